@@ -45,7 +45,7 @@ BEGIN_NCBI_SCOPE
 NCBI_DEFINE_ERRCODE_X(Connect_Stream,    315, 18);
 NCBI_DEFINE_ERRCODE_X(Connect_Pipe,      316, 16);
 NCBI_DEFINE_ERRCODE_X(Connect_ThrServer, 317, 11);
-NCBI_DEFINE_ERRCODE_X(Connect_Core,      318, 11);
+NCBI_DEFINE_ERRCODE_X(Connect_Core,      318, 12);
 
 
 END_NCBI_SCOPE
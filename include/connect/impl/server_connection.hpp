@@ -118,8 +118,14 @@ class CServer_Listener : public IServer_ConnectionBase,
                          public CListeningSocket // CPollable
 {
 public:
-    CServer_Listener(IServer_ConnectionFactory* factory, unsigned short port)
-        : m_Factory(factory), m_Port(port)
+    CServer_Listener(IServer_ConnectionFactory* factory, unsigned short port,
+                     TSOCK_Flags flags = fSOCK_LogDefault)
+        : m_Factory(factory), m_Port(port), m_Flags(flags)
+        { }
+    /// Another listener on the same port sharing the factory
+    /// (for SO_REUSEPORT sharded listening)
+    CServer_Listener(const CServer_Listener& other, TSOCK_Flags flags)
+        : m_Factory(other.m_Factory), m_Port(other.m_Port), m_Flags(flags)
         { }
     virtual CStdRequest* CreateRequest(EServIO_Event event,
                                        CServer_ConnectionPool& connPool,
@@ -129,7 +135,7 @@ public:
         while (st != eIO_Success) {
             // Set backlog to high enough value because Windows actually
             // uses it and we have no reason not to buffer incoming connections
-            if ((st = Listen(m_Port, 128)) == eIO_Success) return;
+            if ((st = Listen(m_Port, 128, m_Flags)) == eIO_Success) return;
             IServer_ConnectionFactory::EListenAction action =
                 m_Factory->OnFailure(&m_Port);
             if (action == IServer_ConnectionFactory::eLAFail)
@@ -140,10 +146,13 @@ public:
     }
     virtual void Passivate(void) { Close(); }
     unsigned short GetPort(void) const { return m_Port; }
+    void SetFlags(TSOCK_Flags flags) { m_Flags = flags; }
+    TSOCK_Flags GetFlags(void) const { return m_Flags; }
 private:
     friend class CAcceptRequest;
-    unique_ptr<IServer_ConnectionFactory> m_Factory;
+    shared_ptr<IServer_ConnectionFactory> m_Factory;
     unsigned short m_Port;
+    TSOCK_Flags    m_Flags;
 } ;
 
 
@@ -756,6 +756,24 @@ public:
      size_t              buf_size     = kConn_DefaultBufSize
      );
 
+    /// Same as the above but the connections are taken from (and returned
+    /// to) the specified pool of persistent connections.
+    /// @sa
+    ///   HTTP_CreateConnPool, HTTP_CreatePooledConnector
+    CConn_HttpStream
+    (const string&       url,
+     const SConnNetInfo* net_info,
+     const string&       user_header,
+     FHTTP_ParseHeader   parse_header,
+     void*               user_data,
+     FHTTP_Adjust        adjust,
+     FHTTP_Cleanup       cleanup,
+     THTTP_Flags         flags,
+     const STimeout*     timeout,
+     size_t              buf_size,
+     HTTP_CONNPOOL       pool
+     );
+
     CConn_HttpStream
     (const SConnNetInfo* net_info     = 0,
      const string&       user_header  = kEmptyStr,
@@ -316,6 +316,11 @@ typedef struct {  /* NCBI_FAKE_WARNING: ICC */
 #define REG_CONN_NAMERD_ENABLE      "NAMERD_ENABLE"
 #define REG_CONN_DISPD_DISABLE      "DISPD_DISABLE"
 
+/* Service resolution cache (see SERV_GetCacheStats()) */
+#define REG_CONN_SERVICE_CACHE_TTL           "SERVICE_CACHE_TTL"
+#define REG_CONN_SERVICE_CACHE_NEGATIVE_TTL  "SERVICE_CACHE_NEGATIVE_TTL"
+#define REG_CONN_SERVICE_CACHE_SIZE          "SERVICE_CACHE_SIZE"
+
 /* Substitute (redirected) service name */
 #define REG_CONN_SERVICE_NAME       DEF_CONN_REG_SECTION "_" "SERVICE_NAME"
 
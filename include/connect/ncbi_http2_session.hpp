@@ -36,6 +36,15 @@
 BEGIN_NCBI_SCOPE
 
 
+/// All HTTP/2 sessions in a process share the internal I/O implementation.
+/// By default it has one I/O loop, which can limit clients running many
+/// concurrent streams. The number of loops and how requests are distributed
+/// between them are configurable (registry section [HTTP2] or environment):
+///   IO_LOOPS / HTTP2_IO_LOOPS - number of I/O loops (default 1);
+///   IO_LOOP_SELECTION / HTTP2_IO_LOOP_SELECTION -
+///     "least_loaded" (default) - loop with the fewest active requests,
+///     "authority" - requests to the same host and port share a loop
+///     (and therefore TCP connections).
 /// @sa CHttpSession_Base
 class NCBI_XXCONNECT2_EXPORT CHttp2Session : public CHttpSession_Base
 {
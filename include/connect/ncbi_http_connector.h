@@ -338,6 +338,98 @@ extern NCBI_XCONNECT_EXPORT CONNECTOR HTTP_CreateConnectorEx
  );
 
 
+/** Pool of idle persistent (keep-alive) HTTP connections, which can be shared
+ * by any number of HTTP connectors (see HTTP_CreatePooledConnector()).
+ *
+ * A connector that has been created with a pool, first tries to take an idle
+ * connection from the pool to the same destination (scheme, host, port, proxy
+ * and virtual host) before making a new one;  and when closed, returns its
+ * connection to the pool if the last response has been read out entirely and
+ * the server did not ask for the connection to be closed.
+ * A pooled connection that turns out to have been dropped by the server gets
+ * silently replaced with a new one (not counted as a failed attempt).
+ * @note
+ *  Connectors with TLS credentials (net_info->credentials) do not use the
+ *  pool.
+ * @note
+ *  Idle connections are checked upon each checkout:  the expired ones, as
+ *  well as those showing any pending input (EOF included), get closed.
+ * @note
+ *  The pool is MT-safe.
+ * @sa
+ *  HTTP_CreateConnPool, HTTP_CreatePooledConnector
+ */
+struct SHttpConnPool;
+typedef struct SHttpConnPool* HTTP_CONNPOOL;
+
+
+/** Pool statistics (counters are since the pool creation / last flush) */
+typedef struct {
+    unsigned int  idle;      /**< idle connections currently in the pool     */
+    unsigned long hits;      /**< connections taken from the pool            */
+    unsigned long misses;    /**< no (usable) idle connection to take        */
+    unsigned long released;  /**< connections returned to the pool           */
+    unsigned long stale;     /**< idle connections failed the health check   */
+    unsigned long expired;   /**< idle connections closed on idle timeout    */
+    unsigned long overflow;  /**< connections not kept since the pool's full */
+} SHTTP_ConnPoolStats;
+
+
+/** Create a connection pool.
+ * @param max_idle
+ *  Maximal number of idle connections to keep per destination (0 = default)
+ * @param idle_timeout
+ *  How long an idle connection can stay in the pool (NULL = indefinitely,
+ *  kDefaultTimeout = the default, which is 30 seconds)
+ * @return
+ *  The pool handle, or NULL on error (out of memory)
+ * @sa
+ *  HTTP_DestroyConnPool
+ */
+extern NCBI_XCONNECT_EXPORT HTTP_CONNPOOL HTTP_CreateConnPool
+(unsigned int        max_idle,
+ const STimeout*     idle_timeout
+ );
+
+
+/** Close all idle connections in the pool, and reset the pool statistics */
+extern NCBI_XCONNECT_EXPORT void HTTP_FlushConnPool
+(HTTP_CONNPOOL       pool
+ );
+
+
+/** Obtain pool statistics */
+extern NCBI_XCONNECT_EXPORT void HTTP_GetConnPoolStats
+(HTTP_CONNPOOL        pool,
+ SHTTP_ConnPoolStats* stats
+ );
+
+
+/** Close all idle connections, and release the pool.  The pool is actually
+ * destroyed after the last connector that uses it, is gone.
+ */
+extern NCBI_XCONNECT_EXPORT void HTTP_DestroyConnPool
+(HTTP_CONNPOOL       pool
+ );
+
+
+/** Same as HTTP_CreateConnectorEx() but the connector takes and returns its
+ * connections from / to the pool (NULL "pool" makes this call identical to
+ * HTTP_CreateConnectorEx()).
+ * @sa
+ *  HTTP_CreateConnPool
+ */
+extern NCBI_XCONNECT_EXPORT CONNECTOR HTTP_CreatePooledConnector
+(const SConnNetInfo* net_info,
+ THTTP_Flags         flags,
+ FHTTP_ParseHeader   parse_header,  /**< may be NULL, then no addtl. parsing */
+ void*               user_data,     /**< user data for HTTP CBs (callbacks)  */
+ FHTTP_Adjust        adjust,        /**< may be NULL                         */
+ FHTTP_Cleanup       cleanup,       /**< may be NULL                         */
+ HTTP_CONNPOOL       pool           /**< may be NULL                         */
+ );
+
+
 /** Create a tunnel to "net_info->host:net_info->port" via an HTTP proxy server
  * located at "net_info->http_proxy_host:net_info->http_proxy_port".  Return
  * the tunnel as a socket via the last parameter.  For compatibility with
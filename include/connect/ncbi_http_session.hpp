@@ -789,6 +789,20 @@ public:
 
     void SetProxy(const CHttpProxy& proxy) { m_Proxy = proxy; }
     const CHttpProxy& GetProxy(void) const { return m_Proxy; }
+
+    /// Get statistics of the session's pool of persistent (keep-alive)
+    /// HTTP/1.x connections, which are re-used by the session's requests
+    /// to the same host.  The pool is off by default, it is enabled by
+    /// setting [CONN]HTTP_POOL_MAX_IDLE (CONN_HTTP_POOL_MAX_IDLE), the
+    /// number of idle connections kept per host, before the session is
+    /// created;  [CONN]HTTP_POOL_IDLE_TIMEOUT (default 30 seconds) limits
+    /// how long they are kept.  All zeros if the pool is disabled.
+    /// Requests with TLS credentials do not use the pool.
+    /// @sa HTTP_CreateConnPool
+    SHTTP_ConnPoolStats GetConnPoolStats(void) const;
+    /// Close all idle connections in the pool, and reset its statistics.
+    void FlushConnPool(void);
+
 private:
     friend class CHttpRequest;
     friend class CHttpResponse;
@@ -807,6 +821,7 @@ private:
     CHttpCookies m_Cookies;
     shared_ptr<CTlsCertCredentials> m_Credentials;
     CHttpProxy   m_Proxy;
+    shared_ptr<SHttpConnPool> m_ConnPool;
 };
 
 
@@ -421,6 +421,79 @@ extern NCBI_XCONNECT_EXPORT ESERV_Type SERV_GetImplicitServerType
  );
 
 
+/** Statistics of the process-wide service resolution cache.
+ *
+ * Resolutions done by SERV_Open*() (and thus by service connectors and
+ * CConn_ServiceStream) are cached per service name and the set of requested
+ * server types/flags, when the cache is enabled with a non-zero
+ * "[CONN]SERVICE_CACHE_TTL" (CONN_SERVICE_CACHE_TTL), in seconds.  Servers
+ * are then load-balanced out of the cached lists.  Lists of the LOCAL, LBSMD,
+ * LBDNS, LBNULL and NAMERD mappers get cached (DISPD and LINKERD need the
+ * request context, so they are always used directly), as well as failures
+ * to find any mapper for the service, for
+ * "[CONN]SERVICE_CACHE_NEGATIVE_TTL" seconds (by default, 1/4 of the TTL).
+ * An entry that is still in use gets refreshed after 3/4 of its TTL, in the
+ * background if a refresher is installed (see SERV_SetCacheRefresher()), or
+ * by the next caller otherwise.  "[CONN]SERVICE_CACHE_SIZE" limits the
+ * number of entries (1000 by default), least recently used go first.
+ * Lookups by a mask, reverse DNS, with an argument/value pair, or with the
+ * host information requested, are never cached.
+ * @sa
+ *  SERV_GetCacheStats, SERV_FlushCache
+ */
+typedef struct {
+    unsigned long hits;          /**< positive lookups served by the cache */
+    unsigned long negative_hits; /**< failures served by the cache         */
+    unsigned long misses;        /**< lookups not found (or expired)       */
+    unsigned long refreshes;     /**< entries refreshed ahead of expiry    */
+    unsigned long evictions;     /**< entries dropped to limit the size    */
+    unsigned long entries;       /**< current number of entries            */
+} SSERV_CacheStats;
+
+
+/** Get the service resolution cache statistics.
+ * @sa
+ *  SSERV_CacheStats
+ */
+extern NCBI_XCONNECT_EXPORT void SERV_GetCacheStats
+(SSERV_CacheStats* stats
+ );
+
+
+/** Drop all service resolution cache entries and statistics, and re-read
+ * the cache configuration upon next use.
+ * @sa
+ *  SSERV_CacheStats
+ */
+extern NCBI_XCONNECT_EXPORT void SERV_FlushCache(void);
+
+
+/** Install a callback to be called (without any locks held) when cached
+ * entries become due for refresh.  The callback must arrange for
+ * SERV_RefreshCache() to be called soon, e.g. by waking up a thread (that is
+ * what the C++ Toolkit does when CONNECT is initialized).  Without a
+ * callback, the due entries get refreshed by the caller that hits them.
+ * @param refresher
+ *  Callback (0 to uninstall)
+ * @sa
+ *  SERV_RefreshCache
+ */
+typedef void (*FSERV_CacheRefresher)(void);
+extern NCBI_XCONNECT_EXPORT void SERV_SetCacheRefresher
+(FSERV_CacheRefresher refresher
+ );
+
+
+/** Re-resolve all entries of the service resolution cache that are due for
+ * refresh.  An entry that fails to refresh stays valid until it expires.
+ * @return
+ *  The number of entries refreshed
+ * @sa
+ *  SERV_SetCacheRefresher
+ */
+extern NCBI_XCONNECT_EXPORT size_t SERV_RefreshCache(void);
+
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
@@ -82,6 +82,8 @@
  *  SOCK_Pushback
  *  SOCK_Status
  *  SOCK_Write
+ *  SOCK_WriteV, SOCK_ReadV, SOCK_WriteBUF, SOCK_SendFile
+ *  SOCK_SetZeroCopy, SOCK_GetZeroCopyStatus
  *  SOCK_Abort
  *  SOCK_GetLocalPort[Ex]
  *  SOCK_GetRemotePort
@@ -169,6 +171,7 @@
  *
  */
 
+#include <connect/ncbi_buffer.h>
 #include <connect/ncbi_core.h>
 #include <connect/ncbi_ipv6.h>
 
@@ -526,7 +529,9 @@ typedef enum {
     fSOCK_KeepOnClose  = 0x80, /**< retain OS handle in SOCK_Close[Ex]()     */
     fSOCK_CloseOnClose = 0,    /**< close  OS handle in SOCK_Close[Ex]()     */
     fSOCK_ReadOnWrite       = 0x100,
-    fSOCK_InterruptOnSignal = 0x200
+    fSOCK_InterruptOnSignal = 0x200,
+    fSOCK_ReusePort    = 0x400  /**< LSOCK: let several sockets listen on the
+                                     same port (SO_REUSEPORT, if supported) */
 } ESOCK_Flags;
 typedef unsigned int TSOCK_Flags;  /**< bitwise "OR" of ESOCK_Flags */
 
@@ -1399,6 +1404,175 @@ extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_Write
  );
 
 
+/** Data segment for vectored I/O (same as POSIX "struct iovec").
+ * @sa
+ *  SOCK_WriteV, SOCK_ReadV
+ */
+typedef struct {
+    void*  base;    /**< segment start; written from / read into */
+    size_t size;    /**< segment size (can be 0)                  */
+} SSOCK_IoVec;
+
+
+/** Write "n_iov" data segments to "sock", as if they were concatenated into
+ * a single buffer and passed to SOCK_Write() (but without copying), e.g. a
+ * protocol header and a data blob.  On UNIX, unencrypted stream sockets
+ * send all segments with as few system calls as possible (sendmsg(2)).
+ * Segments of sockets that cannot do that are written one by one, so the
+ * semantics are exactly the same as of SOCK_Write() in all cases.
+ * @param sock
+ *  [in]  socket handle (stream socket)
+ * @param iov
+ *  [in]  data segments
+ * @param n_iov
+ *  [in]  number of the segments
+ * @param n_written
+ *  [out] # of written bytes in total (can be NULL)
+ * @param how
+ *  [in]  either eIO_WritePlain or eIO_WritePersist
+ * @return
+ *  Same as SOCK_Write() would return for the concatenated data.
+ * @note  Large writes can avoid copying the data into the kernel if enabled
+ *        with SOCK_SetZeroCopy().
+ * @sa
+ *  SOCK_Write, SOCK_WriteBUF, SOCK_SetZeroCopy
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_WriteV
+(SOCK               sock,
+ const SSOCK_IoVec* iov,
+ size_t             n_iov,
+ size_t*            n_written,
+ EIO_WriteMethod    how
+ );
+
+
+/** Read data from "sock" into "n_iov" segments, filling them in order, as if
+ * they were a single buffer passed to SOCK_Read().  On UNIX, unencrypted
+ * stream sockets with no data buffered internally read directly into the
+ * segments (readv(2) semantics).
+ * @param sock
+ *  [in]  socket handle (stream socket)
+ * @param iov
+ *  [in]  segments to read into
+ * @param n_iov
+ *  [in]  number of the segments
+ * @param n_read
+ *  [out] # of bytes read in total (can be NULL)
+ * @param how
+ *  [in]  either eIO_ReadPlain or eIO_ReadPersist (eIO_ReadPeek is not
+ *        supported)
+ * @return
+ *  Same as SOCK_Read() would return for the concatenated buffer.
+ * @sa
+ *  SOCK_Read
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_ReadV
+(SOCK               sock,
+ const SSOCK_IoVec* iov,
+ size_t             n_iov,
+ size_t*            n_read,
+ EIO_ReadMethod     how
+ );
+
+
+/** Write contents of "buf" to "sock" without flattening the chunks of "buf"
+ * (see SOCK_WriteV()), and remove the data written from "buf".
+ * @param sock
+ *  [in]  socket handle (stream socket)
+ * @param buf
+ *  [in]  buffer to send (and remove) the data from
+ * @param n_written
+ *  [out] # of written (and removed) bytes (can be NULL)
+ * @param how
+ *  [in]  either eIO_WritePlain or eIO_WritePersist
+ * @sa
+ *  SOCK_WriteV, BUF_PeekAtCB
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_WriteBUF
+(SOCK            sock,
+ BUF             buf,
+ size_t*         n_written,
+ EIO_WriteMethod how
+ );
+
+
+/** Send "size" bytes of a file starting at "offset" to "sock" (persistently,
+ * as with eIO_WritePersist).  On Linux, the data go right from the file to
+ * the socket (sendfile(2)) unless the socket is secure or has pending
+ * output;  otherwise, the file is read and its data are written as usual.
+ * The file position of "fd" is not changed.
+ * @param sock
+ *  [in]  socket handle (stream socket)
+ * @param fd
+ *  [in]  file descriptor open for reading (UNIX only)
+ * @param offset
+ *  [in]  starting position in the file
+ * @param size
+ *  [in]  # of bytes to send
+ * @param n_written
+ *  [out] # of bytes sent (can be NULL)
+ * @return
+ *  eIO_Success if all "size" bytes have been sent;  eIO_Closed if the file
+ *  ends before that;  eIO_NotSupported if not on UNIX;  other error code
+ *  as SOCK_Write() would return.
+ * @sa
+ *  SOCK_Write
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_SendFile
+(SOCK            sock,
+ int             fd,
+ TNCBI_BigCount  offset,
+ size_t          size,
+ size_t*         n_written
+ );
+
+
+/** Enable or disable zero-copy sends (Linux MSG_ZEROCOPY) for SOCK_WriteV()
+ * of at least "threshold" bytes.  Other writes always copy the data.
+ * The kernel then sends the data right from the caller's memory, which thus
+ * must not be modified or freed until the send is reported complete, see
+ * SOCK_GetZeroCopyStatus().  Zero-copy only pays off for large sends
+ * (~10KB and more), and is not used for secure sockets.
+ * @param sock
+ *  [in]  socket handle (stream socket)
+ * @param threshold
+ *  [in]  minimal size of a send to do without copying;  0 to disable
+ * @return
+ *  eIO_NotSupported if the OS or the socket cannot do that (zero-copy stays
+ *  disabled then);  eIO_Success otherwise.
+ * @sa
+ *  SOCK_GetZeroCopyStatus
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_SetZeroCopy
+(SOCK   sock,
+ size_t threshold
+ );
+
+
+/** Get progress of zero-copy sends in "sock" (see SOCK_SetZeroCopy()).
+ * Zero-copy sends are numbered 1, 2, 3... since the socket has been
+ * connected;  the data of a send can be reused when its number is not
+ * greater than the number of completed sends.  Note that a wrap-around is
+ * possible after 2^32 sends.
+ * @param sock
+ *  [in]  socket handle
+ * @param sent
+ *  [out] # of zero-copy sends issued (can be NULL)
+ * @param done
+ *  [out] # of them that the kernel reported as complete (can be NULL)
+ * @return
+ *  eIO_Success if all sends are complete;  eIO_Timeout if some are pending;
+ *  eIO_NotSupported if zero-copy is not enabled for "sock".
+ * @sa
+ *  SOCK_SetZeroCopy
+ */
+extern NCBI_XCONNECT_EXPORT EIO_Status SOCK_GetZeroCopyStatus
+(SOCK          sock,
+ unsigned int* sent,
+ unsigned int* done
+ );
+
+
 /** If there is outstanding connection or output data pending, cancel it.
  * Mark the socket as if it has been shut down for both reading and writing.
  * Break actual connection if any was established.
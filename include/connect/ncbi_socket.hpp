@@ -476,6 +476,52 @@ public:
                      size_t*         n_written = 0,
                      EIO_WriteMethod how = eIO_WritePersist);
 
+    /// Write data segments to socket as if they were a single buffer.
+    /// @sa
+    ///  SOCK_WriteV
+    EIO_Status WriteV(const SSOCK_IoVec* iov,
+                      size_t             n_iov,
+                      size_t*            n_written = 0,
+                      EIO_WriteMethod    how = eIO_WritePersist);
+
+    /// Read from socket into data segments as if they were a single buffer.
+    /// @sa
+    ///  SOCK_ReadV
+    EIO_Status ReadV(const SSOCK_IoVec* iov,
+                     size_t             n_iov,
+                     size_t*            n_read = 0,
+                     EIO_ReadMethod     how = eIO_ReadPlain);
+
+    /// Write (and remove) contents of the buffer to socket.
+    /// @sa
+    ///  SOCK_WriteBUF
+    EIO_Status WriteBUF(BUF             buf,
+                        size_t*         n_written = 0,
+                        EIO_WriteMethod how = eIO_WritePersist);
+
+    /// Send a part of a file to socket.
+    /// @sa
+    ///  SOCK_SendFile
+    EIO_Status SendFile(int            fd,
+                        TNCBI_BigCount offset,
+                        size_t         size,
+                        size_t*        n_written = 0);
+
+    /// Enable (threshold > 0) or disable zero-copy sends with WriteV().
+    /// @sa
+    ///  SOCK_SetZeroCopy, SOCK_GetZeroCopyStatus
+    EIO_Status SetZeroCopy(size_t threshold);
+
+    /// Get the numbers of zero-copy sends issued and completed, to tell when
+    /// the memory passed to WriteV() can be reused.
+    /// @return
+    ///  eIO_Success if all sends are complete;  eIO_Timeout if some are
+    ///  pending;  eIO_NotSupported if zero-copy is not enabled.
+    /// @sa
+    ///  SOCK_GetZeroCopyStatus, SetZeroCopy
+    EIO_Status GetZeroCopyStatus(unsigned int* sent = 0,
+                                 unsigned int* done = 0) const;
+
     /// Abort socket connection.
     /// @sa
     ///  SOCK_Abort
@@ -1131,6 +1177,76 @@ inline EIO_Status CSocket::Pushback(const void* buf, size_t size)
 }
 
 
+inline EIO_Status CSocket::ReadV(const SSOCK_IoVec* iov,
+                                 size_t             n_iov,
+                                 size_t*            n_read,
+                                 EIO_ReadMethod     how)
+{
+    if ( m_Socket )
+        return SOCK_ReadV(m_Socket, iov, n_iov, n_read, how);
+    if ( n_read )
+        *n_read = 0;
+    return eIO_Closed;
+}
+
+
+inline EIO_Status CSocket::WriteV(const SSOCK_IoVec* iov,
+                                  size_t             n_iov,
+                                  size_t*            n_written,
+                                  EIO_WriteMethod    how)
+{
+    if ( m_Socket )
+        return SOCK_WriteV(m_Socket, iov, n_iov, n_written, how);
+    if ( n_written )
+        *n_written = 0;
+    return eIO_Closed;
+}
+
+
+inline EIO_Status CSocket::WriteBUF(BUF             buf,
+                                    size_t*         n_written,
+                                    EIO_WriteMethod how)
+{
+    if ( m_Socket )
+        return SOCK_WriteBUF(m_Socket, buf, n_written, how);
+    if ( n_written )
+        *n_written = 0;
+    return eIO_Closed;
+}
+
+
+inline EIO_Status CSocket::SendFile(int            fd,
+                                    TNCBI_BigCount offset,
+                                    size_t         size,
+                                    size_t*        n_written)
+{
+    if ( m_Socket )
+        return SOCK_SendFile(m_Socket, fd, offset, size, n_written);
+    if ( n_written )
+        *n_written = 0;
+    return eIO_Closed;
+}
+
+
+inline EIO_Status CSocket::SetZeroCopy(size_t threshold)
+{
+    return m_Socket ? SOCK_SetZeroCopy(m_Socket, threshold) : eIO_Closed;
+}
+
+
+inline EIO_Status CSocket::GetZeroCopyStatus(unsigned int* sent,
+                                             unsigned int* done) const
+{
+    if ( m_Socket )
+        return SOCK_GetZeroCopyStatus(m_Socket, sent, done);
+    if ( sent )
+        *sent = 0;
+    if ( done )
+        *done = 0;
+    return eIO_Closed;
+}
+
+
 inline EIO_Status CSocket::Abort(void)
 {
     return m_Socket ? SOCK_Abort(m_Socket) : eIO_Closed;
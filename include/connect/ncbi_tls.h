@@ -99,6 +99,56 @@ SOCKSSL NcbiSetupTls(void);
  */
 
 
+/** Client-side TLS session resumption.
+ *
+ * Sessions established by secure client SOCKs (including those created with
+ * SOCK_CreateOnTopEx(), and therefore used by the HTTP connectors) are kept
+ * in a process-wide cache, and are offered to the server for resumption
+ * (either by session ID, or by session ticket) when a new connection is made
+ * to the same peer (address and port) with the same SNI host name.  A
+ * successful resumption saves a full handshake.  Sessions that use client
+ * credentials (NCBI_CRED) are never cached.
+ *
+ * The cache holds up to [CONN]TLS_SESSION_CACHE sessions (0 disables it)
+ * for at most [CONN]TLS_SESSION_TIMEOUT seconds each, whatever comes first;
+ * the least recently used session is discarded when the cache is full.
+ * TLS 1.3 tickets are used only once each, as recommended by RFC 8446 C.4.
+ * The settings are looked up as CONN_TLS_SESSION_CACHE / ..._TIMEOUT in the
+ * environment, as well.
+ */
+#define REG_CONN_TLS_SESSION_CACHE    "TLS_SESSION_CACHE"
+#define DEF_CONN_TLS_SESSION_CACHE    "100"
+
+#define REG_CONN_TLS_SESSION_TIMEOUT  "TLS_SESSION_TIMEOUT"
+#define DEF_CONN_TLS_SESSION_TIMEOUT  "3600"
+
+
+/** Statistics of the TLS session cache (all counters are since the start,
+ *  or since the last NcbiFlushTlsSessionCache()).
+ */
+typedef struct {
+    unsigned long full;       /**< full client handshakes completed          */
+    unsigned long resumed;    /**< abbreviated (resumed) client handshakes   */
+    unsigned long hits;       /**< cached sessions offered for resumption    */
+    unsigned long misses;     /**< new sessions with nothing to offer        */
+    unsigned long stores;     /**< sessions (or tickets) put in the cache    */
+    unsigned long evictions;  /**< sessions discarded because of the limit   */
+    unsigned long entries;    /**< sessions currently cached                 */
+} SNcbiTlsSessionStats;
+
+
+/** Get the TLS session cache statistics. */
+extern NCBI_XCONNECT_EXPORT
+void NcbiGetTlsSessionStats(SNcbiTlsSessionStats* stats);
+
+
+/** Discard all cached TLS sessions, reset the statistics, and re-read the
+ *  settings upon next use.
+ */
+extern NCBI_XCONNECT_EXPORT
+void NcbiFlushTlsSessionCache(void);
+
+
 /** Build NCBI_CRED from memory buffers containing an X.509 certificate and a
  *  private key, respectively, in either PEM or DER format (independently of
  *  each other).
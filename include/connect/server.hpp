@@ -54,6 +54,7 @@ class  IServer_ConnectionBase;
 struct SServer_Parameters;
 class  CServer_ConnectionPool;
 class  CServer_Connection;
+class  CServer_ReactorSet;
 
 
 /// Extended copy of the type EIO_Event allowing to distinguish between
@@ -81,6 +82,24 @@ IOEventToServIOEvent(EIO_Event event)
 
 class CNetCacheServer;
 
+/////////////////////////////////////////////////////////////////////////////
+///
+///  SServer_ReactorStats::
+///
+/// Statistics of one CServer main loop (see CServer::GetReactorStats)
+///
+
+struct SServer_ReactorStats
+{
+    unsigned int index;        ///< 0 for the loop run by CServer::Run()
+    size_t       connections;  ///< Connections and listeners it serves
+    Uint8        iterations;   ///< Loop iterations
+    Uint8        events;       ///< Ready sockets
+    Uint8        accepts;      ///< Events on listening sockets
+    Uint8        requests;     ///< Requests processed or queued
+};
+
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 ///  CServer::
@@ -92,6 +111,23 @@ class CNetCacheServer;
 /// ShutdownRequested) or process data in main thread on timeout (override
 /// ProcessTimeout and set parameter accept_timeout to non-zero value).
 ///
+/// On Linux, the main loop can wait for events with epoll instead of
+/// rebuilding the poll vector of all connections on every iteration,
+/// which pays off with many mostly idle connections:
+///   [server] Reactor = epoll   (environment: CSERVER_REACTOR=epoll)
+/// With the epoll reactor, the following settings are also available:
+///   [server] Reactor_Threads = N   (CSERVER_REACTOR_THREADS)
+///     Run N such loops, each in its own thread, with its own SO_REUSEPORT
+///     listening socket on every port and its own set of connections (the
+///     kernel distributes incoming connections between the loops).
+///     Implies Reactor = epoll.  ShutdownRequested() and ProcessTimeout()
+///     are still called by the thread that called Run() only, but
+///     connection factories are called from all loop threads.
+///   [server] Reactor_Inline = true   (CSERVER_REACTOR_INLINE)
+///     Process socket events right in the loop threads instead of passing
+///     them to the thread pool; handlers must not block then.
+/// Per-loop statistics are available from GetReactorStats().
+///
 
 class NCBI_XCONNECT_EXPORT CServer : protected CConnIniter
 {
@@ -166,6 +202,10 @@ public:
     ///  currently listened ports
     vector<unsigned short>  GetListenerPorts(void);
 
+    /// Get statistics of the epoll main loops, the first one is run by
+    /// the thread that called Run().  Empty if the reactor is not used.
+    void GetReactorStats(vector<SServer_ReactorStats>* stats);
+
 protected:
     /// Initialize the server
     ///
@@ -192,13 +232,18 @@ protected:
 
 private:
     void x_DoRun(void);
+    void x_DoRunReactor(CServer_ConnectionPool& pool, bool main_loop);
+    void x_SetupReactors(void);
+    void x_StopReactors(void);
 
     friend class CNetCacheServer;
+    friend class CServer_ReactorThread;
     CPoolOfThreads_ForServer* GetThreadPool(void) { return m_ThreadPool; }
 
     SServer_Parameters*         m_Parameters;
     CServer_ConnectionPool*     m_ConnectionPool;
     CPoolOfThreads_ForServer*   m_ThreadPool;
+    CServer_ReactorSet*         m_Reactors;
     string m_ThreadSuffix;
 };
 
@@ -38,6 +38,8 @@
 
 BEGIN_NCBI_SCOPE
 
+class CServer;
+
 /** @addtogroup ThreadedServer
  *
  * @{
@@ -74,6 +76,9 @@ public:
     bool IsMonitorActive();
     void SendMessage(const char* msg, size_t length);
     void SendString(const string& str);
+    /// Send statistics of the server main loops, one line per loop
+    /// (nothing if the server does not use the epoll reactor)
+    void SendReactorStats(CServer& server);
 
     /// @name IServer_Monitor interface
     /// @{
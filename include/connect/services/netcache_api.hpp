@@ -127,6 +127,31 @@ BEGIN_NCBI_SCOPE
 
 struct SNetCacheAPIImpl;
 
+/// One blob of a batch operation.
+/// @see CNetCacheAPI::ReadDataBatch, CNetICacheClient::ReadBatch
+struct SNetCacheBatchItem
+{
+    /// Outcome of the operation for this particular blob.
+    enum EStatus {
+        eNotProcessed,  ///< The blob hasn't been processed (yet)
+        eOK,            ///< The blob has been read or written
+        eNotFound,      ///< The blob to read does not exist (or is too old)
+        eError          ///< Server or communication error, see error_message
+    };
+
+    /// NetCache blob key or ICache key. When writing to NetCache, leave
+    /// it empty to create a new blob; its key will be stored here.
+    string key;
+    /// ICache blob version and subkey. Not used with NetCache keys.
+    int version = 0;
+    string subkey;
+    /// Blob contents that have been read or that are to be written.
+    string data;
+
+    EStatus status = eNotProcessed;
+    string error_message;
+};
+
 /// Client API for NetCache server.
 ///
 /// It is undesirable to create objects of this class on the heap
@@ -459,6 +484,32 @@ class NCBI_XCONNECT_EXPORT CNetCacheAPI
     void Remove(const string& blob_id,
             const CNamedParameterList* optional = NULL);
 
+    /// Asynchronous versions of HasBlob(), GetBlobSize() and Remove().
+    /// The commands of all callers go to the server the blob key points
+    /// to over a single multiplexed connection (see CNetServer::ExecAsync),
+    /// so many of them can be outstanding at once. Unlike the synchronous
+    /// methods, these neither retry nor fall back to mirrors; errors
+    /// (including those of RemoveAsync) are delivered through the future.
+    future<bool> HasBlobAsync(const string& blob_id,
+            const CNamedParameterList* optional = NULL);
+    future<size_t> GetBlobSizeAsync(const string& blob_id,
+            const CNamedParameterList* optional = NULL);
+    future<void> RemoveAsync(const string& blob_id,
+            const CNamedParameterList* optional = NULL);
+
+    /// Read or write many blobs with as few round trips as possible.
+    /// The items are grouped by the server their keys point to (new
+    /// blobs are spread over the servers of the service), and each group
+    /// is sent as pipelined batch commands over its own connection. All
+    /// groups are processed concurrently. The result of each item is
+    /// stored in its "status" field; these methods throw only if the
+    /// operation cannot be started at all. Like the asynchronous methods,
+    /// they neither retry nor fall back to mirrors.
+    void ReadDataBatch(vector<SNetCacheBatchItem>& items,
+            const CNamedParameterList* optional = NULL);
+    void PutDataBatch(vector<SNetCacheBatchItem>& items,
+            const CNamedParameterList* optional = NULL);
+
     /// Return a CNetServerMultilineCmdOutput object for reading
     /// meta information about the specified blob.
     ///
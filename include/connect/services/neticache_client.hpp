@@ -295,6 +295,16 @@ class NCBI_NET_CACHE_EXPORT CNetICacheClient : public ICache
         unsigned int time_to_live = 0,
         const string& owner = kEmptyStr);
 
+    /// Read or store many blobs at once. Keys are grouped by the server
+    /// they are assigned to and each group is sent as pipelined batch
+    /// commands; groups are processed concurrently. The result of each
+    /// blob is stored in the "status" field of its item.
+    /// @see CNetCacheAPI::ReadDataBatch
+    void ReadBatch(vector<SNetCacheBatchItem>& items,
+            const CNamedParameterList* optional = NULL);
+    void StoreBatch(vector<SNetCacheBatchItem>& items,
+            const CNamedParameterList* optional = NULL);
+
     virtual void Remove(const string&    key,
                         int              version,
                         const string&    subkey);
@@ -553,6 +553,14 @@ class NCBI_XCONNECT_EXPORT CNetScheduleSubmitter
             time_t* job_exptime = NULL,
             ENetScheduleQueuePauseMode* pause_mode = NULL);
 
+    /// Asynchronous version of GetJobStatus(): the command goes to the
+    /// server the job key points to over a single multiplexed connection
+    /// (see CNetServer::ExecAsync), so that the statuses of many jobs
+    /// can be polled at once. Errors are delivered through the future;
+    /// no retries are made.
+    future<CNetScheduleAPI::EJobStatus> GetJobStatusAsync(
+            const string& job_key);
+
     /// Get full information about the specified job.
     ///
     /// @param job
@@ -40,6 +40,10 @@
 #include <corelib/reader_writer.hpp>
 #include <corelib/ncbi_config.hpp>
 
+#include <exception>
+#include <functional>
+#include <future>
+
 
 BEGIN_NCBI_SCOPE
 
@@ -121,6 +125,24 @@ class NCBI_XCONNECT_EXPORT CNetServer
     SExecResult ExecWithRetry(const string& cmd,
             bool multiline_output = false);
 
+    /// Completion handler of an asynchronous command: it gets either
+    /// the reply (as ExecWithRetry() would return it) or the error.
+    typedef function<void(const string& response, exception_ptr error)>
+        TAsyncHandler;
+
+    /// Queue remote command 'cmd' (which must have a single-line reply)
+    /// without waiting for the reply. Commands of all callers are sent
+    /// over one connection per server and their replies are read by
+    /// a few shared event loop threads (see the [netservice_api]
+    /// async_loop_threads parameter), which also call 'handler'.
+    /// The handler is called exactly once; it must not block.
+    /// Unlike ExecWithRetry(), no retries are made.
+    void ExecAsync(const string& cmd, TAsyncHandler handler);
+
+    /// Same as above, with the reply (or the error) delivered
+    /// through the returned future.
+    future<string> ExecAsync(const string& cmd);
+
     /// Retrieve basic information about the server as
     /// attribute name-value pairs.
     CNetServerInfo GetServerInfo();
@@ -48,7 +48,7 @@ NCBI_DEFINE_ERRCODE_X(Corelib_Static,     104,  1);
 NCBI_DEFINE_ERRCODE_X(Corelib_System,     105, 13);
 NCBI_DEFINE_ERRCODE_X(Corelib_App,        106, 24);
 NCBI_DEFINE_ERRCODE_X(Corelib_Diag,       107, 29);
-NCBI_DEFINE_ERRCODE_X(Corelib_File,       108, 106);
+NCBI_DEFINE_ERRCODE_X(Corelib_File,       108, 109);
 NCBI_DEFINE_ERRCODE_X(Corelib_Object,     109, 15);
 NCBI_DEFINE_ERRCODE_X(Corelib_Reg,        110,  8);
 NCBI_DEFINE_ERRCODE_X(Corelib_Util,       111,  6);
@@ -65,6 +65,7 @@ NCBI_DEFINE_ERRCODE_X(Corelib_Mutex,      121,  2);
 NCBI_DEFINE_ERRCODE_X(Corelib_Cookies,    122,  7);
 NCBI_DEFINE_ERRCODE_X(Corelib_Message,    123,  2);
 NCBI_DEFINE_ERRCODE_X(Corelib_Balancer,   124,  16);
+NCBI_DEFINE_ERRCODE_X(Corelib_Profiler,   125,  6);
 
 
 END_NCBI_SCOPE
@@ -0,0 +1,127 @@
+#ifndef CORELIB_IMPL___NCBISTR_SIMD__HPP
+#define CORELIB_IMPL___NCBISTR_SIMD__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Vectorized primitives used by NStr and CUtf8 (internal)
+ *
+ */
+
+/// @file ncbistr_simd.hpp
+/// Runtime-dispatched SIMD kernels behind NStr::CompareNocase(),
+/// NStr::Find(eNocase), NStr::ToLower(), NStr::Split() and CUtf8
+/// validation.  This is an implementation detail of the string
+/// library; it is exposed only so that tests and benchmarks can
+/// compare the back ends.
+
+#include <corelib/ncbistd.hpp>
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CStrSimd --
+///
+/// The back end is chosen on first use from CCpuFeatures: AVX2 if
+/// available, then SSE 4.2, then a portable scalar implementation
+/// (used also on non-x86 platforms).  The NCBI_STR_SIMD environment
+/// variable ("scalar", "sse42", "avx2") can restrict the choice.
+///
+/// All kernels use ASCII case folding, which is what tolower() does
+/// in the "C" locale; bytes above 0x7F are compared as is.  NStr calls
+/// the case-insensitive kernels only when the "C" locale is in effect.
+
+class NCBI_XNCBI_EXPORT CStrSimd
+{
+public:
+    enum EBackend {
+        eScalar,
+        eSSE42,
+        eAVX2,
+        eAuto       ///< Best back end supported by the CPU
+    };
+
+    /// Back end currently in use.
+    static EBackend GetBackend(void);
+    /// Switch back end.  Return FALSE (and change nothing) if the
+    /// requested back end is not supported by the CPU or the build.
+    /// Not thread-safe with respect to concurrent string operations.
+    static bool SetBackend(EBackend backend);
+    static bool IsSupported(EBackend backend);
+    static const char* GetBackendName(EBackend backend);
+
+    /// Return length of a prefix of s1 and s2 (up to n) in which
+    /// the strings are equal ignoring ASCII case.  The prefix need not
+    /// be the longest one; callers finish the comparison themselves.
+    static size_t PrefixNocase(const char* s1, const char* s2, size_t n)
+        { return sm_Impl->prefix_nocase(s1, s2, n); }
+
+    /// Lowercase ASCII letters in place; other bytes go through
+    /// tolower().
+    static void ToLower(char* str, size_t n)
+        { sm_Impl->to_lower(str, n); }
+
+    /// Return position of the first byte of str that is one of the
+    /// bytes in "set", or NPOS.
+    static size_t FindFirstOf(const char* str, size_t n,
+                              const char* set, size_t set_len)
+        { return sm_Impl->find_first_of(str, n, set, set_len); }
+
+    /// Return the first position "i" such that str[i] matches "first"
+    /// and str[i + dist] matches "last" ignoring ASCII case, or NPOS.
+    /// Used to locate candidates for a case-insensitive substring search.
+    static size_t FindNocasePair(const char* str, size_t n,
+                                 char first, char last, size_t dist)
+        { return sm_Impl->find_nocase_pair(str, n, first, last, dist); }
+
+    /// Return length of the longest prefix of str that consists of
+    /// ASCII (0x00-0x7F) bytes only.
+    static size_t SkipAscii(const char* str, size_t n)
+        { return sm_Impl->skip_ascii(str, n); }
+
+    struct SImpl {
+        EBackend backend;
+        size_t (*prefix_nocase)   (const char*, const char*, size_t);
+        void   (*to_lower)        (char*, size_t);
+        size_t (*find_first_of)   (const char*, size_t, const char*, size_t);
+        size_t (*find_nocase_pair)(const char*, size_t, char, char, size_t);
+        size_t (*skip_ascii)      (const char*, size_t);
+    };
+
+private:
+    friend struct SStrSimdLazy;
+    static const SImpl* sm_Impl;
+};
+
+
+END_NCBI_SCOPE
+
+#endif  /* CORELIB_IMPL___NCBISTR_SIMD__HPP */
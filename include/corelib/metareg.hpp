@@ -171,6 +171,11 @@ public:
     static string FindRegistry(const string& name,
                                ENameStyle style = eName_AsIs);
 
+    /// Get all registry files loaded so far, with their sizes and
+    /// modification times as of loading. Entries for files loaded
+    /// with fPrivate have no registry.
+    static void GetLoadedEntries(vector<SEntry>& entries);
+
 private:
     /// Private functions, mostly non-static implementations of the
     /// public interface.
@@ -208,6 +213,7 @@ private:
     typedef map<SKey, size_t> TIndex;
 
     vector<SEntry> m_Contents;
+    vector<SEntry> m_PrivateFiles; ///< Loaded with fPrivate, no registry
     TSearchPath    m_SearchPath;
     TIndex         m_Index;
 
@@ -0,0 +1,196 @@
+#ifndef CORELIB___NCBI_FILE_AIO__HPP
+#define CORELIB___NCBI_FILE_AIO__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ */
+
+/// @file ncbi_file_aio.hpp
+///
+///   Asynchronous positional file I/O: batches of reads and writes with
+///   completion callbacks or futures, served by io_uring on Linux when
+///   the kernel supports it, or by a pool of threads otherwise.
+///
+
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <deque>
+#include <future>
+
+
+/** @addtogroup Files
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+class CFileAsyncIOBackend;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CFileAsyncIO --
+///
+/// Queue of asynchronous positional reads and writes.
+///
+/// Requests are submitted in batches and complete in any order. Each
+/// request has its own completion callback, which is called from one of
+/// the service threads, so it should be short and must not wait for
+/// completion of other requests (WaitAll(), futures from Read()/Write()).
+/// The file handles and buffers must stay valid until the request is
+/// completed.
+///
+/// The number of requests in flight is limited by the queue depth;
+/// Submit() blocks while the queue is full. Callbacks can submit
+/// follow-up requests: Submit(), Read() and Write() called from a
+/// callback never block, the requests that do not fit into the queue
+/// are started as soon as other requests complete.
+///
+/// Configuration (registry section [FileAsyncIO] or environment):
+///   Backend     / NCBI_FILEASYNCIO_BACKEND    - Default, ThreadPool, URing;
+///   QueueDepth  / NCBI_FILEASYNCIO_QUEUEDEPTH - default 128;
+///   Threads     / NCBI_FILEASYNCIO_THREADS    - thread pool size, default 4.
+
+class NCBI_XNCBI_EXPORT CFileAsyncIO : public CObject
+{
+public:
+    /// I/O implementation.
+    enum EBackend {
+        eDefault,      ///< io_uring if available, thread pool otherwise
+        eThreadPool,   ///< pread()/pwrite() calls in a pool of threads
+        eURing         ///< Linux io_uring
+    };
+
+    /// Type of I/O operation.
+    enum EOperation {
+        eRead,
+        eWrite
+    };
+
+    struct SRequest;
+
+    /// Completion callback.
+    /// @param request
+    ///   Completed request.
+    /// @param result
+    ///   Number of bytes transferred (can be less than requested,
+    ///   like for pread()/pwrite()), or negated errno value on error.
+    typedef function<void(const SRequest& request, Int8 result)> TCallback;
+
+    /// I/O request.
+    struct SRequest {
+        EOperation   op;
+        TFileHandle  handle;
+        void*        buffer;
+        size_t       size;
+        Uint8        offset;
+        TCallback    callback;
+    };
+
+    /// Create I/O queue.
+    /// @param backend
+    ///   I/O implementation, eDefault means to use the configured one.
+    ///   If io_uring is requested but not supported by the system,
+    ///   the thread pool is used.
+    /// @param queue_depth
+    ///   Maximum number of requests in flight, 0 - use configured value.
+    /// @param threads
+    ///   Number of threads in the pool, 0 - use configured value.
+    CFileAsyncIO(EBackend     backend     = eDefault,
+                 unsigned int queue_depth = 0,
+                 unsigned int threads     = 0);
+
+    /// Wait for completion of all pending requests and stop the service
+    /// threads.
+    virtual ~CFileAsyncIO(void);
+
+    /// Return the used implementation (eThreadPool or eURing).
+    EBackend GetBackend(void) const { return m_Backend; }
+
+    /// Maximum number of requests in flight.
+    unsigned int GetQueueDepth(void) const { return m_QueueDepth; }
+
+    /// Submit a batch of requests.
+    /// Batches larger than the queue depth are submitted in parts.
+    void Submit(const SRequest* requests, size_t count);
+    void Submit(const vector<SRequest>& requests)
+        { Submit(requests.data(), requests.size()); }
+    void Submit(const SRequest& request)
+        { Submit(&request, 1); }
+
+    /// Submit a single read, result is the same as for TCallback.
+    future<Int8> Read(TFileHandle handle, void* buffer, size_t size,
+                      Uint8 offset);
+    /// Submit a single write, result is the same as for TCallback.
+    future<Int8> Write(TFileHandle handle, const void* buffer, size_t size,
+                       Uint8 offset);
+
+    /// Wait for completion of all submitted requests.
+    /// Must not be called from a completion callback.
+    void WaitAll(void);
+
+    /// Number of submitted but not yet completed requests.
+    size_t GetPending(void) const;
+
+    /// Check if io_uring can be used on this system.
+    static bool IsURingAvailable(void);
+
+private:
+    friend class CFileAsyncIOBackend;
+    void x_Complete(const SRequest& request, Int8 result);
+    void x_Finish(const SRequest& request, Int8 result);
+    void x_StartDeferred(void);
+    future<Int8> x_SubmitOne(EOperation op, TFileHandle handle,
+                             void* buffer, size_t size, Uint8 offset);
+
+    EBackend                        m_Backend;
+    unsigned int                    m_QueueDepth;
+    unique_ptr<CFileAsyncIOBackend> m_Impl;
+    mutable CFastMutex              m_PendingMutex;
+    CConditionVariable              m_PendingCond;
+    // Submitted and not yet completed requests, including deferred ones
+    size_t                          m_Pending;
+    // Requests started in the backend, never more than the queue depth
+    size_t                          m_InFlight;
+    // Requests submitted from callbacks that did not fit into the queue
+    deque<SRequest>                 m_Deferred;
+
+private:
+    // Prevent copying
+    CFileAsyncIO(const CFileAsyncIO&);
+    void operator=(const CFileAsyncIO&);
+};
+
+
+END_NCBI_SCOPE
+
+/* @} */
+
+#endif  /* CORELIB___NCBI_FILE_AIO__HPP */
@@ -0,0 +1,358 @@
+#ifndef CORELIB___NCBI_METRICS__HPP
+#define CORELIB___NCBI_METRICS__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ */
+
+/// @file ncbi_metrics.hpp
+///
+///   In-process metrics: thread-sharded counters, gauges and log-linear
+///   latency histograms, registry with snapshots and text exposition
+///   in Prometheus format.
+///
+
+#include <corelib/ncbiobj.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <atomic>
+
+
+/** @addtogroup Diagnostics
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+/// Name/value pairs distinguishing metrics with the same name.
+typedef vector< pair<string, string> > TMetricLabels;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CMetricCounter --
+///
+/// Monotonic counter. Each thread increments one of several shards
+/// located on separate cache lines, so concurrent updates do not contend.
+///
+
+class NCBI_XNCBI_EXPORT CMetricCounter : public CObject
+{
+public:
+    CMetricCounter(void);
+
+    /// Increment the counter.
+    void Add(Uint8 value = 1)
+    {
+        m_Shards[x_GetShardIndex()].m_Value.fetch_add(value,
+            memory_order_relaxed);
+    }
+
+    /// Sum of all shards.
+    Uint8 GetValue(void) const;
+
+    /// Reset the counter to zero (not atomic relative to Add()).
+    void Reset(void);
+
+    enum { kShards = 16 };
+
+private:
+    static unsigned int x_GetShardIndex(void);
+
+    struct SShard {
+        alignas(64) atomic<Uint8> m_Value;
+    };
+    SShard m_Shards[kShards];
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CMetricGauge --
+///
+/// Value which can go up and down (queue sizes, active connections etc.)
+///
+
+class NCBI_XNCBI_EXPORT CMetricGauge : public CObject
+{
+public:
+    CMetricGauge(void) : m_Value(0) {}
+
+    void  Set(Int8 value) { m_Value.store(value, memory_order_relaxed); }
+    void  Add(Int8 value) { m_Value.fetch_add(value, memory_order_relaxed); }
+    Int8  GetValue(void) const { return m_Value.load(memory_order_relaxed); }
+
+private:
+    atomic<Int8> m_Value;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CMetricHistogram --
+///
+/// Log-linear (HDR-style) histogram of non-negative integer values.
+/// Values below 2^kSubBucketBits are counted exactly, larger ones fall
+/// into one of 2^kSubBucketBits linear sub-buckets of their power-of-2
+/// range, which gives a relative error below 1/2^kSubBucketBits.
+/// Recording is lock-free (relaxed atomic increments).
+///
+/// The values are recorded in integer units; the unit (in seconds or
+/// any other base unit) is used only for exposition. The default unit
+/// is one microsecond.
+///
+
+class NCBI_XNCBI_EXPORT CMetricHistogram : public CObject
+{
+public:
+    enum {
+        kSubBucketBits = 4,
+        kSubBuckets    = 1 << kSubBucketBits,
+        kBuckets       = (64 - kSubBucketBits + 1) * kSubBuckets
+    };
+
+    CMetricHistogram(double unit = 1e-6);
+
+    /// Record a value (in units).
+    void Record(Uint8 value)
+    {
+        m_Buckets[GetBucketIndex(value)].fetch_add(1, memory_order_relaxed);
+        m_Count.fetch_add(1, memory_order_relaxed);
+        m_Sum.fetch_add(value, memory_order_relaxed);
+    }
+
+    /// Record time in seconds, converting it to units.
+    void RecordSeconds(double seconds)
+    {
+        Record(seconds <= 0 ? 0 : Uint8(seconds / m_Unit + 0.5));
+    }
+
+    /// Unit of recorded values, in base units (e.g. seconds).
+    double GetUnit(void) const { return m_Unit; }
+
+    /// Copy of the histogram state.
+    class NCBI_XNCBI_EXPORT CSnapshot
+    {
+    public:
+        CSnapshot(double unit = 1e-6);
+
+        /// Add counts from another snapshot with the same unit.
+        void Merge(const CSnapshot& other);
+
+        Uint8  GetCount(void) const { return m_Count; }
+        Uint8  GetSum(void) const { return m_Sum; }
+        double GetUnit(void) const { return m_Unit; }
+        /// Number of values in the bucket.
+        Uint8  GetBucketCount(size_t index) const { return m_Buckets[index]; }
+
+        /// Approximate value (in units) at the given quantile (0.0-1.0).
+        /// Returns upper bound of the bucket containing the quantile.
+        Uint8 GetQuantile(double quantile) const;
+
+    private:
+        friend class CMetricHistogram;
+
+        double        m_Unit;
+        Uint8         m_Count;
+        Uint8         m_Sum;
+        vector<Uint8> m_Buckets;
+    };
+
+    /// Get a snapshot of the current state. Not atomic with respect to
+    /// concurrent Record() calls, each bucket is read independently.
+    CSnapshot GetSnapshot(void) const;
+
+    /// Bucket containing the value.
+    static size_t GetBucketIndex(Uint8 value)
+    {
+        if (value < kSubBuckets) {
+            return size_t(value);
+        }
+        unsigned int exp = x_Log2(value);
+        unsigned int shift = exp - kSubBucketBits;
+        return size_t(exp - kSubBucketBits + 1) * kSubBuckets +
+            size_t((value >> shift) & (kSubBuckets - 1));
+    }
+    /// Smallest value falling into the bucket.
+    static Uint8 GetBucketLowerBound(size_t index);
+    /// Largest value falling into the bucket.
+    static Uint8 GetBucketUpperBound(size_t index);
+
+private:
+    static unsigned int x_Log2(Uint8 value)
+    {
+#if defined(__GNUC__)  ||  defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        unsigned int ret = 0;
+        while (value >>= 1) {
+            ++ret;
+        }
+        return ret;
+#endif
+    }
+
+    double        m_Unit;
+    atomic<Uint8> m_Count;
+    atomic<Uint8> m_Sum;
+    atomic<Uint8> m_Buckets[kBuckets];
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CMetricsSnapshot --
+///
+/// State of all metrics of a registry at some moment. Snapshots from
+/// different registries (e.g. from worker processes) can be merged.
+///
+
+class NCBI_XNCBI_EXPORT CMetricsSnapshot
+{
+public:
+    enum EType {
+        eCounter,
+        eGauge,
+        eHistogram
+    };
+
+    struct SEntry {
+        SEntry(void) : m_Type(eCounter), m_Value(0), m_Histogram() {}
+
+        string           m_Name;
+        string           m_Help;
+        EType            m_Type;
+        TMetricLabels    m_Labels;
+        Int8             m_Value;      ///< Counter or gauge value
+        CMetricHistogram::CSnapshot m_Histogram;
+    };
+    typedef vector<SEntry> TEntries;
+
+    const TEntries& GetEntries(void) const { return m_Entries; }
+    TEntries&       SetEntries(void)       { return m_Entries; }
+
+    /// Find entry by name and labels, return NULL if not found.
+    const SEntry* Find(const string&        name,
+                       const TMetricLabels& labels = TMetricLabels()) const;
+
+    /// Add values of the other snapshot. Counters, gauges and histograms
+    /// with the same name and labels are summed, new ones are appended.
+    void Merge(const CMetricsSnapshot& other);
+
+    /// Write the snapshot in Prometheus text exposition format.
+    /// Histograms are written with non-empty buckets only, quantile
+    /// boundaries are scaled to the histogram's unit.
+    void WriteText(CNcbiOstream& out) const;
+
+private:
+    TEntries m_Entries;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CMetricsRegistry --
+///
+/// Collection of named metrics. Get*() methods create the metric on the
+/// first call and return the same object for the same name and labels
+/// later, so they can be called from anywhere; the lock is held only
+/// during lookup, cache the returned reference on hot paths.
+///
+/// @code
+///   static CRef<CMetricHistogram> s_Latency = CMetricsRegistry::Instance()
+///       .GetHistogram("get_blob_seconds", "Blob retrieval time");
+///   CStopWatch sw(CStopWatch::eStart);
+///   ...
+///   s_Latency->RecordSeconds(sw.Elapsed());
+/// @endcode
+///
+
+class NCBI_XNCBI_EXPORT CMetricsRegistry
+{
+public:
+    CMetricsRegistry(void);
+    ~CMetricsRegistry(void);
+
+    /// Process-wide registry.
+    static CMetricsRegistry& Instance(void);
+
+    /// Get or create a metric. Throw CCoreException if a metric with the
+    /// same name but of a different type already exists.
+    CRef<CMetricCounter>   GetCounter(const string&        name,
+                                      const string&        help = kEmptyStr,
+                                      const TMetricLabels& labels
+                                      = TMetricLabels());
+    CRef<CMetricGauge>     GetGauge(const string&        name,
+                                    const string&        help = kEmptyStr,
+                                    const TMetricLabels& labels
+                                    = TMetricLabels());
+    CRef<CMetricHistogram> GetHistogram(const string&        name,
+                                        const string&        help = kEmptyStr,
+                                        const TMetricLabels& labels
+                                        = TMetricLabels(),
+                                        double               unit = 1e-6);
+
+    /// Get current values of all metrics.
+    CMetricsSnapshot GetSnapshot(void) const;
+
+    /// Write current values in Prometheus text exposition format.
+    void WriteText(CNcbiOstream& out) const;
+
+    /// Remove all metrics. References held by callers stay valid but are
+    /// not reported anymore.
+    void Clear(void);
+
+private:
+    CMetricsRegistry(const CMetricsRegistry&);
+    CMetricsRegistry& operator=(const CMetricsRegistry&);
+
+    struct SMetric {
+        CMetricsSnapshot::EType m_Type;
+        string                  m_Name;
+        string                  m_Help;
+        TMetricLabels           m_Labels;
+        CRef<CObject>           m_Object;
+    };
+    typedef map<string, SMetric> TMetrics;
+
+    SMetric& x_Get(CMetricsSnapshot::EType type,
+                   const string&           name,
+                   const string&           help,
+                   const TMetricLabels&    labels);
+
+    mutable CFastMutex m_Mutex;
+    TMetrics           m_Metrics;
+};
+
+
+END_NCBI_SCOPE
+
+/* @} */
+
+#endif  /* CORELIB___NCBI_METRICS__HPP */
@@ -0,0 +1,123 @@
+#ifndef CORELIB___NCBI_PROFILER__HPP
+#define CORELIB___NCBI_PROFILER__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ */
+
+/// @file ncbi_profiler.hpp
+///
+///   Built-in sampling CPU profiler writing folded stacks
+///   (input format of flame graph tools).
+///
+
+#include <corelib/ncbistd.hpp>
+
+
+/** @addtogroup Diagnostics
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CSamplingProfiler --
+///
+/// Periodically interrupts each registered thread with SIGPROF, driven by
+/// the thread's CPU time, and records the thread's stack. The signal
+/// handler only stores return addresses in a per-thread lock-free buffer;
+/// a background thread collects the samples and periodically rewrites
+/// the output file with accumulated counts, one line per distinct stack:
+///     outer_func;caller;callee <count>
+///
+/// CNcbiApplication starts the profiler on startup if it is enabled
+/// in the configuration, and stops it on exit. Threads started with
+/// CThread are registered automatically, others can call RegisterThread().
+///
+/// Configuration (registry section [Profiler] or environment):
+///   Enabled       / NCBI_PROFILER_ENABLED       - start the profiler;
+///   Frequency     / NCBI_PROFILER_FREQUENCY     - samples per second of
+///                                                 CPU time, default 99;
+///   Output        / NCBI_PROFILER_OUTPUT        - output file, default
+///                                                 <app name>.<pid>.folded;
+///   WriteInterval / NCBI_PROFILER_WRITEINTERVAL - seconds between output
+///                                                 updates, default 60;
+///   MaxDepth      / NCBI_PROFILER_MAXDEPTH      - stack depth, max 64;
+///   MaxStacks     / NCBI_PROFILER_MAXSTACKS     - distinct stacks kept,
+///                                                 default 100000; samples
+///                                                 of other stacks are
+///                                                 counted as "[other stacks]".
+///
+/// @note
+///   Supported on Linux (per-thread CPU timers) and other UNIX systems
+///   (process-wide ITIMER_PROF, which samples only registered threads).
+///   Function names are resolved with dladdr(), so executables need to
+///   be linked with -rdynamic for their own symbols to be named.
+
+class NCBI_XNCBI_EXPORT CSamplingProfiler
+{
+public:
+    /// Check if the profiler is enabled by the configuration.
+    static bool IsEnabled(void);
+
+    /// Start profiling, register the calling thread.
+    /// @return
+    ///   FALSE if profiling is not supported on this platform or
+    ///   the profiler cannot be started.
+    static bool Start(void);
+
+    /// Stop profiling and write the final profile.
+    static void Stop(void);
+
+    /// Check if the profiler is running.
+    static bool IsRunning(void);
+
+    /// Write the profile collected so far to the output file.
+    static void Flush(void);
+
+    /// Start sampling the calling thread.
+    static void RegisterThread(void);
+    /// Stop sampling the calling thread, must be called before
+    /// the thread exits if it has been registered.
+    static void UnregisterThread(void);
+
+    /// Number of collected samples.
+    static Uint8 GetSampleCount(void);
+    /// Number of samples lost because of full per-thread buffers.
+    static Uint8 GetDroppedCount(void);
+};
+
+
+END_NCBI_SCOPE
+
+/* @} */
+
+#endif  /* CORELIB___NCBI_PROFILER__HPP */
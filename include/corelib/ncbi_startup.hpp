@@ -0,0 +1,152 @@
+#ifndef CORELIB___NCBI_STARTUP__HPP
+#define CORELIB___NCBI_STARTUP__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ */
+
+/// @file ncbi_startup.hpp
+///
+///   Application startup timeline and registry snapshot cache.
+///
+
+#include <corelib/ncbistd.hpp>
+
+
+/** @addtogroup AppFramework
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+class CNcbiRegistry;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CStartupTimeline --
+///
+/// Records how long each phase of the application startup takes.
+/// CNcbiApplication marks its own phases (diag setup, config loading,
+/// Init(), Run() etc.); applications can add their own marks, e.g. after
+/// opening databases. The first phase, "load", covers the time from
+/// loading of the core library (dynamic linking, static initialization)
+/// to AppMain().
+///
+/// If enabled, the timeline is printed to stderr when AppMain() returns:
+///     phase                     ms      total
+///     load                   1.234      1.234
+///     ...
+///
+/// Configuration (registry section [NCBI] or environment):
+///   StartupTimeline / NCBI_CONFIG__STARTUP_TIMELINE - enable the report.
+
+class NCBI_XNCBI_EXPORT CStartupTimeline
+{
+public:
+    /// Check if the timeline report is enabled by the configuration.
+    static bool IsEnabled(void);
+
+    /// Record the end of a phase started by the previous mark.
+    /// Marks are cheap and always recorded, so that the report can be
+    /// enabled by the application's registry loaded later.
+    /// @param phase
+    ///   Phase name, must be a string literal or otherwise outlive
+    ///   the application.
+    static void Mark(const char* phase);
+
+    /// Time elapsed since the core library was loaded, in seconds.
+    static double GetElapsed(void);
+
+    /// Print the recorded phases.
+    static void Report(CNcbiOstream& out);
+
+    /// Forget all recorded phases.
+    static void Reset(void);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CRegistrySnapshot --
+///
+/// Caches the fully loaded application registry in a single flat file,
+/// so that the next run can skip searching for the configuration files,
+/// loading .ncbirc, included and inherited (.Inherits) registries.
+///
+/// The snapshot lists each file it was built from with its size and
+/// modification time; it is used only if all of them are unchanged and
+/// the configuration file name requested by the application is the same.
+/// Files that did not exist when the snapshot was made are not tracked,
+/// so the snapshot must be removed if a new file is added in front of
+/// the used one in the registry search path.
+///
+/// CNcbiApplicationAPI::LoadConfig() uses the snapshot if the environment
+/// variable NCBI_CONFIG__REGISTRY_SNAPSHOT names the snapshot file (the
+/// registry itself cannot enable it), and rewrites it when it is stale.
+
+class NCBI_XNCBI_EXPORT CRegistrySnapshot
+{
+public:
+    /// Snapshot file name from the configuration, empty if disabled.
+    static string GetPath(void);
+
+    /// Load the snapshot into an empty registry.
+    /// @param path
+    ///   Snapshot file.
+    /// @param key
+    ///   Identifies the requested configuration, e.g. the 'conf' argument
+    ///   of AppMain(); a snapshot made with a different key is ignored.
+    /// @param reg
+    ///   Registry to load into.
+    /// @param config_path
+    ///   Receives the path of the main configuration file (empty if none).
+    /// @return
+    ///   FALSE if the snapshot is missing, stale or cannot be read.
+    static bool Load(const string&  path,
+                     const string&  key,
+                     CNcbiRegistry& reg,
+                     string*        config_path);
+
+    /// Save the registry and the list of currently loaded registry files.
+    /// The file is written atomically (via a temporary file), errors are
+    /// reported as warnings.
+    static bool Save(const string&        path,
+                     const string&        key,
+                     const CNcbiRegistry& reg,
+                     const string&        config_path);
+};
+
+
+END_NCBI_SCOPE
+
+/* @} */
+
+#endif  /* CORELIB___NCBI_STARTUP__HPP */
@@ -614,7 +614,14 @@ protected:
     void SetExitCode(int exit_code, EExitMode when = eExceptionalExits);
 
     enum EAppFlags {
-        fSkipSafeStaticDestroy = 1 << 0
+        fSkipSafeStaticDestroy = 1 << 0,
+        /// Reduce startup latency of short-lived applications: set up
+        /// diagnostics only once, after loading the registry (messages
+        /// posted before that go to the default destination, stderr).
+        /// Can also be enabled by [NCBI] LazyStartup (environment only,
+        /// NCBI_CONFIG__LAZY_STARTUP). See also CStartupTimeline and
+        /// CRegistrySnapshot in <corelib/ncbi_startup.hpp>.
+        fLazyStartup           = 1 << 1
     };
     typedef int TAppFlags;
     void SetAppFlags(TAppFlags flags) { m_AppFlags = flags; }
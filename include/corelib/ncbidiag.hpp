@@ -2803,7 +2803,7 @@ private:
 /// only when it is completely initialized, i.e. no earlier than
 /// CNcbiApplication::Run() is called. Also it shouldn't be installed
 /// using standard SetDiagHandler() function, you have to use
-/// InstallToDiag() method of this handler. And don't forget to call
+/// Install() method of this handler. And don't forget to call
 /// RemoveFromDiag() before your application is finished.
 
 class CAsyncDiagThread;
@@ -2819,20 +2819,42 @@ public:
     /// initialized, i.e. no earlier than CNcbiApplication::Run() is called.
     /// Method can throw CThreadException if dedicated thread failed
     /// to start.
-    /// @deprecated Use regular diganostics instead.
+    /// @deprecated Use regular diganostics or Install() instead.
     NCBI_DEPRECATED
     void InstallToDiag(void);
-    /// Remove this DiagHandler from diagnostics.
-    /// This method must be called if InstallToDiag was called. Object cannot
-    /// be destroyed if InstallToDiag was called and RemoveFromDiag wasn't
-    /// called. If InstallToDiag wasn't called then this method does nothing
+    /// Install this DiagHandler into diagnostics in front of the current
+    /// diagnostic handler, which keeps its ownership. If the current
+    /// handler is not owned by diagnostics the caller must keep it alive
+    /// until RemoveFromDiag() is called.
+    /// Same requirements and exceptions as for InstallToDiag() apply.
+    void Install(void);
+    /// Remove this DiagHandler from diagnostics and put back the handler
+    /// which was current when it was installed.
+    /// This method must be called if Install was called. Object cannot
+    /// be destroyed if Install was called and RemoveFromDiag wasn't
+    /// called. If Install wasn't called then this method does nothing
     /// and is safe to be executed.
     void RemoveFromDiag(void);
     /// Set custom suffix to use on all threads in the server's pool.
-    /// Value can be set only before call to InstallToDiag(), any change
-    /// of the value after call to InstallToDiag() will be ignored.
+    /// Value can be set only before call to Install(), any change
+    /// of the value after call to Install() will be ignored.
     void SetCustomThreadSuffix(const string& suffix);
 
+    /// What to do with a new message when the queue of the dedicated
+    /// thread is full. Set through [Diag]Async_Overflow_Policy
+    /// (DIAG_ASYNC_OVERFLOW_POLICY).
+    enum EOverflowPolicy {
+        eOverflow_Block,  ///< Wait for the thread to free space (default)
+        eOverflow_Drop,   ///< Discard the message
+        eOverflow_Sample  ///< While the queue is 3/4 full keep only every
+                          ///< Nth message below warning severity (see
+                          ///< [Diag]Async_Sample_Rate), block for the rest
+    };
+
+    /// Number of messages discarded according to the overflow policy
+    /// since the handler has been installed.
+    Uint8 GetDroppedCount(void) const;
+
     /// Implementation of CDiagHandler
     virtual void Post(const SDiagMessage& mess);
     virtual string GetLogName(void);
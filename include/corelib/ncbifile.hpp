@@ -3027,57 +3027,109 @@ enum EFindFiles {
 typedef int TFindFiles; 
 
 
-/// Find files in the specified directory
-template<class TFindFunc>
-void FindFilesInDir(const CDir&            dir,
-                    const vector<string>&  masks,
-                    const vector<string>&  masks_subdir,
-                    TFindFunc&             find_func,
-                    TFindFiles             flags = fFF_Default)
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CDirWalker --
+///
+/// Recursive directory traversal with a streaming (callback) interface.
+///
+/// Directories are read directly, without creating CDirEntry lists.
+/// Entry types are taken from the directory listing where the OS provides
+/// them (d_type on Unix, file attributes on MS Windows), so stat() is
+/// needed for symbolic links and on file systems without such support only.
+/// Masks are applied to entry names while reading the directory.
+///
+/// If more than one thread is used, subdirectories are put into a common
+/// queue and read by all threads in breadth-first order. In this case the
+/// order of reported entries is not defined, but the callback is never
+/// called concurrently. With a single thread the traversal is depth-first:
+/// the contents of a directory are reported right after the directory
+/// itself, and the callback is called from the calling thread.
+///
+/// @sa FindFilesInDir, FindFiles
+
+class CDirWalkerImpl;
+
+class NCBI_XNCBI_EXPORT CDirWalker
 {
-    TFindFiles find_type = flags & fFF_All;
-    if ( find_type == 0 ) {
-        flags |= fFF_All;
-    }
-    unique_ptr<CDir::TEntries> 
-        contents(dir.GetEntriesPtr(kEmptyStr, CDir::fIgnoreRecursive | CDir::fIgnorePath));
-    if (contents.get() == NULL) {
-        // error
-        return;
-    }
+public:
+    /// Directory entry passed to the callback.
+    class NCBI_XNCBI_EXPORT CEntry
+    {
+    public:
+        /// Entry path: directory path (if not empty) + entry name.
+        const string& GetPath(void) const { return m_Path; }
+        /// Entry name without path.
+        CTempString GetName(void) const
+            { return CTempString(m_Path).substr(m_NamePos); }
+        /// Entry type; symbolic links are followed.
+        /// Calls stat() if the type is not known from the directory listing.
+        CDirEntry::EType GetType(void) const;
+        /// Nesting level, 0 for entries of the starting directory.
+        unsigned int GetDepth(void) const { return m_Depth; }
+
+    private:
+        friend class CDirWalkerImpl;
+        string                   m_Path;
+        size_t                   m_NamePos;
+        mutable CDirEntry::EType m_Type;
+        unsigned int             m_Depth;
+    };
+
+    /// Callback result.
+    enum EAction {
+        eContinue,   ///< continue traversal
+        eSkipDir,    ///< do not descend into this entry (directory)
+        eStop        ///< stop traversal
+    };
+    /// Called for each entry that matches the masks and type flags.
+    typedef function<EAction(const CEntry& entry)> TCallback;
+
+    /// Constructor.
+    /// @param flags
+    ///   Type of entries to report, recursion and case sensitivity flags.
+    /// @param threads
+    ///   Number of threads used for the traversal, including the calling
+    ///   one. Zero means to use [NCBI]DirWalkerThreads configuration
+    ///   parameter (env. NCBI_CONFIG__DIRWALKERTHREADS), 1 by default.
+    CDirWalker(TFindFiles flags = fFF_Default, unsigned int threads = 0);
+
+    /// Walk the directory tree.
+    /// @param dir
+    ///   Starting directory. If empty, the current directory is used and
+    ///   reported paths are relative.
+    /// @param masks
+    ///   Masks for reported entries.
+    /// @param masks_subdir
+    ///   Masks for subdirectories to descend into if fFF_Recursive is set.
+    /// @param callback
+    ///   Called for each found entry.
+    /// @return
+    ///   FALSE if the traversal has been stopped by the callback.
+    ///   Unreadable directories are silently skipped.
+    /// @note
+    ///   Exceptions thrown by the callback stop the traversal and are
+    ///   rethrown to the caller.
+    bool Walk(const string&    dir,
+              const CMask&     masks,
+              const CMask&     masks_subdir,
+              const TCallback& callback);
+
+    /// Walk the directory tree, use the same masks for entries and
+    /// subdirectories (empty masks match everything).
+    bool Walk(const string&    dir,
+              const CMask&     masks,
+              const TCallback& callback);
+
+    /// Number of threads used by the walker.
+    unsigned int GetThreads(void) const { return m_Threads; }
+
+private:
+    TFindFiles   m_Flags;
+    unsigned int m_Threads;
+};
 
-    NStr::ECase use_case = (flags & fFF_Nocase) ? NStr::eNocase : NStr::eCase;
-    string path;
 
-    if ( dir.GetPath().length() ) {
-        path = CDirEntry::AddTrailingPathSeparator(dir.GetPath());
-    }
-    ITERATE(CDir::TEntries, it, *contents) {
-        CDirEntry& dir_entry = **it;
-        string name = dir_entry.GetPath();
-        dir_entry.Reset(CDirEntry::MakePath(path, name));
-        
-        TFindFiles entry_type = fFF_Dir | fFF_File; // unknown
-        if ( CDirEntry::MatchesMask(name, masks, use_case) ) {
-            if ( find_type != (fFF_Dir | fFF_File) ) {
-                // need to check actual entry type
-                entry_type = dir_entry.IsDir()? fFF_Dir: fFF_File;
-            }
-            if ( (entry_type & find_type) != 0 ) {
-                // entry type matches
-                find_func(dir_entry);
-            }
-        }
-        if ( (flags & fFF_Recursive) &&
-             (entry_type & fFF_Dir) /*possible dir*/ &&
-             CDirEntry::MatchesMask(name, masks_subdir, use_case) &&
-             (entry_type == fFF_Dir || dir_entry.IsDir()) /*real dir*/ ) {
-            CDir nested_dir(dir_entry.GetPath());
-            FindFilesInDir(nested_dir, masks, masks_subdir, find_func, flags);
-        }
-    }
-    return;
-}
 
 
 /// Find files in the specified directory
@@ -3088,48 +3140,32 @@ void FindFilesInDir(const CDir&   dir,
                     TFindFunc&    find_func,
                     TFindFiles    flags = fFF_Default)
 {
-    TFindFiles find_type = flags & fFF_All;
-    if ( find_type == 0 ) {
-        flags |= fFF_All;
-    }
-    unique_ptr<CDir::TEntries> 
-        contents(dir.GetEntriesPtr(kEmptyStr, CDir::fIgnoreRecursive |  CDir::fIgnorePath));
-    if (contents.get() == NULL) {
-        // error
-        return;
-    }
+    CDirWalker walker(flags);
+    walker.Walk(dir.GetPath(), masks, masks_subdir,
+                [&find_func](const CDirWalker::CEntry& entry) {
+                    CDirEntry dir_entry(entry.GetPath());
+                    find_func(dir_entry);
+                    return CDirWalker::eContinue;
+                });
+}
 
-    NStr::ECase use_case = (flags & fFF_Nocase) ? NStr::eNocase : NStr::eCase;
-    string path;
 
-    if ( dir.GetPath().length() ) {
-        path = CDirEntry::AddTrailingPathSeparator(dir.GetPath());
+/// Find files in the specified directory
+template<class TFindFunc>
+void FindFilesInDir(const CDir&            dir,
+                    const vector<string>&  masks,
+                    const vector<string>&  masks_subdir,
+                    TFindFunc&             find_func,
+                    TFindFiles             flags = fFF_Default)
+{
+    CMaskFileName file_masks, subdir_masks;
+    ITERATE(vector<string>, it, masks) {
+        file_masks.Add(*it);
     }
-    ITERATE(CDir::TEntries, it, *contents) {
-        CDirEntry& dir_entry = **it;
-        string name = dir_entry.GetPath();
-        dir_entry.Reset(CDirEntry::MakePath(path, name));
-
-        TFindFiles entry_type = fFF_Dir | fFF_File; // unknown
-        if ( masks.Match(name, use_case) ) {
-            if ( find_type != (fFF_Dir | fFF_File) ) {
-                // need to check actual entry type
-                entry_type = dir_entry.IsDir()? fFF_Dir: fFF_File;
-            }
-            if ( (entry_type & find_type) != 0 ) {
-                // entry type matches
-                find_func(dir_entry);
-            }
-        }
-        if ( (flags & fFF_Recursive) &&
-             (entry_type & fFF_Dir) /*possible dir*/ &&
-             masks_subdir.Match(name, use_case) &&
-             (entry_type == fFF_Dir || dir_entry.IsDir()) /*real dir*/ ) {
-            CDir nested_dir(dir_entry.GetPath());
-            FindFilesInDir(nested_dir, masks, masks_subdir, find_func, flags);
-        }
+    ITERATE(vector<string>, it, masks_subdir) {
+        subdir_masks.Add(*it);
     }
-    return;
+    FindFilesInDir(dir, file_masks, subdir_masks, find_func, flags);
 }
 
 
@@ -1172,6 +1172,75 @@ private:
 
 
 
+class CReadBiasedRWLock;
+
+typedef CGuard< CReadBiasedRWLock,
+                SSimpleReadLock  <CReadBiasedRWLock>,
+                SSimpleReadUnlock<CReadBiasedRWLock> > CReadBiasedReadGuard;
+typedef CGuard< CReadBiasedRWLock,
+                SSimpleWriteLock  <CReadBiasedRWLock>,
+                SSimpleWriteUnlock<CReadBiasedRWLock> > CReadBiasedWriteGuard;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CReadBiasedRWLock --
+///
+/// Read/Write lock for read-mostly data with distributed reader indicators.
+///
+/// Each thread registers its read locks in one of kReaderSlots counters
+/// placed on separate cache lines, so readers running on different CPUs
+/// do not bounce a shared cache line (as CRWLock and CFastRWLock do);
+/// an uncontended read lock touches only the reader's own slot and reads
+/// the writer flag. A writer revokes the reader bias by raising the flag
+/// and waits for all slots to drain, so write locks are more expensive
+/// than with CFastRWLock and should be rare.
+///
+/// Has the same limitations as CFastRWLock: no recursive write locks,
+/// writers are always favored (so a recursive read lock may deadlock when
+/// a writer is waiting), and read locks are assumed to be short.
+/// Each lock object takes kReaderSlots cache lines of memory.
+
+class NCBI_XNCBI_EXPORT CReadBiasedRWLock
+{
+public:
+    typedef CReadBiasedReadGuard  TReadLockGuard;
+    typedef CReadBiasedWriteGuard TWriteLockGuard;
+
+    CReadBiasedRWLock(void);
+    ~CReadBiasedRWLock(void);
+
+    /// Acquire read lock
+    void ReadLock(void);
+    /// Release read lock
+    void ReadUnlock(void);
+
+    /// Acquire write lock
+    void WriteLock(void);
+    /// Release write lock
+    void WriteUnlock(void);
+
+    enum {
+        kReaderSlots = 32
+    };
+
+private:
+    CReadBiasedRWLock(const CReadBiasedRWLock&);
+    CReadBiasedRWLock& operator= (const CReadBiasedRWLock&);
+
+    struct SReaderSlot {
+        alignas(64) atomic<int> m_Count;
+    };
+
+    /// Readers' slots, each thread uses the same slot for all locks.
+    SReaderSlot      m_Readers[kReaderSlots];
+    /// Set while a writer holds or waits for the lock.
+    alignas(64) atomic<bool> m_WriterActive;
+    /// Mutex serializing writers, readers wait on it while a writer is active
+    CFastMutex       m_WriteLock;
+};
+
+
 class CYieldingRWLock;
 class CRWLockHolder;
 
@@ -293,6 +293,45 @@ public:
     /// Set mode from configuration parameter value.
     static void SetAllocFillMode(const string& value);
 
+    /// Allocator used by operator new for heap objects
+    ///
+    /// Default mode is eAllocatorHeap if not changed by configuration
+    /// ([NCBI]OBJECT_ALLOCATOR or NCBI_OBJECT_ALLOCATOR environment variable).
+    ///   eAllocatorHeap - global operator new/delete
+    ///   eAllocatorThreadCache - size-class allocator with thread-local
+    ///       caches of free blocks and central free lists, for objects
+    ///       up to 1KB. Memory taken by the allocator is reused for new
+    ///       objects but is never returned to the system.
+    /// The mode can be switched at any time, objects are always freed by
+    /// the allocator they came from. Placement and memory pool allocations
+    /// are not affected.
+    enum EAllocatorMode {
+        eAllocatorHeap = 1,
+        eAllocatorThreadCache
+    };
+    NCBI_XNCBI_EXPORT
+    static EAllocatorMode GetAllocatorMode(void);
+    NCBI_XNCBI_EXPORT
+    static void SetAllocatorMode(EAllocatorMode mode);
+    /// Set mode from configuration parameter value
+    /// ("Heap" or "ThreadCache", case-insensitive).
+    NCBI_XNCBI_EXPORT
+    static void SetAllocatorMode(const string& value);
+
+    /// Memory statistics of the thread-caching allocator.
+    struct SAllocatorStats {
+        Uint8 m_Allocations;    ///< Number of blocks allocated
+        Uint8 m_Deallocations;  ///< Number of blocks freed
+        Uint8 m_AllocatedBytes; ///< Bytes allocated
+        Uint8 m_FreedBytes;     ///< Bytes freed
+        Uint8 m_CachedBytes;    ///< Free bytes kept in the thread's cache
+        Uint8 m_ReservedBytes;  ///< Memory taken from the system (process)
+    };
+    /// Get allocator statistics for the current thread (m_ReservedBytes
+    /// is process-wide).
+    NCBI_XNCBI_EXPORT
+    static void GetAllocatorThreadStats(SAllocatorStats& stats);
+
 protected:
     /// Virtual method "deleting" this object.
     /// Method is called whenever by all other indicators this object should
@@ -358,6 +397,7 @@ public:
 private:
     friend class CObjectMemoryPool;
     friend class CWeakObject;
+    friend class CBiasedObject;
 
     // special methods for parsing object state number
 
@@ -2384,6 +2424,130 @@ private:
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBiasedObject --
+///
+/// CObject with biased reference counting.  References taken and released
+/// by the thread that created the object are counted in a plain
+/// (non-atomic) owner counter; other threads use the atomic counter of
+/// CObject, even if the object is never locked by its creator.  An object
+/// created by one thread for use by another one does not benefit from
+/// biasing.  While the owner counter is non-zero the atomic counter holds
+/// one reference on its behalf, released when the owner counter is merged.
+///
+/// References can still be passed between threads.  When another thread
+/// releases a reference that was counted by the owner, the release is
+/// queued to the owner thread, which merges it on its next biased
+/// operation, in ProcessQueuedReleases(), or when it exits.
+///
+/// The owner counter is used only by CBiasedObjectLocker, so the scheme is
+/// opt-in per reference type, e.g.:
+/// @code
+///   class CFeatInfo : public CBiasedObject { ... };
+///   typedef CRef<CFeatInfo, CBiasedObjectLocker> TFeatInfoRef;
+/// @endcode
+/// or, for all CRef<> and CConstRef<> of the class:
+/// @code
+///   template<> class CLockerTraits<CFeatInfo>
+///   {
+///   public:
+///       typedef CBiasedObjectLocker TLockerType;
+///   };
+/// @endcode
+/// References with other lockers (e.g. CRef<CObject>) use the atomic
+/// counter and can be mixed with biased ones.
+///
+/// Referenced() and ReferencedOnlyOnce() of this class count the owner's
+/// references too.  Called through a CObject pointer or reference, they
+/// see only the atomic counter, where the owner's references take two
+/// steps: ReferencedOnlyOnce() then returns false while the owner counter
+/// is in use, even if the object has a single reference.
+
+struct SBiasedObjectOwner;
+
+class NCBI_XNCBI_EXPORT CBiasedObject : public CObject
+{
+public:
+    /// The current thread becomes the owner of the object.
+    CBiasedObject(void);
+    /// The current thread becomes the owner of the copy, whichever thread
+    /// owns the source.
+    CBiasedObject(const CBiasedObject& src);
+    virtual ~CBiasedObject(void);
+
+    CBiasedObject& operator=(const CBiasedObject& ) THROWS_NONE
+        { return *this; }
+
+    /// Check if object is referenced.
+    bool Referenced(void) const THROWS_NONE;
+    /// Check if object is referenced only once.
+    bool ReferencedOnlyOnce(void) const THROWS_NONE;
+
+    /// Add reference to object.
+    void AddBiasedReference(void) const;
+    /// Remove reference to object, delete it if it was the last one.
+    void RemoveBiasedReference(void) const;
+    /// Remove reference without deleting object.
+    void ReleaseBiasedReference(void) const;
+
+    /// Merge releases queued to the current thread by other threads.
+    static void ProcessQueuedReleases(void);
+
+private:
+    friend struct SBiasedObjectOwner;
+
+    void x_Activate(void) const;
+    void x_Deactivate(bool release) const;
+    void x_RemoveGroup(bool release) const;
+    void x_RemoveOwned(bool release) const;
+    void x_RemoveShared(bool release) const;
+    void x_ProcessQueued(void) const;
+    Int8 x_GetReferences(void) const;
+
+    SBiasedObjectOwner*   m_Owner;   ///< Creating thread
+    /// Owner's references, changed only by the owner thread
+    mutable atomic<Uint4> m_Biased;
+    mutable atomic<Uint4> m_State;   ///< Flags and count of remote releases
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBiasedObjectLocker --
+///
+/// Locker for CRef/CConstRef to CBiasedObject.
+
+class CBiasedObjectLocker : public CObjectCounterLocker
+{
+public:
+    void Lock(const CBiasedObject* object) const
+        {
+            object->AddBiasedReference();
+        }
+
+    void Relock(const CBiasedObject* object) const
+        {
+            Lock(object);
+        }
+
+    void Unlock(const CBiasedObject* object) const
+        {
+            object->RemoveBiasedReference();
+        }
+
+    void UnlockRelease(const CBiasedObject* object) const
+        {
+            object->ReleaseBiasedReference();
+        }
+
+    void TransferLock(const CBiasedObject* /*object*/,
+                      const CBiasedObjectLocker& /*old_locker*/) const
+        {
+        }
+};
+
+
 // Forward declaration for CPtrToObjectProxy
 class CWeakObject;
 
@@ -399,6 +399,61 @@ private:
 
 
 
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CStrSplitter --
+///
+/// Iterate over the tokens of a string separated by any of a set of
+/// delimiter characters.  Tokens are CTempString views into the source
+/// string, so nothing is allocated; the source must outlive the splitter.
+/// Produces the same tokens as NStr::Split() with the same flags.
+///
+/// Only NStr::fSplit_MergeDelimiters, NStr::fSplit_Truncate_Begin and
+/// NStr::fSplit_Truncate_End are supported; use NStr::Split() for
+/// patterns, escapes and quotes.
+///
+/// @code
+///   CStrSplitter splitter(line, " \t", NStr::fSplit_Tokenize);
+///   CTempString  token;
+///   while ( splitter.Next(token) ) {
+///       ...
+///   }
+/// @endcode
+
+class NCBI_XNCBI_EXPORT CStrSplitter
+{
+public:
+    /// @param str
+    ///   String to split.
+    /// @param delim
+    ///   Set of delimiter characters.
+    /// @param flags
+    ///   Subset of NStr::ESplitFlags, see above.
+    /// @exception CStringException (eBadArgs) on unsupported flags.
+    CStrSplitter(const CTempString str, const CTempString delim,
+                 NStr::TSplitFlags flags = 0);
+
+    /// Get next token.
+    /// @return
+    ///   FALSE if there are no more tokens.
+    bool Next(CTempString& token);
+
+    /// Position of the next token in the source string, or NPOS.
+    SIZE_TYPE GetPos(void) const { return m_Pos; }
+    bool      AtEnd (void) const { return m_Pos == NPOS; }
+
+private:
+    void x_SkipDelims(void);
+
+    CTempString       m_Str;
+    CTempString       m_Delim;
+    SIZE_TYPE         m_Pos;
+    NStr::TSplitFlags m_Flags;
+};
+
+
+
  /*
  * @}
  */
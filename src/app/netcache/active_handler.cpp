@@ -884,7 +884,8 @@ CNCActiveHandler::CopyProlong(const CNCBlobKeyLight& key,
 void
 CNCActiveHandler::SyncStart(CNCActiveSyncControl* ctrl,
                             Uint8 local_rec_no,
-                            Uint8 remote_rec_no)
+                            Uint8 remote_rec_no,
+                            Uint8 digest_root)
 {
     m_SyncAction = eSynActionNone;
     m_SyncCtrl = ctrl;
@@ -900,12 +901,15 @@ CNCActiveHandler::SyncStart(CNCActiveSyncControl* ctrl,
     m_CmdToSend += NStr::UInt8ToString(local_rec_no);
     m_CmdToSend.append(1, ' ');
     m_CmdToSend += NStr::UInt8ToString(remote_rec_no);
+    m_CmdToSend.append(1, ' ');
+    m_CmdToSend += NStr::UInt8ToString(digest_root);
 
     x_SetStateAndStartProcessing(&CNCActiveHandler::x_SendCmdToExecute);
 }
 
 void
-CNCActiveHandler::SyncBlobsList(CNCActiveSyncControl* ctrl)
+CNCActiveHandler::SyncBlobsList(CNCActiveSyncControl* ctrl,
+                                const string& leaves)
 {
     m_SyncAction = eSynActionNone;
     m_SyncCtrl = ctrl;
@@ -917,6 +921,10 @@ CNCActiveHandler::SyncBlobsList(CNCActiveSyncControl* ctrl)
     m_CmdToSend += NStr::UInt8ToString(CNCDistributionConf::GetSelfID());
     m_CmdToSend.append(1, ' ');
     m_CmdToSend += NStr::UIntToString(ctrl->GetSyncSlot());
+    if (!leaves.empty()) {
+        m_CmdToSend.append(1, ' ');
+        m_CmdToSend += leaves;
+    }
 
     x_SetStateAndStartProcessing(&CNCActiveHandler::x_SendCmdToExecute);
 }
@@ -1750,9 +1758,18 @@ CNCActiveHandler::x_ReadSyncStartAnswer(void)
         return &CNCActiveHandler::x_ProcessProtocolError;
     }
 
-    bool by_blobs = m_CurCmd  == eSyncBList
-                    ||  NStr::FindCase(m_Response, "ALL_BLOBS") != NPOS;
+    m_SyncCtrl->AddSyncBytes(m_Response.size() + m_SizeToRead);
+    if (m_CurCmd == eSyncBList) {
+        // SYNC_BLIST follows SYNC_START which already gave record numbers
+        return &CNCActiveHandler::x_ReadBlobsListKeySize;
+    }
+    if (NStr::FindCase(m_Response, "DIGEST") != NPOS) {
+        m_SyncCtrl->StartResponse(local_rec_no, remote_rec_no, true);
+        m_ReadBuf.resize(0);
+        return &CNCActiveHandler::x_ReadSyncDigest;
+    }
 
+    bool by_blobs = NStr::FindCase(m_Response, "ALL_BLOBS") != NPOS;
     m_SyncCtrl->StartResponse(local_rec_no, remote_rec_no, by_blobs);
     if (by_blobs)
         return &CNCActiveHandler::x_ReadBlobsListKeySize;
@@ -1788,6 +1805,28 @@ CNCActiveHandler::x_ReadSyncStartExtra(void)
     return NULL;
 }
 
+CNCActiveHandler::State
+CNCActiveHandler::x_ReadSyncDigest(void)
+{
+    while (m_SizeToRead != 0) {
+        if (m_Proxy->NeedEarlyClose())
+            return &CNCActiveHandler::x_CloseCmdAndConn;
+
+        size_t prev_size = m_ReadBuf.size();
+        m_ReadBuf.resize(prev_size + size_t(m_SizeToRead));
+        size_t n_read = m_Proxy->Read(m_ReadBuf.data() + prev_size,
+                                      size_t(m_SizeToRead));
+        m_ReadBuf.resize(prev_size + n_read);
+        if (n_read == 0)
+            return NULL;
+        m_SizeToRead -= n_read;
+    }
+
+    m_SyncCtrl->SetRemoteDigest(m_ReadBuf.data(), m_ReadBuf.size());
+    x_FinishSyncCmd(eSynOK, NC_SYNC_HINT);
+    return &CNCActiveHandler::x_ReadSyncStartExtra;
+}
+
 CNCActiveHandler::State
 CNCActiveHandler::x_ReadEventsListKeySize(void)
 {
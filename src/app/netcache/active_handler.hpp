@@ -223,8 +223,9 @@ public:
     CTempString GetCmdResponse(void);
     bool GotClientResponse(void);
 
-    void SyncStart(CNCActiveSyncControl* ctrl, Uint8 local_rec_no, Uint8 remote_rec_no);
-    void SyncBlobsList(CNCActiveSyncControl* ctrl);
+    void SyncStart(CNCActiveSyncControl* ctrl, Uint8 local_rec_no, Uint8 remote_rec_no,
+                   Uint8 digest_root);
+    void SyncBlobsList(CNCActiveSyncControl* ctrl, const string& leaves);
     void SyncSend(CNCActiveSyncControl* ctrl, SNCSyncEvent* event);
     void SyncSend(CNCActiveSyncControl* ctrl, const CNCBlobKeyLight& key);
     void SyncRead(CNCActiveSyncControl* ctrl, SNCSyncEvent* event);
@@ -328,6 +329,7 @@ private:
     State x_ReadSyncStartHeader(void);
     State x_ReadSyncStartAnswer(void);
     State x_ReadSyncStartExtra(void);
+    State x_ReadSyncDigest(void);
     State x_ReadEventsListKeySize(void);
     State x_ReadEventsListBody(void);
     State x_ReadBlobsListKeySize(void);
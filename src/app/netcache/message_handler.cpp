@@ -229,6 +229,45 @@ static CNCMessageHandler::SCommandDef s_CommandMap[] = {
           // see ENCUserFlags, added in v6.11.0 (CXX-8737)
           { "flags",  eNSPT_Int,  eNSPA_Optional }
         } },
+    // Read several blobs in one batch. Command for "ICache" clients.
+    // Command line is followed by "cnt" lines each having parameters of
+    // one READ command (key version subkey ...). Each item is executed as
+    // a separate READ command, response to each of them is sent in order.
+    { "MGET",
+        {&CNCMessageHandler::x_DoCmd_Batch,
+            "IC_MGET",
+            fBatchCmd, eNCNone, eProxyNone},
+          // Name of cache for blobs.
+        { { "cache",   eNSPT_Id,   eNSPA_ICPrefix },
+          // Number of items in the batch.
+          { "cnt",     eNSPT_Int,  eNSPA_Required },
+          // Client IP for application sending the command.
+          { "ip",      eNSPT_Str,  fNSPA_Optional },
+          // Session ID for application sending the command.
+          { "sid",     eNSPT_Str,  eNSPA_Optional },
+          // request Hit ID
+          { "ncbi_phid", eNSPT_Str,  eNSPA_Optional }
+        } },
+    // Write several blobs in one batch. Command for "ICache" clients.
+    // Command line is followed by "cnt" items each consisting of parameters
+    // of one STOR command in a separate line and blob data in usual chunked
+    // format. Blob data must always be sent even if the item fails, and
+    // "confirm=1" is needed for each item to keep responses in sync.
+    { "MPUT",
+        {&CNCMessageHandler::x_DoCmd_Batch,
+            "IC_MPUT",
+            fBatchCmd, eNCNone, eProxyNone},
+          // Name of cache for blobs.
+        { { "cache",   eNSPT_Id,   eNSPA_ICPrefix },
+          // Number of items in the batch.
+          { "cnt",     eNSPT_Int,  eNSPA_Required },
+          // Client IP for application sending the command.
+          { "ip",      eNSPT_Str,  fNSPA_Optional },
+          // Session ID for application sending the command.
+          { "sid",     eNSPT_Str,  eNSPA_Optional },
+          // request Hit ID
+          { "ncbi_phid", eNSPT_Str,  eNSPA_Optional }
+        } },
     // Write blob contents. Old and deprecated command which probably is not
     // used by modern ICache clients anymore. It has the size of the blob right
     // in the command (so client should know it beforehand) and it doesn't use
@@ -463,6 +502,40 @@ static CNCMessageHandler::SCommandDef s_CommandMap[] = {
           // request Hit ID
           { "ncbi_phid", eNSPT_Str,  eNSPA_Optional }
         } },
+    // Read several blobs in one batch. Command for "NetCache" clients.
+    // Command line is followed by "cnt" lines each having parameters of
+    // one GET2 command. Response to each item is sent in order exactly as
+    // it would be sent for a separate GET2 command.
+    { "MGET",
+        {&CNCMessageHandler::x_DoCmd_Batch,
+            "MGET",
+            fBatchCmd, eNCNone, eProxyNone},
+          // Number of items in the batch.
+        { { "cnt",     eNSPT_Int,  eNSPA_Required },
+          // Client IP for application sending the command.
+          { "ip",      eNSPT_Str,  fNSPA_Optional },
+          // Session ID for application sending the command.
+          { "sid",     eNSPT_Str,  eNSPA_Optional },
+          // request Hit ID
+          { "ncbi_phid", eNSPT_Str,  eNSPA_Optional }
+        } },
+    // Write several blobs in one batch. Command for "NetCache" clients.
+    // Command line is followed by "cnt" items each consisting of parameters
+    // of one PUT3 command in a separate line and blob data in usual chunked
+    // format. Blob data must always be sent even if the item fails.
+    { "MPUT",
+        {&CNCMessageHandler::x_DoCmd_Batch,
+            "MPUT",
+            fBatchCmd, eNCNone, eProxyNone},
+          // Number of items in the batch.
+        { { "cnt",     eNSPT_Int,  eNSPA_Required },
+          // Client IP for application sending the command.
+          { "ip",      eNSPT_Str,  fNSPA_Optional },
+          // Session ID for application sending the command.
+          { "sid",     eNSPT_Str,  eNSPA_Optional },
+          // request Hit ID
+          { "ncbi_phid", eNSPT_Str,  eNSPA_Optional }
+        } },
     // Check if blob exists. Command for "NetCache" clients.
     { "HASB",
         {&CNCMessageHandler::x_DoCmd_HasBlob,
@@ -1000,7 +1073,11 @@ static CNCMessageHandler::SCommandDef s_CommandMap[] = {
           { "rec_my",  eNSPT_Int,  eNSPA_Required },
           // Last synchronized record number (in sync log) of _this_ server
           // as _that_ server thinks.
-          { "rec_your",eNSPT_Int,  eNSPA_Required } } },
+          { "rec_your",eNSPT_Int,  eNSPA_Required },
+          // Root of the digest of all blobs in the slot on _that_ server.
+          // If it's given and synchronization by blob lists is needed then
+          // digest leaves are sent instead of full list of blobs.
+          { "digest",  eNSPT_Str,  eNSPA_Optional } } },
     // Get full list of blobs for the slot. Command is sent only by other NC
     // servers when that server decides that synchronization using blob lists
     // is needed. Command can be sent only after successful execution of
@@ -1012,7 +1089,10 @@ static CNCMessageHandler::SCommandDef s_CommandMap[] = {
           // Server id of the server managing the synchronization.
         { { "srv_id",  eNSPT_Int,  eNSPA_Required },
           // Slot that synchronization is started on.
-          { "slot",    eNSPT_Int,  eNSPA_Required } } },
+          { "slot",    eNSPT_Int,  eNSPA_Required },
+          // Mask of digest leaves (in hex) which blobs should be listed.
+          // If not given then all blobs in the slot are listed.
+          { "leaves",  eNSPT_Str,  eNSPA_Optional } } },
     // Write blob contents. This command is sent only by other NC servers
     // during synchronization session if some blob was written on that server
     // and the same data didn't make it to this server yet.
@@ -1740,7 +1820,11 @@ CNCMessageHandler::CNCMessageHandler(void)
       m_write_event(NULL),
       m_ChunkLen(0),
       m_SrvsIndex(0),
-      m_ActiveHub(NULL)
+      m_ActiveHub(NULL),
+      m_BatchSize(0),
+      m_BatchLeft(0),
+      m_BatchPuts(false),
+      m_BatchBlobPending(false)
 {
     LOG_CURRENT_FUNCTION
 #if __NC_TASKS_MONITOR
@@ -1775,6 +1859,8 @@ CNCMessageHandler::x_SocketOpened(void)
     m_PrevCache.clear();
     m_ClientParams.clear();
     m_CntCmds = 0;
+    m_BatchLeft = 0;
+    m_BatchBlobPending = false;
 
     string host;
     Uint2 port = 0;
@@ -1963,6 +2049,9 @@ CNCMessageHandler::x_AssignCmdParams(void)
     m_ForceLocal = false;
     m_AgeMax = m_AgeCur = 0;
     m_SlotsDone.clear();
+    m_SyncDigest.clear();
+    m_SyncLeaves.clear();
+    m_BatchSize = 0;
     m_CmdParams.clear();
     bool quorum_was_set = false;
     bool search_was_set = false;
@@ -1998,6 +2087,11 @@ CNCMessageHandler::x_AssignCmdParams(void)
                         m_CmdVersion = NStr::StringToUInt(val);
                     }
                     break;
+                case 'n':
+                    if (key == "cnt") {
+                        m_BatchSize = NStr::StringToUInt(val);
+                    }
+                    break;
                 case 'o':
                     if (key == "confirm") {
                         if (val == "1")
@@ -2023,6 +2117,9 @@ CNCMessageHandler::x_AssignCmdParams(void)
                 if (key == "dead") {
                     m_CopyBlobInfo->dead_time = NStr::StringToInt(val);
                 }
+                else if (key == "digest") {
+                    m_SyncDigest = val;
+                }
                 break;
             case 'e':
                 if (key == "exp") {
@@ -2096,6 +2193,9 @@ CNCMessageHandler::x_AssignCmdParams(void)
                 else if (key == "local") {
                     m_ForceLocal = val == "1";
                 }
+                else if (key == "leaves") {
+                    m_SyncLeaves = val;
+                }
                 break;
             case 'm':
                 if (key == "md5_pass") {
@@ -2355,6 +2455,11 @@ CNCMessageHandler::x_StartCommand(void)
         x_ResetFlags();
         return &CNCMessageHandler::x_CloseCmdAndConn;
     }
+    if (x_IsFlagSet(fBatchCmd)) {
+        // All checks are made for each batch item separately.
+        diag_msg.Flush();
+        return m_CmdProcessor;
+    }
 
     if (x_IsFlagSet(fNeedsAdminClient)
         &&  m_ClientParams["client"] != CNCServer::GetAdminClient()
@@ -2560,6 +2665,15 @@ CNCMessageHandler::x_ReadCommand(void)
             GetDiagCtx()->SetRequestStatus(eStatus_PrematureClose);
         return &CNCMessageHandler::x_SaveStatsAndClose;
     }
+    if (m_BatchLeft != 0) {
+        // Line is an item of MGET/MPUT, it's executed as a separate command
+        // with the name defined by the batch header.
+        --m_BatchLeft;
+        m_BatchCmdLine = m_BatchPrefix;
+        m_BatchCmdLine.append(cmd_line.data(), cmd_line.size());
+        cmd_line = m_BatchCmdLine;
+        m_BatchBlobPending = m_BatchPuts;
+    }
 
     if (!x_IsHttpMode()) {
         try {
@@ -2639,6 +2753,10 @@ CNCMessageHandler::x_ReadCommand(void)
         GetDiagCtx()->SetRequestStatus(eStatus_BadCmd);
         return &CNCMessageHandler::x_SaveStatsAndClose;
     }
+    if (m_BatchBlobPending) {
+        // Client can't tell how the batch item ended without the final reply.
+        x_UnsetFlag(fNoReplyOnFinish);
+    }
     return &CNCMessageHandler::x_StartCommand;
 }
 
@@ -3053,6 +3171,11 @@ CNCMessageHandler::State
 CNCMessageHandler::x_FinishCommand(void)
 {
     LOG_CURRENT_FUNCTION
+    if (m_BatchBlobPending) {
+        // Batch item finished without reading its blob data. Client has sent
+        // it anyway, so it must be consumed before the next item.
+        return &CNCMessageHandler::x_SkipBlobSignature;
+    }
     int status = GetDiagCtx()->GetRequestStatus();
     if (x_IsFlagSet(eBlobPut) && m_NCBlobKey.IsICacheKey()) {
         x_JournalBlobPutResult(status, m_NCBlobKey.PackedKey(), m_BlobSlot);
@@ -3243,6 +3366,7 @@ CNCMessageHandler::x_ReadBlobSignature(void)
         return NULL;
 
     x_LogCmdEvent("ReadBlobSignature");
+    m_BatchBlobPending = false;
     if (sig == 0x04030201) {
         x_SetFlag(fSwapLengthBytes);
         return &CNCMessageHandler::x_ReadBlobChunkLength;
@@ -3418,6 +3542,66 @@ CNCMessageHandler::x_ReadBlobChunk(void)
     return &CNCMessageHandler::x_ReadBlobChunkLength;
 }
 
+CNCMessageHandler::State
+CNCMessageHandler::x_SkipBlobSignature(void)
+{
+    LOG_CURRENT_FUNCTION
+    Uint4 sig = 0;
+    bool has_sig = ReadNumber(&sig);
+    if (NeedEarlyClose())
+        return &CNCMessageHandler::x_CloseCmdAndConn;
+    if (!has_sig)
+        return NULL;
+
+    x_LogCmdEvent("SkipBlobSignature");
+    if (sig == 0x04030201) {
+        x_SetFlag(fSwapLengthBytes);
+    }
+    else if (sig == 0x01020304) {
+        x_UnsetFlag(fSwapLengthBytes);
+    }
+    else {
+        GetDiagCtx()->SetRequestStatus(eStatus_BadCmd);
+        SRV_LOG(Error, "Cannot determine the byte order. Got: "
+                       << NStr::UIntToString(sig, 0, 16));
+        return &CNCMessageHandler::x_CloseCmdAndConn;
+    }
+    m_ChunkLen = 0;
+    return &CNCMessageHandler::x_SkipBlobData;
+}
+
+CNCMessageHandler::State
+CNCMessageHandler::x_SkipBlobData(void)
+{
+    LOG_CURRENT_FUNCTION
+    char buf[4096];
+    for (;;) {
+        if (m_ChunkLen == 0) {
+            bool has_chunklen = ReadNumber(&m_ChunkLen);
+            if (NeedEarlyClose())
+                return &CNCMessageHandler::x_CloseCmdAndConn;
+            if (!has_chunklen)
+                return NULL;
+            if (x_IsFlagSet(fSwapLengthBytes))
+                m_ChunkLen = CByteSwap::GetInt4((const unsigned char*)&m_ChunkLen);
+            if (m_ChunkLen == 0xFFFFFFFF) {
+                m_ChunkLen = 0;
+                m_BatchBlobPending = false;
+                return &CNCMessageHandler::x_FinishCommand;
+            }
+        }
+        while (m_ChunkLen != 0) {
+            size_t n_read = Read(buf, min(size_t(m_ChunkLen), sizeof(buf)));
+            if (NeedEarlyClose())
+                return &CNCMessageHandler::x_CloseCmdAndConn;
+            if (n_read == 0)
+                return NULL;
+            CNCStat::ClientDataWrite(n_read);
+            m_ChunkLen -= Uint4(n_read);
+        }
+    }
+}
+
 CNCMessageHandler::State
 CNCMessageHandler::x_WriteBlobData(void)
 {
@@ -4448,6 +4632,27 @@ CNCMessageHandler::x_DoCmd_Remove(void)
     return &CNCMessageHandler::x_FinishReadingBlob;
 }
 
+CNCMessageHandler::State
+CNCMessageHandler::x_DoCmd_Batch(void)
+{
+    LOG_CURRENT_FUNCTION
+    m_BatchPuts = strcmp(m_ParsedCmd.command->cmd, "MPUT") == 0;
+    const CTempString& cache_name = m_NCBlobKey.Cache();
+    if (cache_name.empty()) {
+        m_BatchPrefix = m_BatchPuts ? "PUT3 " : "GET2 ";
+    }
+    else {
+        m_BatchPrefix = "IC(";
+        m_BatchPrefix.append(cache_name.data(), cache_name.size());
+        m_BatchPrefix += m_BatchPuts ? ") STOR " : ") READ ";
+    }
+    m_BatchLeft = m_BatchSize;
+    // Batch header doesn't have its own reply, each item replies exactly
+    // as the corresponding single command would.
+    x_SetFlag(fNoReplyOnFinish);
+    return &CNCMessageHandler::x_FinishCommand;
+}
+
 CNCMessageHandler::State
 CNCMessageHandler::x_DoCmd_IC_Store(void)
 {
@@ -4474,11 +4679,12 @@ CNCMessageHandler::x_DoCmd_IC_Store(void)
 }
 
 void
-CNCMessageHandler::x_WriteFullBlobsList(void)
+CNCMessageHandler::x_WriteFullBlobsList(const TNCSyncLeavesMask* leaves)
 {
     LOG_CURRENT_FUNCTION
     TNCBlobSumList blobs_list;
-    CNCBlobStorage::GetFullBlobsList(m_Slot, blobs_list, CNCPeerControl::Peer(m_SrvId));
+    CNCBlobStorage::GetFullBlobsList(m_Slot, blobs_list,
+                                     CNCPeerControl::Peer(m_SrvId), leaves);
     m_SendBuff.reset(new TNCBufferType());
     m_SendBuff->reserve_mem(blobs_list.size() * 200);
     NON_CONST_ITERATE(TNCBlobSumList, it_blob, blobs_list) {
@@ -4509,6 +4715,21 @@ error_return:
     }
 }
 
+void
+CNCMessageHandler::x_WriteSlotDigest(void)
+{
+    LOG_CURRENT_FUNCTION
+    m_SendBuff.reset(new TNCBufferType());
+    Uint8 peer_root = NStr::StringToUInt8(m_SyncDigest, NStr::fConvErr_NoThrow);
+    if (peer_root == CNCSyncDigest::GetRoot(m_Slot)) {
+        // Nothing differs, peer doesn't need any leaves
+        return;
+    }
+    TNCSyncDigest leaves;
+    CNCSyncDigest::GetLeaves(m_Slot, leaves);
+    m_SendBuff->append(&leaves[0], leaves.size() * sizeof(leaves[0]));
+}
+
 CNCMessageHandler::State
 CNCMessageHandler::x_DoCmd_SyncStart(void)
 {
@@ -4583,10 +4804,16 @@ CNCMessageHandler::x_DoCmd_SyncStart(void)
     else {
         _ASSERT(sync_res == eProceedWithBlobs);
         m_LocalRecNo = CNCSyncLog::GetCurrentRecNo(m_Slot);
-        x_WriteFullBlobsList();
         GetDiagCtx()->SetRequestStatus(eStatus_SyncBList);
         x_SetFlag(fSyncCmdSuccessful);
-        result += "ALL_BLOBS,";
+        if (m_SyncDigest.empty()) {
+            x_WriteFullBlobsList();
+            result += "ALL_BLOBS,";
+        }
+        else {
+            x_WriteSlotDigest();
+            result += "DIGEST,";
+        }
     }
 
     if (NeedEarlyClose())
@@ -4607,7 +4834,15 @@ CNCMessageHandler::x_DoCmd_SyncBlobsList(void)
     LOG_CURRENT_FUNCTION
     CNCPeriodicSync::MarkCurSyncByBlobs(m_SrvId, m_Slot, m_SyncId);
     Uint8 rec_no = CNCSyncLog::GetCurrentRecNo(m_Slot);
-    x_WriteFullBlobsList();
+    TNCSyncLeavesMask leaves;
+    if (!m_SyncLeaves.empty()
+        &&  CNCSyncDigest::UnpackLeavesMask(m_SyncLeaves, leaves))
+    {
+        x_WriteFullBlobsList(&leaves);
+    }
+    else {
+        x_WriteFullBlobsList();
+    }
 
     if (NeedEarlyClose())
         return &CNCMessageHandler::x_CloseCmdAndConn;
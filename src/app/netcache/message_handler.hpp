@@ -34,6 +34,7 @@
 #include <connect/services/netservice_protocol_parser.hpp>
 
 #include "nc_utils.hpp"
+#include "sync_digest.hpp"
 
 
 BEGIN_NCBI_SCOPE
@@ -109,6 +110,8 @@ enum ENCCmdFlags {
     fIsHttp             = 1 << 23,
     /// Command needs access to the blob list.
     fNeedsBlobList     = 1 <<  24,
+    /// Command is a header of a batch of blob commands (MGET/MPUT).
+    fBatchCmd           = 1 << 25,
 
 
     eProxyBlobRead      = fNeedsBlobAccess | fUsesPeerSearch,
@@ -207,6 +210,7 @@ public:
     State x_DoCmd_GetMeta(void);
     State x_DoCmd_ProxyMeta(void);
     State x_DoCmd_CopyUpdate(void);
+    State x_DoCmd_Batch(void);
     //State x_DoCmd_GetBlobsList(void);
     /// Universal processor for all commands not implemented now.
     State x_DoCmd_NotImplemented(void);
@@ -252,6 +256,9 @@ private:
     State x_ReadBlobChunkLength(void);
     /// Read chunk data in blob transfer protocol
     State x_ReadBlobChunk(void);
+    /// Consume blob data that batch item didn't read because of error
+    State x_SkipBlobSignature(void);
+    State x_SkipBlobData(void);
     /// Write data from blob to socket
     State x_WriteBlobData(void);
     State x_WriteSendBuff(void);
@@ -291,7 +298,8 @@ private:
 
     void x_ProlongBlobDeadTime(unsigned int add_time);
     void x_ProlongVersionLife(void);
-    void x_WriteFullBlobsList(void);
+    void x_WriteFullBlobsList(const TNCSyncLeavesMask* leaves = NULL);
+    void x_WriteSlotDigest(void);
     void x_GetCurSlotServers(void);
 
     void x_JournalBlobPutResult(int status, const string& blob_key, Uint2 blob_slot);
@@ -370,6 +378,8 @@ private:
     bool                      m_StatPrev;
     Uint1                     m_SrvsIndex;
     int                       m_CmdVersion;
+    string                    m_SyncDigest;
+    string                    m_SyncLeaves;
     Uint8                     m_LatestSrvId;
     SNCBlobSummary*           m_LatestBlobSum;
     TServersList              m_CheckSrvs;
@@ -381,6 +391,18 @@ private:
     Uint8                     m_AgeCur;
     SNCBlobFilter*            m_BlobFilter;
     set<Uint2>                m_SlotsDone;
+    /// Number of items announced in MGET/MPUT command
+    Uint4                     m_BatchSize;
+    /// Number of batch items not read from client yet
+    Uint4                     m_BatchLeft;
+    /// Command prefix prepended to each batch item line
+    string                    m_BatchPrefix;
+    /// Full command line of the current batch item
+    string                    m_BatchCmdLine;
+    /// Batch items are writes with blob data following each item line
+    bool                      m_BatchPuts;
+    /// Batch item hasn't consumed blob data sent by client yet
+    bool                      m_BatchBlobPending;
 
     string m_PosponedCmd;
     enum EHttpMode {
@@ -0,0 +1,570 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Compression of blob chunks stored in NetCache database
+ *
+ */
+
+#include "nc_pch.hpp"
+
+#include <corelib/ncbireg.hpp>
+
+#include "nc_compress.hpp"
+#include "nc_storage.hpp"
+
+#ifdef HAVE_LIBZ
+#  include <zlib.h>
+#endif
+
+#include <queue>
+#include <unordered_map>
+
+
+BEGIN_NCBI_SCOPE
+
+
+static const char* kNCCompress_RegSection = "storage";
+static const char* kNCCompress_CodecParam = "compression";
+static const char* kNCCompress_LevelParam = "compression_level";
+static const char* kNCCompress_DictParam  = "compression_dict";
+
+/// Chunks smaller than that are not compressed
+static const Uint4  kMinPackSize      = 64;
+/// Dictionary is trained when that many first chunks of the cache's blobs
+/// are sampled;  only the beginning of each chunk is taken
+static const size_t kDictSamplesCnt   = 128;
+static const Uint4  kDictSampleSize   = 4 * 1024;
+/// Limit on memory taken by samples of all caches
+static const size_t kMaxSamplesMem    = 64 * 1024 * 1024;
+/// Size of dictionary, deflate can't use more than 32 KB
+static const size_t kDictSize         = 16 * 1024;
+/// Maximum number of caches having their own dictionaries
+static const size_t kMaxDicts         = 1000;
+
+
+struct SNCDictionary
+{
+    Uint4  id;
+    string cache;
+    string data;
+};
+
+struct SNCDictSamples
+{
+    vector<string> samples;
+    bool is_training;
+    bool is_trained;
+
+    SNCDictSamples(void) : is_training(false), is_trained(false) {}
+};
+
+class CNCDictTrainer : public CSrvTask
+{
+public:
+    CNCDictTrainer(void);
+    virtual ~CNCDictTrainer(void);
+
+private:
+    virtual void ExecuteSlice(TSrvThreadNum thr_num);
+};
+
+
+typedef map<Uint4, const SNCDictionary*>  TDictsById;
+typedef map<string, const SNCDictionary*> TDictsByCache;
+typedef map<string, SNCDictSamples>       TDictSamples;
+
+/// Dictionaries are never changed or deleted once registered, so they can
+/// be used without holding the lock
+static CMiniMutex s_DictLock;
+static TDictsById s_DictsById;
+static TDictsByCache s_DictsByCache;
+static TDictSamples s_DictSamples;
+static size_t s_SamplesMem = 0;
+static Uint4 s_LastDictId = 0;
+static CNCDictTrainer* s_DictTrainer = nullptr;
+
+static ENCChunkCodec s_Codec = eNCCodecNone;
+static int s_Level = 1;
+static bool s_UseDict = true;
+
+static Int8 s_CntPacked = 0;
+static Int8 s_CntNotPacked = 0;
+static Int8 s_PackedDataSize = 0;
+static Int8 s_PackedSize = 0;
+static Int8 s_CntUnpacked = 0;
+static Int8 s_CntUnpackFailed = 0;
+
+
+#ifdef HAVE_LIBZ
+/// Deflate/inflate state is reused by all chunks compressed in the thread
+struct SNCZlibStreams
+{
+    z_stream deflater;
+    z_stream inflater;
+    int      deflate_level;
+    bool     has_inflater;
+    string   buffer;
+
+    SNCZlibStreams(void) : deflate_level(0), has_inflater(false) {}
+    ~SNCZlibStreams(void)
+    {
+        if (deflate_level)
+            deflateEnd(&deflater);
+        if (has_inflater)
+            inflateEnd(&inflater);
+    }
+};
+
+static thread_local SNCZlibStreams s_ZStreams;
+#endif
+
+
+static const SNCDictionary*
+s_GetDictionary(Uint4 dict_id)
+{
+    s_DictLock.Lock();
+    TDictsById::const_iterator it = s_DictsById.find(dict_id);
+    const SNCDictionary* dict = it == s_DictsById.end()? NULL: it->second;
+    s_DictLock.Unlock();
+    return dict;
+}
+
+/// Find dictionary for the cache; while there's none take sample of the
+/// first chunk and request training when there are enough samples
+static const SNCDictionary*
+s_GetCacheDictionary(const CTempString& cache, bool first_chunk,
+                     const char* data, Uint4 size)
+{
+    const SNCDictionary* dict = NULL;
+    bool need_train = false;
+
+    s_DictLock.Lock();
+    TDictsByCache::const_iterator it = s_DictsByCache.find(cache);
+    if (it != s_DictsByCache.end()) {
+        dict = it->second;
+    }
+    else if (first_chunk  &&  s_SamplesMem < kMaxSamplesMem) {
+        TDictSamples::iterator it_smp = s_DictSamples.find(cache);
+        if (it_smp == s_DictSamples.end()
+            &&  s_DictSamples.size() + s_DictsByCache.size() < kMaxDicts)
+        {
+            it_smp = s_DictSamples.insert(TDictSamples::value_type(cache, SNCDictSamples())).first;
+        }
+        if (it_smp != s_DictSamples.end()
+            &&  !it_smp->second.is_training  &&  !it_smp->second.is_trained)
+        {
+            SNCDictSamples& smp = it_smp->second;
+            smp.samples.push_back(string(data, min(size, kDictSampleSize)));
+            s_SamplesMem += smp.samples.back().size();
+            if (smp.samples.size() >= kDictSamplesCnt) {
+                smp.is_training = true;
+                need_train = s_DictTrainer != nullptr;
+            }
+        }
+    }
+    s_DictLock.Unlock();
+
+    if (need_train)
+        s_DictTrainer->SetRunnable();
+    return dict;
+}
+
+/// Build dictionary from pieces of samples having the most d-mers (strings
+/// of kDmer bytes) that occur in many different samples. Pieces are taken
+/// greedily, d-mers covered by the piece taken don't count anymore. This is
+/// a simplified version of COVER algorithm used by zstd.
+static string
+s_TrainDictionary(const vector<string>& samples, size_t dict_size)
+{
+    static const size_t kDmer    = sizeof(Uint8);
+    static const size_t kSegment = 64;
+    static const size_t kStep    = 16;
+
+    struct SDmerFreq {
+        Uint4 cnt;
+        Uint4 last_sample;
+    };
+    unordered_map<Uint8, SDmerFreq> freqs;
+    for (Uint4 s = 0; s < samples.size(); ++s) {
+        const string& smp = samples[s];
+        for (size_t i = 0; i + kDmer <= smp.size(); ++i) {
+            Uint8 dmer;
+            memcpy(&dmer, smp.data() + i, kDmer);
+            SDmerFreq& freq = freqs[dmer];
+            if (freq.cnt == 0  ||  freq.last_sample != s) {
+                ++freq.cnt;
+                freq.last_sample = s;
+            }
+        }
+    }
+
+    auto score = [&](Uint4 s, size_t pos) -> Uint8 {
+        const string& smp = samples[s];
+        size_t end = min(pos + kSegment, smp.size());
+        Uint8 result = 0;
+        for (size_t i = pos; i + kDmer <= end; ++i) {
+            Uint8 dmer;
+            memcpy(&dmer, smp.data() + i, kDmer);
+            Uint4 cnt = freqs[dmer].cnt;
+            if (cnt > 1)
+                result += cnt;
+        }
+        return result;
+    };
+
+    typedef pair<Uint8, pair<Uint4, size_t> > TCandidate;
+    priority_queue<TCandidate> candidates;
+    for (Uint4 s = 0; s < samples.size(); ++s) {
+        for (size_t pos = 0; pos + kDmer <= samples[s].size(); pos += kStep) {
+            Uint8 cand_score = score(s, pos);
+            if (cand_score != 0)
+                candidates.push(TCandidate(cand_score, make_pair(s, pos)));
+        }
+    }
+
+    vector<CTempString> segments;
+    size_t total_size = 0;
+    while (total_size < dict_size  &&  !candidates.empty()) {
+        TCandidate cand = candidates.top();
+        candidates.pop();
+        Uint4 s = cand.second.first;
+        size_t pos = cand.second.second;
+        // Scores only decrease, so re-evaluated candidate that is still
+        // not worse than the next one is the best
+        Uint8 cur_score = score(s, pos);
+        if (cur_score == 0)
+            continue;
+        if (cur_score < cand.first) {
+            candidates.push(TCandidate(cur_score, cand.second));
+            continue;
+        }
+
+        const string& smp = samples[s];
+        size_t len = min(min(kSegment, smp.size() - pos), dict_size - total_size);
+        segments.push_back(CTempString(smp.data() + pos, len));
+        total_size += len;
+        for (size_t i = pos; i + kDmer <= pos + len; ++i) {
+            Uint8 dmer;
+            memcpy(&dmer, smp.data() + i, kDmer);
+            freqs[dmer].cnt = 0;
+        }
+    }
+
+    // Deflate finds closer matches cheaper, so the best pieces go last
+    string dict;
+    dict.reserve(total_size);
+    REVERSE_ITERATE(vector<CTempString>, it, segments) {
+        dict.append(it->data(), it->size());
+    }
+    return dict;
+}
+
+
+void
+CNCChunkCodec::ReadParams(const CNcbiRegistry& reg)
+{
+    string codec = reg.GetString(kNCCompress_RegSection, kNCCompress_CodecParam, "none");
+    if (NStr::EqualNocase(codec, "zlib")) {
+#ifdef HAVE_LIBZ
+        s_Codec = eNCCodecZlib;
+#else
+        SRV_LOG(Error, "Parameter " << kNCCompress_CodecParam
+                       << " is 'zlib' but compression is not supported. Ignoring it.");
+        s_Codec = eNCCodecNone;
+#endif
+    }
+    else {
+        if (!NStr::EqualNocase(codec, "none")) {
+            SRV_LOG(Error, "Parameter " << kNCCompress_CodecParam
+                           << " has unknown value '" << codec << "'. Assuming it's none.");
+        }
+        s_Codec = eNCCodecNone;
+    }
+
+    int level = reg.GetInt(kNCCompress_RegSection, kNCCompress_LevelParam, 1);
+    if (level < 1  ||  level > 9) {
+        SRV_LOG(Error, "Parameter " << kNCCompress_LevelParam << " has wrong value "
+                       << level << ". Assuming it's 1.");
+        level = 1;
+    }
+    s_Level = level;
+    s_UseDict = reg.GetBool(kNCCompress_RegSection, kNCCompress_DictParam, true);
+}
+
+void
+CNCChunkCodec::AddDictionary(Uint4 dict_id, const string& cache,
+                             const string& dict_data)
+{
+    SNCDictionary* dict = new SNCDictionary();
+    dict->id = dict_id;
+    dict->cache = cache;
+    dict->data = dict_data;
+
+    s_DictLock.Lock();
+    s_DictsById[dict_id] = dict;
+    s_DictsByCache[cache] = dict;
+    s_LastDictId = max(s_LastDictId, dict_id);
+    s_DictLock.Unlock();
+}
+
+void
+CNCChunkCodec::Initialize(void)
+{
+    s_DictTrainer = new CNCDictTrainer();
+}
+
+ENCChunkCodec
+CNCChunkCodec::Pack(const CTempString& cache, bool first_chunk,
+                    const char* data, Uint4 size, CTempString& packed)
+{
+    ENCChunkCodec codec = ACCESS_ONCE(s_Codec);
+    if (codec == eNCCodecNone  ||  size < kMinPackSize)
+        return eNCCodecNone;
+
+#ifdef HAVE_LIBZ
+    const SNCDictionary* dict = NULL;
+    if (s_UseDict)
+        dict = s_GetCacheDictionary(cache, first_chunk, data, size);
+
+    SNCZlibStreams& zs = s_ZStreams;
+    int level = s_Level;
+    int res = Z_OK;
+    if (zs.deflate_level != level) {
+        if (zs.deflate_level)
+            deflateEnd(&zs.deflater);
+        memset(&zs.deflater, 0, sizeof(zs.deflater));
+        res = deflateInit2(&zs.deflater, level, Z_DEFLATED, -MAX_WBITS,
+                           8, Z_DEFAULT_STRATEGY);
+        zs.deflate_level = res == Z_OK? level: 0;
+    }
+    else {
+        res = deflateReset(&zs.deflater);
+    }
+    if (res == Z_OK  &&  dict) {
+        res = deflateSetDictionary(&zs.deflater, (const Bytef*)dict->data.data(),
+                                   uInt(dict->data.size()));
+    }
+    if (res != Z_OK) {
+        SRV_LOG(Critical, "Cannot initialize deflate, error " << res);
+        return eNCCodecNone;
+    }
+
+    // Compression should save at least 1/16 of the size
+    Uint4 max_size = size - size / 16;
+    zs.buffer.resize(max_size);
+    SNCPackedChunkHdr* hdr = (SNCPackedChunkHdr*)&zs.buffer[0];
+    hdr->dict_id = dict? dict->id: 0;
+    hdr->data_size = size;
+    zs.deflater.next_in = (Bytef*)data;
+    zs.deflater.avail_in = size;
+    zs.deflater.next_out = (Bytef*)&zs.buffer[sizeof(*hdr)];
+    zs.deflater.avail_out = uInt(max_size - sizeof(*hdr));
+    if (deflate(&zs.deflater, Z_FINISH) != Z_STREAM_END) {
+        AtomicAdd(s_CntNotPacked, 1);
+        return eNCCodecNone;
+    }
+
+    Uint4 packed_size = max_size - zs.deflater.avail_out;
+    packed = CTempString(zs.buffer.data(), packed_size);
+    AtomicAdd(s_CntPacked, 1);
+    AtomicAdd(s_PackedDataSize, size);
+    AtomicAdd(s_PackedSize, packed_size);
+    return eNCCodecZlib;
+#else
+    return eNCCodecNone;
+#endif
+}
+
+Uint4
+CNCChunkCodec::GetUnpackedSize(Uint1 codec, const char* data, Uint4 size)
+{
+    if (codec == eNCCodecNone)
+        return size;
+    if (codec != eNCCodecZlib  ||  size < sizeof(SNCPackedChunkHdr))
+        return 0;
+    return ((const SNCPackedChunkHdr*)data)->data_size;
+}
+
+bool
+CNCChunkCodec::Unpack(Uint1 codec, const char* data, Uint4 size, string& buffer)
+{
+    Uint4 data_size = GetUnpackedSize(codec, data, size);
+    if (data_size == 0  ||  codec != eNCCodecZlib) {
+        AtomicAdd(s_CntUnpackFailed, 1);
+        return false;
+    }
+
+#ifdef HAVE_LIBZ
+    const SNCPackedChunkHdr* hdr = (const SNCPackedChunkHdr*)data;
+    const SNCDictionary* dict = NULL;
+    if (hdr->dict_id != 0) {
+        dict = s_GetDictionary(hdr->dict_id);
+        if (!dict) {
+            SRV_LOG(Critical, "Unknown compression dictionary " << hdr->dict_id);
+            AtomicAdd(s_CntUnpackFailed, 1);
+            return false;
+        }
+    }
+
+    SNCZlibStreams& zs = s_ZStreams;
+    int res;
+    if (!zs.has_inflater) {
+        memset(&zs.inflater, 0, sizeof(zs.inflater));
+        res = inflateInit2(&zs.inflater, -MAX_WBITS);
+        zs.has_inflater = res == Z_OK;
+    }
+    else {
+        res = inflateReset(&zs.inflater);
+    }
+    if (res == Z_OK  &&  dict) {
+        res = inflateSetDictionary(&zs.inflater, (const Bytef*)dict->data.data(),
+                                   uInt(dict->data.size()));
+    }
+    if (res != Z_OK) {
+        SRV_LOG(Critical, "Cannot initialize inflate, error " << res);
+        AtomicAdd(s_CntUnpackFailed, 1);
+        return false;
+    }
+
+    buffer.resize(data_size);
+    zs.inflater.next_in = (Bytef*)(data + sizeof(*hdr));
+    zs.inflater.avail_in = uInt(size - sizeof(*hdr));
+    zs.inflater.next_out = (Bytef*)&buffer[0];
+    zs.inflater.avail_out = data_size;
+    if (inflate(&zs.inflater, Z_FINISH) != Z_STREAM_END
+        ||  zs.inflater.avail_out != 0)
+    {
+        AtomicAdd(s_CntUnpackFailed, 1);
+        return false;
+    }
+    AtomicAdd(s_CntUnpacked, 1);
+    return true;
+#else
+    AtomicAdd(s_CntUnpackFailed, 1);
+    return false;
+#endif
+}
+
+void
+CNCChunkCodec::WriteSetup(CSrvSocketTask& task)
+{
+    string is("\": "), iss("\": \""), eol(",\n\""), eos("\"");
+    task.WriteText(eol).WriteText(kNCCompress_CodecParam).WriteText(iss)
+                       .WriteText(s_Codec == eNCCodecZlib? "zlib": "none").WriteText(eos);
+    task.WriteText(eol).WriteText(kNCCompress_LevelParam).WriteText(is).WriteNumber(s_Level);
+    task.WriteText(eol).WriteText(kNCCompress_DictParam).WriteText(is)
+                       .WriteText(NStr::BoolToString(s_UseDict));
+}
+
+void
+CNCChunkCodec::WriteStat(CSrvSocketTask& task)
+{
+    s_DictLock.Lock();
+    size_t cnt_dicts = s_DictsById.size();
+    size_t samples_mem = s_SamplesMem;
+    s_DictLock.Unlock();
+
+    string is("\": "), eol(",\n\"");
+    task.WriteText(eol).WriteText("Packed_chunks").WriteText(is).WriteNumber(s_CntPacked);
+    task.WriteText(eol).WriteText("NotPacked_chunks").WriteText(is).WriteNumber(s_CntNotPacked);
+    task.WriteText(eol).WriteText("Packed_data_size").WriteText(is).WriteNumber(s_PackedDataSize);
+    task.WriteText(eol).WriteText("Packed_size").WriteText(is).WriteNumber(s_PackedSize);
+    task.WriteText(eol).WriteText("Unpacked_chunks").WriteText(is).WriteNumber(s_CntUnpacked);
+    task.WriteText(eol).WriteText("Unpack_failures").WriteText(is).WriteNumber(s_CntUnpackFailed);
+    task.WriteText(eol).WriteText("Pack_dictionaries").WriteText(is).WriteNumber(cnt_dicts);
+    task.WriteText(eol).WriteText("Pack_samples_mem").WriteText(is).WriteNumber(samples_mem);
+}
+
+
+CNCDictTrainer::CNCDictTrainer(void)
+{
+#if __NC_TASKS_MONITOR
+    m_TaskName = "CNCDictTrainer";
+#endif
+}
+
+CNCDictTrainer::~CNCDictTrainer(void)
+{}
+
+void
+CNCDictTrainer::ExecuteSlice(TSrvThreadNum /* thr_num */)
+{
+    if (CTaskServer::IsInShutdown())
+        return;
+
+    string cache;
+    vector<string> samples;
+    bool has_more = false;
+    s_DictLock.Lock();
+    NON_CONST_ITERATE(TDictSamples, it, s_DictSamples) {
+        SNCDictSamples& smp = it->second;
+        if (smp.is_training  &&  !smp.is_trained) {
+            if (samples.empty()) {
+                cache = it->first;
+                samples.swap(smp.samples);
+                smp.is_trained = true;
+            }
+            else {
+                has_more = true;
+                break;
+            }
+        }
+    }
+    s_DictLock.Unlock();
+    if (samples.empty())
+        return;
+
+    size_t samples_size = 0;
+    ITERATE(vector<string>, it, samples) {
+        samples_size += it->size();
+    }
+
+    string dict = s_TrainDictionary(samples, kDictSize);
+    if (!dict.empty()) {
+        s_DictLock.Lock();
+        Uint4 dict_id = ++s_LastDictId;
+        s_DictLock.Unlock();
+
+        // Dictionary must be saved before any chunk refers to it
+        if (CNCBlobStorage::SaveChunkDictionary(dict_id, cache, dict)) {
+            CNCChunkCodec::AddDictionary(dict_id, cache, dict);
+            INFO("Trained compression dictionary " << dict_id << " of "
+                 << dict.size() << " bytes for cache '" << cache << "'");
+        }
+    }
+
+    s_DictLock.Lock();
+    s_SamplesMem -= samples_size;
+    s_DictLock.Unlock();
+
+    if (has_more)
+        SetRunnable();
+}
+
+
+END_NCBI_SCOPE
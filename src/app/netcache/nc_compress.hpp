@@ -0,0 +1,98 @@
+#ifndef NETCACHE__NC_COMPRESS__HPP
+#define NETCACHE__NC_COMPRESS__HPP
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Compression of blob chunks stored in NetCache database, with
+ *   dictionaries trained separately for each cache
+ */
+
+#include "nc_utils.hpp"
+
+
+BEGIN_NCBI_SCOPE
+
+
+/// Codec used for the chunk data record, saved in SFileIndexRec::rec_codec
+enum ENCChunkCodec {
+    eNCCodecNone = 0,   ///< chunk data is stored as is
+    eNCCodecZlib = 1    ///< raw deflate stream, optionally with dictionary
+};
+
+/// Header of the compressed chunk data, data itself follows it
+struct ATTR_PACKED SNCPackedChunkHdr
+{
+    Uint4 dict_id;      ///< dictionary used, 0 if none
+    Uint4 data_size;    ///< size of the chunk data before compression
+};
+
+
+/// Compression of blob chunks.
+/// Chunks are compressed when write-back memory is written to disk and when
+/// CSpaceShrinker moves uncompressed chunks;  the chunk is stored compressed
+/// only if it gets noticeably smaller. Dictionary for each cache (all blobs
+/// created via CNetCacheAPI share one) is trained on the first chunks of the
+/// blobs written into it, it's saved in the index database before any chunk
+/// uses it and it's never changed afterwards.
+/// Compression is local to the server: clients and peers (mirroring and
+/// periodic sync alike) always get the unpacked data, and each peer decides
+/// on its own whether to compress the blobs it receives. Peers don't share
+/// dictionaries, so passing packed chunks between them is not supported.
+class CNCChunkCodec
+{
+public:
+    /// Read compression settings from [storage] section of the registry
+    static void ReadParams(const CNcbiRegistry& reg);
+    /// Register dictionary read from the index database
+    static void AddDictionary(Uint4 dict_id, const string& cache,
+                              const string& dict_data);
+    /// Start the dictionaries' training task
+    static void Initialize(void);
+
+    /// Compress the chunk of a blob from the given cache. Returns the codec
+    /// to store the chunk with;  if it's not eNCCodecNone then "packed"
+    /// points to header and compressed data which remain valid until the
+    /// next call to Pack() in the same thread.
+    static ENCChunkCodec Pack(const CTempString& cache, bool first_chunk,
+                              const char* data, Uint4 size,
+                              CTempString& packed);
+    /// Decompress the chunk data (header included) into the buffer.
+    /// Returns FALSE if data is corrupted or dictionary is unknown.
+    static bool Unpack(Uint1 codec, const char* data, Uint4 size,
+                       string& buffer);
+    /// Size of the chunk data before compression, 0 if header is broken
+    static Uint4 GetUnpackedSize(Uint1 codec, const char* data, Uint4 size);
+
+    static void WriteSetup(CSrvSocketTask& task);
+    static void WriteStat(CSrvSocketTask& task);
+};
+
+
+END_NCBI_SCOPE
+
+#endif /* NETCACHE__NC_COMPRESS__HPP */
@@ -48,6 +48,11 @@ BEGIN_NCBI_SCOPE
 #define SETTINGS_NAME       "nm"
 #define SETTINGS_VALUE      "v"
 
+#define DICTS_TABLENAME     "NCD"
+#define DICTS_ID            "id"
+#define DICTS_CACHE         "nm"
+#define DICTS_DATA          "d"
+
 
 
 CNCDBIndexFile::~CNCDBIndexFile(void)
@@ -74,6 +79,14 @@ CNCDBIndexFile::CreateDatabase(void)
           ")";
     stmt.SetSql(sql);
     stmt.Execute();
+
+    sql = "create table if not exists " DICTS_TABLENAME
+          "(" DICTS_ID    " integer primary key,"
+              DICTS_CACHE " varchar not null,"
+              DICTS_DATA  " blob not null"
+          ")";
+    stmt.SetSql(sql);
+    stmt.Execute();
 }
 
 void
@@ -186,4 +199,41 @@ CNCDBIndexFile::UpdatePurgeData(const string& data)
     stmt.Execute();
 }
 
+void
+CNCDBIndexFile::SaveDictionary(Uint4 dict_id, const string& cache,
+                               const string& dict_data)
+{
+    const char* sql;
+    sql = "insert or replace into " DICTS_TABLENAME
+          "(" DICTS_ID    ","
+              DICTS_CACHE ","
+              DICTS_DATA
+          ")values(?1,?2,?3)";
+
+    CSQLITE_Statement stmt(this, sql);
+    stmt.Bind(1, dict_id);
+    stmt.Bind(2, cache.data(), cache.size());
+    stmt.Bind(3, (const void*)dict_data.data(), dict_data.size());
+    stmt.Execute();
+}
+
+void
+CNCDBIndexFile::GetAllDictionaries(TDictionaries& dicts)
+{
+    const char* sql;
+    sql = "select " DICTS_ID    ","
+                    DICTS_CACHE ","
+                    DICTS_DATA
+           " from " DICTS_TABLENAME;
+
+    CSQLITE_Statement stmt(this, sql);
+    while (stmt.Step()) {
+        pair<string, string>& dict = dicts[Uint4(stmt.GetInt(0))];
+        dict.first = stmt.GetString(1);
+        dict.second.resize(stmt.GetBlobSize(2));
+        if (!dict.second.empty())
+            stmt.GetBlob(2, &dict.second[0], dict.second.size());
+    }
+}
+
 END_NCBI_SCOPE
@@ -74,6 +74,15 @@ public:
     string GetPurgeData(void);
     void UpdatePurgeData(const string& data);
 
+    /// Compression dictionaries by their id, with cache name and data
+    typedef map<Uint4, pair<string, string> > TDictionaries;
+
+    /// Save compression dictionary trained for the cache
+    void SaveDictionary(Uint4 dict_id, const string& cache,
+                        const string& dict_data);
+    /// Read all compression dictionaries
+    void GetAllDictionaries(TDictionaries& dicts);
+
 private:
     CNCDBIndexFile(const CNCDBIndexFile&);
     CNCDBIndexFile& operator= (const CNCDBIndexFile&);
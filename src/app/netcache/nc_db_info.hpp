@@ -141,6 +141,9 @@ public:
     size_t  releasable_mem;
     size_t  releasing_mem;
     vector<char*> chunks;
+    /// Numbers of chunks written compressed to the database whose
+    /// write-back memory is kept in chunks until blob's meta is written
+    vector<Uint8> packed_chunks;
 
 
     SNCBlobVerData(CNCBlobVerManager* mgr);
@@ -165,6 +168,7 @@ private:
     void x_FreeChunkMaps(void);
     bool x_WriteBlobInfo(void);
     bool x_WriteCurChunk(char* write_mem, Uint4 write_size);
+    void x_ReleasePackedChunks(bool use_rcu);
     bool x_ExecuteWriteAll(void);
     void x_DeleteVersion(void);
 };
@@ -331,6 +335,8 @@ struct SNCDBFileInfo : public CObject
     SFileIndexRec* index_head;
     CMiniMutex   info_lock;
     bool         is_releasing;
+    /// File is being compacted by one of CSpaceShrinker tasks
+    bool         is_shrinking;
     TFileHandle  fd;
     int          create_time;
     int          next_shrink_time;
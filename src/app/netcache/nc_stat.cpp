@@ -249,6 +249,10 @@ CNCStat::x_ClearStats(void)
     m_DiskWrBySize.resize(40, 0);
     m_PeerSyncs = 0;
     m_PeerSynOps = 0;
+    m_BlobsSyncs = 0;
+    m_DigestSyncs = 0;
+    m_SyncBytes.Initialize();
+    m_SyncLens.Initialize();
     m_CntCleanedFiles = 0;
     m_CntFailedFiles = 0;
     m_CmdLens.Initialize();
@@ -358,6 +362,10 @@ CNCStat::x_AddStats(CNCStat* src_stat)
     m_DiskWrBlobSize += src_stat->m_DiskWrBlobSize;
     m_PeerSyncs += src_stat->m_PeerSyncs;
     m_PeerSynOps += src_stat->m_PeerSynOps;
+    m_BlobsSyncs += src_stat->m_BlobsSyncs;
+    m_DigestSyncs += src_stat->m_DigestSyncs;
+    m_SyncBytes.AddValues(src_stat->m_SyncBytes);
+    m_SyncLens.AddValues(src_stat->m_SyncLens);
     m_CntCleanedFiles += src_stat->m_CntCleanedFiles;
     m_CntFailedFiles += src_stat->m_CntFailedFiles;
     m_CheckedRecs.AddValues(src_stat->m_CheckedRecs);
@@ -566,6 +574,21 @@ CNCStat::PeerSyncFinished(Uint8 srv_id, Uint2 slot, Uint8 cnt_ops, bool success)
     }
 }
 
+void
+CNCStat::ActiveSyncFinished(bool by_blobs, bool by_digest,
+                            Uint8 sync_bytes, Uint8 len_usec)
+{
+    CNCStat* stat = s_Stat();
+    stat->m_StatLock.Lock();
+    if (by_digest)
+        ++stat->m_DigestSyncs;
+    else if (by_blobs)
+        ++stat->m_BlobsSyncs;
+    stat->m_SyncBytes.AddValue(sync_bytes);
+    stat->m_SyncLens.AddValue(len_usec);
+    stat->m_StatLock.Unlock();
+}
+
 void
 CNCStat::DiskDataWrite(size_t data_size)
 {
@@ -809,6 +832,13 @@ CNCStat::PrintToLogs(CTempString stat_name)
         .PrintParam("disk_wr_size", m_DiskWrBlobSize);
     diag.PrintParam("peer_syncs", m_PeerSyncs)
         .PrintParam("peer_syn_ops", m_PeerSynOps)
+        .PrintParam("blobs_syncs", m_BlobsSyncs)
+        .PrintParam("digest_syncs", m_DigestSyncs)
+        .PrintParam("sync_bytes", m_SyncBytes.GetSum())
+        .PrintParam("avg_sync_bytes", m_SyncBytes.GetAverage())
+        .PrintParam("max_sync_bytes", m_SyncBytes.GetMaximum())
+        .PrintParam("avg_sync_len", m_SyncLens.GetAverage())
+        .PrintParam("max_sync_len", m_SyncLens.GetMaximum())
         .PrintParam("cleaned_files", m_CntCleanedFiles)
         .PrintParam("failed_cleans", m_CntFailedFiles)
         .PrintParam("checked_recs", m_CheckedRecs.GetSum())
@@ -1078,6 +1108,15 @@ CNCStat::PrintToSocket(CSrvSocketTask* sock)
     if (m_PeerSyncs != 0)
         proxy << ", " << double(m_PeerSynOps) / m_PeerSyncs << " ops/sync";
     proxy << endl;
+    proxy << "Active syncs - "
+                    << g_ToSmartStr(m_SyncLens.GetCount()) << " syncs ("
+                    << g_ToSmartStr(m_BlobsSyncs) << " by blobs, "
+                    << g_ToSmartStr(m_DigestSyncs) << " by digest), "
+                    << g_ToSizeStr(m_SyncBytes.GetSum()) << " lists ("
+                    << g_ToSizeStr(m_SyncBytes.GetAverage()) << " avg, "
+                    << g_ToSizeStr(m_SyncBytes.GetMaximum()) << " max), "
+                    << g_AsMSecStat(m_SyncLens.GetAverage()) << " (avg msec), "
+                    << g_AsMSecStat(m_SyncLens.GetMaximum()) << " (max msec)" << endl;
     proxy << "Disk writes - "
                     << g_ToSizeStr(m_DiskDataWrite) << ", "
                     << g_ToSizeStr(m_DiskDataWrite / time_secs) << "/s, "
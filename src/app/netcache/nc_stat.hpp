@@ -98,6 +98,8 @@ public:
     static void PeerDataWrite(size_t data_size);
     static void PeerDataRead(size_t data_size);
     static void PeerSyncFinished(Uint8 srv_id, Uint2 slot, Uint8 cnt_ops, bool success);
+    static void ActiveSyncFinished(bool by_blobs, bool by_digest,
+                                   Uint8 sync_bytes, Uint8 len_usec);
     static void DiskDataWrite(size_t data_size);
     static void DiskDataRead(size_t data_size);
     static void DiskBlobWrite(Uint8 blob_size);
@@ -155,6 +157,10 @@ private:
     vector<Uint8> m_DiskWrBySize;
     Uint8 m_PeerSyncs;
     Uint8 m_PeerSynOps;
+    Uint8 m_BlobsSyncs;
+    Uint8 m_DigestSyncs;
+    CSrvStatTerm<Uint8> m_SyncBytes;
+    TSrvTimeTerm m_SyncLens;
     Uint8 m_CntCleanedFiles;
     Uint8 m_CntFailedFiles;
     TSrvTimeTerm m_CmdLens;
@@ -43,6 +43,8 @@
 #include "nc_stat.hpp"
 #include "logging.hpp"
 #include "peer_control.hpp"
+#include "nc_compress.hpp"
+#include "sync_digest.hpp"
 
 
 #ifdef NCBI_OS_LINUX
@@ -91,6 +93,10 @@ static const char* kNCStorage_MinRecNoSaveParam = "min_rec_no_save_period";
 static const char* kNCStorage_FailedWriteSize   = "failed_write_blob_key_count";
 static const char* kNCStorage_MaxBlobSizeStore  = "max_blob_size_store";
 static const char* kNCStorage_WbMemRelease      = "task_priority_wb_memrelease";
+static const char* kNCStorage_ShrinkTasksParam  = "shrink_tasks";
+static const char* kNCStorage_ShrinkBWParam     = "shrink_max_bandwidth";
+static const char* kNCStorage_ShrinkIOPSParam   = "shrink_max_iops";
+static const char* kNCStorage_ShrinkBatchParam  = "shrink_batch_size";
 
 
 // storage file type signatures
@@ -170,10 +176,96 @@ typedef std::set<SNCCacheData*, SCacheKeyCompare>   TKeyMap;
 
 #endif  // __NC_CACHEDATA_INTR_SET
 
+struct SCacheKeyHash
+{
+    size_t operator() (const SNCCacheData& x) const
+    {
+        return hash<string>()(x.key);
+    }
+    size_t operator() (const string& key) const
+    {
+        return hash<string>()(key);
+    }
+};
+
+/// Hash of the key looked up, calculated beforehand (to select the stripe)
+struct SCacheKeyPrehashed
+{
+    size_t value;
+
+    SCacheKeyPrehashed(size_t v) : value(v) {}
+    size_t operator() (const string&) const
+    {
+        return value;
+    }
+};
+
+struct SCacheKeyEqual
+{
+    bool operator() (const SNCCacheData& x, const SNCCacheData& y) const
+    {
+        return x.key == y.key;
+    }
+    bool operator() (const string& key, const SNCCacheData& y) const
+    {
+        return key == y.key;
+    }
+};
+
+typedef intr::unordered_set<SNCCacheData,
+                            intr::base_hook<TKeyHashHook>,
+                            intr::hash<SCacheKeyHash>,
+                            intr::equal<SCacheKeyEqual>,
+                            intr::constant_time_size<true>,
+                            intr::power_2_buckets<true>,
+                            intr::compare_hash<true> >    TKeyHash;
+
+/// Number of independently locked parts of exact-key index in each bucket
+/// (power of 2)
+static const size_t kKeyHashStripes = 8;
+static const size_t kKeyHashMinBuckets = 16;
+
+/// Part of exact-key index: open hash table growing twice when it gets
+/// more keys than buckets
+struct SKeyHashStripe
+{
+    CMiniMutex   lock;
+    vector<TKeyHash::bucket_type> buckets;
+    TKeyHash     key_hash;
+
+    SKeyHashStripe(void)
+        : buckets(kKeyHashMinBuckets),
+          key_hash(TKeyHash::bucket_traits(buckets.data(), buckets.size()))
+    {}
+
+    void Insert(SNCCacheData& data)
+    {
+        key_hash.insert(data);
+        if (key_hash.size() > buckets.size()) {
+            vector<TKeyHash::bucket_type> new_buckets(buckets.size() * 2);
+            key_hash.rehash(TKeyHash::bucket_traits(new_buckets.data(),
+                                                    new_buckets.size()));
+            buckets.swap(new_buckets);
+        }
+    }
+};
+
+/// Blobs' cache data of one time bucket. GET/PUT find the blob by exact key
+/// in the hash index;  the ordered index is kept for key mask searches and
+/// listings and is touched on the hot path only when key is added or deleted.
+/// Lock order is stripe's lock, then bucket's lock.
 struct SBucketCache
 {
+    SKeyHashStripe stripes[kKeyHashStripes];
     CMiniMutex   lock;
     TKeyMap      key_map;
+
+    SKeyHashStripe& GetStripe(size_t key_hash)
+    {
+        // the stripe is picked by the high byte of the hash, so that it is
+        // independent from the lower bits selecting bucket within stripe
+        return stripes[(key_hash >> (sizeof(size_t) * 8 - 8)) & (kKeyHashStripes - 1)];
+    }
 };
 typedef map<Uint2, SBucketCache*> TBucketCacheMap;
 
@@ -288,7 +380,27 @@ static Uint8 s_MaxBlobSizeStore = 0;
 static CNewFileCreator* s_NewFileCreator = nullptr;
 static CDiskFlusher* s_DiskFlusher = nullptr;
 static CRecNoSaver* s_RecNoSaver = nullptr;
-static CSpaceShrinker* s_SpaceShrinker = nullptr;
+/// Compaction tasks, each of them moves records out of its own file
+static vector<CSpaceShrinker*> s_SpaceShrinkers;
+static int s_CntShrinkTasks = 1;
+/// Bytes and records compaction may move per second (0 means no limit)
+static Uint8 s_ShrinkMaxBandwidth = 0;
+static Uint4 s_ShrinkMaxIOPS = 0;
+/// Number of records moved before compaction task yields execution
+static Uint4 s_ShrinkBatchSize = 0;
+/// Guards compaction budget and statistics below
+static CMiniMutex s_ShrinkLock;
+static int s_ShrinkBudgetTime = 0;
+static Uint8 s_ShrinkBudgetBytes = 0;
+static Uint4 s_ShrinkBudgetRecs = 0;
+static Uint8 s_ShrinkThrottled = 0;
+static Uint8 s_ShrinkFilesCleaned = 0;
+static Uint8 s_ShrinkFilesFailed = 0;
+static Uint8 s_ShrinkRecsMoved = 0;
+static Uint8 s_ShrinkSizeMoved = 0;
+static Uint8 s_ShrinkSizeFreed = 0;
+static Uint8 s_ShrinkSizeFreedEmpty = 0;
+static Uint8 s_ShrinkMoveSecs = 0;
 static CExpiredCleaner* s_ExpiredCleaner = nullptr;
 Uint4 s_TaskPriorityWbMemRelease = 10;
 
@@ -540,6 +652,10 @@ s_ReadVariableParams(const CNcbiRegistry& reg)
     s_MinDBSize = NStr::StringToUInt8_DataSize(str);
     s_MinMoveLife = reg.GetInt(kNCStorage_RegSection, kNCStorage_MoveLifeParam, 1000);
     s_FailedMoveDelay = reg.GetInt(kNCStorage_RegSection, kNCStorage_FailedMoveParam, 10);
+    s_ShrinkMaxBandwidth = NStr::StringToUInt8_DataSize(reg.GetString(
+                           kNCStorage_RegSection, kNCStorage_ShrinkBWParam, "0"));
+    s_ShrinkMaxIOPS = Uint4(reg.GetInt(kNCStorage_RegSection, kNCStorage_ShrinkIOPSParam, 0));
+    s_ShrinkBatchSize = Uint4(max(reg.GetInt(kNCStorage_RegSection, kNCStorage_ShrinkBatchParam, 32), 1));
 
     s_MinRecNoSavePeriod = reg.GetInt(kNCStorage_RegSection, kNCStorage_MinRecNoSaveParam, 30);
     s_FlushTimePeriod = reg.GetInt(kNCStorage_RegSection, kNCStorage_FlushTimeParam, 0);
@@ -592,6 +708,8 @@ s_ReadVariableParams(const CNcbiRegistry& reg)
 
     int failed_write = reg.GetInt(kNCStorage_RegSection, kNCStorage_FailedWriteSize, 0);
     CNCBlobAccessor::SetFailedWriteCount((Uint4)failed_write);
+
+    CNCChunkCodec::ReadParams(reg);
     return true;
 }
 
@@ -614,6 +732,7 @@ s_ReadStorageParams(void)
         SRV_LOG(Critical, "Cannot create directory " << s_Path);
         return false;
     }
+    s_CntShrinkTasks = max(reg.GetInt(kNCStorage_RegSection, kNCStorage_ShrinkTasksParam, 2), 1);
     s_GuardName = reg.Get(kNCStorage_RegSection, kNCStorage_GuardNameParam);
     if (s_GuardName.empty()) {
         s_GuardName = CDirEntry::MakePath(s_Path,
@@ -803,6 +922,24 @@ delete_file:
     return false;
 }
 
+/// Load compression dictionaries referenced by chunks in the database
+static bool
+s_ReadChunkDictionaries(void)
+{
+    CNCDBIndexFile::TDictionaries dicts;
+    try {
+        s_IndexDB->GetAllDictionaries(dicts);
+    }
+    catch (CSQLITE_Exception& ex) {
+        SRV_LOG(Critical, "Cannot read compression dictionaries: " << ex);
+        return false;
+    }
+    ITERATE(CNCDBIndexFile::TDictionaries, it, dicts) {
+        CNCChunkCodec::AddDictionary(it->first, it->second.first, it->second.second);
+    }
+    return true;
+}
+
 /// Reinitialize database cleaning all data from it.
 /// Only database is cleaned, internal cache is left intact.
 static void
@@ -1258,6 +1395,7 @@ SNCDBFileInfo::SNCDBFileInfo(void)
       used_size(0),
       index_head(NULL),
       is_releasing(false),
+      is_shrinking(false),
       fd(0),
       create_time(0),
       next_shrink_time(0)
@@ -1307,6 +1445,9 @@ CNCBlobStorage::Initialize(bool do_reinit)
             return false;
         s_CleanStart = false;
     }
+    if (!s_ReadChunkDictionaries())
+        return false;
+    CNCChunkCodec::Initialize();
 
     for (Uint2 i = 1; i <= CNCDistributionConf::GetCntTimeBuckets(); ++i) {
         s_BucketsCache[i] = new SBucketCache();
@@ -1315,6 +1456,7 @@ CNCBlobStorage::Initialize(bool do_reinit)
         s_AllCache[i] = new  SAllCacheTable();
 #endif
     }
+    CNCSyncDigest::Initialize();
 
     s_BlobCounter.Set(0);
     if (!s_DBFiles->empty()) {
@@ -1331,7 +1473,9 @@ CNCBlobStorage::Initialize(bool do_reinit)
     s_NewFileCreator = new CNewFileCreator();
     s_DiskFlusher = new CDiskFlusher();
     s_RecNoSaver = new CRecNoSaver();
-    s_SpaceShrinker = new CSpaceShrinker();
+    for (int i = 0; i < s_CntShrinkTasks; ++i) {
+        s_SpaceShrinkers.push_back(new CSpaceShrinker(i));
+    }
     s_ExpiredCleaner = new CExpiredCleaner();
     CBlobCacher* cacher = new CBlobCacher();
     cacher->SetRunnable();
@@ -1368,6 +1512,12 @@ void CNCBlobStorage::WriteSetup(CSrvSocketTask& task)
     task.WriteText(eol).WriteText(kNCStorage_MinDBSizeParam   ).WriteText(is ).WriteNumber( s_MinDBSize);
     task.WriteText(eol).WriteText(kNCStorage_MoveLifeParam    ).WriteText(is ).WriteNumber( s_MinMoveLife);
     task.WriteText(eol).WriteText(kNCStorage_FailedMoveParam  ).WriteText(is ).WriteNumber( s_FailedMoveDelay);
+    task.WriteText(eol).WriteText(kNCStorage_ShrinkTasksParam ).WriteText(is ).WriteNumber( s_CntShrinkTasks);
+    task.WriteText(eol).WriteText(kNCStorage_ShrinkBWParam    ).WriteText(str).WriteText(iss)
+                                                   .WriteText(NStr::UInt8ToString_DataSize( s_ShrinkMaxBandwidth)).WriteText(eos);
+    task.WriteText(eol).WriteText(kNCStorage_ShrinkBWParam    ).WriteText(is ).WriteNumber( s_ShrinkMaxBandwidth);
+    task.WriteText(eol).WriteText(kNCStorage_ShrinkIOPSParam  ).WriteText(is ).WriteNumber( s_ShrinkMaxIOPS);
+    task.WriteText(eol).WriteText(kNCStorage_ShrinkBatchParam ).WriteText(is ).WriteNumber( s_ShrinkBatchSize);
     task.WriteText(eol).WriteText(kNCStorage_MinRecNoSaveParam).WriteText(is ).WriteNumber( s_MinRecNoSavePeriod);
     task.WriteText(eol).WriteText(kNCStorage_FlushTimeParam   ).WriteText(is ).WriteNumber( s_FlushTimePeriod);
     task.WriteText(eol).WriteText(kNCStorage_ExtraGCOnParam   ).WriteText(is ).WriteNumber( s_ExtraGCOnSize);
@@ -1395,6 +1545,7 @@ void CNCBlobStorage::WriteSetup(CSrvSocketTask& task)
     task.WriteText(eol).WriteText("write_back_failed_delay"   ).WriteText(is ).WriteNumber( GetWBFailedWriteDelay());
     task.WriteText(eol).WriteText(kNCStorage_WbMemRelease).WriteText(is).WriteNumber(s_TaskPriorityWbMemRelease);
     task.WriteText(eol).WriteText(kNCStorage_FailedWriteSize  ).WriteText(is ).WriteNumber( CNCBlobAccessor::GetFailedWriteCount());
+    CNCChunkCodec::WriteSetup(task);
 }
 
 void CNCBlobStorage::WriteEnvInfo(CSrvSocketTask& task)
@@ -1414,11 +1565,17 @@ void CNCBlobStorage::WriteBlobStat(CSrvSocketTask& task)
 {
     int expire = 0;
     Uint8 size = 0;
-    Uint8 cache_count = 0, timetable_count = 0;
+    Uint8 cache_count = 0, timetable_count = 0, hash_buckets = 0, key_mem = 0;
     map<Uint4, Uint8> blob_per_file;
 
     ITERATE( TBucketCacheMap, bkt, s_BucketsCache) {
         SBucketCache* cache = bkt->second;
+        for (size_t i = 0; i < kKeyHashStripes; ++i) {
+            SKeyHashStripe& stripe = cache->stripes[i];
+            stripe.lock.Lock();
+            hash_buckets += stripe.buckets.capacity();
+            stripe.lock.Unlock();
+        }
         cache->lock.Lock();
         ITERATE(TKeyMap, it, cache->key_map) {
             ++cache_count;
@@ -1426,6 +1583,9 @@ void CNCBlobStorage::WriteBlobStat(CSrvSocketTask& task)
             size += it->size;
             expire = max( expire, it->dead_time); 
             ++blob_per_file[it->coord.file_id];
+            if (it->key.capacity() >= sizeof(string)) {
+                key_mem += it->key.capacity() + 1;
+            }
 #else
             size += (*it)->size;
             expire = max( expire, (*it)->dead_time); 
@@ -1449,6 +1609,16 @@ void CNCBlobStorage::WriteBlobStat(CSrvSocketTask& task)
     task.WriteText(eol).WriteText("TimeTable_count").WriteText( is).WriteNumber( timetable_count);
     task.WriteText(eol).WriteText("Purge_count").WriteText( is).WriteNumber( CNCBlobAccessor::GetPurgeCount());
 
+    // Memory taken by blobs' cache data and key indexes (excluding blob
+    // version managers and memory allocator's overhead)
+    Uint8 hash_mem = hash_buckets * sizeof(TKeyHash::bucket_type);
+    Uint8 cache_mem = cache_count * sizeof(SNCCacheData) + key_mem + hash_mem;
+    task.WriteText(eol).WriteText("KeyHash_buckets").WriteText( is).WriteNumber( hash_buckets);
+    task.WriteText(eol).WriteText("KeyHash_mem").WriteText(iss).WriteText(NStr::UInt8ToString_DataSize(hash_mem)).WriteText(eos);
+    task.WriteText(eol).WriteText("CacheData_mem").WriteText(iss).WriteText(NStr::UInt8ToString_DataSize(cache_mem)).WriteText(eos);
+    task.WriteText(eol).WriteText("CacheData_per_blob").WriteText( is).WriteNumber( cache_count ? cache_mem / cache_count : 0);
+    CNCChunkCodec::WriteStat(task);
+
 #if __NC_CACHEDATA_ALL_MONITOR
     size_t ncaches_count = 0;
     ITERATE(TAllCacheBuckets, tt, s_AllCache) {
@@ -1744,6 +1914,41 @@ if (is_audit) {
     }
     s_DBFilesLock.Unlock();
     task.WriteText("]");
+
+    s_ShrinkLock.Lock();
+    Uint8 throttled = s_ShrinkThrottled;
+    Uint8 files_cleaned = s_ShrinkFilesCleaned;
+    Uint8 files_failed = s_ShrinkFilesFailed;
+    Uint8 recs_moved = s_ShrinkRecsMoved;
+    Uint8 size_moved = s_ShrinkSizeMoved;
+    Uint8 size_freed = s_ShrinkSizeFreed;
+    Uint8 size_freed_empty = s_ShrinkSizeFreedEmpty;
+    Uint8 move_secs = s_ShrinkMoveSecs;
+    s_ShrinkLock.Unlock();
+
+    task.WriteText(eol).WriteText("shrink\": {");
+    task.WriteText("\n\"").WriteText("tasks").WriteText( is).WriteNumber( s_SpaceShrinkers.size());
+    task.WriteText(eol).WriteText("max_bandwidth").WriteText( is).WriteNumber( s_ShrinkMaxBandwidth);
+    task.WriteText(eol).WriteText("max_iops").WriteText( is).WriteNumber( s_ShrinkMaxIOPS);
+    task.WriteText(eol).WriteText("throttled").WriteText( is).WriteNumber( throttled);
+    task.WriteText(eol).WriteText("files_cleaned").WriteText( is).WriteNumber( files_cleaned);
+    task.WriteText(eol).WriteText("files_failed").WriteText( is).WriteNumber( files_failed);
+    task.WriteText(eol).WriteText("recs_moved").WriteText( is).WriteNumber( recs_moved);
+    task.WriteText(eol).WriteText("size_moved").WriteText( is).WriteNumber( size_moved);
+    task.WriteText(eol).WriteText("size_freed").WriteText( is).WriteNumber( size_freed);
+    // Files that became empty without compaction
+    task.WriteText(eol).WriteText("size_freed_empty").WriteText( is).WriteNumber( size_freed_empty);
+    // How many bytes of disk space were released per byte moved
+    task.WriteText(eol).WriteText("freed_per_moved_pct").WriteText( is)
+                       .WriteNumber( size_moved == 0 ? 0 : size_freed * 100 / size_moved);
+    task.WriteText(eol).WriteText("move_rate").WriteText( is)
+                       .WriteNumber( size_moved / max(move_secs, Uint8(1)));
+    task.WriteText(eol).WriteText("moves\": [");
+    for (size_t i = 0; i < s_SpaceShrinkers.size(); ++i) {
+        task.WriteText(i == 0 ? "\n" : ",\n");
+        s_SpaceShrinkers[i]->WriteProgress(task);
+    }
+    task.WriteText("]}");
 }
 
 string
@@ -1775,56 +1980,32 @@ static SNCCacheData*
 s_GetKeyCacheData(Uint2 time_bucket, const string& key, bool need_create)
 {
     SBucketCache* cache = s_GetBucketCache(time_bucket);
+    size_t key_hash = SCacheKeyHash()(key);
+    SKeyHashStripe& stripe = cache->GetStripe(key_hash);
     SNCCacheData* data = NULL;
-    cache->lock.Lock();
-#if __NC_CACHEDATA_INTR_SET
-    if (need_create) {
-        TKeyMap::insert_commit_data commit_data;
-        pair<TKeyMap::iterator, bool> ins_res
-            = cache->key_map.insert_unique_check(key, SCacheKeyCompare(), commit_data);
-        if (ins_res.second) {
-            data = new SNCCacheData();
-            data->key = key;
-            data->time_bucket = time_bucket;
-            cache->key_map.insert_unique_commit(*data, commit_data);
-            AtomicAdd(s_CurKeysCnt, 1);
-
-#if __NC_CACHEDATA_ALL_MONITOR
-            SAllCacheTable* table = s_AllCache[time_bucket];
-            table->lock.Lock();
-            table->all_cache_set.insert(data);
-            table->lock.Unlock();
-#endif
-        }
-        else {
-            data = &*ins_res.first;
-        }
-    }
-    else {
-        TKeyMap::iterator it = cache->key_map.find(key, SCacheKeyCompare());
-        if (it == cache->key_map.end()) {
-            data = NULL;
-        }
-        else {
-            data = &*it;
-        }
-    }
-#else  // __NC_CACHEDATA_INTR_SET
-    SNCCacheData search_mask;
-    search_mask.key = key;
-    TKeyMap::iterator it = cache->key_map.find( &search_mask);
-    if (it != cache->key_map.end()) {
-        data = *it;
+    stripe.lock.Lock();
+    TKeyHash::iterator it = stripe.key_hash.find(key, SCacheKeyPrehashed(key_hash),
+                                                 SCacheKeyEqual());
+    if (it != stripe.key_hash.end()) {
+        data = &*it;
 #ifdef _DEBUG
         if (data->time_bucket != time_bucket) {
             abort();
         }
 #endif
-    } else if (need_create) {
+    }
+    else if (need_create) {
         data = new SNCCacheData();
         data->key = key;
         data->time_bucket = time_bucket;
+        stripe.Insert(*data);
+        cache->lock.Lock();
+#if __NC_CACHEDATA_INTR_SET
+        cache->key_map.insert_unique(*data);
+#else
         cache->key_map.insert(data);
+#endif
+        cache->lock.Unlock();
         AtomicAdd(s_CurKeysCnt, 1);
 
 #if __NC_CACHEDATA_ALL_MONITOR
@@ -1834,11 +2015,10 @@ s_GetKeyCacheData(Uint2 time_bucket, const string& key, bool need_create)
         table->lock.Unlock();
 #endif
     }
-#endif //__NC_CACHEDATA_INTR_SET
     if (data) {
         CNCBlobStorage::ReferenceCacheData(data);
     }
-    cache->lock.Unlock();
+    stripe.lock.Unlock();
     return data;
 }
 
@@ -1867,7 +2047,8 @@ CNCAlerts::Register(CNCAlerts::eDebugReleaseCacheData1, "ref_cnt is 0");
         return;
     }
     SBucketCache* cache = it->second;
-    cache->lock.Lock();
+    SKeyHashStripe& stripe = cache->GetStripe(SCacheKeyHash()(data->key));
+    stripe.lock.Lock();
 
 #ifdef _DEBUG
     if (!data->coord.empty() && data->dead_time == 0) {
@@ -1876,22 +2057,21 @@ CNCAlerts::Register(CNCAlerts::eDebugReleaseCacheData1, "ref_cnt is 0");
 #endif
 
     if (data->ref_cnt.Get() != 0  ||  !data->coord.empty()
-#if 1
-#if __NC_CACHEDATA_INTR_SET
-        ||  !((TKeyMapHook*)data)->is_linked()
-#endif
-#endif
-       )
+        ||  !((TKeyHashHook*)data)->is_linked())
     {
-        cache->lock.Unlock();
+        stripe.lock.Unlock();
         return;
     }
+    size_t n = stripe.key_hash.erase(*data);
+    CNCSyncDigest::BlobRemoved(data);
+    cache->lock.Lock();
 #if __NC_CACHEDATA_INTR_SET
-    size_t n = cache->key_map.erase(*data);
+    cache->key_map.erase(cache->key_map.iterator_to(*data));
 #else
-    size_t n = cache->key_map.erase(data);
+    cache->key_map.erase(data);
 #endif
     cache->lock.Unlock();
+    stripe.lock.Unlock();
 
 #if __NC_CACHEDATA_ALL_MONITOR
     SAllCacheTable* table = s_AllCache[time_bucket];
@@ -1998,6 +2178,7 @@ s_GetNextWriteCoord(EDBFileIndex file_index,
     ind_rec->offset = w_info.next_offset;
     ind_rec->rec_size = rec_size;
     ind_rec->rec_type = eFileRecNone;
+    ind_rec->rec_codec = eNCCodecNone;
     ind_rec->cache_data = NULL;
     ind_rec->chain_coord.clear();
 
@@ -2458,7 +2639,8 @@ CNCBlobStorage::ReadChunkData(SNCBlobVerData* ver_data,
                               SNCChunkMaps* maps,
                               Uint8 chunk_num,
                               char*& buffer,
-                              Uint4& buf_size)
+                              Uint4& buf_size,
+                              Uint1& codec)
 {
     Uint2 map_idx[kNCMaxBlobMapsDepth] = {0};
     Uint1 cur_index = 0;
@@ -2575,6 +2757,7 @@ CNCAlerts::Register(CNCAlerts::eDebugReadChunkData4, "ReadChunkData: data_inf");
 
     buf_size = s_CalcChunkDataSize(data_ind->rec_size);
     buffer = (char*)data_rec->chunk_data;
+    codec = data_ind->rec_codec;
 
     return true;
 }
@@ -2585,7 +2768,8 @@ CNCBlobStorage::WriteChunkData(SNCBlobVerData* ver_data,
                                SNCCacheData* cache_data,
                                Uint8 chunk_num,
                                char* buffer,
-                               Uint4 buf_size)
+                               Uint4 buf_size,
+                               bool& packed)
 {
     Uint2 map_idx[kNCMaxBlobMapsDepth] = {0};
     Uint1 cur_index = 0;
@@ -2613,6 +2797,16 @@ CNCAlerts::Register(CNCAlerts::eDebugWriteChunkData1,"chunk number");
             maps->maps[i]->map_idx = map_idx[i + 1];
     }
 
+    CTempString packed_data;
+    ENCChunkCodec codec = CNCChunkCodec::Pack(CNCBlobKeyLight(cache_data->key).Cache(),
+                                              chunk_num == 0, buffer, buf_size,
+                                              packed_data);
+    if (codec != eNCCodecNone) {
+        buffer = const_cast<char*>(packed_data.data());
+        buf_size = Uint4(packed_data.size());
+    }
+    packed = codec != eNCCodecNone;
+
     SNCDataCoord data_coord;
     CSrvRef<SNCDBFileInfo> data_file;
     SFileIndexRec* data_ind;
@@ -2625,6 +2819,7 @@ CNCAlerts::Register(CNCAlerts::eDebugWriteChunkData2,"s_GetNextWriteCoord");
     }
 
     data_ind->rec_type = eFileRecChunkData;
+    data_ind->rec_codec = codec;
     data_ind->cache_data = cache_data;
     SFileChunkDataRec* data_rec = s_CalcChunkAddress(data_file, data_ind);
     data_rec->chunk_num = chunk_num;
@@ -2687,6 +2882,23 @@ CNCBlobStorage::SaveMaxSyncLogRecNo(void)
     s_NeedSaveLogRecNo = true;
 }
 
+bool
+CNCBlobStorage::SaveChunkDictionary(Uint4 dict_id, const string& cache,
+                                    const string& dict_data)
+{
+    bool result = true;
+    s_IndexLock.Lock();
+    try {
+        s_IndexDB->SaveDictionary(dict_id, cache, dict_data);
+    }
+    catch (CSQLITE_Exception& ex) {
+        SRV_LOG(Critical, "Cannot save compression dictionary: " << ex);
+        result = false;
+    }
+    s_IndexLock.Unlock();
+    return result;
+}
+
 string
 CNCBlobStorage::GetPurgeData(void)
 {
@@ -2834,7 +3046,9 @@ CNCBlobStorage::GetLatestBlobExpire(void)
 }
 
 void
-CNCBlobStorage::GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst, const CNCPeerControl* peer)
+CNCBlobStorage::GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst,
+                                 const CNCPeerControl* peer,
+                                 const TNCSyncLeavesMask* leaves)
 {
     blobs_lst.clear();
     Uint2 slot_buckets = CNCDistributionConf::GetCntSlotBuckets();
@@ -2862,7 +3076,7 @@ CNCBlobStorage::GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst, const CN
         cache->lock.Unlock();
 
         info_ptr = (SNCTempBlobInfo*)big_block;
-        for (Uint8 i = 0; i < cnt_blobs; ++i) {
+        for (Uint8 i = 0; i < cnt_blobs; ++i, ++info_ptr) {
             Uint2 key_slot = 0, key_bucket = 0;
             if (!CNCDistributionConf::GetSlotByKey(info_ptr->key, key_slot, key_bucket) ||
                 key_slot != slot /*|| key_bucket != bucket_num*/) {
@@ -2875,27 +3089,31 @@ CNCBlobStorage::GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst, const CN
                           ", expected bucket: " << bucket_num << ", calculated bucket: " << key_bucket);
             }
 
+            bool need_blob = true;
             if (info_ptr->size > CNCDistributionConf::GetMaxBlobSizeSync()) {
                 if (CNCDistributionConf::IsThisServerKey(info_ptr->key)) {
-                    continue;
+                    need_blob = false;
                 }
             }
-
             if (peer && !peer->AcceptsBlobKey(info_ptr->key)) {
-                continue;
+                need_blob = false;
+            }
+            if (leaves && !(*leaves)[CNCSyncDigest::GetKeyLeaf(info_ptr->key)]) {
+                need_blob = false;
+            }
+            if (need_blob) {
+                SNCBlobSummary* blob_sum = new SNCBlobSummary();
+                blob_sum->size           = info_ptr->size;
+                blob_sum->create_id      = info_ptr->create_id;
+                blob_sum->create_server  = info_ptr->create_server;
+                blob_sum->create_time    = info_ptr->create_time;
+                blob_sum->dead_time      = info_ptr->dead_time;
+                blob_sum->expire         = info_ptr->expire;
+                blob_sum->ver_expire     = info_ptr->ver_expire;
+                blobs_lst[info_ptr->key] = blob_sum;
             }
-            SNCBlobSummary* blob_sum = new SNCBlobSummary();
-            blob_sum->size           = info_ptr->size;
-            blob_sum->create_id      = info_ptr->create_id;
-            blob_sum->create_server  = info_ptr->create_server;
-            blob_sum->create_time    = info_ptr->create_time;
-            blob_sum->dead_time      = info_ptr->dead_time;
-            blob_sum->expire         = info_ptr->expire;
-            blob_sum->ver_expire     = info_ptr->ver_expire;
-            blobs_lst[info_ptr->key] = blob_sum;
 
             info_ptr->~SNCTempBlobInfo();
-            ++info_ptr;
         }
 
         free(big_block);
@@ -3008,6 +3226,12 @@ CBlobCacher::x_CacheMapRecs(SNCDataCoord map_coord,
             return false;
         }
         Uint4 data_size = s_CalcChunkDataSize(map_ind->rec_size);
+        if (map_ind->rec_codec != eNCCodecNone) {
+            SFileChunkDataRec* data_rec = s_CalcChunkAddress(file_info, map_ind);
+            data_size = CNCChunkCodec::GetUnpackedSize(map_ind->rec_codec,
+                                                       (char*)data_rec->chunk_data,
+                                                       data_size);
+        }
         Uint4 need_size;
         if (chunk_num < cnt_chunks)
             need_size = cache_data->chunk_size;
@@ -3204,6 +3428,12 @@ CBlobCacher::x_CacheMetaRec(SNCDBFileInfo* file_info,
         bucket_cache = it_bucket->second;
     }
     STimeTable* time_table = s_TimeTables[time_bucket];
+    SKeyHashStripe& stripe = bucket_cache->GetStripe(SCacheKeyHash()(key));
+    TKeyHash::iterator hash_it = stripe.key_hash.find(*cache_data);
+    if (hash_it != stripe.key_hash.end()) {
+        stripe.key_hash.erase(hash_it);
+    }
+    stripe.Insert(*cache_data);
 #if __NC_CACHEDATA_INTR_SET
     TKeyMap::insert_commit_data commit_data;
     pair<TKeyMap::iterator, bool> ins_res =
@@ -3256,6 +3486,7 @@ CBlobCacher::x_CacheMetaRec(SNCDBFileInfo* file_info,
             s_MoveRecToGarbage(old_file, old_ind);
             old_data->coord.clear();
         }
+        CNCSyncDigest::BlobRemoved(old_data);
         delete old_data;
     }
 #if __NC_CACHEDATA_INTR_SET
@@ -3266,6 +3497,7 @@ CBlobCacher::x_CacheMetaRec(SNCDBFileInfo* file_info,
 #if __NC_CACHEDATA_ALL_MONITOR
     s_AllCache[time_bucket]->all_cache_set.insert(cache_data);
 #endif
+    CNCSyncDigest::BlobChanged(cache_data);
     ++s_CurBlobsCnt;
 
     return true;
@@ -3528,7 +3760,9 @@ CBlobCacher::x_FinishCaching(void)
 
     s_DiskFlusher->SetRunnable();
     s_RecNoSaver->SetRunnable();
-    s_SpaceShrinker->SetRunnable();
+    ITERATE(vector<CSpaceShrinker*>, it, s_SpaceShrinkers) {
+        (*it)->SetRunnable();
+    }
     s_ExpiredCleaner->SetRunnable();
 
     CNCServer::CachingCompleted();
@@ -3731,6 +3965,7 @@ CExpiredCleaner::x_DeleteNextData(void)
     Uint2 map_size = cache_data->map_size;
     cache_data->coord.clear();
     cache_data->dead_time = 0;
+    CNCSyncDigest::BlobChanged(cache_data);
     CNCBlobVerManager* mgr = cache_data->Get_ver_mgr();
     if (mgr) {
         mgr->ObtainReference();
@@ -3941,6 +4176,40 @@ CExpiredCleaner::~CExpiredCleaner(void)
 {}
 
 
+/// Check if compaction already spent its budget for the current second
+static bool
+s_IsShrinkBudgetSpent(void)
+{
+    int cur_time = CSrvTime::CurSecs();
+    s_ShrinkLock.Lock();
+    if (s_ShrinkBudgetTime != cur_time) {
+        s_ShrinkBudgetTime = cur_time;
+        s_ShrinkBudgetBytes = 0;
+        s_ShrinkBudgetRecs = 0;
+    }
+    bool spent = (s_ShrinkMaxBandwidth != 0  &&  s_ShrinkBudgetBytes >= s_ShrinkMaxBandwidth)
+                 ||  (s_ShrinkMaxIOPS != 0  &&  s_ShrinkBudgetRecs >= s_ShrinkMaxIOPS);
+    if (spent)
+        ++s_ShrinkThrottled;
+    s_ShrinkLock.Unlock();
+    return spent;
+}
+
+static void
+s_SpendShrinkBudget(Uint4 size)
+{
+    int cur_time = CSrvTime::CurSecs();
+    s_ShrinkLock.Lock();
+    if (s_ShrinkBudgetTime != cur_time) {
+        s_ShrinkBudgetTime = cur_time;
+        s_ShrinkBudgetBytes = 0;
+        s_ShrinkBudgetRecs = 0;
+    }
+    s_ShrinkBudgetBytes += size;
+    ++s_ShrinkBudgetRecs;
+    s_ShrinkLock.Unlock();
+}
+
 CSpaceShrinker::State
 CSpaceShrinker::x_MoveRecord(void)
 {
@@ -3954,11 +4223,29 @@ CSpaceShrinker::x_MoveRecord(void)
     old_coord.file_id = m_MaxFile->file_id;
     old_coord.rec_num = m_RecNum;
 
+    // Chunks written before compression was turned on are compressed
+    // when moved
+    SFileChunkDataRec* old_data = NULL;
+    CTempString packed_data;
+    ENCChunkCodec codec = eNCCodecNone;
+    Uint4 new_size = m_IndRec->rec_size;
+    if (m_IndRec->rec_type == eFileRecChunkData) {
+        old_data = s_CalcChunkAddress(m_MaxFile, m_IndRec);
+        if (m_IndRec->rec_codec == eNCCodecNone) {
+            codec = CNCChunkCodec::Pack(CNCBlobKeyLight(m_CacheData->key).Cache(),
+                                        false, (char*)old_data->chunk_data,
+                                        s_CalcChunkDataSize(m_IndRec->rec_size),
+                                        packed_data);
+            if (codec != eNCCodecNone)
+                new_size = s_CalcChunkRecSize(packed_data.size());
+        }
+    }
+
     SNCDataCoord new_coord;
     CSrvRef<SNCDBFileInfo> new_file;
     SFileIndexRec* new_ind;
     if (!s_GetNextWriteCoord(m_MaxFile->type_index,
-                             m_IndRec->rec_size, new_coord, new_file, new_ind))
+                             new_size, new_coord, new_file, new_ind))
     {
 #ifdef _DEBUG
 CNCAlerts::Register(CNCAlerts::eDebugMoveRecord0,"s_GetNextWriteCoord");
@@ -3967,12 +4254,22 @@ CNCAlerts::Register(CNCAlerts::eDebugMoveRecord0,"s_GetNextWriteCoord");
         return &CSpaceShrinker::x_FinishMoveRecord;
     }
 
-    memcpy(new_file->file_map + new_ind->offset,
-           m_MaxFile->file_map + m_IndRec->offset,
-           m_IndRec->rec_size);
-
     new_ind->cache_data = m_CacheData;
     new_ind->rec_type = m_IndRec->rec_type;
+    if (codec != eNCCodecNone) {
+        SFileChunkDataRec* new_data = s_CalcChunkAddress(new_file, new_ind);
+        new_data->chunk_num = old_data->chunk_num;
+        new_data->chunk_idx = old_data->chunk_idx;
+        memcpy(new_data->chunk_data, packed_data.data(), packed_data.size());
+        new_ind->rec_codec = codec;
+    }
+    else {
+        memcpy(new_file->file_map + new_ind->offset,
+               m_MaxFile->file_map + m_IndRec->offset,
+               m_IndRec->rec_size);
+        new_ind->rec_codec = m_IndRec->rec_codec;
+    }
+
     SNCDataCoord chain_coord = m_IndRec->chain_coord;
     new_ind->chain_coord = chain_coord;
 
@@ -4113,7 +4410,17 @@ CNCAlerts::Register(CNCAlerts::eDebugMoveRecord3,"eFileRecChunkData");
 #endif
         if (m_CurVer) {
             SFileChunkDataRec* new_data = s_CalcChunkAddress(new_file, new_ind);
-            m_CurVer->chunks[new_data->chunk_num] = (char*)new_data->chunk_data;
+            if (new_ind->rec_codec == eNCCodecNone) {
+                m_CurVer->chunks[new_data->chunk_num] = (char*)new_data->chunk_data;
+            }
+            else {
+                // Compressed chunk can be found only via maps, so readers
+                // should re-read them.
+                char*& chunk_ptr = m_CurVer->chunks[new_data->chunk_num];
+                if (chunk_ptr == (char*)old_data->chunk_data)
+                    ACCESS_ONCE(chunk_ptr) = NULL;
+                ++m_CurVer->map_move_counter;
+            }
         }
     update_up_map:
         if (up_map) {
@@ -4143,7 +4450,9 @@ CNCAlerts::Register(CNCAlerts::eDebugMoveRecord3,"eFileRecChunkData");
     new_file->cnt_unfinished.Add(-1);
 
     ++m_CntMoved;
-    m_SizeMoved += m_IndRec->rec_size + sizeof(SFileIndexRec);
+    // Count what was written, chunks can be compressed when moved
+    m_SizeMoved += new_size + sizeof(SFileIndexRec);
+    s_SpendShrinkBudget(new_size + sizeof(SFileIndexRec));
 
     return &CSpaceShrinker::x_FinishMoveRecord;
 
@@ -4190,8 +4499,18 @@ CSpaceShrinker::x_PrepareToShrink(void)
         if (is_current  ||  this_file->cnt_unfinished.Get() != 0)
             continue;
 
-        if (this_file->used_size == 0) {
-            m_FilesToDel.push_back(SrvRef(this_file));
+        if (this_file->is_shrinking) {
+            // Other shrinker is releasing this file already
+            this_file->info_lock.Lock();
+            total_rel_used += this_file->used_size;
+            total_rel_garb += this_file->garb_size;
+            this_file->info_lock.Unlock();
+        }
+        else if (this_file->used_size == 0) {
+            // Empty files are deleted by the first shrinker only so that
+            // they are not deleted twice.
+            if (m_Index == 0)
+                m_FilesToDel.push_back(SrvRef(this_file));
         }
         else if (need_move) {
             if (cur_time >= this_file->next_shrink_time) {
@@ -4219,7 +4538,6 @@ CSpaceShrinker::x_PrepareToShrink(void)
             }
         }
     }
-    s_DBFilesLock.Unlock();
 
     if (max_pct < 0.9) {
         Uint8 proj_garbage = s_GarbageSize - total_rel_garb;
@@ -4231,6 +4549,9 @@ CSpaceShrinker::x_PrepareToShrink(void)
             m_MaxFile = NULL;
         }
     }
+    if (m_MaxFile)
+        m_MaxFile->is_shrinking = true;
+    s_DBFilesLock.Unlock();
 
     m_CurDelFile = m_FilesToDel.begin();
     SetState(&CSpaceShrinker::x_DeleteNextFile);
@@ -4253,6 +4574,14 @@ CSpaceShrinker::x_DeleteNextFile(void)
 CNCAlerts::Register(CNCAlerts::eDebugDeleteFile,"x_DeleteNextFile");
 #endif
     s_DeleteDBFile(*m_CurDelFile, true);
+    s_ShrinkLock.Lock();
+    // Files released by moving records out of them become empty when
+    // the moved records are finally deleted
+    if ((*m_CurDelFile)->is_releasing)
+        s_ShrinkSizeFreed += (*m_CurDelFile)->file_size;
+    else
+        s_ShrinkSizeFreedEmpty += (*m_CurDelFile)->file_size;
+    s_ShrinkLock.Unlock();
     m_CurDelFile->Reset();
     ++m_CurDelFile;
     SetRunnable();
@@ -4281,6 +4610,8 @@ CSpaceShrinker::x_StartMoves(void)
     m_CntProcessed = 0;
     m_CntMoved = 0;
     m_SizeMoved = 0;
+    m_BatchLeft = s_ShrinkBatchSize;
+    m_MoveFileId = m_MaxFile->file_id;
 
     return &CSpaceShrinker::x_MoveNextRecord;
 }
@@ -4290,6 +4621,11 @@ CSpaceShrinker::x_MoveNextRecord(void)
 {
     if (CTaskServer::IsInShutdown())
         return &CSpaceShrinker::x_FinishMoves;
+    if (s_IsShrinkBudgetSpent()) {
+        m_BatchLeft = s_ShrinkBatchSize;
+        RunAfter(1);
+        return NULL;
+    }
 
     int cur_time = CSrvTime::CurSecs();
     m_MaxFile->info_lock.Lock();
@@ -4503,10 +4839,18 @@ CSpaceShrinker::x_FinishMoveRecord(void)
     ++m_CntProcessed;
     m_PrevRecNum = m_RecNum;
 
-    if (m_Failed || CTaskServer::IsInShutdown())
+    if (m_Failed || CTaskServer::IsInShutdown()) {
         SetState(&CSpaceShrinker::x_FinishMoves);
-    else
+    }
+    else if (m_BatchLeft > 1) {
+        // Keep moving records in a row, so that they are written sequentially
+        --m_BatchLeft;
+        return &CSpaceShrinker::x_MoveNextRecord;
+    }
+    else {
+        m_BatchLeft = s_ShrinkBatchSize;
         SetState(&CSpaceShrinker::x_MoveNextRecord);
+    }
     SetRunnable();
     return NULL;
 }
@@ -4514,10 +4858,13 @@ CSpaceShrinker::x_FinishMoveRecord(void)
 CSpaceShrinker::State
 CSpaceShrinker::x_FinishMoves(void)
 {
+    Uint4 size_freed = 0;
     if (!m_Failed) {
         m_MaxFile->is_releasing = true;
-        if (m_MaxFile->used_size == 0)
+        if (m_MaxFile->used_size == 0) {
             s_DeleteDBFile(m_MaxFile, true);
+            size_freed = m_MaxFile->file_size;
+        }
         else if (m_CntProcessed == 0) {
             SRV_LOG(Warning, "Didn't find anything to process in the file");
             m_MaxFile->next_shrink_time = CSrvTime::CurSecs() + max(s_MinMoveLife, 300);
@@ -4529,7 +4876,22 @@ CSpaceShrinker::x_FinishMoves(void)
         GetDiagCtx()->SetRequestStatus(eStatus_CmdAborted);
         m_MaxFile->next_shrink_time = CSrvTime::CurSecs() + s_FailedMoveDelay;
     }
+    s_DBFilesLock.Lock();
+    m_MaxFile->is_shrinking = false;
+    s_DBFilesLock.Unlock();
     m_MaxFile.Reset();
+    m_MoveFileId = 0;
+
+    s_ShrinkLock.Lock();
+    if (!m_Failed)
+        ++s_ShrinkFilesCleaned;
+    else
+        ++s_ShrinkFilesFailed;
+    s_ShrinkRecsMoved += m_CntMoved;
+    s_ShrinkSizeMoved += m_SizeMoved;
+    s_ShrinkSizeFreed += size_freed;
+    s_ShrinkMoveSecs += CSrvTime::CurSecs() - m_StartTime;
+    s_ShrinkLock.Unlock();
 
     CSrvDiagMsg().PrintExtra()
                  .PrintParam("cnt_processed", m_CntProcessed)
@@ -4555,7 +4917,10 @@ CSpaceShrinker::x_FinishSession(void)
     return NULL;
 }
 
-CSpaceShrinker::CSpaceShrinker(void)
+CSpaceShrinker::CSpaceShrinker(int index)
+    : m_Index(index),
+      m_MoveFileId(0),
+      m_BatchLeft(1)
 {
 #if __NC_TASKS_MONITOR
     m_TaskName = "CSpaceShrinker";
@@ -4566,6 +4931,23 @@ CSpaceShrinker::CSpaceShrinker(void)
 CSpaceShrinker::~CSpaceShrinker(void)
 {}
 
+void
+CSpaceShrinker::WriteProgress(TNCBufferType& task) const
+{
+    string is("\": "), eol(",\n\"");
+    Uint4 file_id = m_MoveFileId;
+    task.WriteText("{\n\"").WriteText("task").WriteText(is).WriteNumber(m_Index);
+    task.WriteText(eol).WriteText("file_id").WriteText(is).WriteNumber(file_id);
+    if (file_id != 0) {
+        task.WriteText(eol).WriteText("elapsed").WriteText(is)
+                           .WriteNumber(CSrvTime::CurSecs() - m_StartTime);
+        task.WriteText(eol).WriteText("cnt_processed").WriteText(is).WriteNumber(m_CntProcessed);
+        task.WriteText(eol).WriteText("cnt_moved").WriteText(is).WriteNumber(m_CntMoved);
+        task.WriteText(eol).WriteText("size_moved").WriteText(is).WriteNumber(m_SizeMoved);
+    }
+    task.WriteText("}");
+}
+
 
 CMovedRecDeleter::CMovedRecDeleter(SNCDBFileInfo* file_info, SFileIndexRec* ind_rec)
     : m_FileInfo(file_info),
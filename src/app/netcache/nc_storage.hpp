@@ -31,6 +31,7 @@
 
 #include "nc_utils.hpp"
 #include "nc_db_info.hpp"
+#include "sync_digest.hpp"
 
 
 namespace intr = boost::intrusive;
@@ -46,16 +47,20 @@ class CNCPeerControl;
 
 struct STimeTable_tag;
 struct SKeyMap_tag;
+struct SKeyHash_tag;
 
 typedef intr::set_base_hook< intr::tag<STimeTable_tag>,
                              intr::optimize_size<true> >    TTimeTableHook;
 typedef intr::set_base_hook< intr::tag<SKeyMap_tag>,
                              intr::optimize_size<true> >    TKeyMapHook;
+typedef intr::unordered_set_base_hook< intr::tag<SKeyHash_tag>,
+                                       intr::store_hash<true> >  TKeyHashHook;
 
 #define __NC_CACHEDATA_MONITOR     0
 
 class SNCCacheData : public TTimeTableHook,
                       public TKeyMapHook,
+                      public TKeyHashHook,
                       public SNCBlobSummary,
                       public CSrvRCUUser
 {
@@ -63,6 +68,8 @@ public:
     SNCDataCoord coord;
     string key;
     int saved_dead_time;
+    /// Hash of the blob summary included into slot digest, see CNCSyncDigest
+    Uint8 sync_hash;
     Uint2 time_bucket;
     Uint2 map_size;
     Uint4 chunk_size;
@@ -137,7 +144,11 @@ public:
     static void MeasureDB(SNCStateStat& state);
 
     static int GetLatestBlobExpire(void);
-    static void GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst, const CNCPeerControl* peer);
+    /// Summaries of all blobs in the slot;  if leaves are given then only
+    /// of blobs belonging to the digest leaves set in the mask
+    static void GetFullBlobsList(Uint2 slot, TNCBlobSumList& blobs_lst,
+                                 const CNCPeerControl* peer,
+                                 const TNCSyncLeavesMask* leaves = NULL);
     static Uint8 GetMaxSyncLogRecNo(void);
     static void SaveMaxSyncLogRecNo(void);
 
@@ -168,13 +179,21 @@ public:
                               SNCChunkMaps* maps,
                               Uint8 chunk_num,
                               char*& buffer,
-                              Uint4& buf_size);
+                              Uint4& buf_size,
+                              Uint1& codec);
+    /// Write chunk of blob data into the database. Returns pointer to data
+    /// written or NULL on error. If data was compressed (packed is set to
+    /// TRUE) the pointer can be used only with CNCChunkCodec::Unpack().
     static char* WriteChunkData(SNCBlobVerData* ver_data,
                                 SNCChunkMaps* maps,
                                 SNCCacheData* cache_data,
                                 Uint8 chunk_num,
                                 char* buffer,
-                                Uint4 buf_size);
+                                Uint4 buf_size,
+                                bool& packed);
+    /// Save compression dictionary trained for the cache into index database
+    static bool SaveChunkDictionary(Uint4 dict_id, const string& cache,
+                                    const string& dict_data);
 
     static void ReferenceCacheData(SNCCacheData* cache_data);
     static void ReleaseCacheData(SNCCacheData* cache_data);
@@ -192,6 +211,7 @@ private:
 inline
 SNCCacheData::SNCCacheData(void)
     : saved_dead_time(0),
+      sync_hash(0),
       time_bucket(0),
       map_size(0),
       chunk_size(0),
@@ -35,6 +35,8 @@
 #include "nc_storage.hpp"
 #include "storage_types.hpp"
 #include "nc_stat.hpp"
+#include "nc_compress.hpp"
+#include "sync_digest.hpp"
 #include <set>
 
 BEGIN_NCBI_SCOPE
@@ -607,6 +609,7 @@ CNCBlobVerManager::x_DeleteCurVersion(void)
     m_CacheData->dead_time = 0;
     CNCBlobStorage::ChangeCacheDeadTime(m_CacheData);
     m_CacheData->expire = 0;
+    CNCSyncDigest::BlobChanged(m_CacheData);
     if (m_CurVersion) {
         m_CurVersion->SetNotCurrent();
         m_CurVersion.Reset();
@@ -941,6 +944,7 @@ CNCBlobVerManager::FinalizeWriting(SNCBlobVerData* ver_data)
         m_CacheData->size = m_CurVersion->size;
         m_CacheData->chunk_size = m_CurVersion->chunk_size;
         m_CacheData->map_size = m_CurVersion->map_size;
+        CNCSyncDigest::BlobChanged(m_CacheData);
 
         m_CurVersion->meta_has_changed = true;
         m_CurVersion->last_access_time = CSrvTime::CurSecs();
@@ -965,6 +969,7 @@ CNCBlobVerManager::DeadTimeChanged(SNCBlobVerData* ver_data)
         m_CacheData->dead_time = ver_data->dead_time;
         m_CacheData->expire = ver_data->expire;
         m_CacheData->ver_expire = ver_data->ver_expire;
+        CNCSyncDigest::BlobChanged(m_CacheData);
         m_CurVersion->last_access_time = CSrvTime::CurSecs();
         m_CurVersion->need_write_time = m_CurVersion->last_access_time
                                         + s_WBWriteTimeout;
@@ -1117,6 +1122,7 @@ SNCBlobVerData::~SNCBlobVerData(void)
     if (chunk_maps) {
         SRV_FATAL("chunk_maps not released");
     }
+    x_ReleasePackedChunks(false);
 
     //AtomicSub(s_CntVers, 1);
     //Uint8 cnt = AtomicSub(s_CntVers, 1);
@@ -1303,9 +1309,11 @@ SNCBlobVerData::x_WriteCurChunk(char* write_mem, Uint4 write_size)
         need_stop_write = true;
         return true;
     }
+    bool packed = false;
     char* new_mem = CNCBlobStorage::WriteChunkData(
                                         this, chunk_maps, mgr->GetCacheData(),
-                                        cur_chunk_num, write_mem, write_size);
+                                        cur_chunk_num, write_mem, write_size,
+                                        packed);
     if (!new_mem) {
         RunAfter(s_WBFailedWriteDelay);
         return false;
@@ -1313,7 +1321,13 @@ SNCBlobVerData::x_WriteCurChunk(char* write_mem, Uint4 write_size)
     CNCStat::DiskDataWrite(write_size);
 
     wb_mem_lock.Lock();
-    chunks[cur_chunk_num] = new_mem;
+    // Compressed chunk can't be read from database directly, and until
+    // blob's meta is written it can't be found there at all. So readers
+    // continue to use write-back memory which is released later.
+    if (packed)
+        packed_chunks.push_back(cur_chunk_num);
+    else
+        chunks[cur_chunk_num] = new_mem;
     ++cur_chunk_num;
     if (data_mem < write_size) {
         SRV_FATAL("blob ver data broken");
@@ -1336,12 +1350,42 @@ SNCBlobVerData::x_WriteCurChunk(char* write_mem, Uint4 write_size)
     }
     wb_mem_lock.Unlock();
 
-    CWBMemDeleter* deleter = new CWBMemDeleter(write_mem, write_size);
-    deleter->CallRCU();
+    if (!packed) {
+        CWBMemDeleter* deleter = new CWBMemDeleter(write_mem, write_size);
+        deleter->CallRCU();
+    }
 
     return true;
 }
 
+void
+SNCBlobVerData::x_ReleasePackedChunks(bool use_rcu)
+{
+    wb_mem_lock.Lock();
+    vector<Uint8> packed_nums;
+    packed_nums.swap(packed_chunks);
+    vector<char*> mems;
+    mems.reserve(packed_nums.size());
+    ITERATE(vector<Uint8>, it, packed_nums) {
+        mems.push_back(chunks[*it]);
+        chunks[*it] = NULL;
+    }
+    wb_mem_lock.Unlock();
+
+    for (size_t i = 0; i < packed_nums.size(); ++i) {
+        Uint4 mem_size = chunk_size;
+        if (packed_nums[i] == cnt_chunks - 1)
+            mem_size = Uint4(min(size - (cnt_chunks - 1) * chunk_size, Uint8(chunk_size)));
+        if (use_rcu) {
+            CWBMemDeleter* deleter = new CWBMemDeleter(mems[i], mem_size);
+            deleter->CallRCU();
+        }
+        else {
+            s_FreeWriteBackMem(mems[i], mem_size, mem_size);
+        }
+    }
+}
+
 bool
 SNCBlobVerData::x_ExecuteWriteAll(void)
 {
@@ -1362,8 +1406,11 @@ SNCBlobVerData::x_ExecuteWriteAll(void)
         need_write_all = false;
         wb_mem_lock.Unlock();
 
-        if (x_WriteBlobInfo())
+        if (x_WriteBlobInfo()) {
+            // now compressed chunks can be read from the database
+            x_ReleasePackedChunks(true);
             SetRunnable();
+        }
         return true;
     }
     char* write_mem = chunks[cur_chunk_num];
@@ -1383,6 +1430,7 @@ SNCBlobVerData::x_DeleteVersion(void)
     CNCBlobStorage::DeleteBlobInfo(this, chunk_maps);
     coord.clear();
     x_FreeChunkMaps();
+    x_ReleasePackedChunks(false);
     if (cur_chunk_num < cnt_chunks) {
         for (Uint8 num = cur_chunk_num; num < cnt_chunks - 1; ++num) {
             s_FreeWriteBackMem(chunks[num], chunk_size, chunk_size);
@@ -1476,7 +1524,8 @@ CNCBlobAccessor::CNCBlobAccessor(void)
     : m_ChunkMaps(NULL),
       m_MetaInfoReady(false),
       m_WriteMemRequested(false),
-      m_Buffer(NULL)
+      m_Buffer(NULL),
+      m_IsUnpacked(false)
 {
 #if __NC_TASKS_MONITOR
     m_TaskName = "CNCBlobAccessor";
@@ -1510,6 +1559,7 @@ CNCBlobAccessor::Prepare(const string& key,
     m_CurChunk      = 0;
     m_ChunkPos      = 0;
     m_SizeRead      = 0;
+    m_IsUnpacked    = false;
 }
 
 void
@@ -1533,6 +1583,11 @@ CNCBlobAccessor::Deinitialize(void)
             delete m_ChunkMaps;
             m_ChunkMaps = NULL;
         }
+        if (m_IsUnpacked) {
+            m_Buffer = NULL;
+            m_IsUnpacked = false;
+            string().swap(m_Unpacked);
+        }
         break;
     case eNCCreate:
     case eNCCopyCreate:
@@ -1618,12 +1673,18 @@ CNCBlobAccessor::GetReadMemSize(void)
     }
     if (m_Buffer) {
         if (m_ChunkPos < m_ChunkSize) {
-            m_Buffer = m_CurData->chunks[m_CurChunk];
+            if (m_IsUnpacked)
+                return m_ChunkSize - m_ChunkPos;
+            m_Buffer = ACCESS_ONCE(m_CurData->chunks[m_CurChunk]);
+            // write-back memory of compressed chunk could be released
+            if (!m_Buffer  &&  !x_ReadChunk(m_ChunkSize))
+                return 0;
             return m_ChunkSize - m_ChunkPos;
         }
         ++m_CurChunk;
         m_ChunkPos = 0;
     }
+    m_IsUnpacked = false;
 
     Uint8 need_size = m_CurData->size - GetPosition() + m_ChunkPos;
     if (need_size > m_CurData->chunk_size)
@@ -1635,23 +1696,44 @@ CNCBlobAccessor::GetReadMemSize(void)
         return m_ChunkSize - m_ChunkPos;
     }
 
+    if (!x_ReadChunk(need_size))
+        return 0;
+    return m_ChunkSize - m_ChunkPos;
+}
+
+bool
+CNCBlobAccessor::x_ReadChunk(Uint8 need_size)
+{
     if (!m_ChunkMaps) {
         m_ChunkMaps = new SNCChunkMaps(m_CurData->map_size);
         s_AddCurrentMem(s_CalcChunkMapsSize(m_CurData->map_size));
     }
+    Uint1 codec = eNCCodecNone;
     if (!CNCBlobStorage::ReadChunkData(m_CurData, m_ChunkMaps, m_CurChunk,
-                                       m_Buffer, m_ChunkSize))
+                                       m_Buffer, m_ChunkSize, codec))
     {
         x_DelCorruptedVersion();
-        return 0;
+        return false;
+    }
+    if (codec != eNCCodecNone) {
+        // Unpacked data is private for this accessor, other readers will
+        // unpack the chunk again.
+        if (!CNCChunkCodec::Unpack(codec, m_Buffer, m_ChunkSize, m_Unpacked)) {
+            x_DelCorruptedVersion();
+            return false;
+        }
+        m_Buffer = &m_Unpacked[0];
+        m_ChunkSize = Uint4(m_Unpacked.size());
+        m_IsUnpacked = true;
     }
     if (m_ChunkSize != need_size) {
         x_DelCorruptedVersion();
-        return 0;
+        return false;
     }
 
-    ACCESS_ONCE(m_CurData->chunks[m_CurChunk]) = m_Buffer;
-    return m_ChunkSize - m_ChunkPos;
+    if (!m_IsUnpacked)
+        ACCESS_ONCE(m_CurData->chunks[m_CurChunk]) = m_Buffer;
+    return true;
 }
 
 void
@@ -1659,8 +1741,9 @@ CNCBlobAccessor::MoveReadPos(Uint4 move_size)
 {
     m_ChunkPos += move_size;
     m_SizeRead += move_size;
-    if (m_CurData->cur_chunk_num > m_CurChunk
-        &&  m_Buffer == m_CurData->chunks[m_CurChunk])
+    if (m_IsUnpacked
+        ||  (m_CurData->cur_chunk_num > m_CurChunk
+             &&  m_Buffer == m_CurData->chunks[m_CurChunk]))
     {
         CNCStat::DiskDataRead(move_size);
     }
@@ -227,6 +227,7 @@ private:
 
     void x_CreateNewData(void);
     void x_DelCorruptedVersion(void);
+    bool x_ReadChunk(Uint8 need_size);
 
 
     /// Type of access requested for the blob
@@ -248,6 +249,10 @@ private:
     Uint4       m_ChunkSize;
     Uint8       m_SizeRead;
     char*       m_Buffer;
+    /// Current chunk is compressed in the database and m_Buffer points
+    /// to its data unpacked into m_Unpacked
+    bool        m_IsUnpacked;
+    string      m_Unpacked;
     CSrvTask*   m_Owner;
 };
 
@@ -614,6 +614,10 @@ CNCActiveSyncControl::CNCActiveSyncControl(void)
     m_LoopStart = 0;
     m_CntUnfinished = 0;
     m_MyTrust = m_TheirTrust = 0;
+    m_ByDigest = false;
+    m_CntDiffLeaves = 0;
+    m_DigestRecNo = 0;
+    m_SyncBytes = 0;
 }
 
 CNCActiveSyncControl::~CNCActiveSyncControl(void) {
@@ -791,6 +795,9 @@ CNCActiveSyncControl::x_DoPeriodicSync(void)
     m_FinishSyncCalled = false;
     m_NextTask = eSynNoTask;
     m_StartTime = CSrvTime::Current().AsUSec();
+    m_ByDigest = false;
+    m_CntDiffLeaves = 0;
+    m_SyncBytes = 0;
 
     m_ReadOK = m_ReadERR = 0;
     m_WriteOK = m_WriteERR = 0;
@@ -807,6 +814,10 @@ CNCActiveSyncControl::x_DoPeriodicSync(void)
 
     CNCSyncLog::GetLastSyncedRecNo(m_SrvId, m_Slot,
                                    &m_LocalStartRecNo, &m_RemoteStartRecNo);
+    // Record number must be taken before the digest so that any change
+    // missed by the digest comparison is synchronized by events next time.
+    m_DigestRecNo = CNCSyncLog::GetCurrentRecNo(m_Slot);
+    Uint8 digest_root = CNCSyncDigest::GetRoot(m_Slot);
 
     CNCActiveHandler* conn = m_SlotSrv->peer->GetBGConn();
     if (!conn) {
@@ -817,7 +828,7 @@ CNCActiveSyncControl::x_DoPeriodicSync(void)
 
     m_StartedCmds = 1;
     m_SyncHandlers.clear();
-    conn->SyncStart(this, m_LocalStartRecNo, m_RemoteStartRecNo);
+    conn->SyncStart(this, m_LocalStartRecNo, m_RemoteStartRecNo, digest_root);
     return &CNCActiveSyncControl::x_WaitSyncStarted;
 }
 
@@ -841,12 +852,33 @@ CNCActiveSyncControl::x_WaitSyncStarted(void)
     m_RemoteSyncedRecNo = 0;
     m_SlotSrv->last_active_time = CSrvTime::CurSecs();
     // depending on the reply
-    if (m_SlotSrv->is_by_blobs)
+    if (m_SlotSrv->is_by_blobs) {
+        if (m_ByDigest  &&  m_CntDiffLeaves != 0)
+            return &CNCActiveSyncControl::x_RequestDiffBlobsList;
         return &CNCActiveSyncControl::x_PrepareSyncByBlobs;
+    }
     else
         return &CNCActiveSyncControl::x_PrepareSyncByEvents;
 }
 
+CNCActiveSyncControl::State
+CNCActiveSyncControl::x_RequestDiffBlobsList(void)
+{
+    CNCActiveHandler* conn = m_SlotSrv->peer->GetBGConn();
+    if (!conn) {
+        m_Result = eSynNetworkError;
+        m_Hint = NC_SYNC_HINT;
+        return &CNCActiveSyncControl::x_FinishSync;
+    }
+
+    string leaves = CNCSyncDigest::PackLeavesMask(m_DiffLeaves);
+    m_SyncBytes += leaves.size();
+    m_StartedCmds = 1;
+    conn->SyncBlobsList(this, leaves);
+    m_SlotSrv->last_active_time = CSrvTime::CurSecs();
+    return &CNCActiveSyncControl::x_WaitForBlobList;
+}
+
 CNCActiveSyncControl::State
 CNCActiveSyncControl::x_ExecuteSyncCommands(void)
 {
@@ -951,21 +983,31 @@ CNCActiveSyncControl::x_FinishSync(void)
         break;
     }
 
-    CSrvDiagMsg().PrintExtra()
-                 .PrintParam("sync", (m_SlotSrv->is_by_blobs? "blobs": "events"))
-                 .PrintParam("r_ok", m_ReadOK)
-                 .PrintParam("r_err", m_ReadERR)
-                 .PrintParam("w_ok", m_WriteOK)
-                 .PrintParam("w_err", m_WriteERR)
-                 .PrintParam("p_ok", m_ProlongOK)
-                 .PrintParam("p_err", m_ProlongERR)
-                 .PrintParam("d_ok", m_DelOK)
-                 .PrintParam("d_err", m_DelERR);
+    Uint8 end_time = CSrvTime::Current().AsUSec();
+    CNCStat::ActiveSyncFinished(m_SlotSrv->is_by_blobs, m_ByDigest,
+                                m_SyncBytes, end_time - m_StartTime);
+
+    CSrvDiagMsg diag_msg;
+    diag_msg.PrintExtra()
+            .PrintParam("sync", (m_ByDigest? "digest":
+                                 (m_SlotSrv->is_by_blobs? "blobs": "events")));
+    if (m_ByDigest)
+        diag_msg.PrintParam("diff_leaves", Uint4(m_CntDiffLeaves));
+    diag_msg.PrintParam("sync_bytes", m_SyncBytes)
+            .PrintParam("sync_usec", end_time - m_StartTime)
+            .PrintParam("r_ok", m_ReadOK)
+            .PrintParam("r_err", m_ReadERR)
+            .PrintParam("w_ok", m_WriteOK)
+            .PrintParam("w_err", m_WriteERR)
+            .PrintParam("p_ok", m_ProlongOK)
+            .PrintParam("p_err", m_ProlongERR)
+            .PrintParam("d_ok", m_DelOK)
+            .PrintParam("d_err", m_DelERR);
+    diag_msg.Flush();
     CSrvDiagMsg().StopRequest();
     ReleaseDiagCtx();
 
     if (s_LogFile) {
-        Uint8 end_time = CSrvTime::Current().AsUSec();
         Uint8 log_size = CNCSyncLog::GetLogSize();
         fprintf(s_LogFile,
                 "%" NCBI_UINT8_FORMAT_SPEC ",%" NCBI_UINT8_FORMAT_SPEC
@@ -1070,7 +1112,10 @@ CNCActiveSyncControl::x_WaitForBlobList(void)
 CNCActiveSyncControl::State
 CNCActiveSyncControl::x_PrepareSyncByBlobs(void)
 {
-    m_LocalSyncedRecNo = CNCSyncLog::GetCurrentRecNo(m_Slot);
+    if (m_ByDigest)
+        m_LocalSyncedRecNo = m_DigestRecNo;
+    else
+        m_LocalSyncedRecNo = CNCSyncLog::GetCurrentRecNo(m_Slot);
     m_RemoteSyncedRecNo = m_RemoteStartRecNo;
     m_SlotSrv->last_active_time = CSrvTime::CurSecs();
 
@@ -1078,7 +1123,10 @@ CNCActiveSyncControl::x_PrepareSyncByBlobs(void)
         delete it->second;
     }
     m_LocalBlobs.clear();
-    CNCBlobStorage::GetFullBlobsList(m_Slot, m_LocalBlobs, NULL);
+    if (!m_ByDigest)
+        CNCBlobStorage::GetFullBlobsList(m_Slot, m_LocalBlobs, NULL);
+    else if (m_CntDiffLeaves != 0)
+        CNCBlobStorage::GetFullBlobsList(m_Slot, m_LocalBlobs, NULL, &m_DiffLeaves);
 
     m_CurLocalBlob = m_LocalBlobs.begin();
     m_CurRemoteBlob = m_RemoteBlobs.begin();
@@ -1430,6 +1478,22 @@ CNCActiveSyncControl::ExecuteSyncTask(const SSyncTaskInfo& task_info,
     }
 }
 
+void
+CNCActiveSyncControl::SetRemoteDigest(const char* data, size_t size)
+{
+    m_ByDigest = true;
+    if (size == 0) {
+        // peer has the same digest root, nothing to synchronize
+        m_DiffLeaves.assign(kNCSyncDigestLeaves, false);
+        m_CntDiffLeaves = 0;
+        return;
+    }
+    TNCSyncDigest local;
+    CNCSyncDigest::GetLeaves(m_Slot, local);
+    m_CntDiffLeaves = CNCSyncDigest::CompareLeaves(local, data, size,
+                                                   m_DiffLeaves);
+}
+
 void
 CNCActiveSyncControl::CmdFinished(ESyncResult res, ESynActionType action, CNCActiveHandler* conn, int hint)
 {
@@ -35,6 +35,7 @@
 #include "sync_log.hpp"
 #include "nc_db_info.hpp"
 #include "nc_utils.hpp"
+#include "sync_digest.hpp"
 #include <set>
 
 
@@ -219,6 +220,12 @@ struct SSyncTaskInfo
             wait for sync started (check m_StartedCmds)
                 NCActiveHandler will report command result using  CmdFinished() method
             depending on the reply, goto x_PrepareSyncByBlobs, or goto x_PrepareSyncByEvents
+            if another server has sent us its slot digest instead of blob list
+                and some digest leaves differ, goto x_RequestDiffBlobsList
+
+    -> x_RequestDiffBlobsList
+            request blob list only for the digest leaves that differ (SYNC_BLIST)
+            goto x_WaitForBlobList
 
     -> x_PrepareSyncByEvents
             another server has sent us list of events,
@@ -232,7 +239,7 @@ struct SSyncTaskInfo
             once blob list received, goto x_PrepareSyncByBlobs
     
     -> x_PrepareSyncByBlobs
-            re-fill list of local blobs (in given slot)
+            re-fill list of local blobs (in given slot, or in differing digest leaves)
             goto x_ExecuteSyncCommands
     
     -> x_ExecuteSyncCommands
@@ -266,6 +273,8 @@ public:
     void StartResponse(Uint8 local_rec_no, Uint8 remote_rec_no, bool by_blobs);
     bool AddStartEvent(SNCSyncEvent* evt);
     bool AddStartBlob(const string& key, SNCBlobSummary* blob_sum);
+    void SetRemoteDigest(const char* data, size_t size);
+    void AddSyncBytes(Uint8 size);
     bool GetNextTask(SSyncTaskInfo& task_info, bool* is_valid = nullptr);
     void ExecuteSyncTask(const SSyncTaskInfo& task_info, CNCActiveHandler* conn);
     void CmdFinished(ESyncResult res, ESynActionType action, CNCActiveHandler* conn, int hint);
@@ -284,6 +293,7 @@ private:
     State x_FinishScanSlots(void);
     State x_DoPeriodicSync(void);
     State x_WaitSyncStarted(void);
+    State x_RequestDiffBlobsList(void);
     State x_PrepareSyncByEvents(void);
     State x_WaitForBlobList(void);
     State x_PrepareSyncByBlobs(void);
@@ -327,6 +337,11 @@ private:
     TNCBlobSumList m_RemoteBlobs;
     TBlobsListIt   m_CurLocalBlob;
     TBlobsListIt   m_CurRemoteBlob;
+    bool    m_ByDigest;
+    Uint2   m_CntDiffLeaves;
+    TNCSyncLeavesMask m_DiffLeaves;
+    Uint8   m_DigestRecNo;
+    Uint8   m_SyncBytes;
     Uint8   m_ReadOK;
     Uint8   m_ReadERR;
     Uint8   m_WriteOK;
@@ -401,6 +416,12 @@ CNCActiveSyncControl::AddStartEvent(SNCSyncEvent* evt)
     return true;
 }
 
+inline void
+CNCActiveSyncControl::AddSyncBytes(Uint8 size)
+{
+    m_SyncBytes += size;
+}
+
 inline bool
 CNCActiveSyncControl::AddStartBlob(const string& key, SNCBlobSummary* blob_sum)
 {
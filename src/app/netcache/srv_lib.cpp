@@ -46,6 +46,8 @@ public:
 
 #include "../../corelib/ncbistr.cpp"
 #undef NCBI_USE_ERRCODE_X
+#include "../../corelib/ncbistr_simd.cpp"
+#undef NCBI_USE_ERRCODE_X
 #undef CHECK_RANGE
 #include "../../corelib/ncbiobj.cpp"
 #undef NCBI_USE_ERRCODE_X
@@ -68,7 +70,14 @@ public:
 #undef NCBI_USE_ERRCODE_X
 #include "../../corelib/stream_utils.cpp"
 #undef NCBI_USE_ERRCODE_X
-#include "../../corelib/ncbifile.cpp"
+// CDirWalker's worker threads are corelib's CThread, unavailable here
+#ifdef NCBI_THREADS
+#  undef NCBI_THREADS
+#  include "../../corelib/ncbifile.cpp"
+#  define NCBI_THREADS
+#else
+#  include "../../corelib/ncbifile.cpp"
+#endif
 #undef NCBI_USE_ERRCODE_X
 #include "../../corelib/ncbimtx.cpp"
 #undef NCBI_USE_ERRCODE_X
@@ -60,7 +60,8 @@ struct ATTR_PACKED SFileIndexRec
     Uint4   next_num;
     Uint4   offset;
     Uint4   rec_size:24;
-    Uint1   rec_type:8;
+    Uint1   rec_type:4;
+    Uint1   rec_codec:4;    // ENCChunkCodec for chunk data records
     SNCDataCoord chain_coord;
     SNCCacheData* cache_data;
 };
@@ -270,13 +271,19 @@ private:
 
 
 // move blob chunks, or data from old files (which are 'almost empty')
-// into new ones, then deletes old files
+// into new ones, then deletes old files.
+// Several shrinkers can work at the same time (see ini file: shrink_tasks),
+// each of them moves records from its own file. All of them share one
+// budget of bytes and records moved per second.
 /*
     begin: x_PrepareToShrink
     -> x_PrepareToShrink: analyze what to move and what to delete;
+           pick file with the largest garbage ratio not taken by other shrinker;
+           only the first shrinker deletes empty files
     -> x_DeleteNextFile: has smth to delete ? delete : x_StartMoves
     -> x_StartMoves: has smth to move ? x_MoveNextRecord : x_FinishSession
     -> x_MoveNextRecord:
+           if budget for this second is spent, wait for the next one;
            find what to move;
            if not found, goto x_FinishMoves;
            if VerMgr for this key exists, goto x_CheckCurVersion;
@@ -293,6 +300,7 @@ private:
     -> x_MoveRecord: move, goto x_FinishMoveRecord
     -> x_FinishMoveRecord: release used resources;
         if move failed ? x_FinishMoves :  x_MoveNextRecord
+        (yield execution after each shrink_batch_size records)
     -> x_FinishMoves: if the file from which we moved records is empty now, delete it;
         save some statistics
         goto x_FinishSession
@@ -304,9 +312,12 @@ class CSpaceShrinker : public CSrvStatesTask<CSpaceShrinker>,
                        public CSrvTransConsumer
 {
 public:
-    CSpaceShrinker(void);
+    CSpaceShrinker(int index);
     virtual ~CSpaceShrinker(void);
 
+    /// Print progress of the file move currently in progress
+    void WriteProgress(TNCBufferType& task) const;
+
 private:
     State x_PrepareToShrink(void);
     State x_DeleteNextFile(void);
@@ -323,9 +334,14 @@ private:
 
     typedef vector<CSrvRef<SNCDBFileInfo> > TFilesList;
 
+    int m_Index;
     TFilesList m_FilesToDel;
     TFilesList::iterator m_CurDelFile;
     CSrvRef<SNCDBFileInfo> m_MaxFile;
+    /// Id of m_MaxFile while moves are in progress (0 otherwise)
+    Uint4 m_MoveFileId;
+    /// Records left to move before yielding execution
+    Uint4 m_BatchLeft;
     SFileIndexRec* m_IndRec;
     SNCCacheData* m_CacheData;
     CNCBlobVerManager* m_VerMgr;
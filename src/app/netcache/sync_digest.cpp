@@ -0,0 +1,250 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Digest of blobs summaries in each slot
+ *
+ */
+
+#include "nc_pch.hpp"
+
+#include "netcached.hpp"
+#include "sync_digest.hpp"
+#include "nc_storage.hpp"
+#include "distribution_conf.hpp"
+
+
+BEGIN_NCBI_SCOPE
+
+
+struct SSlotDigest
+{
+    CMiniMutex lock;
+    Uint8 root;
+    Uint8 leaves[kNCSyncDigestLeaves];
+
+    SSlotDigest(void) : root(0) {
+        memset(leaves, 0, sizeof(leaves));
+    }
+};
+
+
+static vector<SSlotDigest*> s_SlotDigests;
+static Uint2 s_SlotBuckets = 1;
+
+
+
+static inline Uint8
+s_MixHash(Uint8 h)
+{
+    h ^= h >> 33;
+    h *= NCBI_CONST_UINT8(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= NCBI_CONST_UINT8(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+static Uint8
+s_HashKey(const string& key)
+{
+    // FNV-1a, it must not depend on platform or on the library version
+    Uint8 h = NCBI_CONST_UINT8(0xcbf29ce484222325);
+    for (size_t i = 0; i < key.size(); ++i) {
+        h ^= Uint1(key[i]);
+        h *= NCBI_CONST_UINT8(0x100000001b3);
+    }
+    return h;
+}
+
+static inline Uint2
+s_LeafByHash(Uint8 key_hash)
+{
+    return Uint2((key_hash >> 32) % kNCSyncDigestLeaves);
+}
+
+static Uint8
+s_CalcBlobHash(const SNCCacheData* data, Uint8 key_hash)
+{
+    if (data->dead_time == 0)
+        return 0;
+
+    Uint8 h = s_MixHash(key_hash ^ data->create_time);
+    h = s_MixHash(h ^ data->create_server);
+    h = s_MixHash(h ^ data->create_id);
+    h = s_MixHash(h ^ Uint4(data->dead_time));
+    h = s_MixHash(h ^ ((Uint8(Uint4(data->expire)) << 32)
+                       + Uint4(data->ver_expire)));
+    return h == 0? 1: h;
+}
+
+static inline SSlotDigest*
+s_GetDigest(Uint2 time_bucket)
+{
+    if (time_bucket == 0)
+        return NULL;
+    size_t slot = (time_bucket - 1) / s_SlotBuckets + 1;
+    return slot < s_SlotDigests.size()? s_SlotDigests[slot]: NULL;
+}
+
+static void
+s_ChangeLeaf(SNCCacheData* cache_data, Uint8 key_hash, Uint8 new_hash)
+{
+    SSlotDigest* digest = s_GetDigest(cache_data->time_bucket);
+    if (!digest)
+        return;
+
+    Uint8 diff = cache_data->sync_hash ^ new_hash;
+    digest->lock.Lock();
+    digest->leaves[s_LeafByHash(key_hash)] ^= diff;
+    digest->root ^= diff;
+    digest->lock.Unlock();
+    cache_data->sync_hash = new_hash;
+}
+
+
+void
+CNCSyncDigest::Initialize(void)
+{
+    s_SlotBuckets = CNCDistributionConf::GetCntSlotBuckets();
+    Uint2 cnt_slots = CNCDistributionConf::GetCntTimeBuckets() / s_SlotBuckets;
+    s_SlotDigests.resize(cnt_slots + 1, NULL);
+    for (Uint2 slot = 1; slot <= cnt_slots; ++slot) {
+        s_SlotDigests[slot] = new SSlotDigest();
+    }
+}
+
+void
+CNCSyncDigest::BlobChanged(SNCCacheData* cache_data)
+{
+    Uint8 key_hash = s_HashKey(cache_data->key);
+    Uint8 new_hash = s_CalcBlobHash(cache_data, key_hash);
+    if (new_hash != cache_data->sync_hash)
+        s_ChangeLeaf(cache_data, key_hash, new_hash);
+}
+
+void
+CNCSyncDigest::BlobRemoved(SNCCacheData* cache_data)
+{
+    if (cache_data->sync_hash != 0)
+        s_ChangeLeaf(cache_data, s_HashKey(cache_data->key), 0);
+}
+
+Uint8
+CNCSyncDigest::GetRoot(Uint2 slot)
+{
+    if (slot >= s_SlotDigests.size()  ||  !s_SlotDigests[slot])
+        return 0;
+
+    SSlotDigest* digest = s_SlotDigests[slot];
+    digest->lock.Lock();
+    Uint8 root = digest->root;
+    digest->lock.Unlock();
+    return root;
+}
+
+void
+CNCSyncDigest::GetLeaves(Uint2 slot, TNCSyncDigest& leaves)
+{
+    leaves.assign(kNCSyncDigestLeaves, 0);
+    if (slot >= s_SlotDigests.size()  ||  !s_SlotDigests[slot])
+        return;
+
+    SSlotDigest* digest = s_SlotDigests[slot];
+    digest->lock.Lock();
+    memcpy(&leaves[0], digest->leaves, sizeof(digest->leaves));
+    digest->lock.Unlock();
+}
+
+Uint2
+CNCSyncDigest::GetKeyLeaf(const string& key)
+{
+    return s_LeafByHash(s_HashKey(key));
+}
+
+Uint2
+CNCSyncDigest::CompareLeaves(const TNCSyncDigest& local,
+                             const char* remote, size_t remote_size,
+                             TNCSyncLeavesMask& mask)
+{
+    mask.assign(kNCSyncDigestLeaves, true);
+    if (local.size() != kNCSyncDigestLeaves
+        ||  remote_size != kNCSyncDigestLeaves * sizeof(Uint8))
+    {
+        return kNCSyncDigestLeaves;
+    }
+
+    Uint2 cnt_diff = 0;
+    for (Uint2 i = 0; i < kNCSyncDigestLeaves; ++i, remote += sizeof(Uint8)) {
+        Uint8 leaf;
+        memcpy(&leaf, remote, sizeof(leaf));
+        mask[i] = leaf != local[i];
+        if (mask[i])
+            ++cnt_diff;
+    }
+    return cnt_diff;
+}
+
+string
+CNCSyncDigest::PackLeavesMask(const TNCSyncLeavesMask& mask)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+
+    string result;
+    result.reserve(mask.size() / 4 + 1);
+    for (size_t i = 0; i < mask.size(); i += 4) {
+        int digit = 0;
+        for (size_t j = 0; j < 4; ++j) {
+            if (i + j < mask.size()  &&  mask[i + j])
+                digit |= 1 << j;
+        }
+        result.append(1, kHexDigits[digit]);
+    }
+    return result;
+}
+
+bool
+CNCSyncDigest::UnpackLeavesMask(const CTempString& packed,
+                                TNCSyncLeavesMask& mask)
+{
+    if (packed.size() != kNCSyncDigestLeaves / 4)
+        return false;
+
+    mask.assign(kNCSyncDigestLeaves, false);
+    for (size_t i = 0; i < packed.size(); ++i) {
+        int digit = NStr::HexChar(packed[i]);
+        if (digit < 0)
+            return false;
+        for (size_t j = 0; j < 4; ++j) {
+            mask[i * 4 + j] = (digit & (1 << j)) != 0;
+        }
+    }
+    return true;
+}
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,92 @@
+#ifndef NETCACHE__SYNC_DIGEST__HPP
+#define NETCACHE__SYNC_DIGEST__HPP
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Digest of blobs summaries in each slot used to narrow down the
+ *   synchronization by blobs lists
+ */
+
+
+BEGIN_NCBI_SCOPE
+
+
+class SNCCacheData;
+
+
+/// Number of leaves in the digest of each slot
+static const Uint2 kNCSyncDigestLeaves = 1024;
+
+/// Digest leaves of one slot
+typedef vector<Uint8> TNCSyncDigest;
+/// Set of digest leaves, one bit per leaf
+typedef vector<bool>  TNCSyncLeavesMask;
+
+
+/// Digest of blobs existing in each slot.
+/// Every slot has kNCSyncDigestLeaves leaves, each blob key belongs to one of
+/// them. Leaf value is XOR of hashes of all blobs' summaries (the fields
+/// compared by SNCBlobSummary::isEqual()) belonging to it, so that it's
+/// maintained incrementally when blob's summary changes and it's the same on
+/// all servers having the same set of blobs. Root of the slot digest is XOR
+/// of all its leaves. When peers need to synchronize by blobs lists they
+/// compare roots first, then leaves, and then exchange lists of blobs only
+/// from the leaves that differ.
+class CNCSyncDigest
+{
+public:
+    static void Initialize(void);
+
+    /// Recalculate blob's contribution into the digest of its slot.
+    /// Should be called after any change of the blob's summary, under
+    /// cache_data->lock (or when nobody else can access cache_data).
+    static void BlobChanged(SNCCacheData* cache_data);
+    /// Remove blob's contribution from the digest before cache_data is
+    /// deleted.
+    static void BlobRemoved(SNCCacheData* cache_data);
+
+    static Uint8 GetRoot(Uint2 slot);
+    static void GetLeaves(Uint2 slot, TNCSyncDigest& leaves);
+    /// Leaf the blob key belongs to
+    static Uint2 GetKeyLeaf(const string& key);
+
+    /// Compare local leaves with the ones received from peer, set in mask
+    /// all leaves that differ. Returns number of different leaves.
+    static Uint2 CompareLeaves(const TNCSyncDigest& local,
+                               const char* remote, size_t remote_size,
+                               TNCSyncLeavesMask& mask);
+    /// Conversion of leaves mask to/from hex string passed in SYNC_BLIST
+    static string PackLeavesMask(const TNCSyncLeavesMask& mask);
+    static bool UnpackLeavesMask(const CTempString& packed,
+                                 TNCSyncLeavesMask& mask);
+};
+
+
+END_NCBI_SCOPE
+
+#endif /* NETCACHE__SYNC_DIGEST__HPP */
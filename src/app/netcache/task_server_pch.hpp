@@ -79,6 +79,7 @@
 #include <boost/intrusive/slist.hpp>
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
+#include <boost/intrusive/unordered_set.hpp>
 
 
 #include "task_server.hpp"
@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+#
+# Authors: NCBI C++ Toolkit
+#
+# $Id$
+#
+
+"""
+NetCache periodic sync integration test: digest-narrowed blobs-list sync
+"""
+
+import sys
+import os
+import os.path
+import shutil
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+from optparse import OptionParser
+
+
+VERBOSE = False
+DEFAULT_BASE_PORT = 9470
+BLOB_TTL = 3600
+BLOB_SIZE = 1000
+
+# Blobs put while both servers are up, blobs put and removed while the
+# second one is down.  The changes made while it is down must exceed
+# max_slot_log_records, so that the events log cannot cover them and the
+# sync has to go by the blobs lists (i.e. by the digests).
+INITIAL_BLOBS = 50
+OFFLINE_BLOBS = 300
+OFFLINE_REMOVALS = 25
+MAX_SLOT_LOG_RECORDS = 100
+
+SYNC_TIMEOUT = 120
+
+# Number of digest leaves in a slot, see kNCSyncDigestLeaves
+DIGEST_LEAVES = 1024
+
+
+CONFIG = """\
+[task_server]
+log_visible = Warning
+
+[netcache]
+ports = %(port)d
+control_port = %(control_port)d
+search_on_read = false
+prolong_on_read = false
+
+[storage]
+path = %(path)s
+write_back_timeout = 1
+
+[mirror]
+server_0 = g:127.0.0.1:%(control_port_0)d
+server_1 = g:127.0.0.1:%(control_port_1)d
+srv_slots_0 = 1,2
+srv_slots_1 = 1,2
+deferred_sync_interval = 2
+max_slot_log_records = %(max_records)d
+periodic_log_file = %(path)s/periodic.log
+sync_log_file = %(path)s/sync_events.log
+"""
+
+
+def main():
+    """The real entry point"""
+
+    parser = OptionParser("""%prog [options] <path to netcached>
+
+Starts two NetCache servers mirroring each other, stops one of them,
+changes blobs on the other one, starts the stopped one again, and checks
+that the periodic sync brings both servers to the same set of blobs by
+exchanging slot digests and only the differing parts of the blobs lists.""")
+    parser.add_option("-v", "--verbose",
+                      action="store_true", dest="verbose", default=False,
+                      help="be verbose (default: False)")
+    parser.add_option("-p", "--port", dest="port", type="int",
+                      default=DEFAULT_BASE_PORT,
+                      help="base port to use, the servers take 4 ports "
+                           "starting from it (default: " +
+                           str(DEFAULT_BASE_PORT) + ")")
+    parser.add_option("-k", "--keep",
+                      action="store_true", dest="keep", default=False,
+                      help="keep the servers' directories (default: False)")
+
+    # parse the command line options
+    options, args = parser.parse_args()
+    global VERBOSE
+    VERBOSE = options.verbose
+
+    if len(args) != 1:
+        parser.error("incorrect number of arguments")
+    netcached = os.path.abspath(args[0])
+    if not os.access(netcached, os.X_OK):
+        raise Exception("Cannot execute " + netcached)
+
+    workDir = tempfile.mkdtemp(prefix="check_nc_sync_digest.")
+    servers = [NCServer(netcached, workDir, options.port, index)
+               for index in range(2)]
+    try:
+        runTest(servers)
+        # The servers flush their logs on exit
+        for server in servers:
+            server.stop()
+        checkDigestSyncs(servers)
+    finally:
+        for server in servers:
+            server.stop()
+        if options.keep:
+            print("Servers' directories are kept in " + workDir)
+        else:
+            shutil.rmtree(workDir, ignore_errors=True)
+
+    print("PASSED")
+    return 0
+
+
+def runTest(servers):
+    """Runs the test scenario"""
+
+    first, second = servers
+
+    printVerbose('Starting both servers...')
+    first.start()
+    second.start()
+
+    printVerbose('Putting ' + str(INITIAL_BLOBS) + ' blobs...')
+    keys = first.putBlobs(INITIAL_BLOBS)
+    waitForSync(second, keys, [])
+    printVerbose('Initial blobs mirrored: OK')
+
+    printVerbose('Stopping the second server...')
+    second.stop()
+
+    printVerbose('Changing blobs on the first server...')
+    keys += first.putBlobs(OFFLINE_BLOBS)
+    removed = keys[:OFFLINE_REMOVALS]
+    keys = keys[OFFLINE_REMOVALS:]
+    first.removeBlobs(removed)
+
+    printVerbose('Restarting the second server...')
+    second.start()
+    waitForSync(second, keys, removed)
+    printVerbose('Changes synced: OK')
+
+
+def checkDigestSyncs(servers):
+    """Checks that the changes went by the digest-narrowed syncs"""
+
+    diffLeaves = []
+    for server in servers:
+        diffLeaves += server.getDigestSyncs()
+    printVerbose('Digest syncs, differing leaves: ' + str(diffLeaves))
+    if not [leaves for leaves in diffLeaves if leaves > 0]:
+        raise Exception("No digest-narrowed sync has transferred changes")
+    if [leaves for leaves in diffLeaves if leaves >= DIGEST_LEAVES]:
+        raise Exception("A digest sync has not narrowed the blobs list")
+
+
+def waitForSync(server, keys, removed):
+    """Waits till the server has all the keys and none of the removed ones"""
+
+    deadline = time.time() + SYNC_TIMEOUT
+    while True:
+        missing = server.countBlobs(keys, False)
+        extra = server.countBlobs(removed, True)
+        printVerbose('Blobs on ' + server.name + ': ' + str(missing) +
+                     ' missing, ' + str(extra) + ' not removed')
+        if missing == 0 and extra == 0:
+            return
+        if time.time() > deadline:
+            raise Exception("Servers have not converged in " +
+                            str(SYNC_TIMEOUT) + " seconds")
+        time.sleep(2)
+
+
+class NCServer:
+    """NetCache server instance under test"""
+
+    def __init__(self, netcached, workDir, basePort, index):
+        self.netcached = netcached
+        self.name = 'server_' + str(index)
+        self.path = os.path.join(workDir, self.name)
+        self.port = basePort + index
+        self.proc = None
+        os.mkdir(self.path)
+        with open(self.confFile(), 'w') as conf:
+            conf.write(CONFIG % {'port': self.port,
+                                 'control_port': basePort + 2 + index,
+                                 'control_port_0': basePort + 2,
+                                 'control_port_1': basePort + 3,
+                                 'path': self.path,
+                                 'max_records': MAX_SLOT_LOG_RECORDS})
+
+    def confFile(self):
+        return os.path.join(self.path, 'netcached.ini')
+
+    def logFile(self):
+        return os.path.join(self.path, 'netcached.log')
+
+    def start(self):
+        """Starts the server and waits till it accepts connections"""
+        self.proc = subprocess.Popen([self.netcached,
+                                      '-nodaemon',
+                                      '-conffile', self.confFile(),
+                                      '-logfile', self.logFile()],
+                                     stdout=subprocess.DEVNULL,
+                                     stderr=subprocess.DEVNULL)
+        deadline = time.time() + 30
+        while True:
+            if self.proc.poll() is not None:
+                raise Exception(self.name + " has exited with code " +
+                                str(self.proc.returncode))
+            try:
+                socket.create_connection(('127.0.0.1', self.port)).close()
+                return
+            except OSError:
+                if time.time() > deadline:
+                    raise Exception(self.name + " has not started")
+                time.sleep(0.5)
+
+    def stop(self):
+        """Stops the server gracefully"""
+        if self.proc is None:
+            return
+        self.proc.terminate()
+        try:
+            self.proc.wait(60)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+            self.proc.wait()
+        self.proc = None
+
+    def connect(self):
+        sock = socket.create_connection(('127.0.0.1', self.port))
+        conn = sock.makefile('rwb')
+        conn.write(b'client=check_nc_sync_digest\r\n')
+        return sock, conn
+
+    @staticmethod
+    def command(conn, cmd):
+        conn.write(cmd.encode() + b'\r\n')
+        conn.flush()
+        reply = conn.readline().decode().strip()
+        if not reply.startswith('OK:'):
+            raise Exception("Command '" + cmd + "' failed: " + reply)
+        return reply[3:]
+
+    def putBlobs(self, count):
+        """Creates blobs, returns their keys"""
+        keys = []
+        sock, conn = self.connect()
+        try:
+            for _ in range(count):
+                reply = self.command(conn, 'PUT3 ' + str(BLOB_TTL))
+                key = reply.split('ID:', 1)[1].strip()
+                data = os.urandom(BLOB_SIZE)
+                conn.write(struct.pack('<I', 0x01020304) +
+                           struct.pack('<I', len(data)) + data +
+                           struct.pack('<I', 0xFFFFFFFF))
+                conn.flush()
+                reply = conn.readline().decode().strip()
+                if not reply.startswith('OK:'):
+                    raise Exception("Writing blob " + key +
+                                    " failed: " + reply)
+                keys.append(key)
+        finally:
+            sock.close()
+        return keys
+
+    def removeBlobs(self, keys):
+        sock, conn = self.connect()
+        try:
+            for key in keys:
+                self.command(conn, 'RMV2 ' + key)
+        finally:
+            sock.close()
+
+    def countBlobs(self, keys, exist):
+        """Counts the blobs that (do not) exist locally"""
+        count = 0
+        sock, conn = self.connect()
+        try:
+            for key in keys:
+                if (self.command(conn, 'HASB ' + key + ' 1') == '1') \
+                        == exist:
+                    count += 1
+        finally:
+            sock.close()
+        return count
+
+    def getDigestSyncs(self):
+        """Returns the numbers of differing leaves of the digest syncs"""
+        leaves = []
+        with open(self.logFile(), errors='replace') as log:
+            for line in log:
+                if 'sync=digest&' not in line:
+                    continue
+                for param in line.split()[-1].split('&'):
+                    if param.startswith('diff_leaves='):
+                        leaves.append(int(param.split('=', 1)[1]))
+        return leaves
+
+
+def printVerbose(msg):
+    """Prints stdout message conditionally"""
+    if VERBOSE:
+        timestamp = time.strftime('%Y-%m-%d %H:%M:%S')
+        print(timestamp + " " + msg)
+
+
+if __name__ == "__main__":
+    try:
+        retVal = main()
+    except KeyboardInterrupt:
+        retVal = 1
+    except Exception as exc:
+        print("FAILED: " + str(exc), file=sys.stderr)
+        retVal = 2
+    sys.exit(retVal)
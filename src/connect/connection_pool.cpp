@@ -77,6 +77,11 @@ void CServer_ConnectionPool::Erase(void)
         delete *it;
     }
     m_Data.clear();
+    if (m_Reactor.get()) {
+        m_Reactor->Clear();
+        m_ReactorChanges.clear();
+        m_Deferred.clear();
+    }
 }
 
 void CServer_ConnectionPool::x_UpdateExpiration(TConnBase* conn)
@@ -111,6 +116,8 @@ bool CServer_ConnectionPool::Add(TConnBase* conn, EServerConnType type)
         if (m_Data.find(conn) != m_Data.end())
             abort();
         m_Data.insert(conn);
+        if (m_Reactor.get()  &&  type != eActiveSocket)
+            m_ReactorChanges.push_back(conn);
     }}
 
     if (type == eListener)
@@ -128,6 +135,10 @@ void CServer_ConnectionPool::Remove(TConnBase* conn)
 {
     CMutexGuard guard(m_Mutex);
     m_Data.erase(conn);
+    if (m_Reactor.get()) {
+        m_Reactor->Remove(conn);
+        m_Deferred.erase(conn);
+    }
 }
 
 
@@ -177,6 +188,7 @@ bool CServer_ConnectionPool::RemoveListener(unsigned short  port)
 
 void CServer_ConnectionPool::SetConnType(TConnBase* conn, EServerConnType type)
 {
+    bool changed = false;
     conn->type_lock.Lock();
     if (conn->type != eClosedSocket) {
         EServerConnType new_type = type;
@@ -189,17 +201,27 @@ void CServer_ConnectionPool::SetConnType(TConnBase* conn, EServerConnType type)
                 x_UpdateExpiration(conn);
         }
         conn->type = new_type;
+        changed = true;
     }
     conn->type_lock.Unlock();
 
     // Signal poll cycle to re-read poll vector by sending
     // byte to control socket
-    if (type == eInactiveSocket)
+    if (type == eInactiveSocket) {
+        if (changed  &&  m_Reactor.get()) {
+            CMutexGuard guard(m_Mutex);
+            m_ReactorChanges.push_back(conn);
+        }
         PingControlConnection();
+    }
 }
 
 void CServer_ConnectionPool::PingControlConnection(void)
 {
+    if (m_Reactor.get()) {
+        m_Reactor->Wakeup();
+        return;
+    }
     EIO_Status status = m_ControlTrigger.Set();
     if (status != eIO_Success) {
         ERR_POST_X(4, Warning
@@ -357,6 +379,185 @@ bool CServer_ConnectionPool::GetPollAndTimerVec(
     return false;
 }
 
+static double s_TimeToSeconds(const CTime& t)
+{
+    return t.IsEmpty() ? 0.0 : double(t.GetTimeT()) + t.NanoSecond() * 1e-9;
+}
+
+// Data already read from the OS socket into the CSocket buffer does not
+// make the socket ready for epoll (CSocketAPI::Poll() takes it into account)
+static bool s_HasBufferedInput(IServer_ConnectionBase* conn)
+{
+    const CSocket* socket = dynamic_cast<const CSocket*>(conn);
+    return socket  &&
+        socket->GetCount(eIO_Read) > socket->GetPosition(eIO_Read);
+}
+
+bool CServer_ConnectionPool::EnableReactor(void)
+{
+    if ( !CServer_Reactor::IsSupported() )
+        return false;
+
+    CMutexGuard guard(m_Mutex);
+    if (m_Reactor.get())
+        return true;
+    try {
+        m_Reactor.reset(new CServer_Reactor());
+    }
+    catch (CException& ex) {
+        ERR_POST_X(11, Warning << "Cannot create reactor, using poll: "
+                   << ex.GetMsg());
+        return false;
+    }
+    // Everything added so far has to be registered
+    m_ReactorChanges.assign(m_Data.begin(), m_Data.end());
+    return true;
+}
+
+bool CServer_ConnectionPool::GetReactorChanges(
+                             vector<TReadyConn>& ready,
+                             vector<IServer_ConnectionBase*>& timer_requests,
+                             STimeout* timer_timeout,
+                             vector<IServer_ConnectionBase*>& revived_conns,
+                             vector<IServer_ConnectionBase*>& to_close_conns,
+                             vector<IServer_ConnectionBase*>& to_delete_conns)
+{
+    double now = s_TimeToSeconds(CTime(CTime::eCurrent));
+    ready.clear();
+    timer_requests.clear();
+    revived_conns.clear();
+    to_close_conns.clear();
+    to_delete_conns.clear();
+
+    CMutexGuard     guard(m_Mutex);
+
+    // Listener removal requests are rare, so look through all connections
+    // as GetPollAndTimerVec() does
+    if ( !m_ListenerPortsToStop.empty() ) {
+        ERASE_ITERATE(TData, it, m_Data) {
+            CServer_Listener* listener = dynamic_cast<CServer_Listener*>(*it);
+            if ( !listener )
+                continue;
+            vector<unsigned short>::iterator    port_it =
+                    std::find(m_ListenerPortsToStop.begin(),
+                              m_ListenerPortsToStop.end(),
+                              listener->GetPort());
+            if (port_it != m_ListenerPortsToStop.end()) {
+                m_ListenerPortsToStop.erase(port_it);
+                m_Reactor->Remove(*it);
+                delete *it;
+                m_Data.erase(it);
+            }
+        }
+    }
+
+    m_ReactorChangesCopy.clear();
+    m_ReactorChangesCopy.swap(m_ReactorChanges);
+    ITERATE(vector<TConnBase*>, it, m_ReactorChangesCopy) {
+        TConnBase* conn_base = *it;
+        TData::iterator data_it = m_Data.find(conn_base);
+        if (data_it == m_Data.end())
+            continue;   // already deleted or removed from the pool
+
+        conn_base->type_lock.Lock();
+        EServerConnType conn_type = conn_base->type;
+        if (conn_type == eListener) {
+            if (m_ListeningStarted)
+                m_Reactor->AddListener(conn_base);
+        }
+        else if (conn_type == eClosedSocket
+                 ||  (conn_type == eInactiveSocket  &&  !conn_base->IsOpen()))
+        {
+            // See GetPollAndTimerVec()
+            m_Reactor->Remove(conn_base);
+            to_delete_conns.push_back(conn_base);
+            m_Data.erase(data_it);
+        }
+        else if (conn_type == eInactiveSocket) {
+            const CTime*  alarm_time = NULL;
+            EIO_Event     events = conn_base->GetEventsToPollFor(&alarm_time);
+            if ((events & eIO_Read)  &&  s_HasBufferedInput(conn_base)) {
+                conn_base->type = eActiveSocket;
+                ready.push_back(TReadyConn(conn_base, eIO_Read));
+            }
+            else if ( !m_Reactor->Arm(conn_base, events,
+                                      s_TimeToSeconds(conn_base->expiration),
+                                      alarm_time
+                                      ? s_TimeToSeconds(*alarm_time) : 0.0) ) {
+                // The socket has been closed by the handler; poll() would
+                // report it as closed too
+                conn_base->type = eActiveSocket;
+                ready.push_back(TReadyConn(conn_base, eIO_Close));
+            }
+        }
+        else if (conn_type == eDeferredSocket) {
+            m_Deferred.insert(conn_base);
+        }
+        conn_base->type_lock.Unlock();
+    }
+
+    ERASE_ITERATE(set<TConnBase*>, it, m_Deferred) {
+        TConnBase* conn_base = *it;
+        conn_base->type_lock.Lock();
+        if (conn_base->type != eDeferredSocket) {
+            m_Deferred.erase(it);
+        }
+        else if (conn_base->IsReadyToProcess()) {
+            conn_base->type = eActiveSocket;
+            revived_conns.push_back(conn_base);
+            m_Deferred.erase(it);
+        }
+        conn_base->type_lock.Unlock();
+    }
+
+    m_Expired.clear();
+    m_Alarms.clear();
+    m_Reactor->ProcessTimers(now, m_Expired, m_Alarms);
+    ITERATE(vector<TConnBase*>, it, m_Expired) {
+        m_Data.erase(*it);
+        to_close_conns.push_back(*it);
+    }
+    ITERATE(vector<TConnBase*>, it, m_Alarms) {
+        TConnBase* conn_base = *it;
+        conn_base->type_lock.Lock();
+        if (conn_base->type == eInactiveSocket) {
+            conn_base->type = eActiveSocket;
+            timer_requests.push_back(conn_base);
+        }
+        conn_base->type_lock.Unlock();
+    }
+
+    return m_Reactor->GetTimerTimeout(now, timer_timeout);
+}
+
+EIO_Status CServer_ConnectionPool::WaitReactorEvents(vector<TReadyConn>& ready,
+                                                     const STimeout* timeout)
+{
+    m_ReactorEvents.clear();
+    EIO_Status status = m_Reactor->Wait(m_ReactorEvents, timeout);
+    if (status != eIO_Success)
+        return status;
+
+    CMutexGuard guard(m_Mutex);
+    ITERATE(vector<CServer_Reactor::SEvent>, it, m_ReactorEvents) {
+        EIO_Event events = m_Reactor->Activate(*it);
+        if (events == eIO_Open)
+            continue;
+        TConnBase* conn_base = it->conn;
+        conn_base->type_lock.Lock();
+        if (conn_base->type == eInactiveSocket) {
+            conn_base->type = eActiveSocket;
+            ready.push_back(TReadyConn(conn_base, events));
+        }
+        else if (conn_base->type == eListener) {
+            ready.push_back(TReadyConn(conn_base, events));
+            ++m_Stats.accepts;
+        }
+        conn_base->type_lock.Unlock();
+    }
+    return eIO_Success;
+}
+
 void CServer_ConnectionPool::SetAllActive(const vector<CSocketAPI::SPoll>& polls)
 {
     ITERATE(vector<CSocketAPI::SPoll>, it, polls) {
@@ -392,11 +593,41 @@ void CServer_ConnectionPool::SetAllActive(const vector<IServer_ConnectionBase*>&
 }
 
 
+void CServer_ConnectionPool::ShareListeners(CServer_ConnectionPool& other)
+{
+    vector<TConnBase*> listeners;
+    {{
+        CMutexGuard guard(m_Mutex);
+        ITERATE (TData, it, m_Data) {
+            CServer_Listener* listener = dynamic_cast<CServer_Listener*>(*it);
+            if (listener) {
+                TSOCK_Flags flags = listener->GetFlags() | fSOCK_ReusePort;
+                listener->SetFlags(flags);
+                listeners.push_back(new CServer_Listener(*listener, flags));
+            }
+        }
+    }}
+    ITERATE (vector<TConnBase*>, it, listeners) {
+        if ( !other.Add(*it, eListener) )
+            delete *it;
+    }
+}
+
+
+size_t CServer_ConnectionPool::GetSize(void) const
+{
+    CMutexGuard guard(m_Mutex);
+    return m_Data.size();
+}
+
+
 void CServer_ConnectionPool::StartListening(void)
 {
     CMutexGuard guard(m_Mutex);
     ITERATE (TData, it, m_Data) {
         (*it)->Activate();
+        if (m_Reactor.get())
+            m_ReactorChanges.push_back(*it);
     }
     m_ListeningStarted = true;
 }
@@ -35,6 +35,7 @@
 
 
 #include <connect/impl/server_connection.hpp>
+#include "server_reactor.hpp"
 
 
 /** @addtogroup ThreadedServer
@@ -85,6 +86,48 @@ public:
                             vector<IServer_ConnectionBase*>& to_close_conns,
                             vector<IServer_ConnectionBase*>& to_delete_conns);
 
+    /// Event-driven counterparts of GetPollAndTimerVec() and
+    /// CSocketAPI::Poll(), see CServer_Reactor.
+    typedef pair<IServer_ConnectionBase*, EIO_Event> TReadyConn;
+
+    /// Switch to the reactor backend.
+    /// @return
+    ///  false if the reactor is not supported or cannot be created.
+    bool EnableReactor(void);
+    bool HasReactor(void) const { return m_Reactor.get() != NULL; }
+
+    /// Process only the connections that changed state since the
+    /// previous call, and the timers that are due.
+    bool GetReactorChanges(vector<TReadyConn>& ready,
+                           vector<IServer_ConnectionBase*>& timer_requests,
+                           STimeout* timer_timeout,
+                           vector<IServer_ConnectionBase*>& revived_conns,
+                           vector<IServer_ConnectionBase*>& to_close_conns,
+                           vector<IServer_ConnectionBase*>& to_delete_conns);
+
+    /// Wait for socket events and mark the ready connections active.
+    EIO_Status WaitReactorEvents(vector<TReadyConn>& ready,
+                                 const STimeout* timeout);
+
+    /// Add listeners on the same ports to another pool.  All of them,
+    /// including this pool's, will listen with SO_REUSEPORT, so that the
+    /// kernel distributes incoming connections between the pools.
+    /// Must be called before StartListening().
+    void ShareListeners(CServer_ConnectionPool& other);
+
+    /// Statistics of the loop serving this pool, updated by that loop only
+    struct SStats {
+        SStats(void) : iterations(0), events(0), accepts(0), requests(0) { }
+        atomic<Uint8> iterations;   ///< Main loop iterations
+        atomic<Uint8> events;       ///< Ready sockets
+        atomic<Uint8> accepts;      ///< Events on listening sockets
+        atomic<Uint8> requests;     ///< Requests processed or queued
+    };
+    SStats& GetStats(void) { return m_Stats; }
+
+    /// Number of connections and listeners in the pool
+    size_t GetSize(void) const;
+
     void StartListening(void);
     void StopListening(void);
 
@@ -112,6 +155,19 @@ private:
     // The access to the container is protected with m_Mutex
     vector<unsigned short>  m_ListenerPortsToStop;
     bool                    m_ListeningStarted;
+
+    // Reactor backend: connections to (re)arm, close or delete, and
+    // deferred connections waiting for IsReadyToProcess().
+    // The access is protected with m_Mutex
+    unique_ptr<CServer_Reactor>         m_Reactor;
+    vector<TConnBase*>                  m_ReactorChanges;
+    vector<TConnBase*>                  m_ReactorChangesCopy;
+    set<TConnBase*>                     m_Deferred;
+    vector<CServer_Reactor::SEvent>     m_ReactorEvents;
+    vector<TConnBase*>                  m_Expired;
+    vector<TConnBase*>                  m_Alarms;
+
+    SStats                              m_Stats;
 };
 
 
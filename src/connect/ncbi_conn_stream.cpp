@@ -542,7 +542,8 @@ s_HttpConnectorBuilder(const SConnNetInfo* net_info,
                        void**              user_data_ptr,
                        FHTTP_Cleanup*      user_cleanup_ptr,
                        void*               user_data    = 0,
-                       FHTTP_Cleanup       user_cleanup = 0)
+                       FHTTP_Cleanup       user_cleanup = 0,
+                       HTTP_CONNPOOL       pool         = 0)
 {
     EReqMethod x_req_method;
     AutoPtr<SConnNetInfo> x_net_info(net_info
@@ -607,12 +608,13 @@ s_HttpConnectorBuilder(const SConnNetInfo* net_info,
     // NB: Must init these two here just in case of early CONNECTOR->destroy()
     *user_data_ptr    = user_data;
     *user_cleanup_ptr = user_cleanup;
-    CONNECTOR c = HTTP_CreateConnectorEx(x_net_info.get(),
-                                         flgs,
-                                         x_parse_header,
-                                         x_data,
-                                         x_adjust,
-                                         x_cleanup);
+    CONNECTOR c = HTTP_CreatePooledConnector(x_net_info.get(),
+                                             flgs,
+                                             x_parse_header,
+                                             x_data,
+                                             x_adjust,
+                                             x_cleanup,
+                                             pool);
     /* NOTE: if "c" is NULL here (could not create connector -- out of memory?)
      * then "user_data" (if any) is going to potentially leak because for the caller,
      * the stream contruction appears "successful" (no exception thrown), meaning if
@@ -745,6 +747,43 @@ CConn_HttpStream::CConn_HttpStream(const string&       url,
 }
 
 
+CConn_HttpStream::CConn_HttpStream(const string&       url,
+                                   const SConnNetInfo* net_info,
+                                   const string&       user_header,
+                                   FHTTP_ParseHeader   parse_header,
+                                   void*               user_data,
+                                   FHTTP_Adjust        adjust,
+                                   FHTTP_Cleanup       cleanup,
+                                   THTTP_Flags         flgs,
+                                   const STimeout*     timeout,
+                                   size_t              buf_size,
+                                   HTTP_CONNPOOL       pool)
+    : CConn_HttpStream_Base(s_HttpConnectorBuilder(net_info,
+                                                   eReqMethod_Any,
+                                                   url.c_str(),
+                                                   0,
+                                                   0,
+                                                   0,
+                                                   0,
+                                                   user_header.c_str(),
+                                                   this,
+                                                   sx_Adjust,
+                                                   cleanup ? sx_Cleanup : 0,
+                                                   sx_ParseHeader,
+                                                   flgs,
+                                                   timeout,
+                                                   &m_UserData,
+                                                   &m_UserCleanup,
+                                                   user_data,
+                                                   cleanup,
+                                                   pool),
+                            timeout, buf_size),
+      m_UserAdjust(adjust), m_UserParseHeader(parse_header)
+{
+    return;
+}
+
+
 CConn_HttpStream::CConn_HttpStream(const SConnNetInfo* net_info,
                                    const string&       user_header,
                                    FHTTP_ParseHeader   parse_header,
@@ -44,6 +44,10 @@
 BEGIN_NCBI_SCOPE
 
 
+static const size_t kMaxReadBufSize = 128 * 1024;  // adaptive growth limit
+static const size_t kPutbackSize    = 16;  // kept after reading directly
+
+
 /*ARGSUSED*/
 static inline bool x_IsThrowable(EIO_Status status)
 {
@@ -133,7 +137,8 @@ CConn_Streambuf::CConn_Streambuf(CONNECTOR                   connector,
                                  CT_CHAR_TYPE*               ptr,
                                  size_t                      size)
     : m_Conn(0), x_Connector(connector),
-      m_WriteBuf(0), m_ReadBuf(&x_Buf), m_BufSize(1), m_Status(status),
+      m_WriteBuf(0), m_ReadBuf(&x_Buf), m_BufSize(1),
+      x_BufSize(1), x_GrownBuf(0), x_FullReads(0), m_Status(status),
       m_Tie(false), m_Close(true), m_CbValid(false), m_Initial(false),
       x_Buf(), x_GPos((CT_OFF_TYPE)(ptr ? size : 0)), x_PPos((CT_OFF_TYPE)size)
 {
@@ -184,7 +189,8 @@ CConn_Streambuf::CConn_Streambuf(CONN                        conn,
                                  CT_CHAR_TYPE*               ptr,
                                  size_t                      size)
     : m_Conn(conn), x_Connector(0),
-      m_WriteBuf(0), m_ReadBuf(&x_Buf), m_BufSize(1), m_Status(eIO_Success),
+      m_WriteBuf(0), m_ReadBuf(&x_Buf), m_BufSize(1),
+      x_BufSize(1), x_GrownBuf(0), x_FullReads(0), m_Status(eIO_Success),
       m_Tie(false), m_Close(close), m_CbValid(false), m_Initial(false),
       x_Buf(), x_GPos((CT_OFF_TYPE)(ptr ? size : 0)), x_PPos((CT_OFF_TYPE)size)
 {
@@ -212,6 +218,7 @@ CConn_Streambuf::~CConn_Streambuf()
         x_Connector->destroy(x_Connector);
 
     delete[] m_WriteBuf;
+    delete[] x_GrownBuf;
 }
 
 
@@ -260,6 +267,7 @@ void CConn_Streambuf::x_Init(const STimeout* timeout, size_t buf_size,
         setp(write_buf, write_buf + buf_size);
     }/* else
         setp(0, 0) */
+    x_BufSize = m_BufSize;
 
     if (ptr) {
         m_Initial = true;
@@ -429,9 +437,13 @@ CNcbiStreambuf* CConn_Streambuf::setbuf(CT_CHAR_TYPE* buf, streamsize buf_size)
 
     delete[] m_WriteBuf;
     m_WriteBuf = 0;
+    delete[] x_GrownBuf;
+    x_GrownBuf = 0;
 
     m_ReadBuf  = &x_Buf;
     m_BufSize  = 1;
+    x_BufSize  = 1;
+    x_FullReads = 0;
 
     if (!m_Conn  ||  !m_Initial)
         setg(m_ReadBuf, m_ReadBuf, m_ReadBuf);
@@ -621,9 +633,11 @@ CT_INT_TYPE CConn_Streambuf::underflow(void)
 
     // read from connection
     size_t n_read;
+    x_GrowReadBuf();
     m_Status = CONN_Read(m_Conn, m_ReadBuf, m_BufSize,
                          &n_read, eIO_ReadPlain);
     _ASSERT(n_read <= m_BufSize);
+    x_CountRead(n_read);
     if (!n_read) {
         _ASSERT(m_Status != eIO_Success);
         if (m_Status != eIO_Closed) {
@@ -678,9 +692,12 @@ streamsize CConn_Streambuf::x_Read(CT_CHAR_TYPE* buf, streamsize m)
         n_read = 0;
 
     do {
-        // next, read from the connection
-        size_t     x_toread = !buf || (n  &&  n < m_BufSize) ? m_BufSize : n;
-        CT_CHAR_TYPE* x_buf = !buf || (       n < m_BufSize) ? m_ReadBuf : buf;
+        // next, read from the connection:  reads of at least the initial
+        // buffer size go directly to "buf" (even if the buffer has grown)
+        if (!buf  ||  (n  &&  n < x_BufSize))
+            x_GrowReadBuf();
+        size_t     x_toread = !buf || (n  &&  n < x_BufSize) ? m_BufSize : n;
+        CT_CHAR_TYPE* x_buf = !buf || (       n < x_BufSize) ? m_ReadBuf : buf;
         size_t       x_read;
 
         m_Status = CONN_Read(m_Conn, x_buf, x_toread,
@@ -700,6 +717,8 @@ streamsize CConn_Streambuf::x_Read(CT_CHAR_TYPE* buf, streamsize m)
         x_GPos += (CT_OFF_TYPE) x_read;
         // satisfy "usual backup condition", see standard: 27.5.2.4.3.13
         if (x_buf == m_ReadBuf) {
+            if (x_toread == m_BufSize)
+                x_CountRead(x_read);
             size_t xx_read = x_read;
             if (x_read > n)
                 x_read = n;
@@ -707,8 +726,9 @@ streamsize CConn_Streambuf::x_Read(CT_CHAR_TYPE* buf, streamsize m)
                 memcpy(buf, m_ReadBuf,  x_read);
             setg(m_ReadBuf, m_ReadBuf + x_read, m_ReadBuf + xx_read);
         } else {
+            // keep just a few bytes for putback, not to copy the data twice
             _ASSERT(x_read <= n);
-            size_t xx_read = x_read > m_BufSize ? m_BufSize : x_read;
+            size_t xx_read = min(x_read, min(m_BufSize, kPutbackSize));
             memcpy(m_ReadBuf, buf + x_read - xx_read, xx_read);
             setg(m_ReadBuf, m_ReadBuf + xx_read, m_ReadBuf + xx_read);
         }
@@ -726,6 +746,26 @@ streamsize CConn_Streambuf::x_Read(CT_CHAR_TYPE* buf, streamsize m)
 }
 
 
+// Double the read buffer (up to a limit) when reads keep filling it up, so
+// that bulk transfers take fewer CONN_Read() calls
+void CConn_Streambuf::x_GrowReadBuf(void)
+{
+    if (x_FullReads < 2  ||  m_ReadBuf == &x_Buf
+        ||  m_BufSize >= kMaxReadBufSize  ||  gptr() < egptr()) {
+        return;
+    }
+    size_t size = min(m_BufSize << 1, kMaxReadBufSize);
+    CT_CHAR_TYPE* buf = new(nothrow) CT_CHAR_TYPE[size];
+    if (!buf)
+        return;
+    delete[] x_GrownBuf;
+    m_ReadBuf = x_GrownBuf = buf;
+    m_BufSize = size;
+    x_FullReads = 0;
+    setg(m_ReadBuf, m_ReadBuf, m_ReadBuf);
+}
+
+
 streamsize CConn_Streambuf::xsgetn(CT_CHAR_TYPE* buf, streamsize m)
 {
     _ASSERT(gptr() <= gptr());
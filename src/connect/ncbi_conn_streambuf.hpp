@@ -129,6 +129,10 @@ protected:
 
     streamsize  x_Read(CT_CHAR_TYPE* buf, streamsize n);
 
+    void        x_GrowReadBuf(void);
+    void        x_CountRead(size_t n_read)
+    { x_FullReads = n_read < m_BufSize ? 0 : x_FullReads + 1; }
+
     EIO_Status  x_Pushback(void) THROWS_NONE;
 
 private:
@@ -138,6 +142,9 @@ private:
     CT_CHAR_TYPE*     m_WriteBuf;  // I/O arena (set as 0 if unbuffered)
     CT_CHAR_TYPE*     m_ReadBuf;   // read buffer or &x_Buf (if unbuffered)
     size_t            m_BufSize;   // of m_ReadBuf (1 if unbuffered)
+    size_t            x_BufSize;   // initial m_BufSize (direct read cutoff)
+    CT_CHAR_TYPE*     x_GrownBuf;  // m_ReadBuf when grown (0 otherwise)
+    unsigned int      x_FullReads; // successive reads that filled m_ReadBuf
 
     EIO_Status        m_Status;    // status of last I/O completed by CONN
 
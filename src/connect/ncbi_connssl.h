@@ -133,6 +133,25 @@ struct SOCKSSL_struct {
 };
 
 
+/* Client session resumption cache (see <connect/ncbi_tls.h>) for providers:
+ * NcbiTlsSessionKey() returns a key (to free() by the caller) for "ctx" of a
+ * client session of "provider", or 0 if the cache is disabled (or the session
+ * uses client credentials);
+ * NcbiTlsSessionGet() returns a copy of the cached session data (to free() by
+ * the caller) in the provider's own serialized format, or 0 if none;
+ * NcbiTlsSessionPut() caches session data ("once" is for single-use tickets);
+ * NcbiTlsSessionDone() accounts for a completed client handshake.
+ */
+char* NcbiTlsSessionKey (const char* provider, const SNcbiSSLctx* ctx);
+
+void* NcbiTlsSessionGet (const char* key, size_t* size);
+
+void  NcbiTlsSessionPut (const char* key, const void* data, size_t size,
+                         int/*bool*/ once);
+
+void  NcbiTlsSessionDone(int/*bool*/ resumed);
+
+
 /* Internal certificate credentials management routines */
 
 #if defined(HAVE_LIBMBEDTLS)  ||  defined(NCBI_CXX_TOOLKIT)
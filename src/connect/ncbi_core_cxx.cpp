@@ -41,9 +41,11 @@
 #include <corelib/ncbi_param.hpp>
 #include <corelib/request_ctx.hpp>
 #include <corelib/ncbi_safe_static.hpp>
+#include <corelib/ncbithr.hpp>
 #include <connect/error_codes.hpp>
 #include <connect/ncbi_core_cxx.hpp>
 #include <connect/ncbi_monkey.hpp>
+#include <connect/ncbi_service.h>
 #include <connect/ncbi_util.h>
 #include <common/ncbi_sanitizers.h>
 
@@ -629,20 +631,130 @@ static void s_SetMonkeyHooks(EMonkeyHookSwitch hook_switch)
 #endif //NCBI_MONKEY
 
 
+/***********************************************************************
+ *                       Service Cache Refresher                       *
+ ***********************************************************************/
+
+
+// Refreshes due entries of the service resolution cache in a thread of its
+// own, so that the callers hitting the cache do not wait for resolutions.
+// The thread gets started on first demand, and stopped at exit (before the
+// static data destruction), after which the callers refresh the entries.
+class CServiceCacheRefresher : public CThread
+{
+public:
+    CServiceCacheRefresher(void)
+        : m_Wakeup(0, 1), m_Pending(false), m_Stop(false)
+    { }
+
+    // Wake the thread up, unless it is to wake up already
+    void Schedule(void)
+    {
+        if (!m_Pending.exchange(true))
+            m_Wakeup.Post();
+    }
+
+    void Stop(void)
+    {
+        m_Stop = true;
+        Schedule();
+    }
+
+protected:
+    virtual void* Main(void)
+    {
+        for (;;) {
+            m_Wakeup.Wait();
+            if (m_Stop)
+                break;
+            m_Pending = false;
+            SERV_RefreshCache();
+        }
+        return 0;
+    }
+
+private:
+    CSemaphore   m_Wakeup;
+    atomic<bool> m_Pending;
+    atomic<bool> m_Stop;
+};
+
+DEFINE_STATIC_FAST_MUTEX(s_ServiceCacheRefresherMutex);
+static CServiceCacheRefresher* s_ServiceCacheRefresher = 0;
+static bool                    s_ServiceCacheRefresherExit = false;
+
+
+extern "C" {
+static void s_StopServiceCacheRefresher(void)
+{
+    CServiceCacheRefresher* refresher;
+    {{
+        CFastMutexGuard guard(s_ServiceCacheRefresherMutex);
+        refresher = s_ServiceCacheRefresher;
+        s_ServiceCacheRefresher = 0;
+        s_ServiceCacheRefresherExit = true;
+    }}
+    if (refresher) {
+        refresher->Stop();
+        refresher->Join();
+        refresher->RemoveReference();
+    }
+}
+
+
+static void s_ScheduleServiceCacheRefresh(void)
+{
+    {{
+        CFastMutexGuard guard(s_ServiceCacheRefresherMutex);
+        if (!s_ServiceCacheRefresher  &&  !s_ServiceCacheRefresherExit) {
+            // the thread must be stopped before static data destruction
+            static bool s_AtExit = false;
+            if (!s_AtExit  &&  atexit(s_StopServiceCacheRefresher) == 0)
+                s_AtExit = true;
+            if (s_AtExit) {
+                CRef<CServiceCacheRefresher> refresher
+                    (new CServiceCacheRefresher);
+                try {
+                    refresher->Run();
+                    refresher->AddReference();  // released when stopped
+                    s_ServiceCacheRefresher = refresher.GetPointer();
+                }
+                catch (exception& e) {
+                    ERR_POST_X(12, Warning
+                               << "Cannot start service cache refresher: "
+                               << e.what());
+                }
+            }
+        }
+        if (s_ServiceCacheRefresher) {
+            s_ServiceCacheRefresher->Schedule();
+            return;
+        }
+    }}
+    SERV_RefreshCache();
+}
+}
+
+
 #ifdef NCBI_POSIX_THREADS
 extern "C" {
 static void x_PreFork(void)
 {
     CORE_LOCK_WRITE;
+    s_ServiceCacheRefresherMutex.Lock();
 }
 
 static void x_PostForkParent(void)
 {
+    s_ServiceCacheRefresherMutex.Unlock();
     CORE_UNLOCK;
 }
 
 static void x_PostForkChild(void)
 {
+    // The refresher thread does not exist in the child (its object leaks)
+    s_ServiceCacheRefresher = 0;
+    s_ServiceCacheRefresherMutex.Unlock();
     extern bool g_CorelibDaemonize;
     if (g_CorelibDaemonize)
         CORE_UNLOCK;
@@ -764,6 +876,7 @@ static void s_Init(const IRWRegistry* reg  = 0,
     g_CORE_GetReferer     = s_GetReferer;
     g_CORE_GetRequestID   = s_GetRequestID;
     g_CORE_GetRequestDtab = s_GetRequestDTab;
+    SERV_SetCacheRefresher(s_ScheduleServiceCacheRefresh);
 
 #ifdef NCBI_MONKEY
     /* Allow CMonkey to switch hooks to Connect library */
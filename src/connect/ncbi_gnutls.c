@@ -364,6 +364,7 @@ static void* s_GnuTlsCreate(ESOCK_Side side, SNcbiSSLctx* ctx, int* error)
     gnutls_session_t session;
     char val[128];
     size_t len;
+    char* key;
     int err;
 
     CORE_DEBUG_ARG(if (s_GnuTlsLogLevel))
@@ -441,6 +442,17 @@ static void* s_GnuTlsCreate(ESOCK_Side side, SNcbiSSLctx* ctx, int* error)
     gnutls_handshake_set_timeout(session, 0);
 #  endif /*LIBGNUTLS_VERSION_NUMBER>=3.0.0*/
 
+    if ((key = NcbiTlsSessionKey("GNUTLS", ctx)) != 0) {
+        void* data;
+        size_t size;
+        if ((data = NcbiTlsSessionGet(key, &size)) != 0) {
+            (void) gnutls_session_set_data(session, data, size);
+            free(data);
+        }
+    }
+    /* NB: the session's user pointer is the session cache key, if any */
+    gnutls_session_set_ptr(session, key);
+
 out:
     CORE_DEBUG_ARG(if (s_GnuTlsLogLevel))
         CORE_TRACEF(("GnuTlsCreate(): Leave(%p)", session));
@@ -449,6 +461,29 @@ out:
 }
 
 
+/* TLS 1.3 tickets come after the handshake, see s_GnuTlsDelete() */
+static int/*bool*/ x_IsTls13(gnutls_session_t session)
+{
+#  if LIBGNUTLS_VERSION_NUMBER >= 0x030603
+    return gnutls_protocol_get_version(session) == GNUTLS_TLS1_3;
+#  else
+    return 0/*false*/;
+#  endif /*LIBGNUTLS_VERSION_NUMBER>=3.6.3*/
+}
+
+
+/* Save the established session (or the last received ticket) for resumption */
+static void x_GnuTlsSave(gnutls_session_t session, const char* key,
+                         int/*bool*/ once)
+{
+    gnutls_datum_t data;
+    if (gnutls_session_get_data2(session, &data) == GNUTLS_E_SUCCESS) {
+        NcbiTlsSessionPut(key, data.data, data.size, once);
+        gnutls_free(data.data);
+    }
+}
+
+
 static EIO_Status s_GnuTlsOpen(void* session, int* error, char** desc)
 {
     EIO_Status status;
@@ -470,6 +505,12 @@ static EIO_Status s_GnuTlsOpen(void* session, int* error, char** desc)
         if (desc)
             *desc = 0;
     } else {
+        const char* key
+            = (const char*) gnutls_session_get_ptr((gnutls_session_t) session);
+        NcbiTlsSessionDone(gnutls_session_is_resumed((gnutls_session_t)
+                                                     session));
+        if (key  &&  !x_IsTls13((gnutls_session_t) session))
+            x_GnuTlsSave((gnutls_session_t) session, key, 0/*reusable*/);
         status = eIO_Success;
         if (desc) {
 #  if LIBGNUTLS_VERSION_NUMBER >= 0x030110
@@ -699,11 +740,24 @@ static EIO_Status s_GnuTlsClose(void* session, int how, int* error)
 
 static void s_GnuTlsDelete(void* session)
 {
+    char* key;
+
     assert(session);
 
     CORE_DEBUG_ARG(if (s_GnuTlsLogLevel))
         CORE_TRACEF(("GnuTlsDelete(%p): Enter", session));
 
+    if ((key = (char*) gnutls_session_get_ptr((gnutls_session_t) session))) {
+#  if LIBGNUTLS_VERSION_NUMBER >= 0x030603
+        if (x_IsTls13((gnutls_session_t) session)
+            &&  (gnutls_session_get_flags((gnutls_session_t) session)
+                 & GNUTLS_SFLAGS_SESSION_TICKET)) {
+            x_GnuTlsSave((gnutls_session_t) session, key, 1/*once*/);
+        }
+#  endif /*LIBGNUTLS_VERSION_NUMBER>=3.6.3*/
+        free(key);
+    }
+
     gnutls_deinit((gnutls_session_t) session);
 
     CORE_DEBUG_ARG(if (s_GnuTlsLogLevel))
@@ -31,6 +31,7 @@
 
 #include "ncbi_http2_session_impl.hpp"
 
+#include <corelib/ncbi_param.hpp>
 #include <corelib/rwstream.hpp>
 
 
@@ -86,16 +87,24 @@ const char* SH2S_Event<TBase>::GetTypeName() const
 
 SH2S_ReaderWriter::SH2S_ReaderWriter(TUpdateResponse update_response, shared_ptr<TH2S_ResponseQueue> response_queue, TH2S_RequestEvent request) :
     m_Io(SH2S_Io::GetInstance()),
+    m_Loop(m_Io->GetLoop(request.GetStart().url)),
     m_UpdateResponse(update_response),
     m_ResponseQueue(std::move(response_queue))
 {
     _ASSERT(m_UpdateResponse);
 
+    ++m_Loop.load;
+
     Push(std::move(request));
 
     Process();
 }
 
+SH2S_ReaderWriter::~SH2S_ReaderWriter()
+{
+    --m_Loop.load;
+}
+
 ERW_Result SH2S_ReaderWriter::Write(const void* buf, size_t count, size_t* bytes_written)
 {
     if (m_State != eWriting) {
@@ -500,6 +509,55 @@ int SH2S_Session::OnFrameRecv(nghttp2_session*, const nghttp2_frame *frame)
     return 0;
 }
 
+NCBI_PARAM_DECL(unsigned, HTTP2, IO_LOOPS);
+NCBI_PARAM_DEF_EX(unsigned, HTTP2, IO_LOOPS, 1, eParam_NoThread, HTTP2_IO_LOOPS);
+
+NCBI_PARAM_DECL(string, HTTP2, IO_LOOP_SELECTION);
+NCBI_PARAM_DEF_EX(string, HTTP2, IO_LOOP_SELECTION, "least_loaded", eParam_NoThread, HTTP2_IO_LOOP_SELECTION);
+
+SH2S_Io::SH2S_Io() :
+    m_Selection(eLeastLoaded)
+{
+    auto loops = NCBI_PARAM_TYPE(HTTP2, IO_LOOPS)::GetDefault();
+    auto selection = NCBI_PARAM_TYPE(HTTP2, IO_LOOP_SELECTION)::GetDefault();
+
+    if (NStr::EqualNocase(selection, "authority")) {
+        m_Selection = eAuthority;
+    } else if (!NStr::EqualNocase(selection, "least_loaded")) {
+        ERR_POST(Warning << "Unknown [HTTP2]IO_LOOP_SELECTION value '" << selection << "', using least_loaded");
+    }
+
+    m_Loops.resize(max(loops, 1u));
+
+    for (auto& loop : m_Loops) {
+        loop.reset(new SH2S_IoLoop);
+    }
+}
+
+SH2S_IoLoop& SH2S_Io::GetLoop(const CUrl& url)
+{
+    if (m_Loops.size() == 1) {
+        return *m_Loops.front();
+    }
+
+    if (m_Selection == eAuthority) {
+        // Sessions (connections) to a server are shared by its requests only within a loop
+        auto authority = url.GetScheme() + "://" + url.GetHost() + ':' + url.GetPort();
+        return *m_Loops[hash<string>()(authority) % m_Loops.size()];
+    }
+
+    // Not exact, as loads may change concurrently, but good enough for balancing
+    auto least_loaded = m_Loops.begin();
+
+    for (auto it = least_loaded + 1; it != m_Loops.end(); ++it) {
+        if ((*it)->load < (*least_loaded)->load) {
+            least_loaded = it;
+        }
+    }
+
+    return **least_loaded;
+}
+
 SH2S_IoCoordinator::SH2S_IoCoordinator() :
     m_Proxy(SSocketAddress::Parse(CNcbiEnvironment().Get("HTTP_PROXY"), SSocketAddress::SHost::EName::eOriginal))
 {
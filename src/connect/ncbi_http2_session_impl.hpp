@@ -35,6 +35,7 @@
 
 #include <corelib/reader_writer.hpp>
 
+#include <atomic>
 #include <map>
 #include <queue>
 #include <unordered_map>
@@ -245,10 +246,27 @@ private:
     SSocketAddress m_Proxy;
 };
 
-struct SH2S_Io
+// One I/O loop: the requests for it and the sessions it serves.
+// The loop is driven by the threads of its readers/writers,
+// so different loops can do framing and TLS in parallel.
+struct SH2S_IoLoop
 {
     TH2S_RequestQueue request_queue;
     SThreadSafe<SH2S_IoCoordinator> coordinator;
+    atomic<size_t> load{0};  // Readers/writers using this loop
+};
+
+struct SH2S_Io
+{
+    // How requests are distributed between loops
+    enum ESelection {
+        eLeastLoaded,  // Loop with the fewest active requests
+        eAuthority,    // Same host and port go to the same loop
+    };
+
+    SH2S_Io();
+
+    SH2S_IoLoop& GetLoop(const CUrl& url);
 
     static shared_ptr<SH2S_Io> GetInstance()
     {
@@ -264,6 +282,10 @@ struct SH2S_Io
 
         return rv;
     }
+
+private:
+    vector<unique_ptr<SH2S_IoLoop>> m_Loops;
+    ESelection m_Selection;
 };
 
 struct SH2S_ReaderWriter : IReaderWriter
@@ -271,6 +293,7 @@ struct SH2S_ReaderWriter : IReaderWriter
     using TUpdateResponse = function<void(CHttpHeaders::THeaders)>;
 
     SH2S_ReaderWriter(TUpdateResponse update_response, shared_ptr<TH2S_ResponseQueue> response_queue, TH2S_RequestEvent request);
+    ~SH2S_ReaderWriter() override;
 
     ERW_Result Read(void* buf, size_t count, size_t* bytes_read = 0) override
     {
@@ -299,12 +322,13 @@ private:
     void Push(TH2S_RequestEvent event)
     {
         H2S_RW_TRACE(m_ResponseQueue.get() << " push " << event);
-        m_Io->request_queue.GetLock()->emplace(std::move(event));
+        m_Loop.request_queue.GetLock()->emplace(std::move(event));
     }
 
-    void Process() { m_Io->coordinator.GetLock()->Process(m_Io->request_queue); }
+    void Process() { m_Loop.coordinator.GetLock()->Process(m_Loop.request_queue); }
 
     shared_ptr<SH2S_Io> m_Io;
+    SH2S_IoLoop& m_Loop;
     TUpdateResponse m_UpdateResponse;
     shared_ptr<TH2S_ResponseQueue> m_ResponseQueue;
     TH2S_Data m_OutgoingData;
@@ -42,12 +42,16 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <time.h>
 
 #define NCBI_USE_ERRCODE_X   Connect_HTTP
 
 
 #define HTTP_SOAK_READ_SIZE  16384
 
+#define HTTP_POOL_MAX_IDLE   8   /* idle connections per destination       */
+#define HTTP_POOL_IDLE_TIME  30  /* seconds an idle connection can be kept */
+
 
 /***********************************************************************
  *  INTERNAL -- Auxiliary types and static functions
@@ -104,6 +108,24 @@ typedef struct {
 } SRetry;
 
 
+/* Idle connection kept in a pool */
+typedef struct SHttpIdleConn {
+    struct SHttpIdleConn* next;       /* next (less recently used) one       */
+    SOCK                  sock;       /* connection, ready for next request  */
+    time_t                expires;    /* time to close it at, 0 if never     */
+    char                  key[1];     /* destination, see x_ConnPoolKey()    */
+} SHttpIdleConn;
+
+struct SHttpConnPool {
+    unsigned int          refcnt;     /* the handle plus connectors using it */
+    unsigned int          max_idle;   /* idle connections per destination    */
+    unsigned int          idle_time;  /* max time to stay idle (if expire)   */
+    int/*bool*/           expire;     /* whether idle connections expire     */
+    SHttpIdleConn*        idle;       /* idle connections, MRU first         */
+    SHTTP_ConnPoolStats   stats;      /* pool statistics                     */
+};
+
+
 /* All internal data necessary to perform the (re)connect and I/O.
  *
  *  The following connection states are defined:                    |  sock?
@@ -145,6 +167,7 @@ typedef struct {
     const char*       vhost;          /* VHost in the request                */
 
     SOCK              sock;           /* socket;  NULL if not connected      */
+    HTTP_CONNPOOL     pool;           /* connection pool (if any)            */
     const STimeout*   o_timeout;      /* NULL(infinite), dflt or ptr to next */
     STimeout          oo_timeout;     /* storage for (finite) open timeout   */
     const STimeout*   w_timeout;      /* NULL(infinite), dflt or ptr to next */
@@ -858,6 +881,178 @@ static void x_SetRequestIDs(SConnNetInfo* net_info)
 }
 
 
+/* Destination that a pooled connection can be re-used for */
+static char* x_ConnPoolKey(SHttpConnector* uuu)
+{
+    const SConnNetInfo* net_info = uuu->net_info;
+    char*               key;
+
+    /* NB: Host: tag is the SNI for secure connections */
+    if (!uuu->vhost  &&  !(uuu->vhost = x_SetHttpHostTag(uuu->net_info)))
+        return 0;
+    if (!(key = (char*) malloc(strlen(net_info->host)
+                               + strlen(net_info->http_proxy_host)
+                               + strlen(uuu->vhost) + 80))) {
+        return 0;
+    }
+    /* NB: no credentials here, such connectors are not pooled */
+    sprintf(key, "%s://%s:%hu|%s:%hu|%s",
+            net_info->scheme == eURL_Https ? "https" : "http",
+            net_info->host,
+            x_PortForScheme(net_info->port, net_info->scheme),
+            net_info->http_proxy_host, net_info->http_proxy_port,
+            uuu->vhost);
+    return key;
+}
+
+
+static void x_ConnPoolClose(SHttpIdleConn* conn)
+{
+    while (conn) {
+        SHttpIdleConn* next = conn->next;
+        SOCK_SetTimeout(conn->sock, eIO_Close, &kZeroTimeout);
+        SOCK_Close(conn->sock);
+        free(conn);
+        conn = next;
+    }
+}
+
+
+/* Unlink and return all expired idle connections;  must be called locked */
+static SHttpIdleConn* x_ConnPoolExpire(HTTP_CONNPOOL pool, time_t now)
+{
+    SHttpIdleConn* conn, **prev = &pool->idle, *drop = 0;
+
+    while ((conn = *prev) != 0) {
+        if (pool->expire  &&  conn->expires <= now) {
+            *prev = conn->next;
+            conn->next = drop;
+            drop = conn;
+            pool->stats.expired++;
+            pool->stats.idle--;
+        } else
+            prev = &conn->next;
+    }
+    return drop;
+}
+
+
+/* Take a healthy idle connection to the connector's destination, if any */
+static SOCK x_ConnPoolGet(SHttpConnector* uuu)
+{
+    HTTP_CONNPOOL  pool = uuu->pool;
+    SHttpIdleConn* conn = 0, *drop, **prev;
+    SOCK           sock = 0;
+    char*          key;
+
+    if (!(key = x_ConnPoolKey(uuu)))
+        return 0;
+
+    do {
+        CORE_LOCK_WRITE;
+        if (conn) {
+            /* the previous candidate has failed the health check */
+            pool->stats.stale++;
+        }
+        drop = x_ConnPoolExpire(pool, time(0));
+        for (prev = &pool->idle;  (conn = *prev) != 0;  prev = &conn->next) {
+            if (strcmp(conn->key, key) == 0) {
+                *prev = conn->next;
+                conn->next = 0;
+                pool->stats.idle--;
+                break;
+            }
+        }
+        if (!conn)
+            pool->stats.misses++;
+        CORE_UNLOCK;
+
+        x_ConnPoolClose(drop);
+        if (!conn)
+            break;
+        /* any pending input (incl. EOF) on an idle connection is fatal */
+        if (SOCK_Wait(conn->sock, eIO_Read, &kZeroTimeout) == eIO_Timeout) {
+            sock = conn->sock;
+            free(conn);
+            CORE_LOCK_WRITE;
+            pool->stats.hits++;
+            CORE_UNLOCK;
+        } else
+            x_ConnPoolClose(conn);
+    } while (!sock);
+
+    free(key);
+    return sock;
+}
+
+
+/* Put the connector's connection to the pool;  return 0 if that's not done */
+static int/*bool*/ x_ConnPoolPut(SHttpConnector* uuu)
+{
+    HTTP_CONNPOOL  pool = uuu->pool;
+    SHttpIdleConn* conn, *drop, *next;
+    unsigned int   count;
+    time_t         now;
+    size_t         len;
+    char*          key;
+
+    if (!(key = x_ConnPoolKey(uuu)))
+        return 0/*false*/;
+    len = strlen(key);
+    conn = (SHttpIdleConn*) malloc(sizeof(*conn) + len);
+    if (conn) {
+        conn->sock = uuu->sock;
+        memcpy(conn->key, key, len + 1);
+    }
+    free(key);
+    if (!conn)
+        return 0/*false*/;
+
+    now = time(0);
+    CORE_LOCK_WRITE;
+    drop = x_ConnPoolExpire(pool, now);
+    count = 0;
+    for (next = pool->idle;  next;  next = next->next) {
+        if (strcmp(next->key, conn->key) == 0)
+            ++count;
+    }
+    if (count < pool->max_idle) {
+        conn->expires = now + (time_t) pool->idle_time;
+        conn->next = pool->idle;
+        pool->idle = conn;
+        pool->stats.idle++;
+        pool->stats.released++;
+    } else {
+        pool->stats.overflow++;
+        free(conn);
+        conn = 0;
+    }
+    CORE_UNLOCK;
+
+    x_ConnPoolClose(drop);
+    return conn ? 1/*true*/ : 0/*false*/;
+}
+
+
+static void x_ConnPoolUnref(HTTP_CONNPOOL pool)
+{
+    SHttpIdleConn* drop;
+    unsigned int   refcnt;
+
+    CORE_LOCK_WRITE;
+    if (!(refcnt = --pool->refcnt)) {
+        drop = pool->idle;
+        pool->idle = 0;
+    } else
+        drop = 0;
+    CORE_UNLOCK;
+
+    x_ConnPoolClose(drop);
+    if (!refcnt)
+        free(pool);
+}
+
+
 /*ARGSUSED*/
 static int s_TunnelAdjust(SConnNetInfo* net_info, void* data, unsigned int arg)
 {
@@ -919,6 +1114,10 @@ static EIO_Status s_Connect(SHttpConnector* uuu,
                : fSOCK_KeepAlive | fSOCK_LogDefault);
         sock = uuu->sock;
         uuu->sock = 0;
+        if (!sock  &&  uuu->pool
+            &&  uuu->net_info->req_method != eReqMethod_Connect) {
+            sock = x_ConnPoolGet(uuu);
+        }
         uuu->reused = sock ? 1/*true*/ : 0/*false*/;
         if ((!sock  ||  !SOCK_IsSecure(sock))
             &&  uuu->net_info->req_method != eReqMethod_Connect
@@ -2441,6 +2640,8 @@ static void s_DestroyHttpConnector(SHttpConnector* uuu)
     assert(!uuu->sock);
     if (uuu->cleanup)
         uuu->cleanup(uuu->user_data);
+    if (uuu->pool)
+        x_ConnPoolUnref(uuu->pool);
     ConnNetInfo_Destroy(uuu->net_info);
     if (uuu->vhost)
         free((void*) uuu->vhost);
@@ -2744,6 +2945,20 @@ static EIO_Status s_VT_Close
         /* "WRITE" mode and data (or just flag) is still pending */
         s_PreRead(uuu, timeout, eEM_Drop);
     }
+    /* return the connection to the pool if the response has been read out */
+    if (uuu->pool  &&  uuu->sock  &&  uuu->keepalive
+        &&  uuu->net_info->req_method != eReqMethod_Connect) {
+        if (uuu->conn_state == eCS_DoneBody) {
+            /* complete the message (e.g. read the trailer of chunked body) */
+            size_t n_read = 0;
+            char   x_buf;
+            SOCK_SetTimeout(uuu->sock, eIO_Read, timeout);
+            s_Read(uuu, &x_buf, sizeof(x_buf), &n_read);
+            assert(!n_read);
+        }
+        if (uuu->sock  &&  uuu->conn_state == eCS_Eom  &&  x_ConnPoolPut(uuu))
+            uuu->sock = 0;
+    }
     s_Disconnect(uuu, timeout, eEM_Drop);
     assert(!uuu->sock);
 
@@ -2944,6 +3159,7 @@ static EIO_Status s_CreateHttpConnector
     uuu->reserved     = 0;
 
     uuu->sock         = 0;
+    uuu->pool         = 0;
     uuu->o_timeout    = kDefaultTimeout;  /* deliberately bad values here... */
     uuu->w_timeout    = kDefaultTimeout;  /* ...must be reset prior to use   */
     uuu->http         = 0;
@@ -2967,7 +3183,8 @@ static CONNECTOR s_CreateConnector
  FHTTP_ParseHeader   parse_header,
  void*               user_data,
  FHTTP_Adjust        adjust,
- FHTTP_Cleanup       cleanup)
+ FHTTP_Cleanup       cleanup,
+ HTTP_CONNPOOL       pool)
 {
     SHttpConnector* uuu;
     CONNECTOR       ccc;
@@ -2987,6 +3204,14 @@ static CONNECTOR s_CreateConnector
     /* initialize additional internal data structure */
     uuu->parse_header = parse_header;
     uuu->cleanup      = cleanup;
+    /* Connections with TLS credentials are not pooled:  the credentials
+     * handle identifies nothing once released (its address can be reused) */
+    if (pool  &&  !uuu->net_info->credentials) {
+        CORE_LOCK_WRITE;
+        pool->refcnt++;
+        CORE_UNLOCK;
+        uuu->pool     = pool;
+    }
 
     /* enable an override from outside */
     if (!uuu->unsafe_redir)
@@ -3012,7 +3237,7 @@ extern CONNECTOR HTTP_CreateConnector
  const char*         user_header,
  THTTP_Flags         flags)
 {
-    return s_CreateConnector(net_info, user_header, flags, 0, 0, 0, 0);
+    return s_CreateConnector(net_info, user_header, flags, 0, 0, 0, 0, 0);
 }
 
 
@@ -3025,7 +3250,21 @@ extern CONNECTOR HTTP_CreateConnectorEx
  FHTTP_Cleanup       cleanup)
 {
     return s_CreateConnector(net_info, 0/*user_header*/, flags,
-                             parse_header, user_data, adjust, cleanup);
+                             parse_header, user_data, adjust, cleanup, 0);
+}
+
+
+extern CONNECTOR HTTP_CreatePooledConnector
+(const SConnNetInfo* net_info,
+ THTTP_Flags         flags,
+ FHTTP_ParseHeader   parse_header,
+ void*               user_data,
+ FHTTP_Adjust        adjust,
+ FHTTP_Cleanup       cleanup,
+ HTTP_CONNPOOL       pool)
+{
+    return s_CreateConnector(net_info, 0/*user_header*/, flags,
+                             parse_header, user_data, adjust, cleanup, pool);
 }
 
 
@@ -3101,6 +3340,67 @@ extern EIO_Status HTTP_CreateTunnel
 }
 
 
+extern HTTP_CONNPOOL HTTP_CreateConnPool(unsigned int    max_idle,
+                                         const STimeout* idle_timeout)
+{
+    HTTP_CONNPOOL pool = (HTTP_CONNPOOL) calloc(1, sizeof(*pool));
+    if (pool) {
+        pool->refcnt   = 1;
+        pool->max_idle = max_idle ? max_idle : HTTP_POOL_MAX_IDLE;
+        if (idle_timeout == kDefaultTimeout) {
+            pool->idle_time = HTTP_POOL_IDLE_TIME;
+            pool->expire    = 1/*true*/;
+        } else if (idle_timeout) {
+            pool->idle_time = idle_timeout->sec + !!idle_timeout->usec;
+            pool->expire    = 1/*true*/;
+        }
+    }
+    return pool;
+}
+
+
+extern void HTTP_FlushConnPool(HTTP_CONNPOOL pool)
+{
+    SHttpIdleConn* drop;
+
+    CORE_LOCK_WRITE;
+    drop = pool->idle;
+    pool->idle = 0;
+    memset(&pool->stats, 0, sizeof(pool->stats));
+    CORE_UNLOCK;
+
+    x_ConnPoolClose(drop);
+}
+
+
+extern void HTTP_GetConnPoolStats(HTTP_CONNPOOL        pool,
+                                  SHTTP_ConnPoolStats* stats)
+{
+    CORE_LOCK_READ;
+    *stats = pool->stats;
+    CORE_UNLOCK;
+}
+
+
+extern void HTTP_DestroyConnPool(HTTP_CONNPOOL pool)
+{
+    SHttpIdleConn* drop;
+
+    if (!pool)
+        return;
+    CORE_LOCK_WRITE;
+    /* connectors still using the pool will no longer return connections */
+    pool->max_idle = 0;
+    drop = pool->idle;
+    pool->idle = 0;
+    pool->stats.idle = 0;
+    CORE_UNLOCK;
+
+    x_ConnPoolClose(drop);
+    x_ConnPoolUnref(pool);
+}
+
+
 extern void HTTP_SetNcbiMessageHook(FHTTP_NcbiMessageHook hook)
 {
     if (hook) {
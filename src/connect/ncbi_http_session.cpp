@@ -35,6 +35,7 @@
 #include "ncbi_ansi_ext.h"
 #include "ncbi_servicep.h"
 #include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_param.hpp>
 #include <corelib/request_ctx.hpp>
 #include <corelib/ncbimtx.hpp>
 #include <corelib/ncbistr.hpp>
@@ -896,7 +897,11 @@ void CHttpRequest::x_InitConnection(bool use_form_data)
             sx_Adjust,
             s_Cleanup,
             // Always set AdjustOnRedirect flag - to send correct cookies.
-            m_Session->GetHttpFlags() | fHTTP_AdjustOnRedirect));
+            m_Session->GetHttpFlags() | fHTTP_AdjustOnRedirect,
+            kDefaultTimeout,
+            kConn_DefaultBufSize,
+            // Keep-alive connections are re-used throughout the session.
+            m_Session->m_ConnPool.get()));
     }
     else {
         // Try to resolve service name.
@@ -1131,10 +1136,60 @@ void CHttpRequest::SetParam(const CHttpParam& param)
 //
 
 
+// Max idle persistent connections per host kept by a session,
+// 0 (default) = no pool
+NCBI_PARAM_DECL  (unsigned int, CONN, HTTP_POOL_MAX_IDLE);
+NCBI_PARAM_DEF_EX(unsigned int, CONN, HTTP_POOL_MAX_IDLE,
+                  0, eParam_Default, CONN_HTTP_POOL_MAX_IDLE);
+
+// Seconds for an idle persistent connection to stay in the session's pool
+NCBI_PARAM_DECL  (double, CONN, HTTP_POOL_IDLE_TIMEOUT);
+NCBI_PARAM_DEF_EX(double, CONN, HTTP_POOL_IDLE_TIMEOUT,
+                  30.0, eParam_Default, CONN_HTTP_POOL_IDLE_TIMEOUT);
+
+
+static HTTP_CONNPOOL s_CreateConnPool(void)
+{
+    unsigned int max_idle = NCBI_PARAM_TYPE(CONN, HTTP_POOL_MAX_IDLE)::GetDefault();
+    if ( !max_idle ) {
+        return 0;
+    }
+    STimeout idle_timeout;
+    CTimeout(NCBI_PARAM_TYPE(CONN, HTTP_POOL_IDLE_TIMEOUT)::GetDefault())
+        .Get(&idle_timeout.sec, &idle_timeout.usec);
+    HTTP_CONNPOOL pool = HTTP_CreateConnPool(max_idle, &idle_timeout);
+    if ( !pool ) {
+        ERR_POST_ONCE(Warning << "Unable to create HTTP connection pool");
+    }
+    return pool;
+}
+
+
 CHttpSession_Base::CHttpSession_Base(EProtocol protocol)
     : m_Protocol(protocol),
-      m_HttpFlags(0)
+      m_HttpFlags(0),
+      m_ConnPool(s_CreateConnPool(), HTTP_DestroyConnPool)
+{
+}
+
+
+SHTTP_ConnPoolStats CHttpSession_Base::GetConnPoolStats(void) const
+{
+    SHTTP_ConnPoolStats stats;
+    if ( m_ConnPool ) {
+        HTTP_GetConnPoolStats(m_ConnPool.get(), &stats);
+    } else {
+        memset(&stats, 0, sizeof(stats));
+    }
+    return stats;
+}
+
+
+void CHttpSession_Base::FlushConnPool(void)
 {
+    if ( m_ConnPool ) {
+        HTTP_FlushConnPool(m_ConnPool.get());
+    }
 }
 
 
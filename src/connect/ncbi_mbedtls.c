@@ -78,6 +78,18 @@ struct SNcbiMbedTlsCred {
 };
 
 
+#if defined(HAVE_LIBMBEDTLS)  ||  defined(NCBI_CXX_TOOLKIT)
+
+/* Session handle (can be used as mbedtls_ssl_context*) */
+struct SNcbiMbedTlsSession {
+    mbedtls_ssl_context ssl;   /* NB: must go first                         */
+    char*               key;   /* session resumption cache key, 0 if none   */
+    int/*bool*/         full;  /* server certificate seen (no resumption)   */
+};
+
+#endif /*HAVE_LIBMBEDTLS || NCBI_CXX_TOOLKIT*/
+
+
 #if defined(HAVE_LIBMBEDTLS)  ||  defined(NCBI_CXX_TOOLKIT)
 
 #  if defined(MBEDTLS_THREADING_ALT)  &&  defined(NCBI_THREADS)
@@ -361,11 +373,27 @@ static int x_StatusToError(EIO_Status status, EIO_Event direction)
 }
 
 
+#ifdef MBEDTLS_X509_CRT_PARSE_C
+/* Only gets called when the server has sent its certificate (i.e. the
+ * handshake is a full one, not a resumption);  accepts any certificate.
+ */
+static int x_MbedTlsVerify(void* data, mbedtls_x509_crt* crt,
+                           int depth, uint32_t* flags)
+{
+    struct SNcbiMbedTlsSession* session = (struct SNcbiMbedTlsSession*) data;
+    session->full = 1/*true*/;
+    *flags = 0;
+    return 0;
+}
+#endif /*MBEDTLS_X509_CRT_PARSE_C*/
+
+
 static void* s_MbedTlsCreate(ESOCK_Side side, SNcbiSSLctx* ctx, int* error)
 {
     int end = (side == eSOCK_Client
                ? MBEDTLS_SSL_IS_CLIENT
                : MBEDTLS_SSL_IS_SERVER);
+    struct SNcbiMbedTlsSession* x_session;
     struct SNcbiMbedTlsCred* xcred;
     mbedtls_ssl_context* session;
     int err;
@@ -397,11 +425,16 @@ static void* s_MbedTlsCreate(ESOCK_Side side, SNcbiSSLctx* ctx, int* error)
     } else
         xcred = 0;
 
-    if (!(session = (mbedtls_ssl_context*) malloc(sizeof(*session)))) {
+    if (!(x_session = (struct SNcbiMbedTlsSession*)
+          malloc(sizeof(*x_session)))) {
         *error = errno;
+        session = 0;
         goto out;
     }
+    session = &x_session->ssl;
     mbedtls_ssl_init(session);
+    x_session->key  = 0;
+    x_session->full = 0/*false*/;
 
     if ((err = mbedtls_ssl_setup(session, &s_MbedTlsConf))        != 0   ||
         (ctx->host  &&  *ctx->host
@@ -417,7 +450,24 @@ static void* s_MbedTlsCreate(ESOCK_Side side, SNcbiSSLctx* ctx, int* error)
     }
 
     mbedtls_ssl_set_bio(session, ctx, x_MbedTlsPush, x_MbedTlsPull, 0);
-
+#ifdef MBEDTLS_X509_CRT_PARSE_C
+    mbedtls_ssl_set_verify(session, x_MbedTlsVerify, x_session);
+#endif /*MBEDTLS_X509_CRT_PARSE_C*/
+
+    if ((x_session->key = NcbiTlsSessionKey("MBEDTLS", ctx)) != 0) {
+        void* data;
+        size_t size;
+        if ((data = NcbiTlsSessionGet(x_session->key, &size)) != 0) {
+            mbedtls_ssl_session saved;
+            mbedtls_ssl_session_init(&saved);
+            if (mbedtls_ssl_session_load(&saved,
+                                         (unsigned char*) data, size) == 0) {
+                (void) mbedtls_ssl_set_session(session, &saved);
+            }
+            mbedtls_ssl_session_free(&saved);
+            free(data);
+        }
+    }
 out:
     CORE_DEBUG_ARG(if (s_MbedTlsLogLevel))
         CORE_TRACEF(("MbedTlsCreate(): Leave(%p)", session));
@@ -460,8 +510,32 @@ static char* x_MbedTlsDesc(const mbedtls_ssl_context* session)
 }
 
 
+/* Save the established session (or the last received ticket) for resumption */
+static void x_MbedTlsSave(mbedtls_ssl_context* session, const char* key,
+                          int/*bool*/ once)
+{
+    mbedtls_ssl_session saved;
+    unsigned char* data = 0;
+    size_t size = 0;
+
+    mbedtls_ssl_session_init(&saved);
+    if (mbedtls_ssl_get_session(session, &saved) == 0
+        &&  mbedtls_ssl_session_save(&saved, 0, 0, &size)
+        == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL
+        &&  (data = (unsigned char*) malloc(size)) != 0
+        &&  mbedtls_ssl_session_save(&saved, data, size, &size) == 0) {
+        NcbiTlsSessionPut(key, data, size, once);
+    }
+    if (data)
+        free(data);
+    mbedtls_ssl_session_free(&saved);
+}
+
+
 static EIO_Status s_MbedTlsOpen(void* session, int* error, char** desc)
 {
+    struct SNcbiMbedTlsSession* x_session
+        = (struct SNcbiMbedTlsSession*) session;
     EIO_Status status;
     int x_error;
 
@@ -479,9 +553,15 @@ static EIO_Status s_MbedTlsOpen(void* session, int* error, char** desc)
         if (desc)
             *desc = 0;
     } else {
+        NcbiTlsSessionDone(!x_session->full);
+        /* TLS 1.3 tickets come after the handshake, see s_MbedTlsRead() */
+        if (x_session->key  &&  mbedtls_ssl_get_version_number(&x_session->ssl)
+            != MBEDTLS_SSL_VERSION_TLS1_3) {
+            x_MbedTlsSave(&x_session->ssl, x_session->key, 0/*reusable*/);
+        }
         status = eIO_Success;
         if (desc)
-            *desc = x_MbedTlsDesc((mbedtls_ssl_context*) session);
+            *desc = x_MbedTlsDesc(&x_session->ssl);
     }
 
     CORE_DEBUG_ARG(if (s_MbedTlsLogLevel))
@@ -534,6 +614,17 @@ again:
                               (unsigned char*) buf, n_todo);
     assert(x_read < 0  ||  (size_t) x_read <= n_todo);
 
+#ifdef MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED
+    if (x_read == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET) {
+        /* TLS 1.3 tickets are single-use (RFC 8446, C.4) */
+        struct SNcbiMbedTlsSession* x_session
+            = (struct SNcbiMbedTlsSession*) session;
+        if (x_session->key)
+            x_MbedTlsSave(&x_session->ssl, x_session->key, 1/*once*/);
+        goto again;
+    }
+#endif /*MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED*/
+
     if (x_read <= 0) {
         status = x_ErrorToStatus(x_read, (mbedtls_ssl_context*) session,
                                  eIO_Read);
@@ -669,12 +760,18 @@ static EIO_Status s_MbedTlsClose(void* session, int how/*unused*/, int* error)
 
 static void s_MbedTlsDelete(void* session)
 {
+    struct SNcbiMbedTlsSession* x_session
+        = (struct SNcbiMbedTlsSession*) session;
+
     assert(session);
 
     CORE_DEBUG_ARG(if (s_MbedTlsLogLevel))
         CORE_TRACEF(("MbedTlsDelete(%p): Enter", session));
 
-    mbedtls_ssl_free((mbedtls_ssl_context*) session);
+    if (x_session->key)
+        free(x_session->key);
+
+    mbedtls_ssl_free(&x_session->ssl);
 
     CORE_DEBUG_ARG(if (s_MbedTlsLogLevel))
         CORE_TRACEF(("MbedTlsDelete(%p): Leave", session));
@@ -787,12 +884,25 @@ static EIO_Status s_MbedTlsInit(FSSLPull pull, FSSLPush push)
                                 MBEDTLS_SSL_IS_CLIENT,
                                 MBEDTLS_SSL_TRANSPORT_STREAM,
                                 MBEDTLS_SSL_PRESET_DEFAULT);
+#ifdef MBEDTLS_X509_CRT_PARSE_C
+    /* Certificates still go unchecked (x_MbedTlsVerify() accepts any), but
+     * the callback tells full handshakes from resumed ones */
+    mbedtls_ssl_conf_authmode(&s_MbedTlsConf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+#else
     mbedtls_ssl_conf_authmode(&s_MbedTlsConf, MBEDTLS_SSL_VERIFY_NONE);
+#endif /*MBEDTLS_X509_CRT_PARSE_C*/
 #if MBEDTLS_VERSION_NUMBER == 0x03060000
     /* The above line can otherwise be ineffective. */
     mbedtls_ssl_conf_max_tls_version(&s_MbedTlsConf,
                                      MBEDTLS_SSL_VERSION_TLS1_2);
 #endif
+#if defined(MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED)  &&  \
+    defined(MBEDTLS_SSL_PROTO_TLS1_3)  &&  defined(MBEDTLS_SSL_SESSION_TICKETS)
+    /* Have TLS 1.3 tickets surface from mbedtls_ssl_read() to be cached
+     * (no such setting before mbedTLS 3.6.1) */
+    mbedtls_ssl_conf_tls13_enable_signal_new_session_tickets
+        (&s_MbedTlsConf, MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED);
+#endif /*MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED && ...*/
 
     /* Check CONN_[MBED]TLS_LOGLEVEL or [CONN][MBED]TLS_LOGLEVEL */
     val = ConnNetInfo_GetValueInternal(0, "MBED" REG_CONN_TLS_LOGLEVEL,
@@ -93,13 +93,13 @@ extern "C" {
  * C++ sources (in C++ Toolkit) see include/connect/error_codes.hpp.
  */
 NCBI_C_DEFINE_ERRCODE_X(Connect_Conn,          301,  37);
-NCBI_C_DEFINE_ERRCODE_X(Connect_Socket,        302, 166);
+NCBI_C_DEFINE_ERRCODE_X(Connect_Socket,        302, 168);
 NCBI_C_DEFINE_ERRCODE_X(Connect_Util,          303,  15);
 NCBI_C_DEFINE_ERRCODE_X(Connect_LBSM,          304,  96);
 NCBI_C_DEFINE_ERRCODE_X(Connect_FTP,           305,  14);
 NCBI_C_DEFINE_ERRCODE_X(Connect_SMTP,          306,  33);
 NCBI_C_DEFINE_ERRCODE_X(Connect_HTTP,          307,  26);
-NCBI_C_DEFINE_ERRCODE_X(Connect_Service,       308,  14);
+NCBI_C_DEFINE_ERRCODE_X(Connect_Service,       308,  15);
 NCBI_C_DEFINE_ERRCODE_X(Connect_HeapMgr,       309,  34);
 NCBI_C_DEFINE_ERRCODE_X(Connect_TLS,           310,  50);  /* mbedTLS: 1-20; GNUTLS: 21-40; TLS: 41-50 */
 NCBI_C_DEFINE_ERRCODE_X(Connect_Mghbn,         311,  16);
@@ -43,6 +43,7 @@
 #  include "ncbi_namerd.h"
 #endif /*NCBI_CXX_TOOLKIT*/
 #include "ncbi_once.h"
+#include "ncbi_srvcache.h"
 #include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -585,6 +586,95 @@ int/*bool*/ SERV_IsMapperConfiguredInternal(const char* svc, const char* key)
 }
 
 
+/* How x_Open() uses the resolution cache */
+typedef enum {
+    eCache_None = 0,    /* not at all                                     */
+    eCache_Use,         /* look up, and store what gets resolved          */
+    eCache_Refresh      /* only store what gets resolved                  */
+} ECacheMode;
+
+
+/* Collect all servers of the just opened "iter" (including "*info" that the
+ * mapper may have returned right away), and store them in the resolution
+ * cache.  Then, either switch "iter" to use the cached servers (if
+ * "attach"), or reset the mapper to make "iter" as if just opened.
+ */
+static void s_CacheStore(SERV_ITER           iter,
+                         const SConnNetInfo* net_info,
+                         SSERV_Info*         info,
+                         int/*bool*/         attach)
+{
+    const SSERV_VTable* op = iter->op;
+    unsigned int   host = iter->host;
+    unsigned short port = iter->port;
+    double         pref = iter->pref;
+    SSERV_Info**   list = 0;
+    size_t         n = 0, a = 0;
+    void*          data;
+
+    assert(op  &&  !iter->n_skip);
+    if (!op->GetNextInfo  ||  !SERV_CACHE_IsCacheable(iter, op->mapper))
+        return;
+
+    /* let LB favor none of the servers while draining the mapper */
+    iter->host = 0;
+    iter->port = 0;
+    iter->pref = 0.0;
+    if (info == (SSERV_Info*)(-1L)
+        ||  (info  &&  !(info = SERV_CopyInfo(info)))) {
+        info = 0;
+    }
+    for (;;) {
+        SSERV_Info* copy;
+        if (!info  &&  !(info = op->GetNextInfo(iter, 0)))
+            break;
+        if (n == a) {
+            SSERV_Info** temp;
+            a += 16;
+            if (!(temp = (SSERV_Info**) realloc(list, a * sizeof(*list)))) {
+                free(info);
+                break;
+            }
+            list = temp;
+        }
+        if (!(copy = SERV_CopyInfo(info))) {
+            free(info);
+            break;
+        }
+        list[n++] = copy;
+        if (!s_AddSkipInfo(iter, SERV_NameOfInfo(info), info)) {
+            free(info);
+            break;
+        }
+        info = 0;
+    }
+    iter->host = host;
+    iter->port = port;
+    iter->pref = pref;
+    while (iter->n_skip)
+        free((void*) iter->skip[--iter->n_skip]);
+    iter->last = 0;
+    if (op->Reset)
+        op->Reset(iter);
+
+    if (!n) {
+        if (list)
+            free(list);
+        return;
+    }
+    data = 0;
+    if (!(op = SERV_CACHE_Add(iter, net_info, op->mapper, list, n,
+                              attach ? &data : 0))) {
+        return;
+    }
+    /* replace the original mapper */
+    if (iter->op->Close)
+        iter->op->Close(iter);
+    iter->data = data;
+    iter->op   = op;
+}
+
+
 static SERV_ITER x_Open(const char*         service,
                         int/*bool*/         ismask,
                         TSERV_Type          types,
@@ -598,7 +688,8 @@ static SERV_ITER x_Open(const char*         service,
                         const char*         arg,
                         const char*         val,
                         SSERV_Info**        info,
-                        HOST_INFO*          host_info)
+                        HOST_INFO*          host_info,
+                        ECacheMode          cache)
 {
     int/*bool*/
         do_local,
@@ -735,6 +826,21 @@ static SERV_ITER x_Open(const char*         service,
     }
     if (ismask)
         svc = 0;
+    if (host_info  ||  n_skip)
+        cache = eCache_None;
+    if (cache == eCache_Use) {
+        int/*bool*/ negative;
+        if ((op = SERV_CACHE_Open(iter, net_info, &negative)) != 0) {
+            if ( info )
+                *info = 0;
+            cache = eCache_None;
+            goto done;
+        }
+        if (negative) {
+            SERV_Close(iter);
+            return 0;
+        }
+    }
 
     /* Ugly optimization not to access the registry more than necessary */
     if ((!(do_local = s_IsMapperConfigured(svc, REG_CONN_LOCAL_ENABLE))    ||
@@ -819,6 +925,8 @@ static SERV_ITER x_Open(const char*         service,
                          &"/"[!svc], svc ? svc : "",
                          *service ? "]  " : ""));
         }
+        if (cache != eCache_None  &&  SERV_CACHE_IsCacheable(iter, 0))
+            SERV_CACHE_Add(iter, net_info, 0/*failure*/, 0, 0, 0);
         SERV_Close(iter);
         return 0;
     }
@@ -826,6 +934,10 @@ static SERV_ITER x_Open(const char*         service,
  done:
     assert(op != 0);
     iter->op = op;
+    if (cache != eCache_None  &&  !data) {
+        s_CacheStore(iter, net_info, info ? *info : 0,
+                     cache == eCache_Use);
+    }
     return iter;
 }
 
@@ -1143,7 +1255,7 @@ static SERV_ITER s_Open(const char*         service,
                             preferred_host, preferred_port, preference,
                             net_info, skip, n_skip,
                             external, arg, val,
-                            &x_info, host_info);
+                            &x_info, host_info, eCache_Use);
     assert(!iter  ||  iter->op);
     if (!iter)
         x_info = 0;
@@ -1162,6 +1274,26 @@ static SERV_ITER s_Open(const char*         service,
 }
 
 
+int/*bool*/ SERV_CACHE_Resolve(const char*         name,
+                               TSERV_Type          types,
+                               const SConnNetInfo* net_info,
+                               int/*bool*/         external)
+{
+    SSERV_Info* info = 0;
+    SERV_ITER iter = x_Open(name, 0/*not mask*/, types,
+                            SERV_ANYHOST, 0/*preferred_port*/, 0.0,
+                            net_info, 0/*skip*/, 0/*n_skip*/,
+                            external, 0/*arg*/, 0/*val*/,
+                            &info, 0/*host_info*/, eCache_Refresh);
+    if (info  &&  info != (SSERV_Info*)(-1L))
+        free(info);
+    if (!iter)
+        return 0/*false*/;
+    SERV_Close(iter);
+    return 1/*true*/;
+}
+
+
 extern SERV_ITER SERV_OpenSimple(const char* service)
 {
     SConnNetInfo* net_info = ConnNetInfo_Create(service);
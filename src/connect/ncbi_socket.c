@@ -132,7 +132,16 @@
 #    include <sys/resource.h>
 #  endif /*HAVE_SYS_RESOURCE_H*/
 #  include <sys/stat.h>
+#  include <sys/uio.h>
 #  include <sys/un.h>
+#  include <limits.h>
+#  ifdef NCBI_OS_LINUX
+#    include <linux/errqueue.h>
+#    include <sys/sendfile.h>
+#    if defined(SO_ZEROCOPY)  &&  defined(MSG_ZEROCOPY)  &&  defined(SO_EE_ORIGIN_ZEROCOPY)
+#      define SOCK_ZEROCOPY  1
+#    endif /*SO_ZEROCOPY && MSG_ZEROCOPY && SO_EE_ORIGIN_ZEROCOPY*/
+#  endif /*NCBI_OS_LINUX*/
 #endif /*NCBI_OS_UNIX*/
 
 /* Portable standard C headers
@@ -3513,6 +3522,46 @@ static EIO_Status s_WaitConnected(SOCK                  sock,
 }
 
 
+/* Collect completion notifications of zero-copy sends from the socket error
+ * queue.  NB:  Pending notifications make poll() report the socket as ready,
+ * so they must be collected before waiting for I/O on it.
+ */
+static void s_ZeroCopyReap(SOCK sock)
+{
+#ifdef SOCK_ZEROCOPY
+    for (;;) {
+        char            control[128];
+        struct msghdr   msg;
+        struct cmsghdr* cmsg;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sock->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            break;
+        for (cmsg = CMSG_FIRSTHDR(&msg);  cmsg;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            const struct sock_extended_err* err;
+            if (!(cmsg->cmsg_level == SOL_IP
+                  &&  cmsg->cmsg_type == IP_RECVERR)  &&
+                !(cmsg->cmsg_level == SOL_IPV6
+                  &&  cmsg->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            err = (const struct sock_extended_err*) CMSG_DATA(cmsg);
+            if (err->ee_errno  ||  err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            /* sends [ee_info, ee_data] (counted from 0) have completed */
+            if ((int)(err->ee_data + 1 - sock->zc_done) > 0)
+                sock->zc_done = err->ee_data + 1;
+        }
+    }
+#else
+    (void) sock;
+#endif /*SOCK_ZEROCOPY*/
+}
+
+
 /* Read as many as "size" bytes of data from the socket.  Return eIO_Success
  * if at least one byte has been read or EOF has been reached (0 bytes read).
  * Otherwise (nothing read), return an error code to indicate the problem.
@@ -3601,6 +3650,8 @@ static EIO_Status s_Recv(SOCK    sock,
                              " Spurious false indication of read-ready",
                              s_ID(sock, _id)));
             }
+            if (sock->zc_sent != sock->zc_done)
+                s_ZeroCopyReap(sock);
             poll.sock   = sock;
             poll.event  = eIO_Read;
             poll.revent = eIO_Open;
@@ -4168,6 +4219,8 @@ static EIO_Status s_Send(SOCK        sock,
                              " Spurious false indication of write-ready",
                              s_ID(sock, _id)));
             }
+            if (sock->zc_sent != sock->zc_done)
+                s_ZeroCopyReap(sock);
             poll.sock   = sock;
             poll.event  = eIO_Write;
             poll.revent = eIO_Open;
@@ -4499,6 +4552,569 @@ static EIO_Status s_Write(SOCK        sock,
 }
 
 
+/* Max number of segments passed to the OS at once */
+#define SOCK_IOV_WINDOW  64
+
+
+#ifdef NCBI_OS_UNIX
+
+/* Wait for a stream socket to become writable after EAGAIN, see s_Send().
+ * Return eIO_Success to try writing again.
+ */
+static EIO_Status x_WaitWritable(SOCK         sock,
+                                 int/*bool*/* writeable,
+                                 const char*  what)
+{
+    SSOCK_Poll poll;
+    EIO_Status status;
+    CORE_DEBUG_ARG(char _id[MAXIDLEN];)
+
+    if (sock->w_tv_set  &&  !(sock->w_tv.tv_sec | sock->w_tv.tv_usec))
+        return eIO_Timeout;
+    if (*writeable) {
+        CORE_TRACEF(("%s[SOCK::%s] "
+                     " Spurious false indication of write-ready",
+                     s_ID(sock, _id), what));
+    }
+    if (sock->zc_sent != sock->zc_done)
+        s_ZeroCopyReap(sock);
+    poll.sock   = sock;
+    poll.event  = eIO_Write;
+    poll.revent = eIO_Open;
+    /* stall protection:  try pulling incoming data from the socket */
+    status = s_SelectStallsafe(1, &poll, SOCK_GET_TIMEOUT(sock, w), 0);
+    assert(poll.event == eIO_Write);
+    if (status != eIO_Success)
+        return status;
+    if (poll.revent == eIO_Close)
+        return eIO_Unknown;
+    *writeable = 1/*true*/;
+    return eIO_Success;
+}
+
+
+/* Vectored counterpart of s_Send() (without OOB):  write data of "n_iov"
+ * segments, "size" bytes in total, with a single system call if possible.
+ * Return eIO_Success iff at least some bytes have been written.
+ * NOTE: This call is for unencrypted stream sockets only.
+ */
+static EIO_Status s_SendV(SOCK                sock,
+                          const struct iovec* iov,
+                          size_t              n_iov,
+                          size_t              size,
+                          size_t*             n_written,
+                          int/*bool*/         zerocopy)
+{
+    int/*bool*/ writeable;
+    char _id[MAXIDLEN];
+
+    assert(sock->type == eSOCK_Socket  &&  !sock->sslctx);
+    assert(n_iov  &&  size > 0  &&  !*n_written);
+
+    if (sock->w_status == eIO_Closed)
+        return eIO_Closed;
+
+    writeable = 0/*false*/;
+    for (;;) { /* optionally auto-resume if interrupted */
+        struct msghdr msg;
+        EIO_Status    status;
+        ssize_t       x_written;
+        int           flags = 0;
+        int           error = 0;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = (struct iovec*) iov;
+        msg.msg_iovlen = n_iov;
+#ifdef MSG_NOSIGNAL
+        if (!s_AllowSigPipe)
+            flags |= MSG_NOSIGNAL;
+#endif /*MSG_NOSIGNAL*/
+#ifdef SOCK_ZEROCOPY
+        if (zerocopy  &&  sock->zc_min  &&  size >= sock->zc_min)
+            flags |= MSG_ZEROCOPY;
+#endif /*SOCK_ZEROCOPY*/
+
+        x_written = sendmsg(sock->sock, &msg, flags);
+
+        if (x_written >= 0  ||
+            (x_written < 0  &&  ((error = SOCK_ERRNO) == SOCK_EPIPE         ||
+                                 error                == SOCK_ENOTCONN      ||
+                                 error                == SOCK_ETIMEDOUT     ||
+                                 error                == SOCK_ENETRESET     ||
+                                 error                == SOCK_ECONNRESET    ||
+                                 error                == SOCK_ECONNABORTED))) {
+            /* statistics & logging */
+            if (x_written <= 0) {
+                if (sock->log != eOff) {
+                    s_DoLog(sock->n_read  &&  sock->n_written
+                            ? eLOG_Error : eLOG_Trace, sock, eIO_Write,
+                            &error, 0, 0);
+                }
+            } else if (sock->log == eOn
+                       ||  (sock->log == eDefault  &&  s_Log == eOn)) {
+                size_t i, n_left = (size_t) x_written;
+                for (i = 0;  n_left  &&  i < n_iov;  ++i) {
+                    size_t n = iov[i].iov_len < n_left
+                        ? iov[i].iov_len : n_left;
+                    if (n)
+                        s_DoLog(eLOG_Note, sock, eIO_Write,
+                                iov[i].iov_base, n, 0);
+                    n_left -= n;
+                }
+            }
+
+            if (x_written > 0) {
+#ifdef SOCK_ZEROCOPY
+                if (flags & MSG_ZEROCOPY)
+                    ++sock->zc_sent;
+#endif /*SOCK_ZEROCOPY*/
+                sock->n_written += (TNCBI_BigCount) x_written;
+                *n_written       = (size_t)         x_written;
+                sock->w_status = eIO_Success;
+                break/*success*/;
+            }
+            if (x_written < 0) {
+                if (error != SOCK_EPIPE  &&  error != SOCK_ENOTCONN)
+                    sock->r_status = eIO_Closed;
+                sock->w_status = eIO_Closed;
+                break/*closed*/;
+            }
+        }
+
+        if (!x_written)
+            return eIO_Unknown;
+
+#ifdef SOCK_ZEROCOPY
+        if (error == ENOBUFS  &&  (flags & MSG_ZEROCOPY)) {
+            /* out of lockable memory: send this one with copying */
+            zerocopy = 0/*false*/;
+            continue;
+        }
+#endif /*SOCK_ZEROCOPY*/
+
+        if (error == SOCK_EWOULDBLOCK  ||  error == SOCK_EAGAIN) {
+            /* blocked -- retry if unblocked before the timeout expires */
+            status = x_WaitWritable(sock, &writeable, "SendV");
+            if (status == eIO_Timeout) {
+                sock->w_status = eIO_Timeout;
+                break/*timeout*/;
+            }
+            if (status != eIO_Success)
+                return status;
+            continue/*try to write again*/;
+        }
+
+        if (error != SOCK_EINTR) {
+            const char* strerr = SOCK_STRERROR(error);
+            CORE_LOGF_ERRNO_EXX(168, eLOG_Trace,
+                                error, strerr ? strerr : "",
+                                ("%s[SOCK::SendV] "
+                                 " Failed sendmsg()",
+                                 s_ID(sock, _id)));
+            UTIL_ReleaseBuffer(strerr);
+            sock->w_status = eIO_Unknown;
+            break/*unknown*/;
+        }
+
+        if (x_IsInterruptibleSOCK(sock)) {
+            sock->w_status = eIO_Interrupt;
+            break/*interrupt*/;
+        }
+    }
+
+    return (EIO_Status) sock->w_status;
+}
+
+
+/* Vectored counterpart of s_Recv():  read into "n_iov" segments, "size"
+ * bytes in total.  Return eIO_Success iff at least one byte has been read;
+ * otherwise, an error code (eIO_Closed at EOF).
+ * NOTE: This call is for unencrypted stream sockets only.
+ */
+static EIO_Status s_RecvV(SOCK                sock,
+                          const struct iovec* iov,
+                          size_t              n_iov,
+                          size_t              size,
+                          size_t*             n_read)
+{
+    int/*bool*/ readable;
+    char _id[MAXIDLEN];
+
+    assert(sock->type == eSOCK_Socket  &&  !sock->sslctx);
+    assert(n_iov  &&  size > 0  &&  !*n_read);
+
+    if (sock->eof)
+        return sock->r_status == eIO_Closed ? eIO_Unknown : eIO_Closed;
+    if (sock->r_status == eIO_Closed)
+        return eIO_Unknown;
+
+    readable = 0/*false*/;
+    for (;;) { /* optionally auto-resume if interrupted */
+        struct msghdr msg;
+        ssize_t       x_read;
+        int           error = 0;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = (struct iovec*) iov;
+        msg.msg_iovlen = n_iov;
+
+        x_read = recvmsg(sock->sock, &msg, 0);
+
+        /* success/EOF? */
+        if (x_read >= 0  ||
+            (x_read < 0  &&  ((error = SOCK_ERRNO) == SOCK_ENOTCONN    ||
+                              error                == SOCK_ETIMEDOUT   ||
+                              error                == SOCK_ENETRESET   ||
+                              error                == SOCK_ECONNRESET  ||
+                              error                == SOCK_ECONNABORTED))) {
+            /* statistics & logging */
+            if (x_read < 0) {
+                if (sock->log != eOff) {
+                    s_DoLog(sock->n_read  &&  sock->n_written
+                            ? eLOG_Error : eLOG_Trace, sock, eIO_Read,
+                            &error, 0, 0);
+                }
+            } else if (sock->log == eOn
+                       ||  (sock->log == eDefault  &&  s_Log == eOn)) {
+                size_t i, n_left = (size_t) x_read;
+                if (!n_left)
+                    s_DoLog(eLOG_Note, sock, eIO_Read, 0, 0, 0);
+                for (i = 0;  n_left  &&  i < n_iov;  ++i) {
+                    size_t n = iov[i].iov_len < n_left
+                        ? iov[i].iov_len : n_left;
+                    if (n)
+                        s_DoLog(eLOG_Note, sock, eIO_Read,
+                                iov[i].iov_base, n, 0);
+                    n_left -= n;
+                }
+            }
+
+            if (x_read > 0) {
+                assert((size_t) x_read <= size);
+                sock->n_read += (TNCBI_BigCount) x_read;
+                *n_read       = (size_t)         x_read;
+                sock->r_status = eIO_Success;
+                break/*success*/;
+            }
+            /* catch EOF/failure */
+            sock->eof = 1/*true*/;
+            if (x_read/*<0*/) {
+                if (error != SOCK_ENOTCONN)
+                    sock->w_status = eIO_Closed;
+                sock->r_status = eIO_Closed;
+                return eIO_Unknown/*error*/;
+            }
+            sock->r_status = eIO_Success;
+            return eIO_Closed/*EOF*/;
+        }
+
+        if (error == SOCK_EWOULDBLOCK  ||  error == SOCK_EAGAIN) {
+            /* blocked -- wait for data to come;  return if timeout/error */
+            EIO_Status status;
+            SSOCK_Poll poll;
+
+            if (sock->r_tv_set  &&  !(sock->r_tv.tv_sec | sock->r_tv.tv_usec)){
+                sock->r_status = eIO_Timeout;
+                break/*timeout*/;
+            }
+            if (readable) {
+                CORE_TRACEF(("%s[SOCK::RecvV] "
+                             " Spurious false indication of read-ready",
+                             s_ID(sock, _id)));
+            }
+            if (sock->zc_sent != sock->zc_done)
+                s_ZeroCopyReap(sock);
+            poll.sock   = sock;
+            poll.event  = eIO_Read;
+            poll.revent = eIO_Open;
+            status = s_Select(1, &poll, SOCK_GET_TIMEOUT(sock, r), 1/*asis*/);
+            assert(poll.event == eIO_Read);
+            if (status == eIO_Timeout) {
+                sock->r_status = eIO_Timeout;
+                break/*timeout*/;
+            }
+            if (status != eIO_Success)
+                return status;
+            if (poll.revent == eIO_Close)
+                return eIO_Unknown;
+            readable = 1/*true*/;
+            continue/*read again*/;
+        }
+
+        if (error != SOCK_EINTR) {
+            const char* strerr = SOCK_STRERROR(error);
+            CORE_LOGF_ERRNO_EXX(168, eLOG_Trace,
+                                error, strerr ? strerr : "",
+                                ("%s[SOCK::RecvV] "
+                                 " Failed recvmsg()",
+                                 s_ID(sock, _id)));
+            UTIL_ReleaseBuffer(strerr);
+            sock->r_status = eIO_Unknown;
+            break/*unknown*/;
+        }
+
+        if (x_IsInterruptibleSOCK(sock)) {
+            sock->r_status = eIO_Interrupt;
+            break/*interrupt*/;
+        }
+    }
+
+    return (EIO_Status) sock->r_status;
+}
+
+#endif /*NCBI_OS_UNIX*/
+
+
+/* Write segments one by one, each with s_Write(), as if they were a single
+ * buffer:  after some data have been written, do not wait any longer.
+ */
+static EIO_Status x_WriteSegments(SOCK               sock,
+                                  const SSOCK_IoVec* iov,
+                                  size_t             n_iov,
+                                  size_t*            n_written)
+{
+    unsigned int wtv_set = 2;
+    struct timeval wtv;
+    EIO_Status status = eIO_Success;
+    size_t i;
+
+    *n_written = 0;
+    for (i = 0;  i < n_iov;  ++i) {
+        size_t x_written;
+        if (!iov[i].size)
+            continue;
+        status = s_Write(sock, iov[i].base, iov[i].size, &x_written, 0);
+        *n_written += x_written;
+        if (status != eIO_Success  ||  x_written < iov[i].size)
+            break;
+        if (wtv_set & 2) {
+            if ((wtv_set = sock->w_tv_set) != 0)
+                wtv = sock->w_tv;
+            /*zero timeout*/
+            sock->w_tv_set = 1;
+            memset(&sock->w_tv, 0, sizeof(sock->w_tv));
+        }
+    }
+    if (!(wtv_set & 2)  &&  (sock->w_tv_set = wtv_set & 1) != 0)
+        x_tvcpy(&sock->w_tv, &wtv);
+    if (i == n_iov  &&  !*n_written) {
+        /* nothing to write: just flush whatever is pending */
+        size_t x_written;
+        status = s_Write(sock, 0, 0, &x_written, 0);
+    }
+
+    return *n_written ? eIO_Success : status;
+}
+
+
+/* Write up to SOCK_IOV_WINDOW segments (see SOCK_Write(eIO_WritePlain)).
+ * Return eIO_Success if some data have been written.
+ */
+static EIO_Status s_WriteV(SOCK               sock,
+                           const SSOCK_IoVec* iov,
+                           size_t             n_iov,
+                           size_t*            n_written,
+                           int/*bool*/        zerocopy)
+{
+#ifdef NCBI_OS_UNIX
+    struct iovec x_iov[SOCK_IOV_WINDOW];
+    size_t       i, n, size;
+    EIO_Status   status;
+
+    assert(n_iov <= SOCK_IOV_WINDOW);
+
+    for (i = n = size = 0;  i < n_iov;  ++i) {
+        if (!iov[i].size)
+            continue;
+        x_iov[n].iov_base = iov[i].base;
+        x_iov[n].iov_len  = iov[i].size;
+        size += iov[i].size;
+        ++n;
+    }
+    /* a single segment is just as good for the regular write,
+     * unless it is to be sent with zero-copy */
+    if (sock->type != eSOCK_Socket  ||  sock->sslctx  ||  !n
+        ||  (n < 2  &&  !(zerocopy  &&  sock->zc_min))) {
+        return x_WriteSegments(sock, iov, n_iov, n_written);
+    }
+
+    *n_written = 0;
+    if (sock->w_status == eIO_Closed)
+        return eIO_Closed;
+    status = s_WritePending(sock, SOCK_GET_TIMEOUT(sock, w), 0, 0);
+    if (status == eIO_Success)
+        status = s_SendV(sock, x_iov, n, size, n_written, zerocopy);
+    if (s_ErrHook  &&  status != eIO_Success) {
+        SSOCK_ErrInfo info;
+        char          addr[SOCK_ADDRSTRLEN];
+        memset(&info, 0, sizeof(info));
+        info.type = eSOCK_ErrIO;
+        info.sock = sock;
+        if (sock->port) {
+            s_AddrToString(addr, sizeof(addr), &sock->addr, s_IPVersion, 0);
+            info.host =       addr;
+            info.port = sock->port;
+        } else
+            info.host = sock->path;
+        info.event = eIO_Write;
+        info.status = status;
+        s_ErrorCallback(&info);
+    }
+    return status;
+#else
+    (void) zerocopy;
+    return x_WriteSegments(sock, iov, n_iov, n_written);
+#endif /*NCBI_OS_UNIX*/
+}
+
+
+/* Read segments one by one, each with s_Read(), as if they were a single
+ * buffer:  after some data have been read, do not wait any longer.
+ */
+static EIO_Status x_ReadSegments(SOCK               sock,
+                                 const SSOCK_IoVec* iov,
+                                 size_t             n_iov,
+                                 size_t*            n_read)
+{
+    unsigned int rtv_set = 2;
+    struct timeval rtv;
+    EIO_Status status = eIO_Success;
+    size_t i;
+
+    *n_read = 0;
+    for (i = 0;  i < n_iov;  ++i) {
+        size_t x_read;
+        if (!iov[i].size)
+            continue;
+        status = s_Read(sock, iov[i].base, iov[i].size, &x_read, 0/*read*/);
+        *n_read += x_read;
+        if (status != eIO_Success  ||  x_read < iov[i].size)
+            break;
+        if (rtv_set & 2) {
+            if ((rtv_set = sock->r_tv_set) != 0)
+                rtv = sock->r_tv;
+            /*zero timeout*/
+            sock->r_tv_set = 1;
+            memset(&sock->r_tv, 0, sizeof(sock->r_tv));
+        }
+    }
+    if (!(rtv_set & 2)  &&  (sock->r_tv_set = rtv_set & 1) != 0)
+        x_tvcpy(&sock->r_tv, &rtv);
+    if (i == n_iov  &&  !*n_read) {
+        /* nothing to read into: just check the status */
+        size_t x_read;
+        status = s_Read(sock, 0, 0, &x_read, 0/*read*/);
+    }
+
+    return *n_read ? eIO_Success : status;
+}
+
+
+/* Read into up to SOCK_IOV_WINDOW segments (see SOCK_Read(eIO_ReadPlain)).
+ * Return eIO_Success if some data have been read.
+ */
+static EIO_Status s_ReadV(SOCK               sock,
+                          const SSOCK_IoVec* iov,
+                          size_t             n_iov,
+                          size_t*            n_read)
+{
+#ifdef NCBI_OS_UNIX
+    struct iovec x_iov[SOCK_IOV_WINDOW];
+    size_t       i, n, size;
+    EIO_Status   status;
+
+    assert(n_iov <= SOCK_IOV_WINDOW);
+
+    for (i = n = size = 0;  i < n_iov;  ++i) {
+        if (!iov[i].size)
+            continue;
+        x_iov[n].iov_base = iov[i].base;
+        x_iov[n].iov_len  = iov[i].size;
+        size += iov[i].size;
+        ++n;
+    }
+    /* buffered data must go first, and one segment is no different */
+    if (sock->type != eSOCK_Socket  ||  sock->sslctx  ||  n < 2
+        ||  BUF_Size(sock->r_buf)) {
+        return x_ReadSegments(sock, iov, n_iov, n_read);
+    }
+
+    *n_read = 0;
+    /* same preparations as in s_Read_() */
+    status = s_WritePending(sock, SOCK_GET_TIMEOUT(sock, r), 0, 0);
+    if (sock->pending) {
+        assert(status != eIO_Success);
+        return status == eIO_Closed ? eIO_Unknown : status;
+    }
+    status = s_RecvV(sock, x_iov, n, size, n_read);
+    if (s_ErrHook  &&  status != eIO_Success  &&  status != eIO_Closed) {
+        SSOCK_ErrInfo info;
+        char          addr[SOCK_ADDRSTRLEN];
+        memset(&info, 0, sizeof(info));
+        info.type = eSOCK_ErrIO;
+        info.sock = sock;
+        if (sock->port) {
+            s_AddrToString(addr, sizeof(addr), &sock->addr, s_IPVersion, 0);
+            info.host =       addr;
+            info.port = sock->port;
+        } else
+            info.host = sock->path;
+        info.event = eIO_Read;
+        info.status = status;
+        s_ErrorCallback(&info);
+    }
+    return status;
+#else
+    return x_ReadSegments(sock, iov, n_iov, n_read);
+#endif /*NCBI_OS_UNIX*/
+}
+
+
+/* Take the next window of segments starting at segment "i", byte "skip" */
+static size_t x_IoVecWindow(SSOCK_IoVec*       window,
+                            const SSOCK_IoVec* iov,
+                            size_t             n_iov,
+                            size_t             i,
+                            size_t             skip)
+{
+    size_t n;
+    for (n = 0;  i < n_iov  &&  n < SOCK_IOV_WINDOW;  ++i, ++n) {
+        window[n] = iov[i];
+        if (skip) {
+            window[n].base  = (char*) window[n].base + skip;
+            window[n].size -= skip;
+            skip = 0;
+        }
+    }
+    return n;
+}
+
+
+/* Advance position ("*i", "*skip") in the segments by "size" bytes */
+static void x_IoVecAdvance(const SSOCK_IoVec* iov,
+                           size_t             n_iov,
+                           size_t*            i,
+                           size_t*            skip,
+                           size_t             size)
+{
+    while (*i < n_iov) {
+        size_t left = iov[*i].size - *skip;
+        if (size < left) {
+            *skip += size;
+            return;
+        }
+        size -= left;
+        *skip = 0;
+        ++*i;
+        if (!size)
+            break;
+    }
+    /* skip empty segments */
+    while (*i < n_iov  &&  !iov[*i].size)
+        ++*i;
+}
+
+
 /* For non-datagram sockets only */
 static EIO_Status s_Shutdown(SOCK                  sock,
                              EIO_Event             dir,
@@ -4769,6 +5385,11 @@ static EIO_Status s_Close_(SOCK       sock,
         sock->sslctx->sock = 0;
     }
 
+    /* zero-copy is set up per OS handle */
+    sock->zc_min  = 0;
+    sock->zc_sent = 0;
+    sock->zc_done = 0;
+
     if (abs(abort) <= 1) {
         /* statistics & logging */
         if (sock->type != eSOCK_Datagram) {
@@ -5962,6 +6583,15 @@ static EIO_Status s_CreateListening(const char*    path,
          */
         if (!s_SetReuseAddress(fd, 1/*true*/))
             failed = "REUSEADDR";
+#  ifdef SO_REUSEPORT
+        else if (flags & fSOCK_ReusePort) {
+            int reuse_port = 1;
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+                           (char*) &reuse_port, sizeof(reuse_port)) != 0) {
+                failed = "REUSEPORT";
+            }
+        }
+#  endif /*SO_REUSEPORT*/
 #endif /*NCBI_OS_MSWIN...*/
         if (failed) {
             const char* strerr = SOCK_STRERROR(error = SOCK_ERRNO);
@@ -8361,6 +8991,348 @@ extern EIO_Status SOCK_Write(SOCK            sock,
 }
 
 
+static EIO_Status x_WriteVec(SOCK               sock,
+                             const SSOCK_IoVec* iov,
+                             size_t             n_iov,
+                             size_t*            n_written,
+                             EIO_WriteMethod    how,
+                             const char*        what,
+                             int/*bool*/        zerocopy)
+{
+    EIO_Status status;
+    size_t     x_written;
+    char       _id[MAXIDLEN];
+
+    x_written = 0;
+    if (n_iov  &&  !iov) {
+        assert(0);
+        status = eIO_InvalidArg;
+    } else if (sock->sock == SOCK_INVALID) {
+        CORE_LOGF_X(70, eLOG_Error,
+                    ("%s[SOCK::%s] "
+                     " Invalid socket",
+                     s_ID(sock, _id), what));
+        status = eIO_Closed;
+    } else if (how != eIO_WritePlain  &&  how != eIO_WritePersist) {
+        CORE_LOGF_X(167, eLOG_Error,
+                    ("%s[SOCK::%s] "
+                     " Unsupported write method #%u",
+                     s_ID(sock, _id), what, (unsigned int) how));
+        status = eIO_NotSupported;
+    } else {
+        size_t i = 0, skip = 0;
+        x_IoVecAdvance(iov, n_iov, &i, &skip, 0);
+        do {
+            SSOCK_IoVec window[SOCK_IOV_WINDOW];
+            size_t      n = x_IoVecWindow(window, iov, n_iov, i, skip);
+            size_t      xx_written;
+            status = s_WriteV(sock, window, n, &xx_written, zerocopy);
+            x_IoVecAdvance(iov, n_iov, &i, &skip, xx_written);
+            x_written += xx_written;
+        } while (how == eIO_WritePersist  &&  i < n_iov
+                 &&  status == eIO_Success);
+    }
+
+    if ( n_written )
+        *n_written = x_written;
+    return status;
+}
+
+
+extern EIO_Status SOCK_WriteV(SOCK               sock,
+                              const SSOCK_IoVec* iov,
+                              size_t             n_iov,
+                              size_t*            n_written,
+                              EIO_WriteMethod    how)
+{
+    return x_WriteVec(sock, iov, n_iov, n_written, how,
+                      "WriteV", 1/*zerocopy*/);
+}
+
+
+extern EIO_Status SOCK_ReadV(SOCK               sock,
+                             const SSOCK_IoVec* iov,
+                             size_t             n_iov,
+                             size_t*            n_read,
+                             EIO_ReadMethod     how)
+{
+    EIO_Status status;
+    size_t     x_read;
+    char       _id[MAXIDLEN];
+
+    x_read = 0;
+    if (n_iov  &&  !iov) {
+        assert(0);
+        status = eIO_InvalidArg;
+    } else if (sock->sock == SOCK_INVALID) {
+        CORE_LOGF_X(54, eLOG_Error,
+                    ("%s[SOCK::ReadV] "
+                     " Invalid socket",
+                     s_ID(sock, _id)));
+        status = eIO_Closed;
+    } else if (how != eIO_ReadPlain  &&  how != eIO_ReadPersist) {
+        CORE_LOGF_X(167, eLOG_Error,
+                    ("%s[SOCK::ReadV] "
+                     " Unsupported read method #%u",
+                     s_ID(sock, _id), (unsigned int) how));
+        status = eIO_NotSupported;
+    } else {
+        size_t i = 0, skip = 0;
+        x_IoVecAdvance(iov, n_iov, &i, &skip, 0);
+        do {
+            SSOCK_IoVec window[SOCK_IOV_WINDOW];
+            size_t      n = x_IoVecWindow(window, iov, n_iov, i, skip);
+            size_t      xx_read;
+            status = s_ReadV(sock, window, n, &xx_read);
+            x_IoVecAdvance(iov, n_iov, &i, &skip, xx_read);
+            x_read += xx_read;
+        } while (how == eIO_ReadPersist  &&  i < n_iov
+                 &&  status == eIO_Success);
+    }
+
+    if ( n_read )
+        *n_read = x_read;
+    return status;
+}
+
+
+struct SIoVecWindow {
+    SSOCK_IoVec iov[SOCK_IOV_WINDOW];
+    size_t      n;
+};
+
+
+static size_t x_AddToIoVecWindow(void* data, const void* buf, size_t size)
+{
+    struct SIoVecWindow* window = (struct SIoVecWindow*) data;
+    if (window->n >= SOCK_IOV_WINDOW)
+        return 0/*full*/;
+    window->iov[window->n].base = (void*) buf;
+    window->iov[window->n].size = size;
+    window->n++;
+    return size;
+}
+
+
+extern EIO_Status SOCK_WriteBUF(SOCK            sock,
+                                BUF             buf,
+                                size_t*         n_written,
+                                EIO_WriteMethod how)
+{
+    EIO_Status status;
+    size_t     x_written = 0;
+
+    do {
+        struct SIoVecWindow window;
+        size_t              xx_written;
+        window.n = 0;
+        BUF_PeekAtCB(buf, 0, x_AddToIoVecWindow, &window, BUF_Size(buf));
+        /* the chunks get released as soon as written:  no zero-copy */
+        status = x_WriteVec(sock, window.iov, window.n, &xx_written, how,
+                            "WriteBUF", 0/*no zerocopy*/);
+        verify(BUF_Read(buf, 0, xx_written) == xx_written);
+        x_written += xx_written;
+    } while (how == eIO_WritePersist  &&  BUF_Size(buf)
+             &&  status == eIO_Success);
+
+    if ( n_written )
+        *n_written = x_written;
+    return status;
+}
+
+
+#ifdef NCBI_OS_UNIX
+
+/* Portable SOCK_SendFile():  read the file and write its data */
+static EIO_Status x_SendFileData(SOCK    sock,
+                                 int     fd,
+                                 off_t   offset,
+                                 size_t  size,
+                                 size_t* n_written)
+{
+    char       buf[16384];
+    EIO_Status status = eIO_Success;
+    char       _id[MAXIDLEN];
+
+    while (size) {
+        size_t  x_written;
+        ssize_t x_read = pread(fd, buf, size < sizeof(buf)
+                               ? size : sizeof(buf), offset);
+        if (x_read < 0) {
+            int error = errno;
+            if (error == EINTR)
+                continue;
+            CORE_LOGF_ERRNO_X(168, eLOG_Error, error,
+                              ("%s[SOCK::SendFile] "
+                               " Failed pread()",
+                               s_ID(sock, _id)));
+            return eIO_Unknown;
+        }
+        if (!x_read)
+            return eIO_Closed/*file too short*/;
+        status = SOCK_Write(sock, buf, (size_t) x_read,
+                            &x_written, eIO_WritePersist);
+        *n_written += x_written;
+        if (status != eIO_Success)
+            break;
+        offset += x_read;
+        size   -= (size_t) x_read;
+    }
+    return status;
+}
+
+#endif /*NCBI_OS_UNIX*/
+
+
+extern EIO_Status SOCK_SendFile(SOCK           sock,
+                                int            fd,
+                                TNCBI_BigCount offset,
+                                size_t         size,
+                                size_t*        n_written)
+{
+    EIO_Status status;
+    size_t     x_written = 0;
+    char       _id[MAXIDLEN];
+
+    if (sock->sock == SOCK_INVALID) {
+        CORE_LOGF_X(70, eLOG_Error,
+                    ("%s[SOCK::SendFile] "
+                     " Invalid socket",
+                     s_ID(sock, _id)));
+        status = eIO_Closed;
+    } else {
+#ifdef NCBI_OS_UNIX
+        status = eIO_Success;
+#  ifdef NCBI_OS_LINUX
+        if (size  &&  sock->type == eSOCK_Socket  &&  !sock->sslctx
+            &&  sock->w_status != eIO_Closed) {
+            int/*bool*/ writeable = 0/*false*/;
+            off_t       pos = (off_t) offset;
+
+            status = s_WritePending(sock, SOCK_GET_TIMEOUT(sock, w), 0, 0);
+            while (status == eIO_Success  &&  x_written < size) {
+                ssize_t x_sent = sendfile(sock->sock, fd, &pos,
+                                          size - x_written);
+                int     error;
+                if (x_sent > 0) {
+                    sock->n_written += (TNCBI_BigCount) x_sent;
+                    x_written       += (size_t)         x_sent;
+                    sock->w_status = eIO_Success;
+                    continue;
+                }
+                if (!x_sent) {
+                    status = eIO_Closed/*file too short*/;
+                    break;
+                }
+                error = errno;
+                if (error == EINTR) {
+                    if (x_IsInterruptibleSOCK(sock))
+                        status = eIO_Interrupt;
+                    continue;
+                }
+                if (error == EAGAIN  ||  error == EWOULDBLOCK) {
+                    status = x_WaitWritable(sock, &writeable, "SendFile");
+                    if (status == eIO_Timeout)
+                        sock->w_status = eIO_Timeout;
+                    continue;
+                }
+                if (!x_written  &&  (error == EINVAL  ||  error == ENOSYS)) {
+                    /* the file cannot be mapped: read it instead */
+                    break;
+                }
+                CORE_LOGF_ERRNO_X(168, eLOG_Trace, error,
+                                  ("%s[SOCK::SendFile] "
+                                   " Failed sendfile()",
+                                   s_ID(sock, _id)));
+                if (error == EPIPE  ||  error == ECONNRESET) {
+                    sock->r_status = eIO_Closed;
+                    sock->w_status = eIO_Closed;
+                    status = eIO_Closed;
+                } else
+                    status = eIO_Unknown;
+                break;
+            }
+            if (status != eIO_Success  ||  x_written == size)
+                size = x_written/*done*/;
+            else
+                offset = (TNCBI_BigCount) pos;
+        }
+#  endif /*NCBI_OS_LINUX*/
+        if (x_written < size) {
+            status = x_SendFileData(sock, fd, (off_t) offset,
+                                    size, &x_written);
+        }
+#else
+        (void) fd;
+        (void) offset;
+        (void) size;
+        status = eIO_NotSupported;
+#endif /*NCBI_OS_UNIX*/
+    }
+
+    if ( n_written )
+        *n_written = x_written;
+    return status;
+}
+
+
+extern EIO_Status SOCK_SetZeroCopy(SOCK   sock,
+                                   size_t threshold)
+{
+    char _id[MAXIDLEN];
+
+    if (sock->sock == SOCK_INVALID) {
+        CORE_LOGF_X(70, eLOG_Error,
+                    ("%s[SOCK::SetZeroCopy] "
+                     " Invalid socket",
+                     s_ID(sock, _id)));
+        return eIO_Closed;
+    }
+    if (!threshold) {
+        sock->zc_min = 0;
+        return eIO_Success;
+    }
+#ifdef SOCK_ZEROCOPY
+    if (sock->type == eSOCK_Socket  &&  !sock->sslctx) {
+        int on = 1;
+        if (setsockopt(sock->sock, SOL_SOCKET, SO_ZEROCOPY,
+                       (char*) &on, sizeof(on)) == 0) {
+            sock->zc_min = threshold;
+            return eIO_Success;
+        } else {
+            int error = SOCK_ERRNO;
+            const char* strerr = SOCK_STRERROR(error);
+            CORE_LOGF_ERRNO_EXX(168, eLOG_Trace,
+                                error, strerr ? strerr : "",
+                                ("%s[SOCK::SetZeroCopy] "
+                                 " Failed setsockopt(SO_ZEROCOPY)",
+                                 s_ID(sock, _id)));
+            UTIL_ReleaseBuffer(strerr);
+        }
+    }
+#endif /*SOCK_ZEROCOPY*/
+    return eIO_NotSupported;
+}
+
+
+extern EIO_Status SOCK_GetZeroCopyStatus(SOCK          sock,
+                                         unsigned int* sent,
+                                         unsigned int* done)
+{
+#ifdef SOCK_ZEROCOPY
+    if (sock->sock != SOCK_INVALID  &&  sock->zc_sent != sock->zc_done)
+        s_ZeroCopyReap(sock);
+#endif /*SOCK_ZEROCOPY*/
+    if ( sent )
+        *sent = sock->zc_sent;
+    if ( done )
+        *done = sock->zc_done;
+    if (!sock->zc_min  &&  !sock->zc_sent)
+        return eIO_NotSupported;
+    return sock->zc_sent == sock->zc_done ? eIO_Success : eIO_Timeout;
+}
+
+
 extern EIO_Status SOCK_Abort(SOCK sock)
 {
     char _id[MAXIDLEN];
@@ -306,6 +306,11 @@ typedef struct SOCK_tag {
                                    SOCK:  total # of raw bytes written in all
                                    completed connections in this SOCK so far
                                 */
+    /* zero-copy sends, see SOCK_SetZeroCopy() */
+    size_t           zc_min;    /* min size to send w/o copying, 0 if off    */
+    unsigned int     zc_sent;   /* # of zero-copy sends issued               */
+    unsigned int     zc_done;   /* # of them that the kernel has completed   */
+
 #ifdef NCBI_OS_UNIX
     /* pathname for UNIX socket */
     char             path[1];   /* must go last                              */
@@ -0,0 +1,719 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  Anton Lavrentiev
+ *
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Process-wide cache of service resolutions
+ *
+ *   Cached entries are keyed by the final service name, the requested
+ *   server types, and the flags of the request that affect the mappers.
+ *   Each entry keeps a reference-counted immutable list of servers, which
+ *   gets shared with the iterators currently attached to it, so a refresh
+ *   just replaces the list.  Servers are selected out of the list by the
+ *   generic load-balancing procedure, just as the LOCAL mapper does.
+ *
+ */
+
+#include "ncbi_ansi_ext.h"
+#include "ncbi_lb.h"
+#include "ncbi_once.h"
+#include "ncbi_priv.h"
+#include "ncbi_srvcache.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+#if   defined(NCBI_CXX_TOOLKIT)  &&  defined(NCBI_POSIX_THREADS)
+#  include <pthread.h>
+#elif defined(NCBI_CXX_TOOLKIT)  &&  defined(NCBI_WIN32_THREADS)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif /*NCBI_CXX_TOOLKIT && NCBI_..._THREADS*/
+
+#define NCBI_USE_ERRCODE_X   Connect_Service
+
+
+#define SERV_CACHE_BUCKETS     256
+#define SERV_CACHE_DEF_SIZE    1000
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+    static SSERV_Info* s_GetNextInfo(SERV_ITER, HOST_INFO*);
+    static void        s_Close      (SERV_ITER);
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /*__cplusplus*/
+
+
+/* Immutable list of servers, shared between an entry and the iterators */
+typedef struct {
+    unsigned int  refcount;
+    size_t        n_info;
+    SSERV_Info**  info;
+} SCACHE_List;
+
+
+typedef struct SCACHE_EntryTag SCACHE_Entry;
+struct SCACHE_EntryTag {
+    SCACHE_Entry* next;         /* next in the hash bucket                   */
+    SCACHE_Entry* lru_prev;     /* more recently used                        */
+    SCACHE_Entry* lru_next;     /* less recently used                        */
+    char*         name;         /* final service name                        */
+    TSERV_Type    types;        /* requested types and flags                 */
+    unsigned int  flags;        /* other request flags (see x_Flags())       */
+    SConnNetInfo* net_info;     /* for refreshes, may be 0                   */
+    const char*   mapper;       /* original mapper, 0 for negative entry     */
+    SCACHE_List*  list;         /* servers, 0 for negative entry             */
+    TNCBI_Time    expires;      /* time of expiration                        */
+    TNCBI_Time    refresh;      /* time to refresh at, if used               */
+    unsigned      due:1;        /* whether scheduled for refresh             */
+    unsigned      refreshing:1; /* whether being refreshed right now         */
+};
+
+
+/* Iterator's private data */
+struct SCACHE_Data {
+    SSERV_VTable   op;          /* NB: keeps the name of the original mapper */
+    SCACHE_List*   list;
+    SLB_Candidate* cand;
+    size_t         n_cand;
+};
+
+
+static int/*bool*/        s_Inited       = 0/*false*/;
+static TNCBI_Time         s_Ttl          = 0;
+static TNCBI_Time         s_NegativeTtl  = 0;
+static size_t             s_MaxSize      = 0;
+static SCACHE_Entry*      s_Bucket[SERV_CACHE_BUCKETS];
+static SCACHE_Entry*      s_LruHead      = 0;
+static SCACHE_Entry*      s_LruTail      = 0;
+static SSERV_CacheStats   s_Stats;
+static FSERV_CacheRefresher s_Refresher  = 0;
+
+
+/* The cache has a lock of its own, so that its hits do not contend for the
+ * CORE lock (which is never acquired while the cache lock is being held).
+ * Without native threads, the CORE lock is used instead.
+ */
+#if   defined(NCBI_CXX_TOOLKIT)  &&  defined(NCBI_POSIX_THREADS)
+
+static pthread_mutex_t    s_Lock         = PTHREAD_MUTEX_INITIALIZER;
+#  define CACHE_LOCK      verify(pthread_mutex_lock  (&s_Lock) == 0)
+#  define CACHE_UNLOCK    verify(pthread_mutex_unlock(&s_Lock) == 0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+static void x_PreFork (void) { CACHE_LOCK;   }
+static void x_PostFork(void) { CACHE_UNLOCK; }
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /*__cplusplus*/
+
+#elif defined(NCBI_CXX_TOOLKIT)  &&  defined(NCBI_WIN32_THREADS)
+
+static SRWLOCK            s_Lock         = SRWLOCK_INIT;
+#  define CACHE_LOCK      AcquireSRWLockExclusive(&s_Lock)
+#  define CACHE_UNLOCK    ReleaseSRWLockExclusive(&s_Lock)
+
+#else
+
+#  define CACHE_LOCK      CORE_LOCK_WRITE
+#  define CACHE_UNLOCK    CORE_UNLOCK
+
+#endif /*NCBI_CXX_TOOLKIT && NCBI_..._THREADS*/
+
+
+/* Mappers that deliver complete server lists independently of the request
+ * context:  DISPD and LINKERD do not, and the service connector treats them
+ * specially.
+ */
+static const char* kCacheableMappers[] = {
+    "LOCAL", "LBSMD", "LBDNS", "LBNULL", "NAMERD"
+};
+
+
+/* Caller must NOT hold the lock:  the registry is read under the CORE lock */
+static void x_Init(void)
+{
+    TNCBI_Time ttl, negative_ttl;
+    size_t max_size;
+    char val[40];
+
+#if defined(NCBI_CXX_TOOLKIT)  &&  defined(NCBI_POSIX_THREADS)
+    /* a child must not inherit the lock held by another thread */
+    static void* /*bool*/ s_AtFork = 0/*false*/;
+    if (CORE_Once(&s_AtFork)
+        &&  pthread_atfork(x_PreFork, x_PostFork, x_PostFork) != 0) {
+        CORE_LOG_X(15, eLOG_Warning,
+                   "Cannot register service cache fork handlers");
+    }
+#endif /*NCBI_CXX_TOOLKIT && NCBI_POSIX_THREADS*/
+    ttl = negative_ttl = 0;
+    max_size = SERV_CACHE_DEF_SIZE;
+    if (ConnNetInfo_GetValueInternal(0, REG_CONN_SERVICE_CACHE_TTL,
+                                     val, sizeof(val), 0)  &&  *val) {
+        ttl = (TNCBI_Time) strtoul(val, 0, 10);
+    }
+    if (ttl) {
+        negative_ttl = ttl / 4 ? ttl / 4 : 1;
+        if (ConnNetInfo_GetValueInternal(0,
+                                         REG_CONN_SERVICE_CACHE_NEGATIVE_TTL,
+                                         val, sizeof(val), 0)  &&  *val) {
+            negative_ttl = (TNCBI_Time) strtoul(val, 0, 10);
+        }
+        if (ConnNetInfo_GetValueInternal(0, REG_CONN_SERVICE_CACHE_SIZE,
+                                         val, sizeof(val), 0)  &&  *val) {
+            max_size = (size_t) strtoul(val, 0, 10);
+        }
+    }
+
+    CACHE_LOCK;
+    if (!s_Inited) {
+        s_Ttl         = ttl;
+        s_NegativeTtl = negative_ttl;
+        s_MaxSize     = max_size;
+        s_Inited      = 1/*true*/;
+    }
+    CACHE_UNLOCK;
+}
+
+
+static unsigned int x_Flags(SERV_ITER iter, const SConnNetInfo* net_info)
+{
+    unsigned int flags = 0;
+    if (iter->external)
+        flags |= 1;
+    if (net_info)
+        flags |= net_info->lb_disable ? 4 : 2;
+    return flags;
+}
+
+
+/* Reconstruct the types and flags requested */
+static TSERV_Type x_Types(SERV_ITER iter)
+{
+    TSERV_Type types = iter->types;
+    if (iter->ok_down)
+        types |= fSERV_IncludeDown;
+    if (iter->ok_standby)
+        types |= fSERV_IncludeStandby;
+    if (iter->ok_reserved)
+        types |= fSERV_IncludeReserved;
+    if (iter->ok_suppressed)
+        types |= fSERV_IncludeSuppressed;
+    if (iter->ok_private)
+        types |= fSERV_IncludePrivate;
+    return types;
+}
+
+
+static int/*bool*/ x_IsCacheable(SERV_ITER iter)
+{
+    return !iter->ismask  &&  !iter->reverse_dns  &&  !iter->arglen
+        &&  iter->name  &&  *iter->name;
+}
+
+
+static size_t x_Hash(const char* name, TSERV_Type types, unsigned int flags)
+{
+    size_t hash = (size_t) types * 31 + flags;
+    while (*name)
+        hash = hash * 31 + (unsigned char) tolower((unsigned char)(*name++));
+    return hash % SERV_CACHE_BUCKETS;
+}
+
+
+/* Caller must hold the lock */
+static void x_ReleaseList(SCACHE_List* list)
+{
+    size_t n;
+    if (!list  ||  --list->refcount)
+        return;
+    for (n = 0;  n < list->n_info;  ++n)
+        free(list->info[n]);
+    if (list->info)
+        free(list->info);
+    free(list);
+}
+
+
+/* Caller must hold the lock */
+static void x_LruUnlink(SCACHE_Entry* entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        s_LruHead = entry->lru_next;
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        s_LruTail = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = 0;
+}
+
+
+/* Caller must hold the lock */
+static void x_LruPush(SCACHE_Entry* entry)
+{
+    entry->lru_prev = 0;
+    entry->lru_next = s_LruHead;
+    if (s_LruHead)
+        s_LruHead->lru_prev = entry;
+    else
+        s_LruTail = entry;
+    s_LruHead = entry;
+}
+
+
+/* Caller must hold the lock */
+static void x_Remove(SCACHE_Entry* entry)
+{
+    size_t hash = x_Hash(entry->name, entry->types, entry->flags);
+    SCACHE_Entry** ptr;
+    for (ptr = &s_Bucket[hash];  *ptr;  ptr = &(*ptr)->next) {
+        if (*ptr == entry) {
+            *ptr = entry->next;
+            break;
+        }
+    }
+    x_LruUnlink(entry);
+    x_ReleaseList(entry->list);
+    ConnNetInfo_Destroy(entry->net_info);
+    free(entry->name);
+    free(entry);
+    assert(s_Stats.entries);
+    --s_Stats.entries;
+}
+
+
+/* Caller must hold the lock */
+static SCACHE_Entry* x_Find(const char* name,
+                            TSERV_Type  types,
+                            unsigned    flags)
+{
+    SCACHE_Entry* entry;
+    for (entry = s_Bucket[x_Hash(name, types, flags)];  entry;
+         entry = entry->next) {
+        if (entry->types == types  &&  entry->flags == flags
+            &&  strcasecmp(entry->name, name) == 0) {
+            break;
+        }
+    }
+    return entry;
+}
+
+
+static SCACHE_List* x_CreateList(SSERV_Info** info, size_t n_info)
+{
+    SCACHE_List* list;
+    if (!(list = (SCACHE_List*) malloc(sizeof(*list))))
+        return 0;
+    list->refcount = 1;
+    list->n_info   = n_info;
+    list->info     = info;
+    return list;
+}
+
+
+/* Caller must hold the lock */
+static struct SCACHE_Data* x_NewData(const SCACHE_Entry* entry)
+{
+    struct SCACHE_Data* data;
+    size_t n_info = entry->list->n_info;
+    if (!(data = (struct SCACHE_Data*) calloc(1, sizeof(*data)
+                                             + n_info * sizeof(*data->cand)))){
+        return 0;
+    }
+    data->op.GetNextInfo = s_GetNextInfo;
+    data->op.Close       = s_Close;
+    data->op.mapper      = entry->mapper;
+    data->list           = entry->list;
+    data->cand           = (SLB_Candidate*)((char*) data + sizeof(*data));
+    entry->list->refcount++;
+    return data;
+}
+
+
+const SSERV_VTable* SERV_CACHE_Open(SERV_ITER           iter,
+                                    const SConnNetInfo* net_info,
+                                    int/*bool*/*        negative)
+{
+    struct SCACHE_Data* data;
+    SCACHE_Entry* entry;
+    int/*bool*/ due;
+    TSERV_Type types;
+    unsigned int flags;
+
+    *negative = 0/*false*/;
+    if (!x_IsCacheable(iter))
+        return 0;
+    types = x_Types(iter);
+    flags = x_Flags(iter, net_info);
+
+    if (!s_Inited)
+        x_Init();
+    CACHE_LOCK;
+    if (!s_Ttl) {
+        CACHE_UNLOCK;
+        return 0;
+    }
+    if (!(entry = x_Find(iter->name, types, flags))
+        ||  entry->expires <= iter->time) {
+        if (entry  &&  !entry->refreshing)
+            x_Remove(entry);
+        s_Stats.misses++;
+        CACHE_UNLOCK;
+        return 0;
+    }
+    x_LruUnlink(entry);
+    x_LruPush(entry);
+    if (!entry->list) {
+        s_Stats.negative_hits++;
+        CACHE_UNLOCK;
+        *negative = 1/*true*/;
+        return 0;
+    }
+    s_Stats.hits++;
+    due = 0/*false*/;
+    if (entry->refresh <= iter->time  &&  !entry->due) {
+        entry->due = 1/*true*/;
+        due = 1/*true*/;
+    }
+    data = x_NewData(entry);
+    CACHE_UNLOCK;
+    if (!data)
+        return 0;
+    iter->data = data;
+
+    if (g_NCBI_ConnectRandomSeed == 0) {
+        g_NCBI_ConnectRandomSeed  = iter->time ^ NCBI_CONNECT_SRAND_ADDEND;
+        srand(g_NCBI_ConnectRandomSeed);
+    }
+
+    if (due) {
+        FSERV_CacheRefresher refresher;
+        CACHE_LOCK;
+        refresher = s_Refresher;
+        CACHE_UNLOCK;
+        if (refresher)
+            refresher();
+        else
+            SERV_RefreshCache();
+    }
+    return &data->op;
+}
+
+
+int/*bool*/ SERV_CACHE_IsCacheable(SERV_ITER iter, const char* mapper)
+{
+    size_t n;
+    if (!x_IsCacheable(iter))
+        return 0/*false*/;
+    if (!s_Inited)
+        x_Init();
+    CACHE_LOCK;
+    n = s_Ttl ? 1 : 0;
+    CACHE_UNLOCK;
+    if (!n)
+        return 0/*false*/;
+    if (!mapper)
+        return 1/*true*/;
+    for (n = 0;  n < sizeof(kCacheableMappers)/sizeof(*kCacheableMappers);
+         ++n) {
+        if (strcmp(mapper, kCacheableMappers[n]) == 0)
+            return 1/*true*/;
+    }
+    return 0/*false*/;
+}
+
+
+const SSERV_VTable* SERV_CACHE_Add(SERV_ITER           iter,
+                                   const SConnNetInfo* net_info,
+                                   const char*         mapper,
+                                   SSERV_Info**        info,
+                                   size_t              n_info,
+                                   void**              attach)
+{
+    struct SCACHE_Data* data = 0;
+    SCACHE_Entry* entry;
+    SCACHE_List*  list;
+    TNCBI_Time    expires;
+    TSERV_Type    types;
+    unsigned int  flags;
+    size_t        n;
+
+    assert(x_IsCacheable(iter));
+    types = x_Types(iter);
+    flags = x_Flags(iter, net_info);
+    list  = 0;
+    if (mapper  &&  !(list = x_CreateList(info, n_info))) {
+        for (n = 0;  n < n_info;  ++n)
+            free(info[n]);
+        if (info)
+            free(info);
+        return 0;
+    }
+
+    if (!s_Inited)
+        x_Init();
+    CACHE_LOCK;
+    if (!s_Ttl  ||  !s_MaxSize  ||  (!list  &&  !s_NegativeTtl)) {
+        x_ReleaseList(list);
+        CACHE_UNLOCK;
+        return 0;
+    }
+    expires = iter->time + (list ? s_Ttl : s_NegativeTtl);
+    if (list) {
+        /* do not outlive the servers */
+        for (n = 0;  n < n_info;  ++n) {
+            if (info[n]->time  &&  info[n]->time < expires)
+                expires = info[n]->time;
+        }
+        if (expires <= iter->time)
+            expires  = iter->time + 1;
+    }
+    if ((entry = x_Find(iter->name, types, flags)) != 0) {
+        if (!list  &&  entry->list  &&  entry->expires > iter->time) {
+            /* keep servers that still work until they expire */
+            entry->refreshing = 0/*false*/;
+            entry->due        = 0/*false*/;
+            entry->refresh    = entry->expires;
+            CACHE_UNLOCK;
+            return 0;
+        }
+        if (entry->refreshing  &&  entry->list)
+            s_Stats.refreshes++;
+        x_ReleaseList(entry->list);
+        x_LruUnlink(entry);
+    } else {
+        char* name = strdup(iter->name);
+        if (!name
+            ||  !(entry = (SCACHE_Entry*) calloc(1, sizeof(*entry)))) {
+            if (name)
+                free(name);
+            x_ReleaseList(list);
+            CACHE_UNLOCK;
+            return 0;
+        }
+        entry->name     = name;
+        entry->types    = types;
+        entry->flags    = flags;
+        entry->net_info = net_info ? ConnNetInfo_Clone(net_info) : 0;
+        n = x_Hash(name, types, flags);
+        entry->next = s_Bucket[n];
+        s_Bucket[n] = entry;
+        if (++s_Stats.entries > s_MaxSize) {
+            assert(s_LruTail);
+            x_Remove(s_LruTail);
+            s_Stats.evictions++;
+        }
+    }
+    entry->mapper     = mapper;
+    entry->list       = list;
+    entry->expires    = expires;
+    entry->refresh    = iter->time + (expires - iter->time) * 3 / 4;
+    entry->due        = 0/*false*/;
+    entry->refreshing = 0/*false*/;
+    x_LruPush(entry);
+    if (attach  &&  list)
+        data = x_NewData(entry);
+    CACHE_UNLOCK;
+
+    if (!data)
+        return 0;
+    *attach = data;
+    return &data->op;
+}
+
+
+static SLB_Candidate* s_GetCandidate(void* user_data, size_t i)
+{
+    struct SCACHE_Data* data = (struct SCACHE_Data*) user_data;
+    return i < data->n_cand ? &data->cand[i] : 0;
+}
+
+
+static int/*bool*/ x_IsSkipped(SERV_ITER iter, const SSERV_Info* info)
+{
+    size_t n;
+    for (n = 0;  n < iter->n_skip;  ++n) {
+        if (SERV_EqualInfo(iter->skip[n], info))
+            return 1/*true*/;
+    }
+    return 0/*false*/;
+}
+
+
+static SSERV_Info* s_GetNextInfo(SERV_ITER iter, HOST_INFO* host_info)
+{
+    struct SCACHE_Data* data = (struct SCACHE_Data*) iter->data;
+    const SCACHE_List* list = data->list;
+    size_t i, n_standby = 0;
+    SSERV_Info* info;
+
+    /* active servers go first, and standby ones only if there are none */
+    data->n_cand = 0;
+    for (i = 0;  i < list->n_info;  ++i) {
+        const SSERV_Info* x_info = list->info[i];
+        if (!iter->ok_suppressed  &&  SERV_IfSuppressed(x_info))
+            continue;
+        if (!x_info->rate) {
+            if (!iter->ok_down)
+                continue;
+        } else if (x_info->rate < 0.0  &&  !iter->ok_standby) {
+            n_standby++;
+            continue;
+        }
+        if (x_IsSkipped(iter, x_info))
+            continue;
+        data->cand[data->n_cand].info   = x_info;
+        data->cand[data->n_cand].status = x_info->rate < 0.0
+            ? -x_info->rate : x_info->rate;
+        data->n_cand++;
+    }
+    if (!data->n_cand  &&  n_standby) {
+        for (i = 0;  i < list->n_info;  ++i) {
+            const SSERV_Info* x_info = list->info[i];
+            if (x_info->rate >= 0.0
+                ||  (!iter->ok_suppressed  &&  SERV_IfSuppressed(x_info))
+                ||  x_IsSkipped(iter, x_info)) {
+                continue;
+            }
+            data->cand[data->n_cand].info   = x_info;
+            data->cand[data->n_cand].status = -x_info->rate;
+            data->n_cand++;
+        }
+    }
+    if (!data->n_cand)
+        return 0;
+
+    i = data->n_cand > 1 ? LB_Select(iter, data, s_GetCandidate, 1.0) : 0;
+    if ((info = SERV_CopyInfo(data->cand[i].info)) != 0) {
+        if (info->rate > 0.0)
+            info->rate = data->cand[i].status;
+        if (host_info)
+            *host_info = 0;
+    }
+    return info;
+}
+
+
+static void s_Close(SERV_ITER iter)
+{
+    struct SCACHE_Data* data = (struct SCACHE_Data*) iter->data;
+    iter->data = 0;
+    CACHE_LOCK;
+    x_ReleaseList(data->list);
+    CACHE_UNLOCK;
+    free(data);
+}
+
+
+/***********************************************************************
+ *  EXTERNAL
+ ***********************************************************************/
+
+extern void SERV_GetCacheStats(SSERV_CacheStats* stats)
+{
+    CACHE_LOCK;
+    *stats = s_Stats;
+    CACHE_UNLOCK;
+}
+
+
+extern void SERV_FlushCache(void)
+{
+    CACHE_LOCK;
+    while (s_LruHead)
+        x_Remove(s_LruHead);
+    memset(&s_Stats, 0, sizeof(s_Stats));
+    s_Inited = 0/*false*/;
+    CACHE_UNLOCK;
+}
+
+
+extern void SERV_SetCacheRefresher(FSERV_CacheRefresher refresher)
+{
+    CACHE_LOCK;
+    s_Refresher = refresher;
+    CACHE_UNLOCK;
+}
+
+
+extern size_t SERV_RefreshCache(void)
+{
+    size_t n_refreshed = 0;
+
+    for (;;) {
+        SCACHE_Entry* entry;
+        SConnNetInfo* net_info;
+        TSERV_Type    types;
+        unsigned int  flags;
+        char*         name;
+
+        /* take one due entry at a time:  the table changes meanwhile */
+        CACHE_LOCK;
+        for (entry = s_LruHead;  entry;  entry = entry->lru_next) {
+            if (entry->due  &&  !entry->refreshing)
+                break;
+        }
+        if (!entry) {
+            CACHE_UNLOCK;
+            break;
+        }
+        entry->refreshing = 1/*true*/;
+        name     = strdup(entry->name);
+        types    = entry->types;
+        flags    = entry->flags;
+        net_info = entry->net_info ? ConnNetInfo_Clone(entry->net_info) : 0;
+        CACHE_UNLOCK;
+
+        if (name  &&  (!(flags & 6)  ||  net_info)
+            &&  SERV_CACHE_Resolve(name, types, net_info, flags & 1)) {
+            n_refreshed++;
+        }
+
+        /* if not refreshed, do not retry until the entry expires */
+        CACHE_LOCK;
+        if (name  &&  (entry = x_Find(name, types, flags)) != 0
+            &&  entry->refreshing) {
+            entry->refreshing = 0/*false*/;
+            entry->due        = 0/*false*/;
+            entry->refresh    = entry->expires;
+        }
+        CACHE_UNLOCK;
+        ConnNetInfo_Destroy(net_info);
+        if (!name)
+            break;
+        free(name);
+    }
+    return n_refreshed;
+}
@@ -0,0 +1,90 @@
+#ifndef CONNECT___NCBI_SRVCACHE__H
+#define CONNECT___NCBI_SRVCACHE__H
+
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Process-wide cache of service resolutions, which acts as a service
+ *   mapper for the iterators it serves
+ *
+ */
+
+#include "ncbi_servicep.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Attach "iter" to the cached resolution, if any (and if "iter" qualifies
+ * for caching), and return the virtual table, which reports the mapper name
+ * of the original resolution.  Set "*negative" to non-zero, if the cache
+ * knows that the resolution fails (0 gets returned then, too).
+ */
+const SSERV_VTable* SERV_CACHE_Open(SERV_ITER           iter,
+                                    const SConnNetInfo* net_info,
+                                    int/*bool*/*        negative);
+
+
+/* Whether the resolution of "iter" by "mapper" (0 for a failure) can be
+ * stored in the cache.
+ */
+int/*bool*/ SERV_CACHE_IsCacheable(SERV_ITER iter, const char* mapper);
+
+
+/* Store the resolution of "iter" done by "mapper":  "n_info" servers in
+ * "info" (the cache takes the ownership of the servers and of the array).
+ * A failure (no mapper found) is stored with "mapper" == 0.  If "attach" is
+ * non-zero, also prepare the cached servers for "iter":  return the virtual
+ * table and put the private data to be used as "iter->data" into "*attach"
+ * (unless 0 is returned).
+ */
+const SSERV_VTable* SERV_CACHE_Add(SERV_ITER           iter,
+                                   const SConnNetInfo* net_info,
+                                   const char*         mapper,
+                                   SSERV_Info**        info,
+                                   size_t              n_info,
+                                   void**              attach);
+
+
+/* Re-resolve the service (the final name of) bypassing the cache lookup,
+ * to store the fresh result in the cache (implemented in ncbi_service.c).
+ * Return non-zero if the service has been resolved.
+ */
+int/*bool*/ SERV_CACHE_Resolve(const char*         name,
+                               TSERV_Type          types,
+                               const SConnNetInfo* net_info,
+                               int/*bool*/         external);
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif /* CONNECT___NCBI_SRVCACHE__H */
@@ -38,6 +38,7 @@
 #include <connect/ncbi_mbedtls.h>
 #include <connect/ncbi_tls.h>
 #include <stdlib.h>
+#include <time.h>
 
 #define NCBI_USE_ERRCODE_X   Connect_TLS
 
@@ -218,3 +219,211 @@ extern void NcbiDeleteTlsCertCredentials(NCBI_CRED cred)
     cred->data = 0;
     free(cred);
 }
+
+
+/******************************************************************************
+ *  Client session resumption cache
+ */
+
+
+typedef struct SNcbiTlsSessionTag {
+    struct SNcbiTlsSessionTag* prev;  /* more recently used                  */
+    struct SNcbiTlsSessionTag* next;  /* less recently used                  */
+    TNCBI_Time                 expires;
+    int/*bool*/                once;  /* single-use (TLS 1.3 ticket)         */
+    size_t                     size;  /* of data following this header       */
+    const char*                key;   /* stored after the data               */
+} SNcbiTlsSession;
+
+
+static int/*bool*/          s_TlsSessionInited = 0/*false*/;
+static size_t               s_TlsSessionMax    = 0;
+static TNCBI_Time           s_TlsSessionTtl    = 0;
+static SNcbiTlsSession*     s_TlsSessionHead   = 0;  /* MRU */
+static SNcbiTlsSession*     s_TlsSessionTail   = 0;  /* LRU */
+static SNcbiTlsSessionStats s_TlsSessionStats;
+
+
+static void x_TlsSessionInit(void)
+{
+    size_t     max;
+    TNCBI_Time ttl;
+    char       val[40];
+
+    ConnNetInfo_GetValueInternal(0, REG_CONN_TLS_SESSION_CACHE,
+                                 val, sizeof(val), DEF_CONN_TLS_SESSION_CACHE);
+    max = (size_t) strtoul(val, 0, 10);
+    ConnNetInfo_GetValueInternal(0, REG_CONN_TLS_SESSION_TIMEOUT,
+                                 val, sizeof(val), DEF_CONN_TLS_SESSION_TIMEOUT);
+    ttl = (TNCBI_Time) strtoul(val, 0, 10);
+
+    CORE_LOCK_WRITE;
+    s_TlsSessionMax    = ttl ? max : 0;
+    s_TlsSessionTtl    = ttl;
+    s_TlsSessionInited = 1/*true*/;
+    CORE_UNLOCK;
+}
+
+
+/* NB: All x_ routines below are to be called under the lock */
+
+static void x_TlsSessionUnlink(SNcbiTlsSession* sess)
+{
+    if (sess->prev)
+        sess->prev->next = sess->next;
+    else
+        s_TlsSessionHead = sess->next;
+    if (sess->next)
+        sess->next->prev = sess->prev;
+    else
+        s_TlsSessionTail = sess->prev;
+    assert(s_TlsSessionStats.entries);
+    s_TlsSessionStats.entries--;
+}
+
+
+static void x_TlsSessionPush(SNcbiTlsSession* sess)
+{
+    sess->prev = 0;
+    sess->next = s_TlsSessionHead;
+    if (s_TlsSessionHead)
+        s_TlsSessionHead->prev = sess;
+    else
+        s_TlsSessionTail = sess;
+    s_TlsSessionHead = sess;
+    s_TlsSessionStats.entries++;
+}
+
+
+static SNcbiTlsSession* x_TlsSessionFind(const char* key)
+{
+    SNcbiTlsSession* sess;
+    for (sess = s_TlsSessionHead;  sess;  sess = sess->next) {
+        if (strcmp(sess->key, key) == 0)
+            break;
+    }
+    return sess;
+}
+
+
+char* NcbiTlsSessionKey(const char* provider, const SNcbiSSLctx* ctx)
+{
+    char   addr[80];
+    size_t len;
+    char*  key;
+
+    if (!s_TlsSessionInited)
+        x_TlsSessionInit();
+    /* Sessions established with client credentials are not cached:  the
+     * credentials' address does not identify them (it can get reused) */
+    if (!s_TlsSessionMax  ||  ctx->cred
+        ||  !SOCK_GetPeerAddressStringEx(ctx->sock, addr, sizeof(addr),
+                                         eSAF_Full)) {
+        return 0;
+    }
+    len = strlen(provider) + strlen(addr);
+    if (ctx->host)
+        len += strlen(ctx->host);
+    if ((key = (char*) malloc(len + 3/*2 seps + EOL*/)) != 0)
+        sprintf(key, "%s|%s|%s", provider, ctx->host ? ctx->host : "", addr);
+    return key;
+}
+
+
+void* NcbiTlsSessionGet(const char* key, size_t* size)
+{
+    TNCBI_Time       now = (TNCBI_Time) time(0);
+    SNcbiTlsSession* sess;
+    void*            data;
+
+    CORE_LOCK_WRITE;
+    if ((sess = x_TlsSessionFind(key)) != 0) {
+        x_TlsSessionUnlink(sess);
+        if (sess->expires <= now) {
+            free(sess);
+            sess = 0;
+        } else if (!sess->once)
+            x_TlsSessionPush(sess);
+    }
+    if (sess) {
+        s_TlsSessionStats.hits++;
+        if ((data = malloc(sess->size)) != 0) {
+            memcpy(data, sess + 1, sess->size);
+            *size = sess->size;
+        }
+        if (sess->once)
+            free(sess);
+    } else {
+        s_TlsSessionStats.misses++;
+        data = 0;
+    }
+    CORE_UNLOCK;
+    return data;
+}
+
+
+void NcbiTlsSessionPut(const char* key, const void* data, size_t size,
+                       int/*bool*/ once)
+{
+    size_t           len = strlen(key) + 1;
+    SNcbiTlsSession* sess;
+    SNcbiTlsSession* temp;
+
+    if (!size  ||  !(sess = (SNcbiTlsSession*) malloc(sizeof(*sess)
+                                                      + size + len))) {
+        return;
+    }
+    sess->once = once;
+    sess->size = size;
+    memcpy(sess + 1, data, size);
+    sess->key  = (const char*) memcpy((char*)(sess + 1) + size, key, len);
+
+    CORE_LOCK_WRITE;
+    sess->expires = (TNCBI_Time) time(0) + s_TlsSessionTtl;
+    if ((temp = x_TlsSessionFind(key)) != 0) {
+        x_TlsSessionUnlink(temp);
+        free(temp);
+    }
+    x_TlsSessionPush(sess);
+    s_TlsSessionStats.stores++;
+    while (s_TlsSessionStats.entries > s_TlsSessionMax) {
+        temp = s_TlsSessionTail;
+        x_TlsSessionUnlink(temp);
+        free(temp);
+        s_TlsSessionStats.evictions++;
+    }
+    CORE_UNLOCK;
+}
+
+
+void NcbiTlsSessionDone(int/*bool*/ resumed)
+{
+    CORE_LOCK_WRITE;
+    if (resumed)
+        s_TlsSessionStats.resumed++;
+    else
+        s_TlsSessionStats.full++;
+    CORE_UNLOCK;
+}
+
+
+extern void NcbiGetTlsSessionStats(SNcbiTlsSessionStats* stats)
+{
+    CORE_LOCK_READ;
+    *stats = s_TlsSessionStats;
+    CORE_UNLOCK;
+}
+
+
+extern void NcbiFlushTlsSessionCache(void)
+{
+    CORE_LOCK_WRITE;
+    while (s_TlsSessionHead) {
+        SNcbiTlsSession* sess = s_TlsSessionHead;
+        x_TlsSessionUnlink(sess);
+        free(sess);
+    }
+    memset(&s_TlsSessionStats, 0, sizeof(s_TlsSessionStats));
+    s_TlsSessionInited = 0/*false*/;
+    CORE_UNLOCK;
+}
@@ -48,6 +48,24 @@ NCBI_PARAM_DEF_EX(bool, server, Catch_Unhandled_Exceptions, true, 0,
 typedef NCBI_PARAM_TYPE(server, Catch_Unhandled_Exceptions) TParamServerCatchExceptions;
 static CSafeStatic<TParamServerCatchExceptions> s_ServerCatchExceptions;
 
+// "poll" - rebuild the poll vector on every iteration (default),
+// "epoll" - event-driven CServer_Reactor (Linux only)
+NCBI_PARAM_DECL(string, server, Reactor);
+NCBI_PARAM_DEF_EX(string, server, Reactor, "poll", 0, CSERVER_REACTOR);
+typedef NCBI_PARAM_TYPE(server, Reactor) TParamServerReactor;
+
+// Number of epoll main loops, each with its own SO_REUSEPORT listeners
+NCBI_PARAM_DECL(unsigned int, server, Reactor_Threads);
+NCBI_PARAM_DEF_EX(unsigned int, server, Reactor_Threads, 1, 0,
+                  CSERVER_REACTOR_THREADS);
+typedef NCBI_PARAM_TYPE(server, Reactor_Threads) TParamServerReactorThreads;
+
+// Process socket events in the main loop threads
+NCBI_PARAM_DECL(bool, server, Reactor_Inline);
+NCBI_PARAM_DEF_EX(bool, server, Reactor_Inline, false, 0,
+                  CSERVER_REACTOR_INLINE);
+typedef NCBI_PARAM_TYPE(server, Reactor_Inline) TParamServerReactorInline;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // IServer_MessageHandler implementation
@@ -594,18 +612,83 @@ CServer_Connection::~CServer_Connection()
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Additional epoll main loops (see [server] Reactor_Threads)
+
+class CServer_ReactorSet
+{
+public:
+    typedef vector<CServer_ConnectionPool*> TPools;
+
+    CServer_ReactorSet(void)
+        : stop(false), inline_requests(false), configured(false)
+    { }
+    ~CServer_ReactorSet()
+    {
+        ITERATE(TPools, it, pools) {
+            delete *it;
+        }
+    }
+
+    TPools                 pools;     ///< All but CServer::m_ConnectionPool
+    vector< CRef<CThread> > threads;  ///< One per pool, while running
+    atomic<bool>           stop;
+    bool                   inline_requests;
+    bool                   configured;
+};
+
+
+class CServer_ReactorThread : public CThread
+{
+public:
+    CServer_ReactorThread(CServer& server, CServer_ConnectionPool& pool)
+        : m_Server(server), m_Pool(pool)
+    { }
+
+protected:
+    virtual void* Main(void)
+    {
+        try {
+            m_Server.x_DoRunReactor(m_Pool, false);
+        }
+        NCBI_CATCH_ALL_X(11, "Server reactor thread failed");
+        return NULL;
+    }
+
+private:
+    CServer&                m_Server;
+    CServer_ConnectionPool& m_Pool;
+};
+
+
+static void s_DispatchRequest(CPoolOfThreads_ForServer* thread_pool,
+                              CStdRequest*              request,
+                              bool                      in_place)
+{
+    CRef<CStdRequest> req(request);
+    if (in_place) {
+        req->Process();
+    } else {
+        thread_pool->AcceptRequest(req);
+    }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // CServer implementation
 
 CServer::CServer(void) :
     m_Parameters(new SServer_Parameters()),
     m_ConnectionPool(NULL),
-    m_ThreadPool(NULL)
+    m_ThreadPool(NULL),
+    m_Reactors(NULL)
 {
     try {
         m_ConnectionPool = new CServer_ConnectionPool(
             m_Parameters->max_connections);
+        m_Reactors = new CServer_ReactorSet();
     } catch (...) {
+        delete m_ConnectionPool;
         delete m_Parameters;
         throw;
     }
@@ -616,6 +699,8 @@ CServer::~CServer()
 {
     delete m_ThreadPool;
     m_ThreadPool = NULL;
+    delete m_Reactors;
+    m_Reactors = NULL;
     delete m_ConnectionPool;
     m_ConnectionPool = NULL;
     delete m_Parameters;
@@ -626,13 +711,19 @@ CServer::~CServer()
 void CServer::AddListener(IServer_ConnectionFactory* factory,
                           unsigned short port)
 {
+    // Listeners added after StartListening() are served by the first
+    // main loop only
     m_ConnectionPool->Add(new CServer_Listener(factory, port), eListener);
 }
 
 
 bool CServer::RemoveListener(unsigned short  port)
 {
-    return m_ConnectionPool->RemoveListener(port);
+    bool removed = m_ConnectionPool->RemoveListener(port);
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->RemoveListener(port);
+    }
+    return removed;
 }
 
 
@@ -645,7 +736,17 @@ void CServer::SetParameters(const SServer_Parameters& new_params)
                    "CServer::SetParameters: Bad parameters");
     }
     *m_Parameters = new_params;
-    m_ConnectionPool->SetMaxConnections(m_Parameters->max_connections);
+    // The connection limit is split between the main loops
+    unsigned int max_connections = m_Parameters->max_connections;
+    if ( !m_Reactors->pools.empty() ) {
+        size_t n_loops  = m_Reactors->pools.size() + 1;
+        max_connections = (unsigned int)
+            ((max_connections + n_loops - 1) / n_loops);
+    }
+    m_ConnectionPool->SetMaxConnections(max_connections);
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->SetMaxConnections(max_connections);
+    }
 }
 
 
@@ -657,7 +758,81 @@ void CServer::GetParameters(SServer_Parameters* params)
 
 void CServer::StartListening(void)
 {
+    x_SetupReactors();
     m_ConnectionPool->StartListening();
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->StartListening();
+    }
+}
+
+
+void CServer::x_SetupReactors(void)
+{
+    if (m_Reactors->configured) {
+        return;
+    }
+    m_Reactors->configured = true;
+
+    unsigned int n_loops = TParamServerReactorThreads::GetDefault();
+    if (n_loops <= 1
+        &&  !NStr::EqualNocase(TParamServerReactor::GetDefault(), "epoll")) {
+        return;
+    }
+    if ( !m_ConnectionPool->EnableReactor() ) {
+        ERR_POST_X(11, Warning << "epoll reactor is not available, "
+                   "falling back to poll");
+        return;
+    }
+    m_Reactors->inline_requests = TParamServerReactorInline::GetDefault();
+
+    for (unsigned int i = 1;  i < n_loops;  ++i) {
+        unique_ptr<CServer_ConnectionPool> pool(
+            new CServer_ConnectionPool(m_Parameters->max_connections));
+        if ( !pool->EnableReactor() ) {
+            ERR_POST_X(11, Warning << "Cannot create more than " << i
+                       << " server reactors");
+            break;
+        }
+        m_ConnectionPool->ShareListeners(*pool);
+        m_Reactors->pools.push_back(pool.release());
+    }
+    SetParameters(*m_Parameters);
+}
+
+
+void CServer::x_StopReactors(void)
+{
+    m_Reactors->stop = true;
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->PingControlConnection();
+    }
+    NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Reactors->threads) {
+        (*it)->Join();
+    }
+    m_Reactors->threads.clear();
+}
+
+
+void CServer::GetReactorStats(vector<SServer_ReactorStats>* stats)
+{
+    stats->clear();
+    if ( !m_ConnectionPool->HasReactor() ) {
+        return;
+    }
+    CServer_ReactorSet::TPools pools(1, m_ConnectionPool);
+    pools.insert(pools.end(),
+                 m_Reactors->pools.begin(), m_Reactors->pools.end());
+    for (size_t i = 0;  i < pools.size();  ++i) {
+        CServer_ConnectionPool::SStats& pool_stats = pools[i]->GetStats();
+        SServer_ReactorStats s;
+        s.index       = (unsigned int) i;
+        s.connections = pools[i]->GetSize();
+        s.iterations  = pool_stats.iterations;
+        s.events      = pool_stats.events;
+        s.accepts     = pool_stats.accepts;
+        s.requests    = pool_stats.requests;
+        stats->push_back(s);
+    }
 }
 
 
@@ -680,6 +855,24 @@ void CServer::x_DoRun(void)
 
     Init();
 
+    if (m_ConnectionPool->HasReactor()) {
+        m_Reactors->stop = false;
+        ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+            CRef<CThread> thread(new CServer_ReactorThread(*this, **it));
+            thread->Run();
+            m_Reactors->threads.push_back(thread);
+        }
+        try {
+            x_DoRunReactor(*m_ConnectionPool, true);
+        }
+        catch (...) {
+            x_StopReactors();
+            throw;
+        }
+        x_StopReactors();
+        return;
+    }
+
     vector<CSocketAPI::SPoll> polls;
     size_t     count;
     typedef vector<IServer_ConnectionBase*> TConnsList;
@@ -790,6 +983,98 @@ void CServer::x_DoRun(void)
 }
 
 
+void CServer::x_DoRunReactor(CServer_ConnectionPool& pool, bool main_loop)
+{
+    static const STimeout kZeroTimeout = { 0, 0 };
+
+    typedef vector<CServer_ConnectionPool::TReadyConn> TReadyList;
+    typedef vector<IServer_ConnectionBase*> TConnsList;
+    TReadyList ready;
+    TConnsList timer_requests;
+    TConnsList revived_conns;
+    TConnsList to_close_conns;
+    TConnsList to_delete_conns;
+    STimeout timer_timeout;
+    const STimeout* timeout;
+    const STimeout* idle_timeout = m_Parameters->idle_timeout;
+    bool in_place = m_Reactors->inline_requests;
+    CServer_ConnectionPool::SStats& stats = pool.GetStats();
+
+    // Only the first loop talks to the application, the others are
+    // stopped by x_StopReactors()
+    while (main_loop ? !ShutdownRequested() : !m_Reactors->stop) {
+        ++stats.iterations;
+        bool has_timer = pool.GetReactorChanges(
+                                           ready, timer_requests, &timer_timeout,
+                                           revived_conns, to_close_conns,
+                                           to_delete_conns);
+
+        ITERATE(TConnsList, it, revived_conns) {
+            IServer_ConnectionBase* conn_base = *it;
+            EServIO_Event evt = IOEventToServIOEvent(conn_base->GetEventsToPollFor(NULL));
+            s_DispatchRequest(m_ThreadPool,
+                              conn_base->CreateRequest(evt, pool, idle_timeout),
+                              in_place);
+        }
+        ITERATE(TConnsList, it, to_close_conns) {
+            IServer_ConnectionBase* conn_base = *it;
+            s_DispatchRequest(m_ThreadPool,
+                              conn_base->CreateRequest(eServIO_Inactivity,
+                                                       pool, idle_timeout),
+                              in_place);
+        }
+        ITERATE(TConnsList, it, to_delete_conns) {
+            IServer_ConnectionBase* conn_base = *it;
+            s_DispatchRequest(m_ThreadPool,
+                              conn_base->CreateRequest(eServIO_Delete,
+                                                       pool, idle_timeout),
+                              in_place);
+        }
+        ITERATE(TConnsList, it, timer_requests) {
+            IServer_ConnectionBase* conn_base = *it;
+            s_DispatchRequest(m_ThreadPool,
+                              conn_base->CreateRequest(eServIO_Alarm,
+                                                       pool, idle_timeout),
+                              in_place);
+        }
+        stats.requests += revived_conns.size() + to_close_conns.size()
+            + to_delete_conns.size() + timer_requests.size();
+
+        // Connections with buffered input are ready already, just pick
+        // up whatever else is there
+        timeout = m_Parameters->accept_timeout;
+        if ( !ready.empty() ) {
+            timeout = &kZeroTimeout;
+        } else if (has_timer &&
+                   (timeout == kDefaultTimeout ||
+                    timeout == kInfiniteTimeout ||
+                    timer_timeout < *timeout)) {
+            timeout = &timer_timeout;
+        }
+
+        EIO_Status status = pool.WaitReactorEvents(ready, timeout);
+        if (status == eIO_Timeout) {
+            if (main_loop  &&  timeout == m_Parameters->accept_timeout) {
+                ProcessTimeout();
+            }
+        } else if (status != eIO_Success  &&  status != eIO_Interrupt) {
+            ERR_POST_X(8, Critical << "Reactor wait failed with status "
+                       << IO_StatusStr(status));
+        }
+
+        ITERATE(TReadyList, it, ready) {
+            s_DispatchRequest(m_ThreadPool,
+                              it->first->CreateRequest(
+                                  IOEventToServIOEvent(it->second),
+                                  pool, idle_timeout),
+                              in_place);
+        }
+        stats.events   += ready.size();
+        stats.requests += ready.size();
+    }
+}
+
+
 void CServer::Run(void)
 {
     StartListening(); // detect unavailable ports ASAP
@@ -805,6 +1090,9 @@ void CServer::Run(void)
             // while worker threads are active (or, worse, initializing).
             m_ThreadPool->KillAllThreads(true);
             m_ConnectionPool->Erase();
+            ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+                (*it)->Erase();
+            }
             throw;
         }
     }
@@ -819,8 +1107,14 @@ void CServer::Run(void)
     // We stop listening only here to provide port lock until application
     // cleaned up after execution.
     m_ConnectionPool->StopListening();
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->StopListening();
+    }
     // Here we finally free to erase connection pool.
     m_ConnectionPool->Erase();
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->Erase();
+    }
 }
 
 
@@ -854,13 +1148,20 @@ void CServer::AddConnectionToPool(CServer_Connection* conn)
 
 void CServer::RemoveConnectionFromPool(CServer_Connection* conn)
 {
+    // Not known which main loop serves it, and removing is harmless
     m_ConnectionPool->Remove(conn);
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->Remove(conn);
+    }
 }
 
 
 void CServer::WakeUpPollCycle(void)
 {
     m_ConnectionPool->PingControlConnection();
+    ITERATE(CServer_ReactorSet::TPools, it, m_Reactors->pools) {
+        (*it)->PingControlConnection();
+    }
 }
 
 
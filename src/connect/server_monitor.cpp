@@ -31,6 +31,7 @@
 
 #include <ncbi_pch.hpp>
 #include <connect/server_monitor.hpp>
+#include <connect/server.hpp>
 
 
 BEGIN_NCBI_SCOPE
@@ -102,6 +103,22 @@ void CServer_Monitor::SendString(const string& str)
 }
 
 
+void CServer_Monitor::SendReactorStats(CServer& server)
+{
+    vector<SServer_ReactorStats> stats;
+    server.GetReactorStats(&stats);
+    ITERATE(vector<SServer_ReactorStats>, it, stats) {
+        SendString("reactor " + NStr::UIntToString(it->index)
+                   + " connections=" + NStr::NumericToString(it->connections)
+                   + " iterations=" + NStr::NumericToString(it->iterations)
+                   + " events=" + NStr::NumericToString(it->events)
+                   + " accepts=" + NStr::NumericToString(it->accepts)
+                   + " requests=" + NStr::NumericToString(it->requests)
+                   + "\n");
+    }
+}
+
+
 bool CServer_Monitor::IsActive()
 {
     return IsMonitorActive();
@@ -0,0 +1,552 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Event-driven (epoll) backend of the threaded server
+ *
+ * ===========================================================================
+ */
+
+#include <ncbi_pch.hpp>
+#include "server_reactor.hpp"
+#include <connect/error_codes.hpp>
+
+#if defined(NCBI_OS_LINUX)
+#  define NCBI_SERVER_EPOLL 1
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <errno.h>
+#  include <limits.h>
+#  include <unistd.h>
+#endif
+
+#define NCBI_USE_ERRCODE_X   Connect_ThrServer
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+// CServer_TimerWheel implementation
+
+CServer_TimerWheel::CServer_TimerWheel(double tick, size_t n_slots)
+    : m_Slots(n_slots), m_Tick(tick), m_CurrentTick(-1), m_Size(0)
+{
+}
+
+
+void CServer_TimerWheel::Schedule(const STimer& timer)
+{
+    Int8 tick = x_GetTick(timer.deadline);
+    // Timers that are already due go to the current slot, which is
+    // looked at on every Advance()
+    if (m_CurrentTick >= 0  &&  tick < m_CurrentTick) {
+        tick = m_CurrentTick;
+    }
+    SSlot& slot = m_Slots[size_t(tick % Int8(m_Slots.size()))];
+    if (slot.timers.empty()  ||  timer.deadline < slot.min_deadline) {
+        slot.min_deadline = timer.deadline;
+    }
+    slot.timers.push_back(timer);
+    ++m_Size;
+}
+
+
+void CServer_TimerWheel::x_ProcessSlot(SSlot& slot, double now,
+                                       vector<STimer>& due)
+{
+    if (slot.timers.empty()  ||  slot.min_deadline > now) {
+        return;
+    }
+    // Timers of the later rounds stay in the slot
+    size_t kept = 0;
+    double min_deadline = 0.0;
+    for (size_t i = 0;  i < slot.timers.size();  ++i) {
+        const STimer& timer = slot.timers[i];
+        if (timer.deadline <= now) {
+            due.push_back(timer);
+            --m_Size;
+        } else {
+            if (kept == 0  ||  timer.deadline < min_deadline) {
+                min_deadline = timer.deadline;
+            }
+            slot.timers[kept++] = timer;
+        }
+    }
+    slot.timers.resize(kept);
+    slot.min_deadline = min_deadline;
+}
+
+
+void CServer_TimerWheel::Advance(double now, vector<STimer>& due)
+{
+    Int8 now_tick = x_GetTick(now);
+    Int8 n_slots  = Int8(m_Slots.size());
+    Int8 from     = m_CurrentTick;
+    if (from < 0  ||  now_tick - from >= n_slots) {
+        from = now_tick - n_slots + 1;
+    }
+    if (m_Size != 0) {
+        for (Int8 tick = from;  tick <= now_tick;  ++tick) {
+            x_ProcessSlot(m_Slots[size_t(tick % n_slots)], now, due);
+        }
+    }
+    if (now_tick > m_CurrentTick) {
+        m_CurrentTick = now_tick;
+    }
+}
+
+
+bool CServer_TimerWheel::GetNextDeadline(double* deadline) const
+{
+    if (m_Size == 0) {
+        return false;
+    }
+    bool found = false;
+    ITERATE(vector<SSlot>, it, m_Slots) {
+        if ( !it->timers.empty()
+             &&  (!found  ||  it->min_deadline < *deadline) ) {
+            *deadline = it->min_deadline;
+            found = true;
+        }
+    }
+    return found;
+}
+
+
+void CServer_TimerWheel::Clear(void)
+{
+    NON_CONST_ITERATE(vector<SSlot>, it, m_Slots) {
+        it->timers.clear();
+    }
+    m_Size = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// CServer_Reactor implementation
+
+#ifdef NCBI_SERVER_EPOLL
+
+static const size_t kMaxReactorEvents = 256;
+
+
+static int s_GetOSHandle(IServer_ConnectionBase* conn)
+{
+    const CPollable* pollable = dynamic_cast<const CPollable*>(conn);
+    int fd;
+    if ( !pollable
+         ||  pollable->GetOSHandle(&fd, sizeof(fd)) != eIO_Success ) {
+        return -1;
+    }
+    return fd;
+}
+
+
+CServer_Reactor::CServer_Reactor(void)
+    : m_Epoll(-1), m_WakeupFd(-1), m_WakeupPending(false), m_Generation(0),
+      m_EventBuf(kMaxReactorEvents * sizeof(struct epoll_event))
+{
+    m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_Epoll < 0) {
+        NCBI_THROW_FMT(CServer_Exception, eBadParameters,
+                       "epoll_create1() failed: " << strerror(errno));
+    }
+    m_WakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct epoll_event ev;
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (m_WakeupFd < 0
+        ||  epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_WakeupFd, &ev) != 0) {
+        int x_errno = errno;
+        if (m_WakeupFd >= 0) {
+            close(m_WakeupFd);
+        }
+        close(m_Epoll);
+        NCBI_THROW_FMT(CServer_Exception, eBadParameters,
+                       "Cannot create reactor wakeup event: "
+                       << strerror(x_errno));
+    }
+}
+
+
+CServer_Reactor::~CServer_Reactor()
+{
+    close(m_WakeupFd);
+    close(m_Epoll);
+}
+
+
+bool CServer_Reactor::IsSupported(void)
+{
+    return true;
+}
+
+
+CServer_Reactor::SConnInfo* CServer_Reactor::x_Register(TConnBase* conn,
+                                                        int*       op)
+{
+    int fd = s_GetOSHandle(conn);
+    if (fd < 0) {
+        return NULL;
+    }
+    SConnInfo& info = m_Conns[conn];
+    if (info.gen == 0  ||  info.fd != fd) {
+        // New connection, or a listener reopened on a different handle
+        // (the old one has gone from the epoll set when it was closed)
+        info.fd  = fd;
+        info.gen = ++m_Generation;
+        if (info.gen == 0) {
+            info.gen = ++m_Generation;
+        }
+        info.expiration_timer = info.alarm_timer = 0.0;
+        *op = EPOLL_CTL_ADD;
+    } else {
+        *op = EPOLL_CTL_MOD;
+    }
+    return &info;
+}
+
+
+static bool s_EpollCtl(int epoll, int op, int fd, struct epoll_event* ev)
+{
+    if (epoll_ctl(epoll, op, fd, ev) == 0) {
+        return true;
+    }
+    // The handle may have been left in the set by a connection that was
+    // removed without unregistering, or dropped by the kernel on close
+    if (op == EPOLL_CTL_ADD  &&  errno == EEXIST) {
+        return epoll_ctl(epoll, EPOLL_CTL_MOD, fd, ev) == 0;
+    }
+    if (op == EPOLL_CTL_MOD  &&  errno == ENOENT) {
+        return epoll_ctl(epoll, EPOLL_CTL_ADD, fd, ev) == 0;
+    }
+    return false;
+}
+
+
+bool CServer_Reactor::Arm(TConnBase* conn, EIO_Event events,
+                          double expiration, double alarm)
+{
+    int op;
+    SConnInfo* info = x_Register(conn, &op);
+    if ( !info ) {
+        m_Conns.erase(conn);
+        return false;
+    }
+    struct epoll_event ev;
+    ev.events   = EPOLLET | EPOLLONESHOT;
+    ev.data.ptr = conn;
+    if (events & eIO_Read) {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (events & eIO_Write) {
+        ev.events |= EPOLLOUT;
+    }
+    if ( !s_EpollCtl(m_Epoll, op, info->fd, &ev) ) {
+        ERR_POST_X(11, "Cannot add socket to the reactor: "
+                   << strerror(errno));
+        m_Conns.erase(conn);
+        return false;
+    }
+    info->listener   = false;
+    info->armed      = true;
+    info->events     = events;
+    info->expiration = expiration;
+    info->alarm      = alarm;
+    x_SetTimer(conn, *info, CServer_TimerWheel::eExpiration, expiration);
+    x_SetTimer(conn, *info, CServer_TimerWheel::eAlarm,      alarm);
+    return true;
+}
+
+
+bool CServer_Reactor::AddListener(TConnBase* listener)
+{
+    int op;
+    SConnInfo* info = x_Register(listener, &op);
+    if ( !info ) {
+        m_Conns.erase(listener);
+        return false;
+    }
+    struct epoll_event ev;
+    ev.events   = EPOLLIN;
+    ev.data.ptr = listener;
+    if ( !s_EpollCtl(m_Epoll, op, info->fd, &ev) ) {
+        ERR_POST_X(11, "Cannot add listening socket to the reactor: "
+                   << strerror(errno));
+        m_Conns.erase(listener);
+        return false;
+    }
+    info->listener = true;
+    info->armed    = true;
+    info->events   = eIO_Read;
+    return true;
+}
+
+
+void CServer_Reactor::Disarm(TConnBase* conn)
+{
+    TConns::iterator it = m_Conns.find(conn);
+    if (it == m_Conns.end()  ||  !it->second.armed) {
+        return;
+    }
+    struct epoll_event ev;
+    ev.events   = EPOLLONESHOT;
+    ev.data.ptr = conn;
+    epoll_ctl(m_Epoll, EPOLL_CTL_MOD, it->second.fd, &ev);
+    it->second.armed = false;
+}
+
+
+void CServer_Reactor::Remove(TConnBase* conn)
+{
+    TConns::iterator it = m_Conns.find(conn);
+    if (it == m_Conns.end()) {
+        return;
+    }
+    if (s_GetOSHandle(conn) == it->second.fd) {
+        struct epoll_event ev;  // for kernels before 2.6.9
+        epoll_ctl(m_Epoll, EPOLL_CTL_DEL, it->second.fd, &ev);
+    }
+    m_Conns.erase(it);
+}
+
+
+EIO_Event CServer_Reactor::Activate(const SEvent& event)
+{
+    TConns::iterator it = m_Conns.find(event.conn);
+    if (it == m_Conns.end()  ||  !it->second.armed) {
+        return eIO_Open;
+    }
+    SConnInfo& info = it->second;
+    if ( !info.listener ) {
+        info.armed = false;
+    }
+    // Errors and hangups are reported as readiness for the requested
+    // events, so that the handler gets the error from Read() or Write(),
+    // the same as with poll()
+    int events = eIO_Open;
+    if ((info.events & eIO_Read)
+        &&  (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        events |= eIO_Read;
+    }
+    if ((info.events & eIO_Write)
+        &&  (event.events & (EPOLLOUT | EPOLLHUP | EPOLLERR))) {
+        events |= eIO_Write;
+    }
+    return events ? EIO_Event(events) : info.events;
+}
+
+
+EIO_Status CServer_Reactor::Wait(vector<SEvent>& events,
+                                 const STimeout* timeout)
+{
+    int ms = -1;
+    if (timeout != kInfiniteTimeout  &&  timeout != kDefaultTimeout) {
+        Uint8 x_ms = Uint8(timeout->sec) * 1000 + (timeout->usec + 999) / 1000;
+        ms = x_ms > INT_MAX ? INT_MAX : int(x_ms);
+    }
+    struct epoll_event* ev = (struct epoll_event*) &m_EventBuf[0];
+    int n = epoll_wait(m_Epoll, ev, int(kMaxReactorEvents), ms);
+    if (n < 0) {
+        return errno == EINTR ? eIO_Interrupt : eIO_Unknown;
+    }
+    for (int i = 0;  i < n;  ++i) {
+        if (ev[i].data.ptr == NULL) {
+            // Clear the flag first: a Wakeup() after this point either
+            // writes again, or its change is seen by the caller anyway
+            m_WakeupPending = false;
+            Uint8 value;
+            while (read(m_WakeupFd, &value, sizeof(value)) > 0)
+                ;
+            continue;
+        }
+        SEvent event;
+        event.conn   = static_cast<TConnBase*>(ev[i].data.ptr);
+        event.events = ev[i].events;
+        events.push_back(event);
+    }
+    return n ? eIO_Success : eIO_Timeout;
+}
+
+
+void CServer_Reactor::Wakeup(void)
+{
+    if (m_WakeupPending.exchange(true)) {
+        return;
+    }
+    Uint8 value = 1;
+    if (write(m_WakeupFd, &value, sizeof(value)) < 0  &&  errno != EAGAIN) {
+        ERR_POST_X(11, Warning << "Cannot wake up the reactor: "
+                   << strerror(errno));
+    }
+}
+
+#else  /* !NCBI_SERVER_EPOLL */
+
+CServer_Reactor::CServer_Reactor(void)
+    : m_Epoll(-1), m_WakeupFd(-1), m_WakeupPending(false), m_Generation(0)
+{
+    NCBI_THROW(CServer_Exception, eBadParameters,
+               "Reactor is not supported on this platform");
+}
+
+CServer_Reactor::~CServer_Reactor()
+{
+}
+
+bool CServer_Reactor::IsSupported(void)
+{
+    return false;
+}
+
+CServer_Reactor::SConnInfo* CServer_Reactor::x_Register(TConnBase*, int*)
+{
+    return NULL;
+}
+
+bool CServer_Reactor::Arm(TConnBase*, EIO_Event, double, double)
+{
+    return false;
+}
+
+bool CServer_Reactor::AddListener(TConnBase*)
+{
+    return false;
+}
+
+void CServer_Reactor::Disarm(TConnBase*)
+{
+}
+
+void CServer_Reactor::Remove(TConnBase* conn)
+{
+    m_Conns.erase(conn);
+}
+
+EIO_Event CServer_Reactor::Activate(const SEvent&)
+{
+    return eIO_Open;
+}
+
+EIO_Status CServer_Reactor::Wait(vector<SEvent>&, const STimeout*)
+{
+    return eIO_NotSupported;
+}
+
+void CServer_Reactor::Wakeup(void)
+{
+}
+
+#endif /* NCBI_SERVER_EPOLL */
+
+
+void CServer_Reactor::x_SetTimer(TConnBase* conn, SConnInfo& info,
+                                 CServer_TimerWheel::ETimerType type,
+                                 double deadline)
+{
+    // At most one timer of each type per connection: a later deadline
+    // is handled when the pending timer fires
+    double& pending = type == CServer_TimerWheel::eExpiration
+        ? info.expiration_timer : info.alarm_timer;
+    if (deadline <= 0.0  ||  (pending != 0.0  &&  pending <= deadline)) {
+        return;
+    }
+    CServer_TimerWheel::STimer timer;
+    timer.conn     = conn;
+    timer.deadline = deadline;
+    timer.gen      = info.gen;
+    timer.type     = type;
+    m_Timers.Schedule(timer);
+    pending = deadline;
+}
+
+
+void CServer_Reactor::ProcessTimers(double now,
+                                    vector<TConnBase*>& expired,
+                                    vector<TConnBase*>& alarms)
+{
+    m_DueTimers.clear();
+    m_Timers.Advance(now, m_DueTimers);
+    ITERATE(vector<CServer_TimerWheel::STimer>, it, m_DueTimers) {
+        TConns::iterator conn_it = m_Conns.find(it->conn);
+        if (conn_it == m_Conns.end()  ||  conn_it->second.gen != it->gen) {
+            continue;
+        }
+        SConnInfo& info = conn_it->second;
+        bool is_expiration = it->type == CServer_TimerWheel::eExpiration;
+        double& pending = is_expiration
+            ? info.expiration_timer : info.alarm_timer;
+        if (pending != it->deadline) {
+            continue;   // superseded by an earlier timer
+        }
+        pending = 0.0;
+        double deadline = is_expiration ? info.expiration : info.alarm;
+        if ( !info.armed  ||  deadline == 0.0 ) {
+            // Re-scheduled when the connection is armed again
+            continue;
+        }
+        if (deadline > now) {
+            x_SetTimer(it->conn, info, it->type, deadline);
+            continue;
+        }
+        if (is_expiration) {
+            expired.push_back(it->conn);
+            Remove(it->conn);
+        } else {
+            alarms.push_back(it->conn);
+            Disarm(it->conn);
+        }
+    }
+}
+
+
+bool CServer_Reactor::GetTimerTimeout(double now, STimeout* timeout) const
+{
+    double deadline;
+    if ( !m_Timers.GetNextDeadline(&deadline) ) {
+        return false;
+    }
+    double delay = deadline - now;
+    if (delay <= 0.0) {
+        timeout->sec = timeout->usec = 0;
+    } else {
+        timeout->sec  = (unsigned int) delay;
+        timeout->usec = (unsigned int)((delay - timeout->sec) * 1000000.0);
+    }
+    return true;
+}
+
+
+void CServer_Reactor::Clear(void)
+{
+    m_Conns.clear();
+    m_Timers.Clear();
+}
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,234 @@
+#ifndef CONNECT___SERVER_REACTOR__HPP
+#define CONNECT___SERVER_REACTOR__HPP
+
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ */
+
+/// @file server_reactor.hpp
+/// Internal header for the event-driven (epoll) backend of CServer.
+
+
+#include <connect/impl/server_connection.hpp>
+#include <atomic>
+#include <unordered_map>
+
+
+/** @addtogroup ThreadedServer
+ *
+ * @{
+ */
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CServer_TimerWheel --
+///
+/// Hashed timer wheel for connection idle expirations and alarms.
+/// Scheduling is O(1); advancing the wheel only looks at the slots
+/// whose time has come. Timers cannot be cancelled - the owner checks
+/// whether a fired timer is still valid (see CServer_Reactor).
+/// Times are in seconds since the Epoch.
+///
+/// Not thread safe.
+
+class CServer_TimerWheel
+{
+public:
+    typedef IServer_ConnectionBase TConnBase;
+
+    enum ETimerType {
+        eExpiration,    ///< Idle timeout of an inactive connection
+        eAlarm          ///< Alarm requested by GetEventsToPollFor()
+    };
+
+    struct STimer {
+        TConnBase*   conn;
+        double       deadline;
+        unsigned int gen;
+        ETimerType   type;
+    };
+
+    CServer_TimerWheel(double tick = 0.01, size_t n_slots = 1024);
+
+    void Schedule(const STimer& timer);
+
+    /// Remove all timers with deadline not later than 'now' and
+    /// append them to 'due'.
+    void Advance(double now, vector<STimer>& due);
+
+    /// Get the earliest deadline.
+    /// @return
+    ///   false if there are no timers.
+    bool GetNextDeadline(double* deadline) const;
+
+    size_t GetSize(void) const { return m_Size; }
+
+    void Clear(void);
+
+private:
+    struct SSlot {
+        SSlot(void) : min_deadline(0.0) { }
+        vector<STimer> timers;
+        double         min_deadline;
+    };
+
+    Int8 x_GetTick(double t) const { return Int8(t / m_Tick); }
+    void x_ProcessSlot(SSlot& slot, double now, vector<STimer>& due);
+
+    vector<SSlot> m_Slots;
+    double        m_Tick;
+    Int8          m_CurrentTick;   ///< Last advanced tick, -1 if never
+    size_t        m_Size;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CServer_Reactor --
+///
+/// Edge-triggered epoll(7) based replacement of the poll vector that
+/// CServer_ConnectionPool rebuilds on every iteration of the server loop.
+/// A connection is registered once; after each event it is disarmed
+/// (EPOLLONESHOT) while a pool thread processes it, and it is re-armed
+/// when it becomes inactive again. Thus the cost of an iteration depends
+/// on the number of connections that changed state, not on the number
+/// of open connections. Listening sockets are level-triggered because
+/// only one connection is accepted per event.
+///
+/// Everything but Wait() and Wakeup() must be called with the connection
+/// pool mutex held.
+
+class CServer_Reactor
+{
+public:
+    typedef IServer_ConnectionBase TConnBase;
+
+    /// Raw event returned by Wait()
+    struct SEvent {
+        TConnBase*   conn;
+        unsigned int events;
+    };
+
+    CServer_Reactor(void);
+    ~CServer_Reactor();
+
+    /// Whether the OS supports the reactor.
+    static bool IsSupported(void);
+
+    /// Start polling a connection for 'events', once.
+    /// @param expiration
+    ///   Idle timeout (seconds since the Epoch), 0 if none.
+    /// @param alarm
+    ///   Alarm time, 0 if none.
+    bool Arm(TConnBase* conn, EIO_Event events,
+             double expiration, double alarm);
+
+    /// Start polling a listening socket (until Remove() is called).
+    bool AddListener(TConnBase* listener);
+
+    /// Stop polling a connection, but keep it registered.
+    void Disarm(TConnBase* conn);
+
+    /// Unregister a connection.  Its OS handle is removed from the epoll
+    /// set only if it is still open (a closed handle is removed by the
+    /// kernel, and its number may already belong to another socket).
+    void Remove(TConnBase* conn);
+
+    /// Convert a raw event into the events requested by Arm() and mark
+    /// the connection as not armed.
+    /// @return
+    ///   eIO_Open (i.e. no events) if the connection is no longer polled.
+    EIO_Event Activate(const SEvent& event);
+
+    /// Wait for events (without the pool mutex).
+    EIO_Status Wait(vector<SEvent>& events, const STimeout* timeout);
+
+    /// Interrupt Wait(), can be called from any thread.
+    void Wakeup(void);
+
+    /// Collect connections whose idle timeout or alarm time has come.
+    /// Expired connections are unregistered, alarmed ones are disarmed.
+    void ProcessTimers(double now,
+                       vector<TConnBase*>& expired,
+                       vector<TConnBase*>& alarms);
+
+    /// Get the time until the next timer.
+    /// @return
+    ///   false if there are no timers.
+    bool GetTimerTimeout(double now, STimeout* timeout) const;
+
+    /// Forget all connections (they must have been closed already).
+    void Clear(void);
+
+    size_t GetSize(void) const { return m_Conns.size(); }
+
+private:
+    struct SConnInfo {
+        SConnInfo(void)
+            : fd(-1), gen(0), listener(false), armed(false),
+              events(eIO_Open), expiration(0.0), alarm(0.0),
+              expiration_timer(0.0), alarm_timer(0.0)
+        { }
+        int          fd;
+        unsigned int gen;           ///< Tells reused addresses apart
+        bool         listener;
+        bool         armed;
+        EIO_Event    events;
+        double       expiration;
+        double       alarm;
+        double       expiration_timer;  ///< Deadline of the pending timer
+        double       alarm_timer;
+    };
+    typedef unordered_map<TConnBase*, SConnInfo> TConns;
+
+    SConnInfo* x_Register(TConnBase* conn, int* op);
+    void x_SetTimer(TConnBase* conn, SConnInfo& info,
+                    CServer_TimerWheel::ETimerType type,
+                    double deadline);
+
+    int                m_Epoll;
+    int                m_WakeupFd;
+    atomic<bool>       m_WakeupPending;
+    TConns             m_Conns;
+    unsigned int       m_Generation;
+    CServer_TimerWheel m_Timers;
+    vector<CServer_TimerWheel::STimer> m_DueTimers;
+    vector<char>       m_EventBuf;
+};
+
+
+END_NCBI_SCOPE
+
+
+/* @} */
+
+#endif  /* CONNECT___SERVER_REACTOR__HPP */
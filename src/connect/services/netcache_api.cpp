@@ -341,22 +341,9 @@ CNetServer::SExecResult SNetCacheAPIImpl::ExecMirrorAware(
     const CNetCacheAPIParameters* parameters,
     SNetServiceImpl::EServerErrorHandling error_handling)
 {
-    const string& key_service_name = key.GetServiceName();
-
-    bool key_has_service_name = !key_service_name.empty();
-
-    CNetService service(m_Service);
-
-    if (key_has_service_name && key_service_name != service.GetServiceName()) {
-        // NB: Configured service is always allowed
+    bool key_has_service_name = !key.GetServiceName().empty();
 
-        if (!m_ServiceMap.IsAllowed(key_service_name)) {
-            NCBI_THROW_FMT(CNetCacheException, eAccessDenied, "Service " <<
-                    key_service_name << " is not in the allowed services");
-        }
-
-        service = m_ServiceMap.GetServiceByName(key_service_name, m_Service);
-    }
+    CNetService service(x_GetKeyService(key));
 
     bool mirroring_allowed =
             !key.GetFlag(CNetCacheKey::fNCKey_SingleServer) &&
@@ -433,11 +420,38 @@ CNetServer::SExecResult SNetCacheAPIImpl::ExecMirrorAware(
         return exec_result;
     }
 
+    x_CheckKeyServer(key, service, primary_server, server_check);
+
+    return primary_server.ExecWithRetry(cmd, multiline_output);
+}
+
+CNetService SNetCacheAPIImpl::x_GetKeyService(const CNetCacheKey& key)
+{
+    const string& key_service_name = key.GetServiceName();
+
+    if (key_service_name.empty() ||
+            key_service_name == m_Service.GetServiceName())
+        return m_Service;
+
+    // NB: Configured service is always allowed
+
+    if (!m_ServiceMap.IsAllowed(key_service_name)) {
+        NCBI_THROW_FMT(CNetCacheException, eAccessDenied, "Service " <<
+                key_service_name << " is not in the allowed services");
+    }
+
+    return m_ServiceMap.GetServiceByName(key_service_name, m_Service);
+}
+
+void SNetCacheAPIImpl::x_CheckKeyServer(const CNetCacheKey& key,
+        CNetService& service, CNetServer& primary_server,
+        ESwitch server_check)
+{
     // If enabled, check if the server belongs to the selected service
     if (server_check != eOff && !service->IsInService(primary_server)) {
 
         // Service name is known, no need to check other services
-        if (key_has_service_name) {
+        if (!key.GetServiceName().empty()) {
             NCBI_THROW_FMT(CNetSrvConnException, eServerNotInService,
                     key.GetKey() << ": NetCache server " <<
                     primary_server.GetServerAddress() << " could not be "
@@ -454,8 +468,47 @@ CNetServer::SExecResult SNetCacheAPIImpl::ExecMirrorAware(
         }
 
     }
+}
 
-    return primary_server.ExecWithRetry(cmd, multiline_output);
+CNetServer SNetCacheAPIImpl::GetKeyServer(const CNetCacheKey& key,
+        const CNetCacheAPIParameters* parameters)
+{
+    CNetService service(x_GetKeyService(key));
+
+    if (key.GetVersion() == 3) {
+        if (!service.IsLoadBalanced()) {
+            NCBI_THROW_FMT(CNetSrvConnException, eLBNameNotFound,
+                key.GetKey() << ": NetCache key version 3 "
+                "requires an LBSM service name.");
+        }
+
+        Uint4 crc32 = key.GetHostPortCRC32();
+
+        for (CNetServiceIterator it(service.Iterate()); it; ++it) {
+            CNetServer server(*it);
+
+            if (CNetCacheKey::CalculateChecksum(
+                    CSocketAPI::ntoa(server.GetHost()),
+                            server.GetPort()) == crc32)
+                return server;
+        }
+
+        NCBI_THROW_FMT(CNetSrvConnException, eServerNotInService,
+                key.GetKey() << ": unable to find a NetCache server "
+                "by the checksum from this key.");
+    }
+
+    CNetServer primary_server(service.GetServer(key.GetHost(), key.GetPort()));
+
+    ESwitch server_check = eDefault;
+    parameters->GetServerCheck(&server_check);
+    if (server_check == eDefault)
+        server_check = key.GetFlag(CNetCacheKey::fNCKey_NoServerCheck) ?
+                eOff : eOn;
+
+    x_CheckKeyServer(key, service, primary_server, server_check);
+
+    return primary_server;
 }
 
 CNetCacheAPI::CNetCacheAPI(CNetCacheAPI::EAppRegistry /* use_app_reg */,
@@ -577,37 +630,43 @@ CNetServerConnection SNetCacheAPIImpl::InitiateWriteCmd(
                 " in response to PUT3 \"" << stripped_blob_id << "\"");
         }
     } else {
-        if (m_Service.IsLoadBalanced()) {
-            CNetCacheKey::TNCKeyFlags key_flags = 0;
+        nc_writer->SetBlobID(MakeNewBlobKey(exec_result.response,
+                exec_result.conn->m_Server, parameters));
+    }
 
-            switch (parameters->GetMirroringMode()) {
-            case CNetCacheAPI::eMirroringDisabled:
-                key_flags |= CNetCacheKey::fNCKey_SingleServer;
-                break;
-            case CNetCacheAPI::eMirroringEnabled:
-                break;
-            default:
-                if (!exec_result.conn->m_Server->Get<SNetCacheServerProperties>()->mirrored)
-                    key_flags |= CNetCacheKey::fNCKey_SingleServer;
-            }
+    return exec_result.conn;
+}
 
-            bool server_check_hint = true;
-            parameters->GetServerCheckHint(&server_check_hint);
-            if (!server_check_hint)
-                key_flags |= CNetCacheKey::fNCKey_NoServerCheck;
+string SNetCacheAPIImpl::MakeNewBlobKey(string key, CNetServer& server,
+        const CNetCacheAPIParameters* parameters)
+{
+    if (m_Service.IsLoadBalanced()) {
+        CNetCacheKey::TNCKeyFlags key_flags = 0;
 
-            CNetCacheKey::AddExtensions(exec_result.response,
-                    m_Service.GetServiceName(), key_flags);
+        switch (parameters->GetMirroringMode()) {
+        case CNetCacheAPI::eMirroringDisabled:
+            key_flags |= CNetCacheKey::fNCKey_SingleServer;
+            break;
+        case CNetCacheAPI::eMirroringEnabled:
+            break;
+        default:
+            if (!server->Get<SNetCacheServerProperties>()->mirrored)
+                key_flags |= CNetCacheKey::fNCKey_SingleServer;
         }
 
-        if (parameters->GetUseCompoundID())
-            exec_result.response = CNetCacheKey::KeyToCompoundID(
-                    exec_result.response, m_CompoundIDPool);
+        bool server_check_hint = true;
+        parameters->GetServerCheckHint(&server_check_hint);
+        if (!server_check_hint)
+            key_flags |= CNetCacheKey::fNCKey_NoServerCheck;
 
-        nc_writer->SetBlobID(exec_result.response);
+        CNetCacheKey::AddExtensions(key,
+                m_Service.GetServiceName(), key_flags);
     }
 
-    return exec_result.conn;
+    if (parameters->GetUseCompoundID())
+        key = CNetCacheKey::KeyToCompoundID(key, m_CompoundIDPool);
+
+    return key;
 }
 
 
@@ -706,6 +765,440 @@ void CNetCacheAPI::Remove(const string& blob_id,
     }
 }
 
+// Send the command to the server the key points to without waiting; "set"
+// turns the reply into the value of the returned future. Errors, including
+// those that occur before the command is sent, go to the future as well.
+template <typename TResult, class TSetter>
+static future<TResult> s_ExecAsync(SNetCacheAPIImpl* impl,
+        const char* cmd_base, const string& blob_id,
+        const CNamedParameterList* optional, TSetter set)
+{
+    auto result = make_shared<promise<TResult>>();
+    auto rv = result->get_future();
+
+    auto handler = [result, set](const string& response, exception_ptr error) {
+        if (!error) {
+            try {
+                set(*result, response);
+                return;
+            }
+            catch (...) {
+                error = current_exception();
+            }
+        }
+
+        result->set_exception(error);
+    };
+
+    try {
+        CNetCacheKey key(blob_id, impl->m_CompoundIDPool);
+
+        CNetCacheAPIParameters parameters(&impl->m_DefaultParameters);
+
+        parameters.LoadNamedParameters(optional);
+
+        impl->GetKeyServer(key, &parameters).ExecAsync(
+                impl->MakeCmd(cmd_base, key, &parameters), handler);
+    }
+    catch (...) {
+        handler(kEmptyStr, current_exception());
+    }
+
+    return rv;
+}
+
+future<bool> CNetCacheAPI::HasBlobAsync(const string& blob_id,
+        const CNamedParameterList* optional)
+{
+    return s_ExecAsync<bool>(m_Impl, "HASB ", blob_id, optional,
+            [](promise<bool>& result, const string& response) {
+                result.set_value(response[0] == '1');
+            });
+}
+
+future<size_t> CNetCacheAPI::GetBlobSizeAsync(const string& blob_id,
+        const CNamedParameterList* optional)
+{
+    return s_ExecAsync<size_t>(m_Impl, "GSIZ ", blob_id, optional,
+            [](promise<size_t>& result, const string& response) {
+                result.set_value(CheckBlobSize(
+                        NStr::StringToUInt8(response)));
+            });
+}
+
+future<void> CNetCacheAPI::RemoveAsync(const string& blob_id,
+        const CNamedParameterList* optional)
+{
+    return s_ExecAsync<void>(m_Impl, "RMV2 ", blob_id, optional,
+            [](promise<void>& result, const string&) {
+                result.set_value();
+            });
+}
+
+// Maximum number of items sent in one MGET/MPUT command. The whole command
+// is written before reading the replies, so it must be small enough to fit
+// into socket buffers: otherwise, the server may block writing the replies
+// to the early items while the client is still writing the later ones.
+static const size_t kMaxBatchCmdItems = 256;
+
+// Amount of blob data accumulated before writing it to the socket.
+static const size_t kBatchWriteBufferSize = 1024 * 1024;
+
+// Items of a batch that go to the same server, along with the arguments of
+// their commands. The arguments are prepared in the calling thread
+// because they include data from the (thread-local) request context.
+struct SNetCacheBatchGroup
+{
+    CNetServer server;
+    vector<SNetCacheBatchItem*> items;
+    vector<string> cmds;
+};
+
+static void s_WriteBatchData(SNetServerConnectionImpl* conn,
+        const string& data)
+{
+    const char* buf = data.data();
+    size_t len = data.size();
+
+    while (len > 0) {
+        size_t n_written;
+
+        EIO_Status io_st = conn->m_Socket.Write(buf, len, &n_written);
+
+        if (io_st != eIO_Success) {
+            conn->Abort();
+
+            CONNSERV_THROW_FMT(CNetSrvConnException, eWriteFailure,
+                conn->m_Server, "Failed to write: " << IO_StatusStr(io_st));
+        }
+        len -= n_written;
+        buf += n_written;
+    }
+}
+
+// Append blob contents in the chunked format of the blob transfer protocol.
+static void s_AppendBatchBlob(string& request, const string& data)
+{
+    static const Uint4 kSignature = 0x01020304;
+    static const Uint4 kEndOfData = 0xFFFFFFFF;
+    static const size_t kMaxChunkSize = 0x40000000;
+
+    request.append(reinterpret_cast<const char*>(&kSignature),
+            sizeof(kSignature));
+
+    for (size_t offset = 0; offset < data.size(); ) {
+        Uint4 chunk_size = Uint4(min(data.size() - offset, kMaxChunkSize));
+
+        request.append(reinterpret_cast<const char*>(&chunk_size),
+                sizeof(chunk_size));
+        request.append(data, offset, chunk_size);
+        offset += chunk_size;
+    }
+
+    request.append(reinterpret_cast<const char*>(&kEndOfData),
+            sizeof(kEndOfData));
+}
+
+class CNetCacheBatchExecHandler : public INetServerExecHandler
+{
+public:
+    CNetCacheBatchExecHandler(SNetCacheAPIImpl* impl,
+            SNetCacheBatchGroup& group, const string& batch_cmd, bool put,
+            const CNetCacheAPIParameters* parameters) :
+        m_Impl(impl),
+        m_Group(group),
+        m_BatchCmd(batch_cmd),
+        m_Put(put),
+        m_Parameters(parameters)
+    {
+    }
+
+    virtual void Exec(CNetServerConnection::TInstance conn_impl,
+            const STimeout* timeout);
+
+private:
+    void x_ReadReply(SNetServerConnectionImpl* conn,
+            SNetCacheBatchItem& item);
+
+    SNetCacheAPIImpl* m_Impl;
+    SNetCacheBatchGroup& m_Group;
+    const string& m_BatchCmd;
+    bool m_Put;
+    const CNetCacheAPIParameters* m_Parameters;
+};
+
+void CNetCacheBatchExecHandler::Exec(
+        CNetServerConnection::TInstance conn_impl, const STimeout* timeout)
+{
+    CTimeoutKeeper timeout_keeper(&conn_impl->m_Socket, timeout);
+
+    // Exec() is repeated if a pooled connection turns out to be closed;
+    // the items that have been processed by then are not sent again.
+    vector<size_t> pending;
+
+    for (size_t i = 0; i < m_Group.items.size(); ++i)
+        if (m_Group.items[i]->status == SNetCacheBatchItem::eNotProcessed)
+            pending.push_back(i);
+
+    try {
+        for (size_t begin = 0; begin < pending.size();
+                begin += kMaxBatchCmdItems) {
+            size_t end = min(begin + kMaxBatchCmdItems, pending.size());
+
+            string request(m_BatchCmd);
+            request.push_back(' ');
+            request.append(NStr::NumericToString(end - begin));
+            request.append("\r\n");
+
+            for (size_t i = begin; i < end; ++i) {
+                request.append(m_Group.cmds[pending[i]]);
+                request.append("\r\n");
+
+                if (m_Put) {
+                    s_AppendBatchBlob(request,
+                            m_Group.items[pending[i]]->data);
+
+                    if (request.size() >= kBatchWriteBufferSize) {
+                        s_WriteBatchData(conn_impl, request);
+                        request.clear();
+                    }
+                }
+            }
+
+            s_WriteBatchData(conn_impl, request);
+
+            for (size_t i = begin; i < end; ++i)
+                x_ReadReply(conn_impl, *m_Group.items[pending[i]]);
+        }
+    }
+    catch (...) {
+        conn_impl->Abort();
+        throw;
+    }
+}
+
+void CNetCacheBatchExecHandler::x_ReadReply(SNetServerConnectionImpl* conn,
+        SNetCacheBatchItem& item)
+{
+    string response;
+
+    // Error replies of the individual items are reported through
+    // CNetCacheException and do not break the batch; anything else does.
+    try {
+        conn->ReadCmdOutputLine(response, false);
+
+        if (m_Put) {
+            string new_key;
+
+            // PUT3 returns the key first (ICache STOR returns nothing).
+            if (item.key.empty() && NStr::StartsWith(response, "ID:"))
+                new_key = m_Impl->MakeNewBlobKey(response.substr(3),
+                        conn->m_Server, m_Parameters);
+
+            // Confirmation that the blob has been written.
+            conn->ReadCmdOutputLine(response, false);
+
+            if (!new_key.empty())
+                item.key = new_key;
+        } else {
+            string::size_type pos = response.find("SIZE=");
+
+            if (pos == string::npos) {
+                CONNSERV_THROW_FMT(CNetServiceException, eCommunicationError,
+                    conn->m_Server,
+                    "No SIZE field in reply to the blob reading command");
+            }
+
+            size_t blob_size = CheckBlobSize(NStr::StringToUInt8(
+                    response.c_str() + pos + sizeof("SIZE=") - 1,
+                    NStr::fAllowTrailingSymbols));
+
+            item.data.resize(blob_size);
+
+            size_t n_read = 0;
+            EIO_Status io_st = blob_size == 0 ? eIO_Success :
+                conn->m_Socket.Read(&item.data[0], blob_size,
+                        &n_read, eIO_ReadPersist);
+
+            if (n_read != blob_size) {
+                item.data.clear();
+
+                if (io_st == eIO_Timeout) {
+                    CONNSERV_THROW_FMT(CNetServiceException, eTimeout,
+                        conn->m_Server,
+                        "Timeout while reading blob contents");
+                }
+
+                CONNSERV_THROW_FMT(CNetServiceException, eCommunicationError,
+                    conn->m_Server,
+                    "Error while reading blob: " << IO_StatusStr(io_st));
+            }
+        }
+
+        item.status = SNetCacheBatchItem::eOK;
+    }
+    catch (CNetCacheBlobTooOldException& e) {
+        item.status = SNetCacheBatchItem::eNotFound;
+        item.error_message = e.GetMsg();
+    }
+    catch (CNetCacheException& e) {
+        item.status = e.GetErrCode() == CNetCacheException::eBlobNotFound ?
+                SNetCacheBatchItem::eNotFound : SNetCacheBatchItem::eError;
+        item.error_message = e.GetMsg();
+    }
+}
+
+static void s_ExecBatchGroup(SNetCacheAPIImpl* impl,
+        SNetCacheBatchGroup& group, const string& batch_cmd, bool put,
+        const CNetCacheAPIParameters* parameters)
+{
+    string error;
+
+    try {
+        CNetCacheBatchExecHandler handler(impl, group, batch_cmd, put,
+                parameters);
+
+        group.server->TryExec(handler);
+        return;
+    }
+    catch (CException& e) {
+        error = e.GetMsg();
+    }
+    catch (exception& e) {
+        error = e.what();
+    }
+
+    for (auto item : group.items) {
+        if (item->status == SNetCacheBatchItem::eNotProcessed) {
+            item->status = SNetCacheBatchItem::eError;
+            item->error_message = error;
+        }
+    }
+}
+
+void SNetCacheAPIImpl::ExecBatch(vector<SNetCacheBatchItem>& items, bool put,
+        const CNetCacheAPIParameters* parameters)
+{
+    map<SNetServerInPool*, SNetCacheBatchGroup> groups;
+    CNetServiceIterator new_blob_servers;
+
+    for (auto& item : items) {
+        item.status = SNetCacheBatchItem::eNotProcessed;
+        item.error_message.clear();
+        if (!put)
+            item.data.clear();
+
+        try {
+            CNetServer server(GetBatchItemServer(item, parameters));
+
+            // New blobs are spread evenly over the servers.
+            if (!server) {
+                if (!new_blob_servers || !new_blob_servers.Next())
+                    new_blob_servers = m_Service.Iterate(
+                            CNetService::eRandomize);
+
+                if (!new_blob_servers) {
+                    NCBI_THROW_FMT(CNetSrvConnException, eSrvListEmpty,
+                            m_Service.GetServiceName() <<
+                            ": no servers to write new blobs to");
+                }
+
+                server = *new_blob_servers;
+            }
+
+            string cmd(MakeBatchItemCmd(item, put, parameters));
+
+            SNetCacheBatchGroup& group(groups[server->m_ServerInPool]);
+            if (!group.server)
+                group.server = server;
+            group.items.push_back(&item);
+            group.cmds.push_back(cmd);
+        }
+        catch (CException& e) {
+            item.status = SNetCacheBatchItem::eError;
+            item.error_message = e.GetMsg();
+        }
+    }
+
+    if (groups.empty())
+        return;
+
+    string batch_cmd(MakeBatchCmd(put, parameters));
+
+    // All groups but the first one are processed in separate threads.
+    vector<future<void>> results;
+
+    for (auto it = next(groups.begin()); it != groups.end(); ++it) {
+        results.push_back(async(launch::async, s_ExecBatchGroup,
+                this, ref(it->second), cref(batch_cmd), put, parameters));
+    }
+
+    s_ExecBatchGroup(this, groups.begin()->second, batch_cmd, put,
+            parameters);
+
+    for (auto& result : results)
+        result.get();
+}
+
+CNetServer SNetCacheAPIImpl::GetBatchItemServer(
+        const SNetCacheBatchItem& item,
+        const CNetCacheAPIParameters* parameters)
+{
+    if (item.key.empty())
+        return CNetServer();
+
+    CNetCacheKey key(item.key, m_CompoundIDPool);
+
+    return GetKeyServer(key, parameters);
+}
+
+string SNetCacheAPIImpl::MakeBatchCmd(bool put,
+        const CNetCacheAPIParameters* /*parameters*/)
+{
+    return put ? "MPUT" : "MGET";
+}
+
+string SNetCacheAPIImpl::MakeBatchItemCmd(const SNetCacheBatchItem& item,
+        bool put, const CNetCacheAPIParameters* parameters)
+{
+    if (!put)
+        return MakeCmd("", CNetCacheKey(item.key, m_CompoundIDPool),
+                parameters);
+
+    string cmd(NStr::IntToString(parameters->GetTTL()));
+
+    if (!item.key.empty()) {
+        cmd.push_back(' ');
+        cmd.append(CNetCacheKey(item.key,
+                m_CompoundIDPool).StripKeyExtensions());
+    }
+
+    AppendClientIPSessionIDPasswordAgeHitID(&cmd, parameters);
+    if (m_FlagsOnWrite) cmd.append(" flags=").append(to_string(m_FlagsOnWrite));
+
+    return cmd;
+}
+
+void CNetCacheAPI::ReadDataBatch(vector<SNetCacheBatchItem>& items,
+        const CNamedParameterList* optional)
+{
+    CNetCacheAPIParameters parameters(&m_Impl->m_DefaultParameters);
+
+    parameters.LoadNamedParameters(optional);
+
+    m_Impl->ExecBatch(items, false, &parameters);
+}
+
+void CNetCacheAPI::PutDataBatch(vector<SNetCacheBatchItem>& items,
+        const CNamedParameterList* optional)
+{
+    CNetCacheAPIParameters parameters(&m_Impl->m_DefaultParameters);
+
+    parameters.LoadNamedParameters(optional);
+
+    m_Impl->ExecBatch(items, true, &parameters);
+}
+
 CNetServerMultilineCmdOutput CNetCacheAPI::GetBlobInfo(const string& blob_id,
         const CNamedParameterList* optional)
 {
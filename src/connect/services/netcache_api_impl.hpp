@@ -102,6 +102,27 @@ struct NCBI_XCONNECT_EXPORT SNetCacheAPIImpl : public CObject
     virtual CNetServerConnection InitiateWriteCmd(CNetCacheWriter* nc_writer,
             const CNetCacheAPIParameters* parameters);
 
+    // Add the service name and key flags to the key of a blob
+    // just created on "server" and, if requested, convert it to CompoundID.
+    string MakeNewBlobKey(string key, CNetServer& server,
+            const CNetCacheAPIParameters* parameters);
+
+    // Read or write the items grouping them by server, see ReadDataBatch().
+    void ExecBatch(vector<SNetCacheBatchItem>& items, bool put,
+            const CNetCacheAPIParameters* parameters);
+
+    // The server for the item, or an empty object
+    // if the item can go to any server of the service.
+    virtual CNetServer GetBatchItemServer(const SNetCacheBatchItem& item,
+            const CNetCacheAPIParameters* parameters);
+
+    // The batch command (without the item count) and the arguments of the
+    // individual blob reading or writing command for the item.
+    virtual string MakeBatchCmd(bool put,
+            const CNetCacheAPIParameters* parameters);
+    virtual string MakeBatchItemCmd(const SNetCacheBatchItem& item, bool put,
+            const CNetCacheAPIParameters* parameters);
+
     void AppendClientIPSessionID(string* cmd, CRequestContext& req);
     void AppendHitID(string* cmd, CRequestContext& req);
     void AppendClientIPSessionIDHitID(string* cmd);
@@ -120,6 +141,15 @@ struct NCBI_XCONNECT_EXPORT SNetCacheAPIImpl : public CObject
         SNetServiceImpl::EServerErrorHandling error_handling =
             SNetServiceImpl::eRethrowServerErrors);
 
+    // The server the key points to, for commands
+    // that are not to be sent to mirrors.
+    CNetServer GetKeyServer(const CNetCacheKey& key,
+        const CNetCacheAPIParameters* parameters);
+
+    CNetService x_GetKeyService(const CNetCacheKey& key);
+    void x_CheckKeyServer(const CNetCacheKey& key, CNetService& service,
+        CNetServer& primary_server, ESwitch server_check);
+
     void Init(CSynRegistry& registry, const SRegSynonyms& sections);
 
     CNetService m_Service;
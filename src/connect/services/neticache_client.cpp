@@ -158,6 +158,13 @@ struct SNetICacheClientImpl : public SNetCacheAPIImpl
     virtual CNetServerConnection InitiateWriteCmd(CNetCacheWriter* nc_writer,
             const CNetCacheAPIParameters* parameters);
 
+    virtual CNetServer GetBatchItemServer(const SNetCacheBatchItem& item,
+            const CNetCacheAPIParameters* parameters);
+    virtual string MakeBatchCmd(bool put,
+            const CNetCacheAPIParameters* parameters);
+    virtual string MakeBatchItemCmd(const SNetCacheBatchItem& item, bool put,
+            const CNetCacheAPIParameters* parameters);
+
     IReader* ReadCurrentBlobNotOlderThan(
         const string& key, const string& subkey,
         size_t* blob_size_ptr,
@@ -211,6 +218,45 @@ CNetServerConnection SNetICacheClientImpl::InitiateWriteCmd(
             false, parameters).conn;
 }
 
+CNetServer SNetICacheClientImpl::GetBatchItemServer(
+        const SNetCacheBatchItem& item,
+        const CNetCacheAPIParameters* parameters)
+{
+    CNetServer selected_server(parameters->GetServerToUse());
+
+    return selected_server ? selected_server :
+            *m_Service.IterateByWeight(item.key);
+}
+
+string SNetICacheClientImpl::MakeBatchCmd(bool put,
+        const CNetCacheAPIParameters* parameters)
+{
+    string cmd("IC(" + NStr::PrintableString(parameters->GetCacheName()));
+    cmd.append(put ? ") MPUT" : ") MGET");
+    return cmd;
+}
+
+string SNetICacheClientImpl::MakeBatchItemCmd(const SNetCacheBatchItem& item,
+        bool put, const CNetCacheAPIParameters* parameters)
+{
+    string blob_id(s_KeyVersionSubkeyToBlobID(item.key,
+            item.version, item.subkey));
+
+    if (!put) {
+        AppendClientIPSessionIDPasswordAgeHitID(&blob_id, parameters);
+        return blob_id;
+    }
+
+    string cmd(NStr::UIntToString(parameters->GetTTL()));
+    cmd.push_back(' ');
+    cmd.append(blob_id);
+    cmd.append(" confirm=1");
+    AppendClientIPSessionIDPasswordAgeHitID(&cmd, parameters);
+    if (m_FlagsOnWrite) cmd.append(" flags=").append(to_string(m_FlagsOnWrite));
+
+    return cmd;
+}
+
 CNetICacheClient::CNetICacheClient(EAppRegistry,
         const string& conf_section) :
     m_Impl(new SNetICacheClientImpl(NULL, conf_section,
@@ -588,6 +634,26 @@ IEmbeddedStreamWriter* CNetICacheClient::GetNetCacheWriter(const string& key,
 }
 
 
+void CNetICacheClient::ReadBatch(vector<SNetCacheBatchItem>& items,
+        const CNamedParameterList* optional)
+{
+    CNetCacheAPIParameters parameters(&m_Impl->m_DefaultParameters);
+
+    parameters.LoadNamedParameters(optional);
+
+    m_Impl->ExecBatch(items, false, &parameters);
+}
+
+void CNetICacheClient::StoreBatch(vector<SNetCacheBatchItem>& items,
+        const CNamedParameterList* optional)
+{
+    CNetCacheAPIParameters parameters(&m_Impl->m_DefaultParameters);
+
+    parameters.LoadNamedParameters(optional);
+
+    m_Impl->ExecBatch(items, true, &parameters);
+}
+
 void CNetICacheClient::Remove(const string&    key,
                               int              version,
                               const string&    subkey)
@@ -616,6 +616,46 @@ CNetScheduleAPI::EJobStatus CNetScheduleSubmitter::GetJobStatus(
     return m_Impl->m_API->GetJobStatus("SST2", job, job_exptime, pause_mode);
 }
 
+future<CNetScheduleAPI::EJobStatus> CNetScheduleSubmitter::GetJobStatusAsync(
+        const string& job_key)
+{
+    using TResult = promise<CNetScheduleAPI::EJobStatus>;
+
+    auto result = make_shared<TResult>();
+    auto rv = result->get_future();
+
+    auto handler = [result](const string& response, exception_ptr error) {
+        try {
+            if (error)
+                rethrow_exception(error);
+
+            SNetScheduleOutputParser parser(response);
+            result->set_value(
+                    CNetScheduleAPI::StringToStatus(parser("job_status")));
+        }
+        catch (CNetScheduleException& e) {
+            if (e.GetErrCode() != CNetScheduleException::eJobNotFound)
+                result->set_exception(current_exception());
+            else
+                result->set_value(CNetScheduleAPI::eJobNotFound);
+        }
+        catch (...) {
+            result->set_exception(current_exception());
+        }
+    };
+
+    try {
+        string cmd("SST2 " + job_key);
+        g_AppendClientIPSessionIDHitID(cmd);
+        m_Impl->m_API->GetServer(job_key).ExecAsync(cmd, handler);
+    }
+    catch (...) {
+        handler(kEmptyStr, current_exception());
+    }
+
+    return rv;
+}
+
 CNetScheduleAPI::EJobStatus CNetScheduleSubmitter::GetJobDetails(
         CNetScheduleJob& job, time_t* job_exptime,
         ENetScheduleQueuePauseMode* pause_mode)
@@ -53,6 +53,7 @@ NCBI_PARAM_DEF(int, netservice_api, max_connection_pool_size, 0); // unlimited
 NCBI_PARAM_DEF(bool, netservice_api, connection_data_logging, false);
 NCBI_PARAM_DEF(bool, netservice_api, error_on_unexpected_reply, false);
 NCBI_PARAM_DEF(bool, netservice_api, warn_on_unexpected_reply, false);
+NCBI_PARAM_DEF(unsigned, netservice_api, async_loop_threads, 2);
 NCBI_PARAM_DEF(unsigned, server, max_wait_for_servers, 24 * 60 * 60);
 NCBI_PARAM_DEF(bool, server, stop_on_job_errors, true);
 NCBI_PARAM_DEF(bool, server, allow_implicit_job_return, false);
@@ -209,6 +210,7 @@ CSynRegistry::CReport::CReport()
         TServConn_MaxConnPoolSize,
         TServConn_ConnDataLogging,
         TServConn_WarnOnUnexpectedReply,
+        TServConn_AsyncLoopThreads,
         TWorkerNode_MaxWaitForServers,
         TWorkerNode_StopOnJobErrors,
         TWorkerNode_AllowImplicitJobReturn>();
@@ -83,6 +83,10 @@ typedef NCBI_PARAM_TYPE(netservice_api, error_on_unexpected_reply) TServConn_Err
 NCBI_PARAM_DECL(bool, netservice_api, warn_on_unexpected_reply);
 typedef NCBI_PARAM_TYPE(netservice_api, warn_on_unexpected_reply) TServConn_WarnOnUnexpectedReply;
 
+// The number of event loop threads that serve asynchronous commands
+NCBI_PARAM_DECL(unsigned, netservice_api, async_loop_threads);
+typedef NCBI_PARAM_TYPE(netservice_api, async_loop_threads) TServConn_AsyncLoopThreads;
+
 // Worker node-specific parameters
 
 // Determine how long the worker node should wait for the
@@ -0,0 +1,497 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Asynchronous execution of commands: event loop threads serving
+ *   multiplexed (pipelined) server connections.
+ *
+ */
+
+#include <ncbi_pch.hpp>
+
+#include "netservice_api_impl.hpp"
+
+#include <connect/ncbi_core_cxx.hpp>
+
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbi_safe_static.hpp>
+
+#include <atomic>
+#include <list>
+#include <memory>
+
+
+BEGIN_NCBI_SCOPE
+
+// How often idle loops wake up to check for expired requests
+static const STimeout s_PollPeriod = {0, 200 * 1000};
+static const STimeout s_ZeroTimeout = {0, 0};
+
+
+///////////////////////////////////////////////////////////////////////////
+struct SNetServerAsyncLoop : public CThread
+{
+    // False if the loop has already been stopped.
+    bool Attach(SNetServerAsyncConn* conn);
+    void Wake() { m_Trigger.Set(); }
+    void Stop();
+
+protected:
+    virtual void* Main();
+
+private:
+    CTrigger m_Trigger;
+
+    CFastMutex m_Lock;
+    vector<CRef<SNetServerAsyncConn>> m_NewConns;
+    bool m_Stop = false;
+};
+
+bool SNetServerAsyncLoop::Attach(SNetServerAsyncConn* conn)
+{
+    {{
+        CFastMutexGuard guard(m_Lock);
+
+        if (m_Stop)
+            return false;
+
+        conn->m_Loop = this;
+        m_NewConns.emplace_back(conn);
+    }}
+
+    Wake();
+    return true;
+}
+
+void SNetServerAsyncLoop::Stop()
+{
+    {{
+        CFastMutexGuard guard(m_Lock);
+        m_Stop = true;
+    }}
+
+    Wake();
+}
+
+void* SNetServerAsyncLoop::Main()
+{
+    list<CRef<SNetServerAsyncConn>> conns;
+    vector<CSocketAPI::SPoll> polls;
+
+    for (;;) {
+        {{
+            CFastMutexGuard guard(m_Lock);
+
+            conns.insert(conns.end(), m_NewConns.begin(), m_NewConns.end());
+            m_NewConns.clear();
+
+            if (m_Stop)
+                break;
+        }}
+
+        polls.clear();
+        polls.emplace_back(&m_Trigger, eIO_Read);
+
+        for (auto& conn : conns)
+            polls.emplace_back(&conn->m_Socket, conn->GetPollEvent());
+
+        CSocketAPI::Poll(polls, &s_PollPeriod);
+
+        // Reset before processing, so a command queued meanwhile
+        // makes the next poll return immediately.
+        if (polls.front().m_REvent != eIO_Open)
+            m_Trigger.Reset();
+
+        auto poll = polls.begin();
+
+        for (auto it = conns.begin(); it != conns.end();) {
+            if ((*it)->Process((++poll)->m_REvent))
+                ++it;
+            else
+                it = conns.erase(it);
+        }
+    }
+
+    // Fail whatever is still outstanding.
+    for (auto& conn : conns) {
+        conn->Close();
+        conn->Process(eIO_Open);
+    }
+
+    return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+class CNetServerAsyncLoops
+{
+public:
+    CNetServerAsyncLoops();
+    ~CNetServerAsyncLoops();
+
+    void Attach(SNetServerAsyncConn* conn);
+
+private:
+    vector<CRef<SNetServerAsyncLoop>> m_Loops;
+    atomic<size_t> m_Next{0};
+};
+
+CNetServerAsyncLoops::CNetServerAsyncLoops()
+{
+    unsigned threads = max(TServConn_AsyncLoopThreads::GetDefault(), 1u);
+
+    for (unsigned i = 0; i < threads; ++i) {
+        m_Loops.emplace_back(new SNetServerAsyncLoop);
+        m_Loops.back()->Run();
+    }
+}
+
+CNetServerAsyncLoops::~CNetServerAsyncLoops()
+{
+    for (auto& loop : m_Loops)
+        loop->Stop();
+
+    for (auto& loop : m_Loops)
+        loop->Join();
+}
+
+void CNetServerAsyncLoops::Attach(SNetServerAsyncConn* conn)
+{
+    // Round-robin: each connection stays with its loop for life
+    auto& loop = m_Loops[m_Next++ % m_Loops.size()];
+
+    if (!loop->Attach(conn)) {
+        conn->Close();
+        NCBI_THROW(CNetSrvConnException, eCommunicationError,
+                "Event loops have been stopped");
+    }
+}
+
+static CSafeStatic<CNetServerAsyncLoops> s_AsyncLoops;
+
+
+///////////////////////////////////////////////////////////////////////////
+static void s_CallHandler(SNetServerAsyncConn::THandler& handler,
+        const string& response, exception_ptr error)
+{
+    try {
+        handler(response, error);
+    }
+    catch (std::exception& e) {
+        ERR_POST("Asynchronous command handler failed: " << e.what());
+    }
+    catch (...) {
+        ERR_POST("Asynchronous command handler failed");
+    }
+}
+
+SNetServerAsyncConn::SNetServerAsyncConn(CNetServerConnection conn,
+        const STimeout& timeout) :
+    m_Address(conn->m_Server->m_ServerInPool->m_Address.AsString()),
+    m_Timeout(g_STimeoutToCTimeout(&timeout)),
+    m_Closed(false)
+{
+    // Take over the socket; what remains of the connection
+    // object gets deleted rather than returned to the pool.
+    auto& socket = conn->m_Socket;
+    SOCK sock = socket.GetSOCK();
+    socket.SetOwnership(eNoOwnership);
+    socket.Reset(NULL, eNoOwnership, eCopyTimeoutsToSOCK);
+
+    m_Socket.Reset(sock, eTakeOwnership, eCopyTimeoutsFromSOCK);
+    m_Socket.SetTimeout(eIO_ReadWrite, &s_ZeroTimeout);
+}
+
+SNetServerAsyncConn::~SNetServerAsyncConn()
+{
+}
+
+bool SNetServerAsyncConn::Submit(const string& cmd, CNetServer server,
+        THandler& handler)
+{
+    {{
+        CFastMutexGuard guard(m_Lock);
+
+        if (m_Closed)
+            return false;
+
+        m_Outbox.emplace_back(cmd,
+                SRequest{server, std::move(handler), CDeadline(m_Timeout)});
+    }}
+
+    m_Loop->Wake();
+    return true;
+}
+
+bool SNetServerAsyncConn::IsClosed()
+{
+    CFastMutexGuard guard(m_Lock);
+    return m_Closed;
+}
+
+void SNetServerAsyncConn::Close()
+{
+    {{
+        CFastMutexGuard guard(m_Lock);
+        m_Closed = true;
+    }}
+
+    if (m_Loop)
+        m_Loop->Wake();
+}
+
+EIO_Event SNetServerAsyncConn::GetPollEvent() const
+{
+    return m_WriteBuf.empty() ? eIO_Read : eIO_ReadWrite;
+}
+
+bool SNetServerAsyncConn::Process(EIO_Event ready)
+{
+    bool closed;
+
+    {{
+        CFastMutexGuard guard(m_Lock);
+
+        for (auto& item : m_Outbox) {
+            m_WriteBuf += item.first;
+            m_WriteBuf += "\r\n";
+            m_Pending.emplace_back(std::move(item.second));
+        }
+
+        m_Outbox.clear();
+        closed = m_Closed;
+    }}
+
+    if (closed) {
+        x_Fail(CNetSrvConnException::eCommunicationError,
+                "Connection closed by the client");
+        return false;
+    }
+
+    while (!m_WriteBuf.empty()) {
+        size_t n_written;
+
+        EIO_Status io_st = m_Socket.Write(m_WriteBuf.data(),
+                m_WriteBuf.size(), &n_written, eIO_WritePlain);
+
+        m_WriteBuf.erase(0, n_written);
+
+        if (io_st == eIO_Timeout)
+            break;
+
+        if (io_st != eIO_Success) {
+            x_Fail(CNetSrvConnException::eWriteFailure,
+                    string("Failed to write: ") + IO_StatusStr(io_st));
+            return false;
+        }
+    }
+
+    if ((ready == eIO_Read || ready == eIO_ReadWrite || ready == eIO_Close)
+            && !x_Read())
+        return false;
+
+    if (!m_Pending.empty() && m_Pending.front().deadline.IsExpired()) {
+        x_Fail(CNetSrvConnException::eReadTimeout,
+                "Communication timeout while reading (timeout=" +
+                NStr::DoubleToString(m_Timeout.GetAsDouble()) + "s)");
+        return false;
+    }
+
+    return true;
+}
+
+bool SNetServerAsyncConn::x_Read()
+{
+    char buf[16 * 1024];
+    EIO_Status io_st;
+
+    for (;;) {
+        size_t n_read;
+
+        io_st = m_Socket.Read(buf, sizeof(buf), &n_read, eIO_ReadPlain);
+        m_ReadBuf.append(buf, n_read);
+
+        if (io_st != eIO_Success || n_read < sizeof(buf))
+            break;
+    }
+
+    // Replies come in the order the commands were sent.
+    size_t start = 0, eol;
+
+    while ((eol = m_ReadBuf.find('\n', start)) != NPOS) {
+        size_t len = eol - start;
+
+        if (len > 0 && m_ReadBuf[eol - 1] == '\r')
+            --len;
+
+        string line(m_ReadBuf, start, len);
+        start = eol + 1;
+
+        if (m_Pending.empty()) {
+            m_ReadBuf.clear();
+            x_Fail(CNetSrvConnException::eCommunicationError,
+                    "Unexpected reply: " + line);
+            return false;
+        }
+
+        SRequest request(std::move(m_Pending.front()));
+        m_Pending.pop_front();
+        x_Complete(request, line);
+    }
+
+    m_ReadBuf.erase(0, start);
+
+    switch (io_st) {
+    case eIO_Success:
+    case eIO_Timeout:
+        return true;
+    case eIO_Closed:
+        x_Fail(CNetSrvConnException::eConnClosedByServer,
+                "Connection closed");
+        return false;
+    default:
+        x_Fail(CNetSrvConnException::eCommunicationError,
+                "Communication error while reading");
+        return false;
+    }
+}
+
+void SNetServerAsyncConn::x_Complete(SRequest& request, string& line)
+{
+    try {
+        SNetServerConnectionImpl::ParseCmdOutputLine(line, false,
+                request.server);
+    }
+    catch (...) {
+        s_CallHandler(request.handler, kEmptyStr, current_exception());
+        return;
+    }
+
+    request.server->m_ServerInPool->m_ThrottleStats.Adjust(
+            request.server, -1); // Success
+
+    s_CallHandler(request.handler, line, nullptr);
+}
+
+void SNetServerAsyncConn::x_Fail(CNetSrvConnException::EErrCode err_code,
+        const string& message)
+{
+    m_Socket.Abort();
+    m_WriteBuf.clear();
+
+    {{
+        CFastMutexGuard guard(m_Lock);
+
+        m_Closed = true;
+
+        for (auto& item : m_Outbox)
+            m_Pending.emplace_back(std::move(item.second));
+
+        m_Outbox.clear();
+    }}
+
+    if (m_Pending.empty())
+        return;
+
+    auto error = make_exception_ptr(CNetSrvConnException(DIAG_COMPILE_INFO,
+                0, err_code, m_Address + ": " + message));
+
+    auto& server = m_Pending.front().server;
+    server->m_ServerInPool->m_ThrottleStats.Adjust(server, err_code);
+
+    while (!m_Pending.empty()) {
+        SRequest request(std::move(m_Pending.front()));
+        m_Pending.pop_front();
+        s_CallHandler(request.handler, kEmptyStr, error);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+CRef<SNetServerAsyncConn> SNetServerInPool::GetAsyncConn(
+        SNetServerImpl* server)
+{
+    CFastMutexGuard guard(m_AsyncConnLock);
+
+    if (!m_AsyncConn || m_AsyncConn->IsClosed()) {
+        // Connect (and authenticate) synchronously,
+        // then hand the connection over to an event loop.
+        CRef<SNetServerAsyncConn> conn(new SNetServerAsyncConn(
+                Connect(server, NULL), m_ServerPool->m_CommTimeout));
+
+        s_AsyncLoops->Attach(conn);
+        m_AsyncConn = conn;
+    }
+
+    return m_AsyncConn;
+}
+
+void CNetServer::ExecAsync(const string& cmd, TAsyncHandler handler)
+{
+    auto& throttle_stats = m_Impl->m_ServerInPool->m_ThrottleStats;
+
+    try {
+        throttle_stats.Check(m_Impl);
+
+        CRef<SNetServerAsyncConn> conn;
+
+        try {
+            conn = m_Impl->m_ServerInPool->GetAsyncConn(m_Impl);
+        }
+        catch (CNetSrvConnException& e) {
+            throttle_stats.Adjust(m_Impl, e.GetErrCode());
+            throw;
+        }
+
+        // No retries: a connection that has failed in the meantime
+        // is replaced by the next command
+        if (!conn->Submit(cmd, *this, handler)) {
+            CONNSERV_THROW_FMT(CNetSrvConnException, eCommunicationError,
+                    m_Impl, "Connection closed");
+        }
+    }
+    catch (...) {
+        s_CallHandler(handler, kEmptyStr, current_exception());
+    }
+}
+
+future<string> CNetServer::ExecAsync(const string& cmd)
+{
+    auto result = make_shared<promise<string>>();
+    auto rv = result->get_future();
+
+    ExecAsync(cmd, [result](const string& response, exception_ptr error) {
+        if (error)
+            result->set_exception(error);
+        else
+            result->set_value(response);
+    });
+
+    return rv;
+}
+
+END_NCBI_SCOPE
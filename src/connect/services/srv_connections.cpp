@@ -205,7 +205,13 @@ void SNetServerConnectionImpl::ReadCmdOutputLine(string& result,
                 "Communication error while reading");
     }
 
-    auto& conn_listener = m_Server->m_Service->m_Listener;
+    ParseCmdOutputLine(result, multiline_output, m_Server);
+}
+
+void SNetServerConnectionImpl::ParseCmdOutputLine(string& result,
+        bool multiline_output, CNetServer& server)
+{
+    auto& conn_listener = server->m_Service->m_Listener;
 
     if (NStr::StartsWith(result, "OK:")) {
         const char* reply = result.c_str() + STRING_LEN("OK:");
@@ -217,11 +223,11 @@ void SNetServerConnectionImpl::ReadCmdOutputLine(string& result,
             const char* semicolon = strchr(reply, ';');
             if (semicolon == NULL) {
                 conn_listener->OnWarning(string(reply, reply + reply_len),
-                        m_Server);
+                        server);
                 reply_len = 0;
                 break;
             }
-            conn_listener->OnWarning(string(reply, semicolon), m_Server);
+            conn_listener->OnWarning(string(reply, semicolon), server);
             reply_len -= semicolon - reply + 1;
             reply = semicolon + 1;
         }
@@ -229,14 +235,14 @@ void SNetServerConnectionImpl::ReadCmdOutputLine(string& result,
     } else if (NStr::StartsWith(result, "ERR:")) {
         result.erase(0, STRING_LEN("ERR:"));
         result = NStr::ParseEscapes(result);
-        conn_listener->OnError(result, m_Server);
+        conn_listener->OnError(result, server);
         result = multiline_output ? string(END_OF_MULTILINE_OUTPUT) : kEmptyStr;
 
     } else if (!multiline_output) {
         if (TServConn_ErrorOnUnexpectedReply::GetDefault()) {
-            conn_listener->OnError("Unexpected reply: " + result, m_Server);
+            conn_listener->OnError("Unexpected reply: " + result, server);
         } else if (TServConn_WarnOnUnexpectedReply::GetDefault()) {
-            conn_listener->OnWarning("Unexpected reply: " + result, m_Server);
+            conn_listener->OnWarning("Unexpected reply: " + result, server);
         }
     }
 }
@@ -357,6 +363,9 @@ SNetServerInPool::~SNetServerInPool()
         delete impl;
         impl = next_impl;
     }
+
+    if (m_AsyncConn)
+        m_AsyncConn->Close();
 }
 
 CUrlArgs::TArgs s_GetAttributes(const string& version_string)
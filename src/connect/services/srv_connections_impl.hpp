@@ -35,12 +35,14 @@
 #include "netservice_params.hpp"
 
 #include <connect/services/netservice_api.hpp>
+#include <connect/services/srv_connections_expt.hpp>
 
 #include <corelib/ncbimtx.hpp>
 
 #include <util/ncbi_url.hpp>
 
 #include <bitset>
+#include <deque>
 
 BEGIN_NCBI_SCOPE
 
@@ -116,6 +118,10 @@ struct SNetServerConnectionImpl : public CObject
     void ReadCmdOutputLine(string& result,
             bool multiline_output);
 
+    // Strip "OK:" (reporting warnings, if any) or report "ERR:".
+    static void ParseCmdOutputLine(string& result,
+            bool multiline_output, CNetServer& server);
+
     void Close();
     void Abort();
 
@@ -196,6 +202,56 @@ private:
     CFastMutex m_ThrottleLock;
 };
 
+struct SNetServerAsyncLoop;
+
+// A connection that carries pipelined single-line commands of any number
+// of callers. Once established, it is served by one of the event loop
+// threads, which sends the queued commands and matches the replies to
+// them in order (see srv_async.cpp).
+struct SNetServerAsyncConn : public CObject
+{
+    typedef CNetServer::TAsyncHandler THandler;
+
+    SNetServerAsyncConn(CNetServerConnection conn, const STimeout& timeout);
+    ~SNetServerAsyncConn();
+
+    // Called by the users: queue the command; false if the connection
+    // has already been closed (the handler is left intact then).
+    bool Submit(const string& cmd, CNetServer server, THandler& handler);
+    bool IsClosed();
+    void Close();
+
+    // Called by the event loop only.
+    EIO_Event GetPollEvent() const;
+    bool Process(EIO_Event ready);
+
+    CSocket m_Socket;
+    CRef<SNetServerAsyncLoop> m_Loop;
+
+private:
+    struct SRequest
+    {
+        CNetServer server;  // Keeps the server and the service alive
+        THandler handler;
+        CDeadline deadline;
+    };
+
+    bool x_Read();
+    void x_Complete(SRequest& request, string& line);
+    void x_Fail(CNetSrvConnException::EErrCode err_code, const string& message);
+
+    const string m_Address;
+    const CTimeout m_Timeout;
+
+    CFastMutex m_Lock;
+    vector<pair<string, SRequest>> m_Outbox;
+    bool m_Closed;
+
+    string m_WriteBuf;
+    string m_ReadBuf;
+    deque<SRequest> m_Pending;
+};
+
 struct SNetServerInPool : public CObject
 {
     SNetServerInPool(SSocketAddress address,
@@ -214,6 +270,7 @@ struct SNetServerInPool : public CObject
 
     CNetServerConnection GetConnectionFromPool(SNetServerImpl* server);
     CNetServerConnection Connect(SNetServerImpl* server, const STimeout* timeout);
+    CRef<SNetServerAsyncConn> GetAsyncConn(SNetServerImpl* server);
 
 public:
     // A smart pointer to the server pool object that contains
@@ -233,6 +290,10 @@ public:
 
     SThrottleStats m_ThrottleStats;
     Uint4 m_RankBase;
+
+    // Multiplexed connection for CNetServer::ExecAsync().
+    CRef<SNetServerAsyncConn> m_AsyncConn;
+    CFastMutex m_AsyncConnLock;
 };
 
 struct SNetServerInfoImpl : public CObject
@@ -878,6 +878,64 @@ static void s_SimpleTest(const CNamedParameterList* nc_params)
     }
 }
 
+static void s_BatchTest(const CNamedParameterList* nc_params)
+{
+    CNetCacheAPI api(TNetCache_ServiceName::GetDefault(), s_ClientName);
+    api.SetDefaultParameters(nc_params);
+
+    const size_t kBlobs = 1000;
+
+    auto random_char = bind(uniform_int_distribution<int>('a', 'z'), mt19937());
+
+    vector<SNetCacheBatchItem> items(kBlobs);
+
+    for (size_t i = 0; i < kBlobs; ++i)
+        generate_n(back_inserter(items[i].data), i * 10, random_char);
+
+    // Creating blobs
+    api.PutDataBatch(items);
+
+    for (size_t i = 0; i < kBlobs; ++i) {
+        BOOST_REQUIRE_MESSAGE(items[i].status == SNetCacheBatchItem::eOK,
+                "Failed to write blob (" << i << "): " <<
+                items[i].error_message);
+        BOOST_REQUIRE_MESSAGE(!items[i].key.empty(),
+                "No key for new blob (" << i << ")");
+    }
+
+    // Checking blobs
+    vector<SNetCacheBatchItem> read_items(kBlobs);
+
+    for (size_t i = 0; i < kBlobs; ++i)
+        read_items[i].key = items[i].key;
+
+    api.ReadDataBatch(read_items);
+
+    for (size_t i = 0; i < kBlobs; ++i) {
+        BOOST_REQUIRE_MESSAGE(read_items[i].status == SNetCacheBatchItem::eOK,
+                "Failed to read blob (" << i << "): " <<
+                read_items[i].error_message);
+        BOOST_REQUIRE_MESSAGE(read_items[i].data == items[i].data,
+                "Blob content does not match the source (" << i << ")");
+    }
+
+    // Removing blobs
+    for (size_t i = 0; i < kBlobs; i += 2)
+        api.Remove(items[i].key);
+
+    this_thread::sleep_for(chrono::seconds(1));
+
+    // Checking removed blobs
+    api.ReadDataBatch(read_items);
+
+    for (size_t i = 0; i < kBlobs; ++i) {
+        BOOST_REQUIRE_MESSAGE(read_items[i].status == (i % 2 ?
+                    SNetCacheBatchItem::eOK : SNetCacheBatchItem::eNotFound),
+                "Unexpected status of blob (" << i << "): " <<
+                read_items[i].error_message);
+    }
+}
+
 #define OUTPUT_CTX(ctx) ctx << '[' << __LINE__ << "]: "
 
 #define BOOST_ERROR_CTX(message, ctx) \
@@ -1038,6 +1096,11 @@ BOOST_AUTO_TEST_CASE(SimpleTestMirroring)
     s_SimpleTest(nc_mirroring_mode = CNetCacheAPI::eMirroringEnabled);
 }
 
+BOOST_AUTO_TEST_CASE(BatchTest)
+{
+    s_BatchTest(nc_mirroring_mode = CNetCacheAPI::eMirroringDisabled);
+}
+
 BOOST_AUTO_TEST_CASE(AllowedServices)
 {
     s_AllowedServicesTest();
@@ -0,0 +1,359 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Asynchronous (multiplexed) execution of NetCache and NetSchedule
+ *   commands, against a local stand-in server;  also compares throughput
+ *   with the blocking API
+ *
+ */
+
+#include <ncbi_pch.hpp>
+
+#include <connect/services/netcache_api.hpp>
+#include <connect/services/netschedule_api.hpp>
+
+#include <connect/ncbi_socket.hpp>
+
+#include <corelib/test_boost.hpp>
+#include <corelib/ncbitime.hpp>
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <thread>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+static const STimeout kTimeout = {10, 0};
+static const STimeout kZero    = {0, 0};
+
+
+///////////////////////////////////////////////////////////////////////
+// Serves NetCache and NetSchedule commands from an in-memory store,
+// replying to pipelined commands in order. Blobs added with size (size_t)-1
+// make the server drop the connection instead of replying.
+
+class CStandInServer
+{
+public:
+    enum EProtocol { eNetCache, eNetSchedule };
+
+    CStandInServer(EProtocol protocol);
+    ~CStandInServer();
+
+    unsigned short GetPort() const { return m_Port; }
+    string GetAddress() const { return "127.0.0.1:" + NStr::NumericToString(m_Port); }
+    unsigned GetConnections() const { return m_Connections; }
+
+    void AddBlob(const string& key, size_t size) { m_Blobs[CNetCacheKey(key).GetId()] = size; }
+    void AddJob(const string& key) { m_Jobs.insert(key); }
+
+private:
+    void x_Serve(CSocket* sock);
+    bool x_Reply(const string& line, string& reply);
+
+    const EProtocol m_Protocol;
+    CListeningSocket m_Listener;
+    unsigned short m_Port = 0;
+    atomic<unsigned> m_Connections{0};
+    atomic<bool> m_Stop{false};
+    thread m_Thread;
+
+    map<unsigned, size_t> m_Blobs;
+    set<string> m_Jobs;
+};
+
+CStandInServer::CStandInServer(EProtocol protocol) :
+    m_Protocol(protocol)
+{
+    for (unsigned short port = 9100;  port;  ++port) {
+        if (m_Listener.Listen(port, 64, fSOCK_BindLocal | fSOCK_LogOff) == eIO_Success) {
+            m_Port = port;
+            break;
+        }
+    }
+
+    BOOST_REQUIRE(m_Port);
+
+    m_Thread = thread([this]() {
+        static const STimeout kPoll = {0, 100000};
+        vector<thread> workers;
+
+        while (!m_Stop) {
+            CSocket* sock = nullptr;
+
+            if (m_Listener.Accept(sock, &kPoll, fSOCK_LogOff) == eIO_Success) {
+                ++m_Connections;
+                workers.emplace_back(&CStandInServer::x_Serve, this, sock);
+            }
+        }
+
+        for (auto& worker : workers) worker.join();
+    });
+}
+
+CStandInServer::~CStandInServer()
+{
+    m_Stop = true;
+    m_Thread.join();
+}
+
+void CStandInServer::x_Serve(CSocket* sock)
+{
+    static const STimeout kPoll = {0, 100000};
+    sock->SetTimeout(eIO_Read, &kPoll);
+    sock->SetTimeout(eIO_Write, &kTimeout);
+
+    // Authentication: NetCache clients send a line, NetSchedule ones
+    // add the queue name; neither wait for a reply
+    unsigned auth_lines = m_Protocol == eNetSchedule ? 2 : 1;
+    string line, replies;
+
+    while (!m_Stop) {
+        EIO_Status status = sock->ReadLine(line);
+
+        if (status == eIO_Timeout) continue;
+        if (status != eIO_Success) break;
+        if (auth_lines) {
+            --auth_lines;
+            continue;
+        }
+
+        string reply;
+
+        if (!x_Reply(line, reply)) break;
+        if (reply.empty()) continue;
+
+        // Batch the replies to the commands that have already arrived
+        replies += reply + "\r\n";
+
+        if (sock->Wait(eIO_Read, &kZero) != eIO_Success) {
+            if (sock->Write(replies.data(), replies.size()) != eIO_Success) break;
+            replies.clear();
+        }
+    }
+
+    sock->Close();
+    delete sock;
+}
+
+bool CStandInServer::x_Reply(const string& line, string& reply)
+{
+    vector<string> args;
+    NStr::Split(line, " ", args, NStr::fSplit_Tokenize);
+    const string& cmd = args.empty() ? kEmptyStr : args[0];
+    const string& key = args.size() > 1 ? args[1] : kEmptyStr;
+
+    if (cmd == "VERSION") {
+        reply = m_Protocol == eNetSchedule ?
+            "OK:server_version=4.30.0&ns_node=standin&ns_session=1" :
+            "OK:version=1.0.0";
+
+    } else if (cmd == "HASB" || cmd == "GSIZ" || cmd == "RMV2") {
+        unsigned id = CNetCacheKey(key).GetId();
+        auto blob = m_Blobs.find(id);
+
+        if (blob != m_Blobs.end() && blob->second == size_t(-1)) return false;
+
+        if (cmd == "HASB")
+            reply = blob != m_Blobs.end() ? "OK:1" : "OK:0";
+        else if (blob == m_Blobs.end())
+            reply = "ERR:BLOB not found.";
+        else if (cmd == "GSIZ")
+            reply = "OK:" + NStr::NumericToString(blob->second);
+        else
+            reply = "OK:";
+
+    } else if (cmd == "SST2") {
+        reply = m_Jobs.count(key) ? "OK:job_status=Running&job_exptime=0"
+                                  : "ERR:eJobNotFound:Job not found";
+    } else {
+        reply = "ERR:eProtocolSyntaxError:Unknown command";
+    }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+static string s_BlobKey(const CStandInServer& server, unsigned id)
+{
+    string key;
+    CNetCacheKey::GenerateBlobKey(&key, id, "127.0.0.1", server.GetPort(), 1, id);
+    return key;
+}
+
+BOOST_AUTO_TEST_SUITE(NetServiceAsync)
+
+BOOST_AUTO_TEST_CASE(NetCache)
+{
+    CStandInServer server(CStandInServer::eNetCache);
+    CNetCacheAPI api(server.GetAddress(), "test_netservice_async");
+
+    const string present = s_BlobKey(server, 1);
+    const string absent  = s_BlobKey(server, 2);
+    server.AddBlob(present, 12345);
+
+    // Many commands outstanding at once over a single connection
+    vector<future<bool>> has;
+    vector<future<size_t>> sizes;
+
+    for (int i = 0; i < 100; ++i) {
+        has.emplace_back(api.HasBlobAsync(i % 2 ? present : absent));
+        sizes.emplace_back(api.GetBlobSizeAsync(present));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(has[i].get(), i % 2 != 0);
+        BOOST_CHECK_EQUAL(sizes[i].get(), 12345u);
+    }
+
+    // Server errors are delivered through the future
+    auto missing = api.GetBlobSizeAsync(absent);
+
+    try {
+        missing.get();
+        BOOST_ERROR("Exception expected");
+    }
+    catch (CNetCacheException& e) {
+        BOOST_CHECK_EQUAL(e.GetErrCode(), CNetCacheException::eBlobNotFound);
+    }
+
+    BOOST_CHECK_NO_THROW(api.RemoveAsync(present).get());
+
+    // The synchronous API gets a connection of its own
+    BOOST_CHECK(api.HasBlob(present));
+    BOOST_CHECK_EQUAL(server.GetConnections(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(NetSchedule)
+{
+    CStandInServer server(CStandInServer::eNetSchedule);
+    CNetScheduleAPI api(server.GetAddress(), "test_netservice_async", "queue");
+    CNetScheduleSubmitter submitter(api.GetSubmitter());
+
+    CNetScheduleKeyGenerator generator("127.0.0.1", server.GetPort(), "queue");
+    const string running = generator.Generate(1);
+    const string expired = generator.Generate(2);
+    server.AddJob(running);
+
+    auto status1 = submitter.GetJobStatusAsync(running);
+    auto status2 = submitter.GetJobStatusAsync(expired);
+
+    BOOST_CHECK_EQUAL(status1.get(), CNetScheduleAPI::eRunning);
+    BOOST_CHECK_EQUAL(status2.get(), CNetScheduleAPI::eJobNotFound);
+    BOOST_CHECK_EQUAL(submitter.GetJobStatus(running), CNetScheduleAPI::eRunning);
+}
+
+BOOST_AUTO_TEST_CASE(ConnectionFailure)
+{
+    CStandInServer server(CStandInServer::eNetCache);
+    CNetCacheAPI api(server.GetAddress(), "test_netservice_async");
+
+    const string present = s_BlobKey(server, 1);
+    const string dropped = s_BlobKey(server, 2);
+    server.AddBlob(present, 1);
+    server.AddBlob(dropped, size_t(-1));
+
+    BOOST_CHECK(api.HasBlobAsync(present).get());
+
+    // Outstanding commands fail when the connection drops...
+    auto failed = api.HasBlobAsync(dropped);
+
+    try {
+        failed.get();
+        BOOST_ERROR("Exception expected");
+    }
+    catch (CNetSrvConnException& e) {
+        BOOST_CHECK_EQUAL(e.GetErrCode(), CNetSrvConnException::eConnClosedByServer);
+    }
+
+    // ...and the next ones go over a new connection
+    BOOST_CHECK(api.HasBlobAsync(present).get());
+    BOOST_CHECK_EQUAL(server.GetConnections(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+    const unsigned kRequests = 20000;
+    const unsigned kThreads  = 8;
+    const unsigned kWindow   = 256;
+
+    CStandInServer server(CStandInServer::eNetCache);
+    CNetCacheAPI api(server.GetAddress(), "test_netservice_async");
+
+    const string key = s_BlobKey(server, 1);
+    server.AddBlob(key, 1);
+
+    // Blocking API: a thread (and a connection) per outstanding command
+    CStopWatch sw(CStopWatch::eStart);
+    atomic<unsigned> found{0};
+    vector<thread> threads;
+
+    for (unsigned t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (unsigned i = 0; i < kRequests / kThreads; ++i)
+                if (api.HasBlob(key)) ++found;
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    double blocking = sw.Elapsed();
+    BOOST_CHECK_EQUAL(found.load(), kRequests);
+
+    // Asynchronous API: one thread, one connection, many commands in flight
+    sw.Restart();
+    found = 0;
+    deque<future<bool>> window;
+
+    for (unsigned i = 0; i < kRequests; ++i) {
+        if (window.size() == kWindow) {
+            if (window.front().get()) ++found;
+            window.pop_front();
+        }
+        window.emplace_back(api.HasBlobAsync(key));
+    }
+
+    for (auto& f : window)
+        if (f.get()) ++found;
+
+    double async = sw.Elapsed();
+    BOOST_CHECK_EQUAL(found.load(), kRequests);
+
+    BOOST_TEST_MESSAGE("Blocking (" << kThreads << " threads): " <<
+            NStr::DoubleToString(kRequests / blocking, 0) << " req/s");
+    BOOST_TEST_MESSAGE("Asynchronous (window of " << kWindow << "): " <<
+            NStr::DoubleToString(kRequests / async, 0) << " req/s");
+    LOG_POST("Blocking: " << NStr::DoubleToString(kRequests / blocking, 0) <<
+            " req/s, asynchronous: " << NStr::DoubleToString(kRequests / async, 0) << " req/s");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,399 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Loopback benchmark harness for the connection library
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_process.hpp>
+#include <corelib/ncbistr.hpp>
+#include "connbench.hpp"
+
+#ifdef HAVE_GETRUSAGE
+#  include <sys/resource.h>
+#endif /*HAVE_GETRUSAGE*/
+
+
+BEGIN_NCBI_SCOPE
+
+
+static const STimeout kPollTimeout = { 0, 100000 };
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CConnBenchMeter::
+//
+
+static double s_CpuTime(void)
+{
+#ifdef HAVE_GETRUSAGE
+    // Finer than CCurrentProcess::GetTimes() (clock ticks, on Linux)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+            +  ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    }
+#endif /*HAVE_GETRUSAGE*/
+    double user = 0.0, sys = 0.0;
+    if (!CCurrentProcess::GetTimes(0, &user, &sys)  ||  user < 0.0
+        ||  sys < 0.0) {
+        return 0.0;
+    }
+    return user + sys;
+}
+
+
+CConnBenchMeter::CConnBenchMeter(const string& suite, const string& variant)
+{
+    m_Result.suite    = suite;
+    m_Result.variant  = variant;
+    m_Result.requests = 0;
+    m_Result.bytes    = 0;
+    Start();
+}
+
+
+void CConnBenchMeter::Start(void)
+{
+    m_CpuStart = s_CpuTime();
+    m_Clock.Restart();
+}
+
+
+void CConnBenchMeter::x_Merge(vector<double>& latency, Uint8 bytes)
+{
+    CFastMutexGuard guard(m_Mutex);
+    m_Latency.insert(m_Latency.end(), latency.begin(), latency.end());
+    m_Result.bytes += bytes;
+}
+
+
+static double s_Percentile(const vector<double>& sorted, double q)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t n = (size_t)(q * sorted.size());
+    return sorted[min(n, sorted.size() - 1)];
+}
+
+
+SConnBenchResult CConnBenchMeter::Stop(void)
+{
+    m_Result.elapsed = m_Clock.Elapsed();
+    m_Result.cpu     = max(s_CpuTime() - m_CpuStart, 0.0);
+
+    CFastMutexGuard guard(m_Mutex);
+    sort(m_Latency.begin(), m_Latency.end());
+    m_Result.requests = m_Latency.size();
+    m_Result.p50      = s_Percentile(m_Latency, 0.50);
+    m_Result.p99      = s_Percentile(m_Latency, 0.99);
+    m_Result.p999     = s_Percentile(m_Latency, 0.999);
+    return m_Result;
+}
+
+
+SConnBenchResult CConnBenchMeter::Run(unsigned int threads,
+                                      const function<void(CThreadLog&)>& client)
+{
+    vector<thread> clients;
+    Start();
+    for (unsigned int i = 0;  i < threads;  ++i) {
+        clients.emplace_back([this, &client]() {
+            CThreadLog log(*this);
+            client(log);
+        });
+    }
+    for (auto& t : clients)
+        t.join();
+    return Stop();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CConnBenchReport::
+//
+
+void CConnBenchReport::Add(const SConnBenchResult& result)
+{
+    if (m_Results.empty()) {
+        NcbiCout << setw(8)  << left << "suite"
+                 << setw(24) << "variant" << right
+                 << setw(10) << "requests"
+                 << setw(12) << "req/s"
+                 << setw(12) << "cpu/req,us"
+                 << setw(10) << "p50,us"
+                 << setw(10) << "p99,us"
+                 << setw(10) << "p999,us" << NcbiEndl;
+    }
+    m_Results.push_back(result);
+    NcbiCout << setw(8)  << left << result.suite
+             << setw(24) << result.variant << right
+             << setw(10) << result.requests << fixed << setprecision(0)
+             << setw(12) << result.RequestsPerSec() << setprecision(1)
+             << setw(12) << result.CpuPerRequest() * 1e6
+             << setw(10) << result.p50  * 1e6
+             << setw(10) << result.p99  * 1e6
+             << setw(10) << result.p999 * 1e6 << NcbiEndl;
+}
+
+
+void CConnBenchReport::Save(const string& path) const
+{
+    CNcbiOfstream file;
+    if (path != "-") {
+        file.open(path.c_str(), IOS_BASE::out | IOS_BASE::trunc);
+        if (!file) {
+            NCBI_THROW(CCoreException, eInvalidArg,
+                       "Cannot create benchmark results file " + path);
+        }
+    }
+    CNcbiOstream& out = path == "-" ? NcbiCout : file;
+    for (const auto& r : m_Results) {
+        out << "{\"suite\":\""        << NStr::JsonEncode(r.suite)
+            << "\",\"variant\":\""    << NStr::JsonEncode(r.variant)
+            << "\",\"requests\":"     << r.requests
+            << ",\"bytes\":"          << r.bytes << fixed << setprecision(6)
+            << ",\"elapsed\":"        << r.elapsed
+            << ",\"cpu\":"            << r.cpu     << setprecision(1)
+            << ",\"req_per_sec\":"    << r.RequestsPerSec()
+            << ",\"cpu_per_req_us\":" << r.CpuPerRequest() * 1e6
+            << ",\"p50_us\":"         << r.p50  * 1e6
+            << ",\"p99_us\":"         << r.p99  * 1e6
+            << ",\"p999_us\":"        << r.p999 * 1e6
+            << "}\n";
+    }
+    out.flush();
+}
+
+
+// Value of the "key" in a JSON line as written by Save()
+static string s_JsonValue(const string& line, const string& key)
+{
+    string tag = '"' + key + "\":";
+    SIZE_TYPE pos = line.find(tag);
+    if (pos == NPOS)
+        return kEmptyStr;
+    pos += tag.size();
+    if (line[pos] == '"') {
+        SIZE_TYPE end = line.find('"', ++pos);
+        return end == NPOS ? kEmptyStr : line.substr(pos, end - pos);
+    }
+    SIZE_TYPE end = line.find_first_of(",}", pos);
+    return end == NPOS ? kEmptyStr : line.substr(pos, end - pos);
+}
+
+
+size_t CConnBenchReport::Compare(const string& path, double tolerance) const
+{
+    CNcbiIfstream file(path.c_str());
+    if (!file) {
+        NCBI_THROW(CCoreException, eInvalidArg,
+                   "Cannot open benchmark baseline file " + path);
+    }
+    map<string, double> baseline;
+    string line;
+    while (NcbiGetline(file, line, "\n")) {
+        string rate = s_JsonValue(line, "req_per_sec");
+        if (rate.empty())
+            continue;
+        baseline[s_JsonValue(line, "suite") + ' '
+                 + s_JsonValue(line, "variant")]
+            = NStr::StringToDouble(rate, NStr::fConvErr_NoThrow);
+    }
+
+    size_t regressions = 0;
+    for (const auto& r : m_Results) {
+        // NB: NStr::JsonEncode() is identity for the names used here
+        auto it = baseline.find(r.suite + ' ' + r.variant);
+        if (it == baseline.end()  ||  it->second <= 0.0)
+            continue;
+        double ratio = r.RequestsPerSec() / it->second;
+        if (ratio < 1.0 - tolerance) {
+            ERR_POST(Error << "Regression in " << r.suite << ' ' << r.variant
+                     << ": " << NStr::DoubleToString(r.RequestsPerSec(), 0)
+                     << " vs. " << NStr::DoubleToString(it->second, 0)
+                     << " requests/s in the baseline ("
+                     << NStr::DoubleToString((1.0 - ratio) * 100.0, 1)
+                     << "% slower)");
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CConnBenchServer::
+//
+
+CConnBenchServer::~CConnBenchServer()
+{
+    _ASSERT(!m_Thread.joinable());
+}
+
+
+void CConnBenchServer::x_Start(void)
+{
+    for (unsigned short port = 4096;  port;  ++port) {
+        if (m_Listener.Listen(port, 128, fSOCK_BindLocal | fSOCK_LogOff)
+            == eIO_Success) {
+            m_Port = port;
+            break;
+        }
+    }
+    if (!m_Port) {
+        NCBI_THROW(CCoreException, eCore,
+                   "Unable to find a free port to listen on");
+    }
+    m_Thread = thread([this]() {
+        vector<thread> connections;
+        while (!m_Stop) {
+            CSocket* sock = 0;
+            if (m_Listener.Accept(sock, &kPollTimeout) != eIO_Success)
+                continue;
+            ++m_Connections;
+            connections.emplace_back([this, sock]() {
+                unique_ptr<CSocket> guard(sock);
+                sock->DisableOSSendDelay();
+                sock->SetTimeout(eIO_Read, &kPollTimeout);
+                x_Serve(*sock);
+            });
+        }
+        // Connections end as clients close them, or the server is stopped
+        for (auto& t : connections)
+            t.join();
+    });
+}
+
+
+void CConnBenchServer::x_Stop(void)
+{
+    m_Stop = true;
+    m_Thread.join();
+    m_Listener.Close();
+}
+
+
+// Read with the polling timeout until data or the server stops
+static EIO_Status s_Read(CSocket& sock, void* buf, size_t size, size_t* n_read,
+                         const atomic<bool>& stop)
+{
+    EIO_Status status;
+    while ((status = sock.Read(buf, size, n_read)) == eIO_Timeout) {
+        if (stop)
+            break;
+    }
+    return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CConnBenchEchoServer::
+//
+
+void CConnBenchEchoServer::x_Serve(CSocket& sock)
+{
+    char buf[65536];
+    for (;;) {
+        size_t n_read;
+        if (s_Read(sock, buf, sizeof(buf), &n_read, x_Stopping())
+            != eIO_Success) {
+            break;
+        }
+        if (sock.Write(buf, n_read) != eIO_Success)
+            break;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CConnBenchHttpServer::
+//
+
+void CConnBenchHttpServer::x_Serve(CSocket& sock)
+{
+    string line, body;
+    for (;;) {
+        // Request line: "METHOD /<size>[?args] HTTP/1.x"
+        EIO_Status status;
+        while ((status = sock.ReadLine(line)) == eIO_Timeout) {
+            if (x_Stopping())
+                break;
+        }
+        if (status != eIO_Success  ||  line.empty())
+            break;
+        vector<string> request;
+        NStr::Split(line, " ", request, NStr::fSplit_Tokenize);
+        if (request.size() != 3)
+            break;
+        bool keepalive = request[2] != "HTTP/1.0";
+        size_t content_length = 0;
+        while ((status = sock.ReadLine(line)) == eIO_Success
+               &&  !line.empty()) {
+            if (NStr::StartsWith(line, "Connection:", NStr::eNocase)) {
+                keepalive
+                    = NStr::FindNoCase(line, "keep-alive") != NPOS;
+            } else if (NStr::StartsWith(line, "Content-Length:",
+                                        NStr::eNocase)) {
+                content_length = NStr::StringToSizet
+                    (NStr::TruncateSpaces(line.substr(15)),
+                     NStr::fConvErr_NoThrow);
+            }
+        }
+        if (status != eIO_Success)
+            break;
+        // Discard the request body, if any
+        if (content_length
+            &&  sock.Read(0, content_length, 0, eIO_ReadPersist)
+            != eIO_Success) {
+            break;
+        }
+
+        // The size may be followed by a query string (e.g. from a service)
+        const string& path = request[1];
+        size_t size = NStr::StringToSizet
+            (path.substr(1, path.find_first_not_of("0123456789", 1) - 1),
+             NStr::fConvErr_NoThrow);
+        if (body.size() < size)
+            body.resize(size, 'x');
+        string reply = request[2] + " 200 OK\r\n";
+        if (keepalive  &&  request[2] == "HTTP/1.0")
+            reply += "Connection: keep-alive\r\n";
+        reply += "Content-Length: " + NStr::NumericToString(size)
+            + "\r\n\r\n";
+        reply.append(body, 0, size);
+        if (sock.Write(reply.data(), reply.size()) != eIO_Success
+            ||  !keepalive) {
+            break;
+        }
+    }
+}
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,202 @@
+#ifndef CONNBENCH__HPP
+#define CONNBENCH__HPP
+
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Loopback benchmark harness for the connection library:  latency and CPU
+ *   metering, reporting (incl. machine-readable results and comparison with
+ *   a baseline), and local stand-in servers
+ *
+ */
+
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbitime.hpp>
+#include <connect/ncbi_socket.hpp>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+BEGIN_NCBI_SCOPE
+
+
+/// Results of one benchmark run
+struct SConnBenchResult
+{
+    string suite;     ///< e.g. "socket", "http", "server"
+    string variant;   ///< run parameters, e.g. "size=64" or "workers=4"
+    size_t requests;  ///< requests (round trips / operations) completed
+    Uint8  bytes;     ///< payload bytes transferred
+    double elapsed;   ///< wall clock time, seconds
+    double cpu;       ///< process CPU time (user + system), seconds
+    double p50;       ///< latency percentiles, seconds
+    double p99;
+    double p999;
+
+    double RequestsPerSec(void) const
+    { return elapsed > 0.0 ? requests / elapsed : 0.0; }
+    double CpuPerRequest (void) const
+    { return requests ? cpu / requests : 0.0; }
+};
+
+
+/// Measures a run:  collects request latencies (from any number of client
+/// threads, each having its own CConnBenchMeter::CThreadLog) along with the
+/// wall clock and the process CPU time spent.
+/// @note
+///   The CPU time includes the in-process stand-in servers.
+class CConnBenchMeter
+{
+public:
+    /// Per-thread latency log
+    class CThreadLog
+    {
+    public:
+        CThreadLog(CConnBenchMeter& meter) : m_Meter(meter)
+        { m_Latency.reserve(1024); }
+        ~CThreadLog() { m_Meter.x_Merge(m_Latency, m_Bytes); }
+
+        void Add(double latency, size_t bytes = 0)
+        { m_Latency.push_back(latency);  m_Bytes += bytes; }
+
+    private:
+        CConnBenchMeter& m_Meter;
+        vector<double>   m_Latency;
+        Uint8            m_Bytes = 0;
+    };
+
+    CConnBenchMeter(const string& suite, const string& variant);
+
+    /// Start the clock (it's also started at construction)
+    void Start(void);
+
+    /// Stop the clock and compute the results;  all thread logs must be gone
+    SConnBenchResult Stop(void);
+
+    /// Run "threads" client threads (each with its own log) concurrently,
+    /// with the clock started right before and stopped after they all finish
+    SConnBenchResult Run(unsigned int threads,
+                         const function<void(CThreadLog&)>& client);
+
+private:
+    void x_Merge(vector<double>& latency, Uint8 bytes);
+
+    SConnBenchResult m_Result;
+    CFastMutex       m_Mutex;
+    vector<double>   m_Latency;
+    CStopWatch       m_Clock;
+    double           m_CpuStart;
+};
+
+
+/// Collects results, prints them as a table, saves them as JSON lines (one
+/// object per run), and compares them with a baseline saved earlier.
+class CConnBenchReport
+{
+public:
+    /// Add the result and print it out right away
+    void Add(const SConnBenchResult& result);
+
+    /// Save results to the file ("-" for the standard output)
+    void Save(const string& path) const;
+
+    /// Compare the throughput with the baseline file (as saved by Save()):
+    /// return the number of runs whose requests per second dropped by more
+    /// than "tolerance" (a fraction);  each regression is reported.
+    size_t Compare(const string& path, double tolerance) const;
+
+    const vector<SConnBenchResult>& GetResults(void) const
+    { return m_Results; }
+
+private:
+    vector<SConnBenchResult> m_Results;
+};
+
+
+/// Base class for the stand-in servers:  accepts loopback connections in a
+/// background thread and serves each one in a thread of its own.
+class CConnBenchServer
+{
+public:
+    virtual ~CConnBenchServer();
+
+    unsigned short GetPort       (void) const { return m_Port; }
+    unsigned int   GetConnections(void) const { return m_Connections; }
+
+protected:
+    CConnBenchServer(void) = default;
+
+    /// Bind and start accepting;  must be called by the derived constructor
+    void x_Start(void);
+    /// Stop accepting and wait for all connections to end;  must be called
+    /// by the derived destructor
+    void x_Stop(void);
+
+    /// Whether the server is being stopped (connections should wind down)
+    const atomic<bool>& x_Stopping(void) const { return m_Stop; }
+
+    /// Serve the connection until the client closes it
+    virtual void x_Serve(CSocket& sock) = 0;
+
+private:
+    CListeningSocket     m_Listener;
+    unsigned short       m_Port = 0;
+    atomic<unsigned int> m_Connections{0};
+    atomic<bool>         m_Stop{false};
+    thread               m_Thread;
+};
+
+
+/// Echoes any data back
+class CConnBenchEchoServer : public CConnBenchServer
+{
+public:
+    CConnBenchEchoServer(void)  { x_Start(); }
+    ~CConnBenchEchoServer()     { x_Stop();  }
+
+protected:
+    virtual void x_Serve(CSocket& sock);
+};
+
+
+/// HTTP/1.1 server with keep-alive:  "GET /<N>" gets an N-byte response body
+class CConnBenchHttpServer : public CConnBenchServer
+{
+public:
+    CConnBenchHttpServer(void)  { x_Start(); }
+    ~CConnBenchHttpServer()     { x_Stop();  }
+
+protected:
+    virtual void x_Serve(CSocket& sock);
+};
+
+
+END_NCBI_SCOPE
+
+#endif /* CONNBENCH__HPP */
@@ -0,0 +1,554 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Loopback benchmarks of the socket, memory, file, pipe, HTTP and service
+ *   connectors, and of CServer with different numbers of worker threads:
+ *   latency percentiles, throughput and CPU per request, with the results
+ *   optionally saved (JSON lines) and compared against a saved baseline
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/request_status.hpp>
+#include <connect/ncbi_conn_stream.hpp>
+#include <connect/ncbi_file_connector.h>
+#include <connect/ncbi_http_session.hpp>
+#include <connect/server.hpp>
+#include "connbench.hpp"
+
+#include "test_assert.h"  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+static const char kService[] = "CONNBENCH";
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CServer line echo (as in test_server_perf)
+
+class CEchoServer : public CServer
+{
+public:
+    CEchoServer(void) : m_Stop(false) { }
+
+    virtual bool ShutdownRequested(void) { return m_Stop; }
+    void RequestShutdown(void) { m_Stop = true; }
+
+private:
+    volatile bool m_Stop;
+};
+
+
+class CEchoHandler : public IServer_LineMessageHandler
+{
+public:
+    virtual void OnOpen(void)  { GetSocket().DisableOSSendDelay(); }
+    virtual void OnWrite(void) { }
+    virtual void OnMessage(BUF buf)
+    {
+        string data(BUF_Size(buf), '\0');
+        data.resize(BUF_Read(buf, &data[0], data.size()));
+        data += '\n';
+        GetSocket().Write(data.data(), data.size());
+    }
+};
+
+
+class CEchoFactory : public IServer_ConnectionFactory
+{
+public:
+    virtual IServer_ConnectionHandler* Create(void)
+    {
+        return new CEchoHandler;
+    }
+};
+
+
+class CServerThread : public CThread
+{
+public:
+    CServerThread(CEchoServer& server) : m_Server(server) { }
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Server.Run();
+        return NULL;
+    }
+
+private:
+    CEchoServer& m_Server;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestConnBenchApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    typedef function<void(CConnBenchMeter::CThreadLog&, size_t)> TClient;
+
+    // Run the client in all threads once for each size, with the optional
+    // setup (for the size) done before each run
+    void x_Run(const string& suite, const string& variant, const TClient& f,
+               const function<void(size_t)>& setup = nullptr);
+
+    void x_Socket (void);
+    void x_Stream (void);
+    void x_Memory (void);
+    void x_File   (void);
+    void x_Pipe   (void);
+    void x_Http   (void);
+    void x_Service(void);
+    void x_Server (void);
+
+    CConnBenchReport m_Report;
+    vector<size_t>   m_Sizes;
+    size_t           m_Requests;
+    unsigned int     m_Threads;
+    atomic<size_t>   m_Failed;
+};
+
+
+void CTestConnBenchApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "Loopback benchmarks of connectors and servers");
+    d->AddDefaultKey("suites", "List",
+                     "Comma-separated suites to run:  socket, stream, memory, "
+                     "file, pipe, http, service, server",
+                     CArgDescriptions::eString,
+                     "socket,stream,memory,file,pipe,http,service,server");
+    d->AddDefaultKey("requests", "N", "Requests per client thread",
+                     CArgDescriptions::eInteger, "2000");
+    d->SetConstraint("requests", new CArgAllow_Integers(1, kMax_Int));
+    d->AddDefaultKey("sizes", "List",
+                     "Comma-separated payload sizes, bytes",
+                     CArgDescriptions::eString, "64,4096,65536");
+    d->AddDefaultKey("threads", "N", "Client threads (connector suites)",
+                     CArgDescriptions::eInteger, "1");
+    d->SetConstraint("threads", new CArgAllow_Integers(1, 1024));
+    d->AddDefaultKey("workers", "List",
+                     "Comma-separated numbers of CServer worker threads",
+                     CArgDescriptions::eString, "1,2,4,8");
+    d->AddDefaultKey("clients", "N", "Concurrent clients (server suite)",
+                     CArgDescriptions::eInteger, "8");
+    d->SetConstraint("clients", new CArgAllow_Integers(1, 1024));
+    d->AddOptionalKey("json", "File",
+                      "Save the results as JSON lines (\"-\" for stdout)",
+                      CArgDescriptions::eString);
+    d->AddOptionalKey("baseline", "File",
+                      "Compare throughput with the results saved by -json, "
+                      "and fail on regressions",
+                      CArgDescriptions::eInputFile);
+    d->AddDefaultKey("tolerance", "Fraction",
+                     "Throughput drop vs. the baseline deemed a regression",
+                     CArgDescriptions::eDouble, "0.25");
+    SetupArgDescriptions(d.release());
+}
+
+
+void CTestConnBenchApp::x_Run(const string& suite, const string& variant,
+                              const TClient& f,
+                              const function<void(size_t)>& setup)
+{
+    for (size_t size : m_Sizes) {
+        if (setup)
+            setup(size);
+        string name = "size=" + NStr::NumericToString(size);
+        if (!variant.empty())
+            name = variant + ',' + name;
+        if (m_Threads > 1)
+            name += ",threads=" + NStr::NumericToString(m_Threads);
+        CConnBenchMeter meter(suite, name);
+        m_Report.Add(meter.Run(m_Threads,
+                               [&f, size](CConnBenchMeter::CThreadLog& log) {
+                                   f(log, size);
+                               }));
+    }
+}
+
+
+// Write the data and read it back, in chunks (not to overfill any buffers)
+static bool s_RoundTrip(CNcbiIostream& io, const string& data, string& buf)
+{
+    static const size_t kChunk = 16384;
+    for (size_t pos = 0;  pos < data.size();  pos += kChunk) {
+        size_t n = min(kChunk, data.size() - pos);
+        if (!io.write(data.data() + pos, n).flush()
+            ||  !io.read(&buf[pos], n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void CTestConnBenchApp::x_Socket(void)
+{
+    CConnBenchEchoServer server;
+    x_Run("socket", kEmptyStr,
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        CSocket sock("127.0.0.1", server.GetPort());
+        sock.DisableOSSendDelay();
+        string data(size, 's'), buf(size, '\0');
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            if (sock.Write(data.data(), size) != eIO_Success
+                ||  sock.Read(&buf[0], size, 0, eIO_ReadPersist)
+                != eIO_Success  ||  buf != data) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    });
+}
+
+
+void CTestConnBenchApp::x_Stream(void)
+{
+    // Response bodies from the HTTP server, read off a socket stream either
+    // at once, or in small pieces
+    CConnBenchHttpServer server;
+    for (size_t chunk : { (size_t) 0, (size_t) 1024 }) {
+        x_Run("stream", chunk ? "chunk=" + NStr::NumericToString(chunk)
+              : string("read"),
+              [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+            CConn_SocketStream sock("127.0.0.1", server.GetPort(), 1);
+            string request = "GET /" + NStr::NumericToString(size)
+                + " HTTP/1.1\r\n\r\n", line;
+            vector<char> buf(size + 1);
+            for (size_t i = 0;  i < m_Requests;  ++i) {
+                CStopWatch sw(CStopWatch::eStart);
+                sock << request << flush;
+                while (getline(sock, line)  &&  line != "\r")
+                    ;
+                size_t n_read = 0;
+                while (n_read < size  &&  sock) {
+                    size_t n = chunk ? min(chunk, size - n_read)
+                        : size - n_read;
+                    n_read += (size_t) sock.read(&buf[n_read], n).gcount();
+                }
+                if (!sock  ||  n_read != size) {
+                    ++m_Failed;
+                    break;
+                }
+                log.Add(sw.Elapsed(), size);
+            }
+        });
+    }
+}
+
+
+void CTestConnBenchApp::x_Memory(void)
+{
+    x_Run("memory", kEmptyStr,
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        CConn_MemoryStream mem;
+        string data(size, 'm'), buf(size, '\0');
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            if (!s_RoundTrip(mem, data, buf)  ||  buf != data) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    });
+}
+
+
+void CTestConnBenchApp::x_File(void)
+{
+    // Each request opens a file connector and reads the whole file
+    string path = CFile::GetTmpName(CFile::eTmpFileCreate);
+    x_Run("file", kEmptyStr,
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        string buf(size, '\0');
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            CONN conn;
+            if (CONN_Create(FILE_CreateConnector(path.c_str(), 0), &conn)
+                != eIO_Success) {
+                ++m_Failed;
+                break;
+            }
+            CConn_IOStream file(conn, true/*close*/);
+            if (!file.read(&buf[0], size)  ||  file.get() != EOF) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    }, [&path](size_t size) {
+        CNcbiOfstream(path.c_str(), IOS_BASE::binary | IOS_BASE::trunc)
+            << string(size, 'f');
+    });
+    CFile(path).Remove();
+}
+
+
+void CTestConnBenchApp::x_Pipe(void)
+{
+#ifdef NCBI_OS_UNIX
+    x_Run("pipe", kEmptyStr,
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        CConn_PipeStream cat("cat", vector<string>());
+        string data(size, 'p'), buf(size, '\0');
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            if (!s_RoundTrip(cat, data, buf)  ||  buf != data) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    });
+#else
+    ERR_POST(Warning << "The pipe suite is only available on UNIX");
+#endif /*NCBI_OS_UNIX*/
+}
+
+
+void CTestConnBenchApp::x_Http(void)
+{
+    CConnBenchHttpServer server;
+    string url = "http://127.0.0.1:" + NStr::NumericToString(server.GetPort())
+        + '/';
+
+    // CHttpSession re-uses persistent connections
+    x_Run("http", "pooled",
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        CHttpSession session;
+        session.SetProtocol(CHttpSession::eHTTP_11);
+        CUrl size_url(url + NStr::NumericToString(size));
+        string body;
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            CHttpResponse response = session.Get(size_url);
+            body.clear();
+            if (response.GetStatusCode() != CRequestStatus::e200_Ok
+                ||  !NcbiStreamToString(&body, response.ContentStream())
+                ||  body.size() != size) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    });
+
+    // A new connection for each request
+    x_Run("http", "fresh",
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        string size_url(url + NStr::NumericToString(size));
+        string body;
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            CConn_HttpStream http(size_url);
+            body.clear();
+            if (!NcbiStreamToString(&body, http)  ||  body.size() != size) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    });
+}
+
+
+void CTestConnBenchApp::x_Service(void)
+{
+    // Resolved by the LOCAL mapper only;  the server path selects the size
+    CConnBenchHttpServer server;
+    string host = "HTTP 127.0.0.1:" + NStr::NumericToString(server.GetPort());
+    SetEnvironment("CONN_LOCAL_ENABLE",   "1");
+    SetEnvironment("CONN_LBSMD_DISABLE",  "1");
+    SetEnvironment("CONN_DISPD_DISABLE",  "1");
+    x_Run("service", kEmptyStr,
+          [&](CConnBenchMeter::CThreadLog& log, size_t size) {
+        string body;
+        for (size_t i = 0;  i < m_Requests;  ++i) {
+            CStopWatch sw(CStopWatch::eStart);
+            CConn_ServiceStream svc(kService, fSERV_Http);
+            body.clear();
+            if (!NcbiStreamToString(&body, svc)  ||  body.size() != size) {
+                ++m_Failed;
+                break;
+            }
+            log.Add(sw.Elapsed(), size);
+        }
+    }, [&](size_t size) {
+        SetEnvironment(string(kService) + "_CONN_LOCAL_SERVER_0",
+                       host + " /" + NStr::NumericToString(size));
+    });
+}
+
+
+void CTestConnBenchApp::x_Server(void)
+{
+    const CArgs& args = GetArgs();
+    vector<string> workers;
+    NStr::Split(args["workers"].AsString(), ",", workers,
+                NStr::fSplit_Tokenize);
+    unsigned int clients = (unsigned int) args["clients"].AsInteger();
+
+    for (const string& w : workers) {
+        unsigned short port = 4096;
+        {{
+            CListeningSocket listener;
+            while (++port) {
+                if (listener.Listen(port, 5, fSOCK_BindLocal | fSOCK_LogOff)
+                    == eIO_Success) {
+                    break;
+                }
+            }
+            if (!port) {
+                ERR_POST("Unable to find a free port to listen on");
+                ++m_Failed;
+                return;
+            }
+        }}
+
+        static const STimeout kAcceptTimeout = { 0, 100000 };
+        static const STimeout kIdleTimeout   = { 3600, 0 };
+        SServer_Parameters params;
+        params.init_threads    = 1;
+        params.max_threads     = NStr::StringToUInt(w);
+        params.max_connections = 10000;
+        params.accept_timeout  = &kAcceptTimeout;
+        params.idle_timeout    = &kIdleTimeout;
+
+        CEchoServer server;
+        server.SetParameters(params);
+        server.AddListener(new CEchoFactory, port);
+        server.StartListening();
+        CRef<CServerThread> thread(new CServerThread(server));
+        thread->Run();
+
+        // Each request is a line of the first size
+        size_t size = m_Sizes.empty() ? 64 : m_Sizes.front();
+        CConnBenchMeter meter("server", "workers=" + w + ",clients="
+                              + NStr::NumericToString(clients));
+        m_Report.Add(meter.Run(clients,
+                               [&](CConnBenchMeter::CThreadLog& log) {
+            CSocket sock("127.0.0.1", port);
+            sock.DisableOSSendDelay();
+            string line(max(size, (size_t) 2) - 1, 'c'), reply;
+            line += '\n';
+            for (size_t i = 0;  i < m_Requests;  ++i) {
+                CStopWatch sw(CStopWatch::eStart);
+                if (sock.Write(line.data(), line.size()) != eIO_Success
+                    ||  sock.ReadLine(reply) != eIO_Success
+                    ||  reply.size() + 1 != line.size()) {
+                    ++m_Failed;
+                    break;
+                }
+                log.Add(sw.Elapsed(), line.size());
+            }
+        }));
+
+        server.RequestShutdown();
+        thread->Join();
+    }
+}
+
+
+int CTestConnBenchApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    m_Requests = (size_t) args["requests"].AsInteger();
+    m_Threads  = (unsigned int) args["threads"].AsInteger();
+    m_Failed   = 0;
+    vector<string> list;
+    NStr::Split(args["sizes"].AsString(), ",", list, NStr::fSplit_Tokenize);
+    for (const string& size : list)
+        m_Sizes.push_back(NStr::StringToSizet(size));
+
+    list.clear();
+    NStr::Split(args["suites"].AsString(), ",", list, NStr::fSplit_Tokenize);
+    for (const string& suite : list) {
+        if      (suite == "socket")
+            x_Socket();
+        else if (suite == "stream")
+            x_Stream();
+        else if (suite == "memory")
+            x_Memory();
+        else if (suite == "file")
+            x_File();
+        else if (suite == "pipe")
+            x_Pipe();
+        else if (suite == "http")
+            x_Http();
+        else if (suite == "service")
+            x_Service();
+        else if (suite == "server")
+            x_Server();
+        else {
+            ERR_POST(Error << "Unknown suite \"" << suite << '"');
+            return 2;
+        }
+    }
+
+    if (args["json"])
+        m_Report.Save(args["json"].AsString());
+
+    int retval = 0;
+    if (m_Failed) {
+        ERR_POST(Error << m_Failed << " client(s) failed");
+        retval = 1;
+    }
+    if (args["baseline"]
+        &&  m_Report.Compare(args["baseline"].AsString(),
+                             args["tolerance"].AsDouble())) {
+        retval = 1;
+    }
+    _ASSERT(!m_Failed);
+    return retval;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestConnBenchApp().AppMain(argc, argv);
+}
@@ -0,0 +1,276 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors: NCBI C++ Toolkit
+ *
+ * File Description:
+ *   CHttp2Session throughput against a local h2c (cleartext HTTP/2)
+ *   stand-in server, for different numbers of I/O loops
+ *
+ */
+
+#include <ncbi_pch.hpp>
+
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/request_status.hpp>
+#include <connect/ncbi_http2_session.hpp>
+#include <connect/ncbi_socket.hpp>
+
+#include <nghttp2/nghttp2.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+#include "connbench.hpp"
+
+#include "test_assert.h"  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+// Serves one connection: every request gets a small "200 OK" response
+struct SH2cConnection
+{
+    SH2cConnection(CSocket* sock) : m_Socket(sock) {}
+
+    void Run();
+
+private:
+    static ssize_t s_Send(nghttp2_session*, const uint8_t* data, size_t length, int, void* user_data)
+    {
+        auto that = static_cast<SH2cConnection*>(user_data);
+        size_t written = 0;
+        auto status = that->m_Socket->Write(data, length, &written, eIO_WritePersist);
+        return status == eIO_Success ? static_cast<ssize_t>(written) : NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+
+    static int s_OnFrameRecv(nghttp2_session* session, const nghttp2_frame* frame, void*)
+    {
+        // Respond once the whole request (headers and body, if any) is received
+        if ((frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA) &&
+                (frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+            static const nghttp2_nv kHeaders[] = {
+                { (uint8_t*)":status", (uint8_t*)"200", 7, 3, NGHTTP2_NV_FLAG_NONE },
+                { (uint8_t*)"content-type", (uint8_t*)"text/plain", 12, 10, NGHTTP2_NV_FLAG_NONE },
+            };
+            nghttp2_data_provider data_prd;
+            data_prd.source.ptr = nullptr;
+            data_prd.read_callback = s_ReadBody;
+            nghttp2_submit_response(session, frame->hd.stream_id, kHeaders, 2, &data_prd);
+        }
+
+        return 0;
+    }
+
+    static ssize_t s_ReadBody(nghttp2_session*, int32_t, uint8_t* buf, size_t length, uint32_t* data_flags,
+            nghttp2_data_source*, void*)
+    {
+        static const char kBody[] = "ok\n";
+        auto n = min(length, sizeof(kBody) - 1);
+        memcpy(buf, kBody, n);
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        return static_cast<ssize_t>(n);
+    }
+
+    unique_ptr<CSocket> m_Socket;
+};
+
+void SH2cConnection::Run()
+{
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_send_callback(callbacks, s_Send);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, s_OnFrameRecv);
+
+    nghttp2_session* session;
+    nghttp2_session_server_new(&session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+
+    nghttp2_settings_entry settings[] = { { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 1000 } };
+    nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, 1);
+    m_Socket->DisableOSSendDelay();
+
+    char buf[16384];
+
+    while (nghttp2_session_want_read(session) || nghttp2_session_want_write(session)) {
+        if (nghttp2_session_send(session)) break;
+
+        size_t n_read = 0;
+        if (m_Socket->Read(buf, sizeof(buf), &n_read, eIO_ReadPlain) != eIO_Success) break;
+
+        if (nghttp2_session_mem_recv(session, reinterpret_cast<uint8_t*>(buf), n_read) < 0) break;
+    }
+
+    nghttp2_session_del(session);
+}
+
+
+// Accepts connections until stopped, one thread per connection
+struct SH2cServer
+{
+    SH2cServer();
+    ~SH2cServer();
+
+    unsigned short GetPort() const { return m_Port; }
+
+private:
+    void Run();
+
+    CListeningSocket m_Listener;
+    unsigned short m_Port = 0;
+    atomic<bool> m_Stop{false};
+    thread m_Thread;
+};
+
+SH2cServer::SH2cServer()
+{
+    for (unsigned short port = 4096; port; ++port) {
+        if (m_Listener.Listen(port, 128, fSOCK_BindLocal | fSOCK_LogOff) == eIO_Success) {
+            m_Port = port;
+            break;
+        }
+    }
+
+    if (!m_Port) {
+        NCBI_THROW(CException, eUnknown, "Unable to find a free port to listen on");
+    }
+
+    m_Thread = thread(&SH2cServer::Run, this);
+}
+
+SH2cServer::~SH2cServer()
+{
+    m_Stop = true;
+    m_Thread.join();
+}
+
+void SH2cServer::Run()
+{
+    static const STimeout kTimeout = { 0, 100000 };
+    vector<thread> connections;
+
+    while (!m_Stop) {
+        CSocket* sock = nullptr;
+
+        if (m_Listener.Accept(sock, &kTimeout) == eIO_Success) {
+            connections.emplace_back([sock]() { SH2cConnection(sock).Run(); });
+        }
+    }
+
+    // Connections end when clients close them
+    for (auto& t : connections) {
+        t.join();
+    }
+}
+
+
+class CNCBITestHttp2SessionPerfApp : public CNcbiApplication
+{
+    void Init(void);
+    int  Run (void);
+};
+
+
+void CNCBITestHttp2SessionPerfApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(), "CHttp2Session throughput vs. number of I/O loops");
+    d->AddDefaultKey("loops", "N", "Number of I/O loops ([HTTP2]IO_LOOPS)", CArgDescriptions::eInteger, "1");
+    d->AddDefaultKey("selection", "Mode", "Loop selection ([HTTP2]IO_LOOP_SELECTION)",
+            CArgDescriptions::eString, "least_loaded");
+    d->SetConstraint("selection", &(*new CArgAllow_Strings, "least_loaded", "authority"));
+    d->AddDefaultKey("threads", "N", "Client threads", CArgDescriptions::eInteger, "8");
+    d->AddDefaultKey("requests", "N", "Requests per client thread", CArgDescriptions::eInteger, "1000");
+    d->AddOptionalKey("json", "File", "Save the results as JSON lines (\"-\" for stdout)", CArgDescriptions::eString);
+    d->AddOptionalKey("baseline", "File", "Compare throughput with the results saved by -json, and fail on regressions",
+            CArgDescriptions::eInputFile);
+    d->AddDefaultKey("tolerance", "Fraction", "Throughput drop vs. the baseline deemed a regression",
+            CArgDescriptions::eDouble, "0.25");
+    SetupArgDescriptions(d.release());
+}
+
+int CNCBITestHttp2SessionPerfApp::Run(void)
+{
+    const auto& args = GetArgs();
+    const auto loops = args["loops"].AsString();
+    const auto selection = args["selection"].AsString();
+    const auto kThreadNum = static_cast<size_t>(args["threads"].AsInteger());
+    const auto kRequestNum = args["requests"].AsInteger();
+
+    // Read when the I/O implementation is created (by the first session)
+    GetRWConfig().Set("HTTP2", "IO_LOOPS", loops);
+    GetRWConfig().Set("HTTP2", "IO_LOOP_SELECTION", selection);
+
+    SH2cServer server;
+    const string kUrl("http://127.0.0.1:" + NStr::UIntToString(server.GetPort()) + "/");
+    atomic_size_t failed(0);
+
+    auto f = [&](CConnBenchMeter::CThreadLog& log) {
+        CHttp2Session session;
+
+        for (auto i = kRequestNum; i > 0; --i) {
+            CStopWatch sw(CStopWatch::eStart);
+            CHttpRequest request = session.NewRequest(kUrl);
+            CHttpResponse response = request.Execute();
+
+            if (response.GetStatusCode() == CRequestStatus::e200_Ok) {
+                stringstream ss;
+                ss << response.ContentStream().rdbuf();
+                log.Add(sw.Elapsed(), ss.str().size());
+            } else {
+                ++failed;
+            }
+        }
+    };
+
+    auto api_lock = CHttp2Session::GetApiLock();
+    CConnBenchMeter meter("http2", "loops=" + loops + "," + selection + ",threads=" + NStr::NumericToString(kThreadNum));
+    CConnBenchReport report;
+    report.Add(meter.Run(static_cast<unsigned int>(kThreadNum), f));
+    api_lock.reset();
+
+    if (args["json"]) {
+        report.Save(args["json"].AsString());
+    }
+
+    int retval = failed ? 1 : 0;
+
+    if (args["baseline"] && report.Compare(args["baseline"].AsString(), args["tolerance"].AsDouble())) {
+        retval = 1;
+    }
+
+    _ASSERT(!failed);
+    return retval;
+}
+
+
+int main(int argc, const char* argv[])
+{
+    return CNCBITestHttp2SessionPerfApp().AppMain(argc, argv);
+}
@@ -0,0 +1,270 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Re-use of persistent connections by CHttpSession, against a local
+ *   HTTP/1.1 server
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/request_status.hpp>
+#include <connect/ncbi_http_session.hpp>
+#include <connect/ncbi_socket.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "test_assert.h"  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+static const STimeout kTimeout = { 10, 0 };
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Server:  serves any number of requests per connection;  the body of each
+//  response is the request path, sent chunked for "/chunked";  "/drop" has the
+//  connection closed after the response (w/o telling the client beforehand)
+
+class CHttpServer
+{
+public:
+    CHttpServer(void);
+    ~CHttpServer();
+
+    unsigned short GetPort       (void) const { return m_Port;        }
+    unsigned int   GetConnections(void) const { return m_Connections; }
+
+private:
+    void x_Serve(CSocket* sock);
+
+    CListeningSocket     m_Listener;
+    unsigned short       m_Port;
+    atomic<unsigned int> m_Connections;
+    atomic<bool>         m_Stop;
+    thread               m_Thread;
+};
+
+
+CHttpServer::CHttpServer(void)
+    : m_Port(0), m_Connections(0), m_Stop(false)
+{
+    for (unsigned short port = 8080;  port;  ++port) {
+        if (m_Listener.Listen(port, 5, fSOCK_BindLocal | fSOCK_LogOff)
+            == eIO_Success) {
+            m_Port = port;
+            break;
+        }
+    }
+    if (!m_Port) {
+        NCBI_THROW(CException, eUnknown,
+                   "Unable to find a free port to listen on");
+    }
+    m_Thread = thread([this]() {
+        static const STimeout kPoll = { 0, 100000 };
+        vector<thread> workers;
+        while (!m_Stop) {
+            CSocket* sock = 0;
+            if (m_Listener.Accept(sock, &kPoll) != eIO_Success)
+                continue;
+            ++m_Connections;
+            workers.emplace_back(&CHttpServer::x_Serve, this, sock);
+        }
+        for (auto& worker : workers)
+            worker.join();
+    });
+}
+
+
+CHttpServer::~CHttpServer()
+{
+    m_Stop = true;
+    m_Thread.join();
+}
+
+
+void CHttpServer::x_Serve(CSocket* sock)
+{
+    sock->SetTimeout(eIO_ReadWrite, &kTimeout);
+    for (;;) {
+        string line;
+        if (sock->ReadLine(line) != eIO_Success  ||  line.empty())
+            break;
+        // GET /path HTTP/1.x
+        vector<string> request;
+        NStr::Split(line, " ", request);
+        _ASSERT(request.size() == 3);
+        bool http10    = request[2] == "HTTP/1.0";
+        bool keepalive = !http10;
+        for (;;) {
+            if (sock->ReadLine(line) != eIO_Success)
+                break;
+            if (line.empty())
+                break;
+            if (NStr::EqualNocase(line, "Connection: keep-alive"))
+                keepalive = true;
+        }
+        const string& path = request[1];
+        string reply(request[2] + " 200 OK\r\n");
+        if (http10  &&  keepalive)
+            reply += "Connection: keep-alive\r\n";
+        if (path == "/chunked"  &&  !http10) {
+            reply += "Transfer-Encoding: chunked\r\n\r\n"
+                + NStr::NumericToString(path.size(), 0, 16) + "\r\n"
+                + path + "\r\n0\r\n\r\n";
+        } else {
+            reply += "Content-Length: "
+                + NStr::NumericToString(path.size()) + "\r\n\r\n" + path;
+        }
+        if (sock->Write(reply.data(), reply.size()) != eIO_Success
+            ||  !keepalive  ||  path == "/drop") {
+            break;
+        }
+    }
+    sock->Close();
+    delete sock;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestHttpPoolApp : public CNcbiApplication
+{
+public:
+    virtual int Run(void);
+
+private:
+    void x_Get(CHttpSession& session, const string& path);
+
+    string m_Url;
+};
+
+
+void CTestHttpPoolApp::x_Get(CHttpSession& session, const string& path)
+{
+    CHttpResponse response = session.Get(m_Url + path);
+    _ASSERT(response.GetStatusCode() == CRequestStatus::e200_Ok);
+    string body;
+    NcbiStreamToString(&body, response.ContentStream());
+    _ASSERT(body == path);
+}
+
+
+static void s_PrintStats(const char* what, const SHTTP_ConnPoolStats& stats,
+                         unsigned int connections)
+{
+    NcbiCout << what
+             << ": connections=" << connections
+             << " hits="         << stats.hits
+             << " misses="       << stats.misses
+             << " released="     << stats.released
+             << " stale="        << stats.stale
+             << " idle="         << stats.idle << NcbiEndl;
+}
+
+
+int CTestHttpPoolApp::Run(void)
+{
+    CHttpServer server;
+    m_Url = "http://127.0.0.1:" + NStr::NumericToString(server.GetPort());
+    // Sessions do not pool connections unless asked to
+    GetRWConfig().Set("CONN", "HTTP_POOL_MAX_IDLE", "8");
+
+    // HTTP/1.1:  sequential requests all go over a single connection
+    {{
+        CHttpSession session;
+        session.SetProtocol(CHttpSession::eHTTP_11);
+        x_Get(session, "/first");
+        x_Get(session, "/chunked");
+        x_Get(session, "/chunked");
+        x_Get(session, "/last");
+        SHTTP_ConnPoolStats stats = session.GetConnPoolStats();
+        s_PrintStats("HTTP/1.1", stats, server.GetConnections());
+        _ASSERT(server.GetConnections() == 1);
+        _ASSERT(stats.misses   == 1);
+        _ASSERT(stats.hits     == 3);
+        _ASSERT(stats.released == 4);
+        _ASSERT(stats.idle     == 1);
+    }}
+
+    // HTTP/1.0 with keep-alive (the session's default protocol)
+    {{
+        CHttpSession session;
+        x_Get(session, "/first");
+        x_Get(session, "/second");
+        SHTTP_ConnPoolStats stats = session.GetConnPoolStats();
+        s_PrintStats("HTTP/1.0", stats, server.GetConnections());
+        _ASSERT(server.GetConnections() == 2);
+        _ASSERT(stats.hits == 1);
+    }}
+
+    // A connection dropped by the server while idle does not get re-used
+    {{
+        CHttpSession session;
+        session.SetProtocol(CHttpSession::eHTTP_11);
+        x_Get(session, "/drop");
+        SleepMilliSec(200);
+        x_Get(session, "/after");
+        SHTTP_ConnPoolStats stats = session.GetConnPoolStats();
+        s_PrintStats("Dropped", stats, server.GetConnections());
+        _ASSERT(server.GetConnections() == 4);
+        _ASSERT(stats.stale  == 1);
+        _ASSERT(stats.misses == 2);
+        _ASSERT(stats.hits   == 0);
+    }}
+
+    // Flushing closes idle connections
+    {{
+        CHttpSession session;
+        session.SetProtocol(CHttpSession::eHTTP_11);
+        x_Get(session, "/first");
+        session.FlushConnPool();
+        x_Get(session, "/second");
+        SHTTP_ConnPoolStats stats = session.GetConnPoolStats();
+        s_PrintStats("Flushed", stats, server.GetConnections());
+        _ASSERT(server.GetConnections() == 6);
+        _ASSERT(stats.misses   == 1);
+        _ASSERT(stats.released == 1);
+    }}
+
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestHttpPoolApp().AppMain(argc, argv);
+}
@@ -38,6 +38,11 @@
 
 #include "test_assert.h"  /* This header must go last */
 
+#ifdef _MSC_VER
+#define unsetenv(n)     _putenv_s(n,"")
+#define setenv(n,v,w)   _putenv_s(n,v)
+#endif /*_MSC_VER*/
+
 
 static unsigned int s_Resolve(const char* name, TSERV_Type types)
 {
@@ -73,6 +78,122 @@ static unsigned int s_Resolve(const char* name, TSERV_Type types)
 }
 
 
+/* Service resolution cache, offline (LOCAL mapper only) */
+static const char* kCacheEnv[] = {
+    "CONN_LOCAL_ENABLE",
+    "CONN_LBSMD_DISABLE",
+    "CONN_DISPD_DISABLE",
+    "TEST_NCBI_SERVICE_CACHE_CONN_LOCAL_SERVER_0",
+    "CONN_SERVICE_CACHE_TTL",
+    "CONN_SERVICE_CACHE_NEGATIVE_TTL"
+};
+
+
+/* Start afresh with the TTLs given (in seconds, 0 for the default) */
+static void s_SetupCache(const char* ttl, const char* negative_ttl)
+{
+    setenv(kCacheEnv[0], "1", 1);
+    setenv(kCacheEnv[1], "1", 1);
+    setenv(kCacheEnv[2], "1", 1);
+    setenv(kCacheEnv[3], "STANDALONE 127.0.0.1:1234", 1);
+    setenv(kCacheEnv[4], ttl, 1);
+    if (negative_ttl)
+        setenv(kCacheEnv[5], negative_ttl, 1);
+    else
+        unsetenv(kCacheEnv[5]);
+    SERV_FlushCache();
+}
+
+
+static void s_CleanupCache(void)
+{
+    size_t n;
+    for (n = 0;  n < sizeof(kCacheEnv) / sizeof(kCacheEnv[0]);  ++n)
+        unsetenv(kCacheEnv[n]);
+    SERV_FlushCache();
+}
+
+
+static void s_GetCacheStats(SSERV_CacheStats* stats)
+{
+    SERV_GetCacheStats(stats);
+    CORE_LOGF(eLOG_Note, ("Cache: %lu hit(s), %lu negative hit(s),"
+                          " %lu miss(es), %lu refresh(es), %lu entries",
+                          stats->hits, stats->negative_hits, stats->misses,
+                          stats->refreshes, stats->entries));
+}
+
+
+static void s_CacheTest(void)
+{
+    SSERV_CacheStats stats;
+
+    s_SetupCache("60", 0);
+
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    assert(!s_Resolve("test_ncbi_service_nocache", fSERV_Any));
+    assert(!s_Resolve("test_ncbi_service_nocache", fSERV_Any));
+
+    s_GetCacheStats(&stats);
+    assert(stats.hits          == 1);
+    assert(stats.negative_hits == 1);
+    assert(stats.misses        == 2);
+    assert(stats.entries       == 2);
+
+    s_CleanupCache();
+}
+
+
+/* Refresh-ahead and expiration with short TTLs (takes about 12 seconds):
+ * the cache time is in whole seconds, so an 8-second TTL leaves a 2-second
+ * window between the refresh point (at 3/4 of the TTL) and the expiration.
+ * There is no refresher thread in C, so the hit refreshes the entry itself.
+ */
+static void s_CacheTtlTest(void)
+{
+    SSERV_CacheStats stats;
+
+    s_SetupCache("8", "1");
+
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    assert(!s_Resolve("test_ncbi_service_nocache", fSERV_Any));
+
+    /* past 3/4 of the TTL:  the hit still gets served, and refreshes */
+    CORE_Msdelay(6500);
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    /* the negative entry has expired by now */
+    assert(!s_Resolve("test_ncbi_service_nocache", fSERV_Any));
+    s_GetCacheStats(&stats);
+    assert(stats.hits          == 1);
+    assert(stats.refreshes     == 1);
+    assert(stats.negative_hits == 0);
+    assert(stats.misses        == 3);
+    assert(stats.entries       == 2);
+
+    /* past the original expiration:  the refreshed entry is still a hit */
+    CORE_Msdelay(2000);
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    s_GetCacheStats(&stats);
+    assert(stats.hits          == 2);
+    assert(stats.refreshes     == 1);
+    assert(stats.misses        == 3);
+
+    /* an entry that is not hit in time just expires */
+    s_SetupCache("2", 0);
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    CORE_Msdelay(3000);
+    assert( s_Resolve("test_ncbi_service_cache",   fSERV_Any) == 1);
+    s_GetCacheStats(&stats);
+    assert(stats.hits          == 0);
+    assert(stats.refreshes     == 0);
+    assert(stats.misses        == 2);
+    assert(stats.entries       == 1);
+
+    s_CleanupCache();
+}
+
+
 static int s_SelfTest(void)
 {
     /* Figure out if wildcarding would work (only in-house) */
@@ -80,6 +201,9 @@ static int s_SelfTest(void)
     const char* ptr = env ? strstr(env, "in-house-resources") : 0;
     if (ptr  &&  ptr > env  &&  ptr[-1] == '-')
         ptr = 0;
+    s_CacheTest();
+    s_CacheTtlTest();
+
 #define WWW "www.ncbi.nlm.nih.gov"
     assert(!s_Resolve(0, fSERV_Any));
     assert( s_Resolve("bounce", fSERV_Any));
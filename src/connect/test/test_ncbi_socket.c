@@ -1101,6 +1101,173 @@ static void TEST_OnTopSock(void)
 #endif /*NCBI_OS_LINUX*/
 
 
+#ifdef NCBI_OS_UNIX
+static void TEST_VectoredIO(void)
+{
+    LSOCK        pipe;
+    SOCK         server, client;
+    BUF          buf = 0;
+    SSOCK_IoVec  iov[4];
+    char         a[8], b[16], c[64], file[64];
+    size_t       n;
+    EIO_Status   status;
+    FILE*        fp;
+    int          fd;
+    const char*  unique = tmpnam(0);
+    CORE_LOGF(eLOG_Note, ("SOCK_WriteV/ReadV/WriteBUF/SendFile(\"%s\")",
+                          unique));
+    verify(LSOCK_CreateUNIX(unique, 64, &pipe, fSOCK_LogDefault)
+           == eIO_Success);
+    verify(SOCK_CreateUNIX(unique, 0, &client, 0, 0, fSOCK_LogDefault)
+           == eIO_Success);
+    verify(LSOCK_Accept(pipe, 0, &server)
+           == eIO_Success);
+
+    /* zero-copy may or may not be available for the socket */
+    status = SOCK_SetZeroCopy(client, 1);
+    assert(status == eIO_Success  ||  status == eIO_NotSupported);
+
+    iov[0].base = (void*) "head";    iov[0].size = 4;
+    iov[1].base = 0;                 iov[1].size = 0;
+    iov[2].base = (void*) "ertail";  iov[2].size = 6;
+    iov[3].base = (void*) "!";       iov[3].size = 1;
+    verify(SOCK_WriteV(client, iov, 4, &n, eIO_WritePersist)
+           == eIO_Success  &&  n == 11);
+
+    verify(BUF_Write(&buf, "buf1", 4)  &&  BUF_Write(&buf, "buf2", 4));
+    verify(SOCK_WriteBUF(client, buf, &n, eIO_WritePersist)
+           == eIO_Success  &&  n == 8  &&  !BUF_Size(buf));
+    BUF_Destroy(buf);
+
+    verify((fp = tmpfile()) != 0);
+    verify(fputs("0123456789", fp) >= 0  &&  fflush(fp) == 0);
+    fd = fileno(fp);
+    verify(SOCK_SendFile(client, fd, 2, 5, &n)
+           == eIO_Success  &&  n == 5);
+    verify(SOCK_SendFile(client, fd, 8, 5, &n)
+           == eIO_Closed   &&  n == 2);
+    fclose(fp);
+
+    /* read all 26 bytes persistently across segments of different sizes */
+    iov[0].base = a;     iov[0].size = 3;
+    iov[1].base = b;     iov[1].size = 0;
+    iov[2].base = b;     iov[2].size = 7;
+    iov[3].base = c;     iov[3].size = 16;
+    verify(SOCK_ReadV(server, iov, 4, &n, eIO_ReadPersist)
+           == eIO_Success  &&  n == 26);
+    memcpy(file,      a, 3);
+    memcpy(file + 3,  b, 7);
+    memcpy(file + 10, c, 16);
+    verify(memcmp(file, "headertail!buf1buf22345689", 26) == 0);
+    verify(SOCK_ReadV(server, iov, 4, &n, eIO_ReadPeek)
+           == eIO_NotSupported  &&  !n);
+
+    verify(SOCK_Destroy(client)
+           == eIO_Success);
+    verify(SOCK_ReadV(server, iov, 4, &n, eIO_ReadPlain)
+           == eIO_Closed  &&  !n);
+    verify(SOCK_Destroy(server)
+           == eIO_Success);
+    verify(LSOCK_Close(pipe)
+           == eIO_Success);
+    remove(unique);
+}
+#endif /*NCBI_OS_UNIX*/
+
+
+#ifdef NCBI_OS_LINUX
+/* Zero-copy needs a TCP socket;  where the kernel cannot do it, the test
+ * only checks that SOCK_WriteV() keeps working with it requested.
+ */
+static void TEST_ZeroCopy(void)
+{
+    static const STimeout kZero = { 0, 0 };
+    static char    data[64 * 1024];  /* must stay intact until sent */
+    char           buf[8192];
+    LSOCK          lsock;
+    SOCK           server, client;
+    SSOCK_IoVec    iov[2];
+    unsigned int   sent, done;
+    size_t         n, n_sent, n_recv;
+    EIO_Status     status;
+    int            zerocopy, i;
+
+    CORE_LOG(eLOG_Note, "SOCK_SetZeroCopy/GetZeroCopyStatus");
+    verify(LSOCK_CreateEx(0, 1, &lsock, fSOCK_LogDefault)
+           == eIO_Success);
+    verify(SOCK_Create("127.0.0.1", LSOCK_GetPort(lsock, eNH_HostByteOrder),
+                       0, &client)
+           == eIO_Success);
+    verify(LSOCK_Accept(lsock, 0, &server)
+           == eIO_Success);
+
+    status = SOCK_SetZeroCopy(client, sizeof(data) / 4);
+    assert(status == eIO_Success  ||  status == eIO_NotSupported);
+    if (!(zerocopy = status == eIO_Success))
+        CORE_LOG(eLOG_Warning, "Zero-copy not supported, copying instead");
+    verify(SOCK_GetZeroCopyStatus(client, &sent, &done)
+           == (zerocopy ? eIO_Success : eIO_NotSupported)
+           &&  !sent  &&  !done);
+
+    for (i = 0;  i < (int) sizeof(data);  ++i)
+        data[i] = (char) i;
+
+    /* below the threshold:  the data gets copied */
+    iov[0].base = data;  iov[0].size = 10;
+    iov[1].base = data;  iov[1].size = 10;
+    verify(SOCK_WriteV(client, iov, 2, &n, eIO_WritePersist)
+           == eIO_Success  &&  n == 20);
+    verify(SOCK_Read(server, buf, 20, &n, eIO_ReadPersist)
+           == eIO_Success  &&  n == 20);
+    verify(memcmp(buf, data, 10) == 0  &&  memcmp(buf + 10, data, 10) == 0);
+    verify(SOCK_GetZeroCopyStatus(client, &sent, 0)
+           != eIO_Timeout  &&  !sent);
+
+    /* above it:  sent without copying, as long as the peer keeps reading */
+    SOCK_SetTimeout(client, eIO_Write, &kZero);
+    SOCK_SetTimeout(server, eIO_Read,  &kZero);
+    n_sent = n_recv = 0;
+    while (n_recv < sizeof(data)) {
+        if (n_sent < sizeof(data)) {
+            iov[0].base = data + n_sent;
+            iov[0].size = (sizeof(data) - n_sent) / 2;
+            iov[1].base = data + n_sent + iov[0].size;
+            iov[1].size = sizeof(data) - n_sent - iov[0].size;
+            status = SOCK_WriteV(client, iov, 2, &n, eIO_WritePlain);
+            assert(status == eIO_Success  ||  status == eIO_Timeout);
+            n_sent += n;
+        }
+        status = SOCK_Read(server, buf, sizeof(buf), &n, eIO_ReadPlain);
+        assert(status == eIO_Success  ||  status == eIO_Timeout);
+        verify(memcmp(buf, data + n_recv, n) == 0);
+        n_recv += n;
+    }
+
+    /* completions come when the peer has consumed the data */
+    for (i = 0;  i < 100;  ++i) {
+        status = SOCK_GetZeroCopyStatus(client, &sent, &done);
+        if (status != eIO_Timeout)
+            break;
+        CORE_Msdelay(10);
+    }
+    CORE_LOGF(eLOG_Note, ("Zero-copy sends: %u issued, %u complete",
+                          sent, done));
+    if (zerocopy) {
+        assert(status == eIO_Success);
+        assert(sent > 0  &&  done == sent);
+    } else
+        assert(status == eIO_NotSupported  &&  !sent);
+
+    verify(SOCK_Destroy(client)
+           == eIO_Success);
+    verify(SOCK_Destroy(server)
+           == eIO_Success);
+    verify(LSOCK_Close(lsock)
+           == eIO_Success);
+}
+#endif /*NCBI_OS_LINUX*/
+
+
 /* Main function
  * Parse command-line options, initialize and cleanup API internals;
  * run client or server test
@@ -1143,6 +1310,14 @@ int main(int argc, const char* argv[])
         TEST_OnTopSock();
 #endif/*NCBI_OS_LINUX*/
 
+#ifdef NCBI_OS_UNIX
+        TEST_VectoredIO();
+#endif/*NCBI_OS_UNIX*/
+
+#ifdef NCBI_OS_LINUX
+        TEST_ZeroCopy();
+#endif/*NCBI_OS_LINUX*/
+
         verify(SOCK_ShutdownAPI() == eIO_Success);
 
         CORE_SetLOCK(0);
@@ -0,0 +1,339 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   TLS session resumption by secure client sockets, against a local
+ *   mbedTLS server that supports both session IDs and session tickets
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <connect/ncbi_socket.hpp>
+#include <connect/ncbi_tls.h>
+
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_cache.h>
+#include <mbedtls/ssl_ticket.h>
+#include <mbedtls/x509_crt.h>
+
+#include <thread>
+
+#include "test_assert.h"  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+static const STimeout kTimeout = { 10, 0 };
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Server:  accepts connections one at a time, answers "ping" with "pong"
+
+class CTlsServer
+{
+public:
+    CTlsServer(mbedtls_ssl_protocol_version max_version);
+    ~CTlsServer();
+
+    unsigned short GetPort(void) const { return m_Port; }
+
+    // Serve "n" connections in a background thread
+    void Start(int n);
+    void Wait(void) { m_Thread.join(); }
+
+private:
+    void x_Serve(CSocket* sock);
+
+    static int x_Send(void* sock, const unsigned char* data, size_t size);
+    static int x_Recv(void* sock, unsigned char* buf, size_t size);
+
+    mbedtls_entropy_context      m_Entropy;
+    mbedtls_ctr_drbg_context     m_CtrDrbg;
+    mbedtls_pk_context           m_Key;
+    mbedtls_x509_crt             m_Cert;
+    mbedtls_ssl_cache_context    m_Cache;
+    mbedtls_ssl_ticket_context   m_Ticket;
+    mbedtls_ssl_config           m_Conf;
+    CListeningSocket             m_Listener;
+    unsigned short               m_Port;
+    thread                       m_Thread;
+};
+
+
+CTlsServer::CTlsServer(mbedtls_ssl_protocol_version max_version)
+    : m_Port(0)
+{
+    mbedtls_entropy_init(&m_Entropy);
+    mbedtls_ctr_drbg_init(&m_CtrDrbg);
+    mbedtls_pk_init(&m_Key);
+    mbedtls_x509_crt_init(&m_Cert);
+    mbedtls_ssl_cache_init(&m_Cache);
+    mbedtls_ssl_ticket_init(&m_Ticket);
+    mbedtls_ssl_config_init(&m_Conf);
+
+    _VERIFY(mbedtls_ctr_drbg_seed(&m_CtrDrbg, mbedtls_entropy_func,
+                                  &m_Entropy, 0, 0) == 0);
+
+    // Self-signed certificate (the client does not verify it anyways)
+    _VERIFY(mbedtls_pk_setup(&m_Key,
+                             mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY))
+            == 0);
+    _VERIFY(mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1,
+                                mbedtls_pk_ec(m_Key),
+                                mbedtls_ctr_drbg_random, &m_CtrDrbg) == 0);
+    mbedtls_x509write_cert crt;
+    mbedtls_x509write_crt_init(&crt);
+    static const unsigned char kSerial[] = { 1 };
+    mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+    mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+    mbedtls_x509write_crt_set_subject_key(&crt, &m_Key);
+    mbedtls_x509write_crt_set_issuer_key(&crt, &m_Key);
+    _VERIFY(mbedtls_x509write_crt_set_serial_raw
+            (&crt, (unsigned char*) kSerial, sizeof(kSerial)) == 0);
+    _VERIFY(mbedtls_x509write_crt_set_subject_name(&crt, "CN=localhost")
+            == 0);
+    _VERIFY(mbedtls_x509write_crt_set_issuer_name(&crt, "CN=localhost")
+            == 0);
+    _VERIFY(mbedtls_x509write_crt_set_validity(&crt, "20200101000000",
+                                               "20991231235959") == 0);
+    unsigned char der[1024];
+    int len = mbedtls_x509write_crt_der(&crt, der, sizeof(der),
+                                        mbedtls_ctr_drbg_random, &m_CtrDrbg);
+    _ASSERT(len > 0);
+    _VERIFY(mbedtls_x509_crt_parse_der(&m_Cert, der + sizeof(der) - len,
+                                       (size_t) len) == 0);
+    mbedtls_x509write_crt_free(&crt);
+
+    _VERIFY(mbedtls_ssl_config_defaults(&m_Conf,
+                                        MBEDTLS_SSL_IS_SERVER,
+                                        MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&m_Conf, mbedtls_ctr_drbg_random, &m_CtrDrbg);
+    mbedtls_ssl_conf_max_tls_version(&m_Conf, max_version);
+    _VERIFY(mbedtls_ssl_conf_own_cert(&m_Conf, &m_Cert, &m_Key) == 0);
+
+    // Session IDs
+    mbedtls_ssl_conf_session_cache(&m_Conf, &m_Cache,
+                                   mbedtls_ssl_cache_get,
+                                   mbedtls_ssl_cache_set);
+    // Session tickets (the only way to resume in TLS 1.3)
+    _VERIFY(mbedtls_ssl_ticket_setup(&m_Ticket,
+                                     mbedtls_ctr_drbg_random, &m_CtrDrbg,
+                                     MBEDTLS_CIPHER_AES_256_GCM, 3600) == 0);
+    mbedtls_ssl_conf_session_tickets_cb(&m_Conf,
+                                        mbedtls_ssl_ticket_write,
+                                        mbedtls_ssl_ticket_parse,
+                                        &m_Ticket);
+
+    for (unsigned short port = 4096;  port;  ++port) {
+        if (m_Listener.Listen(port, 5, fSOCK_BindLocal | fSOCK_LogOff)
+            == eIO_Success) {
+            m_Port = port;
+            break;
+        }
+    }
+    if (!m_Port) {
+        NCBI_THROW(CException, eUnknown,
+                   "Unable to find a free port to listen on");
+    }
+}
+
+
+CTlsServer::~CTlsServer()
+{
+    mbedtls_ssl_config_free(&m_Conf);
+    mbedtls_ssl_ticket_free(&m_Ticket);
+    mbedtls_ssl_cache_free(&m_Cache);
+    mbedtls_x509_crt_free(&m_Cert);
+    mbedtls_pk_free(&m_Key);
+    mbedtls_ctr_drbg_free(&m_CtrDrbg);
+    mbedtls_entropy_free(&m_Entropy);
+}
+
+
+int CTlsServer::x_Send(void* sock, const unsigned char* data, size_t size)
+{
+    size_t n_written;
+    EIO_Status status = static_cast<CSocket*>(sock)->Write(data, size,
+                                                            &n_written);
+    if (status == eIO_Timeout)
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    return status == eIO_Success ? (int) n_written : -1;
+}
+
+
+int CTlsServer::x_Recv(void* sock, unsigned char* buf, size_t size)
+{
+    size_t n_read;
+    EIO_Status status = static_cast<CSocket*>(sock)->Read(buf, size, &n_read);
+    if (status == eIO_Timeout)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    if (status == eIO_Closed)
+        return 0;
+    return status == eIO_Success ? (int) n_read : -1;
+}
+
+
+void CTlsServer::x_Serve(CSocket* sock)
+{
+    sock->SetTimeout(eIO_ReadWrite, &kTimeout);
+
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_init(&ssl);
+    _VERIFY(mbedtls_ssl_setup(&ssl, &m_Conf) == 0);
+    mbedtls_ssl_set_bio(&ssl, sock, x_Send, x_Recv, 0);
+
+    int err = mbedtls_ssl_handshake(&ssl);
+    if (err == 0) {
+        unsigned char buf[80];
+        if ((err = mbedtls_ssl_read(&ssl, buf, sizeof(buf))) > 0) {
+            static const unsigned char kPong[] = "pong\n";
+            err = mbedtls_ssl_write(&ssl, kPong, sizeof(kPong) - 1);
+        }
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    if (err < 0)
+        ERR_POST(Error << "TLS server error " << err);
+    mbedtls_ssl_free(&ssl);
+    delete sock;
+}
+
+
+void CTlsServer::Start(int n)
+{
+    m_Thread = thread([this, n]() {
+        for (int i = 0;  i < n;  ++i) {
+            CSocket* sock = 0;
+            if (m_Listener.Accept(sock, &kTimeout) != eIO_Success)
+                break;
+            x_Serve(sock);
+        }
+    });
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestTlsSessionApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    // Return the statistics of "n" sequential connections
+    SNcbiTlsSessionStats x_Run(mbedtls_ssl_protocol_version version, int n);
+};
+
+
+void CTestTlsSessionApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "TLS session resumption");
+    d->AddDefaultKey("connections", "N", "Connections per TLS version",
+                     CArgDescriptions::eInteger, "3");
+    SetupArgDescriptions(d.release());
+}
+
+
+SNcbiTlsSessionStats
+CTestTlsSessionApp::x_Run(mbedtls_ssl_protocol_version version, int n)
+{
+    CTlsServer server(version);
+    server.Start(n);
+    NcbiFlushTlsSessionCache();
+
+    for (int i = 0;  i < n;  ++i) {
+        CSocket sock("localhost", server.GetPort(), &kTimeout, fSOCK_Secure);
+        _VERIFY(sock.Write("ping\n", 5) == eIO_Success);
+        string reply;
+        _VERIFY(sock.ReadLine(reply) == eIO_Success);
+        _ASSERT(reply == "pong");
+        sock.Close();
+    }
+    server.Wait();
+
+    SNcbiTlsSessionStats stats;
+    NcbiGetTlsSessionStats(&stats);
+    NcbiCout << (version == MBEDTLS_SSL_VERSION_TLS1_3 ? "TLS1.3" : "TLS1.2")
+             << ": full="    << stats.full
+             << " resumed="  << stats.resumed
+             << " hits="     << stats.hits
+             << " misses="   << stats.misses
+             << " stores="   << stats.stores
+             << " entries="  << stats.entries << NcbiEndl;
+    return stats;
+}
+
+
+int CTestTlsSessionApp::Run(void)
+{
+    int n = GetArgs()["connections"].AsInteger();
+    _ASSERT(n > 0);
+
+    // Initialize the TLS provider (the server uses its RNG, PSA, and locks)
+    if (SOCK_SetupSSLEx(NcbiSetupTls) != eIO_Success
+        ||  NStr::CompareNocase(SOCK_SSLName(), "MBEDTLS") != 0) {
+        NcbiCout << "NCBI_UNITTEST_SKIPPED: mbedTLS is not available"
+                 << NcbiEndl;
+        return 0;
+    }
+
+    SNcbiTlsSessionStats stats;
+
+    stats = x_Run(MBEDTLS_SSL_VERSION_TLS1_2, n);
+    _ASSERT(stats.full    == 1);
+    _ASSERT(stats.resumed == (unsigned long)(n - 1));
+    _ASSERT(stats.hits    == (unsigned long)(n - 1));
+
+#ifdef MBEDTLS_SSL_PROTO_TLS1_3
+    stats = x_Run(MBEDTLS_SSL_VERSION_TLS1_3, n);
+    _ASSERT(stats.full    == 1);
+    _ASSERT(stats.resumed == (unsigned long)(n - 1));
+    _ASSERT(stats.hits    == (unsigned long)(n - 1));
+#endif /*MBEDTLS_SSL_PROTO_TLS1_3*/
+
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestTlsSessionApp().AppMain(argc, argv);
+}
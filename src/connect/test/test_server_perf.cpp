@@ -0,0 +1,320 @@
+/* $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   CServer loopback benchmark: request latency vs. number of idle
+ *   connections, for the poll and epoll main loops, and throughput of
+ *   concurrent clients with one or more epoll main loops
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbitime.hpp>
+#include <connect/ncbi_socket.hpp>
+#include <connect/server.hpp>
+
+#include "test_assert.h"  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Echo server
+
+class CEchoServer : public CServer
+{
+public:
+    CEchoServer(void) : m_Stop(false) { }
+
+    virtual bool ShutdownRequested(void) { return m_Stop; }
+    void RequestShutdown(void) { m_Stop = true; }
+
+private:
+    volatile bool m_Stop;
+};
+
+
+class CEchoHandler : public IServer_LineMessageHandler
+{
+public:
+    virtual void OnOpen(void)  { GetSocket().DisableOSSendDelay(); }
+    virtual void OnWrite(void) { }
+    virtual void OnMessage(BUF buf)
+    {
+        char   data[256];
+        size_t n = BUF_Read(buf, data, sizeof(data) - 1);
+        data[n++] = '\n';
+        GetSocket().Write(data, n);
+    }
+};
+
+
+class CEchoFactory : public IServer_ConnectionFactory
+{
+public:
+    virtual IServer_ConnectionHandler* Create(void)
+    {
+        return new CEchoHandler;
+    }
+};
+
+
+class CServerThread : public CThread
+{
+public:
+    CServerThread(CEchoServer& server) : m_Server(server) { }
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Server.Run();
+        return NULL;
+    }
+
+private:
+    CEchoServer& m_Server;
+};
+
+
+// Client doing round trips over its own connection
+class CClientThread : public CThread
+{
+public:
+    CClientThread(unsigned short port, int requests)
+        : m_Port(port), m_Requests(requests)
+    { }
+
+protected:
+    virtual void* Main(void)
+    {
+        static const char kRequest[] = "ping\n";
+        CSocket sock("127.0.0.1", m_Port);
+        sock.DisableOSSendDelay();
+        string reply;
+        for (int i = 0;  i < m_Requests;  ++i) {
+            _VERIFY(sock.Write(kRequest, sizeof(kRequest) - 1)
+                    == eIO_Success);
+            _VERIFY(sock.ReadLine(reply) == eIO_Success);
+            _ASSERT(reply == "ping");
+        }
+        return NULL;
+    }
+
+private:
+    unsigned short m_Port;
+    int            m_Requests;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestServerPerfApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    // Send one line and wait for the echo, return the latency in seconds.
+    double x_RoundTrip(CSocket& sock);
+};
+
+
+void CTestServerPerfApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "CServer request latency vs. number of idle "
+                       "connections");
+    d->AddDefaultKey("reactor", "Backend", "CServer main loop backend",
+                     CArgDescriptions::eString, "poll");
+    d->SetConstraint("reactor", &(*new CArgAllow_Strings, "poll", "epoll"));
+    d->AddDefaultKey("conns", "List",
+                     "Comma-separated numbers of idle connections "
+                     "(each takes two file descriptors)",
+                     CArgDescriptions::eString, "0,100,1000");
+    d->AddDefaultKey("requests", "N", "Round trips per measurement",
+                     CArgDescriptions::eInteger, "2000");
+    d->AddDefaultKey("threads", "N",
+                     "Number of epoll main loops ([server] Reactor_Threads)",
+                     CArgDescriptions::eInteger, "1");
+    d->AddFlag("inline",
+               "Process requests in the main loops ([server] Reactor_Inline)");
+    d->AddDefaultKey("clients", "K",
+                     "Concurrent clients for the throughput test "
+                     "(0 - skip it)",
+                     CArgDescriptions::eInteger, "0");
+    SetupArgDescriptions(d.release());
+}
+
+
+double CTestServerPerfApp::x_RoundTrip(CSocket& sock)
+{
+    static const char kRequest[] = "ping\n";
+    CStopWatch sw(CStopWatch::eStart);
+    _VERIFY(sock.Write(kRequest, sizeof(kRequest) - 1) == eIO_Success);
+    string reply;
+    _VERIFY(sock.ReadLine(reply) == eIO_Success);
+    _ASSERT(reply == "ping");
+    return sw.Elapsed();
+}
+
+
+int CTestServerPerfApp::Run(void)
+{
+    const CArgs& args     = GetArgs();
+    string       reactor  = args["reactor"].AsString();
+    int          requests = args["requests"].AsInteger();
+    vector<string> conns_list;
+    NStr::Split(args["conns"].AsString(), ",", conns_list,
+                NStr::fSplit_Tokenize);
+
+    int          clients  = args["clients"].AsInteger();
+
+    // Read by CServer::StartListening()
+    GetRWConfig().Set("server", "Reactor", reactor);
+    GetRWConfig().Set("server", "Reactor_Threads", args["threads"].AsString());
+    GetRWConfig().Set("server", "Reactor_Inline",
+                      args["inline"] ? "true" : "false");
+
+    unsigned short port = 4096;
+    {{
+        CListeningSocket listener;
+        while (++port & 0xFFFF) {
+            if (listener.Listen(port, 5, fSOCK_BindAny | fSOCK_LogOff)
+                == eIO_Success)
+                break;
+        }
+        if (port == 0) {
+            ERR_POST("Unable to find a free port to listen on");
+            return 2;
+        }
+    }}
+
+    static const STimeout kAcceptTimeout = { 0, 100000 };
+    static const STimeout kIdleTimeout   = { 3600, 0 };
+    SServer_Parameters params;
+    params.init_threads    = 2;
+    params.max_threads     = 4;
+    params.max_connections = 100000;
+    params.accept_timeout  = &kAcceptTimeout;
+    params.idle_timeout    = &kIdleTimeout;
+
+    CEchoServer server;
+    server.SetParameters(params);
+    server.AddListener(new CEchoFactory, port);
+    server.StartListening();
+    CRef<CServerThread> thread(new CServerThread(server));
+    thread->Run();
+
+    CSocket active("127.0.0.1", port);
+    active.DisableOSSendDelay();
+    x_RoundTrip(active);
+
+    vector< unique_ptr<CSocket> > idle;
+    NcbiCout << "reactor     conns      avg,us      p50,us      p99,us"
+             << NcbiEndl;
+    ITERATE(vector<string>, it, conns_list) {
+        size_t n_conns = NStr::StringToSizet(*it);
+        while (idle.size() < n_conns) {
+            unique_ptr<CSocket> sock(new CSocket("127.0.0.1", port));
+            if (sock->GetStatus(eIO_Open) != eIO_Success) {
+                ERR_POST(Warning << "Cannot open more than " << idle.size()
+                         << " connections");
+                break;
+            }
+            // Make sure the connection has been accepted and is idle
+            x_RoundTrip(*sock);
+            idle.push_back(move(sock));
+        }
+
+        vector<double> latency;
+        latency.reserve(requests);
+        for (int i = 0;  i < requests;  ++i) {
+            latency.push_back(x_RoundTrip(active));
+        }
+        sort(latency.begin(), latency.end());
+        double sum = 0.0;
+        ITERATE(vector<double>, l, latency) {
+            sum += *l;
+        }
+        NcbiCout << setw(7) << left << reactor << right
+                 << setw(10) << idle.size() << fixed << setprecision(1)
+                 << setw(12) << sum / latency.size() * 1e6
+                 << setw(12) << latency[latency.size() / 2] * 1e6
+                 << setw(12) << latency[latency.size() * 99 / 100] * 1e6
+                 << NcbiEndl;
+    }
+
+    if (clients > 0) {
+        vector< CRef<CThread> > threads;
+        CStopWatch sw(CStopWatch::eStart);
+        for (int i = 0;  i < clients;  ++i) {
+            threads.push_back(CRef<CThread>(
+                new CClientThread(port, requests)));
+            threads.back()->Run();
+        }
+        NON_CONST_ITERATE(vector< CRef<CThread> >, it, threads) {
+            (*it)->Join();
+        }
+        double elapsed = sw.Elapsed();
+        NcbiCout << "clients " << clients << ": " << fixed << setprecision(0)
+                 << clients * requests / elapsed << " requests/s"
+                 << NcbiEndl;
+    }
+
+    vector<SServer_ReactorStats> stats;
+    server.GetReactorStats(&stats);
+    ITERATE(vector<SServer_ReactorStats>, it, stats) {
+        NcbiCout << "reactor " << it->index
+                 << ": connections=" << it->connections
+                 << " iterations=" << it->iterations
+                 << " events=" << it->events
+                 << " accepts=" << it->accepts
+                 << " requests=" << it->requests << NcbiEndl;
+    }
+
+    server.RequestShutdown();
+    thread->Join();
+    active.Close();
+    idle.clear();
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestServerPerfApp().AppMain(argc, argv);
+}
@@ -228,6 +228,17 @@ CMetaRegistry::x_Load(const string& name, CMetaRegistry::ENameStyle style,
         scratch_entry.registry.Reset();
         return scratch_entry;
     } else if (flags & fPrivate) {
+        // Remember the file (but not the registry, owned by the caller)
+        CMutexGuard PRIVATE_GUARD(m_Mutex);
+        SEntry file_entry(scratch_entry);
+        file_entry.registry.Reset();
+        NON_CONST_ITERATE (vector<SEntry>, it, m_PrivateFiles) {
+            if (it->actual_name == file_entry.actual_name) {
+                *it = file_entry;
+                return scratch_entry;
+            }
+        }
+        m_PrivateFiles.push_back(file_entry);
         return scratch_entry;
     } else {
         m_Contents.push_back(scratch_entry);
@@ -326,6 +337,16 @@ bool CMetaRegistry::x_Reload(const string& path, IRWRegistry& reg,
 }
 
 
+void CMetaRegistry::GetLoadedEntries(vector<SEntry>& entries)
+{
+    CMetaRegistry& instance = Instance();
+    CMutexGuard GUARD(instance.m_Mutex);
+    entries = instance.m_Contents;
+    entries.insert(entries.end(), instance.m_PrivateFiles.begin(),
+                   instance.m_PrivateFiles.end());
+}
+
+
 void CMetaRegistry::GetDefaultSearchPath(CMetaRegistry::TSearchPath& path)
 {
     path.clear();
@@ -0,0 +1,894 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Asynchronous file I/O
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_file_aio.hpp>
+#include <corelib/ncbi_param.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/error_codes.hpp>
+#include <deque>
+
+#if defined(NCBI_OS_UNIX)
+#  include <errno.h>
+#  include <unistd.h>
+#endif
+
+#if defined(NCBI_OS_LINUX)  &&  defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#    if defined(__NR_io_uring_setup)  &&  defined(__NR_io_uring_enter)
+#      define NCBI_HAVE_IO_URING 1
+#    endif
+#  endif
+#endif
+
+
+#define NCBI_USE_ERRCODE_X   Corelib_File
+
+
+BEGIN_NCBI_SCOPE
+
+
+NCBI_PARAM_ENUM_DECL(CFileAsyncIO::EBackend, FileAsyncIO, Backend);
+NCBI_PARAM_ENUM_ARRAY(CFileAsyncIO::EBackend, FileAsyncIO, Backend)
+{
+    {"Default",    CFileAsyncIO::eDefault},
+    {"ThreadPool", CFileAsyncIO::eThreadPool},
+    {"URing",      CFileAsyncIO::eURing}
+};
+NCBI_PARAM_ENUM_DEF_EX(CFileAsyncIO::EBackend, FileAsyncIO, Backend,
+                       CFileAsyncIO::eDefault,
+                       eParam_NoThread, NCBI_FILEASYNCIO_BACKEND);
+
+NCBI_PARAM_DECL(unsigned int, FileAsyncIO, QueueDepth);
+NCBI_PARAM_DEF_EX(unsigned int, FileAsyncIO, QueueDepth, 128,
+                  eParam_NoThread, NCBI_FILEASYNCIO_QUEUEDEPTH);
+
+NCBI_PARAM_DECL(unsigned int, FileAsyncIO, Threads);
+NCBI_PARAM_DEF_EX(unsigned int, FileAsyncIO, Threads, 4,
+                  eParam_NoThread, NCBI_FILEASYNCIO_THREADS);
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CFileAsyncIOBackend
+//
+
+class CFileAsyncIOBackend
+{
+public:
+    CFileAsyncIOBackend(CFileAsyncIO& owner) : m_Owner(owner) {}
+    virtual ~CFileAsyncIOBackend(void) {}
+
+    // Start requests; the caller guarantees that the number of requests
+    // in flight does not exceed the queue depth. Return the number of
+    // started requests, only those will be completed; if it is less than
+    // count, errno is set.
+    virtual size_t Submit(const CFileAsyncIO::SRequest* requests,
+                          size_t count) = 0;
+
+protected:
+    void Complete(const CFileAsyncIO::SRequest& request, Int8 result)
+    {
+        m_Owner.x_Complete(request, result);
+    }
+
+private:
+    CFileAsyncIO& m_Owner;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Thread pool backend
+//
+
+// Perform the request synchronously.
+static Int8 s_DoIO(const CFileAsyncIO::SRequest& request)
+{
+#if defined(NCBI_OS_MSWIN)
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset     = DWORD(request.offset & 0xFFFFFFFF);
+    ov.OffsetHigh = DWORD(request.offset >> 32);
+    DWORD size = DWORD(min(request.size, size_t(kMax_UI4)));
+    DWORD n = 0;
+    BOOL ok = request.op == CFileAsyncIO::eRead
+        ? ::ReadFile (request.handle, request.buffer, size, &n, &ov)
+        : ::WriteFile(request.handle, request.buffer, size, &n, &ov);
+    if ( !ok ) {
+        DWORD err = ::GetLastError();
+        if (err == ERROR_IO_PENDING) {
+            // Handle opened for overlapped I/O
+            ok = ::GetOverlappedResult(request.handle, &ov, &n, TRUE);
+            err = ok ? 0 : ::GetLastError();
+        }
+        if (err == ERROR_HANDLE_EOF) {
+            return 0;
+        }
+        if ( !ok ) {
+            CNcbiError::SetWindowsError(err);
+            return -EIO;
+        }
+    }
+    return n;
+#else
+    for (;;) {
+        ssize_t n = request.op == CFileAsyncIO::eRead
+            ? ::pread (request.handle, request.buffer, request.size,
+                       off_t(request.offset))
+            : ::pwrite(request.handle, request.buffer, request.size,
+                       off_t(request.offset));
+        if (n >= 0) {
+            return n;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+#endif
+}
+
+
+class CFileAIOPoolThread;
+
+class CFileAIOThreadPool : public CFileAsyncIOBackend
+{
+public:
+    CFileAIOThreadPool(CFileAsyncIO& owner, unsigned int threads);
+    virtual ~CFileAIOThreadPool(void);
+
+    virtual size_t Submit(const CFileAsyncIO::SRequest* requests,
+                          size_t count);
+
+    // Thread main loop
+    void Run(void);
+
+private:
+    CFastMutex                       m_Mutex;
+    CConditionVariable               m_Cond;
+    deque<CFileAsyncIO::SRequest>    m_Queue;
+    bool                             m_Stop;
+    vector< CRef<CThread> >          m_Threads;
+};
+
+
+class CFileAIOPoolThread : public CThread
+{
+public:
+    CFileAIOPoolThread(CFileAIOThreadPool& pool) : m_Pool(pool) {}
+protected:
+    virtual void* Main(void)
+    {
+        m_Pool.Run();
+        return NULL;
+    }
+private:
+    CFileAIOThreadPool& m_Pool;
+};
+
+
+CFileAIOThreadPool::CFileAIOThreadPool(CFileAsyncIO& owner,
+                                       unsigned int  threads)
+    : CFileAsyncIOBackend(owner),
+      m_Stop(false)
+{
+    for (unsigned int i = 0;  i < max(threads, 1U);  ++i) {
+        CRef<CThread> thr(new CFileAIOPoolThread(*this));
+        thr->Run();
+        m_Threads.push_back(thr);
+    }
+}
+
+
+CFileAIOThreadPool::~CFileAIOThreadPool(void)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Stop = true;
+    }}
+    m_Cond.SignalAll();
+    for (auto& thr : m_Threads) {
+        thr->Join();
+    }
+}
+
+
+size_t CFileAIOThreadPool::Submit(const CFileAsyncIO::SRequest* requests,
+                                  size_t count)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Queue.insert(m_Queue.end(), requests, requests + count);
+    }}
+    if (count == 1) {
+        m_Cond.SignalSome();
+    } else {
+        m_Cond.SignalAll();
+    }
+    return count;
+}
+
+
+void CFileAIOThreadPool::Run(void)
+{
+    for (;;) {
+        CFileAsyncIO::SRequest request;
+        {{
+            CFastMutexGuard guard(m_Mutex);
+            while (m_Queue.empty()  &&  !m_Stop) {
+                m_Cond.WaitForSignal(m_Mutex);
+            }
+            if (m_Queue.empty()) {
+                return;
+            }
+            request = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }}
+        Complete(request, s_DoIO(request));
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// io_uring backend
+//
+
+#if defined(NCBI_HAVE_IO_URING)
+
+static int s_URingSetup(unsigned int entries, struct io_uring_params* params)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int s_URingEnter(int fd, unsigned int to_submit,
+                        unsigned int min_complete, unsigned int flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                         flags, NULL, 0));
+}
+
+
+class CFileAIOURingThread;
+
+class CFileAIOURing : public CFileAsyncIOBackend
+{
+public:
+    CFileAIOURing(CFileAsyncIO& owner, unsigned int queue_depth);
+    virtual ~CFileAIOURing(void);
+
+    virtual size_t Submit(const CFileAsyncIO::SRequest* requests,
+                          size_t count);
+
+    // Completion thread main loop
+    void Run(void);
+
+private:
+    // Request in flight
+    struct SSlot {
+        CFileAsyncIO::SRequest request;
+        struct iovec           iov;
+        bool                   in_flight;
+    };
+
+    void x_Unmap(void);
+    void x_Push(Uint8 user_data, const SSlot* slot);
+    unsigned int x_Enter(unsigned int to_submit);
+    SSlot* x_GetSlot(void);
+    void x_ReleaseSlot(SSlot* slot);
+    void x_Fail(int error);
+
+    int                   m_Fd;
+    void*                 m_SQRing;
+    size_t                m_SQRingSize;
+    void*                 m_CQRing;
+    size_t                m_CQRingSize;
+    struct io_uring_sqe*  m_SQEs;
+    size_t                m_SQEsSize;
+
+    // Submission queue
+    unsigned int*         m_SQHead;
+    unsigned int*         m_SQTail;
+    unsigned int          m_SQMask;
+    unsigned int*         m_SQArray;
+    // Completion queue
+    unsigned int*         m_CQHead;
+    unsigned int*         m_CQTail;
+    unsigned int          m_CQMask;
+    struct io_uring_cqe*  m_CQEs;
+
+    CFastMutex            m_SubmitMutex;
+    // Set by the completion thread when the ring is no longer usable
+    int                   m_Error;
+    CRef<CThread>         m_Thread;
+
+    // One slot per request in flight, allocated once
+    vector<SSlot>         m_Slots;
+    vector<SSlot*>        m_FreeSlots;
+    CFastMutex            m_SlotsMutex;
+    // Slots of the batch being submitted, guarded by m_SubmitMutex
+    vector<SSlot*>        m_Batch;
+};
+
+
+class CFileAIOURingThread : public CThread
+{
+public:
+    CFileAIOURingThread(CFileAIOURing& ring) : m_Ring(ring) {}
+protected:
+    virtual void* Main(void)
+    {
+        m_Ring.Run();
+        return NULL;
+    }
+private:
+    CFileAIOURing& m_Ring;
+};
+
+
+template<class T>
+static inline T* s_RingPtr(void* base, unsigned int offset)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+
+CFileAIOURing::CFileAIOURing(CFileAsyncIO& owner, unsigned int queue_depth)
+    : CFileAsyncIOBackend(owner),
+      m_Fd(-1),
+      m_SQRing(MAP_FAILED), m_SQRingSize(0),
+      m_CQRing(MAP_FAILED), m_CQRingSize(0),
+      m_SQEs(static_cast<struct io_uring_sqe*>(MAP_FAILED)), m_SQEsSize(0),
+      m_Error(0),
+      m_Slots(queue_depth)
+{
+    m_FreeSlots.reserve(queue_depth);
+    m_Batch.reserve(queue_depth);
+    for (auto& slot : m_Slots) {
+        slot.in_flight = false;
+        m_FreeSlots.push_back(&slot);
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_Fd = s_URingSetup(queue_depth, &params);
+    if (m_Fd < 0) {
+        NCBI_THROW(CFileErrnoException, eFileIO, "io_uring_setup() failed");
+    }
+    m_SQRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    m_CQRingSize = params.cq_off.cqes
+        + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        m_SQRingSize = m_CQRingSize = max(m_SQRingSize, m_CQRingSize);
+    }
+    m_SQRing = ::mmap(NULL, m_SQRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+    if (m_SQRing != MAP_FAILED) {
+        m_CQRing = single_mmap ? m_SQRing :
+            ::mmap(NULL, m_CQRingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+    }
+    if (m_CQRing != MAP_FAILED) {
+        m_SQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        m_SQEs = static_cast<struct io_uring_sqe*>(
+            ::mmap(NULL, m_SQEsSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES));
+    }
+    if (m_SQEs == MAP_FAILED) {
+        int x_errno = errno;
+        x_Unmap();
+        errno = x_errno;
+        NCBI_THROW(CFileErrnoException, eFileIO, "Cannot map io_uring queues");
+    }
+    m_SQHead  = s_RingPtr<unsigned int>(m_SQRing, params.sq_off.head);
+    m_SQTail  = s_RingPtr<unsigned int>(m_SQRing, params.sq_off.tail);
+    m_SQMask  = *s_RingPtr<unsigned int>(m_SQRing, params.sq_off.ring_mask);
+    m_SQArray = s_RingPtr<unsigned int>(m_SQRing, params.sq_off.array);
+    m_CQHead  = s_RingPtr<unsigned int>(m_CQRing, params.cq_off.head);
+    m_CQTail  = s_RingPtr<unsigned int>(m_CQRing, params.cq_off.tail);
+    m_CQMask  = *s_RingPtr<unsigned int>(m_CQRing, params.cq_off.ring_mask);
+    m_CQEs    = s_RingPtr<struct io_uring_cqe>(m_CQRing, params.cq_off.cqes);
+
+    try {
+        m_Thread.Reset(new CFileAIOURingThread(*this));
+        m_Thread->Run();
+    }
+    catch (...) {
+        m_Thread.Reset();
+        x_Unmap();
+        throw;
+    }
+}
+
+
+CFileAIOURing::~CFileAIOURing(void)
+{
+    // All requests are completed at this point, wake up the completion
+    // thread with a no-op request to let it finish, unless it has already
+    // stopped on error.
+    {{
+        CFastMutexGuard guard(m_SubmitMutex);
+        if ( !m_Error ) {
+            x_Push(0, NULL);
+            if ( !x_Enter(1) ) {
+                // The thread cannot be woken up, leave it with the ring
+                ERR_POST_X(107, Critical << "io_uring_enter() failed: "
+                           << NcbiSys_strerror(errno));
+                m_Thread->Detach();
+                return;
+            }
+        }
+    }}
+    m_Thread->Join();
+    x_Unmap();
+}
+
+
+void CFileAIOURing::x_Unmap(void)
+{
+    if (m_SQEs != MAP_FAILED) {
+        ::munmap(m_SQEs, m_SQEsSize);
+    }
+    if (m_CQRing != MAP_FAILED  &&  m_CQRing != m_SQRing) {
+        ::munmap(m_CQRing, m_CQRingSize);
+    }
+    if (m_SQRing != MAP_FAILED) {
+        ::munmap(m_SQRing, m_SQRingSize);
+    }
+    if (m_Fd >= 0) {
+        ::close(m_Fd);
+    }
+}
+
+
+// Add a request to the submission queue, must be called under
+// m_SubmitMutex. The queue cannot overflow: the owner limits the number
+// of requests in flight by the queue depth, and all queued entries are
+// consumed by io_uring_enter() before the mutex is released.
+void CFileAIOURing::x_Push(Uint8 user_data, const SSlot* slot)
+{
+    unsigned int tail = *m_SQTail;
+    unsigned int index = tail & m_SQMask;
+    struct io_uring_sqe* sqe = &m_SQEs[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if (slot) {
+        const CFileAsyncIO::SRequest& request = slot->request;
+        sqe->opcode = request.op == CFileAsyncIO::eRead
+            ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->fd     = request.handle;
+        sqe->off    = request.offset;
+        sqe->addr   = reinterpret_cast<Uint8>(&slot->iov);
+        sqe->len    = 1;
+    } else {
+        sqe->opcode = IORING_OP_NOP;
+    }
+    sqe->user_data = user_data;
+    m_SQArray[index] = index;
+    __atomic_store_n(m_SQTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+
+// Return the number of entries consumed by the kernel, which is less
+// than to_submit only on error (errno is set then).
+unsigned int CFileAIOURing::x_Enter(unsigned int to_submit)
+{
+    unsigned int submitted = 0;
+    while (submitted < to_submit) {
+        int n = s_URingEnter(m_Fd, to_submit - submitted, 0, 0);
+        if (n < 0) {
+            if (errno == EINTR  ||  errno == EAGAIN  ||  errno == EBUSY) {
+                continue;
+            }
+            break;
+        }
+        submitted += unsigned(n);
+    }
+    return submitted;
+}
+
+
+CFileAIOURing::SSlot* CFileAIOURing::x_GetSlot(void)
+{
+    CFastMutexGuard guard(m_SlotsMutex);
+    // Cannot be empty: the owner limits the number of requests in flight
+    SSlot* slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+    slot->in_flight = true;
+    return slot;
+}
+
+
+void CFileAIOURing::x_ReleaseSlot(SSlot* slot)
+{
+    slot->request.callback = nullptr;
+    CFastMutexGuard guard(m_SlotsMutex);
+    slot->in_flight = false;
+    m_FreeSlots.push_back(slot);
+}
+
+
+size_t CFileAIOURing::Submit(const CFileAsyncIO::SRequest* requests,
+                             size_t count)
+{
+    CFastMutexGuard guard(m_SubmitMutex);
+    if (m_Error) {
+        errno = m_Error;
+        return 0;
+    }
+    m_Batch.clear();
+    for (size_t i = 0;  i < count;  ++i) {
+        SSlot* slot = x_GetSlot();
+        m_Batch.push_back(slot);
+        slot->request = requests[i];
+        slot->iov.iov_base = slot->request.buffer;
+        slot->iov.iov_len  = slot->request.size;
+        x_Push(reinterpret_cast<Uint8>(slot), slot);
+    }
+    unsigned int submitted = x_Enter(unsigned(count));
+    if (submitted < count) {
+        int x_errno = errno;
+        // The kernel has not seen the rest of the entries yet (there is
+        // no SQ polling thread), take them back.
+        __atomic_store_n(m_SQTail, *m_SQTail - unsigned(count - submitted),
+                         __ATOMIC_RELEASE);
+        for (size_t i = submitted;  i < count;  ++i) {
+            x_ReleaseSlot(m_Batch[i]);
+        }
+        errno = x_errno;
+    }
+    return submitted;
+}
+
+
+// Called by the completion thread when it cannot wait for completions
+// anymore: fail all requests in flight and refuse new ones.
+void CFileAIOURing::x_Fail(int error)
+{
+    ERR_POST_X(107, Critical << "io_uring_enter() failed: "
+               << NcbiSys_strerror(error));
+    vector<SSlot*> lost;
+    {{
+        CFastMutexGuard guard(m_SubmitMutex);
+        m_Error = error;
+        CFastMutexGuard slots_guard(m_SlotsMutex);
+        for (auto& slot : m_Slots) {
+            if (slot.in_flight) {
+                lost.push_back(&slot);
+            }
+        }
+    }}
+    for (SSlot* slot : lost) {
+        CFileAsyncIO::SRequest request = std::move(slot->request);
+        x_ReleaseSlot(slot);
+        Complete(request, -error);
+    }
+}
+
+
+void CFileAIOURing::Run(void)
+{
+    for (;;) {
+        unsigned int head = *m_CQHead;
+        unsigned int tail = __atomic_load_n(m_CQTail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            int n = s_URingEnter(m_Fd, 0, 1, IORING_ENTER_GETEVENTS);
+            if (n < 0  &&  errno != EINTR  &&  errno != EAGAIN
+                &&  errno != EBUSY) {
+                x_Fail(errno);
+                return;
+            }
+            continue;
+        }
+        bool stop = false;
+        for ( ;  head != tail;  ++head) {
+            const struct io_uring_cqe& cqe = m_CQEs[head & m_CQMask];
+            SSlot* slot = reinterpret_cast<SSlot*>(cqe.user_data);
+            Int8 result = cqe.res;
+            // Release the entry before the callback, it may take a while
+            __atomic_store_n(m_CQHead, head + 1, __ATOMIC_RELEASE);
+            if ( !slot ) {
+                stop = true;
+                continue;
+            }
+            // Free the slot first, the owner may submit more requests as
+            // soon as this one is completed
+            CFileAsyncIO::SRequest request = std::move(slot->request);
+            x_ReleaseSlot(slot);
+            Complete(request, result);
+        }
+        if (stop) {
+            return;
+        }
+    }
+}
+
+#endif  /* NCBI_HAVE_IO_URING */
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CFileAsyncIO
+//
+
+bool CFileAsyncIO::IsURingAvailable(void)
+{
+#if defined(NCBI_HAVE_IO_URING)
+    static int s_Available = -1;
+    if (s_Available < 0) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = s_URingSetup(1, &params);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        s_Available = fd >= 0;
+    }
+    return s_Available > 0;
+#else
+    return false;
+#endif
+}
+
+
+CFileAsyncIO::CFileAsyncIO(EBackend     backend,
+                           unsigned int queue_depth,
+                           unsigned int threads)
+    : m_Backend(backend),
+      m_QueueDepth(queue_depth),
+      m_Pending(0),
+      m_InFlight(0)
+{
+    if (m_Backend == eDefault) {
+        m_Backend = NCBI_PARAM_TYPE(FileAsyncIO, Backend)::GetDefault();
+    }
+    if ( !m_QueueDepth ) {
+        m_QueueDepth = NCBI_PARAM_TYPE(FileAsyncIO, QueueDepth)::GetDefault();
+    }
+    m_QueueDepth = max(m_QueueDepth, 1U);
+    if ( !threads ) {
+        threads = NCBI_PARAM_TYPE(FileAsyncIO, Threads)::GetDefault();
+    }
+#if defined(NCBI_HAVE_IO_URING)
+    if (m_Backend != eThreadPool  &&  IsURingAvailable()) {
+        try {
+            m_Impl.reset(new CFileAIOURing(*this, m_QueueDepth));
+            m_Backend = eURing;
+        }
+        catch (CException& e) {
+            ERR_POST_X(108, Warning << "Cannot use io_uring for file I/O, "
+                       "falling back to thread pool: " << e.GetMsg());
+        }
+    }
+#endif
+    if ( !m_Impl ) {
+        m_Impl.reset(new CFileAIOThreadPool(*this, threads));
+        m_Backend = eThreadPool;
+    }
+}
+
+
+CFileAsyncIO::~CFileAsyncIO(void)
+{
+    WaitAll();
+    m_Impl.reset();
+}
+
+
+// Queue whose completion callback is being run by the current thread
+static thread_local const CFileAsyncIO* s_CallbackOwner = NULL;
+
+
+void CFileAsyncIO::Submit(const SRequest* requests, size_t count)
+{
+    if (s_CallbackOwner == this) {
+        // Waiting for a free place in the queue here could block the very
+        // thread that has to complete the requests, so defer what does
+        // not fit; completions will start it.
+        {{
+            CFastMutexGuard guard(m_PendingMutex);
+            m_Deferred.insert(m_Deferred.end(), requests, requests + count);
+            m_Pending += count;
+        }}
+        x_StartDeferred();
+        return;
+    }
+    while (count) {
+        size_t n = min(count, size_t(m_QueueDepth));
+        {{
+            CFastMutexGuard guard(m_PendingMutex);
+            while (m_InFlight + n > m_QueueDepth) {
+                m_PendingCond.WaitForSignal(m_PendingMutex);
+            }
+            m_InFlight += n;
+            m_Pending  += n;
+        }}
+        size_t started = 0;
+        try {
+            started = m_Impl->Submit(requests, n);
+        }
+        catch (...) {
+            CFastMutexGuard guard(m_PendingMutex);
+            m_InFlight -= n;
+            m_Pending  -= n;
+            m_PendingCond.SignalAll();
+            throw;
+        }
+        if (started < n) {
+            int x_errno = errno;
+            {{
+                CFastMutexGuard guard(m_PendingMutex);
+                m_InFlight -= n - started;
+                m_Pending  -= n - started;
+            }}
+            m_PendingCond.SignalAll();
+            errno = x_errno;
+            NCBI_THROW(CFileErrnoException, eFileIO,
+                       "Cannot start file I/O requests, "
+                       + NStr::SizetToString(started) + " of "
+                       + NStr::SizetToString(n) + " started");
+        }
+        requests += n;
+        count -= n;
+    }
+}
+
+
+// Start as many deferred requests as the queue depth allows. There is no
+// caller to report a failure to, so the requests that cannot be started
+// are completed with an error.
+void CFileAsyncIO::x_StartDeferred(void)
+{
+    for (;;) {
+        vector<SRequest> batch;
+        {{
+            CFastMutexGuard guard(m_PendingMutex);
+            while ( !m_Deferred.empty()  &&  m_InFlight < m_QueueDepth ) {
+                batch.push_back(std::move(m_Deferred.front()));
+                m_Deferred.pop_front();
+                ++m_InFlight;
+            }
+        }}
+        if (batch.empty()) {
+            return;
+        }
+        size_t started = 0;
+        int x_errno = 0;
+        try {
+            started = m_Impl->Submit(batch.data(), batch.size());
+            x_errno = errno;
+        }
+        catch (...) {
+            x_errno = ENOMEM;
+        }
+        if (started == batch.size()) {
+            continue;
+        }
+        {{
+            CFastMutexGuard guard(m_PendingMutex);
+            m_InFlight -= batch.size() - started;
+        }}
+        for (size_t i = started;  i < batch.size();  ++i) {
+            x_Finish(batch[i], -Int8(x_errno ? x_errno : EIO));
+        }
+    }
+}
+
+
+void CFileAsyncIO::x_Complete(const SRequest& request, Int8 result)
+{
+    {{
+        CFastMutexGuard guard(m_PendingMutex);
+        --m_InFlight;
+    }}
+    x_StartDeferred();
+    x_Finish(request, result);
+}
+
+
+void CFileAsyncIO::x_Finish(const SRequest& request, Int8 result)
+{
+    if (request.callback) {
+        const CFileAsyncIO* owner = s_CallbackOwner;
+        s_CallbackOwner = this;
+        try {
+            request.callback(request, result);
+        }
+        NCBI_CATCH_ALL_X(109, "Exception in file I/O completion callback");
+        s_CallbackOwner = owner;
+    }
+    {{
+        CFastMutexGuard guard(m_PendingMutex);
+        --m_Pending;
+    }}
+    m_PendingCond.SignalAll();
+}
+
+
+future<Int8> CFileAsyncIO::x_SubmitOne(EOperation op, TFileHandle handle,
+                                       void* buffer, size_t size,
+                                       Uint8 offset)
+{
+    shared_ptr< promise<Int8> > result = make_shared< promise<Int8> >();
+    SRequest request;
+    request.op       = op;
+    request.handle   = handle;
+    request.buffer   = buffer;
+    request.size     = size;
+    request.offset   = offset;
+    request.callback = [result](const SRequest&, Int8 res) {
+        result->set_value(res);
+    };
+    future<Int8> ret = result->get_future();
+    Submit(request);
+    return ret;
+}
+
+
+future<Int8> CFileAsyncIO::Read(TFileHandle handle, void* buffer,
+                                size_t size, Uint8 offset)
+{
+    return x_SubmitOne(eRead, handle, buffer, size, offset);
+}
+
+
+future<Int8> CFileAsyncIO::Write(TFileHandle handle, const void* buffer,
+                                 size_t size, Uint8 offset)
+{
+    return x_SubmitOne(eWrite, handle, const_cast<void*>(buffer), size,
+                       offset);
+}
+
+
+void CFileAsyncIO::WaitAll(void)
+{
+    // Would wait for the callback that is calling it
+    _ASSERT(s_CallbackOwner != this);
+    CFastMutexGuard guard(m_PendingMutex);
+    while (m_Pending) {
+        m_PendingCond.WaitForSignal(m_PendingMutex);
+    }
+}
+
+
+size_t CFileAsyncIO::GetPending(void) const
+{
+    CFastMutexGuard guard(m_PendingMutex);
+    return m_Pending;
+}
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,473 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   In-process metrics registry
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_metrics.hpp>
+#include <corelib/ncbi_safe_static.hpp>
+#include <corelib/ncbistr.hpp>
+#include <corelib/ncbiexpt.hpp>
+
+
+BEGIN_NCBI_SCOPE
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CMetricCounter
+//
+
+CMetricCounter::CMetricCounter(void)
+{
+    Reset();
+}
+
+
+unsigned int CMetricCounter::x_GetShardIndex(void)
+{
+    static atomic<unsigned int> s_NextShard(0);
+    thread_local unsigned int s_Shard = s_NextShard++ % kShards;
+    return s_Shard;
+}
+
+
+Uint8 CMetricCounter::GetValue(void) const
+{
+    Uint8 ret = 0;
+    for (size_t i = 0; i < kShards; ++i) {
+        ret += m_Shards[i].m_Value.load(memory_order_relaxed);
+    }
+    return ret;
+}
+
+
+void CMetricCounter::Reset(void)
+{
+    for (size_t i = 0; i < kShards; ++i) {
+        m_Shards[i].m_Value.store(0, memory_order_relaxed);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CMetricHistogram
+//
+
+CMetricHistogram::CMetricHistogram(double unit)
+    : m_Unit(unit), m_Count(0), m_Sum(0)
+{
+    for (size_t i = 0; i < kBuckets; ++i) {
+        m_Buckets[i].store(0, memory_order_relaxed);
+    }
+}
+
+
+Uint8 CMetricHistogram::GetBucketLowerBound(size_t index)
+{
+    if (index < kSubBuckets) {
+        return Uint8(index);
+    }
+    unsigned int shift = unsigned(index / kSubBuckets) - 1;
+    return Uint8(kSubBuckets + index % kSubBuckets) << shift;
+}
+
+
+Uint8 CMetricHistogram::GetBucketUpperBound(size_t index)
+{
+    if (index < kSubBuckets) {
+        return Uint8(index);
+    }
+    unsigned int shift = unsigned(index / kSubBuckets) - 1;
+    return GetBucketLowerBound(index) + ((Uint8(1) << shift) - 1);
+}
+
+
+CMetricHistogram::CSnapshot CMetricHistogram::GetSnapshot(void) const
+{
+    CSnapshot snap(m_Unit);
+    for (size_t i = 0; i < kBuckets; ++i) {
+        snap.m_Buckets[i] = m_Buckets[i].load(memory_order_relaxed);
+    }
+    snap.m_Count = m_Count.load(memory_order_relaxed);
+    snap.m_Sum = m_Sum.load(memory_order_relaxed);
+    return snap;
+}
+
+
+CMetricHistogram::CSnapshot::CSnapshot(double unit)
+    : m_Unit(unit), m_Count(0), m_Sum(0), m_Buckets(kBuckets, 0)
+{
+}
+
+
+void CMetricHistogram::CSnapshot::Merge(const CSnapshot& other)
+{
+    if (m_Unit != other.m_Unit) {
+        NCBI_THROW(CCoreException, eInvalidArg,
+            "Cannot merge histograms with different units");
+    }
+    for (size_t i = 0; i < kBuckets; ++i) {
+        m_Buckets[i] += other.m_Buckets[i];
+    }
+    m_Count += other.m_Count;
+    m_Sum += other.m_Sum;
+}
+
+
+Uint8 CMetricHistogram::CSnapshot::GetQuantile(double quantile) const
+{
+    // Use the sum of buckets rather than m_Count - the snapshot is
+    // not atomic and they may differ slightly.
+    Uint8 total = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        total += m_Buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    if (quantile < 0) quantile = 0;
+    if (quantile > 1) quantile = 1;
+    Uint8 rank = Uint8(quantile * double(total) + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    Uint8 seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += m_Buckets[i];
+        if (seen >= rank) {
+            return GetBucketUpperBound(i);
+        }
+    }
+    return GetBucketUpperBound(kBuckets - 1);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CMetricsSnapshot
+//
+
+static bool s_SameMetric(const CMetricsSnapshot::SEntry& entry,
+                         const string&                   name,
+                         const TMetricLabels&            labels)
+{
+    return entry.m_Name == name  &&  entry.m_Labels == labels;
+}
+
+
+const CMetricsSnapshot::SEntry*
+CMetricsSnapshot::Find(const string& name, const TMetricLabels& labels) const
+{
+    ITERATE(TEntries, it, m_Entries) {
+        if ( s_SameMetric(*it, name, labels) ) {
+            return &*it;
+        }
+    }
+    return NULL;
+}
+
+
+void CMetricsSnapshot::Merge(const CMetricsSnapshot& other)
+{
+    ITERATE(TEntries, it, other.m_Entries) {
+        SEntry* entry = const_cast<SEntry*>(Find(it->m_Name, it->m_Labels));
+        if ( !entry ) {
+            m_Entries.push_back(*it);
+            continue;
+        }
+        if (entry->m_Type != it->m_Type) {
+            NCBI_THROW(CCoreException, eInvalidArg,
+                "Cannot merge metrics of different types: " + it->m_Name);
+        }
+        if (entry->m_Type == eHistogram) {
+            entry->m_Histogram.Merge(it->m_Histogram);
+        }
+        else {
+            entry->m_Value += it->m_Value;
+        }
+    }
+}
+
+
+static string s_EscapeLabelValue(const string& value)
+{
+    string ret;
+    ret.reserve(value.size());
+    ITERATE(string, c, value) {
+        switch (*c) {
+        case '\\':  ret += "\\\\";  break;
+        case '"':   ret += "\\\"";  break;
+        case '\n':  ret += "\\n";   break;
+        default:    ret += *c;      break;
+        }
+    }
+    return ret;
+}
+
+
+static string s_FormatLabels(const TMetricLabels& labels,
+                             const string&        extra_name  = kEmptyStr,
+                             const string&        extra_value = kEmptyStr)
+{
+    if (labels.empty()  &&  extra_name.empty()) {
+        return kEmptyStr;
+    }
+    string ret = "{";
+    ITERATE(TMetricLabels, it, labels) {
+        if (ret.size() > 1) {
+            ret += ',';
+        }
+        ret += it->first + "=\"" + s_EscapeLabelValue(it->second) + '"';
+    }
+    if ( !extra_name.empty() ) {
+        if (ret.size() > 1) {
+            ret += ',';
+        }
+        ret += extra_name + "=\"" + extra_value + '"';
+    }
+    ret += '}';
+    return ret;
+}
+
+
+static string s_FormatDouble(double value)
+{
+    return NStr::DoubleToString(value, 15,
+        NStr::fDoubleGeneral | NStr::fDoublePosix);
+}
+
+
+void CMetricsSnapshot::WriteText(CNcbiOstream& out) const
+{
+    // Group entries with the same name, keeping the order of first
+    // appearance; HELP and TYPE must be printed once per name.
+    vector<string> names;
+    map<string, vector<const SEntry*> > groups;
+    ITERATE(TEntries, it, m_Entries) {
+        vector<const SEntry*>& group = groups[it->m_Name];
+        if ( group.empty() ) {
+            names.push_back(it->m_Name);
+        }
+        group.push_back(&*it);
+    }
+
+    ITERATE(vector<string>, name, names) {
+        const vector<const SEntry*>& group = groups[*name];
+        const SEntry& first = *group.front();
+        if ( !first.m_Help.empty() ) {
+            out << "# HELP " << *name << ' ' << first.m_Help << '\n';
+        }
+        const char* type = "counter";
+        if (first.m_Type == eGauge) {
+            type = "gauge";
+        }
+        else if (first.m_Type == eHistogram) {
+            type = "histogram";
+        }
+        out << "# TYPE " << *name << ' ' << type << '\n';
+
+        ITERATE(vector<const SEntry*>, e, group) {
+            const SEntry& entry = **e;
+            if (entry.m_Type != eHistogram) {
+                out << *name << s_FormatLabels(entry.m_Labels) << ' '
+                    << entry.m_Value << '\n';
+                continue;
+            }
+            const CMetricHistogram::CSnapshot& hist = entry.m_Histogram;
+            double unit = hist.GetUnit();
+            Uint8 cumulative = 0;
+            for (size_t i = 0; i < CMetricHistogram::kBuckets; ++i) {
+                Uint8 count = hist.GetBucketCount(i);
+                if ( !count ) {
+                    continue;
+                }
+                cumulative += count;
+                double le =
+                    double(CMetricHistogram::GetBucketUpperBound(i)) * unit;
+                out << *name << "_bucket"
+                    << s_FormatLabels(entry.m_Labels, "le", s_FormatDouble(le))
+                    << ' ' << cumulative << '\n';
+            }
+            out << *name << "_bucket"
+                << s_FormatLabels(entry.m_Labels, "le", "+Inf")
+                << ' ' << cumulative << '\n';
+            out << *name << "_sum" << s_FormatLabels(entry.m_Labels) << ' '
+                << s_FormatDouble(double(hist.GetSum()) * unit) << '\n';
+            out << *name << "_count" << s_FormatLabels(entry.m_Labels) << ' '
+                << cumulative << '\n';
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CMetricsRegistry
+//
+
+CMetricsRegistry::CMetricsRegistry(void)
+{
+}
+
+
+CMetricsRegistry::~CMetricsRegistry(void)
+{
+}
+
+
+static CSafeStatic<CMetricsRegistry> s_MetricsRegistry;
+
+CMetricsRegistry& CMetricsRegistry::Instance(void)
+{
+    return s_MetricsRegistry.Get();
+}
+
+
+CMetricsRegistry::SMetric&
+CMetricsRegistry::x_Get(CMetricsSnapshot::EType type,
+                        const string&           name,
+                        const string&           help,
+                        const TMetricLabels&    labels)
+{
+    if ( name.empty() ) {
+        NCBI_THROW(CCoreException, eInvalidArg, "Empty metric name");
+    }
+    string key = name + s_FormatLabels(labels);
+    // Must be called with m_Mutex locked.
+    SMetric& metric = m_Metrics[key];
+    if ( metric.m_Object ) {
+        if (metric.m_Type != type) {
+            NCBI_THROW(CCoreException, eInvalidArg,
+                "Metric already registered with a different type: " + key);
+        }
+        return metric;
+    }
+    metric.m_Type = type;
+    metric.m_Name = name;
+    metric.m_Help = help;
+    metric.m_Labels = labels;
+    return metric;
+}
+
+
+CRef<CMetricCounter>
+CMetricsRegistry::GetCounter(const string&        name,
+                             const string&        help,
+                             const TMetricLabels& labels)
+{
+    CFastMutexGuard guard(m_Mutex);
+    SMetric& metric = x_Get(CMetricsSnapshot::eCounter, name, help, labels);
+    if ( !metric.m_Object ) {
+        metric.m_Object.Reset(new CMetricCounter);
+    }
+    return CRef<CMetricCounter>(
+        static_cast<CMetricCounter*>(metric.m_Object.GetPointer()));
+}
+
+
+CRef<CMetricGauge>
+CMetricsRegistry::GetGauge(const string&        name,
+                           const string&        help,
+                           const TMetricLabels& labels)
+{
+    CFastMutexGuard guard(m_Mutex);
+    SMetric& metric = x_Get(CMetricsSnapshot::eGauge, name, help, labels);
+    if ( !metric.m_Object ) {
+        metric.m_Object.Reset(new CMetricGauge);
+    }
+    return CRef<CMetricGauge>(
+        static_cast<CMetricGauge*>(metric.m_Object.GetPointer()));
+}
+
+
+CRef<CMetricHistogram>
+CMetricsRegistry::GetHistogram(const string&        name,
+                               const string&        help,
+                               const TMetricLabels& labels,
+                               double               unit)
+{
+    CFastMutexGuard guard(m_Mutex);
+    SMetric& metric = x_Get(CMetricsSnapshot::eHistogram, name, help, labels);
+    if ( !metric.m_Object ) {
+        metric.m_Object.Reset(new CMetricHistogram(unit));
+    }
+    return CRef<CMetricHistogram>(
+        static_cast<CMetricHistogram*>(metric.m_Object.GetPointer()));
+}
+
+
+CMetricsSnapshot CMetricsRegistry::GetSnapshot(void) const
+{
+    CMetricsSnapshot snap;
+    CFastMutexGuard guard(m_Mutex);
+    snap.SetEntries().reserve(m_Metrics.size());
+    ITERATE(TMetrics, it, m_Metrics) {
+        const SMetric& metric = it->second;
+        CMetricsSnapshot::SEntry entry;
+        entry.m_Name = metric.m_Name;
+        entry.m_Help = metric.m_Help;
+        entry.m_Type = metric.m_Type;
+        entry.m_Labels = metric.m_Labels;
+        switch (metric.m_Type) {
+        case CMetricsSnapshot::eCounter:
+            entry.m_Value = Int8(static_cast<const CMetricCounter&>(
+                *metric.m_Object).GetValue());
+            break;
+        case CMetricsSnapshot::eGauge:
+            entry.m_Value = static_cast<const CMetricGauge&>(
+                *metric.m_Object).GetValue();
+            break;
+        case CMetricsSnapshot::eHistogram:
+            entry.m_Histogram = static_cast<const CMetricHistogram&>(
+                *metric.m_Object).GetSnapshot();
+            break;
+        }
+        snap.SetEntries().push_back(entry);
+    }
+    return snap;
+}
+
+
+void CMetricsRegistry::WriteText(CNcbiOstream& out) const
+{
+    GetSnapshot().WriteText(out);
+}
+
+
+void CMetricsRegistry::Clear(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    m_Metrics.clear();
+}
+
+
+END_NCBI_SCOPE
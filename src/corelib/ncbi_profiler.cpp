@@ -0,0 +1,585 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Sampling CPU profiler
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_profiler.hpp>
+#include <corelib/ncbi_param.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/error_codes.hpp>
+#include <atomic>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#if defined(NCBI_OS_UNIX)
+#  include <signal.h>
+#  include <sys/time.h>
+#  include <time.h>
+#  include <errno.h>
+#  include <dlfcn.h>
+#  if defined(HAVE_LIBUNWIND)
+#    define UNW_LOCAL_ONLY
+#    include <libunwind.h>
+#    define NCBI_PROFILER_SUPPORTED 1
+#  elif defined(NCBI_OS_LINUX)  ||  defined(NCBI_OS_DARWIN)
+#    include <execinfo.h>
+#    define NCBI_PROFILER_SUPPORTED 1
+#  endif
+#  if defined(NCBI_OS_LINUX)  &&  defined(SIGEV_THREAD_ID)
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#    define NCBI_PROFILER_THREAD_TIMERS 1
+#    if !defined(sigev_notify_thread_id)
+#      define sigev_notify_thread_id _sigev_un._tid
+#    endif
+#  endif
+#endif
+#if defined(HAVE_CXA_DEMANGLE)
+#  include <cxxabi.h>
+#endif
+
+
+#define NCBI_USE_ERRCODE_X   Corelib_Profiler
+
+
+BEGIN_NCBI_SCOPE
+
+
+NCBI_PARAM_DECL(bool, Profiler, Enabled);
+NCBI_PARAM_DEF_EX(bool, Profiler, Enabled, false, eParam_NoThread,
+                  NCBI_PROFILER_ENABLED);
+
+NCBI_PARAM_DECL(unsigned int, Profiler, Frequency);
+NCBI_PARAM_DEF_EX(unsigned int, Profiler, Frequency, 99, eParam_NoThread,
+                  NCBI_PROFILER_FREQUENCY);
+
+NCBI_PARAM_DECL(string, Profiler, Output);
+NCBI_PARAM_DEF_EX(string, Profiler, Output, "", eParam_NoThread,
+                  NCBI_PROFILER_OUTPUT);
+
+NCBI_PARAM_DECL(double, Profiler, WriteInterval);
+NCBI_PARAM_DEF_EX(double, Profiler, WriteInterval, 60, eParam_NoThread,
+                  NCBI_PROFILER_WRITEINTERVAL);
+
+NCBI_PARAM_DECL(unsigned int, Profiler, MaxDepth);
+NCBI_PARAM_DEF_EX(unsigned int, Profiler, MaxDepth, 64, eParam_NoThread,
+                  NCBI_PROFILER_MAXDEPTH);
+
+NCBI_PARAM_DECL(unsigned int, Profiler, MaxStacks);
+NCBI_PARAM_DEF_EX(unsigned int, Profiler, MaxStacks, 100000, eParam_NoThread,
+                  NCBI_PROFILER_MAXSTACKS);
+
+
+bool CSamplingProfiler::IsEnabled(void)
+{
+    return NCBI_PARAM_TYPE(Profiler, Enabled)::GetDefault();
+}
+
+
+#if defined(NCBI_PROFILER_SUPPORTED)
+
+// Frames of the signal handler and the signal trampoline
+static const unsigned int kSkipFrames   = 2;
+static const unsigned int kMaxDepth     = 64;
+// Samples per thread buffered between collections
+static const unsigned int kBufferSize   = 256;
+// How often the collector drains per-thread buffers, in seconds
+static const double       kCollectDelay = 0.1;
+
+
+// Per-thread sample buffer, written by the signal handler of the owning
+// thread and read by the collector thread.
+struct SProfilerThreadBuffer
+{
+    struct SSample {
+        unsigned int depth;
+        void*        frames[kMaxDepth + kSkipFrames];
+    };
+
+    SProfilerThreadBuffer(void) : m_Head(0), m_Tail(0), m_HasTimer(false) {}
+
+    SSample              m_Samples[kBufferSize];
+    atomic<unsigned int> m_Head;  // next sample to collect
+    atomic<unsigned int> m_Tail;  // next sample to write
+#if defined(NCBI_PROFILER_THREAD_TIMERS)
+    pid_t                m_ThreadId;
+    timer_t              m_Timer;
+#endif
+    bool                 m_HasTimer;
+};
+
+
+typedef vector<void*> TProfilerStack;
+typedef map<TProfilerStack, Uint8> TProfile;
+
+// Profiler state, guarded by s_ProfilerMutex except the fields accessed
+// from the signal handler.
+struct SProfilerState
+{
+    SProfilerState(void)
+        : m_Running(false), m_Depth(kMaxDepth), m_Frequency(99),
+          m_MaxStacks(100000), m_Samples(0), m_Dropped(0),
+          m_StopCollector(NULL)
+    {}
+
+    atomic<bool>                       m_Running;
+    unsigned int                       m_Depth;
+    unsigned int                       m_Frequency;
+    unsigned int                       m_MaxStacks;
+    string                             m_Output;
+    set<SProfilerThreadBuffer*>        m_Threads;
+    TProfile                           m_Profile;
+    atomic<Uint8>                      m_Samples;
+    atomic<Uint8>                      m_Dropped;
+    CRef<CThread>                      m_Collector;
+    CSemaphore*                        m_StopCollector;
+};
+
+static SProfilerState s_Profiler;
+DEFINE_STATIC_FAST_MUTEX(s_ProfilerMutex);
+// Serializes output file updates, taken before s_ProfilerMutex
+DEFINE_STATIC_FAST_MUTEX(s_ProfileWriteMutex);
+static thread_local SProfilerThreadBuffer* s_ProfilerBuffer = NULL;
+
+
+static void s_ProfilerSignalHandler(int, siginfo_t*, void*)
+{
+    int saved_errno = errno;
+    SProfilerThreadBuffer* buffer = s_ProfilerBuffer;
+    if ( buffer ) {
+        unsigned int tail = buffer->m_Tail.load(memory_order_relaxed);
+        unsigned int head = buffer->m_Head.load(memory_order_acquire);
+        if (tail - head < kBufferSize) {
+            SProfilerThreadBuffer::SSample& sample =
+                buffer->m_Samples[tail % kBufferSize];
+            int depth = int(s_Profiler.m_Depth + kSkipFrames);
+#if defined(HAVE_LIBUNWIND)
+            int n = unw_backtrace(sample.frames, depth);
+#else
+            int n = backtrace(sample.frames, depth);
+#endif
+            sample.depth = n > 0 ? unsigned(n) : 0;
+            buffer->m_Tail.store(tail + 1, memory_order_release);
+        } else {
+            s_Profiler.m_Dropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    errno = saved_errno;
+}
+
+
+// Move samples from the thread buffer to the profile,
+// must be called under s_ProfilerMutex.
+static void s_CollectSamples(SProfilerThreadBuffer& buffer)
+{
+    unsigned int head = buffer.m_Head.load(memory_order_relaxed);
+    unsigned int tail = buffer.m_Tail.load(memory_order_acquire);
+    TProfilerStack stack;
+    for ( ;  head != tail;  ++head) {
+        const SProfilerThreadBuffer::SSample& sample =
+            buffer.m_Samples[head % kBufferSize];
+        if (sample.depth > kSkipFrames) {
+            // Outermost frame first
+            stack.assign(sample.frames + kSkipFrames,
+                         sample.frames + sample.depth);
+            reverse(stack.begin(), stack.end());
+            TProfile::iterator it = s_Profiler.m_Profile.find(stack);
+            if (it == s_Profiler.m_Profile.end()) {
+                if (s_Profiler.m_Profile.size() >= s_Profiler.m_MaxStacks) {
+                    // Too many distinct stacks, count under one
+                    // pseudo-frame
+                    stack.assign(1, (void*) NULL);
+                }
+                it = s_Profiler.m_Profile.insert(
+                    TProfile::value_type(stack, 0)).first;
+            }
+            ++it->second;
+        }
+        s_Profiler.m_Samples.fetch_add(1, memory_order_relaxed);
+    }
+    buffer.m_Head.store(head, memory_order_release);
+}
+
+
+static string s_GetFrameName(void* addr)
+{
+    if ( !addr ) {
+        return "[other stacks]";
+    }
+    Dl_info info;
+    // Return addresses point after the call instruction
+    void* pc = static_cast<char*>(addr) - 1;
+    if ( !::dladdr(pc, &info) ) {
+        return NStr::PtrToString(addr);
+    }
+    string name;
+    if ( info.dli_sname ) {
+        name = info.dli_sname;
+#if defined(HAVE_CXA_DEMANGLE)
+        int status = 0;
+        char* buf = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        if ( buf ) {
+            if (status == 0) {
+                name = buf;
+            }
+            free(buf);
+        }
+#endif
+    } else {
+        string module = info.dli_fname ? info.dli_fname : "???";
+        name = CDirEntry(module).GetName() + "+0x" +
+            NStr::UInt8ToString(
+                Uint8(static_cast<char*>(pc) -
+                      static_cast<char*>(info.dli_fbase)), 0, 16);
+    }
+    // ';' separates frames and trailing space - the count
+    NStr::ReplaceInPlace(name, ";", ",");
+    return name;
+}
+
+
+// Write the profile, must not be called under s_ProfilerMutex: only
+// copying the profile holds it, symbol lookup and demangling do not.
+static void s_WriteProfile(void)
+{
+    CFastMutexGuard write_guard(s_ProfileWriteMutex);
+    TProfile profile;
+    string output;
+    {{
+        CFastMutexGuard guard(s_ProfilerMutex);
+        ITERATE(set<SProfilerThreadBuffer*>, it, s_Profiler.m_Threads) {
+            s_CollectSamples(**it);
+        }
+        if (s_Profiler.m_Output.empty()) {
+            return;
+        }
+        profile = s_Profiler.m_Profile;
+        output = s_Profiler.m_Output;
+    }}
+    string tmp = output + ".tmp";
+    {{
+        CNcbiOfstream out(tmp.c_str(), IOS_BASE::out | IOS_BASE::trunc);
+        if ( !out ) {
+            ERR_POST_X_ONCE(1, Warning << "Cannot write profile to " << tmp);
+            return;
+        }
+        unordered_map<void*, string> names;
+        ITERATE(TProfile, it, profile) {
+            const TProfilerStack& stack = it->first;
+            for (size_t i = 0;  i < stack.size();  ++i) {
+                string& name = names[stack[i]];
+                if ( name.empty() ) {
+                    name = s_GetFrameName(stack[i]);
+                }
+                if (i) {
+                    out << ';';
+                }
+                out << name;
+            }
+            out << ' ' << it->second << '\n';
+        }
+    }}
+    if ( !CFile(tmp).Rename(output, CFile::fRF_Overwrite) ) {
+        ERR_POST_X_ONCE(2, Warning << "Cannot write profile to " << output);
+    }
+}
+
+
+class CProfilerCollector : public CThread
+{
+public:
+    CProfilerCollector(CSemaphore& stop, double write_interval)
+        : m_Stop(stop), m_WriteInterval(write_interval)
+    {}
+
+protected:
+    virtual void* Main(void)
+    {
+        CStopWatch since_write(CStopWatch::eStart);
+        while ( !m_Stop.TryWait(CTimeout(kCollectDelay)) ) {
+            if (since_write.Elapsed() >= m_WriteInterval) {
+                s_WriteProfile();
+                since_write.Restart();
+            } else {
+                CFastMutexGuard guard(s_ProfilerMutex);
+                ITERATE(set<SProfilerThreadBuffer*>, it, s_Profiler.m_Threads) {
+                    s_CollectSamples(**it);
+                }
+            }
+        }
+        return NULL;
+    }
+
+private:
+    CSemaphore& m_Stop;
+    double      m_WriteInterval;
+};
+
+
+// Start the CPU timer of the buffer's thread.
+static void s_StartTimer(SProfilerThreadBuffer& buffer)
+{
+    struct itimerspec its;
+    long interval_ns = 1000000000L / long(s_Profiler.m_Frequency);
+    its.it_interval.tv_sec  = interval_ns / 1000000000L;
+    its.it_interval.tv_nsec = interval_ns % 1000000000L;
+    its.it_value = its.it_interval;
+#if defined(NCBI_PROFILER_THREAD_TIMERS)
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo  = SIGPROF;
+    sev.sigev_notify_thread_id = buffer.m_ThreadId;
+    if (::timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &buffer.m_Timer) == 0) {
+        if (::timer_settime(buffer.m_Timer, 0, &its, NULL) == 0) {
+            buffer.m_HasTimer = true;
+        } else {
+            ::timer_delete(buffer.m_Timer);
+        }
+    }
+    if ( !buffer.m_HasTimer ) {
+        ERR_POST_X_ONCE(3, Warning << "Cannot start profiling timer: "
+                        << NcbiSys_strerror(errno));
+    }
+#else
+    // Process-wide timer started by CSamplingProfiler::Start()
+    (void) buffer;
+    (void) its;
+#endif
+}
+
+
+static void s_StopTimer(SProfilerThreadBuffer& buffer)
+{
+#if defined(NCBI_PROFILER_THREAD_TIMERS)
+    if (buffer.m_HasTimer) {
+        ::timer_delete(buffer.m_Timer);
+        buffer.m_HasTimer = false;
+    }
+#else
+    (void) buffer;
+#endif
+}
+
+
+bool CSamplingProfiler::Start(void)
+{
+    CFastMutexGuard guard(s_ProfilerMutex);
+    if (s_Profiler.m_Running) {
+        return true;
+    }
+    s_Profiler.m_Frequency =
+        max(NCBI_PARAM_TYPE(Profiler, Frequency)::GetDefault(), 1U);
+    s_Profiler.m_Depth = min(NCBI_PARAM_TYPE(Profiler, MaxDepth)::GetDefault(),
+                             kMaxDepth);
+    s_Profiler.m_MaxStacks =
+        max(NCBI_PARAM_TYPE(Profiler, MaxStacks)::GetDefault(), 1U);
+    s_Profiler.m_Output = NCBI_PARAM_TYPE(Profiler, Output)::GetDefault();
+    if (s_Profiler.m_Output.empty()) {
+        string app = GetDiagContext().GetAppName();
+        s_Profiler.m_Output = (app.empty() ? string("ncbi") : app) + "." +
+            NStr::NumericToString(CCurrentProcess::GetPid()) + ".folded";
+    }
+
+    // The first call may allocate memory, which is not allowed
+    // in the signal handler.
+    void* frames[kSkipFrames + 1];
+#if defined(HAVE_LIBUNWIND)
+    unw_backtrace(frames, kSkipFrames + 1);
+#else
+    backtrace(frames, kSkipFrames + 1);
+#endif
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = s_ProfilerSignalHandler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (::sigaction(SIGPROF, &sa, NULL) != 0) {
+        ERR_POST_X(4, "Cannot install SIGPROF handler: "
+                   << NcbiSys_strerror(errno));
+        return false;
+    }
+#if !defined(NCBI_PROFILER_THREAD_TIMERS)
+    struct itimerval itv;
+    long interval_us = 1000000L / long(s_Profiler.m_Frequency);
+    itv.it_interval.tv_sec  = interval_us / 1000000L;
+    itv.it_interval.tv_usec = interval_us % 1000000L;
+    itv.it_value = itv.it_interval;
+    if (::setitimer(ITIMER_PROF, &itv, NULL) != 0) {
+        ERR_POST_X(5, "Cannot start profiling timer: "
+                   << NcbiSys_strerror(errno));
+        return false;
+    }
+#endif
+    s_Profiler.m_Running = true;
+
+    double write_interval =
+        NCBI_PARAM_TYPE(Profiler, WriteInterval)::GetDefault();
+    s_Profiler.m_StopCollector = new CSemaphore(0, 1);
+    s_Profiler.m_Collector.Reset(
+        new CProfilerCollector(*s_Profiler.m_StopCollector, write_interval));
+    s_Profiler.m_Collector->Run();
+    // Threads registered before the previous Stop()
+    ITERATE(set<SProfilerThreadBuffer*>, it, s_Profiler.m_Threads) {
+        s_StartTimer(**it);
+    }
+    guard.Release();
+
+    RegisterThread();
+    return true;
+}
+
+
+void CSamplingProfiler::Stop(void)
+{
+    CRef<CThread> collector;
+    {{
+        CFastMutexGuard guard(s_ProfilerMutex);
+        if ( !s_Profiler.m_Running ) {
+            return;
+        }
+        s_Profiler.m_Running = false;
+#if !defined(NCBI_PROFILER_THREAD_TIMERS)
+        struct itimerval itv;
+        memset(&itv, 0, sizeof(itv));
+        ::setitimer(ITIMER_PROF, &itv, NULL);
+#endif
+        ITERATE(set<SProfilerThreadBuffer*>, it, s_Profiler.m_Threads) {
+            s_StopTimer(**it);
+        }
+        collector.Swap(s_Profiler.m_Collector);
+        s_Profiler.m_StopCollector->Post();
+    }}
+    collector->Join();
+
+    {{
+        CFastMutexGuard guard(s_ProfilerMutex);
+        delete s_Profiler.m_StopCollector;
+        s_Profiler.m_StopCollector = NULL;
+    }}
+    s_WriteProfile();
+}
+
+
+bool CSamplingProfiler::IsRunning(void)
+{
+    return s_Profiler.m_Running;
+}
+
+
+void CSamplingProfiler::Flush(void)
+{
+    s_WriteProfile();
+}
+
+
+void CSamplingProfiler::RegisterThread(void)
+{
+    if ( !s_Profiler.m_Running  ||  s_ProfilerBuffer ) {
+        return;
+    }
+    SProfilerThreadBuffer* buffer = new SProfilerThreadBuffer;
+#if defined(NCBI_PROFILER_THREAD_TIMERS)
+    buffer->m_ThreadId = pid_t(::syscall(SYS_gettid));
+#endif
+    // Also makes sure the thread-local variable is allocated before
+    // the first signal arrives.
+    s_ProfilerBuffer = buffer;
+    CFastMutexGuard guard(s_ProfilerMutex);
+    if ( !s_Profiler.m_Running ) {
+        s_ProfilerBuffer = NULL;
+        delete buffer;
+        return;
+    }
+    s_Profiler.m_Threads.insert(buffer);
+    s_StartTimer(*buffer);
+}
+
+
+void CSamplingProfiler::UnregisterThread(void)
+{
+    SProfilerThreadBuffer* buffer = s_ProfilerBuffer;
+    if ( !buffer ) {
+        return;
+    }
+    CFastMutexGuard guard(s_ProfilerMutex);
+    s_StopTimer(*buffer);
+    s_ProfilerBuffer = NULL;
+    s_CollectSamples(*buffer);
+    s_Profiler.m_Threads.erase(buffer);
+    delete buffer;
+}
+
+
+Uint8 CSamplingProfiler::GetSampleCount(void)
+{
+    CFastMutexGuard guard(s_ProfilerMutex);
+    ITERATE(set<SProfilerThreadBuffer*>, it, s_Profiler.m_Threads) {
+        s_CollectSamples(**it);
+    }
+    return s_Profiler.m_Samples;
+}
+
+
+Uint8 CSamplingProfiler::GetDroppedCount(void)
+{
+    return s_Profiler.m_Dropped;
+}
+
+
+#else  /* NCBI_PROFILER_SUPPORTED */
+
+
+bool CSamplingProfiler::Start(void)
+{
+    ERR_POST_X(6, Warning << "Sampling profiler is not supported "
+               "on this platform");
+    return false;
+}
+
+void CSamplingProfiler::Stop(void)             {}
+bool CSamplingProfiler::IsRunning(void)        { return false; }
+void CSamplingProfiler::Flush(void)            {}
+void CSamplingProfiler::RegisterThread(void)   {}
+void CSamplingProfiler::UnregisterThread(void) {}
+Uint8 CSamplingProfiler::GetSampleCount(void)  { return 0; }
+Uint8 CSamplingProfiler::GetDroppedCount(void) { return 0; }
+
+
+#endif  /* NCBI_PROFILER_SUPPORTED */
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,277 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Application startup timeline and registry snapshot cache
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_startup.hpp>
+#include <corelib/ncbi_param.hpp>
+#include <corelib/ncbi_process.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbireg.hpp>
+#include <corelib/metareg.hpp>
+#include <corelib/error_codes.hpp>
+#include <chrono>
+
+
+#define NCBI_USE_ERRCODE_X   Corelib_App
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CStartupTimeline::
+//
+
+NCBI_PARAM_DECL(bool, NCBI, StartupTimeline);
+NCBI_PARAM_DEF_EX(bool, NCBI, StartupTimeline, false,
+                  eParam_NoThread, NCBI_CONFIG__STARTUP_TIMELINE);
+typedef NCBI_PARAM_TYPE(NCBI, StartupTimeline) TParamStartupTimeline;
+
+
+// Phases are always recorded - it is cheap, and the report can be enabled
+// by the application's registry, which is loaded after the first phases.
+// Plain static data, so that marks can be made during static
+// initialization and destruction.
+struct SStartupPhase
+{
+    const char* name;
+    double      end;
+};
+
+static double s_GetTimeMark(void)
+{
+    return chrono::duration<double>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const size_t   kMaxStartupPhases = 64;
+static SStartupPhase  s_StartupPhases[kMaxStartupPhases];
+static size_t         s_StartupPhaseCount = 0;
+static const double   s_StartupLoadTime = s_GetTimeMark();
+DEFINE_STATIC_FAST_MUTEX(s_StartupMutex);
+
+
+bool CStartupTimeline::IsEnabled(void)
+{
+    return TParamStartupTimeline::GetDefault();
+}
+
+
+void CStartupTimeline::Mark(const char* phase)
+{
+    double now = s_GetTimeMark();
+    CFastMutexGuard guard(s_StartupMutex);
+    if (s_StartupPhaseCount < kMaxStartupPhases) {
+        SStartupPhase& p = s_StartupPhases[s_StartupPhaseCount++];
+        p.name = phase;
+        p.end  = now;
+    }
+}
+
+
+double CStartupTimeline::GetElapsed(void)
+{
+    return s_GetTimeMark() - s_StartupLoadTime;
+}
+
+
+void CStartupTimeline::Report(CNcbiOstream& out)
+{
+    CFastMutexGuard guard(s_StartupMutex);
+    out << "Startup timeline:" << endl
+        << setw(24) << left << "phase" << right
+        << setw(12) << "ms" << setw(12) << "total" << endl;
+    double start = s_StartupLoadTime;
+    for (size_t i = 0;  i < s_StartupPhaseCount;  ++i) {
+        const SStartupPhase& p = s_StartupPhases[i];
+        out << setw(24) << left << p.name << right << fixed
+            << setprecision(3) << setw(12) << (p.end - start) * 1000
+            << setw(12) << (p.end - s_StartupLoadTime) * 1000 << endl;
+        start = p.end;
+    }
+    out.unsetf(IOS_BASE::floatfield);
+}
+
+
+void CStartupTimeline::Reset(void)
+{
+    CFastMutexGuard guard(s_StartupMutex);
+    s_StartupPhaseCount = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CRegistrySnapshot::
+//
+
+NCBI_PARAM_DECL(string, NCBI, RegistrySnapshot);
+NCBI_PARAM_DEF_EX(string, NCBI, RegistrySnapshot, "",
+                  eParam_NoThread, NCBI_CONFIG__REGISTRY_SNAPSHOT);
+typedef NCBI_PARAM_TYPE(NCBI, RegistrySnapshot) TParamRegistrySnapshot;
+
+
+// Snapshot layout: signature line, header lines (tab separated fields,
+// strings in printable form), end of header, then the registry itself.
+static const char* const kSnapshotSignature = "#@ NCBI registry snapshot 1";
+static const char* const kSnapshotKey       = "#@key";
+static const char* const kSnapshotConfig    = "#@config";
+static const char* const kSnapshotFile      = "#@file";
+static const char* const kSnapshotEnd       = "#@end";
+
+
+string CRegistrySnapshot::GetPath(void)
+{
+    return TParamRegistrySnapshot::GetDefault();
+}
+
+
+bool CRegistrySnapshot::Load(const string&  path,
+                             const string&  key,
+                             CNcbiRegistry& reg,
+                             string*        config_path)
+{
+    CNcbiIfstream is(path.c_str(), IOS_BASE::in | IOS_BASE::binary);
+    string line;
+    if ( !getline(is, line)  ||  line != kSnapshotSignature ) {
+        return false;
+    }
+    bool   key_matches = false;
+    string config;
+    for (;;) {
+        if ( !getline(is, line) ) {
+            return false;
+        }
+        if (line == kSnapshotEnd) {
+            break;
+        }
+        vector<string> fields;
+        NStr::Split(line, "\t", fields);
+        if (fields.size() == 2  &&  fields[0] == kSnapshotKey) {
+            key_matches = NStr::ParseEscapes(fields[1]) == key;
+            if ( !key_matches ) {
+                _TRACE("Registry snapshot " << path << " has different key");
+                return false;
+            }
+        } else if (fields.size() == 2  &&  fields[0] == kSnapshotConfig) {
+            config = NStr::ParseEscapes(fields[1]);
+        } else if (fields.size() == 5  &&  fields[0] == kSnapshotFile) {
+            // Same validation as CMetaRegistry::SEntry::Reload()
+            CFile file(NStr::ParseEscapes(fields[4]));
+            CTime timestamp;
+            if ( !file.GetTime(&timestamp)
+                ||  file.GetLength() != NStr::StringToInt8(fields[1])
+                ||  timestamp.GetTimeT()
+                    != (time_t) NStr::StringToInt8(fields[2])
+                ||  timestamp.NanoSecond()
+                    != NStr::StringToLong(fields[3]) ) {
+                _TRACE("Registry snapshot " << path << " is stale: "
+                       << file.GetPath() << " has changed");
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    if ( !key_matches ) {
+        return false;
+    }
+    try {
+        reg.Read(is, IRegistry::fJustCore);
+    }
+    catch (CException& e) {
+        ERR_POST_X(24, Warning << "Cannot read registry snapshot "
+                   << path << ": " << e.GetMsg());
+        reg.Clear();
+        return false;
+    }
+    if ( config_path ) {
+        *config_path = config;
+    }
+    return true;
+}
+
+
+bool CRegistrySnapshot::Save(const string&        path,
+                             const string&        key,
+                             const CNcbiRegistry& reg,
+                             const string&        config_path)
+{
+    vector<CMetaRegistry::SEntry> entries;
+    CMetaRegistry::GetLoadedEntries(entries);
+
+    // Write to a temporary file first, so that concurrently started
+    // applications never see an incomplete snapshot.
+    string tmp_path = path + ".tmp"
+        + NStr::NumericToString(CCurrentProcess::GetPid());
+    {{
+        CNcbiOfstream os(tmp_path.c_str(),
+                         IOS_BASE::out | IOS_BASE::trunc | IOS_BASE::binary);
+        os << kSnapshotSignature << '\n'
+           << kSnapshotKey << '\t' << NStr::PrintableString(key) << '\n'
+           << kSnapshotConfig << '\t' << NStr::PrintableString(config_path)
+           << '\n';
+        ITERATE(vector<CMetaRegistry::SEntry>, it, entries) {
+            if ( it->actual_name.empty() ) {
+                continue;
+            }
+            os << kSnapshotFile << '\t' << it->length << '\t'
+               << (Int8) it->timestamp.GetTimeT() << '\t'
+               << it->timestamp.NanoSecond() << '\t'
+               << NStr::PrintableString(it->actual_name) << '\n';
+        }
+        os << kSnapshotEnd << '\n';
+        // Values from all layers, as seen by the application
+        if ( !reg.Write(os, IRegistry::fTransient | IRegistry::fPersistent
+                            | IRegistry::fNotJustCore) ) {
+            os.setstate(IOS_BASE::failbit);
+        }
+        os.close();
+        if ( !os ) {
+            ERR_POST_X(24, Warning << "Cannot write registry snapshot "
+                       << tmp_path);
+            CFile(tmp_path).Remove();
+            return false;
+        }
+    }}
+    if ( !CFile(tmp_path).Rename(path, CDirEntry::fRF_Overwrite) ) {
+        ERR_POST_X(24, Warning << "Cannot rename registry snapshot "
+                   << tmp_path << " to " << path);
+        CFile(tmp_path).Remove();
+        return false;
+    }
+    return true;
+}
+
+
+END_NCBI_SCOPE
@@ -44,6 +44,8 @@
 #include <corelib/ncbifile.hpp>
 #include <corelib/ncbi_system.hpp>
 #include <corelib/ncbi_param.hpp>
+#include <corelib/ncbi_profiler.hpp>
+#include <corelib/ncbi_startup.hpp>
 #include <corelib/syslog.hpp>
 #include <corelib/error_codes.hpp>
 #include <corelib/ncbi_safe_static.hpp>
@@ -405,6 +407,12 @@ bool s_HandleExceptions(void)
 }
 
 
+NCBI_PARAM_DECL(bool, NCBI, LazyStartup);
+NCBI_PARAM_DEF_EX(bool, NCBI, LazyStartup, false,
+                  eParam_NoThread, NCBI_CONFIG__LAZY_STARTUP);
+typedef NCBI_PARAM_TYPE(NCBI, LazyStartup) TParamLazyStartup;
+
+
 NCBI_PARAM_DECL(bool, NCBI, TerminateOnCpuIncompatibility); 
 NCBI_PARAM_DEF_EX(bool, NCBI, TerminateOnCpuIncompatibility, false,
                   eParam_NoThread, NCBI_CONFIG__TERMINATE_ON_CPU_INCOMPATIBILITY);
@@ -420,18 +428,27 @@ void CNcbiApplicationAPI::x_TryInit(EAppDiagStream diag, const char* conf)
         LoadConfig(*m_Config, NULL);
     }
     m_ConfigLoaded = true;
+    CStartupTimeline::Mark("config load");
 
     CDiagContext::SetupDiag(diag, m_Config, eDCM_Flush, m_LogFile);
     CDiagContext::x_FinalizeSetupDiag();
+    CStartupTimeline::Mark("diag config");
 
     // Setup the standard features from the config file.
     // Don't call till after LoadConfig()
     // NOTE: this will override environment variables,
     // except DIAG_POST_LEVEL which is Set*Fixed*.
     x_HonorStandardSettings();
+    CStartupTimeline::Mark("standard settings");
+
+    // [Profiler.Enabled]
+    if ( CSamplingProfiler::IsEnabled() ) {
+        CSamplingProfiler::Start();
+    }
 
     // Application start
     AppStart();
+    CStartupTimeline::Mark("AppStart()");
 
     // Verify CPU compatibility
     // Second check. Print error message and allow to terminate program depends on configuration parameters.
@@ -466,6 +483,7 @@ void CNcbiApplicationAPI::x_TryInit(EAppDiagStream diag, const char* conf)
              "This program has no mandatory arguments");
         SetupArgDescriptions(arg_desc.release());
     }
+    CStartupTimeline::Mark("Init()");
 }
 
 // Macro to define a logging parameter
@@ -698,6 +716,7 @@ void CNcbiApplicationAPI::x_TryMain(EAppDiagStream diag,
     }
     x_ReadLogOptions();
     x_LogOptions(eStartEvent);
+    CStartupTimeline::Mark("log options");
     // Run application
     if (*exit_code == 1) {
         GetDiagContext().SetGlobalAppState(eDiagAppState_AppRun);
@@ -736,6 +755,7 @@ void CNcbiApplicationAPI::x_TryMain(EAppDiagStream diag,
         else {
             *exit_code = m_DryRun ? DryRun() : Run();
         }
+        CStartupTimeline::Mark("Run()");
     }
     auto span = CDiagContext::GetRequestContext().GetTracerSpan();
     if ( span ) {
@@ -767,6 +787,7 @@ void CNcbiApplicationAPI::x_TryMain(EAppDiagStream diag,
     else {
         Exit();
     }
+    CStartupTimeline::Mark("Exit()");
 }
 
 #if defined(NCBI_OS_MSWIN) && defined(_UNICODE)
@@ -836,6 +857,7 @@ int CNcbiApplicationAPI::AppMain
  const char*        conf,
  const string&      name)
 {
+    CStartupTimeline::Mark("load");
     if (conf) {
         m_DefaultConfig = conf;
     }
@@ -867,16 +889,21 @@ int CNcbiApplicationAPI::AppMain
 
     // Setup logging as soon as possible.
     // Setup for diagnostics
-    try {
-        CDiagContext::SetupDiag(diag, 0, eDCM_NoChange, m_LogFile);
-    } catch (const CException& e) {
-        NCBI_RETHROW(e, CAppException, eSetupDiag,
-                     "Application diagnostic stream's setup failed");
-    } catch (const exception& e) {
-        NCBI_THROW(CAppException, eSetupDiag,
-                   "Application diagnostic stream's setup failed: " +
-                   string(e.what()));
+    // (for lazy startup - only once, after loading the registry)
+    if ((m_AppFlags & fLazyStartup) == 0
+        &&  !TParamLazyStartup::GetDefault()) {
+        try {
+            CDiagContext::SetupDiag(diag, 0, eDCM_NoChange, m_LogFile);
+        } catch (const CException& e) {
+            NCBI_RETHROW(e, CAppException, eSetupDiag,
+                         "Application diagnostic stream's setup failed");
+        } catch (const exception& e) {
+            NCBI_THROW(CAppException, eSetupDiag,
+                       "Application diagnostic stream's setup failed: " +
+                       string(e.what()));
+        }
     }
+    CStartupTimeline::Mark("diag setup");
 
     // Get program executable's name & path.
     string exepath = FindProgramExecutablePath(argc, argv, &m_RealExePath);
@@ -907,6 +934,7 @@ int CNcbiApplicationAPI::AppMain
                       "Please fix FindProgramExecutablePath() on this platform.");
         exepath = appname;
     }
+    CStartupTimeline::Mark("executable path");
 
 #if defined(NCBI_OS_DARWIN)
     // We do not know standard way of passing arguments to C++ program on Mac,
@@ -1045,6 +1073,7 @@ int CNcbiApplicationAPI::AppMain
 
     // Clear registry content
     m_Config->Clear();
+    CStartupTimeline::Mark("arguments");
 
     // Call:  Init() + Run() + Exit()
     int exit_code = 1;
@@ -1126,6 +1155,14 @@ int CNcbiApplicationAPI::AppMain
     // Application stop
     AppStop(exit_code);
 
+    // Write the final profile
+    CSamplingProfiler::Stop();
+
+    CStartupTimeline::Mark("AppStop()");
+    if ( CStartupTimeline::IsEnabled() ) {
+        CStartupTimeline::Report(NcbiCerr);
+    }
+
     if ((m_AppFlags & fSkipSafeStaticDestroy) == 0) {
         // Destroy short-lived statics
         CSafeStaticGuard::Destroy(CSafeStaticLifeSpan::eLifeLevel_AppMain);
@@ -1236,6 +1273,30 @@ bool CNcbiApplicationAPI::SetupDiag_AppSpecific(void)
 }
 
 
+// Everything that can affect which registry files are found and what
+// the resulting registry contains, besides the files themselves.
+static string s_GetRegistrySnapshotKey(const CNcbiArguments&   args,
+                                       const CNcbiEnvironment& env,
+                                       const string&           conf,
+                                       CNcbiRegistry::TFlags   reg_flags)
+{
+    string key = "conf=" + conf;
+    key += "\nflags=" + NStr::IntToString(reg_flags);
+    key += "\ncwd=" + CDir::GetCwd();
+    key += "\nprogram=" + args.GetProgramName(eIgnoreLinks)
+        + ',' + args.GetProgramName(eFollowLinks);
+    key += "\npath=" + NStr::Join(CMetaRegistry::GetSearchPath(), ":");
+    list<string> names;
+    env.Enumerate(names, "NCBI_CONFIG_");
+    names.push_back("NCBI_DONT_USE_NCBIRC");
+    names.sort();
+    ITERATE(list<string>, it, names) {
+        key += "\n" + *it + '=' + env.Get(*it);
+    }
+    return key;
+}
+
+
 bool CNcbiApplicationAPI::LoadConfig(CNcbiRegistry&        reg,
                                   const string*         conf,
                                   CNcbiRegistry::TFlags reg_flags)
@@ -1244,6 +1305,28 @@ bool CNcbiApplicationAPI::LoadConfig(CNcbiRegistry&        reg,
     string basename2(m_Arguments->GetProgramBasename(eFollowLinks));
     CMetaRegistry::SEntry entry;
 
+    // [NCBI.RegistrySnapshot] - only for the application's own registry
+    // with a configuration file.
+    string snapshot, snapshot_key;
+    if (conf  &&  &reg == m_Config.GetPointer()  &&  !m_ConfigLoaded) {
+        snapshot = CRegistrySnapshot::GetPath();
+    }
+    if ( !snapshot.empty() ) {
+        snapshot_key = s_GetRegistrySnapshotKey(*m_Arguments, *m_Environ,
+                                                *conf, reg_flags);
+        string config_path;
+        if (CRegistrySnapshot::Load(snapshot, snapshot_key, reg,
+                                    &config_path)
+            &&  !config_path.empty()) {
+            if (conf->empty()) {
+                m_DefaultConfig = CDirEntry(config_path).GetName();
+            }
+            m_ConfigPath = config_path;
+            m_ConfigLoaded = true;
+            return true;
+        }
+    }
+
     if ( !conf ) {
         if (reg.IncludeNcbircIfAllowed(reg_flags)) {
             m_ConfigPath = CMetaRegistry::FindRegistry
@@ -1297,6 +1380,10 @@ bool CNcbiApplicationAPI::LoadConfig(CNcbiRegistry&        reg,
     }
     m_ConfigPath = entry.actual_name;
     m_ConfigLoaded = true;
+    if ( !snapshot.empty() ) {
+        CRegistrySnapshot::Save(snapshot, snapshot_key, *m_Config,
+                                m_ConfigPath);
+    }
     return true;
 }
 
@@ -1623,6 +1710,9 @@ void CNcbiApplicationAPI::x_HonorStandardSettings(IRegistry* reg)
     // [NCBI.MEMORY_FILL]
     CObject::SetAllocFillMode(reg->Get("NCBI", "MEMORY_FILL"));
 
+    // [NCBI.OBJECT_ALLOCATOR]
+    CObject::SetAllocatorMode(reg->Get("NCBI", "OBJECT_ALLOCATOR"));
+
     {{
         CSysLog* syslog = dynamic_cast<CSysLog*>(GetDiagHandler());
         if (syslog) {
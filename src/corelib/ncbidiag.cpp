@@ -7234,17 +7234,111 @@ void CFileDiagHandler::WriteMessage(const char*   buf,
 }
 
 
+/// Slot of the asynchronous diagnostics ring. It points to a heap copy
+/// of the message made together with its context data (client, session,
+/// time etc.), so that composing it can be deferred to the writer thread.
+/// The copy is deleted by the writer thread.
 struct SAsyncDiagMessage
 {
     SAsyncDiagMessage(void)
-        : m_Message(nullptr), m_Composed(nullptr), m_FileType(eDiagFile_All) {}
+        : m_Seq(0), m_Message(nullptr) {}
 
-    SDiagMessage* m_Message;
-    string*       m_Composed;
-    EDiagFileType m_FileType;
+    atomic<size_t> m_Seq;
+    SDiagMessage*  m_Message;
 };
 
 
+/// Bounded lock-free ring of message slots with many producers (posting
+/// threads) and a single consumer (writer thread). The slots are allocated
+/// once, but each posted message is still copied to the heap because
+/// copying SDiagMessage always allocates its context data.
+/// Each slot carries a sequence number telling whether it is free for
+/// the producer owning position 'pos' (seq == pos) or filled and ready
+/// for the consumer (seq == pos + 1).
+class CAsyncDiagRing
+{
+public:
+    CAsyncDiagRing(size_t capacity);
+
+    /// Try to put the message into the ring, return false if it is full.
+    bool Push(SDiagMessage* msg);
+    /// Get the next message or NULL if there is none ready.
+    /// Must be called from the writer thread only.
+    SDiagMessage* Pop(void);
+
+    size_t GetCapacity(void) const { return m_Mask + 1; }
+
+private:
+    CAsyncDiagRing(const CAsyncDiagRing&);
+    CAsyncDiagRing& operator=(const CAsyncDiagRing&);
+
+    size_t                       m_Mask;
+    unique_ptr<SAsyncDiagMessage[]> m_Slots;
+    // Keep producer and consumer positions on different cache lines.
+    alignas(64) atomic<size_t>   m_Tail;
+    alignas(64) size_t           m_Head;
+};
+
+
+CAsyncDiagRing::CAsyncDiagRing(size_t capacity)
+    : m_Mask(0), m_Tail(0), m_Head(0)
+{
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_Mask = size - 1;
+    m_Slots.reset(new SAsyncDiagMessage[size]);
+    for (size_t i = 0; i < size; ++i) {
+        m_Slots[i].m_Seq.store(i, memory_order_relaxed);
+    }
+}
+
+
+bool CAsyncDiagRing::Push(SDiagMessage* msg)
+{
+    SAsyncDiagMessage* slot;
+    size_t pos = m_Tail.load(memory_order_relaxed);
+    for (;;) {
+        slot = &m_Slots[pos & m_Mask];
+        size_t seq = slot->m_Seq.load(memory_order_acquire);
+        intptr_t diff = intptr_t(seq) - intptr_t(pos);
+        if (diff == 0) {
+            if (m_Tail.compare_exchange_weak(pos, pos + 1,
+                                             memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The slot has not been consumed yet - the ring is full.
+            return false;
+        }
+        else {
+            pos = m_Tail.load(memory_order_relaxed);
+        }
+    }
+    slot->m_Message = msg;
+    slot->m_Seq.store(pos + 1, memory_order_release);
+    return true;
+}
+
+
+SDiagMessage* CAsyncDiagRing::Pop(void)
+{
+    SAsyncDiagMessage& slot = m_Slots[m_Head & m_Mask];
+    if (slot.m_Seq.load(memory_order_acquire) != m_Head + 1) {
+        return nullptr;
+    }
+    SDiagMessage* msg = slot.m_Message;
+    slot.m_Message = nullptr;
+    slot.m_Seq.store(m_Head + m_Mask + 1, memory_order_release);
+    ++m_Head;
+    return msg;
+}
+
+
+struct SMessageBuffer;
+
 class CAsyncDiagThread : public CThread
 {
 public:
@@ -7254,10 +7348,15 @@ public:
     virtual void* Main(void);
     void Stop(void);
 
+    /// Queue the message according to the overflow policy.
+    void Enqueue(SDiagMessage* msg);
+
     bool m_NeedStop;
-    Uint2 m_CntWaiters;
-    CAtomicCounter m_MsgsInQueue;
+    atomic<int> m_CntWaiters;
+    atomic<intptr_t> m_MsgsInQueue;
+    atomic<Uint8> m_Dropped;
     CDiagHandler* m_SubHandler;
+    bool m_OwnSubHandler;
     CFastMutex m_QueueLock;
 #ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
     CConditionVariable m_QueueCond;
@@ -7266,17 +7365,49 @@ public:
     CSemaphore m_QueueSem;
     CSemaphore m_DequeueSem;
 #endif
-    deque<SAsyncDiagMessage> m_MsgQueue;
+    CAsyncDiagRing m_Ring;
+    CAsyncDiagHandler::EOverflowPolicy m_OverflowPolicy;
+    Uint4 m_SampleRate;
+    atomic<Uint4> m_SampleCounter;
     string m_ThreadSuffix;
+
+private:
+    bool x_Drain(SMessageBuffer** buffers, int batch_size);
+    void x_Write(const SDiagMessage& msg, SMessageBuffer** buffers);
+    void x_WakeWaiters(void);
+    void x_ReportDropped(void);
+
+    Uint8 m_ReportedDropped;
 };
 
 
 /// Maximum number of messages that allowed to be in the queue for
-/// asynchronous processing.
+/// asynchronous processing (rounded up to a power of 2).
 NCBI_PARAM_DECL(Uint4, Diag, Max_Async_Queue_Size);
 NCBI_PARAM_DEF_EX(Uint4, Diag, Max_Async_Queue_Size, 10000, eParam_NoThread,
                   DIAG_MAX_ASYNC_QUEUE_SIZE);
 
+/// What to do with new messages when the asynchronous queue is full.
+NCBI_PARAM_ENUM_DECL(CAsyncDiagHandler::EOverflowPolicy,
+                     Diag, Async_Overflow_Policy);
+NCBI_PARAM_ENUM_ARRAY(CAsyncDiagHandler::EOverflowPolicy,
+                      Diag, Async_Overflow_Policy)
+{
+    {"Block",  CAsyncDiagHandler::eOverflow_Block},
+    {"Drop",   CAsyncDiagHandler::eOverflow_Drop},
+    {"Sample", CAsyncDiagHandler::eOverflow_Sample}
+};
+NCBI_PARAM_ENUM_DEF_EX(CAsyncDiagHandler::EOverflowPolicy,
+                       Diag, Async_Overflow_Policy,
+                       CAsyncDiagHandler::eOverflow_Block,
+                       eParam_NoThread, DIAG_ASYNC_OVERFLOW_POLICY);
+
+/// With 'Sample' overflow policy, keep one of this many low severity
+/// messages while the queue is more than 3/4 full.
+NCBI_PARAM_DECL(Uint4, Diag, Async_Sample_Rate);
+NCBI_PARAM_DEF_EX(Uint4, Diag, Async_Sample_Rate, 10, eParam_NoThread,
+                  DIAG_ASYNC_SAMPLE_RATE);
+
 
 CAsyncDiagHandler::CAsyncDiagHandler(void)
     : m_AsyncThread(NULL)
@@ -7295,6 +7426,12 @@ CAsyncDiagHandler::SetCustomThreadSuffix(const string& suffix)
 
 void
 CAsyncDiagHandler::InstallToDiag(void)
+{
+    Install();
+}
+
+void
+CAsyncDiagHandler::Install(void)
 {
     m_AsyncThread = new CAsyncDiagThread(m_ThreadSuffix);
     m_AsyncThread->AddReference();
@@ -7306,7 +7443,12 @@ CAsyncDiagHandler::InstallToDiag(void)
         m_AsyncThread = NULL;
         throw;
     }
-    m_AsyncThread->m_SubHandler = GetDiagHandler(true);
+    bool own = false;
+    m_AsyncThread->m_SubHandler = GetDiagHandler(false, &own);
+    if ( own ) {
+        GetDiagHandler(true);
+    }
+    m_AsyncThread->m_OwnSubHandler = own;
     SetDiagHandler(this, false);
 }
 
@@ -7317,7 +7459,8 @@ CAsyncDiagHandler::RemoveFromDiag(void)
         return;
 
     _ASSERT(GetDiagHandler(false) == this);
-    SetDiagHandler(m_AsyncThread->m_SubHandler);
+    SetDiagHandler(m_AsyncThread->m_SubHandler,
+                   m_AsyncThread->m_OwnSubHandler);
     m_AsyncThread->Stop();
     m_AsyncThread->RemoveReference();
     m_AsyncThread = NULL;
@@ -7335,48 +7478,23 @@ CAsyncDiagHandler::Reopen(TReopenFlags flags)
     m_AsyncThread->m_SubHandler->Reopen(flags);
 }
 
+Uint8
+CAsyncDiagHandler::GetDroppedCount(void) const
+{
+    return m_AsyncThread ? m_AsyncThread->m_Dropped.load() : 0;
+}
+
 void
 CAsyncDiagHandler::Post(const SDiagMessage& mess)
 {
     CAsyncDiagThread* thr = m_AsyncThread;
-    SAsyncDiagMessage async;
-    if (thr->m_SubHandler->AllowAsyncWrite(mess)) {
-        async.m_Composed = new string(thr->m_SubHandler->
-            ComposeMessage(mess, &async.m_FileType));
-    }
-    else {
-        async.m_Message = new SDiagMessage(mess);
-    }
-
-    static CSafeStatic<NCBI_PARAM_TYPE(Diag, Max_Async_Queue_Size)> s_MaxAsyncQueueSizeParam;
     if (mess.m_Severity < GetDiagDieLevel()) {
-        CFastMutexGuard guard(thr->m_QueueLock);
-        while (Uint4(thr->m_MsgsInQueue.Get()) >= s_MaxAsyncQueueSizeParam->Get())
-        {
-            ++thr->m_CntWaiters;
-#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
-            thr->m_DequeueCond.WaitForSignal(thr->m_QueueLock);
-#else
-            guard.Release();
-            thr->m_QueueSem.Wait();
-            guard.Guard(thr->m_QueueLock);
-#endif
-            --thr->m_CntWaiters;
-        }
-        thr->m_MsgQueue.push_back(async);
-        if (thr->m_MsgsInQueue.Add(1) == 1) {
-#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
-            thr->m_QueueCond.SignalSome();
-#else
-            thr->m_QueueSem.Post();
-#endif
-        }
+        // Only copy the message here, it's composed by the writer thread.
+        thr->Enqueue(new SDiagMessage(mess));
     }
     else {
         thr->Stop();
         thr->m_SubHandler->Post(mess);
-        if (async.m_Composed) delete async.m_Composed;
-        if (async.m_Message) delete async.m_Message;
     }
 }
 
@@ -7384,18 +7502,83 @@ CAsyncDiagHandler::Post(const SDiagMessage& mess)
 CAsyncDiagThread::CAsyncDiagThread(const string& thread_suffix)
     : m_NeedStop(false),
       m_CntWaiters(0),
+      m_MsgsInQueue(0),
+      m_Dropped(0),
       m_SubHandler(NULL),
+      m_OwnSubHandler(false),
 #ifndef NCBI_HAVE_CONDITIONAL_VARIABLE
       m_QueueSem(0, 100),
       m_DequeueSem(0, 10000000),
 #endif
-      m_ThreadSuffix(thread_suffix)
+      m_Ring(NCBI_PARAM_TYPE(Diag, Max_Async_Queue_Size)::GetDefault()),
+      m_OverflowPolicy(
+          NCBI_PARAM_TYPE(Diag, Async_Overflow_Policy)::GetDefault()),
+      m_SampleRate(NCBI_PARAM_TYPE(Diag, Async_Sample_Rate)::GetDefault()),
+      m_SampleCounter(0),
+      m_ThreadSuffix(thread_suffix),
+      m_ReportedDropped(0)
 {
-    m_MsgsInQueue.Set(0);
 }
 
 CAsyncDiagThread::~CAsyncDiagThread(void)
-{}
+{
+    // Messages posted after the thread has been stopped.
+    while (SDiagMessage* msg = m_Ring.Pop()) {
+        delete msg;
+    }
+}
+
+
+void
+CAsyncDiagThread::Enqueue(SDiagMessage* msg)
+{
+    // Applog events and warnings are never dropped by the sampling policy.
+    bool may_drop = m_OverflowPolicy == CAsyncDiagHandler::eOverflow_Drop  ||
+        (m_OverflowPolicy == CAsyncDiagHandler::eOverflow_Sample  &&
+         msg->m_Severity < eDiag_Warning  &&
+         !IsSetDiagPostFlag(eDPF_AppLog, msg->m_Flags));
+    if (may_drop  &&
+        m_OverflowPolicy == CAsyncDiagHandler::eOverflow_Sample  &&
+        m_MsgsInQueue.load() >= intptr_t(m_Ring.GetCapacity() / 4 * 3)  &&
+        m_SampleRate > 1  &&
+        m_SampleCounter.fetch_add(1, memory_order_relaxed) % m_SampleRate != 0) {
+        ++m_Dropped;
+        delete msg;
+        return;
+    }
+
+    if ( !m_Ring.Push(msg) ) {
+        if ( may_drop ) {
+            ++m_Dropped;
+            delete msg;
+            return;
+        }
+        CFastMutexGuard guard(m_QueueLock);
+        ++m_CntWaiters;
+        while ( !m_Ring.Push(msg) ) {
+            // Timed wait protects against a wakeup issued between
+            // the failed push and the wait.
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+            m_DequeueCond.WaitForSignal(m_QueueLock, CDeadline(0, 100000000));
+#else
+            guard.Release();
+            m_DequeueSem.TryWait(0, 100000000);
+            guard.Guard(m_QueueLock);
+#endif
+        }
+        --m_CntWaiters;
+    }
+    // The message is already in the ring, so the counter may be behind
+    // the ring contents but never ahead of it.
+    if (++m_MsgsInQueue == 1) {
+        CFastMutexGuard guard(m_QueueLock);
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+        m_QueueCond.SignalSome();
+#else
+        m_QueueSem.Post();
+#endif
+    }
+}
 
 
 NCBI_PARAM_DECL(size_t, Diag, Async_Buffer_Size);
@@ -7463,6 +7646,93 @@ NCBI_PARAM_DEF_EX(int, Diag, Async_Batch_Size, 10, eParam_NoThread,
                   DIAG_ASYNC_BATCH_SIZE);
 
 
+void
+CAsyncDiagThread::x_WakeWaiters(void)
+{
+    if (m_CntWaiters.load() != 0) {
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+        CFastMutexGuard guard(m_QueueLock);
+        m_DequeueCond.SignalAll();
+#else
+        m_DequeueSem.Post();
+#endif
+    }
+}
+
+
+void
+CAsyncDiagThread::x_Write(const SDiagMessage& msg, SMessageBuffer** buffers)
+{
+    if ( !m_SubHandler->AllowAsyncWrite(msg) ) {
+        m_SubHandler->Post(msg);
+        return;
+    }
+    EDiagFileType file_type = eDiagFile_All;
+    string composed = m_SubHandler->ComposeMessage(msg, &file_type);
+    SMessageBuffer* buf = buffers[file_type];
+    if ( !buf ) {
+        buf = new SMessageBuffer;
+        buffers[file_type] = buf;
+    }
+    if ( !buf->size ) {
+        // Do not use buffering.
+        m_SubHandler->WriteMessage(composed.data(), composed.size(), file_type);
+    }
+    else if ( !buf->Append(composed) ) {
+        // Not enough space in the buffer or no waiters,
+        // try to flush if not empty.
+        if ( !buf->IsEmpty() ) {
+            m_SubHandler->WriteMessage(buf->data, buf->pos, file_type);
+            buf->Clear();
+        }
+        if ( !buf->Append(composed) ) {
+            // The message is too long to fit in the buffer.
+            m_SubHandler->WriteMessage(composed.data(), composed.size(),
+                file_type);
+        }
+    }
+}
+
+
+bool
+CAsyncDiagThread::x_Drain(SMessageBuffer** buffers, int batch_size)
+{
+    bool done = false;
+    int queue_counter = 0;
+    while (SDiagMessage* msg = m_Ring.Pop()) {
+        done = true;
+        x_Write(*msg, buffers);
+        delete msg;
+        if (++queue_counter >= batch_size) {
+            m_MsgsInQueue -= queue_counter;
+            queue_counter = 0;
+            x_WakeWaiters();
+        }
+    }
+    if (queue_counter != 0) {
+        m_MsgsInQueue -= queue_counter;
+        x_WakeWaiters();
+    }
+    return done;
+}
+
+
+void
+CAsyncDiagThread::x_ReportDropped(void)
+{
+    Uint8 dropped = m_Dropped.load();
+    if (dropped == m_ReportedDropped) {
+        return;
+    }
+    string text = "Asynchronous diagnostics queue overflow: " +
+        NStr::UInt8ToString(dropped - m_ReportedDropped) +
+        " message(s) dropped";
+    m_ReportedDropped = dropped;
+    SDiagMessage msg(eDiag_Warning, text.data(), text.size());
+    m_SubHandler->Post(msg);
+}
+
+
 void*
 CAsyncDiagThread::Main(void)
 {
@@ -7481,13 +7751,10 @@ CAsyncDiagThread::Main(void)
         buffers[i] = 0;
     }
 
-    deque<SAsyncDiagMessage> save_msgs;
     while (!m_NeedStop) {
         {{
             CFastMutexGuard guard(m_QueueLock);
-            while (m_MsgQueue.size() == 0  &&  !m_NeedStop) {
-                if (m_MsgsInQueue.Get() != 0)
-                    abort();
+            while (m_MsgsInQueue.load() <= 0  &&  !m_NeedStop) {
 #ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
                 m_QueueCond.WaitForSignal(m_QueueLock);
 #else
@@ -7496,59 +7763,16 @@ CAsyncDiagThread::Main(void)
                 guard.Guard(m_QueueLock);
 #endif
             }
-            save_msgs.swap(m_MsgQueue);
         }}
 
-drain_messages:
-        int queue_counter = 0;
-        while (!save_msgs.empty()) {
-            SAsyncDiagMessage msg = save_msgs.front();
-            save_msgs.pop_front();
-            if ( msg.m_Composed ) {
-                SMessageBuffer* buf = buffers[msg.m_FileType];
-                if ( !buf ) {
-                    buf = new SMessageBuffer;
-                    buffers[msg.m_FileType] = buf;
-                }
-                if ( !buf->size ) {
-                    // Do not use buffering.
-                    m_SubHandler->WriteMessage(msg.m_Composed->data(),
-                        msg.m_Composed->size(), msg.m_FileType);
-                }
-                else if ( !buf->Append(*msg.m_Composed) ) {
-                    // Not enough space in the buffer or no waiters,
-                    // try to flush if not empty.
-                    if ( !buf->IsEmpty() ) {
-                        m_SubHandler->WriteMessage(buf->data, buf->pos, msg.m_FileType);
-                        buf->Clear();
-                    }
-                    if ( !buf->Append(*msg.m_Composed) ) {
-                        // The message is too long to fit in the buffer.
-                        m_SubHandler->WriteMessage(msg.m_Composed->data(),
-                            msg.m_Composed->size(), msg.m_FileType);
-                    }
-                }
-                delete msg.m_Composed;
-            }
-            else {
-                _ASSERT(msg.m_Message);
-                m_SubHandler->Post(*msg.m_Message);
-                delete msg.m_Message;
-            }
-            if (++queue_counter >= batch_size  ||  save_msgs.empty()) {
-                m_MsgsInQueue.Add(-queue_counter);
-                queue_counter = 0;
-                if (m_CntWaiters != 0) {
-#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
-                    m_DequeueCond.SignalSome();
-#else
-                    m_DequeueSem.Post();
-#endif
-                }
-            }
+        if ( !x_Drain(buffers, batch_size) ) {
+            // A producer has claimed a slot but not filled it yet.
+            NCBI_SCHED_YIELD();
+            continue;
         }
+        x_ReportDropped();
         // Flush all buffers when the queue is empty and there are no waiters.
-        if (m_CntWaiters == 0) {
+        if (m_CntWaiters.load() == 0) {
             for (size_t i = 0; i < buf_count; ++i) {
                 if ( !buffers[i] ) {
                     continue;
@@ -7561,10 +7785,8 @@ drain_messages:
             }
         }
     }
-    if (m_MsgQueue.size() != 0) {
-        save_msgs.swap(m_MsgQueue);
-        goto drain_messages;
-    }
+    x_Drain(buffers, batch_size);
+    x_ReportDropped();
 
     for (size_t i = 0; i < buf_count; ++i) {
         if ( !buffers[i] ) {
@@ -7585,11 +7807,14 @@ CAsyncDiagThread::Stop(void)
 {
     m_NeedStop = true;
     try {
+        {{
+            CFastMutexGuard guard(m_QueueLock);
 #ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
-        m_QueueCond.SignalAll();
+            m_QueueCond.SignalAll();
 #else
-        m_QueueSem.Post(10);
+            m_QueueSem.Post(10);
 #endif
+        }}
         Join();
     }
     catch (const CException& ex) {
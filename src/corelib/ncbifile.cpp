@@ -36,7 +36,9 @@
 #include <corelib/ncbi_safe_static.hpp>
 #include <corelib/error_codes.hpp>
 #include <corelib/ncbierror.hpp>
+#include <corelib/ncbithr.hpp>
 #include <atomic>
+#include <deque>
 #include <stdio.h>
 
 #if defined(NCBI_OS_MSWIN)
@@ -6224,6 +6226,384 @@ const char* CFileErrnoException::GetErrCodeString(void) const
 
 
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// CDirWalker
+//
+
+// Declare the default number of threads used by CDirWalker.
+// Registry file:
+//     [NCBI]
+//     DirWalkerThreads = <number>
+// Environment variable:
+//     NCBI_CONFIG__DIRWALKERTHREADS
+//
+NCBI_PARAM_DECL(unsigned int, NCBI, DirWalkerThreads);
+NCBI_PARAM_DEF_EX(unsigned int, NCBI, DirWalkerThreads, 1,
+    eParam_NoThread, NCBI_CONFIG__DIRWALKERTHREADS);
+
+
+CDirEntry::EType CDirWalker::CEntry::GetType(void) const
+{
+    if (m_Type == CDirEntry::eUnknown) {
+        m_Type = CDirEntry(m_Path).GetType(eFollowLinks);
+    }
+    return m_Type;
+}
+
+
+// Directory entry read from the directory listing
+struct SDirWalkName
+{
+    string           name;
+    CDirEntry::EType type;  // eUnknown if not known without stat()
+};
+
+// Directory waiting to be read by one of the walker threads
+struct SDirWalkTask
+{
+    string       path;
+    unsigned int depth;
+};
+
+
+class CDirWalkerImpl
+{
+public:
+    CDirWalkerImpl(TFindFiles                    flags,
+                   const CMask&                  masks,
+                   const CMask&                  masks_subdir,
+                   const CDirWalker::TCallback&  callback)
+        : m_Flags(flags),
+          m_UseCase((flags & fFF_Nocase) ? NStr::eNocase : NStr::eCase),
+          m_Masks(masks),
+          m_MasksSubdir(masks_subdir),
+          m_Callback(callback),
+          m_Parallel(false),
+          m_Busy(0),
+          m_Stop(false),
+          m_Stopped(false)
+    {}
+
+    // Depth-first traversal in the calling thread.
+    void WalkDir(const string& path, unsigned int depth);
+    // Breadth-first traversal, run by each of the walker threads.
+    void StartParallel(const string& path);
+    void RunWorker(void);
+
+    bool IsStopped(void) const { return m_Stopped; }
+    void RethrowException(void)
+    {
+        if (m_Exception) {
+            rethrow_exception(m_Exception);
+        }
+    }
+
+private:
+    bool x_ReadDir(const string& path, vector<SDirWalkName>& names) const;
+    // Report entries of the directory, return its subdirectories
+    // to descend into.
+    void x_ProcessDir(const string& path, unsigned int depth,
+                      vector<SDirWalkTask>& subdirs);
+    CDirWalker::EAction x_Call(const CDirWalker::CEntry& entry);
+
+    TFindFiles                    m_Flags;
+    NStr::ECase                   m_UseCase;
+    const CMask&                  m_Masks;
+    const CMask&                  m_MasksSubdir;
+    const CDirWalker::TCallback&  m_Callback;
+    bool                          m_Parallel;
+
+    // Parallel traversal state
+    CFastMutex                    m_QueueMutex;
+    CConditionVariable            m_QueueCond;
+    deque<SDirWalkTask>           m_Queue;
+    unsigned int                  m_Busy;
+    CFastMutex                    m_CallbackMutex;
+    exception_ptr                 m_Exception;
+    atomic<bool>                  m_Stop;     // stop all threads
+    atomic<bool>                  m_Stopped;  // stopped by callback
+};
+
+
+bool CDirWalkerImpl::x_ReadDir(const string& path,
+                               vector<SDirWalkName>& names) const
+{
+    bool recursive = (m_Flags & fFF_Recursive) != 0;
+    SDirWalkName item;
+
+#if defined(NCBI_OS_MSWIN)
+
+    string pattern = CDirEntry::AddTrailingPathSeparator(
+        path.empty() ? DIR_CURRENT : path) + "*";
+    WIN32_FIND_DATA entry;
+    HANDLE handle = ::FindFirstFile(_T_XCSTRING(pattern), &entry);
+    if (handle == INVALID_HANDLE_VALUE) {
+        CNcbiError::SetFromWindowsError();
+        return false;
+    }
+    do {
+        string name = _T_CSTRING(entry.cFileName);
+        if (name == "."  ||  name == "..") {
+            continue;
+        }
+        if ( !m_Masks.Match(name, m_UseCase)  &&
+             !(recursive  &&  m_MasksSubdir.Match(name, m_UseCase)) ) {
+            continue;
+        }
+        if (entry.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            item.type = CDirEntry::eUnknown;
+        } else if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            item.type = CDirEntry::eDir;
+        } else {
+            item.type = CDirEntry::eFile;
+        }
+        item.name.swap(name);
+        names.push_back(item);
+    } while ( ::FindNextFile(handle, &entry) );
+    ::FindClose(handle);
+
+#elif defined(NCBI_OS_UNIX)
+
+    DIR* dir = opendir(path.empty() ? DIR_CURRENT : path.c_str());
+    if ( !dir ) {
+        CNcbiError::SetFromErrno();
+        return false;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (::strcmp(name, ".") == 0  ||  ::strcmp(name, "..") == 0) {
+            continue;
+        }
+        if ( !m_Masks.Match(name, m_UseCase)  &&
+             !(recursive  &&  m_MasksSubdir.Match(name, m_UseCase)) ) {
+            continue;
+        }
+        item.type = CDirEntry::eUnknown;
+#  if defined(_DIRENT_HAVE_D_TYPE)
+        // Symbolic links are resolved later, if necessary
+        if (entry->d_type  &&  entry->d_type != DT_LNK) {
+            struct stat st;
+            st.st_mode = DTTOIF(entry->d_type);
+            item.type = CDirEntry::GetType(st);
+        }
+#  endif
+        item.name = name;
+        names.push_back(item);
+    }
+    closedir(dir);
+
+#endif
+
+    return true;
+}
+
+
+CDirWalker::EAction CDirWalkerImpl::x_Call(const CDirWalker::CEntry& entry)
+{
+    if ( !m_Parallel ) {
+        return m_Callback(entry);
+    }
+    CFastMutexGuard guard(m_CallbackMutex);
+    if (m_Stop) {
+        return CDirWalker::eStop;
+    }
+    return m_Callback(entry);
+}
+
+
+void CDirWalkerImpl::x_ProcessDir(const string&         path,
+                                  unsigned int          depth,
+                                  vector<SDirWalkTask>& subdirs)
+{
+    // Read the whole directory first, so no directory handles stay open
+    // while the callback runs or the walker descends into subdirectories.
+    vector<SDirWalkName> names;
+    if ( !x_ReadDir(path, names) ) {
+        return;
+    }
+    TFindFiles find_type = m_Flags & fFF_All;
+    bool recursive = (m_Flags & fFF_Recursive) != 0;
+
+    CDirWalker::CEntry entry;
+    entry.m_Depth = depth;
+    if ( !path.empty() ) {
+        entry.m_Path = CDirEntry::AddTrailingPathSeparator(path);
+    }
+    entry.m_NamePos = entry.m_Path.size();
+
+    for (auto& item : names) {
+        if (m_Stop) {
+            return;
+        }
+        entry.m_Path.replace(entry.m_NamePos, NPOS, item.name);
+        entry.m_Type = item.type;
+
+        CDirWalker::EAction action = CDirWalker::eContinue;
+        if ( m_Masks.Match(item.name, m_UseCase) ) {
+            TFindFiles entry_type = find_type;
+            if (find_type != fFF_All) {
+                // need to check actual entry type
+                entry_type = entry.GetType() == CDirEntry::eDir ?
+                    fFF_Dir : fFF_File;
+            }
+            if ( (entry_type & find_type) != 0 ) {
+                action = x_Call(entry);
+            }
+        }
+        if (action == CDirWalker::eStop) {
+            m_Stopped = true;
+            m_Stop = true;
+            return;
+        }
+        if ( recursive  &&  action != CDirWalker::eSkipDir  &&
+             m_MasksSubdir.Match(item.name, m_UseCase)  &&
+             entry.GetType() == CDirEntry::eDir ) {
+            if (m_Parallel) {
+                subdirs.push_back(SDirWalkTask{ entry.m_Path, depth + 1 });
+            } else {
+                WalkDir(entry.m_Path, depth + 1);
+            }
+        }
+    }
+}
+
+
+void CDirWalkerImpl::WalkDir(const string& path, unsigned int depth)
+{
+    vector<SDirWalkTask> subdirs;
+    x_ProcessDir(path, depth, subdirs);
+}
+
+
+void CDirWalkerImpl::StartParallel(const string& path)
+{
+    m_Parallel = true;
+    m_Queue.push_back(SDirWalkTask{ path, 0 });
+}
+
+
+void CDirWalkerImpl::RunWorker(void)
+{
+    vector<SDirWalkTask> subdirs;
+    for (;;) {
+        SDirWalkTask task;
+        {{
+            CFastMutexGuard guard(m_QueueMutex);
+            while (m_Queue.empty()  &&  m_Busy  &&  !m_Stop) {
+                m_QueueCond.WaitForSignal(m_QueueMutex);
+            }
+            if (m_Stop  ||  m_Queue.empty()) {
+                // Done, wake up other threads to let them finish too
+                m_QueueCond.SignalAll();
+                return;
+            }
+            task = std::move(m_Queue.front());
+            m_Queue.pop_front();
+            ++m_Busy;
+        }}
+        subdirs.clear();
+        try {
+            x_ProcessDir(task.path, task.depth, subdirs);
+        }
+        catch (...) {
+            CFastMutexGuard guard(m_QueueMutex);
+            if ( !m_Exception ) {
+                m_Exception = current_exception();
+            }
+            m_Stop = true;
+        }
+        {{
+            CFastMutexGuard guard(m_QueueMutex);
+            --m_Busy;
+            for (auto& subdir : subdirs) {
+                m_Queue.push_back(std::move(subdir));
+            }
+        }}
+        m_QueueCond.SignalAll();
+    }
+}
+
+
+#if defined(NCBI_THREADS)
+class CDirWalkerThread : public CThread
+{
+public:
+    CDirWalkerThread(CDirWalkerImpl& impl) : m_Impl(impl) {}
+protected:
+    virtual void* Main(void)
+    {
+        m_Impl.RunWorker();
+        return NULL;
+    }
+private:
+    CDirWalkerImpl& m_Impl;
+};
+#endif
+
+
+CDirWalker::CDirWalker(TFindFiles flags, unsigned int threads)
+    : m_Flags(flags),
+      m_Threads(threads)
+{
+    if ( (m_Flags & fFF_All) == 0 ) {
+        m_Flags |= fFF_All;
+    }
+    if ( !m_Threads ) {
+        m_Threads = NCBI_PARAM_TYPE(NCBI, DirWalkerThreads)::GetDefault();
+    }
+#if !defined(NCBI_THREADS)
+    m_Threads = 1;
+#endif
+    if ( !m_Threads ) {
+        m_Threads = 1;
+    }
+}
+
+
+bool CDirWalker::Walk(const string&    dir,
+                      const CMask&     masks,
+                      const TCallback& callback)
+{
+    return Walk(dir, masks, masks, callback);
+}
+
+
+bool CDirWalker::Walk(const string&    dir,
+                      const CMask&     masks,
+                      const CMask&     masks_subdir,
+                      const TCallback& callback)
+{
+    CDirWalkerImpl impl(m_Flags, masks, masks_subdir, callback);
+    if (m_Threads <= 1) {
+        impl.WalkDir(dir, 0);
+        return !impl.IsStopped();
+    }
+#if defined(NCBI_THREADS)
+    impl.StartParallel(dir);
+    vector< CRef<CThread> > threads;
+    for (unsigned int i = 1;  i < m_Threads;  ++i) {
+        CRef<CThread> thr(new CDirWalkerThread(impl));
+        try {
+            thr->Run();
+        }
+        catch (CThreadException&) {
+            // Continue with threads started so far
+            break;
+        }
+        threads.push_back(thr);
+    }
+    impl.RunWorker();
+    for (auto& thr : threads) {
+        thr->Join();
+    }
+    impl.RethrowException();
+#endif
+    return !impl.IsStopped();
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Find files
@@ -2094,6 +2094,71 @@ CFastRWLock::WriteUnlock(void)
 }
 
 
+static unsigned int s_GetReaderSlot(void)
+{
+    static atomic<unsigned int> s_NextSlot(0);
+    thread_local unsigned int s_Slot =
+        s_NextSlot++ % CReadBiasedRWLock::kReaderSlots;
+    return s_Slot;
+}
+
+
+CReadBiasedRWLock::CReadBiasedRWLock(void)
+    : m_WriterActive(false)
+{
+    for (size_t i = 0; i < kReaderSlots; ++i) {
+        m_Readers[i].m_Count.store(0, memory_order_relaxed);
+    }
+}
+
+CReadBiasedRWLock::~CReadBiasedRWLock(void)
+{
+}
+
+void
+CReadBiasedRWLock::ReadLock(void)
+{
+    atomic<int>& slot = m_Readers[s_GetReaderSlot()].m_Count;
+    for (;;) {
+        // The increment must be visible to a writer before the flag check,
+        // hence sequential consistency on both sides.
+        slot.fetch_add(1, memory_order_seq_cst);
+        if ( !m_WriterActive.load(memory_order_seq_cst) ) {
+            return;
+        }
+        slot.fetch_sub(1, memory_order_seq_cst);
+        // Wait for the writer to finish.
+        m_WriteLock.Lock();
+        m_WriteLock.Unlock();
+    }
+}
+
+void
+CReadBiasedRWLock::ReadUnlock(void)
+{
+    m_Readers[s_GetReaderSlot()].m_Count.fetch_sub(1, memory_order_release);
+}
+
+void
+CReadBiasedRWLock::WriteLock(void)
+{
+    m_WriteLock.Lock();
+    m_WriterActive.store(true, memory_order_seq_cst);
+    for (size_t i = 0; i < kReaderSlots; ++i) {
+        while (m_Readers[i].m_Count.load(memory_order_seq_cst) != 0) {
+            NCBI_SCHED_YIELD();
+        }
+    }
+}
+
+void
+CReadBiasedRWLock::WriteUnlock(void)
+{
+    m_WriterActive.store(false, memory_order_seq_cst);
+    m_WriteLock.Unlock();
+}
+
+
 IRWLockHolder_Listener::~IRWLockHolder_Listener(void)
 {}
 
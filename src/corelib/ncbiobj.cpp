@@ -468,6 +468,334 @@ static inline void sx_FillNewMemory(void* ptr, size_t size)
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Thread-caching allocator for CObject heap objects
+//
+// Objects up to kTC_MaxSize bytes are carved from kTC_SlabSize-aligned
+// slabs, each slab holding blocks of a single size class. The size class
+// of a pointer is found through a two-level radix map of slabs, so blocks
+// need no header and objects allocated by the global operator new (e.g.
+// while the allocator was off) are recognized and freed by it.
+// Each thread keeps per-class lists of free blocks, moving them to and
+// from the central lists in batches of kTC_Batch blocks.
+
+static const unsigned kTC_SlabShift = 20;
+static const size_t   kTC_SlabSize  = size_t(1) << kTC_SlabShift;
+static const size_t   kTC_MaxSize   = 1024;
+// 16-byte classes up to 256 bytes, 64-byte classes up to kTC_MaxSize.
+static const unsigned kTC_ClassCount = 16 + (kTC_MaxSize - 256) / 64;
+static const unsigned kTC_Batch = 32;
+// Radix map of slabs: kTC_MapBits of address above the slab offset.
+static const unsigned kTC_AddrBits = sizeof(void*) == 8 ? 48 : 32;
+static const unsigned kTC_MapBits = kTC_AddrBits - kTC_SlabShift;
+static const unsigned kTC_LeafBits = kTC_MapBits / 2;
+static const unsigned kTC_RootBits = kTC_MapBits - kTC_LeafBits;
+
+static inline unsigned sx_TCSizeClass(size_t size)
+{
+    return size <= 256 ? unsigned((size + 15) / 16) :
+        unsigned(16 + (size - 256 + 63) / 64);
+}
+
+static inline size_t sx_TCClassSize(unsigned cls)
+{
+    return cls <= 16 ? cls * 16 : 256 + (cls - 16) * 64;
+}
+
+// Size class of each slab, 0 for memory not owned by the allocator.
+static atomic<Uint1*> sx_TCSlabMap[size_t(1) << kTC_RootBits];
+
+static inline unsigned sx_TCLookup(const void* ptr)
+{
+    uintptr_t slab = uintptr_t(ptr) >> kTC_SlabShift;
+    if ( slab >> kTC_MapBits ) {
+        return 0;
+    }
+    Uint1* leaf = sx_TCSlabMap[slab >> kTC_LeafBits].load(memory_order_acquire);
+    return leaf ? leaf[slab & ((uintptr_t(1) << kTC_LeafBits) - 1)] : 0;
+}
+
+struct STCFreeList
+{
+    void*    m_Head;
+    unsigned m_Count;
+
+    void Push(void* ptr)
+    {
+        *static_cast<void**>(ptr) = m_Head;
+        m_Head = ptr;
+        ++m_Count;
+    }
+    void* Pop(void)
+    {
+        void* ptr = m_Head;
+        m_Head = *static_cast<void**>(ptr);
+        --m_Count;
+        return ptr;
+    }
+};
+
+// Central part, guarded by sx_TCCentralMutex.
+struct STCCentral
+{
+    STCFreeList m_Free[kTC_ClassCount + 1];
+    char*       m_SlabPos[kTC_ClassCount + 1];
+    char*       m_SlabEnd[kTC_ClassCount + 1];
+};
+static STCCentral sx_TCCentral;
+static atomic<Uint8> sx_TCReservedBytes;
+DEFINE_STATIC_FAST_MUTEX(sx_TCCentralMutex);
+
+static void sx_TCFreeSlab(void* slab)
+{
+#if defined(NCBI_OS_MSWIN)
+    _aligned_free(slab);
+#else
+    free(slab);
+#endif
+}
+
+static char* sx_TCNewSlab(unsigned cls)
+{
+    void* slab = 0;
+#if defined(NCBI_OS_MSWIN)
+    slab = _aligned_malloc(kTC_SlabSize, kTC_SlabSize);
+#else
+    if ( posix_memalign(&slab, kTC_SlabSize, kTC_SlabSize) != 0 ) {
+        slab = 0;
+    }
+#endif
+    if ( !slab ) {
+        return 0;
+    }
+    uintptr_t index = uintptr_t(slab) >> kTC_SlabShift;
+    if ( index >> kTC_MapBits ) {
+        // Address outside of the map range, should not happen.
+        sx_TCFreeSlab(slab);
+        return 0;
+    }
+    atomic<Uint1*>& root = sx_TCSlabMap[index >> kTC_LeafBits];
+    Uint1* leaf = root.load(memory_order_acquire);
+    if ( !leaf ) {
+        // Called under sx_TCCentralMutex, so there are no competitors.
+        leaf = static_cast<Uint1*>(calloc(size_t(1) << kTC_LeafBits, 1));
+        if ( !leaf ) {
+            sx_TCFreeSlab(slab);
+            return 0;
+        }
+        root.store(leaf, memory_order_release);
+    }
+    leaf[index & ((uintptr_t(1) << kTC_LeafBits) - 1)] = Uint1(cls);
+    sx_TCReservedBytes += kTC_SlabSize;
+    return static_cast<char*>(slab);
+}
+
+// Move up to 'count' free blocks of the class from central lists into
+// 'list', carving new blocks from the class slab when needed.
+static void sx_TCFetch(unsigned cls, STCFreeList& list, unsigned count)
+{
+    size_t size = sx_TCClassSize(cls);
+    CFastMutexGuard guard(sx_TCCentralMutex);
+    STCFreeList& central = sx_TCCentral.m_Free[cls];
+    while ( count  &&  central.m_Count ) {
+        list.Push(central.Pop());
+        --count;
+    }
+    char*& pos = sx_TCCentral.m_SlabPos[cls];
+    char*& end = sx_TCCentral.m_SlabEnd[cls];
+    while ( count ) {
+        if ( pos + size > end ) {
+            pos = sx_TCNewSlab(cls);
+            if ( !pos ) {
+                end = 0;
+                return;
+            }
+            end = pos + kTC_SlabSize;
+        }
+        list.Push(pos);
+        pos += size;
+        --count;
+    }
+}
+
+// Return 'count' blocks from 'list' to the central lists.
+static void sx_TCRelease(unsigned cls, STCFreeList& list, unsigned count)
+{
+    CFastMutexGuard guard(sx_TCCentralMutex);
+    STCFreeList& central = sx_TCCentral.m_Free[cls];
+    while ( count--  &&  list.m_Count ) {
+        central.Push(list.Pop());
+    }
+}
+
+struct STCThreadCache
+{
+    STCFreeList             m_Free[kTC_ClassCount + 1];
+    CObject::SAllocatorStats m_Stats;
+
+    ~STCThreadCache(void);
+};
+
+enum ETCCacheState {
+    eTCCache_None,
+    eTCCache_Alive,
+    eTCCache_Destroyed
+};
+static thread_local ETCCacheState sx_TCCacheState = eTCCache_None;
+static thread_local STCThreadCache sx_TCCache;
+
+STCThreadCache::~STCThreadCache(void)
+{
+    sx_TCCacheState = eTCCache_Destroyed;
+    for ( unsigned cls = 1; cls <= kTC_ClassCount; ++cls ) {
+        if ( m_Free[cls].m_Count ) {
+            sx_TCRelease(cls, m_Free[cls], m_Free[cls].m_Count);
+        }
+    }
+    m_Stats.m_CachedBytes = 0;
+}
+
+static inline STCThreadCache* sx_TCGetCache(void)
+{
+    if ( sx_TCCacheState == eTCCache_Alive ) {
+        return &sx_TCCache;
+    }
+    if ( sx_TCCacheState == eTCCache_Destroyed ) {
+        // Thread is exiting, use central lists directly.
+        return 0;
+    }
+    sx_TCCacheState = eTCCache_Alive;
+    return &sx_TCCache;
+}
+
+static void* sx_TCAlloc(size_t size)
+{
+    if ( size > kTC_MaxSize ) {
+        return 0;
+    }
+    unsigned cls = sx_TCSizeClass(size);
+    STCThreadCache* cache = sx_TCGetCache();
+    if ( !cache ) {
+        STCFreeList list = { 0, 0 };
+        sx_TCFetch(cls, list, 1);
+        return list.m_Count ? list.Pop() : 0;
+    }
+    STCFreeList& list = cache->m_Free[cls];
+    size_t block_size = sx_TCClassSize(cls);
+    if ( !list.m_Count ) {
+        sx_TCFetch(cls, list, kTC_Batch);
+        if ( !list.m_Count ) {
+            return 0;
+        }
+        cache->m_Stats.m_CachedBytes += list.m_Count*block_size;
+    }
+    ++cache->m_Stats.m_Allocations;
+    cache->m_Stats.m_AllocatedBytes += block_size;
+    cache->m_Stats.m_CachedBytes -= block_size;
+    return list.Pop();
+}
+
+// Return true if the block belongs to the allocator and was freed.
+static bool sx_TCFree(void* ptr)
+{
+    unsigned cls = sx_TCLookup(ptr);
+    if ( !cls ) {
+        return false;
+    }
+    STCThreadCache* cache = sx_TCGetCache();
+    if ( !cache ) {
+        STCFreeList list = { 0, 0 };
+        list.Push(ptr);
+        sx_TCRelease(cls, list, 1);
+        return true;
+    }
+    STCFreeList& list = cache->m_Free[cls];
+    list.Push(ptr);
+    size_t block_size = sx_TCClassSize(cls);
+    ++cache->m_Stats.m_Deallocations;
+    cache->m_Stats.m_FreedBytes += block_size;
+    cache->m_Stats.m_CachedBytes += block_size;
+    if ( list.m_Count >= 2*kTC_Batch ) {
+        unsigned count = list.m_Count;
+        sx_TCRelease(cls, list, kTC_Batch);
+        cache->m_Stats.m_CachedBytes -= (count - list.m_Count)*block_size;
+    }
+    return true;
+}
+
+
+static CObject::EAllocatorMode sm_AllocatorMode;
+
+static CObject::EAllocatorMode sx_InitAllocatorMode(void)
+{
+    CObject::EAllocatorMode mode = CObject::eAllocatorHeap;
+    const char* env = ::getenv("NCBI_OBJECT_ALLOCATOR");
+    if ( env  &&  NStr::CompareNocase(env, "ThreadCache") == 0 ) {
+        mode = CObject::eAllocatorThreadCache;
+    }
+    sm_AllocatorMode = mode;
+    return mode;
+}
+
+
+CObject::EAllocatorMode CObject::GetAllocatorMode(void)
+{
+    EAllocatorMode mode = sm_AllocatorMode;
+    return mode ? mode : sx_InitAllocatorMode();
+}
+
+
+void CObject::SetAllocatorMode(CObject::EAllocatorMode mode)
+{
+    sm_AllocatorMode = mode;
+}
+
+
+void CObject::SetAllocatorMode(const string& value)
+{
+    if ( NStr::CompareNocase(value, "Heap") == 0 )
+        sm_AllocatorMode = eAllocatorHeap;
+    else if ( NStr::CompareNocase(value, "ThreadCache") == 0 )
+        sm_AllocatorMode = eAllocatorThreadCache;
+}
+
+
+void CObject::GetAllocatorThreadStats(SAllocatorStats& stats)
+{
+    STCThreadCache* cache = sx_TCGetCache();
+    if ( cache ) {
+        stats = cache->m_Stats;
+    }
+    else {
+        memset(&stats, 0, sizeof(stats));
+    }
+    stats.m_ReservedBytes = sx_TCReservedBytes.load();
+}
+
+
+static inline void* sx_AllocHeap(size_t size)
+{
+    CObject::EAllocatorMode mode = sm_AllocatorMode;
+    if ( !mode ) {
+        mode = sx_InitAllocatorMode();
+    }
+    if ( mode == CObject::eAllocatorThreadCache ) {
+        if ( void* ptr = sx_TCAlloc(size) ) {
+            return ptr;
+        }
+    }
+    return ::operator new(size);
+}
+
+
+static inline void sx_FreeHeap(void* ptr)
+{
+    if ( !sx_TCFree(ptr) ) {
+        ::operator delete(ptr);
+    }
+}
+
+
 // CObject local new operator to mark allocation in heap
 void* CObject::operator new(size_t size)
 {
@@ -480,7 +808,7 @@ void* CObject::operator new(size_t size)
     //static_cast<CObject*>(ptr)->m_Counter.Set(0);
     return ptr;
 #else
-    void* ptr = ::operator new(size);
+    void* ptr = sx_AllocHeap(size);
 
 #if USE_TLS_PTR
     // just remember pointer in TLS
@@ -528,7 +856,7 @@ void CObject::operator delete(void* ptr)
     // 1. eMagicCounterDeleted when memory is freed after CObject destructor.
     // 2. eMagicCounterNew when memory is freed before CObject constructor.
     _ASSERT(magic == eMagicCounterDeleted  || magic == eMagicCounterNew);
-    ::operator delete(ptr);
+    sx_FreeHeap(ptr);
 }
 
 
@@ -1341,6 +1669,361 @@ void CPtrToObjectProxy::ReportIncompatibleType(const type_info& type)
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+//  CBiasedObject
+//
+//  m_State bits:
+//    kBiasedActive - the owner counter is in use;
+//    kBiasedQueued - the object is in its owner's release queue;
+//    the rest      - number of owner-counted references released by other
+//                    threads (merged into m_Biased by the owner).
+//  The atomic counter holds a "group" reference while the object is
+//  active or queued.  It takes two counter steps, so that CObject never
+//  sees such an object as referenced only once.  Live references are
+//    m_Biased - remote releases + (atomic references - group reference).
+//  Only the owner thread changes m_Biased and sets kBiasedActive.
+
+static const Uint4 kBiasedActive     = 1 << 0;
+static const Uint4 kBiasedQueued     = 1 << 1;
+static const Uint4 kBiasedRemoteStep = 1 << 2;
+
+static const int   kBiasedGroupRefs  = 2;
+
+
+struct SBiasedObjectOwner
+{
+    SBiasedObjectOwner(void)
+        : m_HasQueued(false), m_Exited(false)
+    {}
+
+    static SBiasedObjectOwner* GetCurrent(void)
+    {
+        return sx_Current;
+    }
+    static SBiasedObjectOwner* GetOrCreate(void);
+
+    void Enqueue(const CBiasedObject* obj);
+    void ProcessQueue(void);
+    void Exit(void);
+
+    atomic<bool>                  m_HasQueued;
+    bool                          m_Exited;
+    CFastMutex                    m_Mutex;
+    vector<const CBiasedObject*>  m_Queue;
+
+    static thread_local SBiasedObjectOwner* sx_Current;
+    static thread_local bool                sx_Exiting;
+};
+
+
+thread_local SBiasedObjectOwner* SBiasedObjectOwner::sx_Current = NULL;
+thread_local bool                SBiasedObjectOwner::sx_Exiting = false;
+
+
+// Merges the queue when the thread exits.
+struct SBiasedObjectOwnerGuard
+{
+    ~SBiasedObjectOwnerGuard(void)
+    {
+        if ( SBiasedObjectOwner::sx_Current ) {
+            SBiasedObjectOwner::sx_Current->Exit();
+        }
+    }
+};
+static thread_local SBiasedObjectOwnerGuard s_BiasedObjectOwnerGuard;
+
+
+SBiasedObjectOwner* SBiasedObjectOwner::GetOrCreate(void)
+{
+    if ( !sx_Current  &&  !sx_Exiting ) {
+        // Owner records are never freed: objects keep pointing to them
+        // after the thread exits.
+        (void) &s_BiasedObjectOwnerGuard;
+        sx_Current = new SBiasedObjectOwner;
+    }
+    return sx_Current;
+}
+
+
+void SBiasedObjectOwner::Enqueue(const CBiasedObject* obj)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        if ( !m_Exited ) {
+            m_Queue.push_back(obj);
+            m_HasQueued.store(true, memory_order_release);
+            return;
+        }
+    }}
+    // The owner thread is gone and its counter will not change any more.
+    obj->x_ProcessQueued();
+}
+
+
+void SBiasedObjectOwner::ProcessQueue(void)
+{
+    vector<const CBiasedObject*> queue;
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        queue.swap(m_Queue);
+        m_HasQueued.store(false, memory_order_relaxed);
+    }}
+    ITERATE(vector<const CBiasedObject*>, it, queue) {
+        (*it)->x_ProcessQueued();
+    }
+}
+
+
+void SBiasedObjectOwner::Exit(void)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Exited = true;
+    }}
+    // From now on this thread works with its objects as any other thread.
+    sx_Current = NULL;
+    sx_Exiting = true;
+    ProcessQueue();
+}
+
+
+CBiasedObject::CBiasedObject(void)
+    : m_Owner(SBiasedObjectOwner::GetOrCreate()),
+      m_Biased(0),
+      m_State(0)
+{
+}
+
+
+CBiasedObject::CBiasedObject(const CBiasedObject& src)
+    : CObject(src),
+      m_Owner(SBiasedObjectOwner::GetOrCreate()),
+      m_Biased(0),
+      m_State(0)
+{
+}
+
+
+CBiasedObject::~CBiasedObject(void)
+{
+    _ASSERT( !(m_State.load(memory_order_relaxed) & kBiasedQueued) );
+}
+
+
+void CBiasedObject::AddBiasedReference(void) const
+{
+    SBiasedObjectOwner* owner = m_Owner;
+    if ( owner  &&  owner == SBiasedObjectOwner::GetCurrent() ) {
+        if ( m_State.load(memory_order_relaxed) & kBiasedActive ) {
+            m_Biased.store(m_Biased.load(memory_order_relaxed) + 1,
+                           memory_order_relaxed);
+        }
+        else {
+            x_Activate();
+        }
+        if ( owner->m_HasQueued.load(memory_order_relaxed) ) {
+            owner->ProcessQueue();
+        }
+    }
+    else {
+        AddReference();
+    }
+}
+
+
+void CBiasedObject::RemoveBiasedReference(void) const
+{
+    SBiasedObjectOwner* owner = m_Owner;
+    if ( owner  &&  owner == SBiasedObjectOwner::GetCurrent() ) {
+        x_RemoveOwned(false);
+        if ( owner->m_HasQueued.load(memory_order_relaxed) ) {
+            owner->ProcessQueue();
+        }
+    }
+    else {
+        x_RemoveShared(false);
+    }
+}
+
+
+void CBiasedObject::ReleaseBiasedReference(void) const
+{
+    SBiasedObjectOwner* owner = m_Owner;
+    if ( owner  &&  owner == SBiasedObjectOwner::GetCurrent() ) {
+        x_RemoveOwned(true);
+    }
+    else {
+        x_RemoveShared(true);
+    }
+}
+
+
+void CBiasedObject::ProcessQueuedReleases(void)
+{
+    SBiasedObjectOwner* owner = SBiasedObjectOwner::GetCurrent();
+    if ( owner ) {
+        owner->ProcessQueue();
+    }
+}
+
+
+bool CBiasedObject::Referenced(void) const THROWS_NONE
+{
+    return x_GetReferences() > 0;
+}
+
+
+bool CBiasedObject::ReferencedOnlyOnce(void) const THROWS_NONE
+{
+    return x_GetReferences() == 1;
+}
+
+
+// Like in CObject, the result is exact only if no other thread changes
+// the references meanwhile.
+Int8 CBiasedObject::x_GetReferences(void) const
+{
+    Uint4 state = m_State.load(memory_order_acquire);
+    Int8 refs = Int8((m_Counter.load(memory_order_acquire) - eCounterValid)
+                     / eCounterStep);
+    if ( state & (kBiasedActive | kBiasedQueued) ) {
+        refs -= kBiasedGroupRefs;
+    }
+    if ( state & kBiasedActive ) {
+        refs += Int8(m_Biased.load(memory_order_relaxed))
+            - Int8(state / kBiasedRemoteStep);
+    }
+    return max(refs, Int8(0));
+}
+
+
+void CBiasedObject::x_Activate(void) const
+{
+    Uint4 state = m_State.load(memory_order_relaxed);
+    if ( !(state & kBiasedQueued) ) {
+        // take the group reference; a queued object still has it
+        for (int i = 0;  i < kBiasedGroupRefs;  ++i) {
+            AddReference();
+        }
+    }
+    m_Biased.store(1, memory_order_relaxed);
+    m_State.fetch_or(kBiasedActive, memory_order_release);
+}
+
+
+// Release the group reference.
+void CBiasedObject::x_RemoveGroup(bool release) const
+{
+    for (int i = 1;  i < kBiasedGroupRefs;  ++i) {
+        RemoveReference();
+    }
+    if ( release ) {
+        ReleaseReference();
+    }
+    else {
+        RemoveReference();
+    }
+}
+
+
+void CBiasedObject::x_Deactivate(bool release) const
+{
+    // No owner-counted references are left, so the remote count is stable.
+    Uint4 state = m_State.load(memory_order_relaxed);
+    while ( !m_State.compare_exchange_weak(state, state & kBiasedQueued,
+                                           memory_order_acq_rel) ) {
+    }
+    m_Biased.store(0, memory_order_relaxed);
+    if ( !(state & kBiasedQueued) ) {
+        // release the group reference; a queued one is released by the queue
+        x_RemoveGroup(release);
+    }
+}
+
+
+void CBiasedObject::x_RemoveOwned(bool release) const
+{
+    Uint4 state = m_State.load(memory_order_acquire);
+    if ( state & kBiasedActive ) {
+        Uint4 remote = state / kBiasedRemoteStep;
+        Uint4 biased = m_Biased.load(memory_order_relaxed);
+        if ( biased > remote ) {
+            m_Biased.store(--biased, memory_order_relaxed);
+            if ( biased == remote ) {
+                x_Deactivate(release);
+            }
+            return;
+        }
+        // All owner-counted references were released by other threads,
+        // so this one is counted in the atomic counter.
+        x_Deactivate(false);
+    }
+    if ( release ) {
+        ReleaseReference();
+    }
+    else {
+        RemoveReference();
+    }
+}
+
+
+void CBiasedObject::x_RemoveShared(bool release) const
+{
+    Uint4 state = m_State.load(memory_order_acquire);
+    while ( state & kBiasedActive ) {
+        TCount count = m_Counter.load(memory_order_relaxed);
+        if ( ObjectStateReferenced(count - kBiasedGroupRefs * eCounterStep) ) {
+            // more than the group reference is left
+            if ( m_Counter.compare_exchange_weak(count, count - eCounterStep,
+                                                 memory_order_acq_rel) ) {
+                return;
+            }
+        }
+        else {
+            // Only the group reference is left, so the reference being
+            // released was counted by the owner: queue it to the owner.
+            Uint4 new_state = (state + kBiasedRemoteStep) | kBiasedQueued;
+            if ( m_State.compare_exchange_weak(state, new_state,
+                                               memory_order_acq_rel) ) {
+                if ( !(state & kBiasedQueued) ) {
+                    m_Owner->Enqueue(this);
+                }
+                return;
+            }
+            continue;
+        }
+        state = m_State.load(memory_order_acquire);
+    }
+    if ( release ) {
+        ReleaseReference();
+    }
+    else {
+        RemoveReference();
+    }
+}
+
+
+void CBiasedObject::x_ProcessQueued(void) const
+{
+    Uint4 state = m_State.load(memory_order_acquire);
+    Uint4 new_state;
+    do {
+        new_state = state & ~kBiasedQueued;
+        if ( (state & kBiasedActive)  &&
+             m_Biased.load(memory_order_relaxed)
+             == state / kBiasedRemoteStep ) {
+            // all owner-counted references were released remotely
+            new_state = 0;
+        }
+    } while ( !m_State.compare_exchange_weak(state, new_state,
+                                             memory_order_acq_rel) );
+    if ( !(new_state & kBiasedActive) ) {
+        m_Biased.store(0, memory_order_relaxed);
+        x_RemoveGroup(false);
+    }
+}
+
+
 END_NCBI_SCOPE
 
 #ifdef USE_DEBUG_NEW
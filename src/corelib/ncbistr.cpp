@@ -35,6 +35,7 @@
 #include <corelib/ncbistr.hpp>
 #include <corelib/tempstr.hpp>
 #include <corelib/ncbistr_util.hpp>
+#include <corelib/impl/ncbistr_simd.hpp>
 #include <corelib/error_codes.hpp>
 #include <corelib/ncbierror.hpp>
 #include <corelib/ncbifloat.h>
@@ -187,6 +188,28 @@ int NStr::CompareCase(const CTempString s1, SIZE_TYPE pos, SIZE_TYPE n,
 }
 
 
+/// @internal
+// CStrSimd kernels fold ASCII case only, which agrees with tolower()
+// in the "C" locale (and "C.UTF-8", where all bytes above 0x7F are
+// left alone).  Other locales go the tolower() way.
+static inline bool s_IsAsciiCaseFolding(void)
+{
+#if defined(NCBI_OS_UNIX)  &&  defined(LC_GLOBAL_LOCALE)
+    if (uselocale((locale_t) 0) != LC_GLOBAL_LOCALE) {
+        return false;
+    }
+#endif
+    const char* name = setlocale(LC_CTYPE, NULL);
+    if ( !name ) {
+        return false;
+    }
+    if (name[0] == 'C'  &&  (name[1] == '\0'  ||  name[1] == '.')) {
+        return true;
+    }
+    return strcmp(name, "POSIX") == 0;
+}
+
+
 int NStr::CompareNocase(const CTempStringEx s1, const CTempStringEx s2)
 {
     SIZE_TYPE n1 = s1.length();
@@ -202,6 +225,9 @@ int NStr::CompareNocase(const CTempStringEx s1, const CTempStringEx s2)
     const char* p1 = s1.data();
     const char* p2 = s2.data();
 
+    SIZE_TYPE same = s_IsAsciiCaseFolding()
+        ? CStrSimd::PrefixNocase(p1, p2, n) : 0;
+    p1 += same;  p2 += same;  n -= same;
     while (n  &&  (*p1 == *p2  ||  
                    tolower((unsigned char)(*p1)) == tolower((unsigned char)(*p2))) ) {
         p1++;  p2++;  n--;
@@ -264,6 +290,9 @@ int NStr::CompareNocase(const CTempString s1, SIZE_TYPE pos, SIZE_TYPE n,
     }
     const char* s = s1.data() + pos;
     const char* p = s2.data();
+    SIZE_TYPE same = s_IsAsciiCaseFolding()
+        ? CStrSimd::PrefixNocase(s, p, n_cmp) : 0;
+    s += same;  p += same;  n_cmp -= same;
     while (n_cmp  &&  (*s == *p  ||
            tolower((unsigned char)(*s)) == tolower((unsigned char)(*p))) ) {
         s++;  p++;  n_cmp--;
@@ -394,16 +423,26 @@ bool NStr::MatchesMask(CTempString str, CTempString mask, ECase use_case)
 
 char* NStr::ToLower(char* str)
 {
-    char* s;
-    for (s = str;  *str;  str++) {
-        *str = (char)tolower((unsigned char)(*str));
+    if ( s_IsAsciiCaseFolding() ) {
+        CStrSimd::ToLower(str, strlen(str));
+        return str;
     }
-    return s;
+    for (char* s = str;  *s;  s++) {
+        *s = (char)tolower((unsigned char)(*s));
+    }
+    return str;
 }
 
 
 string& NStr::ToLower(string& str)
 {
+    if (str.empty()) {
+        return str;
+    }
+    if ( s_IsAsciiCaseFolding() ) {
+        CStrSimd::ToLower(&str[0], str.size());
+        return str;
+    }
     NON_CONST_ITERATE (string, it, str) {
         *it = (char)tolower((unsigned char)(*it));
     }
@@ -2884,6 +2923,61 @@ string NStr::FormatVarargs(const char* format, va_list args)
 }
 
 
+/// @internal
+// A set of lower/upper characters for pattern[0].
+static string s_FirstCharCases(const CTempString pattern)
+{
+    string x_first(pattern, 0, 1);
+    if (isupper((unsigned char)x_first[0])) {
+        x_first += (char)tolower((unsigned char)x_first[0]);
+    } else if (islower((unsigned char)x_first[0])) {
+        x_first += (char)toupper((unsigned char)x_first[0]);
+    }
+    return x_first;
+}
+
+
+/// @internal
+// Forward case-insensitive search of a non-empty pattern.  Candidates
+// are positions where both the first and the last characters of the
+// pattern match; each is then verified with CompareNocase().
+static SIZE_TYPE s_FindNocase(const CTempString str, const CTempString pattern,
+                              SIZE_TYPE start)
+{
+    const SIZE_TYPE slen = str.length();
+    const SIZE_TYPE plen = pattern.length();
+    if ( !plen  ||  start >= slen  ||  plen > slen - start ) {
+        return NPOS;
+    }
+    if ( !s_IsAsciiCaseFolding() ) {
+        string x_first = s_FirstCharCases(pattern);
+        for (SIZE_TYPE pos = str.find_first_of(x_first, start);
+             pos != NPOS  &&  pos + plen <= slen;
+             pos = str.find_first_of(x_first, pos + 1)) {
+            if (NStr::CompareNocase(str, pos, plen, pattern) == 0) {
+                return pos;
+            }
+        }
+        return NPOS;
+    }
+    const char first = pattern[0];
+    const char last  = pattern[plen - 1];
+    SIZE_TYPE pos = start;
+    for (;;) {
+        SIZE_TYPE i = CStrSimd::FindNocasePair(str.data() + pos, slen - pos,
+                                               first, last, plen - 1);
+        if (i == NPOS) {
+            return NPOS;
+        }
+        pos += i;
+        if (NStr::CompareNocase(str, pos, plen, pattern) == 0) {
+            return pos;
+        }
+        ++pos;
+    }
+}
+
+
 SIZE_TYPE NStr::Find(const CTempString str,
                      const CTempString pattern,
                      ECase             use_case,
@@ -2933,27 +3027,10 @@ SIZE_TYPE NStr::Find(const CTempString str,
     } else {
         _ASSERT(use_case == eNocase);
 
-        // A set of lower/upper characters for pattern[0].
-        string x_first(pattern, 0, 1);
-        if (isupper((unsigned char)x_first[0])) {
-            x_first += (char)tolower((unsigned char)x_first[0]);
-        } else if (islower((unsigned char)x_first[0])) {
-            x_first += (char)toupper((unsigned char)x_first[0]);
-        }
-
         if (direction == eForwardSearch) {
             do {
-                pos = str.find_first_of(x_first, search_pos);
-                while (pos != NPOS) {
-                    if ( (pos + plen) > slen ) {
-                        return NPOS;
-                    }
-                    if ( CompareNocase(str, pos, plen, pattern) == 0 ) {
-                        break;
-                    }
-                    pos = str.find_first_of(x_first, pos + 1);
-                }
-                if (pos > slen) {
+                pos = s_FindNocase(str, pattern, search_pos);
+                if (pos == NPOS) {
                     return NPOS;
                 }
                 current_pos = pos;
@@ -2964,6 +3041,7 @@ SIZE_TYPE NStr::Find(const CTempString str,
 
         } else {
             _ASSERT(direction == eReverseSearch);
+            string x_first = s_FirstCharCases(pattern);
             search_pos = slen - plen;
             do {
                 pos = str.find_last_of(x_first, search_pos);
@@ -6674,6 +6752,13 @@ SIZE_TYPE CUtf8::x_GetValidSymbolCount(const CTempString& str,
     src = str.begin();
     CTempString::const_iterator to = str.end();
     for (; src != to; ++src, ++count) {
+        if ((Uint1)*src < 0x80) {
+            // ASCII run, one byte per symbol
+            SIZE_TYPE ascii = CStrSimd::SkipAscii(src, to - src);
+            src   += ascii - 1;
+            count += ascii - 1;
+            continue;
+        }
         SIZE_TYPE more = 0;
         bool good = x_EvalFirst(*src, more);
         while (more-- && good) {
@@ -6718,6 +6803,13 @@ EEncoding CUtf8::GuessEncoding(const CTempString& src)
     CTempString::const_iterator end = src.end();
     bool cp1252, iso1, ascii, utf8, cesu8;
     for (cp1252 = iso1 = ascii = utf8 = true, cesu8=false; i != end; ++i) {
+        if (more == 0  &&  (Uint1)*i < 0x80) {
+            // ASCII bytes do not change any of the flags
+            i += CStrSimd::SkipAscii(i, end - i);
+            if (i == end) {
+                break;
+            }
+        }
         Uint1 ch = *i;
         bool skip = false;
         if (more != 0) {
@@ -7439,6 +7531,20 @@ char* CTempString_Storage::Allocate(CTempString::size_type len)
 }
 
 
+/// @internal
+static inline
+SIZE_TYPE s_FindFirstOf(const CTempString str, const CTempString set,
+                        SIZE_TYPE pos)
+{
+    if (pos >= str.size()) {
+        return NPOS;
+    }
+    SIZE_TYPE i = CStrSimd::FindFirstOf(str.data() + pos, str.size() - pos,
+                                        set.data(), set.size());
+    return i == NPOS ? NPOS : pos + i;
+}
+
+
 bool CStrTokenizeBase::Advance(CTempStringList* part_collector, SIZE_TYPE* ptr_part_start, SIZE_TYPE* ptr_delim_pos)
 {
     SIZE_TYPE pos, part_start, delim_pos = 0, quote_pos = 0;
@@ -7469,7 +7575,7 @@ bool CStrTokenizeBase::Advance(CTempStringList* part_collector, SIZE_TYPE* ptr_p
     // Each chunk covers the half-open interval [part_start, delim_pos).
 
     while ( !done  &&
-            ((delim_pos = m_Str.find_first_of(m_InternalDelim, pos)) != NPOS)) {
+            ((delim_pos = s_FindFirstOf(m_Str, m_InternalDelim, pos)) != NPOS)) {
 
         SIZE_TYPE next_start = pos = delim_pos + 1;
         bool      handled    = false;
@@ -7570,6 +7676,58 @@ void CStrTokenizeBase::x_SkipDelims(bool force_skip)
 }
 
 
+CStrSplitter::CStrSplitter(const CTempString str, const CTempString delim,
+                           NStr::TSplitFlags flags)
+    : m_Str(str), m_Delim(delim), m_Pos(0), m_Flags(flags)
+{
+    if ((flags & ~(NStr::fSplit_MergeDelimiters | NStr::fSplit_Truncate)) != 0) {
+        NCBI_THROW2(CStringException, eBadArgs,
+                    "CStrSplitter: unsupported split flags", 0);
+    }
+    if ((m_Flags & NStr::fSplit_Truncate_Begin) != 0) {
+        x_SkipDelims();
+    }
+    if ((m_Flags & NStr::fSplit_Truncate_End) != 0  &&  m_Pos == NPOS) {
+        // nothing but delimiters
+        m_Str.clear();
+    }
+}
+
+
+void CStrSplitter::x_SkipDelims(void)
+{
+    m_Pos = m_Str.find_first_not_of(m_Delim, m_Pos);
+}
+
+
+bool CStrSplitter::Next(CTempString& token)
+{
+    if (m_Pos == NPOS) {
+        return false;
+    }
+    SIZE_TYPE delim_pos = s_FindFirstOf(m_Str, m_Delim, m_Pos);
+    if (delim_pos == NPOS) {
+        token = m_Str.substr(m_Pos);
+        m_Pos = NPOS;
+        return true;
+    }
+    token = m_Str.substr(m_Pos, delim_pos - m_Pos);
+    m_Pos = delim_pos + 1;
+    if ((m_Flags & NStr::fSplit_MergeDelimiters) != 0) {
+        x_SkipDelims();
+    }
+    if ((m_Flags & NStr::fSplit_Truncate_End) != 0  &&
+        (m_Pos == NPOS  ||  m_Str.find_first_not_of(m_Delim, m_Pos) == NPOS)) {
+        // only trailing delimiters left
+        m_Pos = NPOS;
+    } else if (m_Pos == NPOS) {
+        // merged delimiters at the end of the string
+        m_Pos = m_Str.size();
+    }
+    return true;
+}
+
+
 void CStrTokenizeBase::x_ExtendInternalDelim()
 {
     if ( !(m_Flags & (NStr::fSplit_CanEscape | NStr::fSplit_CanQuote)) ) {
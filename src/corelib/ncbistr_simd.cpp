@@ -0,0 +1,555 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Runtime-dispatched SIMD kernels for NStr and CUtf8
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/impl/ncbistr_simd.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <ctype.h>
+#include <string.h>
+
+#if (defined(__x86_64__)  ||  defined(_M_X64))  && \
+    (defined(__GNUC__)  ||  defined(__clang__)  ||  defined(_MSC_VER))
+#  define NCBI_STR_SIMD_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)  &&  !defined(__clang__)
+#    include <intrin.h>
+#    define NCBI_TARGET_SSE42
+#    define NCBI_TARGET_AVX2
+#  else
+#    define NCBI_TARGET_SSE42  __attribute__((target("sse4.2")))
+#    define NCBI_TARGET_AVX2   __attribute__((target("avx2")))
+#  endif
+#endif
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Scalar kernels -- exactly the loops NStr used before vectorization
+
+static inline unsigned char s_FoldAscii(unsigned char c)
+{
+    return (c >= 'A'  &&  c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+
+static size_t s_PrefixNocase_Scalar(const char*, const char*, size_t)
+{
+    // Let the caller's tolower() loop do all the work
+    return 0;
+}
+
+
+static void s_ToLower_Scalar(char* str, size_t n)
+{
+    for (char* end = str + n;  str != end;  ++str) {
+        *str = (char)tolower((unsigned char)(*str));
+    }
+}
+
+
+static size_t s_FindFirstOf_Scalar(const char* str, size_t n,
+                                   const char* set, size_t set_len)
+{
+    if ( !set_len ) {
+        return NPOS;
+    }
+    if (set_len == 1) {
+        const void* p = memchr(str, set[0], n);
+        return p ? (const char*)p - str : NPOS;
+    }
+    bool table[256] = {};
+    for (size_t k = 0;  k < set_len;  ++k) {
+        table[(unsigned char) set[k]] = true;
+    }
+    for (size_t i = 0;  i < n;  ++i) {
+        if (table[(unsigned char) str[i]]) {
+            return i;
+        }
+    }
+    return NPOS;
+}
+
+
+static size_t s_FindNocasePair_Scalar(const char* str, size_t n,
+                                      char first, char last, size_t dist)
+{
+    if (dist >= n) {
+        return NPOS;
+    }
+    unsigned char f = s_FoldAscii(first);
+    unsigned char l = s_FoldAscii(last);
+    for (size_t i = 0, end = n - dist;  i < end;  ++i) {
+        if (s_FoldAscii(str[i]) == f  &&  s_FoldAscii(str[i + dist]) == l) {
+            return i;
+        }
+    }
+    return NPOS;
+}
+
+
+static size_t s_SkipAscii_Scalar(const char* str, size_t n)
+{
+    size_t i = 0;
+    while (i < n  &&  (unsigned char) str[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+
+static const CStrSimd::SImpl s_ScalarImpl = {
+    CStrSimd::eScalar,
+    s_PrefixNocase_Scalar,
+    s_ToLower_Scalar,
+    s_FindFirstOf_Scalar,
+    s_FindNocasePair_Scalar,
+    s_SkipAscii_Scalar
+};
+
+
+#ifdef NCBI_STR_SIMD_X86
+
+static inline unsigned s_Ctz(unsigned x)
+{
+#  if defined(_MSC_VER)  &&  !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return (unsigned) idx;
+#  else
+    return (unsigned) __builtin_ctz(x);
+#  endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  SSE 4.2 kernels (16 bytes per step)
+
+// Set bit 0x20 in bytes that are 'A'..'Z'.  Adding 0x80-'A' maps the
+// range of uppercase letters onto [-128, -128+26) in signed arithmetic.
+NCBI_TARGET_SSE42
+static inline __m128i s_Fold16(__m128i x)
+{
+    __m128i r  = _mm_add_epi8(x, _mm_set1_epi8((char)(0x80 - 'A')));
+    __m128i up = _mm_cmplt_epi8(r, _mm_set1_epi8((char)(-128 + 26)));
+    return _mm_or_si128(x, _mm_and_si128(up, _mm_set1_epi8(0x20)));
+}
+
+
+NCBI_TARGET_SSE42
+static size_t s_PrefixNocase_SSE42(const char* s1, const char* s2, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 16 <= n;  i += 16) {
+        __m128i a = s_Fold16(_mm_loadu_si128((const __m128i*)(s1 + i)));
+        __m128i b = s_Fold16(_mm_loadu_si128((const __m128i*)(s2 + i)));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (m != 0xFFFF) {
+            return i + s_Ctz(~m);
+        }
+    }
+    return i;
+}
+
+
+NCBI_TARGET_SSE42
+static void s_ToLower_SSE42(char* str, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 16 <= n;  i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(str + i));
+        if ( _mm_movemask_epi8(x) ) {
+            // Non-ASCII bytes are locale-dependent
+            s_ToLower_Scalar(str + i, 16);
+        } else {
+            _mm_storeu_si128((__m128i*)(str + i), s_Fold16(x));
+        }
+    }
+    s_ToLower_Scalar(str + i, n - i);
+}
+
+
+NCBI_TARGET_SSE42
+static size_t s_FindFirstOf_SSE42(const char* str, size_t n,
+                                  const char* set, size_t set_len)
+{
+    if (set_len <= 1  ||  set_len > 16) {
+        return s_FindFirstOf_Scalar(str, n, set, set_len);
+    }
+    char buf[16] = {};
+    memcpy(buf, set, set_len);
+    __m128i chars = _mm_loadu_si128((const __m128i*) buf);
+    size_t i = 0;
+    for ( ;  i + 16 <= n;  i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(str + i));
+        int idx = _mm_cmpestri(chars, (int) set_len, x, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                               _SIDD_LEAST_SIGNIFICANT);
+        if (idx < 16) {
+            return i + idx;
+        }
+    }
+    size_t pos = s_FindFirstOf_Scalar(str + i, n - i, set, set_len);
+    return pos == NPOS ? NPOS : i + pos;
+}
+
+
+NCBI_TARGET_SSE42
+static size_t s_FindNocasePair_SSE42(const char* str, size_t n,
+                                     char first, char last, size_t dist)
+{
+    if (dist >= n) {
+        return NPOS;
+    }
+    __m128i f = _mm_set1_epi8((char) s_FoldAscii(first));
+    __m128i l = _mm_set1_epi8((char) s_FoldAscii(last));
+    size_t end = n - dist;
+    size_t i = 0;
+    for ( ;  i + 16 <= end;  i += 16) {
+        __m128i a = s_Fold16(_mm_loadu_si128((const __m128i*)(str + i)));
+        __m128i b = s_Fold16(_mm_loadu_si128((const __m128i*)(str + i + dist)));
+        unsigned m = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, f), _mm_cmpeq_epi8(b, l)));
+        if (m) {
+            return i + s_Ctz(m);
+        }
+    }
+    size_t pos = s_FindNocasePair_Scalar(str + i, n - i, first, last, dist);
+    return pos == NPOS ? NPOS : i + pos;
+}
+
+
+NCBI_TARGET_SSE42
+static size_t s_SkipAscii_SSE42(const char* str, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 16 <= n;  i += 16) {
+        unsigned m = (unsigned)_mm_movemask_epi8(
+            _mm_loadu_si128((const __m128i*)(str + i)));
+        if (m) {
+            return i + s_Ctz(m);
+        }
+    }
+    return i + s_SkipAscii_Scalar(str + i, n - i);
+}
+
+
+static const CStrSimd::SImpl s_SSE42Impl = {
+    CStrSimd::eSSE42,
+    s_PrefixNocase_SSE42,
+    s_ToLower_SSE42,
+    s_FindFirstOf_SSE42,
+    s_FindNocasePair_SSE42,
+    s_SkipAscii_SSE42
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  AVX2 kernels (32 bytes per step)
+//
+//  Tails are handed to the SSE kernels, which use legacy SSE encoding;
+//  clear the upper halves of the YMM registers first to avoid the
+//  AVX-SSE transition penalty.
+
+NCBI_TARGET_AVX2
+static inline __m256i s_Fold32(__m256i x)
+{
+    __m256i r  = _mm256_add_epi8(x, _mm256_set1_epi8((char)(0x80 - 'A')));
+    __m256i up = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), r);
+    return _mm256_or_si256(x, _mm256_and_si256(up, _mm256_set1_epi8(0x20)));
+}
+
+
+NCBI_TARGET_AVX2
+static size_t s_PrefixNocase_AVX2(const char* s1, const char* s2, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 32 <= n;  i += 32) {
+        __m256i a = s_Fold32(_mm256_loadu_si256((const __m256i*)(s1 + i)));
+        __m256i b = s_Fold32(_mm256_loadu_si256((const __m256i*)(s2 + i)));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+        if (m != 0xFFFFFFFFu) {
+            return i + s_Ctz(~m);
+        }
+    }
+    _mm256_zeroupper();
+    return i + s_PrefixNocase_SSE42(s1 + i, s2 + i, n - i);
+}
+
+
+NCBI_TARGET_AVX2
+static void s_ToLower_AVX2(char* str, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 32 <= n;  i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(str + i));
+        if ( _mm256_movemask_epi8(x) ) {
+            s_ToLower_Scalar(str + i, 32);
+        } else {
+            _mm256_storeu_si256((__m256i*)(str + i), s_Fold32(x));
+        }
+    }
+    _mm256_zeroupper();
+    s_ToLower_SSE42(str + i, n - i);
+}
+
+
+NCBI_TARGET_AVX2
+static size_t s_FindFirstOf_AVX2(const char* str, size_t n,
+                                 const char* set, size_t set_len)
+{
+    // Up to 8 delimiters are compared directly, which is cheaper than
+    // PCMPESTRI; larger sets go to the SSE 4.2 kernel.
+    if (set_len <= 1  ||  set_len > 8) {
+        return s_FindFirstOf_SSE42(str, n, set, set_len);
+    }
+    __m256i chars[8];
+    for (size_t k = 0;  k < set_len;  ++k) {
+        chars[k] = _mm256_set1_epi8(set[k]);
+    }
+    size_t i = 0;
+    for ( ;  i + 32 <= n;  i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(str + i));
+        __m256i eq = _mm256_cmpeq_epi8(x, chars[0]);
+        for (size_t k = 1;  k < set_len;  ++k) {
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(x, chars[k]));
+        }
+        unsigned m = (unsigned)_mm256_movemask_epi8(eq);
+        if (m) {
+            return i + s_Ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    size_t pos = s_FindFirstOf_SSE42(str + i, n - i, set, set_len);
+    return pos == NPOS ? NPOS : i + pos;
+}
+
+
+NCBI_TARGET_AVX2
+static size_t s_FindNocasePair_AVX2(const char* str, size_t n,
+                                    char first, char last, size_t dist)
+{
+    if (dist >= n) {
+        return NPOS;
+    }
+    __m256i f = _mm256_set1_epi8((char) s_FoldAscii(first));
+    __m256i l = _mm256_set1_epi8((char) s_FoldAscii(last));
+    size_t end = n - dist;
+    size_t i = 0;
+    for ( ;  i + 32 <= end;  i += 32) {
+        __m256i a = s_Fold32(_mm256_loadu_si256((const __m256i*)(str + i)));
+        __m256i b = s_Fold32(
+            _mm256_loadu_si256((const __m256i*)(str + i + dist)));
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, f),
+                             _mm256_cmpeq_epi8(b, l)));
+        if (m) {
+            return i + s_Ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    size_t pos = s_FindNocasePair_SSE42(str + i, n - i, first, last, dist);
+    return pos == NPOS ? NPOS : i + pos;
+}
+
+
+NCBI_TARGET_AVX2
+static size_t s_SkipAscii_AVX2(const char* str, size_t n)
+{
+    size_t i = 0;
+    for ( ;  i + 32 <= n;  i += 32) {
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_loadu_si256((const __m256i*)(str + i)));
+        if (m) {
+            return i + s_Ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return i + s_SkipAscii_SSE42(str + i, n - i);
+}
+
+
+static const CStrSimd::SImpl s_AVX2Impl = {
+    CStrSimd::eAVX2,
+    s_PrefixNocase_AVX2,
+    s_ToLower_AVX2,
+    s_FindFirstOf_AVX2,
+    s_FindNocasePair_AVX2,
+    s_SkipAscii_AVX2
+};
+
+#endif  /* NCBI_STR_SIMD_X86 */
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Dispatch
+//
+//  String functions can be called during static initialization, so the
+//  implementation pointer starts out at a table of forwarders that select
+//  the back end on first use.  The selection must not use NStr itself.
+
+static const CStrSimd::SImpl* s_GetImpl(CStrSimd::EBackend backend)
+{
+    switch (backend) {
+#ifdef NCBI_STR_SIMD_X86
+    case CStrSimd::eAVX2:
+        return &s_AVX2Impl;
+    case CStrSimd::eSSE42:
+        return &s_SSE42Impl;
+#endif
+    default:
+        return &s_ScalarImpl;
+    }
+}
+
+
+static CStrSimd::EBackend s_GetBestBackend(void)
+{
+    CStrSimd::EBackend backend = CStrSimd::eAVX2;
+    const char* env = getenv("NCBI_STR_SIMD");
+    if (env) {
+        if (strcmp(env, "scalar") == 0) {
+            backend = CStrSimd::eScalar;
+        } else if (strcmp(env, "sse42") == 0) {
+            backend = CStrSimd::eSSE42;
+        }
+    }
+    if (backend == CStrSimd::eAVX2  &&  !CStrSimd::IsSupported(backend)) {
+        backend = CStrSimd::eSSE42;
+    }
+    if (backend == CStrSimd::eSSE42  &&  !CStrSimd::IsSupported(backend)) {
+        backend = CStrSimd::eScalar;
+    }
+    return backend;
+}
+
+
+struct SStrSimdLazy
+{
+    static const CStrSimd::SImpl* Init(void)
+    {
+        // Concurrent first calls all compute the same value
+        return CStrSimd::sm_Impl = s_GetImpl(s_GetBestBackend());
+    }
+    static size_t PrefixNocase(const char* s1, const char* s2, size_t n)
+    {
+        return Init()->prefix_nocase(s1, s2, n);
+    }
+    static void ToLower(char* str, size_t n)
+    {
+        Init()->to_lower(str, n);
+    }
+    static size_t FindFirstOf(const char* str, size_t n,
+                              const char* set, size_t set_len)
+    {
+        return Init()->find_first_of(str, n, set, set_len);
+    }
+    static size_t FindNocasePair(const char* str, size_t n,
+                                 char first, char last, size_t dist)
+    {
+        return Init()->find_nocase_pair(str, n, first, last, dist);
+    }
+    static size_t SkipAscii(const char* str, size_t n)
+    {
+        return Init()->skip_ascii(str, n);
+    }
+};
+
+
+static const CStrSimd::SImpl s_LazyImpl = {
+    CStrSimd::eAuto,
+    SStrSimdLazy::PrefixNocase,
+    SStrSimdLazy::ToLower,
+    SStrSimdLazy::FindFirstOf,
+    SStrSimdLazy::FindNocasePair,
+    SStrSimdLazy::SkipAscii
+};
+
+const CStrSimd::SImpl* CStrSimd::sm_Impl = &s_LazyImpl;
+
+
+CStrSimd::EBackend CStrSimd::GetBackend(void)
+{
+    const SImpl* impl = sm_Impl;
+    if (impl->backend == eAuto) {
+        impl = SStrSimdLazy::Init();
+    }
+    return impl->backend;
+}
+
+
+bool CStrSimd::SetBackend(EBackend backend)
+{
+    if (backend == eAuto) {
+        backend = s_GetBestBackend();
+    }
+    if ( !IsSupported(backend) ) {
+        return false;
+    }
+    sm_Impl = s_GetImpl(backend);
+    return true;
+}
+
+
+bool CStrSimd::IsSupported(EBackend backend)
+{
+    switch (backend) {
+    case eScalar:
+    case eAuto:
+        return true;
+#ifdef NCBI_STR_SIMD_X86
+    case eSSE42:
+        return CCpuFeatures::SSE42();
+    case eAVX2:
+        return CCpuFeatures::SSE42()  &&  CCpuFeatures::OSXSAVE()  &&
+               CCpuFeatures::AVX()  &&  CCpuFeatures::AVX2();
+#endif
+    default:
+        return false;
+    }
+}
+
+
+const char* CStrSimd::GetBackendName(EBackend backend)
+{
+    switch (backend) {
+    case eScalar:  return "scalar";
+    case eSSE42:   return "sse42";
+    case eAVX2:    return "avx2";
+    case eAuto:    return "auto";
+    }
+    return "unknown";
+}
+
+
+END_NCBI_SCOPE
@@ -45,6 +45,7 @@
 #include <corelib/ncbi_param.hpp>
 #include <corelib/request_ctx.hpp>
 #include <corelib/ncbi_system.hpp>
+#include <corelib/ncbi_profiler.hpp>
 #include <corelib/error_codes.hpp>
 #ifdef NCBI_POSIX_THREADS
 #  include <sys/time.h> // for gettimeofday()
@@ -572,6 +573,8 @@ TWrapperRes CThread::Wrapper(TWrapperArg arg)
         CDiagContext::SetRequestContext(thread_obj->m_ParentRequestContext);
     }
 
+    CSamplingProfiler::RegisterThread();
+
     // Run user-provided thread main function here
     if ( catch_all ) {
         try {
@@ -620,6 +623,8 @@ TWrapperRes CThread::Wrapper(TWrapperArg arg)
         thread_obj->OnExit();
     }
 
+    CSamplingProfiler::UnregisterThread();
+
     // Cleanup local storages used by this thread
     CUsedTlsBases::ClearAllCurrentThread();
 
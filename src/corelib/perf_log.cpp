@@ -33,6 +33,8 @@
 #include <ncbi_pch.hpp>
 #include <corelib/perf_log.hpp>
 #include <corelib/ncbi_param.hpp>
+#include <corelib/ncbi_metrics.hpp>
+#include <unordered_map>
 
 
 BEGIN_NCBI_SCOPE
@@ -50,6 +52,20 @@ NCBI_PARAM_DEF_EX(bool, Log, PerfLogging, false, eParam_NoThread, LOG_PERFLOGGIN
 typedef NCBI_PARAM_TYPE(Log, PerfLogging) TPerfLogging;
 
 
+/// Also record CPerfLogGuard timings into "perf_log_duration_seconds"
+/// histogram of CMetricsRegistry (labeled with resource and status).
+// Registry file:
+//     [Log]
+//     PerfLogging_Metrics = true/false
+// Environment variable:
+//     LOG_PERFLOGGING_METRICS
+//
+NCBI_PARAM_DECL(bool, Log, PerfLogging_Metrics);
+NCBI_PARAM_DEF_EX(bool, Log, PerfLogging_Metrics, false, eParam_NoThread,
+                  LOG_PERFLOGGING_METRICS);
+typedef NCBI_PARAM_TYPE(Log, PerfLogging_Metrics) TPerfLoggingMetrics;
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // CPerfLogger
@@ -110,6 +126,27 @@ CDiagContext_Extra CPerfLogger::Post(int         status,
 // CPerfLogGuard
 //
 
+// Histogram for the resource and status. Resolved through the registry
+// once per thread, later lookups do not lock or build labels.
+static CMetricHistogram& s_GetPerfLogHistogram(const string& resource,
+                                               int           status)
+{
+    typedef unordered_map<string, CRef<CMetricHistogram> > TByResource;
+    static thread_local unordered_map<int, TByResource> s_Cache;
+
+    CRef<CMetricHistogram>& histogram = s_Cache[status][resource];
+    if ( !histogram ) {
+        TMetricLabels labels;
+        labels.push_back(make_pair(string("resource"), resource));
+        labels.push_back(make_pair(string("status"),
+                                   NStr::IntToString(status)));
+        histogram = CMetricsRegistry::Instance().GetHistogram(
+            "perf_log_duration_seconds",
+            "Time measured by CPerfLogGuard", labels);
+    }
+    return *histogram;
+}
+
 void CPerfLogGuard::Post(int status, CTempString status_msg)
 {
     // Check a validity
@@ -120,6 +157,10 @@ void CPerfLogGuard::Post(int status, CTempString status_msg)
     }
     // Check that logging is enabled to avoid extra 'extra' to be printed
     if ( CPerfLogger::IsON() ) {
+        if ( TPerfLoggingMetrics::GetDefault() ) {
+            s_GetPerfLogHistogram(m_Resource, status)
+                .RecordSeconds(m_Logger.GetElapsedTime());
+        }
         CDiagContext_Extra extra = m_Logger.Post(status, m_Resource, status_msg);
         extra.Print(m_Parameters);
     }
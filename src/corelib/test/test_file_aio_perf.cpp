@@ -0,0 +1,355 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Random read IOPS benchmark for CFileAsyncIO
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_file_aio.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbi_test.hpp>
+#include <atomic>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestFileAIOPerfApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    // Create test file, each 8-byte word contains its own offset.
+    void x_CreateFile(const string& path, Uint8 size);
+    // Offsets of random reads.
+    void x_MakeOffsets(size_t count, Uint8 file_size);
+    // Check that the block read from 'offset' has the expected content.
+    bool x_Check(const char* buf, Uint8 offset) const;
+
+    void x_TestSync(CFileIO& file);
+    void x_TestAsync(CFileIO& file, CFileAsyncIO::EBackend backend,
+                     unsigned int depth);
+    // Read chains: each completion callback submits the next reads.
+    void x_TestChain(CFileIO& file, CFileAsyncIO::EBackend backend,
+                     unsigned int depth);
+    void x_Report(const string& name, double elapsed) const;
+
+    size_t         m_BlockSize;
+    vector<Uint8>  m_Offsets;
+    unsigned int   m_Threads;
+};
+
+
+void CTestFileAIOPerfApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "Random read IOPS benchmark for asynchronous file I/O");
+    d->AddOptionalKey("file", "Path",
+                      "Test file; created in the temporary directory "
+                      "if not specified. Use a file larger than RAM "
+                      "(or drop the page cache) to measure device IOPS.",
+                      CArgDescriptions::eString);
+    d->AddDefaultKey("size", "MB", "Size of the created test file",
+                     CArgDescriptions::eInteger, "64");
+    d->AddDefaultKey("block", "Bytes", "Size of each read",
+                     CArgDescriptions::eInteger, "4096");
+    d->AddDefaultKey("requests", "N", "Number of reads in each run",
+                     CArgDescriptions::eInteger, "100000");
+    d->AddDefaultKey("depth", "List",
+                     "Comma separated queue depths to test",
+                     CArgDescriptions::eString, "1,8,32,128");
+    d->AddDefaultKey("threads", "N", "Number of threads in the pool",
+                     CArgDescriptions::eInteger, "8");
+    d->AddDefaultKey("backend", "Type", "I/O implementation to test",
+                     CArgDescriptions::eString, "all");
+    d->SetConstraint("backend", &(*new CArgAllow_Strings,
+                                  "all", "sync", "ThreadPool", "URing"));
+    SetupArgDescriptions(d.release());
+}
+
+
+void CTestFileAIOPerfApp::x_CreateFile(const string& path, Uint8 size)
+{
+    CFileIO file;
+    file.Open(path, CFileIO::eCreate, CFileIO::eReadWrite);
+    vector<Uint8> buf(1024 * 1024 / sizeof(Uint8));
+    for (Uint8 pos = 0;  pos < size;  pos += buf.size() * sizeof(Uint8)) {
+        for (size_t i = 0;  i < buf.size();  ++i) {
+            buf[i] = pos + i * sizeof(Uint8);
+        }
+        file.Write(buf.data(), buf.size() * sizeof(Uint8));
+    }
+    file.Close();
+}
+
+
+void CTestFileAIOPerfApp::x_MakeOffsets(size_t count, Uint8 file_size)
+{
+    Uint8 blocks = file_size / m_BlockSize;
+    assert(blocks > 0);
+    m_Offsets.resize(count);
+    for (auto& offset : m_Offsets) {
+        Uint8 r = (Uint8(rand()) << 31) ^ Uint8(rand());
+        offset = (r % blocks) * m_BlockSize;
+    }
+}
+
+
+bool CTestFileAIOPerfApp::x_Check(const char* buf, Uint8 offset) const
+{
+    Uint8 value;
+    memcpy(&value, buf, sizeof(value));
+    return value == offset;
+}
+
+
+void CTestFileAIOPerfApp::x_Report(const string& name, double elapsed) const
+{
+    NcbiCout << setw(24) << name << "  "
+             << setw(10) << Uint8(double(m_Offsets.size()) / elapsed)
+             << " IOPS" << NcbiEndl;
+}
+
+
+void CTestFileAIOPerfApp::x_TestSync(CFileIO& file)
+{
+    vector<char> buf(m_BlockSize);
+    CStopWatch sw(CStopWatch::eStart);
+    for (Uint8 offset : m_Offsets) {
+        file.SetFilePos(offset);
+        size_t n = file.Read(buf.data(), m_BlockSize);
+        assert(n == m_BlockSize);
+        assert(x_Check(buf.data(), offset));
+    }
+    x_Report("sync", sw.Elapsed());
+}
+
+
+void CTestFileAIOPerfApp::x_TestAsync(CFileIO&               file,
+                                      CFileAsyncIO::EBackend backend,
+                                      unsigned int           depth)
+{
+    CFileAsyncIO aio(backend, depth, m_Threads);
+    if (aio.GetBackend() != backend) {
+        NcbiCout << "io_uring is not available" << NcbiEndl;
+        return;
+    }
+    vector<char> buffers(size_t(depth) * m_BlockSize);
+    vector<unsigned int> free_slots;
+    for (unsigned int i = 0;  i < depth;  ++i) {
+        free_slots.push_back(i);
+    }
+    CFastMutex slots_mutex;
+    atomic<size_t> errors(0);
+
+    CStopWatch sw(CStopWatch::eStart);
+    vector<CFileAsyncIO::SRequest> batch;
+    size_t next = 0;
+    while (next < m_Offsets.size()) {
+        // Submit a request for every free buffer
+        batch.clear();
+        {{
+            CFastMutexGuard guard(slots_mutex);
+            while ( !free_slots.empty()  &&  next < m_Offsets.size() ) {
+                unsigned int slot = free_slots.back();
+                free_slots.pop_back();
+                CFileAsyncIO::SRequest req;
+                req.op     = CFileAsyncIO::eRead;
+                req.handle = file.GetFileHandle();
+                req.buffer = &buffers[size_t(slot) * m_BlockSize];
+                req.size   = m_BlockSize;
+                req.offset = m_Offsets[next++];
+                req.callback =
+                    [this, slot, &free_slots, &slots_mutex, &errors]
+                    (const CFileAsyncIO::SRequest& r, Int8 result) {
+                        if (result != Int8(r.size)  ||
+                            !x_Check(static_cast<char*>(r.buffer), r.offset)) {
+                            ++errors;
+                        }
+                        CFastMutexGuard guard(slots_mutex);
+                        free_slots.push_back(slot);
+                    };
+                batch.push_back(req);
+            }
+        }}
+        if (batch.empty()) {
+            // All buffers are busy, Submit() with a full queue waits
+            // for a completion
+            while (aio.GetPending() == depth) {
+                SleepMicroSec(0);
+            }
+            continue;
+        }
+        aio.Submit(batch);
+    }
+    aio.WaitAll();
+    double elapsed = sw.Elapsed();
+    assert(errors == 0);
+    x_Report(string(backend == CFileAsyncIO::eURing ? "URing" : "ThreadPool")
+             + " depth=" + NStr::UIntToString(depth), elapsed);
+}
+
+
+void CTestFileAIOPerfApp::x_TestChain(CFileIO&               file,
+                                      CFileAsyncIO::EBackend backend,
+                                      unsigned int           depth)
+{
+    CFileAsyncIO aio(backend, depth, m_Threads);
+    if (aio.GetBackend() != backend) {
+        return;
+    }
+    // Every callback submits two more reads while the queue is full,
+    // which must neither block the service thread nor lose requests
+    const size_t kTotal = min(m_Offsets.size(), size_t(1000));
+    vector<char> buffers(kTotal * m_BlockSize);
+    atomic<size_t> next(0), done(0), errors(0);
+    function<void(size_t)> submit_next;
+    CFileAsyncIO::TCallback callback =
+        [&](const CFileAsyncIO::SRequest& r, Int8 result) {
+            if (result != Int8(r.size)  ||
+                !x_Check(static_cast<char*>(r.buffer), r.offset)) {
+                ++errors;
+            }
+            ++done;
+            submit_next(2);
+        };
+    submit_next = [&](size_t count) {
+        vector<CFileAsyncIO::SRequest> batch;
+        while (batch.size() < count) {
+            size_t i = next++;
+            if (i >= kTotal) {
+                break;
+            }
+            CFileAsyncIO::SRequest req;
+            req.op       = CFileAsyncIO::eRead;
+            req.handle   = file.GetFileHandle();
+            req.buffer   = &buffers[i * m_BlockSize];
+            req.size     = m_BlockSize;
+            req.offset   = m_Offsets[i];
+            req.callback = callback;
+            batch.push_back(req);
+        }
+        aio.Submit(batch);
+    };
+    submit_next(depth);
+    aio.WaitAll();
+    assert(errors == 0);
+    assert(done == kTotal);
+    assert(aio.GetPending() == 0);
+}
+
+
+int CTestFileAIOPerfApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    CNcbiTest::SetRandomSeed();
+
+    m_BlockSize = args["block"].AsInteger();
+    m_Threads = args["threads"].AsInteger();
+    assert(m_BlockSize >= sizeof(Uint8)  &&  m_BlockSize % sizeof(Uint8) == 0);
+
+    string path;
+    if (args["file"]) {
+        path = args["file"].AsString();
+    } else {
+        path = CFile::GetTmpName(CFile::eTmpFileCreate);
+        CFileDeleteAtExit::Add(path);
+        x_CreateFile(path, Uint8(args["size"].AsInteger()) * 1024 * 1024);
+    }
+    CFileIO file;
+    file.Open(path, CFileIO::eOpen, CFileIO::eRead);
+    x_MakeOffsets(args["requests"].AsInteger(), file.GetFileSize());
+
+    vector<string> list;
+    NStr::Split(args["depth"].AsString(), ",", list, NStr::fSplit_Tokenize);
+    vector<unsigned int> depths;
+    ITERATE(vector<string>, it, list) {
+        depths.push_back(NStr::StringToUInt(*it));
+    }
+    string backend = args["backend"].AsString();
+
+    if (backend == "all"  ||  backend == "sync") {
+        x_TestSync(file);
+    }
+    ITERATE(vector<unsigned int>, depth, depths) {
+        if (backend == "all"  ||  backend == "ThreadPool") {
+            x_TestAsync(file, CFileAsyncIO::eThreadPool, *depth);
+        }
+        if (backend == "all"  ||  backend == "URing") {
+            x_TestAsync(file, CFileAsyncIO::eURing, *depth);
+        }
+    }
+    x_TestChain(file, CFileAsyncIO::eThreadPool, 1);
+    x_TestChain(file, CFileAsyncIO::eThreadPool, 4);
+    x_TestChain(file, CFileAsyncIO::eURing, 1);
+    x_TestChain(file, CFileAsyncIO::eURing, 4);
+
+    // Futures and writes
+    {{
+        CFileAsyncIO aio;
+        string wpath = CFile::GetTmpName(CFile::eTmpFileCreate);
+        CFileDeleteAtExit::Add(wpath);
+        CFileIO wfile;
+        wfile.Open(wpath, CFileIO::eCreate, CFileIO::eReadWrite);
+        const char kData[] = "0123456789";
+        future<Int8> w1 = aio.Write(wfile.GetFileHandle(), kData, 5, 0);
+        future<Int8> w2 = aio.Write(wfile.GetFileHandle(), kData + 5, 5, 5);
+        assert(w1.get() == 5);
+        assert(w2.get() == 5);
+        char buf[16];
+        future<Int8> r = aio.Read(wfile.GetFileHandle(), buf, sizeof(buf), 0);
+        assert(r.get() == 10);
+        assert(memcmp(buf, kData, 10) == 0);
+        // Error is reported as negated errno
+        r = aio.Read(kInvalidHandle, buf, sizeof(buf), 0);
+        assert(r.get() < 0);
+        wfile.Close();
+    }}
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestFileAIOPerfApp().AppMain(argc, argv);
+}
@@ -0,0 +1,201 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   TEST for:  CMetricsRegistry and metric classes
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_metrics.hpp>
+#include <corelib/ncbienv.hpp>
+#include <corelib/ncbistr.hpp>
+#include <corelib/perf_log.hpp>
+#include <thread>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <corelib/test_boost.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+BOOST_AUTO_TEST_CASE(TestCounterMT)
+{
+    CMetricCounter counter;
+    const int kThreads = 8;
+    const int kIncrements = 100000;
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.push_back(thread([&counter]() {
+            for (int i = 0; i < kIncrements; ++i) {
+                counter.Add();
+            }
+        }));
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+    BOOST_CHECK_EQUAL(counter.GetValue(), Uint8(kThreads * kIncrements));
+    counter.Reset();
+    BOOST_CHECK_EQUAL(counter.GetValue(), 0U);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestHistogramBuckets)
+{
+    // Exact buckets for small values, contiguous ranges for the rest.
+    for (Uint8 v = 0; v < CMetricHistogram::kSubBuckets; ++v) {
+        BOOST_CHECK_EQUAL(CMetricHistogram::GetBucketIndex(v), size_t(v));
+    }
+    for (size_t i = 1; i < CMetricHistogram::kBuckets; ++i) {
+        BOOST_CHECK_EQUAL(CMetricHistogram::GetBucketLowerBound(i),
+                          CMetricHistogram::GetBucketUpperBound(i - 1) + 1);
+    }
+    BOOST_CHECK_EQUAL(
+        CMetricHistogram::GetBucketUpperBound(CMetricHistogram::kBuckets - 1),
+        numeric_limits<Uint8>::max());
+    Uint8 values[] = { 16, 17, 100, 1000, 123456789, Uint8(1) << 40,
+                       numeric_limits<Uint8>::max() };
+    for (Uint8 v : values) {
+        size_t idx = CMetricHistogram::GetBucketIndex(v);
+        BOOST_CHECK(CMetricHistogram::GetBucketLowerBound(idx) <= v);
+        BOOST_CHECK(CMetricHistogram::GetBucketUpperBound(idx) >= v);
+        // Relative error is bounded by the sub-bucket resolution.
+        double width = double(CMetricHistogram::GetBucketUpperBound(idx) -
+                              CMetricHistogram::GetBucketLowerBound(idx));
+        BOOST_CHECK(width / double(v) <= 1.0 / double(CMetricHistogram::kSubBuckets));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestHistogramQuantiles)
+{
+    CMetricHistogram hist;
+    for (Uint8 v = 1; v <= 1000; ++v) {
+        hist.Record(v);
+    }
+    CMetricHistogram::CSnapshot snap = hist.GetSnapshot();
+    BOOST_CHECK_EQUAL(snap.GetCount(), 1000U);
+    BOOST_CHECK_EQUAL(snap.GetSum(), 500500U);
+    Uint8 p50 = snap.GetQuantile(0.5);
+    Uint8 p99 = snap.GetQuantile(0.99);
+    BOOST_CHECK(p50 >= 500  &&  p50 <= 500 + 500 / 16);
+    BOOST_CHECK(p99 >= 990  &&  p99 <= 990 + 990 / 16);
+    BOOST_CHECK_EQUAL(snap.GetQuantile(1.0),
+        CMetricHistogram::GetBucketUpperBound(
+            CMetricHistogram::GetBucketIndex(1000)));
+
+    snap.Merge(hist.GetSnapshot());
+    BOOST_CHECK_EQUAL(snap.GetCount(), 2000U);
+    BOOST_CHECK_EQUAL(snap.GetQuantile(0.5), p50);
+
+    CMetricHistogram::CSnapshot other(1e-3);
+    BOOST_CHECK_THROW(snap.Merge(other), CCoreException);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestRegistry)
+{
+    CMetricsRegistry reg;
+    TMetricLabels labels;
+    labels.push_back(make_pair(string("cmd"), string("get")));
+
+    CRef<CMetricCounter> c1 = reg.GetCounter("requests_total", "Requests",
+                                             labels);
+    CRef<CMetricCounter> c2 = reg.GetCounter("requests_total", "Requests",
+                                             labels);
+    BOOST_CHECK(c1 == c2);
+    BOOST_CHECK(c1 != reg.GetCounter("requests_total"));
+    BOOST_CHECK_THROW(reg.GetGauge("requests_total", "", labels),
+                      CCoreException);
+
+    c1->Add(5);
+    reg.GetGauge("connections")->Set(3);
+    reg.GetHistogram("latency_seconds", "Latency")->RecordSeconds(0.002);
+
+    CMetricsSnapshot snap = reg.GetSnapshot();
+    BOOST_REQUIRE(snap.Find("requests_total", labels));
+    BOOST_CHECK_EQUAL(snap.Find("requests_total", labels)->m_Value, 5);
+    BOOST_CHECK(snap.Find("connections"));
+    BOOST_CHECK(!snap.Find("no_such_metric"));
+
+    // Merging with itself doubles all values.
+    CMetricsSnapshot merged = snap;
+    merged.Merge(snap);
+    BOOST_CHECK_EQUAL(merged.Find("requests_total", labels)->m_Value, 10);
+    BOOST_CHECK_EQUAL(merged.Find("connections")->m_Value, 6);
+    BOOST_CHECK_EQUAL(
+        merged.Find("latency_seconds")->m_Histogram.GetCount(), 2U);
+
+    CNcbiOstrstream out;
+    snap.WriteText(out);
+    string text = CNcbiOstrstreamToString(out);
+    BOOST_CHECK(NStr::Find(text, "# TYPE requests_total counter\n")
+                != NPOS);
+    BOOST_CHECK(NStr::Find(text, "requests_total{cmd=\"get\"} 5\n") != NPOS);
+    BOOST_CHECK(NStr::Find(text, "requests_total 0\n") != NPOS);
+    BOOST_CHECK(NStr::Find(text, "connections 3\n") != NPOS);
+    BOOST_CHECK(NStr::Find(text, "# TYPE latency_seconds histogram\n")
+                != NPOS);
+    BOOST_CHECK(NStr::Find(text, "latency_seconds_bucket{le=\"+Inf\"} 1\n")
+                != NPOS);
+    BOOST_CHECK(NStr::Find(text, "latency_seconds_count 1\n") != NPOS);
+    // HELP and TYPE are printed once per name.
+    BOOST_CHECK_EQUAL(NStr::Find(text, "# TYPE requests_total"),
+                      NStr::Find(text, "# TYPE requests_total",
+                                 NStr::eCase, NStr::eReverseSearch));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestPerfLogGuard)
+{
+    // Read on the first Post()
+    CNcbiEnvironment().Set("LOG_PERFLOGGING_METRICS", "1");
+    CPerfLogger::SetON();
+    for (int i = 0;  i < 3;  ++i) {
+        CPerfLogGuard guard("test_metrics_resource");
+        guard.Post(i < 2 ? 200 : 404);
+    }
+    CPerfLogger::SetON(false);
+
+    TMetricLabels labels;
+    labels.push_back(make_pair(string("resource"),
+                               string("test_metrics_resource")));
+    labels.push_back(make_pair(string("status"), string("200")));
+    CMetricsSnapshot snap = CMetricsRegistry::Instance().GetSnapshot();
+    const CMetricsSnapshot::SEntry* m =
+        snap.Find("perf_log_duration_seconds", labels);
+    BOOST_REQUIRE(m);
+    BOOST_CHECK_EQUAL(m->m_Histogram.GetCount(), 2U);
+    labels.back().second = "404";
+    m = snap.Find("perf_log_duration_seconds", labels);
+    BOOST_REQUIRE(m);
+    BOOST_CHECK_EQUAL(m->m_Histogram.GetCount(), 1U);
+}
@@ -0,0 +1,141 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   TEST for:  CSamplingProfiler
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbi_profiler.hpp>
+#include <atomic>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+static atomic<Uint8> s_Sink(0);
+
+// Keep CPU busy for the specified time.
+static void s_BusyLoop(double seconds)
+{
+    CStopWatch sw(CStopWatch::eStart);
+    Uint8 x = 1;
+    while (sw.Elapsed() < seconds) {
+        for (int i = 0;  i < 100000;  ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+    }
+    s_Sink += x;
+}
+
+
+class CBusyThread : public CThread
+{
+protected:
+    virtual void* Main(void)
+    {
+        s_BusyLoop(0.3);
+        return NULL;
+    }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestProfilerApp : public CNcbiApplication
+{
+public:
+    virtual int Run(void);
+};
+
+
+int CTestProfilerApp::Run(void)
+{
+    if ( CSamplingProfiler::IsRunning() ) {
+        NcbiCout << "Profiler is enabled externally, test skipped" << NcbiEndl;
+        return 0;
+    }
+    string output = CFile::GetTmpName();
+    CFileDeleteAtExit::Add(output);
+    GetRWConfig().Set("Profiler", "Output", output);
+    GetRWConfig().Set("Profiler", "Frequency", "500");
+    // Two stacks plus "[other stacks]" at most
+    GetRWConfig().Set("Profiler", "MaxStacks", "2");
+
+    if ( !CSamplingProfiler::Start() ) {
+        NcbiCout << "Profiler is not supported, test skipped" << NcbiEndl;
+        return 0;
+    }
+    assert(CSamplingProfiler::IsRunning());
+
+    CRef<CThread> thr(new CBusyThread);
+    thr->Run();
+    s_BusyLoop(0.5);
+    thr->Join();
+
+    CSamplingProfiler::Stop();
+    assert( !CSamplingProfiler::IsRunning() );
+    Uint8 samples = CSamplingProfiler::GetSampleCount();
+    NcbiCout << "Samples: " << samples
+             << ", dropped: " << CSamplingProfiler::GetDroppedCount()
+             << NcbiEndl;
+    assert(samples > 0);
+
+    // Folded stacks: "frame;frame;... count"
+    CNcbiIfstream in(output.c_str());
+    assert(in);
+    string line;
+    size_t lines = 0;
+    Uint8 total = 0;
+    while (NcbiGetlineEOL(in, line)) {
+        SIZE_TYPE pos = line.rfind(' ');
+        assert(pos != NPOS  &&  pos > 0);
+        total += NStr::StringToUInt8(line.substr(pos + 1));
+        ++lines;
+    }
+    NcbiCout << "Stacks: " << lines << NcbiEndl;
+    assert(lines > 0  &&  lines <= 3);
+    assert(total > 0  &&  total <= samples);
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestProfilerApp().AppMain(argc, argv);
+}
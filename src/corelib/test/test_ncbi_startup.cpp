@@ -0,0 +1,158 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   TEST for:  CStartupTimeline, CRegistrySnapshot
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbireg.hpp>
+#include <corelib/metareg.hpp>
+#include <corelib/ncbi_startup.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+static void s_WriteFile(const string& path, const string& content)
+{
+    CNcbiOfstream out(path.c_str());
+    out << content;
+    assert(out);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestStartupApp : public CNcbiApplication
+{
+public:
+    virtual int Run(void);
+
+private:
+    void x_TestTimeline(void);
+    void x_TestSnapshot(void);
+};
+
+
+void CTestStartupApp::x_TestTimeline(void)
+{
+    CStartupTimeline::Mark("test phase 1");
+    CStartupTimeline::Mark("test phase 2");
+    assert(CStartupTimeline::GetElapsed() > 0);
+
+    CNcbiOstrstream out;
+    CStartupTimeline::Report(out);
+    string report = CNcbiOstrstreamToString(out);
+    NcbiCout << report;
+    // Phases marked by AppMain() so far, in order
+    const char* const kPhases[] = {
+        "load", "diag setup", "config load", "Init()", "log options",
+        "test phase 1", "test phase 2"
+    };
+    SIZE_TYPE pos = 0;
+    for (size_t i = 0;  i < ArraySize(kPhases);  ++i) {
+        pos = report.find(string("\n") + kPhases[i] + ' ', pos);
+        assert(pos != NPOS);
+    }
+}
+
+
+void CTestStartupApp::x_TestSnapshot(void)
+{
+    CDir dir(CDirEntry::GetTmpName());
+    assert(dir.Create());
+    string base     = CDirEntry::MakePath(dir.GetPath(), "base.ini");
+    string main     = CDirEntry::MakePath(dir.GetPath(), "main.ini");
+    string snapshot = CDirEntry::MakePath(dir.GetPath(), "main.snapshot");
+    s_WriteFile(base, "[Base]\nvalue = 1\n[Main]\nvalue = base\n");
+    s_WriteFile(main, "[NCBI]\n.Inherits = base\n[Main]\nvalue = main\n");
+
+    // The meta-registry keeps a reference to the loaded registry
+    CRef<CNcbiRegistry> reg(new CNcbiRegistry);
+    CMetaRegistry::SEntry entry = CMetaRegistry::Load
+        (main, CMetaRegistry::eName_AsIs, 0, 0, reg.GetPointer());
+    assert(entry.registry);
+    assert(reg->Get("Base", "value") == "1");
+    assert(reg->Get("Main", "value") == "main");
+    assert(CRegistrySnapshot::Save(snapshot, "key", *reg, entry.actual_name));
+
+    // Flat copy of all layers, no base registries needed
+    {{
+        CNcbiRegistry reg2;
+        string config_path;
+        assert(CRegistrySnapshot::Load(snapshot, "key", reg2, &config_path));
+        assert(config_path == entry.actual_name);
+        assert(reg2.Get("Base", "value") == "1");
+        assert(reg2.Get("Main", "value") == "main");
+    }}
+    // Different key
+    {{
+        CNcbiRegistry reg2;
+        assert( !CRegistrySnapshot::Load(snapshot, "other", reg2, NULL) );
+        assert(reg2.Get("Main", "value").empty());
+    }}
+    // Changed base registry
+    {{
+        s_WriteFile(base, "[Base]\nvalue = 22\n");
+        CNcbiRegistry reg2;
+        assert( !CRegistrySnapshot::Load(snapshot, "key", reg2, NULL) );
+    }}
+    // Missing or damaged snapshot
+    {{
+        CNcbiRegistry reg2;
+        assert( !CRegistrySnapshot::Load(snapshot + ".none", "key", reg2,
+                                         NULL) );
+        s_WriteFile(snapshot, "[Main]\nvalue = main\n");
+        assert( !CRegistrySnapshot::Load(snapshot, "key", reg2, NULL) );
+    }}
+    dir.Remove(CDirEntry::eRecursive);
+}
+
+
+int CTestStartupApp::Run(void)
+{
+    x_TestTimeline();
+    x_TestSnapshot();
+    NcbiCout << "Test completed successfully" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestStartupApp().AppMain(argc, argv);
+}
@@ -0,0 +1,202 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Test for CAsyncDiagHandler in multithreaded environment
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/test_mt.hpp>
+#include <corelib/ncbidiag.hpp>
+#include <corelib/ncbienv.hpp>
+#include <corelib/ncbi_system.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Handler receiving messages from the asynchronous writer thread
+
+class CCheckingDiagHandler : public CDiagHandler
+{
+public:
+    CCheckingDiagHandler(void)
+        : m_Count(0), m_Warnings(0), m_Errors(0), m_Delay(0) {}
+
+    virtual void Post(const SDiagMessage& mess)
+    {
+        // Messages from a single thread must arrive in order.
+        // Format: "<thread> <post>".
+        string text(mess.m_Buffer, mess.m_BufferLen);
+        string thr, num;
+        if ( !NStr::SplitInTwo(text, " ", thr, num) ) {
+            return;
+        }
+        int idx = NStr::StringToInt(thr, NStr::fConvErr_NoThrow);
+        int post = NStr::StringToInt(num, NStr::fConvErr_NoThrow);
+        if (post <= 0) {
+            // Not a test message.
+            return;
+        }
+        if ( m_Delay ) {
+            // Slow writer makes the posting threads overflow the queue.
+            SleepMicroSec(m_Delay);
+        }
+        CFastMutexGuard guard(m_Mutex);
+        int& last = m_LastPost[idx];
+        // Without dropping every post must arrive, otherwise the posts
+        // that arrive still must be in order.
+        if (m_ExpectAll ? post != last + 1 : post <= last) {
+            ++m_Errors;
+        }
+        last = post;
+        ++m_Count;
+        if (mess.m_Severity == eDiag_Warning) {
+            ++m_Warnings;
+        }
+    }
+
+    CFastMutex    m_Mutex;
+    map<int, int> m_LastPost;
+    int           m_Count;
+    int           m_Warnings;
+    int           m_Errors;
+    unsigned long m_Delay;
+    bool          m_ExpectAll;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+/// Every this many posts are made with warning severity which is never
+/// dropped by the 'Sample' overflow policy.
+static const int kWarningPeriod = 10;
+
+
+class CTestAsyncDiagApp : public CThreadedApp
+{
+public:
+    virtual bool Thread_Run(int idx);
+protected:
+    virtual bool TestApp_Args(CArgDescriptions& args);
+    virtual bool TestApp_Init(void);
+    virtual bool TestApp_Exit(void);
+private:
+    int m_Posts;
+    string m_Policy;
+    CCheckingDiagHandler m_Checker;
+    CAsyncDiagHandler m_AsyncHandler;
+};
+
+
+bool CTestAsyncDiagApp::TestApp_Args(CArgDescriptions& args)
+{
+    args.AddDefaultKey("posts", "Posts",
+                       "Number of messages posted by each thread",
+                       CArgDescriptions::eInteger, "2000");
+    args.AddDefaultKey("policy", "Policy",
+                       "Overflow policy of the asynchronous queue",
+                       CArgDescriptions::eString, "Block");
+    args.SetConstraint("policy",
+                       &(*new CArgAllow_Strings, "Block", "Drop", "Sample"));
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::Thread_Run(int idx)
+{
+    for (int i = 1; i <= m_Posts; ++i) {
+        if (i % kWarningPeriod == 0) {
+            ERR_POST(Warning << idx << " " << i);
+        }
+        else {
+            ERR_POST(Info << idx << " " << i);
+        }
+    }
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::TestApp_Init(void)
+{
+    m_Posts = GetArgs()["posts"].AsInteger();
+    m_Policy = GetArgs()["policy"].AsString();
+    // Use a tiny queue so that the posting threads hit the overflow.
+    SetEnvironment().Set("DIAG_MAX_ASYNC_QUEUE_SIZE", "16");
+    SetEnvironment().Set("DIAG_ASYNC_OVERFLOW_POLICY", m_Policy);
+    m_Checker.m_ExpectAll = m_Policy == "Block";
+    if ( !m_Checker.m_ExpectAll ) {
+        m_Checker.m_Delay = 50;
+    }
+
+    SetDiagPostLevel(eDiag_Info);
+    SetDiagPostAllFlags(eDPF_Default & ~eDPF_Log);
+    // The checker is owned by the application, not by diagnostics.
+    SetDiagHandler(&m_Checker, false);
+    m_AsyncHandler.Install();
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::TestApp_Exit(void)
+{
+    Uint8 dropped = m_AsyncHandler.GetDroppedCount();
+    // Puts the checker back, still not owned by diagnostics.
+    m_AsyncHandler.RemoveFromDiag();
+    SetDiagStream(&NcbiCerr);
+
+    int expected = m_Posts * (int)s_NumThreads;
+    NcbiCout << "Policy " << m_Policy
+             << ", messages received: " << m_Checker.m_Count
+             << " of " << expected << ", dropped: " << dropped << NcbiEndl;
+    _ASSERT(m_Checker.m_Errors == 0);
+    _ASSERT(m_Checker.m_Count + dropped == Uint8(expected));
+    if (m_Policy == "Block") {
+        _ASSERT(dropped == 0);
+    }
+    else {
+        _ASSERT(dropped != 0);
+    }
+    if (m_Policy == "Sample") {
+        // Warnings are never dropped by sampling.
+        _ASSERT(m_Checker.m_Warnings == (m_Posts / kWarningPeriod) * (int)s_NumThreads);
+    }
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestAsyncDiagApp().AppMain(argc, argv);
+}
@@ -972,6 +972,91 @@ static void s_TEST_Dir(void)
 }
 
 
+//----------------------------------------------------------------------------
+//  Directory traversal
+//----------------------------------------------------------------------------
+
+static void s_TEST_DirWalker(void)
+{
+    CDirEntry("walk").Remove();
+    assert( CDir("walk/a/aa").CreatePath() );
+    assert( CDir("walk/b").CreatePath() );
+    assert( CDir("walk/skip/deep").CreatePath() );
+    s_CreateTestFile("walk/file.txt");
+    s_CreateTestFile("walk/a/file.txt");
+    s_CreateTestFile("walk/a/aa/file.dat");
+    s_CreateTestFile("walk/b/file.txt");
+    s_CreateTestFile("walk/skip/deep/file.txt");
+
+    CMaskFileName all;
+    vector<string> expected;
+    {{
+        vector<string> paths(1, "walk");
+        vector<string> masks;
+        FindFiles(expected, paths.begin(), paths.end(), masks,
+                  fFF_All | fFF_Recursive);
+        sort(expected.begin(), expected.end());
+        assert( expected.size() == 10 );
+    }}
+    for (unsigned int threads = 1;  threads <= 4;  threads *= 2) {
+        // All entries
+        CDirWalker walker(fFF_All | fFF_Recursive, threads);
+        vector<string> found;
+        assert( walker.Walk("walk", all,
+            [&found](const CDirWalker::CEntry& entry) {
+                assert( NStr::EndsWith(entry.GetPath(), entry.GetName()) );
+                assert( entry.GetType() == (CDirEntry(entry.GetPath()).IsDir()
+                                            ? CDirEntry::eDir : CDirEntry::eFile) );
+                found.push_back(entry.GetPath());
+                return CDirWalker::eContinue;
+            }) );
+        sort(found.begin(), found.end());
+        assert( found == expected );
+
+        // Files matching a mask only, skip one subtree
+        CDirWalker file_walker(fFF_File | fFF_Recursive, threads);
+        CMaskFileName masks;
+        masks.Add("*.txt");
+        found.clear();
+        assert( file_walker.Walk("walk", masks, all,
+            [&found](const CDirWalker::CEntry& entry) {
+                assert( entry.GetType() == CDirEntry::eFile );
+                found.push_back(entry.GetPath());
+                return CDirWalker::eContinue;
+            }) );
+        assert( found.size() == 4 );
+
+        CDirWalker dir_walker(fFF_Dir | fFF_Recursive, threads);
+        found.clear();
+        assert( dir_walker.Walk("walk", all,
+            [&found](const CDirWalker::CEntry& entry) {
+                assert( entry.GetType() == CDirEntry::eDir );
+                found.push_back(entry.GetPath());
+                return entry.GetName() == "skip" ?
+                    CDirWalker::eSkipDir : CDirWalker::eContinue;
+            }) );
+        assert( found.size() == 4 );
+
+        // Stop traversal
+        size_t count = 0;
+        assert( !walker.Walk("walk", all,
+            [&count](const CDirWalker::CEntry&) {
+                ++count;
+                return CDirWalker::eStop;
+            }) );
+        assert( count == 1 );
+    }
+    // Not existing directory
+    assert( CDirWalker().Walk("walk/not_existing_dir", all,
+        [](const CDirWalker::CEntry&) {
+            _TROUBLE;
+            return CDirWalker::eContinue;
+        }) );
+
+    assert( CDir("walk").Remove() );
+}
+
+
 //----------------------------------------------------------------------------
 //  Work with symbolic links
 //----------------------------------------------------------------------------
@@ -1703,6 +1788,7 @@ int CTest::Run(void)
         s_TEST_File();
         // CDir
         s_TEST_Dir();
+        s_TEST_DirWalker();
         // CSymLink
         s_TEST_Link();
         // CMemoryFile
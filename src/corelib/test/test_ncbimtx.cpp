@@ -126,3 +126,51 @@ BOOST_AUTO_TEST_CASE(MutexRace)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_AUTO_TEST_SUITE(ReadBiasedRWLock)
+
+BOOST_AUTO_TEST_CASE(ReadWriteRace)
+{
+    const size_t kReaderCount = 8;
+    const size_t kWriterCount = 2;
+    const size_t kPassCount = 20000;
+
+    CReadBiasedRWLock lock;
+    // Writers keep both values equal, readers must never see them differ.
+    size_t value1 = 0, value2 = 0;
+    atomic<int> writers(0);
+    atomic<size_t> errors(0);
+
+    vector<thread> tt;
+    for ( size_t i = 0; i < kReaderCount; ++i ) {
+        tt.push_back(thread([&]() {
+            for ( size_t p = 0; p < kPassCount; ++p ) {
+                CReadBiasedRWLock::TReadLockGuard guard(lock);
+                if ( value1 != value2  ||  writers.load() != 0 ) {
+                    ++errors;
+                }
+            }
+        }));
+    }
+    for ( size_t i = 0; i < kWriterCount; ++i ) {
+        tt.push_back(thread([&]() {
+            for ( size_t p = 0; p < kPassCount / 100; ++p ) {
+                CReadBiasedRWLock::TWriteLockGuard guard(lock);
+                if ( ++writers != 1 ) {
+                    ++errors;
+                }
+                ++value1;
+                ++value2;
+                --writers;
+            }
+        }));
+    }
+    for ( auto& t : tt ) {
+        t.join();
+    }
+    BOOST_CHECK_EQUAL(errors.load(), 0u);
+    BOOST_CHECK_EQUAL(value1, kWriterCount*(kPassCount/100));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
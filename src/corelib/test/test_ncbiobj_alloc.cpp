@@ -0,0 +1,214 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   TEST for:  CObject thread-caching allocator
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiobj.hpp>
+#include <thread>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <corelib/test_boost.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+template<size_t Size>
+class CSizedObject : public CObject
+{
+public:
+    CSizedObject(int value) : m_Value(value)
+        {
+            memset(m_Data, value, sizeof(m_Data));
+        }
+    bool IsValid(void) const
+        {
+            for (size_t i = 0; i < sizeof(m_Data); ++i) {
+                if (m_Data[i] != char(m_Value)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+private:
+    int  m_Value;
+    char m_Data[Size];
+};
+
+
+struct SAllocatorModeGuard
+{
+    SAllocatorModeGuard(CObject::EAllocatorMode mode)
+        : m_Saved(CObject::GetAllocatorMode())
+        {
+            CObject::SetAllocatorMode(mode);
+        }
+    ~SAllocatorModeGuard(void)
+        {
+            CObject::SetAllocatorMode(m_Saved);
+        }
+    CObject::EAllocatorMode m_Saved;
+};
+
+
+BOOST_AUTO_TEST_CASE(TestSetMode)
+{
+    SAllocatorModeGuard guard(CObject::eAllocatorHeap);
+    CObject::SetAllocatorMode("threadcache");
+    BOOST_CHECK_EQUAL(CObject::GetAllocatorMode(),
+                      CObject::eAllocatorThreadCache);
+    CObject::SetAllocatorMode("unknown");
+    BOOST_CHECK_EQUAL(CObject::GetAllocatorMode(),
+                      CObject::eAllocatorThreadCache);
+    CObject::SetAllocatorMode("Heap");
+    BOOST_CHECK_EQUAL(CObject::GetAllocatorMode(), CObject::eAllocatorHeap);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestThreadCache)
+{
+    SAllocatorModeGuard guard(CObject::eAllocatorThreadCache);
+    CObject::SAllocatorStats before, after;
+    CObject::GetAllocatorThreadStats(before);
+
+    const int kCount = 1000;
+    vector< CRef<CObject> > objs;
+    for (int i = 0; i < kCount; ++i) {
+        objs.push_back(CRef<CObject>(new CSizedObject<8>(i)));
+        objs.push_back(CRef<CObject>(new CSizedObject<200>(i)));
+        objs.push_back(CRef<CObject>(new CSizedObject<900>(i)));
+        objs.push_back(CRef<CObject>(new CSizedObject<4000>(i)));
+        BOOST_CHECK(objs.back()->CanBeDeleted());
+    }
+    CObject::GetAllocatorThreadStats(after);
+    // The largest objects are served by the global operator new.
+    BOOST_CHECK_EQUAL(after.m_Allocations - before.m_Allocations,
+                      Uint8(3 * kCount));
+    BOOST_CHECK(after.m_ReservedBytes > 0);
+
+    for (size_t i = 0; i < objs.size(); i += 4) {
+        BOOST_CHECK((static_cast<CSizedObject<8>&>(*objs[i]).IsValid()));
+        BOOST_CHECK((static_cast<CSizedObject<200>&>(*objs[i+1]).IsValid()));
+        BOOST_CHECK((static_cast<CSizedObject<900>&>(*objs[i+2]).IsValid()));
+    }
+    objs.clear();
+    CObject::GetAllocatorThreadStats(after);
+    BOOST_CHECK_EQUAL(after.m_Deallocations - before.m_Deallocations,
+                      Uint8(3 * kCount));
+    BOOST_CHECK_EQUAL(after.m_AllocatedBytes - before.m_AllocatedBytes,
+                      after.m_FreedBytes - before.m_FreedBytes);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCacheLimit)
+{
+    // Allocate and free far more blocks than a thread may keep cached,
+    // in a new thread to start with an empty cache.
+    SAllocatorModeGuard guard(CObject::eAllocatorThreadCache);
+    const int kCount = 10000;
+    // A thread keeps less than 64 free blocks of a size class.
+    const Uint8 kMaxCached = 64 * 64;
+    CObject::SAllocatorStats allocated, freed;
+    thread thr([&]() {
+        vector< CRef<CObject> > objs;
+        for (int i = 0; i < kCount; ++i) {
+            objs.push_back(CRef<CObject>(new CSizedObject<16>(i)));
+        }
+        CObject::GetAllocatorThreadStats(allocated);
+        objs.clear();
+        CObject::GetAllocatorThreadStats(freed);
+    });
+    thr.join();
+    BOOST_CHECK(allocated.m_CachedBytes < kMaxCached);
+    BOOST_CHECK(freed.m_CachedBytes > 0);
+    BOOST_CHECK(freed.m_CachedBytes < kMaxCached);
+    BOOST_CHECK_EQUAL(freed.m_AllocatedBytes, freed.m_FreedBytes);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestModeSwitch)
+{
+    // Objects must be freed properly whatever mode was active
+    // when they were allocated.
+    CRef<CObject> heap_obj, tc_obj;
+    {{
+        SAllocatorModeGuard guard(CObject::eAllocatorHeap);
+        heap_obj.Reset(new CSizedObject<32>(1));
+    }}
+    {{
+        SAllocatorModeGuard guard(CObject::eAllocatorThreadCache);
+        tc_obj.Reset(new CSizedObject<32>(2));
+        heap_obj.Reset();
+    }}
+    {{
+        SAllocatorModeGuard guard(CObject::eAllocatorHeap);
+        BOOST_CHECK(tc_obj->CanBeDeleted());
+        tc_obj.Reset();
+    }}
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCrossThreadFree)
+{
+    SAllocatorModeGuard guard(CObject::eAllocatorThreadCache);
+    const int kThreads = 4;
+    const int kCount = 10000;
+    vector< vector< CRef<CObject> > > objs(kThreads);
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.push_back(thread([&objs, t]() {
+            for (int i = 0; i < kCount; ++i) {
+                objs[t].push_back(CRef<CObject>(new CSizedObject<48>(t)));
+            }
+        }));
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+    threads.clear();
+    // Release objects in threads other than the allocating ones.
+    for (int t = 0; t < kThreads; ++t) {
+        threads.push_back(thread([&objs, t]() {
+            vector< CRef<CObject> >& v = objs[(t + 1) % kThreads];
+            for (auto& obj : v) {
+                if ( !static_cast<CSizedObject<48>&>(*obj).IsValid() ) {
+                    throw runtime_error("corrupted object");
+                }
+            }
+            v.clear();
+        }));
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+}
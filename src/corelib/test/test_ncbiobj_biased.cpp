@@ -0,0 +1,355 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Test and benchmark for biased reference counting (CBiasedObject)
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbiobj.hpp>
+#include <corelib/ncbitime.hpp>
+#include <atomic>
+#include <thread>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+static atomic<int> s_LiveObjects(0);
+
+
+// Feature-like objects with the regular and the biased reference counter
+template<class TBase>
+class CTestFeat : public TBase
+{
+public:
+    CTestFeat(int value) : m_Value(value) { ++s_LiveObjects; }
+    ~CTestFeat(void) { --s_LiveObjects; }
+    int m_Value;
+};
+
+typedef CTestFeat<CObject>       CPlainFeat;
+typedef CTestFeat<CBiasedObject> CBiasedFeat;
+
+
+struct SPlainTraits
+{
+    typedef CPlainFeat                                 TFeat;
+    typedef CRef<CPlainFeat, CObjectCounterLocker>     TRef;
+    typedef CConstRef<CPlainFeat, CObjectCounterLocker> TConstRef;
+};
+
+struct SBiasedTraits
+{
+    typedef CBiasedFeat                                 TFeat;
+    typedef CRef<CBiasedFeat, CBiasedObjectLocker>      TRef;
+    typedef CConstRef<CBiasedFeat, CBiasedObjectLocker> TConstRef;
+};
+
+
+// Mimics the feature iterator: each step builds a "mapped feature" that
+// holds references to the original and the mapped objects, buffers it,
+// and the caller copies it out of the buffer.
+template<class Traits>
+struct SMappedFeat
+{
+    typename Traits::TConstRef m_Orig;
+    typename Traits::TConstRef m_Mapped;
+};
+
+
+template<class Traits>
+static Uint8 s_IterateFeatures(const vector<typename Traits::TRef>& annot)
+{
+    const size_t kPageSize = 16;
+    vector< SMappedFeat<Traits> > page;
+    page.reserve(kPageSize);
+    Uint8 sum = 0;
+    for (size_t i = 0;  i < annot.size();  ) {
+        page.clear();
+        for ( ;  i < annot.size()  &&  page.size() < kPageSize;  ++i) {
+            SMappedFeat<Traits> feat;
+            feat.m_Orig   = annot[i];
+            feat.m_Mapped = annot[(i + 1) % annot.size()];
+            page.push_back(feat);
+        }
+        ITERATE(typename vector< SMappedFeat<Traits> >, it, page) {
+            SMappedFeat<Traits> feat = *it;
+            sum += feat.m_Orig->m_Value + feat.m_Mapped->m_Value;
+        }
+    }
+    return sum;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestBiasedObjectApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    void x_TestCrossThread(unsigned int threads);
+    void x_TestOwnerExit(void);
+    void x_TestMixedLockers(void);
+    void x_TestReferencedOnlyOnce(void);
+
+    template<class Traits>
+    double x_Benchmark(size_t features, int passes, unsigned int threads,
+                       bool shared);
+};
+
+
+void CTestBiasedObjectApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "Biased reference counting test and benchmark");
+    d->AddDefaultKey("features", "N", "Number of features per annotation",
+                     CArgDescriptions::eInteger, "100000");
+    d->AddDefaultKey("passes", "N", "Number of iterations over annotation",
+                     CArgDescriptions::eInteger, "20");
+    d->AddDefaultKey("threads", "N", "Number of threads",
+                     CArgDescriptions::eInteger, "4");
+    SetupArgDescriptions(d.release());
+}
+
+
+// References created by the owner are copied and released by other threads,
+// partly after the owner has released its own.
+void CTestBiasedObjectApp::x_TestCrossThread(unsigned int threads)
+{
+    typedef SBiasedTraits::TRef TRef;
+    vector<TRef> objects;
+    for (int i = 0;  i < 1000;  ++i) {
+        objects.push_back(TRef(new CBiasedFeat(i)));
+    }
+    vector< vector<TRef> > copies(threads, objects);
+    atomic<bool> go(false);
+    vector<thread> tt;
+    for (unsigned int t = 0;  t < threads;  ++t) {
+        tt.push_back(thread([&, t]() {
+            while ( !go ) {
+                this_thread::yield();
+            }
+            for (int pass = 0;  pass < 10;  ++pass) {
+                vector<TRef> tmp(copies[t]);
+                _VERIFY(s_IterateFeatures<SBiasedTraits>(tmp) > 0);
+            }
+            copies[t].clear();
+        }));
+    }
+    go = true;
+    objects.clear();
+    for (auto& t : tt) {
+        t.join();
+    }
+    CBiasedObject::ProcessQueuedReleases();
+    assert(s_LiveObjects == 0);
+}
+
+
+// The owner thread exits while other threads still hold its references.
+void CTestBiasedObjectApp::x_TestOwnerExit(void)
+{
+    typedef SBiasedTraits::TRef TRef;
+    vector<TRef> objects;
+    thread([&]() {
+        for (int i = 0;  i < 1000;  ++i) {
+            TRef ref(new CBiasedFeat(i));
+            objects.push_back(ref);
+            objects.push_back(ref);
+        }
+    }).join();
+    assert(s_LiveObjects == 1000);
+    objects.clear();
+    assert(s_LiveObjects == 0);
+}
+
+
+// Biased and regular references to the same objects.
+void CTestBiasedObjectApp::x_TestMixedLockers(void)
+{
+    vector< CRef<CObject> > plain;
+    {{
+        vector<SBiasedTraits::TRef> biased;
+        for (int i = 0;  i < 100;  ++i) {
+            biased.push_back(SBiasedTraits::TRef(new CBiasedFeat(i)));
+            plain.push_back(CRef<CObject>(biased.back().GetPointer()));
+        }
+        thread([&]() {
+            vector<SBiasedTraits::TRef> tmp(biased);
+            plain.clear();
+        }).join();
+        assert(s_LiveObjects == 100);
+    }}
+    CBiasedObject::ProcessQueuedReleases();
+    assert(s_LiveObjects == 0);
+}
+
+
+// Copy-on-write checks must count the owner's references.
+void CTestBiasedObjectApp::x_TestReferencedOnlyOnce(void)
+{
+    typedef SBiasedTraits::TRef TRef;
+
+    // Two owner references
+    TRef ref(new CBiasedFeat(0));
+    assert(ref->Referenced());
+    assert(ref->ReferencedOnlyOnce());
+    TRef ref2(ref);
+    assert(ref->Referenced());
+    assert( !ref->ReferencedOnlyOnce() );
+    // CObject sees the owner's references only as a group
+    assert( !static_cast<const CObject&>(*ref).ReferencedOnlyOnce() );
+    ref2.Reset();
+    assert(ref->ReferencedOnlyOnce());
+
+    // One owner and one remote reference
+    atomic<int> step(0);
+    thread remote([&]() {
+        TRef ref3(ref);
+        step = 1;
+        while (step != 2) {
+            this_thread::yield();
+        }
+        assert( !ref3->ReferencedOnlyOnce() );
+    });
+    while (step != 1) {
+        this_thread::yield();
+    }
+    assert( !ref->ReferencedOnlyOnce() );
+    assert( !static_cast<const CObject&>(*ref).ReferencedOnlyOnce() );
+    step = 2;
+    remote.join();
+    assert(ref->ReferencedOnlyOnce());
+
+    // Owner reference released by another thread, not merged yet
+    ref2 = ref;
+    thread([&]() { ref2.Reset(); }).join();
+    assert(ref->ReferencedOnlyOnce());
+    CBiasedObject::ProcessQueuedReleases();
+    assert(ref->ReferencedOnlyOnce());
+    ref.Reset();
+    assert(s_LiveObjects == 0);
+}
+
+
+// Return feature references per second.  With 'shared' all threads
+// iterate over the same annotation created by the main thread, otherwise
+// each thread creates its own.
+template<class Traits>
+double CTestBiasedObjectApp::x_Benchmark(size_t features, int passes,
+                                         unsigned int threads, bool shared)
+{
+    typedef typename Traits::TFeat TFeat;
+    typedef typename Traits::TRef  TRef;
+
+    vector<TRef> common;
+    if ( shared ) {
+        for (size_t i = 0;  i < features;  ++i) {
+            common.push_back(TRef(new TFeat(int(i))));
+        }
+    }
+    atomic<Uint8> sink(0);
+    CStopWatch sw(CStopWatch::eStart);
+    vector<thread> tt;
+    for (unsigned int t = 0;  t < threads;  ++t) {
+        tt.push_back(thread([&]() {
+            vector<TRef> own;
+            if ( !shared ) {
+                for (size_t i = 0;  i < features;  ++i) {
+                    own.push_back(TRef(new TFeat(int(i))));
+                }
+            }
+            const vector<TRef>& annot = shared ? common : own;
+            Uint8 sum = 0;
+            for (int pass = 0;  pass < passes;  ++pass) {
+                sum += s_IterateFeatures<Traits>(annot);
+            }
+            sink += sum;
+        }));
+    }
+    for (auto& t : tt) {
+        t.join();
+    }
+    double elapsed = sw.Elapsed();
+    assert(sink > 0);
+    return double(features) * passes * threads / elapsed;
+}
+
+
+int CTestBiasedObjectApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    size_t features = (size_t) args["features"].AsInteger();
+    int passes = args["passes"].AsInteger();
+    unsigned int threads = (unsigned int) args["threads"].AsInteger();
+
+    x_TestCrossThread(threads);
+    x_TestOwnerExit();
+    x_TestMixedLockers();
+    x_TestReferencedOnlyOnce();
+    NcbiCout << "Correctness tests passed" << NcbiEndl;
+
+    for (unsigned int n : { 1u, threads }) {
+        for (bool shared : { false, true }) {
+            if (n == 1  &&  shared) {
+                continue;
+            }
+            double plain  = x_Benchmark<SPlainTraits> (features, passes,
+                                                       n, shared);
+            double biased = x_Benchmark<SBiasedTraits>(features, passes,
+                                                       n, shared);
+            NcbiCout << "threads=" << n
+                     << (shared ? " shared annot " : " own annot    ")
+                     << " CObject: " << setw(12) << Uint8(plain)
+                     << "  CBiasedObject: " << setw(12) << Uint8(biased)
+                     << " features/s  x" << setprecision(2) << fixed
+                     << biased / plain << NcbiEndl;
+        }
+    }
+    assert(s_LiveObjects == 0);
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestBiasedObjectApp().AppMain(argc, argv);
+}
@@ -39,7 +39,10 @@
 #include <corelib/ncbiexec.hpp>
 #include <corelib/ncbifile.hpp>
 #include <corelib/ncbi_test.hpp>
+#include <corelib/ncbistr_util.hpp>
+#include <corelib/impl/ncbistr_simd.hpp>
 #include <algorithm>
+#include <random>
 #include <locale.h>
 #include <math.h>
 
@@ -5421,3 +5424,164 @@ NCBITEST_INIT_TREE()
     NCBITEST_DISABLE(s_StringToInt_Speed);
     NCBITEST_DISABLE(s_StringToDouble_Speed);
 }
+
+
+//----------------------------------------------------------------------------
+// CStrSplitter
+//----------------------------------------------------------------------------
+
+// Random string over the given alphabet, up to max_len characters
+static string s_RandomString(minstd_rand& rnd, const char* alphabet,
+                             size_t max_len)
+{
+    size_t n = strlen(alphabet);
+    string str;
+    for (size_t len = rnd() % (max_len + 1);  len;  --len) {
+        str += alphabet[rnd() % n];
+    }
+    return str;
+}
+
+
+BOOST_AUTO_TEST_CASE(s_StrSplitter)
+{
+    const NStr::TSplitFlags kFlags[] = {
+        0,
+        NStr::fSplit_MergeDelimiters,
+        NStr::fSplit_Truncate_Begin,
+        NStr::fSplit_Truncate_End,
+        NStr::fSplit_Truncate,
+        NStr::fSplit_Tokenize
+    };
+    minstd_rand rnd(1);
+    for (int n = 0;  n < 2000;  ++n) {
+        string str = s_RandomString(rnd, "ab,; ", 12);
+        for (auto flags : kFlags) {
+            vector<CTempString> expected;
+            NStr::Split(str, ",; ", expected, flags);
+            vector<CTempString> tokens;
+            CStrSplitter splitter(str, ",; ", flags);
+            CTempString token;
+            while ( splitter.Next(token) ) {
+                tokens.push_back(token);
+            }
+            BOOST_REQUIRE_MESSAGE(tokens == expected,
+                                  "\"" << str << "\", flags " << flags);
+        }
+    }
+    BOOST_CHECK_THROW(CStrSplitter("a", ",", NStr::fSplit_CanQuote),
+                      CStringException);
+}
+
+
+//----------------------------------------------------------------------------
+// SIMD back ends must give the same results as the scalar one
+//----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(s_StrSimd)
+{
+    const CStrSimd::EBackend saved = CStrSimd::GetBackend();
+    const char* kAlphabet = "aAbBzZ@[`{ \t,;\xC3\xA9\xE2\x82\xAC\xFF";
+
+    minstd_rand rnd(2);
+    for (int n = 0;  n < 500;  ++n) {
+        string s1 = s_RandomString(rnd, kAlphabet, 100);
+        // mostly equal ignoring case
+        string s2 = s1;
+        for (size_t i = 0;  i < s2.size();  ++i) {
+            if (rnd() % 20 == 0) {
+                s2[i] = kAlphabet[rnd() % strlen(kAlphabet)];
+            } else if (rnd() % 2) {
+                s2[i] = (char) toupper((unsigned char) s2[i]);
+            }
+        }
+        string pattern;
+        if ( !s2.empty() ) {
+            pattern = s2.substr(rnd() % s2.size(), rnd() % 5 + 1);
+        }
+
+        BOOST_REQUIRE(CStrSimd::SetBackend(CStrSimd::eScalar));
+        int       cmp   = NStr::CompareNocase(s1, s2);
+        int       cmp2  = NStr::CompareNocase(s1, 1, NPOS, s2);
+        SIZE_TYPE found = NStr::Find(s1, pattern, NStr::eNocase);
+        SIZE_TYPE occ   = NStr::Find(s1, pattern, NStr::eNocase,
+                                     NStr::eForwardSearch, 1);
+        string    lower = s1;
+        NStr::ToLower(lower);
+        EEncoding enc   = CUtf8::GuessEncoding(s1);
+        vector<CTempString> tokens;
+        NStr::Split(s1, " \t,;", tokens);
+
+        for (auto backend : { CStrSimd::eSSE42, CStrSimd::eAVX2 }) {
+            if ( !CStrSimd::SetBackend(backend) ) {
+                continue;
+            }
+            BOOST_CHECK_EQUAL(cmp,   NStr::CompareNocase(s1, s2));
+            BOOST_CHECK_EQUAL(cmp2,  NStr::CompareNocase(s1, 1, NPOS, s2));
+            BOOST_CHECK_EQUAL(found, NStr::Find(s1, pattern, NStr::eNocase));
+            BOOST_CHECK_EQUAL(occ,   NStr::Find(s1, pattern, NStr::eNocase,
+                                                NStr::eForwardSearch, 1));
+            string l = s1;
+            NStr::ToLower(l);
+            BOOST_CHECK_EQUAL(lower, l);
+            BOOST_CHECK(enc == CUtf8::GuessEncoding(s1));
+            vector<CTempString> t;
+            NStr::Split(s1, " \t,;", t);
+            BOOST_CHECK(tokens == t);
+        }
+    }
+    CStrSimd::SetBackend(saved);
+}
+
+
+// In other locales case-insensitive operations must follow tolower()
+BOOST_AUTO_TEST_CASE(s_StrSimdLocale)
+{
+    const char* kLocales[] = {
+        "tr_TR.ISO-8859-9", "de_DE.ISO-8859-1", "en_US.ISO-8859-1"
+    };
+    string saved = setlocale(LC_CTYPE, NULL);
+    const char* lc = NULL;
+    for (const char* name : kLocales) {
+        if (setlocale(LC_CTYPE, name)) {
+            lc = name;
+            break;
+        }
+    }
+#if defined(NCBI_OS_UNIX)  &&  defined(LC_GLOBAL_LOCALE)
+    // Per-thread locale, still takes the tolower() way
+    locale_t thr_locale = (locale_t) 0;
+    if ( !lc ) {
+        thr_locale = newlocale(LC_CTYPE_MASK, "C", (locale_t) 0);
+        BOOST_REQUIRE(thr_locale != (locale_t) 0);
+        uselocale(thr_locale);
+        lc = "per-thread C";
+    }
+#endif
+    if ( !lc ) {
+        BOOST_TEST_MESSAGE("No single-byte locale available, skipped");
+        return;
+    }
+    BOOST_TEST_MESSAGE("Locale: " << lc);
+    string upper, lower;
+    for (int c = 1;  c < 256;  ++c) {
+        upper += (char) c;
+        lower += (char) tolower(c);
+    }
+    string l = upper;
+    NStr::ToLower(l);
+    BOOST_CHECK_EQUAL(l, lower);
+    BOOST_CHECK_EQUAL(NStr::CompareNocase(upper, lower), 0);
+    for (size_t i = 0;  i < upper.size();  ++i) {
+        BOOST_CHECK_EQUAL(NStr::Find(lower, upper.substr(i, 3),
+                                     NStr::eNocase),
+                          lower.find(lower.substr(i, 3)));
+    }
+#if defined(NCBI_OS_UNIX)  &&  defined(LC_GLOBAL_LOCALE)
+    if (thr_locale != (locale_t) 0) {
+        uselocale(LC_GLOBAL_LOCALE);
+        freelocale(thr_locale);
+    }
+#endif
+    setlocale(LC_CTYPE, saved.c_str());
+}
@@ -0,0 +1,328 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Benchmark for vectorized NStr and CUtf8 primitives
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbistr_util.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/impl/ncbistr_simd.hpp>
+#include <functional>
+#include <random>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Synthetic GenBank flat file text
+
+static const char* const kGenes[] = {
+    "TP53", "BRCA1", "BRCA2", "EGFR", "KRAS", "MYC", "PTEN", "APC", "CFTR"
+};
+static const char* const kAuthors[] = {
+    "Smith,J.", "M\xC3\xBCller,K.", "Nguyen,T.", "Garc\xC3\xAD" "a,L.",
+    "Ivanov,A.", "Tanaka,H."
+};
+
+
+static string s_MakeGenBankText(size_t size)
+{
+    minstd_rand rnd(12345);
+    const char kBases[] = "acgt";
+    const char kAmino[] = "ACDEFGHIKLMNPQRSTVWY";
+    string text;
+    text.reserve(size + 8192);
+    for (unsigned int rec = 1;  text.size() < size;  ++rec) {
+        const char* gene = kGenes[rnd() % ArraySize(kGenes)];
+        size_t      len  = 1000 + rnd() % 3000;
+        string      acc  = "NM_" + NStr::NumericToString(rec + 100000);
+        text += "LOCUS       " + acc + "            " +
+            NStr::NumericToString(len) +
+            " bp    mRNA    linear   PRI 27-JUN-2023\n"
+            "DEFINITION  Homo sapiens " + gene +
+            " transcript variant 1, mRNA.\n"
+            "ACCESSION   " + acc + "\n"
+            "VERSION     " + acc + ".1\n"
+            "KEYWORDS    RefSeq; MANE Select.\n"
+            "SOURCE      Homo sapiens (human)\n"
+            "  ORGANISM  Homo sapiens\n"
+            "            Eukaryota; Metazoa; Chordata; Craniata; Vertebrata;"
+            " Euteleostomi;\n"
+            "            Mammalia; Eutheria; Euarchontoglires; Primates;"
+            " Haplorrhini;\n"
+            "            Catarrhini; Hominidae; Homo.\n"
+            "REFERENCE   1  (bases 1 to " + NStr::NumericToString(len) + ")\n"
+            "  AUTHORS   " + kAuthors[rnd() % ArraySize(kAuthors)] + ", " +
+            kAuthors[rnd() % ArraySize(kAuthors)] + " and " +
+            kAuthors[rnd() % ArraySize(kAuthors)] + "\n"
+            "  TITLE     Functional analysis of " + gene + " variants\n"
+            "  JOURNAL   Nucleic Acids Res. 51 (D1), D977-D985 (2023)\n"
+            "FEATURES             Location/Qualifiers\n"
+            "     source          1.." + NStr::NumericToString(len) + "\n"
+            "                     /organism=\"Homo sapiens\"\n"
+            "                     /mol_type=\"mRNA\"\n"
+            "                     /db_xref=\"taxon:9606\"\n"
+            "     gene            1.." + NStr::NumericToString(len) + "\n"
+            "                     /gene=\"" + gene + "\"\n"
+            "     CDS             201.." + NStr::NumericToString(len - 300) +
+            "\n"
+            "                     /gene=\"" + gene + "\"\n"
+            "                     /product=\"" + gene + " protein\"\n"
+            "                     /translation=\"";
+        for (size_t aa = 0;  aa < (len - 500) / 3;  ++aa) {
+            if (aa  &&  aa % 58 == 0) {
+                text += "\n                     ";
+            }
+            text += kAmino[rnd() % 20];
+        }
+        text += "\"\nORIGIN      \n";
+        for (size_t pos = 0;  pos < len;  pos += 60) {
+            string line = NStr::NumericToString(pos + 1);
+            text.append(9 - line.size(), ' ');
+            text += line;
+            for (size_t i = pos;  i < pos + 60  &&  i < len;  ++i) {
+                if (i % 10 == 0) {
+                    text += ' ';
+                }
+                text += kBases[rnd() % 4];
+            }
+            text += '\n';
+        }
+        text += "//\n";
+    }
+    return text;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestStrPerfApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    // Each benchmark returns a checksum that must not depend on back end.
+    typedef function<Uint8(void)> TBench;
+    struct SBench {
+        string name;
+        TBench func;
+    };
+    vector<SBench> x_GetBenchmarks(void);
+
+    string              m_Text;
+    vector<CTempString> m_Lines;
+    vector<string>      m_Upper;
+};
+
+
+void CTestStrPerfApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "NStr SIMD primitives benchmark");
+    d->AddDefaultKey("size", "MB", "Size of generated GenBank text",
+                     CArgDescriptions::eInteger, "16");
+    d->AddDefaultKey("iterations", "N", "Number of runs of each benchmark",
+                     CArgDescriptions::eInteger, "3");
+    d->AddDefaultKey("backend", "List",
+                     "Comma separated back ends to compare",
+                     CArgDescriptions::eString, "scalar,sse42,avx2");
+    SetupArgDescriptions(d.release());
+}
+
+
+vector<CTestStrPerfApp::SBench> CTestStrPerfApp::x_GetBenchmarks(void)
+{
+    vector<SBench> benchmarks;
+
+    benchmarks.push_back({"CompareNocase", [this]() {
+        Uint8 sum = 0;
+        for (size_t i = 0;  i < m_Lines.size();  ++i) {
+            sum += NStr::CompareNocase(m_Lines[i], m_Upper[i]) == 0;
+            if (i) {
+                sum += NStr::CompareNocase(m_Lines[i], m_Lines[i - 1]) < 0;
+            }
+        }
+        return sum;
+    }});
+
+    benchmarks.push_back({"Find(eNocase)", [this]() {
+        Uint8 sum = 0;
+        CTempString text(m_Text);
+        for (SIZE_TYPE pos = 0;  ;  ++pos) {
+            SIZE_TYPE found = NStr::Find(text.substr(pos), "/PRODUCT=",
+                                         NStr::eNocase);
+            if (found == NPOS) {
+                break;
+            }
+            pos += found;
+            sum += pos;
+        }
+        ITERATE(vector<CTempString>, it, m_Lines) {
+            sum += NStr::Find(*it, "Homo", NStr::eNocase) != NPOS;
+        }
+        return sum;
+    }});
+
+    benchmarks.push_back({"ToLower", [this]() {
+        string text(m_Text);
+        NStr::ToLower(text);
+        return (Uint8) count(text.begin(), text.end(), 'a');
+    }});
+
+    benchmarks.push_back({"Split", [this]() {
+        Uint8 sum = 0;
+        vector<CTempString> lines, tokens;
+        NStr::Split(m_Text, "\n", lines);
+        ITERATE(vector<CTempString>, it, lines) {
+            tokens.clear();
+            NStr::Split(*it, " \t;,", tokens, NStr::fSplit_Tokenize);
+            sum += tokens.size();
+        }
+        return sum;
+    }});
+
+    benchmarks.push_back({"CStrSplitter", [this]() {
+        Uint8 sum = 0;
+        CStrSplitter lines(m_Text, "\n");
+        CTempString line, token;
+        while ( lines.Next(line) ) {
+            CStrSplitter tokens(line, " \t;,", NStr::fSplit_Tokenize);
+            while ( tokens.Next(token) ) {
+                ++sum;
+            }
+        }
+        return sum;
+    }});
+
+    benchmarks.push_back({"UTF-8 validation", [this]() {
+        Uint8 sum = (Uint8) CUtf8::GuessEncoding(m_Text);
+        ITERATE(vector<CTempString>, it, m_Lines) {
+            sum += CUtf8::MatchEncoding(*it, eEncoding_UTF8);
+        }
+        return sum;
+    }});
+
+    return benchmarks;
+}
+
+
+int CTestStrPerfApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    size_t size = (size_t) args["size"].AsInteger() * 1024 * 1024;
+    int iterations = args["iterations"].AsInteger();
+
+    vector<CStrSimd::EBackend> backends;
+    vector<string> names;
+    NStr::Split(args["backend"].AsString(), ",", names,
+                NStr::fSplit_Tokenize);
+    ITERATE(vector<string>, it, names) {
+        CStrSimd::EBackend b = CStrSimd::eScalar;
+        for ( ;  b != CStrSimd::eAuto;  b = CStrSimd::EBackend(b + 1)) {
+            if (*it == CStrSimd::GetBackendName(b)) {
+                break;
+            }
+        }
+        if (b == CStrSimd::eAuto) {
+            ERR_POST(Fatal << "Unknown back end: " << *it);
+        }
+        if ( !CStrSimd::IsSupported(b) ) {
+            NcbiCout << *it << " is not supported, skipped" << NcbiEndl;
+            continue;
+        }
+        backends.push_back(b);
+    }
+
+    m_Text = s_MakeGenBankText(size);
+    NStr::Split(m_Text, "\n", m_Lines);
+    ITERATE(vector<CTempString>, it, m_Lines) {
+        m_Upper.push_back(*it);
+        NStr::ToUpper(m_Upper.back());
+    }
+    NcbiCout << "Text: " << m_Text.size() << " bytes, "
+             << m_Lines.size() << " lines" << NcbiEndl;
+
+    const CStrSimd::EBackend saved = CStrSimd::GetBackend();
+    double mb = double(m_Text.size()) / (1024 * 1024);
+    int errors = 0;
+    vector<SBench> benchmarks = x_GetBenchmarks();
+    ITERATE(vector<SBench>, bench, benchmarks) {
+        Uint8  expected = 0;
+        double base = 0;
+        ITERATE(vector<CStrSimd::EBackend>, b, backends) {
+            CStrSimd::SetBackend(*b);
+            Uint8  checksum = 0;
+            double best = 0;
+            for (int i = 0;  i < iterations;  ++i) {
+                CStopWatch sw(CStopWatch::eStart);
+                checksum = bench->func();
+                double elapsed = sw.Elapsed();
+                if (i == 0  ||  elapsed < best) {
+                    best = elapsed;
+                }
+            }
+            if (b == backends.begin()) {
+                expected = checksum;
+                base = best;
+            } else if (checksum != expected) {
+                ERR_POST(Error << bench->name << ": " 
+                         << CStrSimd::GetBackendName(*b)
+                         << " result " << checksum << " differs from "
+                         << expected);
+                ++errors;
+            }
+            NcbiCout << setw(18) << bench->name << "  "
+                     << setw(6) << CStrSimd::GetBackendName(*b) << "  "
+                     << setw(10) << fixed << setprecision(1)
+                     << mb / best << " MB/s  x"
+                     << setprecision(2) << base / best << NcbiEndl;
+        }
+    }
+    CStrSimd::SetBackend(saved);
+    return errors ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestStrPerfApp().AppMain(argc, argv);
+}
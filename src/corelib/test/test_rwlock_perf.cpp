@@ -0,0 +1,184 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  NCBI C++ Toolkit
+ *
+ * File Description:
+ *   Contention benchmark for CRWLock, CFastRWLock and CReadBiasedRWLock
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbitime.hpp>
+#include <atomic>
+#include <thread>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestRWLockPerfApp : public CNcbiApplication
+{
+public:
+    virtual void Init(void);
+    virtual int  Run(void);
+
+private:
+    // Run 'threads' threads for 'duration' seconds, each doing one write
+    // lock per 'write_period' read locks. Return total number of locks.
+    template<class TLock>
+    Uint8 x_Run(unsigned int threads, double duration,
+                unsigned int write_period);
+
+    template<class TLock>
+    void x_Test(const string& name, const vector<unsigned int>& threads,
+                double duration, unsigned int write_period);
+};
+
+
+void CTestRWLockPerfApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "RW lock contention benchmark");
+    d->AddDefaultKey("threads", "List",
+                     "Comma separated numbers of threads to test",
+                     CArgDescriptions::eString, "1,2,4,8,16,32,64,128");
+    d->AddDefaultKey("duration", "Seconds",
+                     "Duration of each run",
+                     CArgDescriptions::eDouble, "0.5");
+    d->AddDefaultKey("write-period", "N",
+                     "Take write lock once per N read locks (0 - never)",
+                     CArgDescriptions::eInteger, "10000");
+    d->AddDefaultKey("lock", "Type", "Lock type to test",
+                     CArgDescriptions::eString, "all");
+    d->SetConstraint("lock", &(*new CArgAllow_Strings,
+                               "all", "CRWLock", "CFastRWLock",
+                               "CReadBiasedRWLock"));
+    SetupArgDescriptions(d.release());
+}
+
+
+template<class TLock>
+Uint8 CTestRWLockPerfApp::x_Run(unsigned int threads, double duration,
+                                unsigned int write_period)
+{
+    TLock lock;
+    atomic<bool> stop(false);
+    atomic<Uint8> total(0);
+    size_t shared_value = 0;
+    // Keeps readers' loads from being optimized out.
+    atomic<size_t> sink(0);
+
+    vector<thread> tt;
+    for (unsigned int t = 0; t < threads; ++t) {
+        tt.push_back(thread([&]() {
+            Uint8 count = 0;
+            size_t sum = 0;
+            while ( !stop.load(memory_order_relaxed) ) {
+                if (write_period  &&  count % write_period == write_period-1) {
+                    typename TLock::TWriteLockGuard guard(lock);
+                    ++shared_value;
+                }
+                else {
+                    typename TLock::TReadLockGuard guard(lock);
+                    sum += shared_value;
+                }
+                ++count;
+            }
+            total += count;
+            sink += sum;
+        }));
+    }
+    SleepMicroSec((unsigned long)(duration * 1e6));
+    stop = true;
+    for (auto& t : tt) {
+        t.join();
+    }
+    return total.load();
+}
+
+
+template<class TLock>
+void CTestRWLockPerfApp::x_Test(const string& name,
+                                const vector<unsigned int>& threads,
+                                double duration,
+                                unsigned int write_period)
+{
+    ITERATE(vector<unsigned int>, it, threads) {
+        CStopWatch sw(CStopWatch::eStart);
+        Uint8 locks = x_Run<TLock>(*it, duration, write_period);
+        double elapsed = sw.Elapsed();
+        NcbiCout << setw(18) << name << " threads=" << setw(3) << *it
+                 << "  " << setw(12) << Uint8(double(locks) / elapsed)
+                 << " locks/s" << NcbiEndl;
+    }
+}
+
+
+int CTestRWLockPerfApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    vector<string> list;
+    NStr::Split(args["threads"].AsString(), ",", list,
+                NStr::fSplit_Tokenize);
+    vector<unsigned int> threads;
+    ITERATE(vector<string>, it, list) {
+        threads.push_back(NStr::StringToUInt(*it));
+    }
+    double duration = args["duration"].AsDouble();
+    unsigned int write_period = args["write-period"].AsInteger();
+    string lock = args["lock"].AsString();
+
+    if (lock == "all"  ||  lock == "CRWLock") {
+        x_Test<CRWLock>("CRWLock", threads, duration, write_period);
+    }
+    if (lock == "all"  ||  lock == "CFastRWLock") {
+        x_Test<CFastRWLock>("CFastRWLock", threads, duration, write_period);
+    }
+    if (lock == "all"  ||  lock == "CReadBiasedRWLock") {
+        x_Test<CReadBiasedRWLock>("CReadBiasedRWLock", threads, duration,
+                                  write_period);
+    }
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestRWLockPerfApp().AppMain(argc, argv);
+}